@@ -39,6 +39,7 @@ class b2Body;
 class b2Draw;
 class b2Fixture;
 class b2Joint;
+struct b2SolverWorker;
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -71,6 +72,17 @@ public:
 	/// by you and must remain in scope.
 	void SetDebugDraw(b2Draw* debugDraw);
 
+	/// Register a task executor to solve independent islands in parallel.
+	/// Islands are partitioned into at most workerCount tasks of contiguous
+	/// islands, and the tasks are passed to the executor. The results are
+	/// identical to the serial solver. Contact post-solve events are deferred
+	/// until all islands are solved, and then reported in the serial order.
+	/// Pass nullptr (or a worker count less than 2) to solve serially.
+	/// @param executor the callback to run the tasks
+	/// @param workerCount the maximum number of tasks per step
+	/// @param userContext the context to pass to the executor
+	void SetTaskExecutor(b2ExecuteTasksCallback* executor, int32 workerCount, void* userContext);
+
 	/// Create a rigid body given a definition. No reference to the definition
 	/// is retained.
 	/// @warning This function is locked during callbacks.
@@ -225,6 +237,8 @@ private:
 	void operator=(const b2World&) = delete;
 
 	void Solve(const b2TimeStep& step);
+	void SolveParallel(const b2TimeStep& step);
+	void SynchronizeBodies();
 	void SolveTOI(const b2TimeStep& step);
 
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
@@ -262,6 +276,11 @@ private:
 	bool m_stepComplete;
 
 	b2Profile m_profile;
+
+	b2ExecuteTasksCallback* m_taskExecutor;
+	void* m_taskContext;
+	b2SolverWorker* m_workers;
+	int32 m_workerCount;
 };
 
 inline b2Body* b2World::GetBodyList()
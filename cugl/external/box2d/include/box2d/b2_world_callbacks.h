@@ -158,4 +158,19 @@ public:
 									const b2Vec2& normal, float fraction) = 0;
 };
 
+/// A single task of the parallel island solver.
+/// @param taskIndex the index of the task, in [0, taskCount)
+/// @param taskContext the solver data shared by all of the tasks
+typedef void b2TaskCallback(int32 taskIndex, void* taskContext);
+
+/// Callback to run the tasks of the parallel island solver. It must call
+/// task(i, taskContext) exactly once for each i in [0, taskCount), and may
+/// do so on any thread. It must not return until every task has finished.
+/// See b2World::SetTaskExecutor
+/// @param task the task to run
+/// @param taskCount the number of tasks
+/// @param taskContext the context to pass to each task
+/// @param userContext the user context given to b2World::SetTaskExecutor
+typedef void b2ExecuteTasksCallback(b2TaskCallback* task, int32 taskCount, void* taskContext, void* userContext);
+
 #endif
@@ -173,10 +173,44 @@ b2Island::b2Island(
 
 	m_velocities = (b2Velocity*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Velocity));
 	m_positions = (b2Position*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Position));
+
+	m_shared = false;
+}
+
+b2Island::b2Island(
+	b2Body** bodies, int32 bodyCount,
+	b2Contact** contacts, int32 contactCount,
+	b2Joint** joints, int32 jointCount,
+	b2Position* positions, b2Velocity* velocities,
+	b2StackAllocator* allocator, b2ContactListener* listener)
+{
+	m_bodyCapacity = bodyCount;
+	m_contactCapacity = contactCount;
+	m_jointCapacity = jointCount;
+	m_bodyCount = bodyCount;
+	m_contactCount = contactCount;
+	m_jointCount = jointCount;
+
+	m_allocator = allocator;
+	m_listener = listener;
+
+	m_bodies = bodies;
+	m_contacts = contacts;
+	m_joints = joints;
+
+	m_velocities = velocities;
+	m_positions = positions;
+
+	m_shared = true;
 }
 
 b2Island::~b2Island()
 {
+	if (m_shared)
+	{
+		return;
+	}
+
 	// Warning: the order should reverse the constructor order.
 	m_allocator->Free(m_positions);
 	m_allocator->Free(m_velocities);
@@ -196,14 +230,19 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	{
 		b2Body* b = m_bodies[i];
 
+		int32 k = b->m_islandIndex;
 		b2Vec2 c = b->m_sweep.c;
 		float a = b->m_sweep.a;
 		b2Vec2 v = b->m_linearVelocity;
 		float w = b->m_angularVelocity;
 
 		// Store positions for continuous collision.
-		b->m_sweep.c0 = b->m_sweep.c;
-		b->m_sweep.a0 = b->m_sweep.a;
+		// Shared static bodies are read-only (and never move).
+		if (m_shared == false || b->m_type != b2_staticBody)
+		{
+			b->m_sweep.c0 = b->m_sweep.c;
+			b->m_sweep.a0 = b->m_sweep.a;
+		}
 
 		if (b->m_type == b2_dynamicBody)
 		{
@@ -222,10 +261,10 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 			w *= 1.0f / (1.0f + h * b->m_angularDamping);
 		}
 
-		m_positions[i].c = c;
-		m_positions[i].a = a;
-		m_velocities[i].v = v;
-		m_velocities[i].w = w;
+		m_positions[k].c = c;
+		m_positions[k].a = a;
+		m_velocities[k].v = v;
+		m_velocities[k].w = w;
 	}
 
 	timer.Reset();
@@ -279,10 +318,11 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	// Integrate positions
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
-		b2Vec2 c = m_positions[i].c;
-		float a = m_positions[i].a;
-		b2Vec2 v = m_velocities[i].v;
-		float w = m_velocities[i].w;
+		int32 k = m_bodies[i]->m_islandIndex;
+		b2Vec2 c = m_positions[k].c;
+		float a = m_positions[k].a;
+		b2Vec2 v = m_velocities[k].v;
+		float w = m_velocities[k].w;
 
 		// Check for large velocities
 		b2Vec2 translation = h * v;
@@ -303,10 +343,10 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 		c += h * v;
 		a += h * w;
 
-		m_positions[i].c = c;
-		m_positions[i].a = a;
-		m_velocities[i].v = v;
-		m_velocities[i].w = w;
+		m_positions[k].c = c;
+		m_positions[k].a = a;
+		m_velocities[k].v = v;
+		m_velocities[k].w = w;
 	}
 
 	// Solve position constraints
@@ -335,10 +375,16 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* body = m_bodies[i];
-		body->m_sweep.c = m_positions[i].c;
-		body->m_sweep.a = m_positions[i].a;
-		body->m_linearVelocity = m_velocities[i].v;
-		body->m_angularVelocity = m_velocities[i].w;
+		if (m_shared && body->m_type == b2_staticBody)
+		{
+			continue;
+		}
+
+		int32 k = body->m_islandIndex;
+		body->m_sweep.c = m_positions[k].c;
+		body->m_sweep.a = m_positions[k].a;
+		body->m_linearVelocity = m_velocities[k].v;
+		body->m_angularVelocity = m_velocities[k].w;
 		body->SynchronizeTransform();
 	}
 
@@ -40,6 +40,17 @@ class b2Island
 public:
 	b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity,
 			b2StackAllocator* allocator, b2ContactListener* listener);
+
+	/// Construct an island over bodies, contacts, and joints gathered by the
+	/// parallel solver. The island does not own these arrays. The state
+	/// buffers are indexed by the island index of each body, which is unique
+	/// for the whole step. Static bodies may be shared by several islands, so
+	/// the island never writes to them.
+	b2Island(b2Body** bodies, int32 bodyCount,
+			b2Contact** contacts, int32 contactCount,
+			b2Joint** joints, int32 jointCount,
+			b2Position* positions, b2Velocity* velocities,
+			b2StackAllocator* allocator, b2ContactListener* listener);
 	~b2Island();
 
 	void Clear()
@@ -92,6 +103,8 @@ public:
 	int32 m_bodyCapacity;
 	int32 m_contactCapacity;
 	int32 m_jointCapacity;
+
+	bool m_shared;
 };
 
 #endif
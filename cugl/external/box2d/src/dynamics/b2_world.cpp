@@ -40,6 +40,142 @@
 
 #include <new>
 
+// Records contact post-solve events during a parallel solve so that
+// they can be reported on the calling thread in the serial order.
+class b2DeferredListener : public b2ContactListener
+{
+public:
+	struct Event
+	{
+		b2Contact* contact;
+		b2ContactImpulse impulse;
+	};
+
+	b2DeferredListener()
+	{
+		m_events = nullptr;
+		m_count = 0;
+		m_capacity = 0;
+	}
+
+	~b2DeferredListener()
+	{
+		b2Free(m_events);
+	}
+
+	void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse) override
+	{
+		if (m_count == m_capacity)
+		{
+			int32 capacity = b2Max(2 * m_capacity, 64);
+			Event* events = (Event*)b2Alloc(capacity * sizeof(Event));
+			if (m_count > 0)
+			{
+				memcpy(events, m_events, m_count * sizeof(Event));
+			}
+			b2Free(m_events);
+			m_events = events;
+			m_capacity = capacity;
+		}
+
+		m_events[m_count].contact = contact;
+		m_events[m_count].impulse = *impulse;
+		++m_count;
+	}
+
+	Event* m_events;
+	int32 m_count;
+	int32 m_capacity;
+};
+
+// The per-task state of the parallel island solver. Each task has its
+// own stack allocator, deferred events, and copy of the body state.
+struct b2SolverWorker
+{
+	b2SolverWorker()
+	{
+		positions = nullptr;
+		velocities = nullptr;
+		capacity = 0;
+	}
+
+	~b2SolverWorker()
+	{
+		b2Free(positions);
+		b2Free(velocities);
+	}
+
+	void Reserve(int32 count)
+	{
+		if (count > capacity)
+		{
+			b2Free(positions);
+			b2Free(velocities);
+			capacity = b2Max(count, 2 * capacity);
+			positions = (b2Position*)b2Alloc(capacity * sizeof(b2Position));
+			velocities = (b2Velocity*)b2Alloc(capacity * sizeof(b2Velocity));
+		}
+	}
+
+	b2StackAllocator allocator;
+	b2DeferredListener listener;
+	b2Profile profile;
+
+	b2Position* positions;
+	b2Velocity* velocities;
+	int32 capacity;
+};
+
+// An island gathered by the parallel solver.
+struct b2SolverIsland
+{
+	int32 bodyStart;
+	int32 bodyCount;
+	int32 contactStart;
+	int32 contactCount;
+	int32 jointStart;
+	int32 jointCount;
+};
+
+// The data shared by all tasks of a parallel solve.
+struct b2SolverContext
+{
+	b2SolverWorker* workers;
+	const b2SolverIsland* islands;
+	const int32* taskStarts;
+	b2Body** bodies;
+	b2Contact** contacts;
+	b2Joint** joints;
+	b2TimeStep step;
+	b2Vec2 gravity;
+	bool allowSleep;
+	bool report;
+};
+
+// Solves a contiguous range of islands.
+static void b2SolveIslandTask(int32 taskIndex, void* taskContext)
+{
+	b2SolverContext* context = (b2SolverContext*)taskContext;
+	b2SolverWorker* worker = context->workers + taskIndex;
+	b2ContactListener* listener = context->report ? &worker->listener : nullptr;
+
+	for (int32 i = context->taskStarts[taskIndex]; i < context->taskStarts[taskIndex + 1]; ++i)
+	{
+		const b2SolverIsland* data = context->islands + i;
+		b2Island island(context->bodies + data->bodyStart, data->bodyCount,
+						context->contacts + data->contactStart, data->contactCount,
+						context->joints + data->jointStart, data->jointCount,
+						worker->positions, worker->velocities,
+						&worker->allocator, listener);
+
+		b2Profile profile;
+		island.Solve(&profile, context->step, context->gravity, context->allowSleep);
+		worker->profile.solveInit += profile.solveInit;
+		worker->profile.solveVelocity += profile.solveVelocity;
+		worker->profile.solvePosition += profile.solvePosition;
+	}
+}
+
 b2World::b2World(const b2Vec2& gravity)
 {
 	m_destructionListener = nullptr;
@@ -69,6 +205,11 @@ b2World::b2World(const b2Vec2& gravity)
 	m_contactManager.m_allocator = &m_blockAllocator;
 
 	memset(&m_profile, 0, sizeof(b2Profile));
+
+	m_taskExecutor = nullptr;
+	m_taskContext = nullptr;
+	m_workers = nullptr;
+	m_workerCount = 0;
 }
 
 b2World::~b2World()
@@ -90,6 +231,8 @@ b2World::~b2World()
 
 		b = bNext;
 	}
+
+	SetTaskExecutor(nullptr, 0, nullptr);
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -112,6 +255,45 @@ void b2World::SetDebugDraw(b2Draw* debugDraw)
 	m_debugDraw = debugDraw;
 }
 
+void b2World::SetTaskExecutor(b2ExecuteTasksCallback* executor, int32 workerCount, void* userContext)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	if (executor == nullptr || workerCount < 2)
+	{
+		executor = nullptr;
+		workerCount = 0;
+		userContext = nullptr;
+	}
+
+	if (workerCount != m_workerCount)
+	{
+		for (int32 i = 0; i < m_workerCount; ++i)
+		{
+			m_workers[i].~b2SolverWorker();
+		}
+		b2Free(m_workers);
+		m_workers = nullptr;
+
+		if (workerCount > 0)
+		{
+			m_workers = (b2SolverWorker*)b2Alloc(workerCount * sizeof(b2SolverWorker));
+			for (int32 i = 0; i < workerCount; ++i)
+			{
+				new (m_workers + i) b2SolverWorker;
+			}
+		}
+		m_workerCount = workerCount;
+	}
+
+	m_taskExecutor = executor;
+	m_taskContext = userContext;
+}
+
 b2Body* b2World::CreateBody(const b2BodyDef* def)
 {
 	b2Assert(IsLocked() == false);
@@ -397,6 +579,12 @@ void b2World::Solve(const b2TimeStep& step)
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
 
+	if (m_taskExecutor != nullptr)
+	{
+		SolveParallel(step);
+		return;
+	}
+
 	// Size the island for the worst case.
 	b2Island island(m_bodyCount,
 					m_contactManager.m_contactCount,
@@ -555,6 +743,268 @@ void b2World::Solve(const b2TimeStep& step)
 
 	m_stackAllocator.Free(stack);
 
+	SynchronizeBodies();
+}
+
+void b2World::SolveParallel(const b2TimeStep& step)
+{
+	// Clear all the island flags. Island indices are assigned
+	// once per step, so that static bodies have the same index
+	// in every island that touches them.
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b->m_flags &= ~b2Body::e_islandFlag;
+		b->m_islandIndex = -1;
+	}
+	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	{
+		c->m_flags &= ~b2Contact::e_islandFlag;
+	}
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		j->m_islandFlag = false;
+	}
+
+	// Static bodies may appear in several islands, but each
+	// appearance requires a contact or joint.
+	int32 contactCapacity = m_contactManager.m_contactCount;
+	int32 bodyCapacity = m_bodyCount + contactCapacity + m_jointCount;
+
+	int32 stackSize = m_bodyCount;
+	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(bodyCapacity * sizeof(b2Body*));
+	b2Contact** contacts = (b2Contact**)m_stackAllocator.Allocate(contactCapacity * sizeof(b2Contact*));
+	b2Joint** joints = (b2Joint**)m_stackAllocator.Allocate(m_jointCount * sizeof(b2Joint*));
+	b2SolverIsland* islands = (b2SolverIsland*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2SolverIsland));
+	int32* taskStarts = (int32*)m_stackAllocator.Allocate((m_workerCount + 1) * sizeof(int32));
+
+	int32 bodyCount = 0;
+	int32 contactCount = 0;
+	int32 jointCount = 0;
+	int32 islandCount = 0;
+	int32 indexCount = 0;
+
+	// Build all awake islands (in the same order as the serial solver).
+	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+	{
+		if (seed->m_flags & b2Body::e_islandFlag)
+		{
+			continue;
+		}
+
+		if (seed->IsAwake() == false || seed->IsEnabled() == false)
+		{
+			continue;
+		}
+
+		// The seed can be dynamic or kinematic.
+		if (seed->GetType() == b2_staticBody)
+		{
+			continue;
+		}
+
+		b2SolverIsland* island = islands + islandCount++;
+		island->bodyStart = bodyCount;
+		island->contactStart = contactCount;
+		island->jointStart = jointCount;
+
+		int32 stackCount = 0;
+		stack[stackCount++] = seed;
+		seed->m_flags |= b2Body::e_islandFlag;
+
+		// Perform a depth first search (DFS) on the constraint graph.
+		while (stackCount > 0)
+		{
+			// Grab the next body off the stack and add it to the island.
+			b2Body* b = stack[--stackCount];
+			b2Assert(b->IsEnabled() == true);
+			b2Assert(bodyCount < bodyCapacity);
+			bodies[bodyCount++] = b;
+			if (b->m_islandIndex < 0)
+			{
+				b->m_islandIndex = indexCount++;
+			}
+
+			// To keep islands as small as possible, we don't
+			// propagate islands across static bodies.
+			if (b->GetType() == b2_staticBody)
+			{
+				continue;
+			}
+
+			// Make sure the body is awake (without resetting sleep timer).
+			b->m_flags |= b2Body::e_awakeFlag;
+
+			// Search all contacts connected to this body.
+			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+			{
+				b2Contact* contact = ce->contact;
+
+				// Has this contact already been added to an island?
+				if (contact->m_flags & b2Contact::e_islandFlag)
+				{
+					continue;
+				}
+
+				// Is this contact solid and touching?
+				if (contact->IsEnabled() == false ||
+					contact->IsTouching() == false)
+				{
+					continue;
+				}
+
+				// Skip sensors.
+				bool sensorA = contact->m_fixtureA->m_isSensor;
+				bool sensorB = contact->m_fixtureB->m_isSensor;
+				if (sensorA || sensorB)
+				{
+					continue;
+				}
+
+				contacts[contactCount++] = contact;
+				contact->m_flags |= b2Contact::e_islandFlag;
+
+				b2Body* other = ce->other;
+
+				// Was the other body already added to this island?
+				if (other->m_flags & b2Body::e_islandFlag)
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < stackSize);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
+
+			// Search all joints connect to this body.
+			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+			{
+				if (je->joint->m_islandFlag == true)
+				{
+					continue;
+				}
+
+				b2Body* other = je->other;
+
+				// Don't simulate joints connected to disabled bodies.
+				if (other->IsEnabled() == false)
+				{
+					continue;
+				}
+
+				joints[jointCount++] = je->joint;
+				je->joint->m_islandFlag = true;
+
+				if (other->m_flags & b2Body::e_islandFlag)
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < stackSize);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
+		}
+
+		island->bodyCount = bodyCount - island->bodyStart;
+		island->contactCount = contactCount - island->contactStart;
+		island->jointCount = jointCount - island->jointStart;
+
+		// Allow static bodies to participate in other islands.
+		for (int32 i = island->bodyStart; i < bodyCount; ++i)
+		{
+			b2Body* b = bodies[i];
+			if (b->GetType() == b2_staticBody)
+			{
+				b->m_flags &= ~b2Body::e_islandFlag;
+			}
+		}
+	}
+
+	// Partition the islands into contiguous tasks of similar cost.
+	int32 taskCount = 0;
+	if (islandCount > 0)
+	{
+		int32 limit = b2Min(m_workerCount, islandCount);
+		float share = float(bodyCount + contactCount + jointCount) / limit;
+		int32 cost = 0;
+		taskStarts[taskCount++] = 0;
+		for (int32 i = 0; i < islandCount - 1; ++i)
+		{
+			const b2SolverIsland* island = islands + i;
+			cost += island->bodyCount + island->contactCount + island->jointCount;
+			if (cost >= taskCount * share && taskCount < limit)
+			{
+				taskStarts[taskCount++] = i + 1;
+			}
+		}
+		taskStarts[taskCount] = islandCount;
+	}
+
+	if (taskCount > 0)
+	{
+		for (int32 i = 0; i < taskCount; ++i)
+		{
+			b2SolverWorker* worker = m_workers + i;
+			worker->Reserve(indexCount);
+			worker->listener.m_count = 0;
+			memset(&worker->profile, 0, sizeof(b2Profile));
+		}
+
+		b2SolverContext context;
+		context.workers = m_workers;
+		context.islands = islands;
+		context.taskStarts = taskStarts;
+		context.bodies = bodies;
+		context.contacts = contacts;
+		context.joints = joints;
+		context.step = step;
+		context.gravity = m_gravity;
+		context.allowSleep = m_allowSleep;
+		context.report = m_contactManager.m_contactListener != nullptr;
+
+		if (taskCount == 1)
+		{
+			b2SolveIslandTask(0, &context);
+		}
+		else
+		{
+			m_taskExecutor(b2SolveIslandTask, taskCount, &context, m_taskContext);
+		}
+
+		// Report post-solve events in island order.
+		for (int32 i = 0; i < taskCount; ++i)
+		{
+			b2SolverWorker* worker = m_workers + i;
+			if (context.report)
+			{
+				b2DeferredListener* listener = &worker->listener;
+				for (int32 j = 0; j < listener->m_count; ++j)
+				{
+					b2DeferredListener::Event* event = listener->m_events + j;
+					m_contactManager.m_contactListener->PostSolve(event->contact, &event->impulse);
+				}
+			}
+
+			m_profile.solveInit += worker->profile.solveInit;
+			m_profile.solveVelocity += worker->profile.solveVelocity;
+			m_profile.solvePosition += worker->profile.solvePosition;
+		}
+	}
+
+	m_stackAllocator.Free(taskStarts);
+	m_stackAllocator.Free(islands);
+	m_stackAllocator.Free(joints);
+	m_stackAllocator.Free(contacts);
+	m_stackAllocator.Free(bodies);
+	m_stackAllocator.Free(stack);
+
+	SynchronizeBodies();
+}
+
+void b2World::SynchronizeBodies()
+{
 	{
 		b2Timer timer;
 		// Synchronize fixtures, check for out of range bodies.
@@ -7,6 +7,11 @@
 //  the timeline. Actions can be added or removed at any time. We also support
 //  callback functions for monitoring the status of various actions.
 //
+//  The timeline stores the state of its actions in flat arrays, and recycles
+//  the storage of completed actions. Actions can be identified by a string
+//  key or by an integer handle. The handles are faster, as the string keys
+//  are just a lookup layer on top of them.
+//
 //  This class uses our standard shared-pointer architecture.
 //
 //  1. The constructor does not perform any initialization; it just sets all
@@ -47,20 +52,12 @@
 #include <unordered_map>
 #include <algorithm>
 #include <string>
+#include <vector>
+#include <deque>
 #include <SDL.h>
 
 namespace cugl {
 
-/**
- * This is an opaque class representing an action being actively animated.
- *
- * The instance contains the state of an action including duration, elapsed
- * time, the interpolation function, and any other necessary state. This class
- * is only meant to be used by {@link ActionTimeline}, and not directly by the
- * user.
- */
-class ActionInstance;
-    
 /**
  * @typedef ActionListener
  *
@@ -103,24 +100,168 @@ typedef std::function<void(const std::string key, float time, float actual)> Act
  * preventing the user from assigning the same action to different keys. This
  * is discouraged as the behavior in this case is undefined.
  *
+ * Alternatively, an action may be added without a key, in which case the
+ * timeline returns an integer handle for it. A handle is never reused, so
+ * a handle for a completed action is simply inactive. Handles avoid hashing
+ * strings altogether, and so they are preferred when there are thousands of
+ * actions (such as a herd of animated sprites). The string keys are just a
+ * lookup layer on top of the handles.
+ *
  * It is possible to assign listeners to each action to monitor its progress.
  * As with the rest of our input listeners, attached listeners are assigned
  * a key when they are attached, which can be used to remove them from the
  * timeline. With that said, listeners are automatically removed when their
  * associated action is complete.
+ *
+ * The state of the actions is stored in flat arrays (one entry per action),
+ * and the storage of completed actions is recycled. Each update computes
+ * the normalized times of all actions at once, and then applies the easing
+ * functions in batches, grouped by {@link EasingFactory::Type}. Easing
+ * functions allocated by {@link EasingFactory} (other than the elastic
+ * ones) are recognized automatically, so they do not need to be specified
+ * by type. Any other easing function is called once per action.
  */
 class ActionTimeline {
 #pragma mark Values
 private:
-    /** A map that associates keys with animations */
-    std::unordered_map<std::string, std::shared_ptr<ActionInstance>> _actions;
-    /** A map that associates listener keys with animations */
-    std::unordered_map<Uint32, std::shared_ptr<ActionInstance>> _listeners;
+    /** A listener attached to an action */
+    class Listener {
+    public:
+        /** The listener function */
+        ActionListener listener;
+        /** The requested time of the listener */
+        double time;
+        /** The key identifying the listener */
+        Uint32 key;
+    };
+
+    /** The time elapsed for each action */
+    std::vector<double> _elapsed;
+    /** The duration of each action */
+    std::vector<double> _duration;
+    /** The easing type of each action (or one of the special values) */
+    std::vector<Uint8> _easing;
+    /** The state of each action (or the inactive state) */
+    std::vector<Uint8> _state;
+    /** Whether each action is paused */
+    std::vector<Uint8> _paused;
+    /** The handle for each action */
+    std::vector<Uint64> _handles;
+    /** The key for each action (empty if it only has a handle) */
+    std::vector<std::string> _keys;
+    /** The interpolation function for each action (stable during an update) */
+    std::deque<ActionFunction> _functions;
+    /** The custom easing function for each action (if any) */
+    std::vector<EasingFunction> _easings;
+    /** The listeners of each action, ordered in reverse call order */
+    std::vector<std::vector<Listener>> _waiting;
+
+    /** The action position for each handle slot */
+    std::vector<Uint32> _slots;
+    /** The current generation of each handle slot */
+    std::vector<Uint32> _generations;
+    /** The handle slots available for reuse */
+    std::vector<Uint32> _freeslots;
+
+    /** A map that associates keys with action handles */
+    std::unordered_map<std::string, Uint64> _actions;
+    /** A map that associates listener keys with action handles */
+    std::unordered_map<Uint32, Uint64> _listeners;
     /** The next available listener key */
     Uint32 nextKey;
-    
-    friend class ActionInstance;
-    
+    /** Whether this timeline is in the middle of an update */
+    bool _updating;
+    /** Whether an action was removed during the current update */
+    bool _removed;
+    /** The number of active actions */
+    size_t _active;
+
+    /** The normalized (and eased) time of each action in an update */
+    std::vector<float> _normtime;
+    /** The actions of each update sorted by easing type */
+    std::vector<Uint32> _easeorder;
+    /** The normalized times of each update sorted by easing type */
+    std::vector<float> _easetime;
+    /** The number of actions for each easing type in an update */
+    std::vector<Uint32> _easecount;
+
+#pragma mark Internal Helpers
+    /**
+     * Returns the position of the action for the given handle
+     *
+     * If the handle does not refer to an active action, this method returns
+     * -1.
+     *
+     * @param handle    The action handle
+     *
+     * @return the position of the action for the given handle
+     */
+    Sint64 locate(Uint64 handle) const;
+
+    /**
+     * Returns the position of the action for the given key
+     *
+     * If the key does not refer to an active action, this method returns -1.
+     *
+     * @param key       The identifying key
+     *
+     * @return the position of the action for the given key
+     */
+    Sint64 locate(const std::string& key) const;
+
+    /**
+     * Returns a handle for a newly attached action
+     *
+     * The action is appended to the flat arrays. It will be started at the
+     * next call to {@link #update}.
+     *
+     * @param key       The identifying key (or the empty string)
+     * @param action    The action to animate
+     * @param duration  The action duration
+     * @param easing    The easing (interpolation) function
+     *
+     * @return a handle for a newly attached action
+     */
+    Uint64 attach(const std::string& key, ActionFunction action,
+                  float duration, EasingFunction easing);
+
+    /**
+     * Stops the action at the given position
+     *
+     * The action is marked inactive and its key is immediately available.
+     * Any listeners waiting on completion are invoked. The storage for this
+     * action is not recycled until {@link #compact} or {@link #erase}.
+     *
+     * @param pos   The action position
+     */
+    void retire(size_t pos);
+
+    /**
+     * Recycles the storage of the action at the given position
+     *
+     * The action is replaced by the last action in the flat arrays. This
+     * invalidates its handle.
+     *
+     * @param pos   The action position
+     */
+    void erase(size_t pos);
+
+    /**
+     * Recycles the storage of all inactive actions
+     */
+    void compact();
+
+    /**
+     * Adds a listener for the action at the given position
+     *
+     * @param pos       The action position
+     * @param time      The invocation time
+     * @param listener  The listener to add
+     *
+     * @return a key identifying this listener
+     */
+    Uint32 attachListener(size_t pos, double time, ActionListener listener);
+
 public:
 #pragma mark Constructors
     /**
@@ -129,7 +270,7 @@ public:
      * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
      * the heap, use one of the static constructors instead.
      */
-    ActionTimeline() : nextKey(1) {}
+    ActionTimeline() : nextKey(1), _updating(false), _removed(false), _active(0) {}
     
     /**
      * Deletes this timeline, disposing all resources
@@ -242,6 +383,59 @@ public:
      */
     bool add(const std::string key, const std::shared_ptr<Action>& action,
              float duration, EasingFunction easing);
+
+    /**
+     * Adds an action with the given duration and easing function
+     *
+     * The action will be invoked at the next call to {@link #update}. The
+     * easing function allows for effects like bouncing or elasticity in the
+     * linear interpolation. If null, the animation will use the standard
+     * linear easing.
+     *
+     * The action is not assigned a key. Instead, this method returns a
+     * handle that identifies the action. The handle is never 0, and so this
+     * method returns 0 if the action could not be added.
+     *
+     * @param action    The action to animate
+     * @param duration  The action duration
+     * @param easing    The easing (interpolation) function
+     *
+     * @return a handle identifying the action (or 0 for failure)
+     */
+    Uint64 add(ActionFunction action, float duration, EasingFunction easing=nullptr);
+
+    /**
+     * Adds an action with the given duration and easing function
+     *
+     * The action will be invoked at the next call to {@link #update}. The
+     * easing function allows for effects like bouncing or elasticity in the
+     * linear interpolation. If null, the animation will use the standard
+     * linear easing.
+     *
+     * The action is not assigned a key. Instead, this method returns a
+     * handle that identifies the action. The handle is never 0, and so this
+     * method returns 0 if the action could not be added.
+     *
+     * @param action    The action to animate
+     * @param duration  The action duration
+     * @param easing    The easing (interpolation) function
+     *
+     * @return a handle identifying the action (or 0 for failure)
+     */
+    Uint64 add(const std::shared_ptr<Action>& action, float duration,
+               EasingFunction easing=nullptr);
+
+    /**
+     * Returns the handle for the action with the given key.
+     *
+     * If there is no action for the given key (e.g. the animation is
+     * complete) this method will return 0.
+     *
+     * @param key       The identifying key
+     *
+     * @return the handle for the action with the given key.
+     */
+    Uint64 getHandle(const std::string key) const;
     
     /**
      * Removes the action for the given key.
@@ -258,6 +452,21 @@ public:
      */
     bool remove(const std::string key);
 
+    /**
+     * Removes the action for the given handle.
+     *
+     * This method will immediately stop the animation. In particular, it will
+     * invoke any listeners waiting on completion.
+     *
+     * If there is no animation for the give handle (e.g. the animation is
+     * complete) this method will return false.
+     *
+     * @param handle    The action handle
+     *
+     * @return true if the animation was successfully removed
+     */
+    bool remove(Uint64 handle);
+
     /**
      * Updates all non-paused actions by dt seconds
      *
@@ -280,6 +489,24 @@ public:
      */
     bool isActive(const std::string key) const;
 
+    /**
+     * Returns true if the given handle represents an active action
+     *
+     * Note that paused actions are still active, even though they are paused.
+     *
+     * @param handle    The action handle
+     *
+     * @return true if the given handle represents an active action
+     */
+    bool isActive(Uint64 handle) const;
+
+    /**
+     * Returns the number of active actions
+     *
+     * @return the number of active actions
+     */
+    size_t size() const { return _active; }
+
 #pragma mark -
 #pragma mark Listeners
     /**
@@ -305,6 +532,30 @@ public:
      */
     Uint32 addListener(const std::string key, float time, ActionListener listener);
 
+    /**
+     * Adds a listener for the specified action at the given time.
+     *
+     * This listener will be invoked when the timeline first passes the given
+     * time for the specified object. Due to framerate imprecision, the actual
+     * time the listener is invoked may be slightly greater than the time
+     * requested.
+     *
+     * If time is greater than or equal to the duration of action, this listener
+     * will be invoked once the action is completed. If it is less than or equal
+     * to 0, it will be invoked once the action is started. If the action does
+     * not have a key, the listener is passed the empty string.
+     *
+     * If there is no action for the given handle, this method will return 0,
+     * indicating failure.
+     *
+     * @param handle    The action handle
+     * @param time      The invocation time
+     * @param listener  The listener to add
+     *
+     * @return a key identifying this listener (or 0 for failure)
+     */
+    Uint32 addListener(Uint64 handle, float time, ActionListener listener);
+
     /**
      * Adds a listener for  action completion.
      *
@@ -321,6 +572,23 @@ public:
      * @return a key identifying this listener (or 0 for failure)
      */
     Uint32 addCompletionListener(const std::string key, ActionListener listener);
+
+    /**
+     * Adds a listener for  action completion.
+     *
+     * This listener will be invoked when action is completed, just before it
+     * is removed from this timeline. This method is the same as calling
+     * {@link #addListener} with a time greater than the duration.
+     *
+     * If there is no action for the given handle, this method will return 0,
+     * indicating failure.
+     *
+     * @param handle    The action handle
+     * @param listener  The listener to add
+     *
+     * @return a key identifying this listener (or 0 for failure)
+     */
+    Uint32 addCompletionListener(Uint64 handle, ActionListener listener);
     
     /**
      * Returns the action listener for the given key
@@ -358,6 +626,18 @@ public:
      * @return the elapsed time of the given action.
      */
     float getElapsed(const std::string key) const;
+
+    /**
+     * Returns the elapsed time of the given action.
+     *
+     * If there is no animation for the give handle (e.g. the animation is
+     * complete) this method will return 0.
+     *
+     * @param handle    The action handle
+     *
+     * @return the elapsed time of the given action.
+     */
+    float getElapsed(Uint64 handle) const;
     
     /**
      * Returns true if the animation for the given key is paused
@@ -371,6 +651,18 @@ public:
      */
     bool isPaused(const std::string key);
 
+    /**
+     * Returns true if the animation for the given handle is paused
+     *
+     * This method will return false if there is no active animation with the
+     * given handle.
+     *
+     * @param handle    The action handle
+     *
+     * @return true if the animation for the given handle is paused
+     */
+    bool isPaused(Uint64 handle) const;
+
     /**
      * Pauses the animation for the given key.
      *
@@ -381,6 +673,16 @@ public:
      */
     void pause(const std::string key);
 
+    /**
+     * Pauses the animation for the given handle.
+     *
+     * If there is no active animation for the given handle, or if it is
+     * already paused, this method does nothing.
+     *
+     * @param handle    The action handle
+     */
+    void pause(Uint64 handle);
+
     /**
      * Unpauses the animation for the given key.
      *
@@ -391,6 +693,16 @@ public:
      */
     void unpause(const std::string key);
 
+    /**
+     * Unpauses the animation for the given handle.
+     *
+     * If there is no active animation for the given handle, or if it is not
+     * currently paused, this method does nothing.
+     *
+     * @param handle    The action handle
+     */
+    void unpause(Uint64 handle);
+
 };
 
 }
@@ -167,6 +167,22 @@ public:
      * @return An easing function of the given type.
      */
     static EasingFunction alloc(Type type, float period = ELASTIC_PERIOD);
+
+    /**
+     * Applies the easing function of the given type to an array of times.
+     *
+     * The times are adjusted in place. The result is the same as calling
+     * the function from {@link alloc} on each element. However, this method
+     * avoids a function object call per element, which allows the compiler
+     * to inline (and vectorize) the simpler easing functions. It is intended
+     * for animating many actions at once.
+     *
+     * @param type      The easing function type
+     * @param times     The times to adjust
+     * @param count     The number of times
+     * @param period    The period of an elastic easing function
+     */
+    static void evaluate(Type type, float* times, size_t count, float period = ELASTIC_PERIOD);
     
     /**
      * Returns an adjustment of the interpolation value
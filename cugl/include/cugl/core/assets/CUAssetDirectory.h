@@ -0,0 +1,464 @@
+//
+//  CUAssetDirectory.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a compiled (binary) form of a JSON asset directory.
+//  Parsing a large asset directory at every startup is wasteful, since the
+//  directory rarely changes between runs. A compiled directory stores the
+//  same tree as fixed-size records with an interned string table, so that it
+//  can be read (or memory mapped) and converted to JsonValue nodes without
+//  any text parsing. The AssetManager accepts a compiled directory anywhere
+//  that it accepts a JSON directory, and the loaders see exactly the same
+//  JsonValue objects in either case.
+//
+//  Compiled directories are typically produced at build time, either with the
+//  method AssetDirectory#write or with the script scripts/assetdir.py. All
+//  integers in the file are stored in network order, so compiled directories
+//  are portable across platforms.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#ifndef __CU_ASSET_DIRECTORY_H__
+#define __CU_ASSET_DIRECTORY_H__
+#include <SDL.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+
+/** The file signature of a compiled asset directory */
+#define CU_ASSET_DIRECTORY_MAGIC    "CUAD"
+/** The current version of the compiled asset directory format */
+#define CU_ASSET_DIRECTORY_VERSION  1
+/** The maximum container nesting of a compiled asset directory */
+#define CU_ASSET_DIRECTORY_MAX_DEPTH    256
+
+namespace  cugl {
+
+// Forward references
+class JsonValue;
+class JsonArena;
+
+/**
+ * This class is a compiled (binary) JSON asset directory.
+ *
+ * A compiled directory contains the same information as the JSON directory
+ * it was created from, but it is stored in a form that requires no parsing.
+ * The file consists of five sections, each aligned to 8 bytes:
+ *
+ *  - A 24 byte header (signature, version, and the size of each section)
+ *  - The category table, with the name and root node of each category
+ *  - The string table, with the offset and length of each interned string
+ *  - The node table, with a 16 byte record for each node in preorder
+ *  - The string data, with each string followed by a null terminator
+ *
+ * Every key and string value is interned, so repeated keys (like "file" or
+ * "size") are only stored once. Container nodes record the size of their
+ * subtree, so that any category can be accessed without visiting the
+ * categories that precede it.
+ *
+ * Because the format uses offsets instead of pointers, a directory can be
+ * read directly from a memory mapped file. See {@link #init(const Uint8*,size_t)}.
+ * Containers may be nested at most {@link CU_ASSET_DIRECTORY_MAX_DEPTH} deep,
+ * so that converting untrusted data back to JSON has bounded recursion.
+ */
+class AssetDirectory {
+private:
+    /** The compiled data, if it is owned by this directory */
+    std::vector<Uint8> _buffer;
+    /** The start of the compiled data */
+    const Uint8* _data;
+    /** The number of bytes in the compiled data */
+    size_t _size;
+
+    /** The number of categories */
+    Uint32 _categories;
+    /** The number of interned strings */
+    Uint32 _strings;
+    /** The number of nodes */
+    Uint32 _nodes;
+    /** The offset of the category table */
+    size_t _catOffset;
+    /** The offset of the string table */
+    size_t _strOffset;
+    /** The offset of the node table */
+    size_t _nodeOffset;
+    /** The offset of the string data */
+    size_t _blobOffset;
+
+#pragma mark -
+#pragma mark Constructors
+public:
+    /**
+     * Creates an uninitialized asset directory.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    AssetDirectory();
+
+    /**
+     * Deletes this asset directory, disposing all resources.
+     */
+    ~AssetDirectory() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this asset directory.
+     *
+     * A disposed directory can be safely reinitialized.
+     */
+    void dispose();
+
+    /**
+     * Initializes an asset directory by compiling the given JSON directory.
+     *
+     * The JSON value must be an object, whose children are the asset
+     * categories.
+     *
+     * @param json  The JSON asset directory
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(const std::shared_ptr<JsonValue>& json);
+
+    /**
+     * Initializes an asset directory from compiled data.
+     *
+     * This directory does NOT copy the data. The data must remain valid (and
+     * unchanged) for the lifetime of this directory. This makes it possible
+     * to use a directory directly from a memory mapped file.
+     *
+     * This method fails if the data is not a valid compiled directory.
+     *
+     * @param data  The compiled data
+     * @param size  The number of bytes of data
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(const Uint8* data, size_t size);
+
+    /**
+     * Initializes an asset directory from the given compiled file.
+     *
+     * This initializer assumes that the file name is an absolute path. This
+     * method fails if the file is not a compiled directory.
+     *
+     * @param file  The path to the file
+     *
+     * @return true if initialization was successful.
+     */
+    bool initWithFile(const std::string file);
+
+    /**
+     * Initializes an asset directory from the given compiled file.
+     *
+     * This initializer assumes that the file name is a relative path. It will
+     * search the application asset directory {@see Application#getAssetDirectory()}
+     * for the file. This method fails if the file cannot be found or is not
+     * a compiled directory.
+     *
+     * @param file  The relative path to the file
+     *
+     * @return true if initialization was successful.
+     */
+    bool initWithAsset(const std::string file);
+
+    /**
+     * Returns a newly allocated asset directory compiled from the JSON directory.
+     *
+     * The JSON value must be an object, whose children are the asset
+     * categories.
+     *
+     * @param json  The JSON asset directory
+     *
+     * @return a newly allocated asset directory compiled from the JSON directory.
+     */
+    static std::shared_ptr<AssetDirectory> alloc(const std::shared_ptr<JsonValue>& json) {
+        std::shared_ptr<AssetDirectory> result = std::make_shared<AssetDirectory>();
+        return (result->init(json) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated asset directory for the compiled data.
+     *
+     * This directory does NOT copy the data. The data must remain valid (and
+     * unchanged) for the lifetime of this directory. This makes it possible
+     * to use a directory directly from a memory mapped file.
+     *
+     * This method returns nullptr if the data is not a valid compiled directory.
+     *
+     * @param data  The compiled data
+     * @param size  The number of bytes of data
+     *
+     * @return a newly allocated asset directory for the compiled data.
+     */
+    static std::shared_ptr<AssetDirectory> alloc(const Uint8* data, size_t size) {
+        std::shared_ptr<AssetDirectory> result = std::make_shared<AssetDirectory>();
+        return (result->init(data,size) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated asset directory for the given compiled file.
+     *
+     * This initializer assumes that the file name is an absolute path. This
+     * method returns nullptr if the file is not a compiled directory.
+     *
+     * @param file  The path to the file
+     *
+     * @return a newly allocated asset directory for the given compiled file.
+     */
+    static std::shared_ptr<AssetDirectory> allocWithFile(const std::string file) {
+        std::shared_ptr<AssetDirectory> result = std::make_shared<AssetDirectory>();
+        return (result->initWithFile(file) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated asset directory for the given compiled file.
+     *
+     * This initializer assumes that the file name is a relative path. It will
+     * search the application asset directory {@see Application#getAssetDirectory()}
+     * for the file. This method returns nullptr if the file cannot be found
+     * or is not a compiled directory.
+     *
+     * @param file  The relative path to the file
+     *
+     * @return a newly allocated asset directory for the given compiled file.
+     */
+    static std::shared_ptr<AssetDirectory> allocWithAsset(const std::string file) {
+        std::shared_ptr<AssetDirectory> result = std::make_shared<AssetDirectory>();
+        return (result->initWithAsset(file) ? result : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Attributes
+    /**
+     * Returns true if the data begins with a compiled directory signature
+     *
+     * This is a quick test that does not validate the rest of the data.
+     *
+     * @param data  The data to test
+     * @param size  The number of bytes of data
+     *
+     * @return true if the data begins with a compiled directory signature
+     */
+    static bool isCompiled(const Uint8* data, size_t size);
+
+    /**
+     * Returns the compiled data of this directory
+     *
+     * This is the data that is saved by {@link #write}.
+     *
+     * @return the compiled data of this directory
+     */
+    const Uint8* data() const { return _data; }
+
+    /**
+     * Returns the number of bytes of compiled data
+     *
+     * @return the number of bytes of compiled data
+     */
+    size_t byteSize() const { return _size; }
+
+    /**
+     * Returns the number of asset categories in this directory
+     *
+     * @return the number of asset categories in this directory
+     */
+    size_t size() const { return _categories; }
+
+    /**
+     * Returns the name of the given asset category
+     *
+     * The name is a view into the compiled data, and is only valid for the
+     * lifetime of this directory.
+     *
+     * @param index The category index
+     *
+     * @return the name of the given asset category
+     */
+    std::string_view getCategory(size_t index) const;
+
+#pragma mark -
+#pragma mark Conversion
+    /**
+     * Returns a newly allocated JsonValue for the given asset category
+     *
+     * The result has the same key and contents as the corresponding child of
+     * the original JSON directory. However, it has no parent.
+     *
+     * If arena is true, every node in the tree is allocated from a single
+     * arena (see {@link JsonArena}). This is much faster for large categories,
+     * but the arena is only released when every node of the tree has been
+     * deleted.
+     *
+     * @param index The category index
+     * @param arena Whether to allocate the tree from an arena
+     *
+     * @return a newly allocated JsonValue for the given asset category
+     */
+    std::shared_ptr<JsonValue> get(size_t index, bool arena=false) const;
+
+    /**
+     * Returns a newly allocated JsonValue for the entire directory
+     *
+     * The result is identical to the original JSON directory.
+     *
+     * If arena is true, every node in the tree is allocated from a single
+     * arena (see {@link JsonArena}). This is much faster for large directories,
+     * but the arena is only released when every node of the tree has been
+     * deleted.
+     *
+     * @param arena Whether to allocate the tree from an arena
+     *
+     * @return a newly allocated JsonValue for the entire directory
+     */
+    std::shared_ptr<JsonValue> toJson(bool arena=false) const;
+
+    /**
+     * Returns a newly allocated JsonValue for the given directory file
+     *
+     * The file may either be a compiled directory or a JSON file. The file
+     * is read exactly once, and its signature determines how the contents
+     * are decoded. Hence this is the preferred way to read a directory whose
+     * format is not known in advance.
+     *
+     * This method assumes that the file name is an absolute path. It returns
+     * nullptr if the file cannot be read or is not a valid directory.
+     *
+     * @param file  The path to the file
+     * @param arena Whether to allocate the tree from an arena
+     *
+     * @return a newly allocated JsonValue for the given directory file
+     */
+    static std::shared_ptr<JsonValue> readJson(const std::string file, bool arena=false);
+
+    /**
+     * Returns a newly allocated JsonValue for the given directory file
+     *
+     * The file may either be a compiled directory or a JSON file. The file
+     * is read exactly once, and its signature determines how the contents
+     * are decoded. Hence this is the preferred way to read a directory whose
+     * format is not known in advance.
+     *
+     * This method assumes that the file name is a relative path. It will
+     * search the application asset directory {@see Application#getAssetDirectory()}
+     * for the file. It returns nullptr if the file cannot be read or is not
+     * a valid directory.
+     *
+     * @param file  The relative path to the file
+     * @param arena Whether to allocate the tree from an arena
+     *
+     * @return a newly allocated JsonValue for the given directory file
+     */
+    static std::shared_ptr<JsonValue> readJsonWithAsset(const std::string file, bool arena=false);
+
+    /**
+     * Writes the compiled directory to the given file.
+     *
+     * If the file is a relative path, it is written to the application save
+     * directory {@see Application#getSaveDirectory()}. If the file already
+     * exists, it will be replaced.
+     *
+     * @param file  The path to the file
+     *
+     * @return true if the file was written successfully
+     */
+    bool write(const std::string file) const;
+
+#pragma mark -
+#pragma mark Internal Helpers
+private:
+    /**
+     * Returns true if the attached data is a valid compiled directory
+     *
+     * This method reads the header and verifies that every section fits in
+     * the data. It also checks every node record, including that each
+     * subtree lies within its parent and that no container is nested more
+     * than {@link CU_ASSET_DIRECTORY_MAX_DEPTH} deep. Hence reading a valid
+     * directory never leaves the data.
+     *
+     * @return true if the attached data is a valid compiled directory
+     */
+    bool validate();
+
+    /**
+     * Returns true if the file contains a valid compiled directory
+     *
+     * The file is read into {@link #_buffer} with a single read of the
+     * file size.
+     *
+     * @param path  The absolute path to the compiled file
+     *
+     * @return true if the file contains a valid compiled directory
+     */
+    bool load(const std::string path);
+
+    /**
+     * Returns true if the contents of the file were read into the buffer
+     *
+     * The buffer is resized to the file size and filled with a single read.
+     *
+     * @param path      The absolute path to the file
+     * @param buffer    The buffer to store the contents
+     *
+     * @return true if the contents of the file were read into the buffer
+     */
+    static bool readFile(const std::string path, std::vector<Uint8>& buffer);
+
+    /**
+     * Returns the interned string with the given id
+     *
+     * @param id    The string id
+     *
+     * @return the interned string with the given id
+     */
+    std::string_view getString(Uint32 id) const;
+
+    /**
+     * Stores the subtree with the given root in the given node.
+     *
+     * Descendant nodes are allocated from the arena, if it is not nullptr.
+     *
+     * @param index The index of the root node record
+     * @param node  The node to store the result
+     * @param arena The arena for descendant nodes (may be nullptr)
+     *
+     * @return the index of the next node record after the subtree
+     */
+    Uint32 readNode(Uint32 index, JsonValue* node,
+                    const std::shared_ptr<JsonArena>& arena) const;
+};
+
+}
+#endif /* __CU_ASSET_DIRECTORY_H__ */
@@ -624,6 +624,9 @@ public:
      * can.  If any asset fails to load, it will return false.  However, some
      * assets may still be loaded and safe to access.
      *
+     * The directory may either be a JSON file or a compiled directory (see
+     * {@link AssetDirectory}). Compiled directories are detected automatically.
+     *
      * @param directory The path to the JSON asset directory
      *
      * @return true if all assets specified in the directory were successfully loaded.
@@ -707,6 +710,9 @@ public:
      * to load, the callback function will be given the asset category name
      * (e.g. "soundfx") as the asset key.
      *
+     * The directory may either be a JSON file or a compiled directory (see
+     * {@link AssetDirectory}). Compiled directories are detected automatically.
+     *
      * @param directory The path to the JSON asset directory
      * @param callback  An optional callback after each asset is loaded
      */
@@ -732,6 +738,9 @@ public:
      * still may remain in memory. However, the rest of the program can no
      * longer access these assets.
      *
+     * The directory may either be a JSON file or a compiled directory (see
+     * {@link AssetDirectory}). Compiled directories are detected automatically.
+     *
      * @param directory The path to the JSON asset directory
      */
     bool unloadDirectory(const std::string directory);
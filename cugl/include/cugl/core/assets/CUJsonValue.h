@@ -4,8 +4,11 @@
 //
 //  This module a modern C++ alternative to the CUJSON interface for reading
 //  JSON files.  In particular, this gives us better type-checking and memory
-//  management.  With that said, it still uses CUJSON as the underlying parsing
-//  engine.
+//  management.  JSON strings are parsed with JsonParser, which builds the tree
+//  directly (optionally from an arena). CUJSON is still used for encoding.
+//
+//  Objects with many children lazily build a hash index of their keys, so
+//  keyed lookups are constant time on large objects.
 //
 //  This class uses our standard shared-pointer architecture.
 //
@@ -47,6 +50,10 @@
 #include <cugl/core/assets/CUJSON.h>
 #include <vector>
 #include <string>
+#include <unordered_map>
+
+/** The number of children before an object indexes its keys */
+#define CU_JSON_INDEX_MINIMUM 8
 
 namespace cugl {
 
@@ -62,9 +69,15 @@ namespace cugl {
  * if the node is an object type.  Hence the main usage of this feature is to
  * "cast" object nodes to arrays.
  *
- * This class uses CUJSON as the underlying parsing engine.  However, it manages
- * memory automatically so that the user does not need to worry about deleting
- * or allocating memory beyond the initial node itself.
+ * This class uses {@link JsonParser} as the underlying parsing engine. However,
+ * it manages memory automatically so that the user does not need to worry about
+ * deleting or allocating memory beyond the initial node itself.
+ *
+ * Once an object has at least {@link CU_JSON_INDEX_MINIMUM} children, keyed
+ * access uses a hash index. This index is maintained when children are
+ * appended, and rebuilt after any other change to the children. It is never
+ * built by a lookup, so const methods do not modify the node, and several
+ * threads may read the same tree at once.
  */
 class JsonValue {
 public:
@@ -108,6 +121,11 @@ public:
     
     /** The children of this node (only non-empty if array or object) */
     std::vector<std::shared_ptr<JsonValue>> _children;
+    
+    /** The position of the first child with each key (only for large objects) */
+    std::unordered_map<std::string, size_t> _index;
+    /** Whether the key index is in use */
+    bool _indexed;
 
 #pragma mark -
 #pragma mark CUJSON Conversions
@@ -268,11 +286,17 @@ public:
      * information about the parsing error will be passed to an assert.  Hence
      * error messages are suppressed if asserts are turned off.
      *
+     * If arena is true, the descendants of this node are allocated from a
+     * single arena (see {@link JsonParser#readValue}). This is much faster
+     * for large files, but the arena is not released until every descendant
+     * (including detached subtrees) has been deleted.
+     *
      * @param json  The JSON string to parse.
+     * @param arena Whether to allocate the descendants from an arena
      *
      * @return  true if the JSON node is initialized properly, false otherwise.
      */
-    bool initWithJson(const std::string json);
+    bool initWithJson(const std::string json, bool arena=false);
 
     
 #pragma mark -
@@ -397,13 +421,19 @@ public:
      * information about the parsing error will be passed to an assert.  Hence
      * error messages are suppressed if asserts are turned off.
      *
+     * If arena is true, the descendants of this node are allocated from a
+     * single arena (see {@link JsonParser#readValue}). This is much faster
+     * for large files, but the arena is not released until every descendant
+     * (including detached subtrees) has been deleted.
+     *
      * @param json  The JSON string to parse.
+     * @param arena Whether to allocate the descendants from an arena
      *
      * @return a newly allocated JsonValue from the given JSON string.
      */
-    static std::shared_ptr<JsonValue> allocWithJson(const std::string json) {
+    static std::shared_ptr<JsonValue> allocWithJson(const std::string json, bool arena=false) {
         std::shared_ptr<JsonValue> result = std::make_shared<JsonValue>();
-        return (result->initWithJson(json) ? result : nullptr);
+        return (result->initWithJson(json,arena) ? result : nullptr);
     }
 
     
@@ -767,6 +797,8 @@ public:
      * corrupted and there is more than one child of this name, it will return
      * the first one.
      *
+     * This method is constant time for objects with many children.
+     *
      * @param name  The key identifying the child.
      *
      * @return the child with the specified key.
@@ -781,6 +813,8 @@ public:
      * corrupted and there is more than one child of this name, it will return
      * the first one.
      *
+     * This method is constant time for objects with many children.
+     *
      * @param name  The key identifying the child.
      *
      * @return the child with the specified key.
@@ -1452,6 +1486,37 @@ public:
 
 
 
+#pragma mark -
+#pragma mark Key Index
+private:
+    /** The parser builds the children directly, and then indexes them */
+    friend class JsonParser;
+    /** The compiled directory builds the children directly, and then indexes them */
+    friend class AssetDirectory;
+
+    /**
+     * Returns the position of the first child with the given key
+     *
+     * If this node has a key index, this method uses it. Otherwise, it
+     * searches the children in order. This method never modifies the node.
+     *
+     * @param key   The key identifying the child
+     *
+     * @return the position of the first child with the given key (-1 if none)
+     */
+    int findChild(const std::string& key) const;
+
+    /**
+     * Rebuilds the key index from the current children
+     *
+     * Only objects with at least {@link CU_JSON_INDEX_MINIMUM} children
+     * have an index. For any other node, this method removes the index.
+     * This method should be called after any change to the children other
+     * than an append.
+     */
+    void rebuildIndex();
+
+public:
 #pragma mark -
 #pragma mark Encoding
     
@@ -32,6 +32,7 @@
 #include "CUJsonValue.h"
 #include "CUWidgetValue.h"
 #include "CUAssetManager.h"
+#include "CUAssetDirectory.h"
 #include "CUJsonLoader.h"
 #include "CUWidgetLoader.h"
 #include "CUGenericLoader.h"
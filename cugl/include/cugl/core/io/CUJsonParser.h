@@ -0,0 +1,565 @@
+//
+//  CUJsonParser.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a streaming (pull) parser for JSON text. Unlike
+//  JsonValue, which always builds a full tree, this parser reports the JSON
+//  as a sequence of events (begin object, key, value, end object, and so on).
+//  Strings are reported as views into the source text whenever they have no
+//  escape characters, so the parser allocates no memory per token. The events
+//  can be consumed directly, pushed to a SAX-style handler, or used to build a
+//  JsonValue tree. In the last case, the tree can optionally be allocated from
+//  a single arena, greatly reducing the number of allocations for large files.
+//  This arena is also available to other classes that build JsonValue trees.
+//
+//  The parser accepts the same JSON as the CUJSON engine behind JsonValue.
+//  In particular, it only parses the first JSON value in the source text, and
+//  ignores anything that follows it.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#ifndef __CU_JSON_PARSER_H__
+#define __CU_JSON_PARSER_H__
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+
+namespace  cugl {
+
+// Forward reference to the DOM node
+class JsonValue;
+
+/**
+ * This class is an interface for receiving SAX-style JSON events.
+ *
+ * To use this interface, subclass it and override the events you care about,
+ * then pass it to {@link JsonParser#parse}. Every event returns a boolean.
+ * Returning false from any event aborts the parse.
+ *
+ * The string views passed to {@link #onKey} and {@link #onString} are only
+ * valid for the duration of the event. They must be copied if the handler
+ * wants to keep them.
+ */
+class JsonHandler {
+public:
+    /**
+     * Deletes this handler, disposing all resources
+     */
+    virtual ~JsonHandler() {}
+
+    /**
+     * Called when the parser encounters a null value
+     *
+     * @return true if parsing should continue
+     */
+    virtual bool onNull() { return true; }
+
+    /**
+     * Called when the parser encounters a boolean value
+     *
+     * @param value The boolean value
+     *
+     * @return true if parsing should continue
+     */
+    virtual bool onBool(bool value) { return true; }
+
+    /**
+     * Called when the parser encounters a numeric value
+     *
+     * @param value The numeric value
+     *
+     * @return true if parsing should continue
+     */
+    virtual bool onNumber(double value) { return true; }
+
+    /**
+     * Called when the parser encounters a string value
+     *
+     * @param value The (unescaped) string value
+     *
+     * @return true if parsing should continue
+     */
+    virtual bool onString(std::string_view value) { return true; }
+
+    /**
+     * Called when the parser encounters the key of an object entry
+     *
+     * The value of the entry is the next event.
+     *
+     * @param key   The (unescaped) entry key
+     *
+     * @return true if parsing should continue
+     */
+    virtual bool onKey(std::string_view key) { return true; }
+
+    /**
+     * Called when the parser encounters the start of an object
+     *
+     * @return true if parsing should continue
+     */
+    virtual bool onBeginObject() { return true; }
+
+    /**
+     * Called when the parser encounters the end of an object
+     *
+     * @return true if parsing should continue
+     */
+    virtual bool onEndObject() { return true; }
+
+    /**
+     * Called when the parser encounters the start of an array
+     *
+     * @return true if parsing should continue
+     */
+    virtual bool onBeginArray() { return true; }
+
+    /**
+     * Called when the parser encounters the end of an array
+     *
+     * @return true if parsing should continue
+     */
+    virtual bool onEndArray() { return true; }
+};
+
+/**
+ * This class is a bump allocator for the nodes of a JsonValue tree.
+ *
+ * Allocating every node of a large tree separately is expensive. Nodes
+ * allocated by {@link #allocValue} are instead carved out of large blocks,
+ * and memory is never returned to the arena. It is all released at once
+ * when the arena is deleted. As every node keeps a reference to its arena,
+ * this happens when the last node allocated from it is deleted.
+ *
+ * This arena is used by {@link JsonParser#readValue}, but it can be used by
+ * any class that builds JsonValue trees.
+ */
+class JsonArena : public std::enable_shared_from_this<JsonArena> {
+private:
+    /** The allocated blocks */
+    std::vector<char*> _blocks;
+    /** The next free byte in the current block */
+    size_t _offset;
+    /** The size of the current block */
+    size_t _capacity;
+
+public:
+    /**
+     * Creates an empty arena
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use the static constructor instead.
+     */
+    JsonArena() : _offset(0), _capacity(0) {}
+
+    /**
+     * Deletes this arena, releasing all memory
+     */
+    ~JsonArena();
+
+    /**
+     * Returns a newly allocated (empty) arena
+     *
+     * @return a newly allocated (empty) arena
+     */
+    static std::shared_ptr<JsonArena> alloc() {
+        return std::make_shared<JsonArena>();
+    }
+
+    /**
+     * Returns a pointer to the given number of bytes
+     *
+     * The memory is aligned for any type.
+     *
+     * @param bytes The number of bytes to allocate
+     *
+     * @return a pointer to the given number of bytes
+     */
+    void* allocate(size_t bytes);
+
+    /**
+     * Returns a new (null) JsonValue allocated from this arena
+     *
+     * The node keeps this arena alive for as long as the node exists.
+     *
+     * @return a new (null) JsonValue allocated from this arena
+     */
+    std::shared_ptr<JsonValue> allocValue();
+};
+
+/**
+ * This class is a streaming pull parser for JSON text.
+ *
+ * Each call to {@link #next} advances the parser to the next event in the
+ * JSON text. The value for that event (if any) can then be read with the
+ * appropriate getter. For example, after {@link Event#Key}, the method
+ * {@link #getString} returns the key of the entry. This allows large files
+ * to be processed without building a {@link JsonValue} tree at all.
+ *
+ * The parser does not allocate memory for each token. Strings without
+ * escape characters are returned as views into the source text, while
+ * strings with escape characters are decoded into a reusable buffer. The
+ * only other memory is the (reusable) stack of open containers.
+ *
+ * If you do need a tree, {@link #readValue} builds one directly from the
+ * events. The nodes can optionally be allocated from a single arena. This
+ * arena is released when the last node in the tree is deleted.
+ */
+class JsonParser {
+public:
+    /**
+     * This enum represents the events reported by the parser
+     */
+    enum class Event : int {
+        /** The parser has not started */
+        None       = 0,
+        /** A null value */
+        NullValue  = 1,
+        /** A boolean value (use {@link #getBool}) */
+        BoolValue  = 2,
+        /** A numeric value (use {@link #getNumber} or {@link #getLong}) */
+        NumberValue= 3,
+        /** A string value (use {@link #getString}) */
+        StringValue= 4,
+        /** The key of an object entry (use {@link #getString}) */
+        Key        = 5,
+        /** The start of an object */
+        BeginObject= 6,
+        /** The end of an object */
+        EndObject  = 7,
+        /** The start of an array */
+        BeginArray = 8,
+        /** The end of an array */
+        EndArray   = 9,
+        /** The end of the JSON value (nothing else will be parsed) */
+        Finished   = 10,
+        /** A syntax error (use {@link #getError}) */
+        Error      = 11
+    };
+
+private:
+    /** The source text, if it is owned by this parser */
+    std::string _source;
+    /** The start of the source text */
+    const char* _begin;
+    /** The current read position */
+    const char* _curr;
+    /** The end of the source text */
+    const char* _end;
+
+    /** The stack of open containers ('{' or '[') */
+    std::vector<char> _stack;
+    /** The parsing state (what the next token may be) */
+    int _state;
+    /** The most recent event */
+    Event _event;
+
+    /** The value of the most recent boolean event */
+    bool _boolValue;
+    /** The value of the most recent number event */
+    double _numberValue;
+    /** The value of the most recent string or key event */
+    std::string_view _stringValue;
+    /** The buffer for decoding strings with escape characters */
+    std::string _scratch;
+
+    /** The position of the syntax error (nullptr if none) */
+    const char* _errorPos;
+    /** The description of the syntax error */
+    const char* _errorMsg;
+
+#pragma mark -
+#pragma mark Constructors
+public:
+    /**
+     * Creates an uninitialized parser.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    JsonParser();
+
+    /**
+     * Deletes this parser, disposing all resources.
+     */
+    ~JsonParser() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this parser.
+     *
+     * A disposed parser can be safely reinitialized.
+     */
+    void dispose();
+
+    /**
+     * Initializes a parser for the given JSON string.
+     *
+     * The parser makes a copy of the string, so it is safe to discard the
+     * original afterwards.
+     *
+     * @param json  The JSON string
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(const std::string json);
+
+    /**
+     * Initializes a parser for the given JSON text.
+     *
+     * This parser does NOT copy the text. The text must remain valid (and
+     * unchanged) for the lifetime of this parser. The text does not need to
+     * be null terminated.
+     *
+     * @param data  The JSON text
+     * @param size  The number of characters in the text
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(const char* data, size_t size);
+
+    /**
+     * Returns a newly allocated parser for the given JSON string.
+     *
+     * The parser makes a copy of the string, so it is safe to discard the
+     * original afterwards.
+     *
+     * @param json  The JSON string
+     *
+     * @return a newly allocated parser for the given JSON string.
+     */
+    static std::shared_ptr<JsonParser> alloc(const std::string json) {
+        std::shared_ptr<JsonParser> result = std::make_shared<JsonParser>();
+        return (result->init(json) ? result : nullptr);
+    }
+
+    /**
+     * Returns a newly allocated parser for the given JSON text.
+     *
+     * This parser does NOT copy the text. The text must remain valid (and
+     * unchanged) for the lifetime of this parser. The text does not need to
+     * be null terminated.
+     *
+     * @param data  The JSON text
+     * @param size  The number of characters in the text
+     *
+     * @return a newly allocated parser for the given JSON text.
+     */
+    static std::shared_ptr<JsonParser> alloc(const char* data, size_t size) {
+        std::shared_ptr<JsonParser> result = std::make_shared<JsonParser>();
+        return (result->init(data,size) ? result : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Pull Interface
+    /**
+     * Returns the next event in the JSON text.
+     *
+     * Once the parser returns {@link Event#Finished} or {@link Event#Error},
+     * every subsequent call will return the same value.
+     *
+     * @return the next event in the JSON text.
+     */
+    Event next();
+
+    /**
+     * Returns the most recent event
+     *
+     * @return the most recent event
+     */
+    Event event() const { return _event; }
+
+    /**
+     * Skips over the current value.
+     *
+     * If the most recent event is {@link Event#BeginObject} or
+     * {@link Event#BeginArray}, this method advances the parser to the
+     * matching end event. If the most recent event is {@link Event#Key},
+     * it skips the value of that entry. Otherwise it does nothing.
+     *
+     * @return false if there was a syntax error
+     */
+    bool skip();
+
+    /**
+     * Returns the current nesting depth
+     *
+     * The depth is the number of objects or arrays that are currently open.
+     *
+     * @return the current nesting depth
+     */
+    size_t depth() const { return _stack.size(); }
+
+    /**
+     * Returns the value of the most recent boolean event
+     *
+     * @return the value of the most recent boolean event
+     */
+    bool getBool() const { return _boolValue; }
+
+    /**
+     * Returns the value of the most recent number event
+     *
+     * @return the value of the most recent number event
+     */
+    double getNumber() const { return _numberValue; }
+
+    /**
+     * Returns the value of the most recent number event as a long
+     *
+     * The number is truncated (and clamped to the range of a long).
+     *
+     * @return the value of the most recent number event as a long
+     */
+    long getLong() const;
+
+    /**
+     * Returns the value of the most recent string or key event
+     *
+     * This is a view into either the source text or a decoding buffer. It is
+     * only valid until the next call to {@link #next}.
+     *
+     * @return the value of the most recent string or key event
+     */
+    std::string_view getString() const { return _stringValue; }
+
+    /**
+     * Returns a description of the most recent syntax error
+     *
+     * The description includes the line number and the offending text. If
+     * there is no error, this returns the empty string.
+     *
+     * @return a description of the most recent syntax error
+     */
+    std::string getError() const;
+
+#pragma mark -
+#pragma mark Push Interfaces
+    /**
+     * Parses the remaining JSON value, sending all events to the handler.
+     *
+     * Parsing stops when the value is complete, when there is a syntax error,
+     * or when an event of the handler returns false.
+     *
+     * @param handler   The handler to receive the events
+     *
+     * @return true if the value was parsed completely
+     */
+    bool parse(JsonHandler& handler);
+
+    /**
+     * Returns a newly allocated JsonValue for the next JSON value.
+     *
+     * The tree is built directly from the parsing events, without any
+     * intermediate representation. If arena is true, every node in the tree
+     * is allocated from a single arena. This is much faster for large files,
+     * but the arena is only released when every node of the tree (including
+     * any detached subtrees) has been deleted.
+     *
+     * If there is a parsing error, this method will return nullptr. The
+     * details are available from {@link #getError}.
+     *
+     * @param arena Whether to allocate the tree from an arena
+     *
+     * @return a newly allocated JsonValue for the next JSON value.
+     */
+    std::shared_ptr<JsonValue> readValue(bool arena=false);
+
+    /**
+     * Stores the next JSON value in the given node.
+     *
+     * The node is reset to match the next value. Any descendants are built
+     * directly from the parsing events, without any intermediate
+     * representation. If arena is true, every descendant is allocated from
+     * a single arena. This is much faster for large files, but the arena
+     * is only released when every descendant has been deleted.
+     *
+     * If there is a parsing error, this method will return false. The
+     * details are available from {@link #getError}.
+     *
+     * @param value The node to store the result
+     * @param arena Whether to allocate the descendants from an arena
+     *
+     * @return true if the value was read successfully
+     */
+    bool readValue(JsonValue* value, bool arena=false);
+
+#pragma mark -
+#pragma mark Internal Helpers
+private:
+    /**
+     * Advances the read position past any whitespace.
+     */
+    void skipSpace() {
+        while (_curr < _end && (unsigned char)*_curr <= 32) {
+            _curr++;
+        }
+    }
+
+    /**
+     * Returns the error event, recording the error position and message.
+     *
+     * @param pos   The position of the error
+     * @param msg   The error description
+     *
+     * @return the error event
+     */
+    Event fail(const char* pos, const char* msg);
+
+    /**
+     * Returns the event for the value at the read position.
+     *
+     * @return the event for the value at the read position.
+     */
+    Event readToken();
+
+    /**
+     * Reads the string at the read position, storing it in {@link #_stringValue}.
+     *
+     * @return false if the string is malformed
+     */
+    bool readString();
+
+    /**
+     * Reads the number at the read position, storing it in {@link #_numberValue}.
+     */
+    void readNumber();
+
+    /**
+     * Updates the parsing state after a complete value.
+     */
+    void endValue();
+};
+
+}
+#endif /* __CU_JSON_PARSER_H__ */
@@ -175,9 +175,15 @@ public:
      * information about the parsing error will be passed to an assert.  Hence
      * error messages are suppressed if asserts are turned off.
      *
+     * If arena is true, the nodes of the JSON tree are allocated from a single
+     * arena (see {@link JsonParser#readValue}). This is ideal for large files
+     * that are discarded after they are processed.
+     *
+     * @param arena Whether to allocate the JSON tree from an arena
+     *
      * @return a newly allocated JsonValue for the next available JSON string.
      */
-    std::shared_ptr<JsonValue> readJson();
+    std::shared_ptr<JsonValue> readJson(bool arena=false);
     
 };
 
@@ -34,6 +34,7 @@
 #include "CUTextWriter.h"
 #include "CUJsonReader.h"
 #include "CUJsonWriter.h"
+#include "CUJsonParser.h"
 #include "CUBinaryReader.h"
 #include "CUBinaryWriter.h"
 
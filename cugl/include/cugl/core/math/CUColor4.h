@@ -1972,6 +1972,26 @@ public:
      */
     static Color4* blendPre(Color4 c1, Color4 c2, Color4* dst);
     
+    /**
+     * Multiplies an array of packed colors by the given tint.
+     *
+     * The colors are in the format returned by {@link #getPacked}. Each
+     * component is multiplied by the corresponding component of tint
+     * (interpreted in the range 0..1), and the result is rounded to the
+     * nearest byte. This is the operation used to tint vertex colors, and
+     * it is vectorized when the math library has vector support.
+     *
+     * It is safe for input and output to be the same array.
+     *
+     * @param input     The array of packed colors
+     * @param tint      The color to multiply by
+     * @param output    The array to store the results
+     * @param size      The number of colors in the two arrays
+     *
+     * @return A reference to output for chaining
+     */
+    static Uint32* multiply(const Uint32* input, Color4 tint, Uint32* output, size_t size);
+    
 #pragma mark Operators
     /**
      * Adds the given color to this one in place.
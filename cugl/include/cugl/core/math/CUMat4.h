@@ -6,12 +6,10 @@
 //  matrix in OpenGL. The class has support for basic camera creation, as well
 //  as the traditional transforms. It can transform any of Vec2, Vec3, and Vec4.
 //
-//  Even though this class is a candidate for vectorization, we have avoided it.
-//  Vectorization only pays off when working with long arrays of vectors. In
-//  addition, the vectorization APIs are a continual moving target. Most of the
-//  time, it is best to enable auto-vectorization in your compiler. Indeed, in
-//  our experiments, naive code with -O3 outperforms the manual vectorization
-//  by almost a full order of magnitude.
+//  Matrix multiplication, inversion, and the array transforms have explicit
+//  vector implementations. These are enabled when the build system defines
+//  either CU_MATH_VECTOR_SSE or CU_MATH_VECTOR_NEON64. Otherwise, this class
+//  falls back to scalar code and relies on the compiler to auto-vectorize.
 //
 //  Because math objects are intended to be on the stack, we do not provide
 //  any shared pointer support in this class.
@@ -71,6 +71,13 @@ typedef Uint32 CUEnum;
 	#include <cpu-features.h>
 #endif
 
+// Vector backends (selected by the build system)
+#if defined CU_MATH_VECTOR_SSE
+    #include <emmintrin.h>
+#elif defined CU_MATH_VECTOR_NEON64
+    #include <arm_neon.h>
+#endif
+
 /**
  * Returns value, clamped to the range [min,max]
  *
@@ -6,12 +6,11 @@
 //  arithmetic, as well as conversions to color formats. It also has
 //  homogenous vector support for Vec3.
 //
-//  Even though this class is a candidate for vectorization, we have avoided it.
-//  Vectorization only pays off when working with long arrays of vectors. In
-//  addition, the vectorization APIs are a continual moving target. Most of the
-//  time, it is best to enable auto-vectorization in your compiler. Indeed, in
-//  our experiments, naive code with -O3 outperforms the manual vectorization
-//  by almost a full order of magnitude.
+//  Even though this class is a candidate for vectorization, we only vectorize
+//  a few operations. Vectorization only pays off when working with long arrays
+//  of vectors, and most of the time it is best to let the compiler do this.
+//  The explicit vector code is enabled by the build system, which defines
+//  either CU_MATH_VECTOR_SSE or CU_MATH_VECTOR_NEON64.
 //
 //  Because math objects are intended to be on the stack, we do not provide
 //  any shared pointer support in this class.
@@ -393,9 +392,9 @@ public:
      */
     Vec4& add(const Vec4 v) {
     #if defined CU_MATH_VECTOR_SSE
-        this->v = _mm_add_ps(this->v,v.v);
+        _mm_storeu_ps(&x,_mm_add_ps(_mm_loadu_ps(&x),_mm_loadu_ps(&v.x)));
     #elif defined CU_MATH_VECTOR_NEON64
-        this->v = vaddq_f32(this->v,v.v);
+        vst1q_f32(&x,vaddq_f32(vld1q_f32(&x),vld1q_f32(&v.x)));
     #else
         x += v.x; y += v.y; z += v.z;  w += v.w;
     #endif
@@ -4,8 +4,9 @@
 //
 //  This module is a factory for a lightweight earclipping triangulator. While
 //  we do have access to the very powerful Pol2Tri, that API has a lot of overhead
-//  with it. While earclipping is an O(n^2) algorithm, the lower overhead of this
-//  class makes it more performant in smaller applications.
+//  with it. This class keeps the ears in a priority queue and the vertices in a
+//  spatial grid, so typical polygons triangulate in O(n log n) time with very
+//  little overhead.
 //
 //  Because math objects are intended to be on the stack, we do not provide
 //  any shared pointer support in this class.
@@ -57,11 +58,14 @@ class Poly2;
  * (but not self-crossings). All triangles produced are guaranteed to be
  * counter-clockwise.
  *
- * The running time of this algorithm is O(n^2), making it one of the slower
- * triangulation methods available. However, it has very low overhead, making
- * it better than {@link DelaunayTriangulator} in some cases. In addition, it
- * is guaranteed to make better (e.g. not thin) triangles than
- * {@link MonotoneTriangulator}
+ * The algorithm always clips the most extruded ear. The ears are kept in a
+ * priority queue on their angle, and the vertices are placed in a uniform grid
+ * so that testing an ear only checks the vertices near it. Hence the
+ * running time is O(n log n) for typical polygons, though it is still O(n^2)
+ * in the worst case (e.g. when many vertices crowd a single ear). It
+ * has very low overhead, making it better than {@link DelaunayTriangulator}
+ * in some cases. In addition, it is guaranteed to make better (e.g. not thin)
+ * triangles than {@link MonotoneTriangulator}
  *
  * As with all factories, the methods are broken up into three phases:
  * initialization, calculation, and materialization. To use the factory, you
@@ -96,6 +100,25 @@ private:
     /** The output results of the triangulation */
     std::vector<Uint32> _output;
     
+    /** The current ears, as a max-heap ordered by angle */
+    std::vector<Vertex*> _ears;
+    /** The first position in the grid vertices for each cell */
+    std::vector<Uint32> _gridstart;
+    /** The number of (active) grid vertices for each cell */
+    std::vector<Uint32> _gridcount;
+    /** The active vertices sorted by grid cell */
+    std::vector<Vertex*> _gridverts;
+    /** The bottom left corner of the grid */
+    Vec2 _gridorigin;
+    /** The number of grid cells per unit length */
+    float _gridscale;
+    /** The number of grid columns */
+    Uint32 _gridcols;
+    /** The number of grid rows */
+    Uint32 _gridrows;
+    /** The tolerance for the grid bounds (to account for round-off) */
+    float _gridslop;
+    
     /** Whether or not the calculation has been run */
     bool _calculated;
 
@@ -372,6 +395,65 @@ private:
      */
     void computeTriangles();
 
+    /**
+     * Places the active vertices in a uniform grid
+     *
+     * This grid is used to find the vertices inside of a potential ear.
+     */
+    void allocateGrid();
+
+    /**
+     * Updates the ear status of the given vertex
+     *
+     * This method should be called whenever a neighbor of the vertex is
+     * clipped. It adds the vertex to the ear queue, moves it in the queue,
+     * or removes it from the queue as appropriate.
+     *
+     * @param vertex    The vertex to update
+     */
+    void updateEar(Vertex* vertex);
+
+    /**
+     * Returns true if another vertex lies inside the ear region of vertex
+     *
+     * The ear region for a vertex is the triangle defined by it and its
+     * two neighbors. Copies of the vertex or its neighbors (created by
+     * slicing holes) are ignored.
+     *
+     * @param vertex    The vertex to check
+     *
+     * @return true if another vertex lies inside the ear region of vertex
+     */
+    bool isBlocked(Vertex* vertex) const;
+
+    /**
+     * Moves the ear at the given queue position up to restore the heap
+     *
+     * @param pos   The position in the ear queue
+     */
+    void raiseEar(size_t pos);
+
+    /**
+     * Moves the ear at the given queue position down to restore the heap
+     *
+     * @param pos   The position in the ear queue
+     */
+    void lowerEar(size_t pos);
+
+    /**
+     * Removes the given vertex from the ear queue
+     *
+     * @param vertex    The vertex to remove
+     */
+    void removeEar(Vertex* vertex);
+
+    /**
+     * Removes the given (clipped) vertex from the grid
+     *
+     * @param vertex    The vertex to remove
+     */
+    void removeGrid(Vertex* vertex);
+
 };
 
 }
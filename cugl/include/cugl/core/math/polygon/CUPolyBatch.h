@@ -0,0 +1,563 @@
+//
+//  CUPolyBatch.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module is a factory for triangulating or extruding many paths at
+//  once. The other polygon factories process a single path on the calling
+//  thread. That is fine for a single shape, but scenes (or level loads)
+//  with hundreds of shapes spend a lot of time processing them one at a
+//  time. This factory splits the paths across a pool of worker threads,
+//  each with its own factory instances, and gathers the results into a
+//  single flat vertex and index buffer.
+//
+//  This class uses our standard shared-pointer architecture, as it owns
+//  a thread pool.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty. In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#ifndef __CU_POLY_BATCH_H__
+#define __CU_POLY_BATCH_H__
+
+#include <cugl/core/CUBase.h>
+#include <cugl/core/math/polygon/CUPolyEnums.h>
+#include <cugl/core/math/CUPath2.h>
+#include <cugl/core/math/CUPoly2.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace cugl {
+
+// Forward references
+class ThreadPool;
+
+/**
+ * This class is a factory for triangulating or extruding many paths at once.
+ *
+ * Each path added to this factory produces one polygon. Triangulation uses
+ * either {@link EarclipTriangulator} or {@link DelaunayTriangulator}, and
+ * extrusion uses either {@link SimpleExtruder} or {@link ComplexExtruder}.
+ * The polygons are exactly the ones that those factories produce for each
+ * path on its own.
+ *
+ * The paths are split into (at most) {@link #getThreadCount} contiguous
+ * ranges of roughly equal vertex count. The first range is processed on
+ * the calling thread, and the rest are processed by a pool of worker
+ * threads. Each range has its own factory instances, which are reused
+ * between calculations, so a batch does not allocate any factories once
+ * it has warmed up. The polygons are then gathered, in order, into a single
+ * vertex buffer and a single index buffer. The indices refer to positions
+ * in the shared vertex buffer, so the entire batch can be drawn as a single
+ * mesh. Alternatively, {@link #getPolygon} extracts an individual polygon.
+ *
+ * As with all factories, the methods are broken up into three phases:
+ * initialization, calculation, and materialization. To use the factory,
+ * you first add the paths with the initialization methods. You then call
+ * one of the calculation methods, which blocks until all of the paths are
+ * processed. Finally, you use the materialization methods to access the
+ * data. This factory is not thread safe, and it should only be used from
+ * one thread at a time.
+ */
+class PolyBatch {
+#pragma mark Values
+private:
+    /** Internal class storing the factories for a single task */
+    class Worker;
+
+    /** The number of threads used to process the paths */
+    Uint32 _threads;
+    /** The worker threads (one less than the thread count) */
+    std::shared_ptr<ThreadPool> _workers;
+    /** The factories for each task */
+    std::vector<std::unique_ptr<Worker>> _tasks;
+
+    /** The extrusion joint settings */
+    poly2::Joint  _joint;
+    /** The extrusion end cap settings */
+    poly2::EndCap _endcap;
+    /** The rounded joint/cap tolerance for simple extrusion */
+    float  _tolerance;
+    /** The mitre limit for extrusion */
+    float  _mitrelimit;
+    /** The resolution scale for complex extrusion */
+    Uint32 _resolution;
+
+    /** The input paths */
+    std::vector<Path2> _input;
+    /** The holes of all input paths (sorted by path) */
+    std::vector<Path2> _holes;
+    /** The first hole of each input path (plus the total at the end) */
+    std::vector<Uint32> _holeoffs;
+
+    /** The output polygons, as a single flat buffer */
+    Poly2 _output;
+    /** The first vertex of each polygon (plus the total at the end) */
+    std::vector<Uint32> _vertoffs;
+    /** The first index of each polygon (plus the total at the end) */
+    std::vector<Uint32> _indxoffs;
+    /** Whether or not the calculation has been run */
+    bool _calculated;
+
+#pragma mark -
+#pragma mark Constructors
+public:
+    /**
+     * Creates a new degenerate batch factory on the stack.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    PolyBatch();
+
+    /**
+     * Deletes this batch factory, disposing all resources
+     */
+    ~PolyBatch();
+
+    /**
+     * Disposes all of the resources used by this batch factory.
+     *
+     * A disposed factory can be safely reinitialized.
+     */
+    void dispose();
+
+    /**
+     * Initializes a batch factory with the given number of threads.
+     *
+     * The calling thread counts as one of the threads, so a factory with
+     * one thread does not create any worker threads.
+     *
+     * @param threads   The number of threads used to process the paths
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(Uint32 threads = 4);
+
+    /**
+     * Returns a newly allocated batch factory with the given number of threads.
+     *
+     * The calling thread counts as one of the threads, so a factory with
+     * one thread does not create any worker threads.
+     *
+     * @param threads   The number of threads used to process the paths
+     *
+     * @return a newly allocated batch factory with the given number of threads.
+     */
+    static std::shared_ptr<PolyBatch> alloc(Uint32 threads = 4) {
+        std::shared_ptr<PolyBatch> result = std::make_shared<PolyBatch>();
+        return (result->init(threads) ? result : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Attributes
+    /**
+     * Returns the number of threads used to process the paths
+     *
+     * The calling thread counts as one of the threads.
+     *
+     * @return the number of threads used to process the paths
+     */
+    Uint32 getThreadCount() const { return _threads; }
+
+    /**
+     * Sets the number of threads used to process the paths
+     *
+     * The calling thread counts as one of the threads, so a value of 1
+     * processes all of the paths serially. Changing this value replaces
+     * the worker threads.
+     *
+     * @param threads   The number of threads used to process the paths
+     */
+    void setThreadCount(Uint32 threads);
+
+    /**
+     * Sets the joint value for the extrusion.
+     *
+     * The joint type determines how the extrusion joins the extruded
+     * line segments together. See {@link poly2::Joint} for the
+     * description of the types.
+     *
+     * @param joint     The extrusion joint type
+     */
+    void setJoint(poly2::Joint joint) { _joint = joint; }
+
+    /**
+     * Returns the joint value for the extrusion.
+     *
+     * The joint type determines how the extrusion joins the extruded
+     * line segments together. See {@link poly2::Joint} for the
+     * description of the types.
+     *
+     * @return the joint value for the extrusion.
+     */
+    poly2::Joint getJoint() const { return _joint; }
+
+    /**
+     * Sets the end cap value for the extrusion.
+     *
+     * The end cap type determines how the extrusion draws the ends of
+     * the line segments at the start and end of the path. See
+     * {@link poly2::EndCap} for the description of the types.
+     *
+     * @param endcap    The extrusion end cap type
+     */
+    void setEndCap(poly2::EndCap endcap) { _endcap = endcap; }
+
+    /**
+     * Returns the end cap value for the extrusion.
+     *
+     * The end cap type determines how the extrusion draws the ends of
+     * the line segments at the start and end of the path. See
+     * {@link poly2::EndCap} for the description of the types.
+     *
+     * @return the end cap value for the extrusion.
+     */
+    poly2::EndCap getEndCap() const { return _endcap; }
+
+    /**
+     * Sets the error tolerance of the simple extrusion.
+     *
+     * This value is only used by {@link SimpleExtruder} for rounded joints
+     * and caps. See {@link SimpleExtruder#setTolerance} for details.
+     *
+     * @param tolerance The error tolerance of the simple extrusion.
+     */
+    void setTolerance(float tolerance) { _tolerance = tolerance; }
+
+    /**
+     * Returns the error tolerance of the simple extrusion.
+     *
+     * This value is only used by {@link SimpleExtruder} for rounded joints
+     * and caps. See {@link SimpleExtruder#setTolerance} for details.
+     *
+     * @return the error tolerance of the simple extrusion.
+     */
+    float getTolerance() const { return _tolerance; }
+
+    /**
+     * Sets the mitre limit of the extrusion.
+     *
+     * The mitre limit sets how "pointy" a mitre joint is allowed to be
+     * before the algorithm switches it back to a bevel/square joint.
+     *
+     * @param limit     The mitre limit for joint calculations
+     */
+    void setMitreLimit(float limit) { _mitrelimit = limit; }
+
+    /**
+     * Returns the mitre limit of the extrusion.
+     *
+     * The mitre limit sets how "pointy" a mitre joint is allowed to be
+     * before the algorithm switches it back to a bevel/square joint.
+     *
+     * @return the mitre limit for joint calculations
+     */
+    float getMitreLimit() const { return _mitrelimit; }
+
+    /**
+     * Sets the resolution scale of the complex extrusion.
+     *
+     * This value is only used by {@link ComplexExtruder}. See
+     * {@link ComplexExtruder#setResolution} for details.
+     *
+     * @param resolution    The resolution scale of the complex extrusion
+     */
+    void setResolution(Uint32 resolution) { _resolution = resolution; }
+
+    /**
+     * Returns the resolution scale of the complex extrusion.
+     *
+     * This value is only used by {@link ComplexExtruder}. See
+     * {@link ComplexExtruder#setResolution} for details.
+     *
+     * @return the resolution scale of the complex extrusion
+     */
+    Uint32 getResolution() const { return _resolution; }
+
+#pragma mark -
+#pragma mark Initialization
+    /**
+     * Returns the number of paths in this batch
+     *
+     * @return the number of paths in this batch
+     */
+    size_t size() const { return _input.size(); }
+
+    /**
+     * Adds the given path to this batch, returning its position.
+     *
+     * A path to be triangulated should be closed and define its hull in a
+     * counter-clockwise traversal. The path is copied. The factory does not
+     * retain any references to the original data.
+     *
+     * @param path      The path to add
+     *
+     * @return the position of the path in this batch
+     */
+    size_t addPath(const Path2& path);
+
+    /**
+     * Adds the given vertices to this batch as a path, returning its position.
+     *
+     * A path to be triangulated should be closed and define its hull in a
+     * counter-clockwise traversal. The vertices are copied. The factory does
+     * not retain any references to the original data.
+     *
+     * @param points    The path vertices
+     * @param closed    Whether the path is closed
+     *
+     * @return the position of the path in this batch
+     */
+    size_t addPath(const std::vector<Vec2>& points, bool closed) {
+        return addPath(points.data(),points.size(),closed);
+    }
+
+    /**
+     * Adds the given vertices to this batch as a path, returning its position.
+     *
+     * A path to be triangulated should be closed and define its hull in a
+     * counter-clockwise traversal. The vertices are copied. The factory does
+     * not retain any references to the original data.
+     *
+     * @param points    The path vertices
+     * @param size      The number of vertices
+     * @param closed    Whether the path is closed
+     *
+     * @return the position of the path in this batch
+     */
+    size_t addPath(const Vec2* points, size_t size, bool closed);
+
+    /**
+     * Adds the given paths to this batch.
+     *
+     * The paths are added in order, after any paths already in this batch.
+     * They are copied. The factory does not retain any references to the
+     * original data.
+     *
+     * @param paths     The paths to add
+     */
+    void addPaths(const std::vector<Path2>& paths);
+
+    /**
+     * Adds a hole to the most recently added path.
+     *
+     * Holes are only used by triangulation, and are ignored by extrusion.
+     * The hole should be a clockwise path inside of the most recent
+     * path, as required by {@link EarclipTriangulator#addHole}. The hole is
+     * copied. The factory does not retain any references to the original data.
+     *
+     * @param hole      The hole to add
+     */
+    void addHole(const Path2& hole);
+
+    /**
+     * Adds a hole to the most recently added path.
+     *
+     * Holes are only used by triangulation, and are ignored by extrusion.
+     * The hole should be a clockwise path inside of the most recent
+     * path, as required by {@link EarclipTriangulator#addHole}. The vertices
+     * are copied. The factory does not retain any references to the original
+     * data.
+     *
+     * @param points    The hole vertices
+     * @param size      The number of vertices
+     */
+    void addHole(const Vec2* points, size_t size);
+
+#pragma mark -
+#pragma mark Calculation
+    /**
+     * Clears all computed data, but still maintains the settings.
+     *
+     * This method preserves all initial paths, as well as the thread
+     * count and extrusion settings.
+     */
+    void reset();
+
+    /**
+     * Clears all internal data, including the initial paths.
+     *
+     * When this method is called, you will need to add new paths before
+     * the calculation is run again. The thread count and extrusion
+     * settings are preserved.
+     */
+    void clear();
+
+    /**
+     * Triangulates all of the paths in this batch.
+     *
+     * The polygon for each path is exactly the one produced by a single
+     * {@link EarclipTriangulator} (or {@link DelaunayTriangulator} if the
+     * parameter is true). Paths with fewer than three vertices produce
+     * an empty polygon. This method blocks until all paths are processed.
+     *
+     * @param delaunay  Whether to use Delaunay triangulation
+     */
+    void triangulate(bool delaunay = false);
+
+    /**
+     * Extrudes all of the paths in this batch with the given width.
+     *
+     * The polygon for each path is exactly the one produced by a single
+     * {@link SimpleExtruder} (or {@link ComplexExtruder} if the parameter
+     * is true) with the current extrusion settings. Paths with fewer than
+     * two vertices produce an empty polygon. This method blocks until all
+     * paths are processed.
+     *
+     * @param width     The stroke width of the extrusion
+     * @param complex   Whether to use the (precise) complex extrusion
+     */
+    void extrude(float width, bool complex = false);
+
+#pragma mark -
+#pragma mark Materialization
+    /**
+     * Returns the vertices of all polygons in this batch.
+     *
+     * The vertices of polygon i are the positions from
+     * {@link #getVertexOffset}(i) up to (but not including)
+     * {@link #getVertexOffset}(i+1). If the calculation is not yet
+     * performed, this buffer is empty.
+     *
+     * @return the vertices of all polygons in this batch.
+     */
+    const std::vector<Vec2>& getVertices() const { return _output.vertices; }
+
+    /**
+     * Returns the triangle indices of all polygons in this batch.
+     *
+     * The indices of polygon i are the positions from
+     * {@link #getIndexOffset}(i) up to (but not including)
+     * {@link #getIndexOffset}(i+1). They refer to positions in
+     * {@link #getVertices}, so the batch may be drawn as a single mesh.
+     * If the calculation is not yet performed, this buffer is empty.
+     *
+     * @return the triangle indices of all polygons in this batch.
+     */
+    const std::vector<Uint32>& getIndices() const { return _output.indices; }
+
+    /**
+     * Returns the first vertex of the given polygon.
+     *
+     * The value for {@link #size} is the total number of vertices.
+     *
+     * @param index The polygon position
+     *
+     * @return the first vertex of the given polygon.
+     */
+    Uint32 getVertexOffset(size_t index) const;
+
+    /**
+     * Returns the first triangle index of the given polygon.
+     *
+     * The value for {@link #size} is the total number of indices.
+     *
+     * @param index The polygon position
+     *
+     * @return the first triangle index of the given polygon.
+     */
+    Uint32 getIndexOffset(size_t index) const;
+
+    /**
+     * Returns all of the polygons in this batch as a single polygon.
+     *
+     * The batch does not maintain references to this polygon and it is
+     * safe to modify it. If the calculation is not yet performed, this
+     * method will return the empty polygon.
+     *
+     * @return all of the polygons in this batch as a single polygon.
+     */
+    Poly2 getPolygon() const;
+
+    /**
+     * Returns the polygon for the given path.
+     *
+     * The batch does not maintain references to this polygon and it is
+     * safe to modify it. If the calculation is not yet performed, this
+     * method will return the empty polygon.
+     *
+     * @param index The path position
+     *
+     * @return the polygon for the given path.
+     */
+    Poly2 getPolygon(size_t index) const;
+
+    /**
+     * Stores the polygon for the given path in the given buffer.
+     *
+     * This method will append the vertices to the given polygon. If the
+     * buffer is not empty, the indices will be adjusted accordingly. You
+     * should clear the buffer first if you do not want to preserve the
+     * original data.
+     *
+     * If the calculation is not yet performed, this method will do nothing.
+     *
+     * @param index     The path position
+     * @param buffer    The buffer to store the polygon
+     *
+     * @return a reference to the buffer for chaining.
+     */
+    Poly2* getPolygon(size_t index, Poly2* buffer) const;
+
+    /**
+     * Returns the polygons of all paths in this batch.
+     *
+     * The batch does not maintain references to these polygons and it is
+     * safe to modify them. If the calculation is not yet performed, this
+     * method will return the empty list.
+     *
+     * @return the polygons of all paths in this batch.
+     */
+    std::vector<Poly2> getPolygons() const;
+
+#pragma mark -
+#pragma mark Internal Computation
+private:
+    /**
+     * Processes all paths, using the given function for each path.
+     *
+     * The function should compute the polygon for the path and append it to
+     * the given buffer, adjusting the indices. The paths are divided into
+     * contiguous ranges, each processed by a separate task, and the results
+     * are merged in order.
+     *
+     * @param process   The function to process a single path
+     */
+    void compute(const std::function<void(Worker*,size_t,Poly2*)>& process);
+
+    /** Copying is only allowed via shared pointer. */
+    CU_DISALLOW_COPY_AND_ASSIGN(PolyBatch);
+};
+
+}
+
+#endif /* __CU_POLY_BATCH_H__ */
@@ -39,6 +39,7 @@
 #include "CUEarclipTriangulator.h"
 #include "CUDelaunayTriangulator.h"
 #include "CUPathSmoother.h"
+#include "CUPolyBatch.h"
 
 // Because we are exposing this internally for how
 #include "clipper.hpp"
@@ -34,14 +34,21 @@
 //
 #ifndef __CU_LOGGER_H__
 #define __CU_LOGGER_H__
+#include <SDL_stdinc.h>
+#include <condition_variable>
 #include <unordered_map>
+#include <cstdarg>
+#include <atomic>
 #include <string>
+#include <vector>
 #include <memory>
+#include <mutex>
 
 namespace cugl {
 
 // Forward declaration
 class TextWriter;
+class ThreadPool;
 
 /**
  * This class provides an interface for fine-grained logging.
@@ -62,6 +69,15 @@ class TextWriter;
  * (defined as {@link #getConsoleLevel}) and will process messages accordingly.
  * Note that the console uses its own timestamps, and so there will be a few
  * microseconds difference between the log file and the console.
+ *
+ * By default, a logger formats and writes each message on the calling thread.
+ * This is not safe if several threads log to the same channel, and the file
+ * I/O can stall the caller. An asynchronous logger (see {@link #setAsync})
+ * instead copies the format string and the raw arguments of each message
+ * into a lock-free buffer owned by the calling thread. A background thread
+ * drains these buffers, formats the messages in timestamp order, and writes
+ * them to the file in batches. Logging from multiple threads is safe in this
+ * mode.
  */
 class Logger {
 public:
@@ -96,7 +112,26 @@ public:
         VERBOSE_MSG = 6
     };
     
+    /**
+     * An enum to represent the policy for a full asynchronous buffer
+     *
+     * Each thread logging to an asynchronous logger has its own buffer of
+     * pending messages. If the background thread cannot keep up, this buffer
+     * can fill up. This policy determines what happens to a message that
+     * does not fit.
+     */
+    enum class Overflow : int {
+        /** Wait for the background thread to make room (DEFAULT) */
+        BLOCK = 0,
+        /** Discard the message, counting it in {@link #getDropped} */
+        DROP = 1
+    };
+    
 protected:
+    /** A buffer of pending messages for a single thread */
+    class Ring;
+    
+
     /** The list of all active logs */
     static std::unordered_map<std::string, std::shared_ptr<Logger>> _channels;
     /** The SDL category to assign to the next allocated log */
@@ -131,6 +166,33 @@ protected:
     /** Whether this channel is still open. */
     bool _open;
     
+    /** Whether messages are formatted and written on a background thread */
+    bool _async;
+    /** The policy for messages that do not fit in an asynchronous buffer */
+    Overflow _overflow;
+    /** The capacity (in bytes) of each per-thread buffer */
+    size_t _ringSize;
+    /** The unique id of the current asynchronous session */
+    Uint64 _session;
+    /** The per-thread buffers of the current asynchronous session */
+    std::vector<std::shared_ptr<Ring>> _rings;
+    /** The background thread for asynchronous logging */
+    std::shared_ptr<ThreadPool> _drainer;
+    /** A mutex for the buffer list and the background thread state */
+    std::mutex _drainMutex;
+    /** A condition variable to wake up the background thread */
+    std::condition_variable _drainWake;
+    /** A condition variable to signal a completed flush */
+    std::condition_variable _drainDone;
+    /** The number of flushes requested of the background thread */
+    Uint64 _flushAsked;
+    /** The number of flushes completed by the background thread */
+    Uint64 _flushDone;
+    /** Whether the background thread should stop */
+    bool _stopping;
+    /** The number of messages dropped because a buffer was full */
+    std::atomic<Uint64> _dropped;
+    
 #pragma mark Constructors
 public:
     /**
@@ -176,6 +238,40 @@ private:
      */
     void expand(size_t size);
     
+    /**
+     * Returns the buffer of the calling thread for asynchronous logging.
+     *
+     * The buffer is allocated the first time a thread logs to this channel
+     * in the current asynchronous session.
+     *
+     * @return the buffer of the calling thread for asynchronous logging.
+     */
+    Ring* acquireRing();
+    
+    /**
+     * Adds a message to the buffer of the calling thread.
+     *
+     * The message is stored as the format string and the raw arguments, and
+     * is formatted later by the background thread. If the format string uses
+     * features that cannot be deferred (such as positional arguments), the
+     * message is formatted immediately instead.
+     *
+     * @param level     The message level (-1 for the default levels)
+     * @param format    The formatting string
+     * @param args      The printf-style subsitution arguments
+     */
+    void enqueue(int level, const char* format, va_list args);
+    
+    /**
+     * Runs the background thread for asynchronous logging.
+     *
+     * This method repeatedly drains the per-thread buffers, formats the
+     * messages in timestamp order, and writes them to the file as a single
+     * batch. It returns once the logger leaves asynchronous mode and all
+     * pending messages have been written.
+     */
+    void drain();
+    
 #pragma mark Static Accessors
 public:
     /**
@@ -333,6 +429,99 @@ public:
      */
     void setAutoFlush(bool value);
     
+#pragma mark Asynchronous Logging
+    /**
+     * Returns true if this logger is asynchronous.
+     *
+     * An asynchronous logger copies the format string and the arguments of
+     * each message into a buffer owned by the calling thread, without any
+     * locking. A background thread formats the messages and writes them to
+     * the file (and the console) in batches. This keeps file I/O off of the
+     * calling thread, and makes it safe to log from several threads at once.
+     *
+     * @return true if this logger is asynchronous.
+     */
+    bool isAsync() const { return _async; }
+    
+    /**
+     * Sets whether this logger is asynchronous.
+     *
+     * An asynchronous logger copies the format string and the arguments of
+     * each message into a buffer owned by the calling thread, without any
+     * locking. A background thread formats the messages and writes them to
+     * the file (and the console) in batches. This keeps file I/O off of the
+     * calling thread, and makes it safe to log from several threads at once.
+     *
+     * String arguments are copied, so they may be freed as soon as the log
+     * call returns. With auto flush, the file is flushed after each batch
+     * rather than after each message. Call {@link #flush} to wait until all
+     * messages logged so far are in the file.
+     *
+     * Leaving asynchronous mode writes all pending messages before it
+     * returns. This method should not be called while other threads are
+     * logging to this channel.
+     *
+     * @param value whether this logger is asynchronous
+     */
+    void setAsync(bool value);
+    
+    /**
+     * Returns the policy for a full asynchronous buffer.
+     *
+     * If a thread logs messages faster than the background thread can write
+     * them, its buffer fills up. By default, the thread then waits for room
+     * ({@link Overflow#BLOCK}). With {@link Overflow#DROP}, the message is
+     * discarded instead, and counted by {@link #getDropped}.
+     *
+     * @return the policy for a full asynchronous buffer.
+     */
+    Overflow getOverflow() const { return _overflow; }
+    
+    /**
+     * Sets the policy for a full asynchronous buffer.
+     *
+     * If a thread logs messages faster than the background thread can write
+     * them, its buffer fills up. By default, the thread then waits for room
+     * ({@link Overflow#BLOCK}). With {@link Overflow#DROP}, the message is
+     * discarded instead, and counted by {@link #getDropped}.
+     *
+     * @param policy    The policy for a full asynchronous buffer
+     */
+    void setOverflow(Overflow policy) { _overflow = policy; }
+    
+    /**
+     * Returns the capacity in bytes of each per-thread buffer.
+     *
+     * Each thread logging to an asynchronous logger gets its own buffer of
+     * this size. A message that is larger than the buffer is always dropped.
+     * The default is 64 KB.
+     *
+     * @return the capacity in bytes of each per-thread buffer.
+     */
+    size_t getBufferSize() const { return _ringSize; }
+    
+    /**
+     * Sets the capacity in bytes of each per-thread buffer.
+     *
+     * Each thread logging to an asynchronous logger gets its own buffer of
+     * this size. A message that is larger than the buffer is always dropped.
+     * The size is rounded up to a power of two, and only applies to buffers
+     * allocated after this call. The default is 64 KB.
+     *
+     * @param size  The capacity in bytes of each per-thread buffer
+     */
+    void setBufferSize(size_t size);
+    
+    /**
+     * Returns the number of messages dropped by this logger.
+     *
+     * A message is dropped when it does not fit in the buffer of an
+     * asynchronous logger (see {@link #getOverflow}).
+     *
+     * @return the number of messages dropped by this logger.
+     */
+    Uint64 getDropped() const { return _dropped.load(std::memory_order_relaxed); }
+    
 #pragma mark Message Logging
     /**
      * Sends a message to this logger.
@@ -408,6 +597,9 @@ public:
      * Otherwise, the file is written after every message. To improve
      * performance, you may wish to disable auto flush if you are writting a
      * large number of messages per animation frame.
+     *
+     * For an asynchronous logger, this method blocks until the background
+     * thread has written every message logged before the call.
      */
     void flush();
 
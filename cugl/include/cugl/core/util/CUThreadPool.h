@@ -190,6 +190,23 @@ public:
      * @param  task     the task function to add to the thread pool
      */
     void addTask(const std::function<void()> &task);
+
+    /**
+     * Runs the given indexed tasks, returning when they are all complete.
+     *
+     * The task is called once for each index from 0 to count-1. Index 0 is
+     * run on the calling thread, and the rest are added to this pool. This
+     * method blocks until every task has finished, so the tasks may safely
+     * reference the stack of the caller. The order in which the tasks run
+     * is unspecified, so a task should only write to data owned by its index.
+     *
+     * This method should never be called from a task of this pool, as the
+     * nested tasks may wait on a worker that is blocked.
+     *
+     * @param count The number of tasks
+     * @param task  The task to run (given the task index)
+     */
+    void parallelFor(Uint32 count, const std::function<void(Uint32)>& task);
     
     /**
      * Stops the thread pool, marking it for shut down.
@@ -48,6 +48,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <list>
 #include <vector>
 #include <cugl/core/math/CUSize.h>
 #include <cugl/core/math/CURect.h>
@@ -210,6 +211,10 @@ protected:
         Size _size;
         /** A (temporary) SDL surface for computing the atlas textures */
         SDL_Surface* _surface;
+        /** The next free position on the current shelf (dynamic atlases only) */
+        Vec2 _cursor;
+        /** The height of the current shelf (dynamic atlases only) */
+        float _shelf;
         
         /**
          * Lays out the glyphs in reasonably efficient packing.
@@ -309,6 +314,58 @@ protected:
             return (result->init(parent,glyphset) ? result : nullptr);
         }
         
+        /**
+         * Initializes an empty dynamic atlas for the given font
+         *
+         * A dynamic atlas starts with no glyphs. Glyphs are added one at a
+         * time with {@link #insert}, which packs them into horizontal shelves
+         * and copies them straight to the texture. Hence this initializer
+         * creates the (blank) texture immediately, and it may only be called
+         * on the main thread.
+         *
+         * @param parent    The parent font of this atlas
+         * @param size      The width and height of the atlas texture
+         *
+         * @return true if the atlas was successfully initialized
+         */
+        bool initDynamic(Font* parent, int size);
+        
+        /**
+         * Returns a newly allocated dynamic atlas for the given font
+         *
+         * A dynamic atlas starts with no glyphs. Glyphs are added one at a
+         * time with {@link #insert}, which packs them into horizontal shelves
+         * and copies them straight to the texture. Hence this allocator
+         * creates the (blank) texture immediately, and it may only be called
+         * on the main thread.
+         *
+         * @param parent    The parent font of this atlas
+         * @param size      The width and height of the atlas texture
+         *
+         * @return a newly allocated dynamic atlas for the given font
+         */
+        static std::shared_ptr<Atlas> allocDynamic(Font* parent, int size) {
+            std::shared_ptr<Atlas> result = std::make_shared<Atlas>();
+            return (result->initDynamic(parent,size) ? result : nullptr);
+        }
+        
+        /**
+         * Adds a glyph to this dynamic atlas.
+         *
+         * The glyph is placed at the end of the current shelf, or at the
+         * start of a new shelf if the current one is full. The glyph is
+         * rendered and copied to that region of the texture, so this method
+         * may only be called on the main thread. The glyph metrics must
+         * already be known to the parent font.
+         *
+         * This method returns false if there is no room left in the atlas.
+         *
+         * @param thechar   The character to add
+         *
+         * @return true if the glyph was successfully added
+         */
+        bool insert(Uint32 thechar);
+        
         /**
          * Returns true if this font has a glyph for the given (UNICODE) character.
          *
@@ -413,6 +470,25 @@ protected:
         bool materialize();
     };
     
+    /**
+     * This class is a cached set of glyph runs for a single line of text.
+     *
+     * The glyph runs are generated with the origin at (0,0) and no bounding
+     * box. To reuse them, the vertices are translated to the new origin,
+     * provided that the (translated) extent fits in the bounding box.
+     */
+    class CachedRun {
+    public:
+        /** The cache key (the text followed by the tracking width) */
+        std::string key;
+        /** The glyph runs with the origin at (0,0) */
+        std::unordered_map<GLuint, std::shared_ptr<GlyphRun>> runs;
+        /** The bounds of the glyph quads, before padding is applied */
+        Rect extent;
+        /** The number of glyphs successfully processed */
+        size_t total;
+    };
+    
 #pragma mark -
 #pragma mark Font Class
     /** The name of this font (typically the family name if known) */
@@ -446,10 +522,20 @@ protected:
     Hinting _hints;
     
     // Altas support
-    /** The cached metrics for each font glyph. This does not include padding. */
-    std::unordered_map<Uint32, Metrics> _glyphsize;
-    /** The kerning for each pair of characters */
-    std::unordered_map<Uint32, std::unordered_map<Uint32, Uint32> > _kernmap;
+    /** The cached metrics for each font glyph, in order gathered. This does not include padding. */
+    std::vector<Metrics> _glyphsize;
+    /** The character for each entry of the glyph metrics */
+    std::vector<Uint32> _glyphcode;
+    /** The position (plus one) of each BMP character in the glyph metrics, in pages of 256 (0 if absent) */
+    std::vector<std::vector<Uint32>> _glyphpages;
+    /** The position of each character outside of the BMP in the glyph metrics */
+    std::unordered_map<Uint32, Uint32> _glyphextra;
+    /** The number of glyph metrics (from the start) with kerning information */
+    size_t _kerncount;
+    /** The kerning for each pair of ASCII characters, indexed directly */
+    std::vector<Sint16> _kernascii;
+    /** The nonzero kerning for all other pairs of characters, sorted by pair */
+    std::vector<std::pair<Uint64, int>> _kernpairs;
     /** The individual atlases for this font */
     std::vector<std::shared_ptr<Atlas>> _atlases;
     /** The number of pixels to pad around each edge of a glyph.  Necessary to support font blurs. */
@@ -464,6 +550,20 @@ protected:
     int _shrinkLimit;
     /** The maximum number of pixels to grow the advance when stretching a line */
     int _stretchLimit;
+    /** Whether to add missing glyphs to a dynamic atlas */
+    bool _dynamic;
+    /** The dynamic atlas currently accepting new glyphs */
+    std::shared_ptr<Atlas> _dynamicAtlas;
+    /** The position of the current dynamic atlas in the atlas collection */
+    size_t _dynamicIndex;
+    
+    // GlyphRun caching
+    /** The maximum number of lines in the glyph run cache (0 to disable) */
+    Uint32 _cacheLimit;
+    /** The cached glyph runs, from most to least recently used */
+    std::list<CachedRun> _runcache;
+    /** The position of each cache key in the glyph run cache */
+    std::unordered_map<std::string, std::list<CachedRun>::iterator> _runindex;
     
     
 public:
@@ -808,9 +908,11 @@ public:
      * methods are no longer safe to be used outside of the main thread
      * (this is not an issue if this attribute is false).
      *
+     * Reseting this value will clear the glyph run cache.
+     *
      * @param fallback  Whether to generate a fallback atlas for glyph runs.
      */
-    void setAtlasFallback(bool fallback) { _fallback = fallback; }
+    void setAtlasFallback(bool fallback);
     
     /**
      * Returns true if this font generates a fallback atlas for glyph runs.
@@ -832,6 +934,119 @@ public:
      */
     bool hasAtlasFallback() const { return _fallback; }
     
+    /**
+     * Sets whether to add missing glyphs to a dynamic atlas.
+     *
+     * By default, the atlas collection is fixed once it is built, and any
+     * glyph missing from it is either omitted or rendered with a one-time
+     * fallback atlas (see {@link #setAtlasFallback}). If this value is true,
+     * the glyph run methods like {@link #getGlyphs} will instead add any
+     * missing glyphs to a dynamic atlas the first time that they are used.
+     * These glyphs are then part of the atlas collection, so each glyph is
+     * only rendered once. This is ideal for text that changes often, like
+     * counters and timers, as it does not require the characters to be
+     * known ahead of time.
+     *
+     * A dynamic atlas is a fixed size texture, and glyphs are packed into
+     * it on horizontal shelves. When it is full, a new one is started. As
+     * new glyphs are copied directly to the texture, the glyph generation
+     * methods are no longer safe to be used outside of the main thread if
+     * this value is true. This value takes precedence over the fallback
+     * atlas when both are set.
+     *
+     * Reseting this value will clear the glyph run cache.
+     *
+     * @param dynamic   Whether to add missing glyphs to a dynamic atlas.
+     */
+    void setAtlasDynamic(bool dynamic);
+    
+    /**
+     * Returns true if this font adds missing glyphs to a dynamic atlas.
+     *
+     * By default, the atlas collection is fixed once it is built, and any
+     * glyph missing from it is either omitted or rendered with a one-time
+     * fallback atlas (see {@link #setAtlasFallback}). If this value is true,
+     * the glyph run methods like {@link #getGlyphs} will instead add any
+     * missing glyphs to a dynamic atlas the first time that they are used.
+     * These glyphs are then part of the atlas collection, so each glyph is
+     * only rendered once. This is ideal for text that changes often, like
+     * counters and timers, as it does not require the characters to be
+     * known ahead of time.
+     *
+     * A dynamic atlas is a fixed size texture, and glyphs are packed into
+     * it on horizontal shelves. When it is full, a new one is started. As
+     * new glyphs are copied directly to the texture, the glyph generation
+     * methods are no longer safe to be used outside of the main thread if
+     * this value is true. This value takes precedence over the fallback
+     * atlas when both are set.
+     *
+     * @return true if this font adds missing glyphs to a dynamic atlas.
+     */
+    bool hasAtlasDynamic() const { return _dynamic; }
+    
+    /**
+     * Sets the maximum number of lines in the glyph run cache.
+     *
+     * The glyph run cache stores the glyph runs for recently rendered lines
+     * of text, keyed by the text and the tracking width. When the same line
+     * is rendered again, such as when a {@link TextLayout} is regenerated
+     * for a label whose text has not changed (or has changed back), the
+     * glyph runs are copied from the cache and moved to the new origin. Once
+     * the cache is full, the least recently used line is discarded.
+     *
+     * A cached line is only used when it fits in the bounding box. Lines
+     * that must be clipped are generated as normal. Because every glyph
+     * run method updates the cache, a font with a cache is not safe to use
+     * outside of the main thread. Hence the cache is disabled by default
+     * (this value is 0).
+     *
+     * @param limit The maximum number of lines in the glyph run cache
+     */
+    void setRunCacheLimit(Uint32 limit);
+    
+    /**
+     * Returns the maximum number of lines in the glyph run cache.
+     *
+     * The glyph run cache stores the glyph runs for recently rendered lines
+     * of text, keyed by the text and the tracking width. When the same line
+     * is rendered again, such as when a {@link TextLayout} is regenerated
+     * for a label whose text has not changed (or has changed back), the
+     * glyph runs are copied from the cache and moved to the new origin. Once
+     * the cache is full, the least recently used line is discarded.
+     *
+     * A cached line is only used when it fits in the bounding box. Lines
+     * that must be clipped are generated as normal. Because every glyph
+     * run method updates the cache, a font with a cache is not safe to use
+     * outside of the main thread. Hence the cache is disabled by default
+     * (this value is 0).
+     *
+     * @return the maximum number of lines in the glyph run cache
+     */
+    Uint32 getRunCacheLimit() const { return _cacheLimit; }
+    
+    /**
+     * Returns the number of lines in the glyph run cache.
+     *
+     * This value is never more than {@link #getRunCacheLimit}.
+     *
+     * @return the number of lines in the glyph run cache.
+     */
+    size_t getRunCacheSize() const { return _runcache.size(); }
+    
+    /**
+     * Returns true if the glyph runs for the given line are cached.
+     *
+     * The line is identified by its text and tracking width, as in
+     * {@link #getGlyphs}. This method does not count as a use of the line,
+     * so it does not change which line will be discarded next.
+     *
+     * @param text  The line of text
+     * @param track The tracking width (if positive)
+     *
+     * @return true if the glyph runs for the given line are cached.
+     */
+    bool hasCachedRun(const std::string text, float track=0) const;
+    
     /**
      * Sets the limit for shrinking the advance during tracking
      *
@@ -843,9 +1058,11 @@ public:
      *
      * By default this value is 0, disabling all (negative) tracking.
      *
+     * Reseting this value will clear the glyph run cache.
+     *
      * @param limit     The limit for shrinking the advance during tracking
      */
-    void setShrinkLimit(Uint32 limit) { _shrinkLimit = limit; }
+    void setShrinkLimit(Uint32 limit);
     
     /**
      * Returns the limit for shrinking the advance during tracking
@@ -875,9 +1092,11 @@ public:
      * equivalent to old-school justification, which stretches a line
      * by only resizing whitespace.
      *
+     * Reseting this value will clear the glyph run cache.
+     *
      * @param limit     The limit for stretching the advance during tracking
      */
-    void setStretchLimit(Uint32 limit) { _stretchLimit = limit; }
+    void setStretchLimit(Uint32 limit);
     
     /**
      * Returns the limit for stretching the advance during tracking
@@ -923,7 +1142,8 @@ public:
      *
      * This value is the amount of overlap (in pixels) between any two adjacent
      * character glyphs rendered by this font.  If the value is 0, there is no
-     * kerning for this pair.
+     * kerning for this pair.  A negative value means the glyphs are spaced
+     * further apart than their advance.
      *
      * The Unicode representation uses the endianness native to the platform.
      * Therefore, this value should not be serialized.  Use UTF8 to represent
@@ -936,7 +1156,7 @@ public:
      *
      * @return the kerning adjustment between the two (Unicode) characters.
      */
-    unsigned int getKerning(Uint32 a, Uint32 b) const;
+    int getKerning(Uint32 a, Uint32 b) const;
     
     /**
      * Returns the size (in pixels) necessary to render this string.
@@ -1140,6 +1360,15 @@ public:
      */
     void clearAtlases();
     
+    /**
+     * Deletes all of the lines in the glyph run cache.
+     *
+     * The cache is cleared automatically whenever the atlas collection
+     * or the tracking limits change. Hence this method is only necessary
+     * to reclaim memory.
+     */
+    void clearRunCache();
+    
     /**
      * Creates an atlas collection for the ASCII characters in this font.
      *
@@ -2240,15 +2469,51 @@ private:
     std::deque<Uint32> gatherGlyphs(const std::vector<Uint32>& charset);
     
     /**
-     * Gathers the kerning information for given characters.
+     * Gathers the kerning information for all new characters.
+     *
+     * The new characters are those gathered since the last call to this
+     * method. They will not only be kerned against each other, but they will
+     * also be kerned against any existing characters.
+     */
+    void gatherKerning();
+
+    /**
+     * Returns the position of the character in the glyph metrics
      *
-     * These characters will not only be kerned against each other, but
-     * they will also be kerned against any existing characters.
+     * This method returns -1 if the glyph metrics for this character have
+     * not been gathered.
      *
-     * @param glyphs    The glyphs to acquire kerning data for
+     * @param thechar   The Unicode character to find
+     *
+     * @return the position of the character in the glyph metrics
      */
-    void gatherKerning(const std::deque<Uint32>& glyphs);
-    
+    Sint32 findGlyph(Uint32 thechar) const;
+
+    /**
+     * Adds the glyph metrics for the given character
+     *
+     * This method does nothing if the metrics for this character have
+     * already been gathered.
+     *
+     * @param thechar   The Unicode character to add
+     * @param metrics   The glyph metrics of the character
+     */
+    void addGlyph(Uint32 thechar, const Metrics& metrics);
+
+    /**
+     * Returns the kerning between two gathered characters.
+     *
+     * The characters are specified by their position in the glyph metrics.
+     * This method returns 0 if either character does not have kerning
+     * information yet.
+     *
+     * @param a     The position of the first character in the pair
+     * @param b     The position of the second character in the pair
+     *
+     * @return the kerning between two gathered characters.
+     */
+    int findKerning(Sint32 a, Sint32 b) const;
+
     /**
      * Returns the metrics for the given character if available.
      *
@@ -2295,6 +2560,43 @@ private:
                            std::vector<std::shared_ptr<Atlas>>& atlases,
                            std::unordered_map<Uint32, size_t>& map);
     
+    /**
+     * Adds any glyphs in the given string missing from the atlases.
+     *
+     * The missing glyphs are added to the current dynamic atlas, and a new
+     * dynamic atlas is started when that one is full. Unlike local atlases,
+     * these glyphs become part of the atlas collection. Characters that are
+     * not supported by the font are ignored.
+     *
+     * WARNING: This method is not thread safe. It modifies an OpenGL texture,
+     * which means that it may only be called in the main thread.
+     *
+     * @param substr    The start of the string to check
+     * @param end       The end of the string to check
+     *
+     * @return true if all supported glyphs were successfully added.
+     */
+    bool buildDynamicGlyphs(const char* substr, const char* end);
+    
+    /**
+     * Stores the glyph runs to render the given string in the given map
+     *
+     * This method is the uncached implementation of {@link #getGlyphs}. The
+     * bounds must already include the atlas padding.
+     *
+     * @param runs      The map to store the glyph runs
+     * @param substr    The start of the string for glyph generation
+     * @param end       The end of the string for glyph generation
+     * @param origin    The position of the first character
+     * @param bounds    The bounding box for the quads (with padding)
+     * @param track     The tracking width (if positive)
+     *
+     * @return the number of glyphs successfully processed
+     */
+    size_t generateGlyphs(std::unordered_map<GLuint, std::shared_ptr<GlyphRun>>& runs,
+                          const char* substr, const char* end, const Vec2 origin,
+                          const Rect bounds, float track);
+    
     /**
      * Creates a quad outline of this character and stores it in mesh
      *
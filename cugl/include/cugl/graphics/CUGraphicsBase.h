@@ -73,6 +73,25 @@
     #define CU_GL_PLATFORM   CU_GL_OPENGL
 #endif
 
+/**
+ * Asserts that there are no outstanding OpenGL errors.
+ *
+ * The call to glGetError forces the driver to synchronize with the GPU. So
+ * this check is only performed when CUAssertLog is active (assert levels 2
+ * and 3). At the release settings it compiles away entirely.
+ *
+ * @param label The prefix of the assert message
+ */
+#if SDL_ASSERT_LEVEL >= 2
+    #define CU_GL_CHECK(label) do { \
+        GLenum __cu_gl_error__ = glGetError(); \
+        CUAssertLog(__cu_gl_error__ == GL_NO_ERROR, "%s: %s", label, \
+                    cugl::graphics::gl_error_name(__cu_gl_error__).c_str()); \
+    } while (0)
+#else
+    #define CU_GL_CHECK(label) do { } while (0)
+#endif
+
 namespace cugl {
 
 // Forward declaration
@@ -1896,6 +1896,41 @@ public:
      */
     void drawMesh(const SpriteVertex* vertices, size_t size, const Affine2& transform, bool tint = true);
     
+#pragma mark -
+#pragma mark Batched Sprites
+    /**
+     * Draws many sprites from the same texture in a single call.
+     *
+     * This method is a bulk version of the convenience draw methods. Sprite
+     * ii is the texture region regions[ii], anchored at its center. It is
+     * scaled by scales[ii], rotated by angles[ii] (radians, counter clockwise)
+     * and then placed with its center at positions[ii]. The texture regions
+     * are specified in texture pixel coordinates (e.g from the bottom left
+     * corner), which makes this method ideal for sprite sheets.
+     *
+     * Only the positions array is required. If regions is nullptr, each
+     * sprite is the entire texture. If scales is nullptr, the sprites are not
+     * scaled. If angles is nullptr, the sprites are not rotated. If colors is
+     * nullptr, each sprite is tinted with the active color. Otherwise the
+     * colors replace the active color (which is not changed).
+     *
+     * This method sets the active texture, but it writes the vertices
+     * directly to the sprite batch mesh, bypassing the per-shape overhead
+     * of the fill methods. The vertex positions are computed four corners
+     * at a time when the math library has vector support.
+     *
+     * @param texture   The new active texture
+     * @param regions   The texture region for each sprite (may be nullptr)
+     * @param positions The center of each sprite in world coordinates
+     * @param scales    The scale of each sprite (may be nullptr)
+     * @param angles    The rotation of each sprite (may be nullptr)
+     * @param colors    The color of each sprite (may be nullptr)
+     * @param size      The number of sprites
+     */
+    void drawSprites(const std::shared_ptr<Texture>& texture, const Rect* regions,
+                     const Vec2* positions, const Vec2* scales, const float* angles,
+                     const Color4* colors, size_t size);
+    
 #pragma mark -
 #pragma mark Text Drawing
     /**
@@ -2189,6 +2224,19 @@ private:
      */
     unsigned int chunkify(const SpriteVertex* vertices, size_t size, const Affine2& mat, bool tint = true);
     
+    /**
+     * Tints the given vertices by the active color.
+     *
+     * The vertex colors are multiplied by the active color and rounded to
+     * the nearest byte. The colors are gathered into blocks so that they
+     * can be tinted with {@link Color4#multiply}, which is vectorized when
+     * the math library has vector support.
+     *
+     * @param vertices  The vertices to tint
+     * @param size      The number of vertices to tint
+     */
+    void tintVertices(SpriteVertex* vertices, size_t size);
+    
 };
 
     }
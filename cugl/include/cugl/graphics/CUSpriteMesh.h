@@ -268,7 +268,7 @@ public:
      *
      * @return the mesh associated with sprite mesh.
      */
-    const Mesh<SpriteVertex> getMesh() const { return _mesh; }
+    const Mesh<SpriteVertex>& getMesh() const { return _mesh; }
     
     /**
      * Sets the mesh associated with sprite mesh.
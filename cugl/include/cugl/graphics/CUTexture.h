@@ -430,6 +430,30 @@ public:
      */
     const Texture& set(const void *data);
     
+    /**
+     * Sets a rectangular region of this texture to the contents of the buffer.
+     *
+     * The buffer must have the correct data format. In addition, the buffer
+     * must be size width*height*bytesize, where width and height are the
+     * size of the region. The rest of the texture is unchanged. The region
+     * is in pixel coordinates, with the origin at the first row of the
+     * texture data. This method does not regenerate any mipmaps.
+     *
+     * A region with a negative size, or that does not fit in the texture,
+     * is ignored.
+     *
+     * This method is only successful if the texture is currently active.
+     *
+     * @param data      The buffer to read into the texture
+     * @param x         The left edge of the region
+     * @param y         The first row of the region
+     * @param width     The width of the region
+     * @param height    The height of the region
+     *
+     * @return a reference to this (modified) texture for chaining.
+     */
+    const Texture& set(const void *data, int x, int y, int width, int height);
+    
     
 #pragma mark -
 #pragma mark Attributes
@@ -13,6 +13,12 @@
 //  it does not support instancing. For that you will need to use the
 //  InstanceBuffer class, or design your own VertexBuffer abstraction.
 //
+//  A vertex buffer can optionally stream its data. In that mode the buffers
+//  are allocated once as a ring of blocks. Each load is written directly into
+//  mapped buffer memory, and blocks are guarded by fences so that the CPU never
+//  overwrites data the GPU is still reading. This avoids respecifying the
+//  buffer on every load, which is ideal for a SpriteBatch.
+//
 //  This class uses our standard shared-pointer architecture.
 //
 //  1. The constructor does not perform any initialization; it just sets all
@@ -55,6 +61,10 @@
 #include <cugl/core/math/CUMathBase.h>
 #include <cugl/core/math/CUMat4.h>
 
+/** The number of blocks in a streaming vertex buffer ring */
+#define CU_VERTEX_STREAM_BLOCKS 3
+/** The number of nanoseconds to wait on a fence before flushing again */
+#define CU_VERTEX_STREAM_TIMEOUT 1000000
 
 namespace cugl {
 
@@ -113,6 +123,36 @@ public:
         GLsizeiptr offset;
     };
     
+    /**
+     * A data type for managing a streaming buffer.
+     *
+     * A streaming buffer is allocated once as a fixed number of blocks, each
+     * of which can hold the full capacity of the vertex buffer. Data is
+     * appended to the active block until it no longer fits. At that point a
+     * fence is placed after the draw calls of that block, and the ring moves
+     * on to the next block (waiting on its fence if necessary).
+     */
+    class StreamRing {
+    public:
+        /** The fences guarding each block of the ring */
+        GLsync fences[CU_VERTEX_STREAM_BLOCKS];
+        /** The block currently receiving data */
+        GLuint block;
+        /** The next free byte in the current block */
+        GLsizeiptr head;
+        /** Whether the storage for this ring has been allocated */
+        bool allocated;
+        
+        /**
+         * Creates an unallocated stream ring
+         */
+        StreamRing() : block(0), head(0), allocated(false) {
+            for(int ii = 0; ii < CU_VERTEX_STREAM_BLOCKS; ii++) {
+                fences[ii] = 0;
+            }
+        }
+    };
+    
 protected:
     /** The max size (both vertices and indices of this buffer */
     GLsizei _size;
@@ -133,6 +173,19 @@ protected:
     std::unordered_map<std::string, bool> _enabled;
     /** The settings for each attribute */
     std::unordered_map<std::string, AttribData> _attributes;
+    /** The attribute locations in the attached shader */
+    std::unordered_map<std::string, GLint> _locations;
+    
+    /** Whether this buffer streams its data through a ring of blocks */
+    bool _streaming;
+    /** The ring for the vertex data (streaming only) */
+    StreamRing _vertRing;
+    /** The ring for the index data (streaming only) */
+    StreamRing _indxRing;
+    /** The byte offset of the active vertex data in the vertex buffer */
+    GLsizeiptr _vertBase;
+    /** The element offset of the active index data in the index buffer */
+    GLsizei _indxBase;
     
 public:
 #pragma mark Constructors
@@ -292,6 +345,39 @@ public:
      */
     GLsizei getStride() const { return _stride; }
     
+    /**
+     * Returns true if this vertex buffer streams its data.
+     *
+     * A streaming buffer is allocated once, as a ring of blocks each with
+     * the full capacity of this buffer. Each call to {@link #loadVertexData}
+     * or {@link #loadIndexData} writes the data directly into mapped memory
+     * at the next free position of the ring, rather than respecifying the
+     * buffer. Fences ensure that no data is overwritten while the GPU is
+     * still reading it.
+     *
+     * @return true if this vertex buffer streams its data.
+     */
+    bool isStreaming() const { return _streaming; }
+    
+    /**
+     * Sets whether this vertex buffer streams its data.
+     *
+     * A streaming buffer is allocated once, as a ring of blocks each with
+     * the full capacity of this buffer. Each call to {@link #loadVertexData}
+     * or {@link #loadIndexData} writes the data directly into mapped memory
+     * at the next free position of the ring, rather than respecifying the
+     * buffer. Fences ensure that no data is overwritten while the GPU is
+     * still reading it.
+     *
+     * Streaming is ideal for buffers that are reloaded several times a frame,
+     * like the one in {@link SpriteBatch}. It requires a nonzero stride. Any
+     * data previously loaded is invalidated by this method, and must be
+     * loaded again.
+     *
+     * @param value Whether this vertex buffer streams its data.
+     */
+    void setStreaming(bool value);
+    
     /**
      * Loads the given vertex buffer with data.
      *
@@ -311,6 +397,9 @@ public:
      * can amortize the uniform changes. For quads and other simple meshes,
      * you should always choose GL_STREAM_DRAW.
      *
+     * If this buffer is streaming, the usage is ignored. The data is written
+     * to the next free position of the ring instead.
+     *
      * This method will only succeed if this buffer is actively bound.
      *
      * @param data  The data to load
@@ -339,6 +428,9 @@ public:
      * you should always choose GL_STREAM_DRAW and push as much computation to the
      * CPU as possible.
      *
+     * If this buffer is streaming, the usage is ignored. The indices are
+     * written to the next free position of the ring instead.
+     *
      * This method will only succeed if this buffer is actively bound.
      *
      * @param data  The indices to load
@@ -458,6 +550,45 @@ public:
     void disableAttribute(const std::string name);
     
     
+#pragma mark -
+#pragma mark Streaming Helpers
+protected:
+    /**
+     * Writes the given data to the next free position of the stream ring.
+     *
+     * The ring storage is allocated on first use. If the data does not fit
+     * in the current block, this method fences that block and moves on to
+     * the next one, waiting on its fence if the GPU is still using it. The
+     * data is then copied into mapped buffer memory (falling back to
+     * glBufferSubData if the buffer cannot be mapped).
+     *
+     * The buffer for the target must be bound.
+     *
+     * @param target    The buffer target (array or element array)
+     * @param ring      The ring for this buffer
+     * @param data      The data to write
+     * @param bytes     The number of bytes to write
+     * @param capacity  The size of a single ring block in bytes
+     *
+     * @return the byte offset of the data in the buffer
+     */
+    GLsizeiptr streamData(GLenum target, StreamRing& ring, const void* data,
+                          GLsizeiptr bytes, GLsizeiptr capacity);
+    
+    /**
+     * Releases all fences in the given ring, marking it unallocated.
+     *
+     * @param ring  The ring to release
+     */
+    void releaseRing(StreamRing& ring);
+    
+    /**
+     * Repoints the enabled attributes at the active vertex data
+     *
+     * This method is necessary whenever the vertex data moves within the
+     * buffer (e.g. in a streaming buffer). The vertex buffer must be bound.
+     */
+    void rebaseAttributes();
 };
 
     }
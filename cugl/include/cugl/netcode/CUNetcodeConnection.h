@@ -314,64 +314,70 @@ public:
     typedef std::function<void(const std::string source, const std::vector<std::byte>& message)> Dispatcher;
 
 private:
+    /**
+     * An interned message source
+     *
+     * Every message stores its source. Rather than copying the UUID of the
+     * source into each message, we intern each source once, and messages
+     * refer to the interned string. Sources are kept in a linked list that
+     * can be searched and extended without locking. They are never removed
+     * until the connection is deleted, so a reference remains valid while
+     * any message refers to it.
+     */
+    class Source {
+    public:
+        /** The source UUID */
+        std::string uuid;
+        /** The next interned source */
+        Source* next;
+
+        /**
+         * Creates an interned source for the given UUID
+         *
+         * @param id    The source UUID
+         */
+        Source(const std::string& id) : uuid(id), next(nullptr) {}
+    };
+
     /**
      * A message envelope, storing the message and its receipt
      *
      * As messages come from many different peers, it is helpful to know the
      * sender of each. This information is stored with the message in the ring
-     * buffer
+     * buffer.
+     *
+     * Envelopes are never deallocated while the connection is in use. When
+     * a message is consumed, its byte vector is swapped (not copied) with
+     * an envelope that has already been processed. Hence the byte vectors
+     * form a pool whose capacity is reused by later messages.
      */
     class Envelope {
     public:
         /** The message source */
-        std::string source;
+        const Source* source;
         /** The message (as a byte vector) */
         std::vector<std::byte> message;
 
         /** Creates an empty message envelope */
-        Envelope() {}
-
-        /**
-         * Creates a copy of the given message envelope
-         *
-         * @param env the message envelope to copy
-         */
-        Envelope(const Envelope& env) {
-            source  = env.source;
-            message = env.message;
-        }
-
-        /**
-         * Creates a message envelope with the resources of the original
-         *
-         * @param env the message envelope to acquire
-         */
-        Envelope(Envelope&& env) {
-            source  = std::move(env.source);
-            message = std::move(env.message);
-         }
+        Envelope() : source(nullptr) {}
+    };
 
-        /**
-         * Copies the given message envelope
-         *
-         * @param env the message envelope to copy
-         */
-        Envelope& operator=(const Envelope& env) {
-            source  = env.source;
-            message = env.message;
-            return *this;
-        }
+    /**
+     * A slot in the data ring buffer
+     *
+     * The sequence number is used to coordinate the threads that access the
+     * slot. A slot at position pos is ready to be written if its sequence
+     * is pos, and ready to be read if its sequence is pos+1.
+     */
+    class Slot {
+    public:
+        /** The sequence number of this slot */
+        std::atomic<size_t> sequence;
+        /** The message stored in this slot */
+        Envelope envelope;
 
-        /**
-         * Acquires the resources of the given message envelope
-         *
-         * @param env the message envelope to acquire
-         */
-        Envelope& operator=(Envelope&& env) {
-            source  = std::move(env.source);
-            message = std::move(env.message);
-            return *this;
-        }
+        /** Creates an empty ring buffer slot */
+        Slot() : sequence(0) {}
     };
 
     /** The configuration of this connection */
@@ -425,18 +431,28 @@ private:
      * But this means it is possible to receive multiple network messages
      * before a read. This buffer stores this messages.
      *
-     * This is a classic ring buffer. It it fills up (because the application
-     * is too slow to read), then the oldest messages are deleted first.
+     * This is a bounded ring buffer that requires no locks. Messages may be
+     * appended by any number of threads (one for each data channel) while
+     * the buffer is read. If it fills up (because the application is too
+     * slow to read), then the oldest messages are deleted first.
      */
-    std::vector<Envelope> _buffer;
-    /** The number of messages in the data ring buffer */
-    std::atomic<size_t> _buffsize;
+    std::unique_ptr<Slot[]> _buffer;
     /** The capacity of the data ring buffer */
     size_t _bufflimit;
-    /** The head of the data ring buffer */
-    size_t _buffhead;
-    /** The tail of the data ring buffer */
-    size_t _bufftail;
+    /** The head (next position to read) of the data ring buffer */
+    std::atomic<size_t> _buffhead;
+    /** The tail (next position to write) of the data ring buffer */
+    std::atomic<size_t> _bufftail;
+    /** The number of threads currently accessing the data ring buffer */
+    std::atomic<size_t> _buffusers;
+    /** Whether the data ring buffer is being resized */
+    std::atomic<bool> _buffresize;
+    /** The envelopes drained from the data ring buffer (for reuse) */
+    std::vector<Envelope> _drain;
+    /** The interned message sources */
+    std::atomic<Source*> _sources;
+    /** Whether messages are dispatched immediately with {@link #onReceipt} */
+    std::atomic<bool> _immediate;
 
     // To prevent race conditions
     /** Whether this websocket connection prints out debugging information */
@@ -622,17 +638,62 @@ private:
      */
     void handleSignal(const std::shared_ptr<JsonValue>&  json);
 
+    /**
+     * Returns the interned source for the given UUID.
+     *
+     * If the UUID has not been interned, this method interns it. This
+     * method does not require a lock.
+     *
+     * @param uuid  The source UUID
+     *
+     * @return the interned source for the given UUID.
+     */
+    const Source* intern(const std::string& uuid);
+
+    /**
+     * Acquires access to the data ring buffer.
+     *
+     * Access prevents the buffer from being resized by {@link #setCapacity}.
+     * It must be released with {@link #releaseBuffer}. This method only
+     * blocks if the buffer is being resized.
+     */
+    void acquireBuffer();
+
+    /**
+     * Releases access to the data ring buffer.
+     *
+     * This method must be paired with {@link #acquireBuffer}.
+     */
+    void releaseBuffer() {
+        _buffusers.fetch_sub(1, std::memory_order_release);
+    }
+
+    /**
+     * Removes the oldest message from the ring buffer.
+     *
+     * If successful, the message is swapped into the given envelope. This
+     * method does not require a lock, but the caller must have acquired
+     * access with {@link #acquireBuffer}.
+     *
+     * @param envelope  The envelope to store the message
+     *
+     * @return true if a message was removed.
+     */
+    bool pop(Envelope& envelope);
+
     /**
      * Appends the given data to the ring buffer.
      *
      * This method is used to store an incoming message for later consumption.
+     * It does not require a lock, and may be called by several threads at
+     * once. If the buffer is full, the oldest message is dropped.
      *
      * @param source    The message source
      * @param data      The message data
      *
      * @return if the message was successfully added to the buffer.
      */
-    bool append(const std::string source, const std::vector<std::byte>& data);
+    bool append(const std::string& source, const std::vector<std::byte>& data);
 
     /** Allow access to the other netcode classes */
     friend class NetcodeManager;
@@ -765,8 +826,6 @@ public:
      * Note that this is NOT the same as the capacity of a single message. That
      * value was set as part of the initial {@link NetcodeConfig}.
      *
-     * This method is not const because it requires a lock.
-     *
      * @return the message buffer capacity.
      */
     size_t getCapacity();
@@ -782,6 +841,10 @@ public:
      * Note that this is NOT the same as the capacity of a single message. That
      * value was set as part of the initial {@link NetcodeConfig}.
      *
+     * Resizing an open connection briefly blocks any threads appending to
+     * the buffer. If the new capacity is smaller than the number of messages
+     * in the buffer, the oldest messages are dropped.
+     *
      * @param capacity  The new message buffer capacity.
      */
     void setCapacity(size_t capacity);
@@ -48,7 +48,9 @@
 #include <cugl/core/CUBase.h>
 #include <variant>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <span>
 #include <cstdint>
 #include <cstddef>
 
@@ -131,6 +133,13 @@ enum NetcodeType : std::uint8_t {
  * The class {@link NetcodeConnection} is only capable of transmitting byte arrays.
  * You should use this class to construct a byte array for a single message so that
  * you can transmit it.
+ *
+ * Every value is written with a single bulk copy into a contiguous buffer, so
+ * the cost of serialization is proportional to the number of values, not the
+ * number of bytes. This buffer is retained by {@link #reset}, so a serializer
+ * that is reused for each message will stop allocating memory once it has
+ * grown to the size of the largest message. Use {@link #reserve} to presize
+ * the buffer when the size of a message is known in advance.
  * 
  * This class is capable of serializing the following data types:
  *  - Floats
@@ -172,6 +181,24 @@ public:
         return std::make_shared<NetcodeSerializer>();
     }
     
+    /**
+     * Reserves space for the given number of bytes.
+     *
+     * This method guarantees that no allocation will take place until the
+     * serialized data exceeds the given number of bytes. It does not change
+     * the data written so far.
+     *
+     * @param bytes The number of bytes to reserve
+     */
+    void reserve(size_t bytes) { _data.reserve(bytes); }
+    
+    /**
+     * Returns the number of bytes written so far.
+     *
+     * @return the number of bytes written so far.
+     */
+    size_t size() const { return _data.size(); }
+    
     /**
      * Writes a single boolean value.
      *
@@ -258,7 +285,7 @@ public:
      *
      * @param s The value to write
      */
-    void writeString(std::string s);
+    void writeString(std::string_view s);
 
     /**
      * Writes a single string value.
@@ -272,7 +299,7 @@ public:
      *
      * @param s The value to write
      */
-    void writeChars(char* s);
+    void writeChars(const char* s);
 
     /**
      * Writes a single {@link JsonValue}.
@@ -294,7 +321,7 @@ public:
      *
      * @param v The vector to write
      */
-    void writeBoolVector(std::vector<bool> v);
+    void writeBoolVector(const std::vector<bool>& v);
 
     /**
      * Writes a vector of float values.
@@ -305,7 +332,23 @@ public:
      *
      * @param v The vector to write
      */
-    void writeFloatVector(std::vector<float> v);
+    void writeFloatVector(const std::vector<float>& v) {
+        writeFloatVector(std::span<const float>(v));
+    }
+
+    /**
+     * Writes a vector of float values.
+     *
+     * Values will be deserialized on other machines in the same order they were
+     * written in. You should pass the result of {@link #serialize} to the
+     * {@link NetcodeConnection} to send all values buffered up to this point.
+     *
+     * The values may come from any contiguous storage, such as an array. They
+     * will be deserialized as a vector.
+     *
+     * @param v The values to write
+     */
+    void writeFloatVector(std::span<const float> v);
 
     /**
      * Writes a vector of double values.
@@ -316,7 +359,23 @@ public:
      *
      * @param v The vector to write
      */
-    void writeDoubleVector(std::vector<double> v);
+    void writeDoubleVector(const std::vector<double>& v) {
+        writeDoubleVector(std::span<const double>(v));
+    }
+
+    /**
+     * Writes a vector of double values.
+     *
+     * Values will be deserialized on other machines in the same order they were
+     * written in. You should pass the result of {@link #serialize} to the
+     * {@link NetcodeConnection} to send all values buffered up to this point.
+     *
+     * The values may come from any contiguous storage, such as an array. They
+     * will be deserialized as a vector.
+     *
+     * @param v The values to write
+     */
+    void writeDoubleVector(std::span<const double> v);
 
     /**
      * Writes a vector of unsigned (32 bit) int values.
@@ -327,7 +386,23 @@ public:
      *
      * @param v The vector to write
      */
-    void writeUint32Vector(std::vector<Uint32> v);
+    void writeUint32Vector(const std::vector<Uint32>& v) {
+        writeUint32Vector(std::span<const Uint32>(v));
+    }
+
+    /**
+     * Writes a vector of unsigned (32 bit) int values.
+     *
+     * Values will be deserialized on other machines in the same order they were
+     * written in. You should pass the result of {@link #serialize} to the
+     * {@link NetcodeConnection} to send all values buffered up to this point.
+     *
+     * The values may come from any contiguous storage, such as an array. They
+     * will be deserialized as a vector.
+     *
+     * @param v The values to write
+     */
+    void writeUint32Vector(std::span<const Uint32> v);
 
     /**
      * Writes a vector of unsigned (64 bit) int values.
@@ -338,7 +413,23 @@ public:
      *
      * @param v The vector to write
      */
-    void writeUint64Vector(std::vector<Uint64> v);
+    void writeUint64Vector(const std::vector<Uint64>& v) {
+        writeUint64Vector(std::span<const Uint64>(v));
+    }
+
+    /**
+     * Writes a vector of unsigned (64 bit) int values.
+     *
+     * Values will be deserialized on other machines in the same order they were
+     * written in. You should pass the result of {@link #serialize} to the
+     * {@link NetcodeConnection} to send all values buffered up to this point.
+     *
+     * The values may come from any contiguous storage, such as an array. They
+     * will be deserialized as a vector.
+     *
+     * @param v The values to write
+     */
+    void writeUint64Vector(std::span<const Uint64> v);
 
     /**
      * Writes a vector of signed (32 bit) int values.
@@ -349,7 +440,23 @@ public:
      *
      * @param v The vector to write
      */
-    void writeSint32Vector(std::vector<Sint32> v);
+    void writeSint32Vector(const std::vector<Sint32>& v) {
+        writeSint32Vector(std::span<const Sint32>(v));
+    }
+
+    /**
+     * Writes a vector of signed (32 bit) int values.
+     *
+     * Values will be deserialized on other machines in the same order they were
+     * written in. You should pass the result of {@link #serialize} to the
+     * {@link NetcodeConnection} to send all values buffered up to this point.
+     *
+     * The values may come from any contiguous storage, such as an array. They
+     * will be deserialized as a vector.
+     *
+     * @param v The values to write
+     */
+    void writeSint32Vector(std::span<const Sint32> v);
 
     /**
      * Writes a vector of signed (64 bit) int values.
@@ -360,7 +467,23 @@ public:
      *
      * @param v The vector to write
      */
-    void writeSint64Vector(std::vector<Sint64> v);
+    void writeSint64Vector(const std::vector<Sint64>& v) {
+        writeSint64Vector(std::span<const Sint64>(v));
+    }
+
+    /**
+     * Writes a vector of signed (64 bit) int values.
+     *
+     * Values will be deserialized on other machines in the same order they were
+     * written in. You should pass the result of {@link #serialize} to the
+     * {@link NetcodeConnection} to send all values buffered up to this point.
+     *
+     * The values may come from any contiguous storage, such as an array. They
+     * will be deserialized as a vector.
+     *
+     * @param v The values to write
+     */
+    void writeSint64Vector(std::span<const Sint64> v);
     
     /**
      * Writes a vector of string values.
@@ -371,7 +494,23 @@ public:
      *
      * @param v The vector to write
      */
-    void writeStringVector(std::vector<std::string> v);
+    void writeStringVector(const std::vector<std::string>& v) {
+        writeStringVector(std::span<const std::string>(v));
+    }
+
+    /**
+     * Writes a vector of string values.
+     *
+     * Values will be deserialized on other machines in the same order they were
+     * written in. You should pass the result of {@link #serialize} to the
+     * {@link NetcodeConnection} to send all values buffered up to this point.
+     *
+     * The values may come from any contiguous storage, such as an array. They
+     * will be deserialized as a vector.
+     *
+     * @param v The values to write
+     */
+    void writeStringVector(std::span<const std::string> v);
 
     /**
      * Writes a vector of string values.
@@ -385,7 +524,7 @@ public:
      * 
      * @param v The vector to write
      */
-    void writeCharsVector(std::vector<char*> v);
+    void writeCharsVector(const std::vector<char*>& v);
 
     /**
      * Write a vector of {@link JsonValue} objects.
@@ -396,7 +535,7 @@ public:
      *
      * @param v The vector to write
      */
-    void writeJsonVector(std::vector<std::shared_ptr<JsonValue>> v);
+    void writeJsonVector(const std::vector<std::shared_ptr<JsonValue>>& v);
 
     /**
      * Returns a byte vector of all written values suitable for network transit.
@@ -440,6 +579,9 @@ public:
     
     /**
      * Clears the input buffer.
+     *
+     * The buffer memory is retained, so that the serializer can be reused
+     * without allocating memory for each message.
      */
     void reset();
     
@@ -453,11 +595,21 @@ public:
  *
  * This class only handles messages serialized using {@link NetcodeSerializer}.
  * You should use {@link NetcodeType} to guide your deserialization process. 
+ *
+ * A message can either be copied into this deserializer, or it can be read
+ * in place from a buffer owned by someone else (see {@link #receive(const std::byte*,size_t)}).
+ * In the latter case, strings can also be read in place with {@link #readStringView},
+ * and numeric vectors can be read into existing storage. This allows a message
+ * to be deserialized without allocating any memory at all.
  */
 class NetcodeDeserializer {
 private:
-    /** Currently loaded data */
-    std::vector<std::byte> _data;
+    /** The message data, if it is owned by this deserializer */
+    std::vector<std::byte> _buffer;
+    /** The start of the currently loaded data */
+    const std::byte* _data;
+    /** The number of bytes of loaded data */
+    size_t _size;
     /** Position in the data of next byte to read */
     size_t _pos;
 
@@ -501,7 +653,7 @@ public:
      * to use an init method. However, we do include a static {@link #alloc} method
      * for creating shared pointers.
      */
-    NetcodeDeserializer() : _pos(0) {}
+    NetcodeDeserializer() : _data(nullptr), _size(0), _pos(0) {}
 
     /**
      * Returns a newly created Netcode ,l Deserializer.
@@ -533,6 +685,33 @@ public:
      * @param msg The byte vector serialized by {@link NetcodeSerializer}
      */
     void receive(const std::vector<std::byte>& msg);
+
+    /**
+     * Loads a new message to be read, taking ownership of it.
+     *
+     * This method is identical to {@link #receive(const std::vector<std::byte>&)}
+     * except that the message is moved into this deserializer instead of
+     * copied.
+     *
+     * @param msg The byte vector serialized by {@link NetcodeSerializer}
+     */
+    void receive(std::vector<std::byte>&& msg);
+
+    /**
+     * Loads a new message to be read in place.
+     *
+     * This deserializer does NOT copy the message. The data must remain valid
+     * (and unchanged) until the message is read completely, or until another
+     * message is loaded. In return, loading a message requires no allocation.
+     *
+     * Calling this method will discard any previously loaded messages. The
+     * message must be serialized by {@link NetcodeSerializer}. Otherwise,
+     * the results are unspecified.
+     *
+     * @param data  The message serialized by {@link NetcodeSerializer}
+     * @param size  The number of bytes in the message
+     */
+    void receive(const std::byte* data, size_t size);
     
     /**
      * Loads a new Base 64 message to be read.
@@ -579,7 +758,7 @@ public:
      *
      * @return true if there is any data left to be read
      */
-    bool available() const { return _pos < _data.size(); }
+    bool available() const { return _pos < _size; }
     
     /**
      * Returns the type of the next data value to be read.
@@ -695,6 +874,24 @@ public:
      * @return a single string.
      */
     std::string readString();
+
+    /**
+     * Returns a single string as a view into the loaded message.
+     *
+     * This method is only defined if {@link #nextType} has returned StringType.
+     * Otherwise, calling this method will potentially corrupt the stream.
+     *
+     * Unlike {@link #readString}, this method does not copy the string. The
+     * view is only valid as long as the loaded message. If the message was
+     * read in place (see {@link #receive(const std::byte*,size_t)}), that is
+     * the lifetime of the original buffer.
+     *
+     * The method advances the read position. If called when no more data is
+     * available, this method will return the empty string.
+     *
+     * @return a single string as a view into the loaded message.
+     */
+    std::string_view readStringView();
     
     /**
      * Returns a single {@link JsonValue} object.
@@ -737,6 +934,25 @@ public:
      */
     std::vector<float> readFloatVector();
 
+    /**
+     * Reads a vector of float values into the given buffer.
+     *
+     * This method is only defined if {@link #nextType} has returned 
+     * (ArrayType+FloatType). Otherwise, calling this method will potentially 
+     * corrupt the stream.
+     *
+     * This method stores as many values as fit in the buffer, skipping the
+     * rest. It returns the length of the serialized vector, so a result
+     * larger than the buffer indicates that values were skipped. Either way,
+     * the read position is advanced past the entire vector. This method does
+     * not allocate any memory.
+     *
+     * @param buffer    The buffer to store the values
+     *
+     * @return the number of values in the serialized vector
+     */
+    size_t readFloatVector(std::span<float> buffer);
+
     /**
      * Returns a vector of double values.
      *
@@ -751,6 +967,25 @@ public:
      */
     std::vector<double> readDoubleVector();
 
+    /**
+     * Reads a vector of double values into the given buffer.
+     *
+     * This method is only defined if {@link #nextType} has returned 
+     * (ArrayType+DoubleType). Otherwise, calling this method will potentially 
+     * corrupt the stream.
+     *
+     * This method stores as many values as fit in the buffer, skipping the
+     * rest. It returns the length of the serialized vector, so a result
+     * larger than the buffer indicates that values were skipped. Either way,
+     * the read position is advanced past the entire vector. This method does
+     * not allocate any memory.
+     *
+     * @param buffer    The buffer to store the values
+     *
+     * @return the number of values in the serialized vector
+     */
+    size_t readDoubleVector(std::span<double> buffer);
+
     /**
      * Returns a vector of unsigned (32 bit) int values.
      *
@@ -765,6 +1000,25 @@ public:
      */
     std::vector<Uint32> readUint32Vector();
 
+    /**
+     * Reads a vector of unsigned (32 bit) int values into the given buffer.
+     *
+     * This method is only defined if {@link #nextType} has returned 
+     * (ArrayType+UInt32Type). Otherwise, calling this method will potentially 
+     * corrupt the stream.
+     *
+     * This method stores as many values as fit in the buffer, skipping the
+     * rest. It returns the length of the serialized vector, so a result
+     * larger than the buffer indicates that values were skipped. Either way,
+     * the read position is advanced past the entire vector. This method does
+     * not allocate any memory.
+     *
+     * @param buffer    The buffer to store the values
+     *
+     * @return the number of values in the serialized vector
+     */
+    size_t readUint32Vector(std::span<Uint32> buffer);
+
     /**
      * Returns a vector of signed (32 bit) int values.
      *
@@ -779,6 +1033,25 @@ public:
      */
     std::vector<Sint32> readSint32Vector();
 
+    /**
+     * Reads a vector of signed (32 bit) int values into the given buffer.
+     *
+     * This method is only defined if {@link #nextType} has returned 
+     * (ArrayType+SInt32Type). Otherwise, calling this method will potentially 
+     * corrupt the stream.
+     *
+     * This method stores as many values as fit in the buffer, skipping the
+     * rest. It returns the length of the serialized vector, so a result
+     * larger than the buffer indicates that values were skipped. Either way,
+     * the read position is advanced past the entire vector. This method does
+     * not allocate any memory.
+     *
+     * @param buffer    The buffer to store the values
+     *
+     * @return the number of values in the serialized vector
+     */
+    size_t readSint32Vector(std::span<Sint32> buffer);
+
     /**
      * Returns a vector of unsigned (64 bit) int values.
      *
@@ -792,6 +1065,25 @@ public:
      * @return a vector of unsigned (64 bit) int values.
      */
     std::vector<Uint64> readUint64Vector();
+
+    /**
+     * Reads a vector of unsigned (64 bit) int values into the given buffer.
+     *
+     * This method is only defined if {@link #nextType} has returned 
+     * (ArrayType+UInt64Type). Otherwise, calling this method will potentially 
+     * corrupt the stream.
+     *
+     * This method stores as many values as fit in the buffer, skipping the
+     * rest. It returns the length of the serialized vector, so a result
+     * larger than the buffer indicates that values were skipped. Either way,
+     * the read position is advanced past the entire vector. This method does
+     * not allocate any memory.
+     *
+     * @param buffer    The buffer to store the values
+     *
+     * @return the number of values in the serialized vector
+     */
+    size_t readUint64Vector(std::span<Uint64> buffer);
     
     /**
      * Returns a vector of signed (64 bit) int values.
@@ -807,6 +1099,25 @@ public:
      */
     std::vector<Sint64> readSint64Vector();
 
+    /**
+     * Reads a vector of signed (64 bit) int values into the given buffer.
+     *
+     * This method is only defined if {@link #nextType} has returned 
+     * (ArrayType+SInt64Type). Otherwise, calling this method will potentially 
+     * corrupt the stream.
+     *
+     * This method stores as many values as fit in the buffer, skipping the
+     * rest. It returns the length of the serialized vector, so a result
+     * larger than the buffer indicates that values were skipped. Either way,
+     * the read position is advanced past the entire vector. This method does
+     * not allocate any memory.
+     *
+     * @param buffer    The buffer to store the values
+     *
+     * @return the number of values in the serialized vector
+     */
+    size_t readSint64Vector(std::span<Sint64> buffer);
+
     /**
      * Returns a vector of strings.
      *
@@ -839,6 +1150,20 @@ public:
      * Clears the buffer and ignore any remaining data in it.
      */
     void reset();
+
+private:
+    /**
+     * Returns the length of the vector at the read position
+     *
+     * This method advances the read position past the vector header. It
+     * throws an exception if the vector is longer than the remaining data,
+     * as each element has a type and at least one byte of data.
+     *
+     * @param stride    The number of bytes for each element
+     *
+     * @return the length of the vector at the read position
+     */
+    size_t readVectorSize(size_t stride);
 };
 
 	}
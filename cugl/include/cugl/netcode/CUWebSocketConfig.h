@@ -137,6 +137,18 @@ public:
      */
     size_t maxMessage;
 
+    /**
+     * Whether the server buffers messages per connection (default false)
+     *
+     * By default, all messages are stored in a single buffer, and they are
+     * dispatched in the order they are received. In sharded mode, each
+     * connection has its own buffer (with the capacity of the message buffer
+     * size). Connections do not contend with each other when receiving
+     * messages, and messages are dispatched one connection at a time. This
+     * mode is intended for dedicated servers with many clients.
+     */
+    bool sharded;
+
 
 #pragma mark Constructors
     /**
@@ -176,6 +188,7 @@ public:
      *      "timeout":      An int representing the connection timeout
      *      "buffer size":  An int respresenting the size of the message buffer
      *      "max message":  An int respresenting the maximum transmission size
+     *      "sharded":      A boolean indicating if messages are buffered per client
      *
      * @param prefs     The configuration settings
      */
@@ -258,6 +271,7 @@ public:
      *      "timeout":      An int representing the connection timeout
      *      "buffer size":  An int respresenting the size of the message buffer
      *      "max message":  An int respresenting the maximum transmission size
+     *      "sharded":      A boolean indicating if messages are buffered per client
      *
      * @param pref      The address settings
      *
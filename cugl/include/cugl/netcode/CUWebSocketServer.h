@@ -256,6 +256,19 @@ private:
     /** The connection keys */
     std::unordered_map<std::string,size_t> _keymap;
 
+    /**
+     * A snapshot of the open connections
+     *
+     * Broadcasts iterate over this snapshot, rather than collecting the
+     * sockets each time. It is only rebuilt when a connection opens or
+     * closes, so a broadcast only holds the lock long enough to copy a
+     * shared pointer. In sharded mode, {@link #receive} also uses this
+     * snapshot to find the connection buffers.
+     */
+    std::shared_ptr<const std::vector<std::shared_ptr<WebSocketWrapper>>> _snapshot;
+    /** The snapshots of the open connections for each path */
+    std::unordered_map<std::string,std::shared_ptr<const std::vector<std::shared_ptr<WebSocketWrapper>>>> _pathshots;
+
     /* A user defined callback to be invoked when a peer connects. */
     ConnectionCallback _onConnect;
     /* A user defined callback to be invoked when a peer disconnects. */
@@ -284,6 +297,12 @@ private:
     size_t _buffhead;
     /** The tail of the data ring buffer */
     size_t _bufftail;
+    /** The number of messages dropped because a buffer was full */
+    std::atomic<Uint64> _dropped;
+    /** Whether messages are dispatched immediately with {@link #onReceipt} */
+    std::atomic<bool> _immediate;
+    /** Whether {@link #receive} is currently draining the buffers */
+    std::atomic<bool> _draining;
     
     // To prevent race conditions
     /** Whether this websocket connection prints out debugging information */
@@ -420,6 +439,27 @@ private:
      * @return if the message was successfully added to the buffer.
      */
     bool append(const std::string client, const std::vector<std::byte>& data, Uint64 timestamp);
+
+    /**
+     * Rebuilds the connection snapshots after a connection change.
+     *
+     * This rebuilds the snapshot of all connections, and the snapshot of the
+     * given path. This method must be called while holding the lock.
+     *
+     * @param path  The path of the connection that changed
+     */
+    void refresh(const std::string& path);
+
+    /**
+     * Dispatches all messages in the connection buffers.
+     *
+     * This is the implementation of {@link #receive} in sharded mode. Each
+     * connection buffer is swapped out in constant time and dispatched with
+     * no locks held.
+     *
+     * @param dispatcher    The function to process received data
+     */
+    void drain(const Dispatcher& dispatcher);
     
 public:
 #pragma mark Static Allocators
@@ -508,6 +548,8 @@ public:
      * Note that this is NOT the same as the capacity of a single message. That
      * value was set as part of the initial {@link WebSocketConfig}.
      *
+     * In sharded mode, this is the capacity of each connection buffer.
+     *
      * @param capacity  The new message buffer capacity.
      */
     void setCapacity(size_t capacity);
@@ -566,6 +608,69 @@ public:
      * @return the number of clients currently connected to this server
      */
     size_t getNumConnections();
+
+    /**
+     * Returns true if this server buffers messages per connection.
+     *
+     * This value is set by {@link WebSocketConfig#sharded}. In sharded mode,
+     * connections do not contend with each other when receiving messages,
+     * and {@link #receive} dispatches messages one connection at a time.
+     *
+     * @return true if this server buffers messages per connection.
+     */
+    bool isSharded() const { return _config.sharded; }
+
+    /**
+     * Returns the number of messages waiting to be received.
+     *
+     * This is the total number of messages across all connections that will
+     * be dispatched by the next call to {@link #receive}.
+     *
+     * This method is not const because it requires a lock.
+     *
+     * @return the number of messages waiting to be received.
+     */
+    size_t getQueueDepth();
+
+    /**
+     * Returns the number of messages waiting to be received from a client.
+     *
+     * This value is only tracked in sharded mode. Otherwise, this method
+     * returns 0.
+     *
+     * This method is not const because it requires a lock.
+     *
+     * @param client    The client identifier
+     *
+     * @return the number of messages waiting to be received from a client.
+     */
+    size_t getQueueDepth(const std::string client);
+
+    /**
+     * Returns the average time messages from a client wait to be received.
+     *
+     * This is the time in microseconds between the arrival of a message and
+     * its dispatch by {@link #receive}, smoothed over recent messages. This
+     * value is only tracked in sharded mode. Otherwise, this method returns
+     * 0.
+     *
+     * This method is not const because it requires a lock.
+     *
+     * @param client    The client identifier
+     *
+     * @return the average time messages from a client wait to be received.
+     */
+    Uint64 getLatency(const std::string client);
+
+    /**
+     * Returns the number of messages dropped because a buffer was full.
+     *
+     * If this number is growing, either {@link #receive} should be called
+     * more often or the capacity should be increased.
+     *
+     * @return the number of messages dropped because a buffer was full.
+     */
+    Uint64 getDropped() const { return _dropped; }
     
 #pragma mark Communication
     /**
@@ -703,6 +808,11 @@ public:
      * buffered and are processed as soon as they are received. However, this
      * method has the advantage that it can be read on a separate thread.
      *
+     * In sharded mode, messages are dispatched one connection at a time (in
+     * the order received from that connection). Messages from different
+     * connections can be ordered by their timestamp. This method should not
+     * be called by more than one thread at a time.
+     *
      * @param dispatcher    The function to process received data
      */
     void receive(const Dispatcher& dispatcher);
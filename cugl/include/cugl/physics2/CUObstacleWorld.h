@@ -50,6 +50,7 @@
 #include <box2d/b2_world.h>
 #include <box2d/b2_joint.h>
 #include <cugl/core/math/cu_math.h>
+#include <cugl/core/util/CUThreadPool.h>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
@@ -73,6 +74,23 @@ class Obstacle;
 // Forward declaration of the Joint class
 class Joint;
 
+/**
+ * The closest fixture hit by a ray in a batched ray cast.
+ *
+ * See {@link ObstacleWorld#rayCast}.
+ */
+class RayHit {
+public:
+    /** The fixture hit by the ray (nullptr if the ray hit nothing) */
+    b2Fixture* fixture;
+    /** The point of intersection */
+    Vec2 point;
+    /** The normal vector at the point of intersection */
+    Vec2 normal;
+    /** The fraction along the ray at the point of intersection (1 if no hit) */
+    float fraction;
+};
+
 /** Default amount of time for a physics engine step. */
 #define DEFAULT_WORLD_STEP  1/60.0f
 /** Default number of velocity iterations for the constrain solvers */
@@ -129,6 +147,26 @@ protected:
     /** Whether or not to activate the destruction listener */
     bool _destroy;
 
+    /** The number of threads to solve the physics islands */
+    Uint32 _threads;
+    /** The worker threads (other than the calling thread) */
+    std::shared_ptr<ThreadPool> _workers;
+    /** The fixtures found by each worker thread in a batched query */
+    mutable std::vector<std::vector<b2Fixture*>> _partials;
+
+    /**
+     * Runs the given island solver tasks, returning when they are complete.
+     *
+     * This is the task executor for the Box2d world. The first task is run
+     * on the calling thread, and the rest are run by the worker threads.
+     *
+     * @param task          The task to run
+     * @param taskCount     The number of tasks
+     * @param taskContext   The solver data shared by all tasks
+     * @param userContext   The ObstacleWorld running the tasks
+     */
+    static void runTasks(b2TaskCallback* task, int32 taskCount, void* taskContext, void* userContext);
+
     
 #pragma mark -
 #pragma mark Constructors
@@ -327,6 +365,38 @@ public:
      * @param  gravity  the global gravity vector.
      */
     void setGravity(const Vec2 gravity);
+
+    /**
+     * Returns the number of threads used to solve the physics islands.
+     *
+     * An island is a set of bodies connected by contacts or joints. Islands
+     * are independent of each other, so they can be solved in parallel. If
+     * this value is 1 (the default), the world is solved on the calling
+     * thread only.
+     *
+     * @return the number of threads used to solve the physics islands.
+     */
+    Uint32 getThreadCount() const { return _threads; }
+
+    /**
+     * Sets the number of threads used to solve the physics islands.
+     *
+     * An island is a set of bodies connected by contacts or joints. Islands
+     * are independent of each other, so they can be solved in parallel. If
+     * this value is greater than 1, each step partitions the awake islands
+     * into (at most) this many tasks, and solves them on a pool of worker
+     * threads together with the calling thread.
+     *
+     * The simulation is identical to a serial one, and the islands are
+     * merged in a deterministic order. The only difference is that the
+     * {@link #afterSolve} callbacks are deferred until all islands are
+     * solved (they are still called in the serial order, on the calling
+     * thread). Collision detection and continuous collision remain serial,
+     * so this only pays off for large worlds with many separate islands.
+     *
+     * @param threads   The number of threads used to solve the physics islands
+     */
+    void setThreadCount(Uint32 threads);
     
     /**
      * Executes a single step of the physics engine.
@@ -779,6 +849,55 @@ public:
     void rayCast(std::function<float(b2Fixture* fixture, const Vec2 point,
                                      const Vec2 normal, float fraction)> callback,
                  const Vec2 point1, const Vec2 point2) const;
+
+    /**
+     * Query the world for the fixtures that potentially overlap each AABB.
+     *
+     * This is a batched version of {@link #queryAABB} for issuing many
+     * queries at once. The fixtures for box i are stored in fixtures at
+     * positions offsets[i] to offsets[i+1] (exclusive), in the order that
+     * Box2d reports them. Both vectors are cleared first, but they keep their
+     * capacity, so reusing them avoids allocation.
+     *
+     * Only fixtures whose category bits intersect the mask are reported. If
+     * {@link #getThreadCount} is greater than 1, large batches are split
+     * across the worker threads. The results are the same either way. The
+     * world must not be modified (or stepped) during the query. As the
+     * worker results are kept between calls, this method should only be
+     * called from one thread at a time.
+     *
+     * @param boxes     The axis-aligned bounding boxes
+     * @param count     The number of boxes
+     * @param fixtures  The vector to store the fixtures found
+     * @param offsets   The vector to store the start of each box (count+1 values)
+     * @param mask      The category bits of the fixtures to report
+     */
+    void queryAABB(const Rect* boxes, size_t count,
+                   std::vector<b2Fixture*>& fixtures, std::vector<size_t>& offsets,
+                   Uint16 mask = 0xFFFF) const;
+
+    /**
+     * Ray-casts the world for the closest fixture hit by each ray.
+     *
+     * This is a batched version of {@link #rayCast} for issuing many ray casts
+     * (such as line-of-sight tests) at once. The closest hit for the ray from
+     * starts[i] to ends[i] is stored in hits[i]. If the ray hits nothing, the
+     * fixture of the hit is nullptr, and the fraction is 1. As with a single
+     * ray-cast, fixtures that contain the starting point are ignored.
+     *
+     * Only fixtures whose category bits intersect the mask are reported. If
+     * {@link #getThreadCount} is greater than 1, large batches are split
+     * across the worker threads. The results are the same either way. The
+     * world must not be modified (or stepped) during the ray casts.
+     *
+     * @param starts    The ray starting points
+     * @param ends      The ray ending points
+     * @param count     The number of rays
+     * @param hits      The array to store the closest hits (at least count)
+     * @param mask      The category bits of the fixtures to report
+     */
+    void rayCast(const Vec2* starts, const Vec2* ends, size_t count,
+                 RayHit* hits, Uint16 mask = 0xFFFF) const;
     
 };
     }
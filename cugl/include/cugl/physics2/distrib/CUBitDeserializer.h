@@ -0,0 +1,245 @@
+//
+//  CUBitDeserializer.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a bit-level deserializer for networked physics. Like
+//  the lightweight deserializer, it relies on the user to know the type of
+//  the data. It is to be paired with the bit-level serializer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#ifndef __CU_BIT_DESERIALIZER_H__
+#define __CU_BIT_DESERIALIZER_H__
+
+#include <SDL_stdinc.h>
+#include <vector>
+#include <memory>
+
+namespace cugl {
+
+    /**
+     * The classes to represent 2-d physics.
+     *
+     * For 2-d physics, CUGL uses the venerable box2d. For the most part, we
+     * do not need anything more than that. However, box2d does involve a lot
+     * of boilerplate code in setting up bodies and fixtures. Students have
+     * found that they like the "training wheel" classes in this package.
+     */
+    namespace physics2 {
+
+        /**
+         * The classes to implement distributed box2d physics.
+         *
+         * This namespace represents an extension of our 2-d physics engine
+         * to support networking. This package provides automatic synchronization
+         * of physics objects across devices.
+         */
+        namespace distrib {
+
+/**
+ * A bit-level deserializer for networked physics.
+ *
+ * This class is similar to {@link LWDeserializer}, except that values are
+ * read as an arbitrary number of bits. It reads the data in place, without
+ * copying it.
+ *
+ * Reading past the end of the data is safe. The missing bits are read as
+ * zeroes, and {@link #hasOverflow} will return true.
+ *
+ * This class is to be paired with {@link BitSerializer} for serialization.
+ */
+class BitDeserializer {
+private:
+    /** Currently loaded data (not owned) */
+    const std::byte* _data;
+    /** The number of bytes of loaded data */
+    size_t _size;
+    /** Position in the data of next byte to read */
+    size_t _pos;
+    /** The bits read from the data, but not yet consumed (right aligned) */
+    Uint64 _accum;
+    /** The number of bits in the accumulator */
+    Uint32 _count;
+    /** Whether a read has gone past the end of the data */
+    bool _overflow;
+
+public:
+    /**
+     * Creates a new BitDeserializer on the stack.
+     *
+     * Deserializers do not have any nontrivial state and so it is unnecessary
+     * to use an init method. However, we do include a static {@link #alloc}
+     * method for creating shared pointers.
+     */
+    BitDeserializer() : _data(nullptr), _size(0), _pos(0),
+    _accum(0), _count(0), _overflow(false) {}
+
+    /**
+     * Returns a newly allocated BitDeserializer.
+     *
+     * This method is solely include for convenience purposes.
+     *
+     * @return a newly allocated BitDeserializer.
+     */
+    static std::shared_ptr<BitDeserializer> alloc() {
+        return std::make_shared<BitDeserializer>();
+    }
+
+    /**
+     * Loads a new message to be read.
+     *
+     * Calling this method will discard any previously loaded messages. The
+     * message must be serialized by {@link BitSerializer}. Otherwise, the
+     * results are unspecified.
+     *
+     * The message is NOT copied. It must remain valid until the next call to
+     * this method or {@link #reset}.
+     *
+     * @param msg The byte vector serialized by {@link BitSerializer}
+     */
+    void receive(const std::vector<std::byte>& msg) {
+        receive(msg.data(), msg.size());
+    }
+
+    /**
+     * Loads a new message to be read.
+     *
+     * Calling this method will discard any previously loaded messages. The
+     * message must be serialized by {@link BitSerializer}. Otherwise, the
+     * results are unspecified.
+     *
+     * The message is NOT copied. It must remain valid until the next call to
+     * this method or {@link #reset}.
+     *
+     * @param data  The bytes serialized by {@link BitSerializer}
+     * @param size  The number of bytes
+     */
+    void receive(const std::byte* data, size_t size) {
+        _data = data;
+        _size = size;
+        _pos = 0;
+        _accum = 0;
+        _count = 0;
+        _overflow = false;
+    }
+
+    /**
+     * Returns true if a read has gone past the end of the data.
+     *
+     * Once this is true, any values read since the end of the data are
+     * invalid.
+     *
+     * @return true if a read has gone past the end of the data.
+     */
+    bool hasOverflow() const {
+        return _overflow;
+    }
+
+    /**
+     * Returns the given number of bits from the loaded data.
+     *
+     * The method advances the read position. If called when no more data is
+     * available, the missing bits are zero.
+     *
+     * @param bits  The number of bits to read (at most 64)
+     *
+     * @return the given number of bits from the loaded data.
+     */
+    Uint64 readBits(Uint32 bits) {
+        if (bits > 32) {
+            Uint64 high = readBits(bits-32);
+            return (high << 32) | readBits(32);
+        }
+        while (_count < bits) {
+            Uint8 next = 0;
+            if (_pos < _size) {
+                next = static_cast<Uint8>(_data[_pos++]);
+            } else {
+                _overflow = true;
+            }
+            _accum = (_accum << 8) | next;
+            _count += 8;
+        }
+        _count -= bits;
+        Uint64 value = (_accum >> _count) & (((Uint64)1 << bits)-1);
+        _accum &= ((Uint64)1 << _count)-1;
+        return value;
+    }
+
+    /**
+     * Returns a boolean read from the loaded data.
+     *
+     * The method advances the read position. If called when no more data is
+     * available, this method will return false.
+     *
+     * @return a boolean read from the loaded data.
+     */
+    bool readBool() {
+        return readBits(1) != 0;
+    }
+
+    /**
+     * Returns an unsigned integer of variable length from the loaded data.
+     *
+     * The method advances the read position. If called when no more data is
+     * available, this method will return 0.
+     *
+     * @return an unsigned integer of variable length from the loaded data.
+     */
+    Uint64 readVarint() {
+        Uint64 result = 0;
+        for (Uint32 shift = 0; shift < 64; shift += 7) {
+            Uint64 group = readBits(8);
+            result |= (group & 0x7f) << shift;
+            if (!(group & 0x80)) {
+                break;
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Returns a signed integer of variable length from the loaded data.
+     *
+     * The method advances the read position. If called when no more data is
+     * available, this method will return 0.
+     *
+     * @return a signed integer of variable length from the loaded data.
+     */
+    Sint64 readSignedVarint() {
+        Uint64 value = readVarint();
+        return (Sint64)(value >> 1) ^ -(Sint64)(value & 1);
+    }
+
+    /**
+     * Resets the deserializer and clears the loaded data.
+     */
+    void reset() {
+        receive(nullptr, 0);
+    }
+};
+
+        }
+    }
+}
+#endif /* __CU_BIT_DESERIALIZER_H__ */
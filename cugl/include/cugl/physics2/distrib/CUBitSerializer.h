@@ -0,0 +1,219 @@
+//
+//  CUBitSerializer.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a bit-level serializer for networked physics. Like
+//  the lightweight serializer, it relies on the user to know the type of the
+//  data. However, values are not rounded up to whole bytes, so quantized
+//  values only take as many bits as they need. This makes it appropriate for
+//  high volume messages like physics synchronization.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#ifndef __CU_BIT_SERIALIZER_H__
+#define __CU_BIT_SERIALIZER_H__
+
+#include <SDL_stdinc.h>
+#include <vector>
+#include <memory>
+
+namespace cugl {
+
+    /**
+     * The classes to represent 2-d physics.
+     *
+     * For 2-d physics, CUGL uses the venerable box2d. For the most part, we
+     * do not need anything more than that. However, box2d does involve a lot
+     * of boilerplate code in setting up bodies and fixtures. Students have
+     * found that they like the "training wheel" classes in this package.
+     */
+    namespace physics2 {
+
+        /**
+         * The classes to implement distributed box2d physics.
+         *
+         * This namespace represents an extension of our 2-d physics engine
+         * to support networking. This package provides automatic synchronization
+         * of physics objects across devices.
+         */
+        namespace distrib {
+
+/**
+ * A bit-level serializer for networked physics.
+ *
+ * This class is similar to {@link LWSerializer}, except that values are
+ * written as an arbitrary number of bits. Bits are written most significant
+ * first, so the stream is independent of the platform byte order. The final
+ * byte is padded with zeroes when the data is serialized.
+ *
+ * This class is to be paired with {@link BitDeserializer} for deserialization.
+ */
+class BitSerializer {
+private:
+    /** The buffered serialized data */
+    std::vector<std::byte> _data;
+    /** The bits not yet written to the buffer (right aligned) */
+    Uint64 _accum;
+    /** The number of bits in the accumulator (always less than 8) */
+    Uint32 _count;
+
+public:
+    /**
+     * Creates a new BitSerializer on the stack.
+     *
+     * Serializers do not have any nontrivial state and so it is unnecessary
+     * to use an init method. However, we do include a static {@link #alloc}
+     * method for creating shared pointers.
+     */
+    BitSerializer() : _accum(0), _count(0) {}
+
+    /**
+     * Returns a newly allocated BitSerializer.
+     *
+     * This method is solely include for convenience purposes.
+     *
+     * @return a newly allocated BitSerializer.
+     */
+    static std::shared_ptr<BitSerializer> alloc() {
+        return std::make_shared<BitSerializer>();
+    }
+
+    /**
+     * Reserves space for the given number of bytes.
+     *
+     * This is an optimization to avoid reallocating the buffer while writing.
+     *
+     * @param bytes The number of bytes to reserve
+     */
+    void reserve(size_t bytes) {
+        _data.reserve(bytes);
+    }
+
+    /**
+     * Returns the number of bits written so far.
+     *
+     * @return the number of bits written so far.
+     */
+    size_t bitSize() const {
+        return 8*_data.size()+_count;
+    }
+
+    /**
+     * Writes the low order bits of the given value to the buffer.
+     *
+     * Values will be deserialized on other machines in the same order they were
+     * written in. Any bits of value above the given width are ignored.
+     *
+     * @param value The value to write
+     * @param bits  The number of bits to write (at most 64)
+     */
+    void writeBits(Uint64 value, Uint32 bits) {
+        if (bits > 32) {
+            writeBits(value >> 32, bits-32);
+            value &= 0xffffffff;
+            bits = 32;
+        }
+        value &= ((Uint64)1 << bits)-1;
+        _accum = (_accum << bits) | value;
+        _count += bits;
+        while (_count >= 8) {
+            _count -= 8;
+            _data.push_back(std::byte((_accum >> _count) & 0xff));
+        }
+        _accum &= ((Uint64)1 << _count)-1;
+    }
+
+    /**
+     * Writes a single boolean value to the buffer.
+     *
+     * Values will be deserialized on other machines in the same order they were
+     * written in. The value only uses one bit.
+     *
+     * @param b The value to write
+     */
+    void writeBool(bool b) {
+        writeBits(b ? 1 : 0, 1);
+    }
+
+    /**
+     * Writes an unsigned integer of variable length to the buffer.
+     *
+     * The value is written in groups of seven bits, each followed by a bit
+     * indicating whether more groups follow. So small values (such as counts
+     * or differences of ids) use very little space.
+     *
+     * @param value The value to write
+     */
+    void writeVarint(Uint64 value) {
+        while (value >= 0x80) {
+            writeBits((value & 0x7f) | 0x80, 8);
+            value >>= 7;
+        }
+        writeBits(value, 8);
+    }
+
+    /**
+     * Writes a signed integer of variable length to the buffer.
+     *
+     * The value is zig-zag encoded, so that values of small magnitude use
+     * very little space regardless of sign.
+     *
+     * @param value The value to write
+     */
+    void writeSignedVarint(Sint64 value) {
+        writeVarint(((Uint64)value << 1) ^ (Uint64)(value >> 63));
+    }
+
+    /**
+     * Returns the serialized data.
+     *
+     * If the bits written do not fill the last byte, it is padded with
+     * zeroes. Any bits written after this method are aligned to the next byte.
+     *
+     * @return A const reference to the serialized data. (Will be lost if reset)
+     */
+    const std::vector<std::byte>& serialize() {
+        if (_count > 0) {
+            writeBits(0, 8-_count);
+        }
+        return _data;
+    }
+
+    /**
+     * Clears the input buffer.
+     *
+     * Note that this will make previous serialize() returns invalid. The
+     * buffer memory is retained so that the serializer can be reused.
+     */
+    void reset() {
+        _data.clear();
+        _accum = 0;
+        _count = 0;
+    }
+};
+
+        }
+    }
+}
+
+#endif /* __CU_BIT_SERIALIZER_H__ */
@@ -84,6 +84,8 @@ private:
     Uint64 _receiveTimeStamp;
     /** The ID of the sender. */
     std::string _sourceID;
+    /** The ID of the recipient (empty for a broadcast). */
+    std::string _destinationID;
     
     //==============================META DATA================================
     
@@ -167,6 +169,27 @@ public:
      * @return the ID of the sender.
      */
     const std::string getSourceId() const { return _sourceID; }
+
+    /**
+     * Returns the ID of the recipient.
+     *
+     * This attribute is only used for outbound events. If it is empty (the
+     * default), the event is broadcast to all peers.
+     *
+     * @return the ID of the recipient.
+     */
+    const std::string getDestination() const { return _destinationID; }
+
+    /**
+     * Sets the ID of the recipient.
+     *
+     * This attribute is only used for outbound events. If it is empty (the
+     * default), the event is broadcast to all peers. Otherwise, it is only
+     * sent to the peer with this UUID.
+     *
+     * @param destination   The ID of the recipient.
+     */
+    void setDestination(const std::string destination) { _destinationID = destination; }
 };
 
         }
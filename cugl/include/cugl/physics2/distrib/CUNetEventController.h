@@ -58,6 +58,7 @@
 #include <cugl/core/CUApplication.h>
 #include <unordered_map>
 #include <typeindex>
+#include <string>
 #include <vector>
 #include <queue>
 #include <memory>
@@ -158,6 +159,35 @@ protected:
     std::queue<std::shared_ptr<NetEvent>> _reservedInEventQueue;
     /** Queue for all outbound events. Cleared every update */
     std::vector<std::shared_ptr<NetEvent>> _outEventQueue;
+
+    /**
+     * An outbound frame, coalescing the events for a single destination
+     *
+     * Frames are kept between updates so that their buffers are reused.
+     */
+    class Frame {
+    public:
+        /** The framed data */
+        std::vector<std::byte> data;
+        /** The number of events in this frame */
+        size_t count;
+
+        /** Creates an empty frame */
+        Frame() : count(0) {}
+    };
+
+    /** The outbound frames, keyed by destination (empty for broadcast) */
+    std::unordered_map<std::string,Frame> _frames;
+    /** The destinations with a pending unicast frame */
+    std::vector<std::string> _pending;
+    /** The maximum size of a frame (before compression) */
+    size_t _frameSize;
+    /** The minimum size of a frame to compress (0 to disable) */
+    size_t _compressSize;
+    /** A buffer for compressing or decompressing frames */
+    std::vector<std::byte> _packed;
+    /** A buffer for the payload of a received event */
+    std::vector<std::byte> _payload;
     
     /** Short user id assigned by the host during session */
     Uint32 _shortUID;
@@ -174,28 +204,47 @@ protected:
     
 #pragma mark Networking Internals
     /**
-     * Unwraps the a byte vector data into a NetEvent.
+     * Unwraps a framed message into NetEvents.
      *
-     * The controller automatically detects the type of event, spawns a new
+     * A frame is a flag byte, the sender timestamp, and a sequence of events.
+     * Each event is prefixed by its length (as a varint) and its type. The
+     * controller automatically detects the type of each event, spawns a new
      * empty instance of that event, and calls the event's
-     * {@link NetEvent#deserialize} method. This method is only called on
-     * outbound events.
+     * {@link NetEvent#deserialize} method. The events are passed to
+     * {@link #processReceivedEvent} in the order they were sent.
+     *
+     * The frame is read in place. Only compressed frames are copied, into a
+     * buffer that is reused across frames. This method is only called on
+     * inbound events.
      *
      * @param data      The message received
      * @param source    The UUID of the sender
      */
-    std::shared_ptr<NetEvent> unwrap(const std::vector<std::byte>& data,std::string source);
+    void unwrap(const std::vector<std::byte>& data, const std::string& source);
     
     /**
-     * Wraps a NetEvent into a byte vector.
+     * Wraps a NetEvent into the frame for its destination.
      *
      * The controller calls the event's {@link NetEvent#serialize()} method
-     * and packs the event into byte data. This method is only on inbound
-     * events.
+     * and appends the event to the frame for its destination. If the event
+     * would make the frame larger than {@link #getMaxFrameSize}, the frame is
+     * sent first. Frames that could be received by the same peer are sent
+     * in order, so each peer receives events in the order they were queued.
+     * This method is only called on outbound events.
      *
      * @param e The event to wrap
      */
-    const std::vector<std::byte> wrap(const std::shared_ptr<NetEvent>& e);
+    void wrap(const std::shared_ptr<NetEvent>& e);
+
+    /**
+     * Sends the frame for the given destination, if it has any events.
+     *
+     * The frame is compressed if it is at least {@link #getCompressionThreshold}
+     * bytes and compression makes it smaller. The frame buffer is retained.
+     *
+     * @param dst   The destination UUID (empty for broadcast)
+     */
+    void flush(const std::string& dst);
     
     /**
      * Processes all received packets received during the last update.
@@ -234,7 +283,11 @@ protected:
     bool checkConnection();
     
     /**
-     * Broadcasts all queued outbound events.
+     * Sends all queued outbound events.
+     *
+     * Events are coalesced into one frame per destination, so that a single
+     * message is sent to each peer per update (unless the frame would exceed
+     * {@link #getMaxFrameSize}).
      */
     void sendQueuedOutData();
     
@@ -351,6 +404,54 @@ public:
      * @return the current status of the controller.
      */
     Status getStatus() const { return _status; }
+
+    /**
+     * Returns the maximum size of an outbound frame.
+     *
+     * All events for the same destination in an update are coalesced into a
+     * single frame. A new frame is started when adding an event would exceed
+     * this size. An event larger than this size is sent in a frame by itself.
+     * The default is chosen to fit in a typical network MTU.
+     *
+     * @return the maximum size of an outbound frame.
+     */
+    size_t getMaxFrameSize() const { return _frameSize; }
+
+    /**
+     * Sets the maximum size of an outbound frame.
+     *
+     * All events for the same destination in an update are coalesced into a
+     * single frame. A new frame is started when adding an event would exceed
+     * this size. An event larger than this size is sent in a frame by itself.
+     * The default is chosen to fit in a typical network MTU.
+     *
+     * @param size  The maximum size of an outbound frame.
+     */
+    void setMaxFrameSize(size_t size) { _frameSize = size; }
+
+    /**
+     * Returns the minimum size of an outbound frame to compress.
+     *
+     * Frames of at least this size are compressed with a run-length encoding
+     * of zero bytes, which is effective on the fixed width integers written
+     * by {@link LWSerializer}. A frame is only sent compressed if that makes
+     * it smaller. A value of 0 disables compression (the default).
+     *
+     * @return the minimum size of an outbound frame to compress.
+     */
+    size_t getCompressionThreshold() const { return _compressSize; }
+
+    /**
+     * Sets the minimum size of an outbound frame to compress.
+     *
+     * Frames of at least this size are compressed with a run-length encoding
+     * of zero bytes, which is effective on the fixed width integers written
+     * by {@link LWSerializer}. A frame is only sent compressed if that makes
+     * it smaller. A value of 0 disables compression (the default).
+     *
+     * @param size  The minimum size of an outbound frame to compress.
+     */
+    void setCompressionThreshold(size_t size) { _compressSize = size; }
             
 #pragma mark Connection Management
     /**
@@ -0,0 +1,398 @@
+//
+//  CUNetInterest.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides interest management (area-of-interest filtering) for
+//  networked physics. By default, every shared obstacle is synchronized with
+//  every peer. In a large world, most of those obstacles are far away from
+//  the player on that peer. This module places the shared obstacles in a
+//  spatial grid, and computes the obstacles relevant to each peer from an
+//  area of interest. Physics synchronization is then sent to each peer
+//  individually, so that the traffic to a peer scales with the number of
+//  obstacles near it, and not the size of the world.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#ifndef __CU_NET_INTEREST_H__
+#define __CU_NET_INTEREST_H__
+
+#include <cugl/core/math/CURect.h>
+#include <SDL_stdinc.h>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace cugl {
+
+    /**
+     * The classes to represent 2-d physics.
+     *
+     * For 2-d physics, CUGL uses the venerable box2d. For the most part, we
+     * do not need anything more than that. However, box2d does involve a lot
+     * of boilerplate code in setting up bodies and fixtures. Students have
+     * found that they like the "training wheel" classes in this package.
+     */
+    namespace physics2 {
+
+        /**
+         * The classes to implement distributed box2d physics.
+         *
+         * This namespace represents an extension of our 2-d physics engine
+         * to support networking. This package provides automatic synchronization
+         * of physics objects across devices.
+         */
+        namespace distrib {
+
+// Forward reference
+class NetWorld;
+
+/**
+ * This class is an area-of-interest manager for networked physics.
+ *
+ * Each peer (identified by its UUID) may be given an area of interest. This
+ * is either a fixed rectangle, or a rectangle centered on an obstacle (such
+ * as the avatar of that player). Every time the manager is updated, it
+ * places the shared obstacles in a uniform grid, and queries that grid to
+ * compute the relevancy set of each peer: the obstacles whose position lies
+ * in its area of interest.
+ *
+ * The grid is stored as an array of obstacles sorted by cell (row major), so
+ * a query is a binary search for each row that it overlaps. Rebuilding the
+ * grid does not allocate memory once the manager has warmed up.
+ *
+ * When attached to a {@link NetPhysicsController}, physics synchronization
+ * is sent to each peer with an area of interest, and it only includes the
+ * obstacles in the relevancy set of that peer. Peers without an area of
+ * interest receive no synchronization at all. To give a peer the entire
+ * world, use a region containing the world bounds.
+ */
+class NetInterest {
+private:
+    /** An obstacle in the spatial grid */
+    class Entry {
+    public:
+        /** The grid cell (row major, order preserving) */
+        Uint64 cell;
+        /** The obstacle id */
+        Uint64 id;
+        /** The obstacle position */
+        Vec2 position;
+    };
+
+    /** The area of interest of a single peer */
+    class Region {
+    public:
+        /** The area of interest (the current area if anchored) */
+        Rect bounds;
+        /** The obstacle to center the area on */
+        Uint64 anchor;
+        /** Whether the area is centered on an obstacle */
+        bool anchored;
+        /** The obstacles in this area, sorted by id */
+        std::vector<Uint64> relevant;
+
+        /** Creates an empty region */
+        Region() : anchor(0), anchored(false) {}
+    };
+
+    /** The position of an obstacle followed by an area of interest */
+    class Anchor {
+    public:
+        /** The obstacle position as of the last insert */
+        Vec2 position;
+        /** The number of areas following this obstacle */
+        Uint32 users;
+        /** Whether the obstacle was inserted since the last clear */
+        bool found;
+
+        /** Creates an unused anchor */
+        Anchor() : users(0), found(false) {}
+    };
+
+    /** The size of a (square) grid cell */
+    float _cellSize;
+    /** The obstacles in the grid, sorted by cell */
+    std::vector<Entry> _entries;
+    /** The area of interest for each peer */
+    std::unordered_map<std::string,Region> _regions;
+    /** The peers with an area of interest */
+    std::vector<std::string> _peers;
+    /** The obstacles followed by an area of interest, by id */
+    std::unordered_map<Uint64,Anchor> _anchors;
+
+    /**
+     * Returns the grid coordinate for the given world coordinate
+     *
+     * @param value The world coordinate
+     *
+     * @return the grid coordinate for the given world coordinate
+     */
+    Sint32 getCoord(float value) const;
+
+    /**
+     * Returns the (order preserving) key for the given grid cell
+     *
+     * @param x The grid column
+     * @param y The grid row
+     *
+     * @return the (order preserving) key for the given grid cell
+     */
+    static Uint64 getCell(Sint32 x, Sint32 y);
+
+    /**
+     * Detaches the area of interest of a peer from its anchor (if any)
+     *
+     * The anchor is forgotten once no area of interest follows it.
+     *
+     * @param region    The area of interest
+     */
+    void detach(Region& region);
+
+#pragma mark -
+#pragma mark Constructors
+public:
+    /**
+     * Creates a new degenerate interest manager on the stack.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    NetInterest();
+
+    /**
+     * Deletes this interest manager, disposing all resources
+     */
+    ~NetInterest() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this interest manager.
+     *
+     * A disposed manager can be safely reinitialized.
+     */
+    void dispose();
+
+    /**
+     * Initializes an interest manager with the given grid cell size.
+     *
+     * The cell size should be comparable to the size of a typical area of
+     * interest. Smaller cells make queries more precise, but require more
+     * binary searches per query.
+     *
+     * @param cellSize  The size of a (square) grid cell in physics units
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(float cellSize);
+
+    /**
+     * Returns a newly allocated interest manager with the given grid cell size.
+     *
+     * The cell size should be comparable to the size of a typical area of
+     * interest. Smaller cells make queries more precise, but require more
+     * binary searches per query.
+     *
+     * @param cellSize  The size of a (square) grid cell in physics units
+     *
+     * @return a newly allocated interest manager with the given grid cell size.
+     */
+    static std::shared_ptr<NetInterest> alloc(float cellSize) {
+        std::shared_ptr<NetInterest> result = std::make_shared<NetInterest>();
+        return (result->init(cellSize) ? result : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Areas of Interest
+    /**
+     * Sets the area of interest of a peer to a fixed rectangle.
+     *
+     * The relevancy set of the peer is not updated until the next call to
+     * {@link #update} or {@link #build}.
+     *
+     * @param peer      The peer UUID
+     * @param region    The area of interest
+     */
+    void setInterest(const std::string peer, const Rect region);
+
+    /**
+     * Sets the area of interest of a peer to follow an obstacle.
+     *
+     * The area of interest is a rectangle of the given size centered on the
+     * position of the obstacle. It is typically the obstacle representing the
+     * player on that peer. If the obstacle is not in the grid, the area of
+     * interest does not move.
+     *
+     * The relevancy set of the peer is not updated until the next call to
+     * {@link #update} or {@link #build}.
+     *
+     * @param peer      The peer UUID
+     * @param anchor    The id of the obstacle to follow
+     * @param size      The size of the area of interest
+     */
+    void setInterest(const std::string peer, Uint64 anchor, const Size size);
+
+    /**
+     * Removes the area of interest of a peer.
+     *
+     * The peer will no longer receive physics synchronization. This should be
+     * called when a peer disconnects.
+     *
+     * @param peer  The peer UUID
+     */
+    void removeInterest(const std::string peer);
+
+    /**
+     * Returns true if the peer has an area of interest.
+     *
+     * @param peer  The peer UUID
+     *
+     * @return true if the peer has an area of interest.
+     */
+    bool hasInterest(const std::string peer) const {
+        return _regions.find(peer) != _regions.end();
+    }
+
+    /**
+     * Returns the current area of interest of a peer.
+     *
+     * If the area follows an obstacle, this is the area as of the last
+     * update. If the peer has no area of interest, this returns the empty
+     * rectangle.
+     *
+     * @param peer  The peer UUID
+     *
+     * @return the current area of interest of a peer.
+     */
+    Rect getInterest(const std::string peer) const;
+
+    /**
+     * Returns the peers with an area of interest.
+     *
+     * @return the peers with an area of interest.
+     */
+    const std::vector<std::string>& getPeers() const {
+        return _peers;
+    }
+
+    /**
+     * Returns the relevancy set of a peer.
+     *
+     * This is the ids of the obstacles in the area of interest of the peer,
+     * as of the last update. The ids are sorted. If the peer has no area
+     * of interest, this set is empty.
+     *
+     * @param peer  The peer UUID
+     *
+     * @return the relevancy set of a peer.
+     */
+    const std::vector<Uint64>& getRelevant(const std::string peer) const;
+
+    /**
+     * Returns true if the obstacle is in the relevancy set of a peer.
+     *
+     * @param peer  The peer UUID
+     * @param id    The obstacle id
+     *
+     * @return true if the obstacle is in the relevancy set of a peer.
+     */
+    bool isRelevant(const std::string peer, Uint64 id) const;
+
+#pragma mark -
+#pragma mark Spatial Grid
+    /**
+     * Returns the size of a (square) grid cell
+     *
+     * @return the size of a (square) grid cell
+     */
+    float getCellSize() const { return _cellSize; }
+
+    /**
+     * Returns the number of obstacles in the grid
+     *
+     * @return the number of obstacles in the grid
+     */
+    size_t size() const { return _entries.size(); }
+
+    /**
+     * Rebuilds the grid and relevancy sets from the given world.
+     *
+     * Only shared obstacles are placed in the grid. This method is called
+     * by {@link NetPhysicsController} before each synchronization.
+     *
+     * @param world The networked physics world
+     */
+    void update(const std::shared_ptr<NetWorld>& world);
+
+    /**
+     * Removes all obstacles from the grid.
+     *
+     * This method (together with {@link #insert} and {@link #build}) allows
+     * the grid to be built from positions other than those of a
+     * {@link NetWorld}, such as predicted positions.
+     */
+    void clear();
+
+    /**
+     * Adds an obstacle position to the grid.
+     *
+     * The grid is not valid until the next call to {@link #build}.
+     *
+     * @param id        The obstacle id
+     * @param position  The obstacle position
+     */
+    void insert(Uint64 id, const Vec2 position);
+
+    /**
+     * Sorts the grid and recomputes the relevancy set of every peer.
+     */
+    void build();
+
+    /**
+     * Appends the ids of the obstacles in the given region to result.
+     *
+     * An obstacle is in the region if its position is. The ids are appended
+     * in grid order, not id order. This method requires that the grid has
+     * been built.
+     *
+     * @param region    The region to query
+     * @param result    The vector to store the result
+     */
+    void query(const Rect region, std::vector<Uint64>& result) const;
+};
+
+        }
+    }
+}
+
+#endif /* __CU_NET_INTEREST_H__ */
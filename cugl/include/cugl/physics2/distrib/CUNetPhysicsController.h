@@ -48,6 +48,8 @@
 #include <cugl/physics2/distrib/CUPhysSyncEvent.h>
 #include <cugl/physics2/distrib/CUGameStateEvent.h>
 #include <cugl/physics2/distrib/CUObstacleFactory.h>
+#include <cugl/physics2/distrib/CUNetInterest.h>
+#include <cugl/physics2/distrib/CUNetRollback.h>
 #include <queue>
 
 namespace cugl {
@@ -140,7 +142,15 @@ public:
         OVERRIDE_FULL_SYNC,
         /** Synchronize all shared objects in the world */
         FULL_SYNC,
-        /** Prioritize syncing volatile objects */
+        /**
+         * Prioritize syncing volatile objects
+         *
+         * Each shared object accumulates priority every time that it is not
+         * synchronized, in proportion to its speed. Owned objects are given
+         * more weight. Only the objects of highest priority are synchronized
+         * (see {@link #setPrioritySyncLimit}), so stale objects are
+         * eventually sent even if they are not moving.
+         */
         PRIO_SYNC
     };
     
@@ -179,6 +189,26 @@ protected:
     
     /** Vector of generated events to be sent */
     std::vector<std::shared_ptr<NetEvent>> _outEvents;
+    /** The history for delta encoding physics synchronization */
+    std::shared_ptr<PhysSyncEvent::Baseline> _syncBaseline;
+    /** The accumulated synchronization priority of each shared obstacle */
+    std::unordered_map<Uint64,float> _syncPriority;
+    /** The candidates for prioritized synchronization (reused each call) */
+    std::vector<std::pair<float,Uint64>> _syncQueue;
+    /** The maximum number of objects in a prioritized synchronization */
+    size_t _syncLimit;
+    /** The objects synchronized with any peer in the current call */
+    std::vector<Uint64> _syncSent;
+    /** The area-of-interest manager (may be nullptr) */
+    std::shared_ptr<NetInterest> _interest;
+    /** The snapshot history for rollback corrections (may be nullptr) */
+    std::shared_ptr<NetRollback> _rollback;
+    /** The function to resimulate a single tick during a rollback */
+    std::function<void(Uint64 tick)> _rollbackStep;
+    /** The earliest tick corrected since the last rollback */
+    Uint64 _rollbackTick;
+    /** Whether a snapshot was corrected since the last rollback */
+    bool _rollbackPending;
     
     /**
      * Returns the result of linear object interpolation.
@@ -189,6 +219,25 @@ protected:
      */
     float interpolate(int stepsLeft, float target, float source);
     
+    /**
+     * Accumulates the synchronization priority of every shared obstacle.
+     *
+     * This method stores the (weighted) priority of each shared obstacle in
+     * {@link #_syncQueue}. It does not reset any priorities.
+     */
+    void accumulateSyncPriority();
+    
+    /**
+     * Packs object data for synchronization with each peer.
+     *
+     * This method is used instead of {@link #packPhysSync} when there is an
+     * area-of-interest manager. It creates a separate event for each peer
+     * with an area of interest, containing only relevant obstacles.
+     *
+     * @param type  the type of synchronization
+     */
+    void packInterestSync(SyncType type);
+    
     
 #pragma mark Constructors
 public:
@@ -372,6 +421,146 @@ public:
     std::vector<std::shared_ptr<NetEvent>>& getOutEvents() {
         return _outEvents;
     }
+
+    /**
+     * Returns the history for delta encoding physics synchronization.
+     *
+     * This baseline is shared by all outbound {@link PhysSyncEvent} objects
+     * created by this controller. The inbound events must share it as well,
+     * which is handled by {@link NetEventController}. The baseline can also
+     * be used to change the precision of synchronization.
+     *
+     * @return the history for delta encoding physics synchronization.
+     */
+    const std::shared_ptr<PhysSyncEvent::Baseline>& getSyncBaseline() const {
+        return _syncBaseline;
+    }
+
+    /**
+     * Returns the maximum number of objects in a prioritized synchronization.
+     *
+     * This is the number of objects sent by {@link #packPhysSync} for the
+     * type {@link SyncType#PRIO_SYNC}. The default is 80.
+     *
+     * @return the maximum number of objects in a prioritized synchronization.
+     */
+    size_t getPrioritySyncLimit() const {
+        return _syncLimit;
+    }
+
+    /**
+     * Sets the maximum number of objects in a prioritized synchronization.
+     *
+     * This is the number of objects sent by {@link #packPhysSync} for the
+     * type {@link SyncType#PRIO_SYNC}. The default is 80.
+     *
+     * @param limit The maximum number of objects in a prioritized synchronization.
+     */
+    void setPrioritySyncLimit(size_t limit) {
+        _syncLimit = limit;
+    }
+
+    /**
+     * Returns the area-of-interest manager.
+     *
+     * If this value is nullptr (the default), synchronization is broadcast
+     * to all peers.
+     *
+     * @return the area-of-interest manager.
+     */
+    const std::shared_ptr<NetInterest>& getInterest() const {
+        return _interest;
+    }
+
+    /**
+     * Sets the area-of-interest manager.
+     *
+     * If this value is nullptr (the default), synchronization is broadcast
+     * to all peers. Otherwise, {@link #packPhysSync} sends a separate event
+     * to each peer with an area of interest, and each event only contains
+     * the obstacles relevant to that peer. Peers without an area of interest
+     * receive no synchronization.
+     *
+     * @param interest  The area-of-interest manager.
+     */
+    void setInterest(const std::shared_ptr<NetInterest>& interest) {
+        _interest = interest;
+    }
+
+    /**
+     * Forgets all synchronization state for a disconnected peer.
+     *
+     * This removes the area of interest of the peer (if any), and erases
+     * the delta encoding history to and from that peer. It is called by
+     * {@link NetEventController} when a peer leaves the game.
+     *
+     * @param peer  The peer UUID
+     */
+    void removePeer(const std::string peer);
+
+    /**
+     * Returns the snapshot history for rollback corrections.
+     *
+     * If this value is nullptr (the default), physics synchronization from
+     * other peers is interpolated.
+     *
+     * @return the snapshot history for rollback corrections.
+     */
+    const std::shared_ptr<NetRollback>& getRollback() const {
+        return _rollback;
+    }
+
+    /**
+     * Sets the snapshot history for rollback corrections.
+     *
+     * When a history is attached, a physics synchronization from another
+     * peer is written into the snapshot for the tick at which it was sent
+     * (see {@link #correctSnapshot}). The next call to {@link #applyRollback}
+     * restores the earliest corrected tick and replays the world to the
+     * current tick with the given step function. Synchronizations too old
+     * for the history are interpolated as before.
+     *
+     * The application must save a snapshot of every tick (with
+     * {@link NetRollback#save}) just before stepping the world. The step
+     * function should apply the inputs of the given tick and step the world
+     * once, just as the application does.
+     *
+     * @param rollback  The snapshot history for rollback corrections
+     * @param step      The function to resimulate a single tick
+     */
+    void setRollback(const std::shared_ptr<NetRollback>& rollback,
+                     const std::function<void(Uint64 tick)>& step);
+
+    /**
+     * Corrects the state of an obstacle at an earlier tick.
+     *
+     * The correction is written into the rollback snapshot for that tick,
+     * and any interpolation of the obstacle is cancelled. The world is not
+     * changed until the next call to {@link #applyRollback}. This method
+     * returns false if there is no rollback history, or if the history does
+     * not have this obstacle at this tick. In that case the caller should
+     * fall back to interpolation.
+     *
+     * @param tick  The tick of the corrected state
+     * @param param The corrected obstacle state
+     *
+     * @return true if the correction was recorded.
+     */
+    bool correctSnapshot(Uint64 tick, const PhysSyncEvent::Parameters& param);
+
+    /**
+     * Replays the world from the earliest corrected tick to the current one.
+     *
+     * This method does nothing if no snapshot has been corrected since the
+     * last rollback. It is called by {@link NetEventController} after the
+     * incoming events are processed. The current tick is the next tick to
+     * be simulated, whose snapshot has not been saved yet.
+     *
+     * @param current   The current simulation tick
+     *
+     * @return true if the world was rolled back and replayed.
+     */
+    bool applyRollback(Uint64 current);
     
     /**
      * Updates the physics controller.
@@ -402,6 +591,9 @@ public:
      * objects. It is called automatically by {@link NetEventController}, but
      * additional calls to it can help fix potential desyncing.
      *
+     * If there is an area-of-interest manager, this method creates an event
+     * for each peer instead. See {@link #setInterest}.
+     *
      * @param type  the type of synchronization
      */
     void packPhysSync(SyncType type);
@@ -0,0 +1,389 @@
+//
+//  CUNetRollback.h
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides state snapshots for networked physics. By default,
+//  networked physics only moves forward: peers send their state, and the
+//  receivers interpolate towards it. Rollback netcode and client-side
+//  prediction instead need to save the state of the world every tick, and
+//  restore an earlier state when a correction arrives. This module keeps a
+//  ring of recent snapshots of the shared obstacles, each stored as a flat
+//  array of plain data, and supports restoring and resimulating from them.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#ifndef __CU_NET_ROLLBACK_H__
+#define __CU_NET_ROLLBACK_H__
+
+#include <SDL_stdinc.h>
+#include <functional>
+#include <vector>
+#include <memory>
+
+// Forward reference
+class b2Fixture;
+
+namespace cugl {
+
+    /**
+     * The classes to represent 2-d physics.
+     *
+     * For 2-d physics, CUGL uses the venerable box2d. For the most part, we
+     * do not need anything more than that. However, box2d does involve a lot
+     * of boilerplate code in setting up bodies and fixtures. Students have
+     * found that they like the "training wheel" classes in this package.
+     */
+    namespace physics2 {
+
+        /**
+         * The classes to implement distributed box2d physics.
+         *
+         * This namespace represents an extension of our 2-d physics engine
+         * to support networking. This package provides automatic synchronization
+         * of physics objects across devices.
+         */
+        namespace distrib {
+
+// Forward reference
+class NetWorld;
+
+/**
+ * This class is a snapshot history for networked physics.
+ *
+ * Each call to {@link #save} records the state (position, angle, velocity,
+ * and sleep state) of every shared obstacle in the world for the given
+ * tick. A snapshot is a flat array of {@link State} values sorted by
+ * obstacle id, so it can be copied, compared, or sent over the network as a
+ * single block. The manager keeps the snapshots of the most recent ticks in
+ * a ring, so saving a snapshot does not allocate memory once the ring has
+ * warmed up.
+ *
+ * When a correction arrives for an earlier tick (such as an authoritative
+ * snapshot from the host), {@link #resimulate} restores that tick and steps
+ * the world forward to the current tick again, saving each intermediate
+ * snapshot along the way. When attached to a {@link NetPhysicsController},
+ * the physics synchronization from other peers is applied this way instead
+ * of being interpolated. See {@link NetPhysicsController#setRollback}.
+ *
+ * A restore writes directly to the Box2d bodies. It does not mark the
+ * obstacles as dirty, so it does not generate any network traffic. Obstacles
+ * created after the snapshot are left alone, and obstacles removed since the
+ * snapshot are skipped.
+ *
+ * A snapshot also records the warm-starting impulses of every touching
+ * contact, and a restore puts them back. Box2d solves with these impulses
+ * as its initial guess, so without them a replay drifts from the original
+ * simulation even when nothing was corrected. Box2d does not let us restore
+ * the order of its contact list, or the time a body has been resting. When
+ * contacts were created or destroyed between the restored tick and the
+ * current one, the replay solves them in a different order, and it only
+ * matches the original simulation up to the solver tolerance.
+ */
+class NetRollback {
+public:
+    /** The obstacle is awake */
+    static const Uint32 AWAKE = 0x01;
+
+    /**
+     * The state of a single shared obstacle.
+     *
+     * This class is plain data, so a snapshot can be copied as bytes.
+     */
+    class State {
+    public:
+        /** The obstacle id */
+        Uint64 id;
+        /** The x-coordinate of the position */
+        float x;
+        /** The y-coordinate of the position */
+        float y;
+        /** The angle in radians */
+        float angle;
+        /** The x-coordinate of the linear velocity */
+        float vx;
+        /** The y-coordinate of the linear velocity */
+        float vy;
+        /** The angular velocity */
+        float omega;
+        /** The state flags (such as {@link #AWAKE}) */
+        Uint32 flags;
+        /** Unused (always 0) so that the structure has no padding */
+        Uint32 reserved;
+    };
+
+private:
+    /** The warm-starting impulses of a single contact */
+    class Contact {
+    public:
+        /** The first fixture */
+        const b2Fixture* fixtureA;
+        /** The second fixture */
+        const b2Fixture* fixtureB;
+        /** The child shape of the first fixture */
+        Sint32 childA;
+        /** The child shape of the second fixture */
+        Sint32 childB;
+        /** The number of contact points */
+        Sint32 count;
+        /** The feature key of each contact point */
+        Uint32 keys[2];
+        /** The normal impulse of each contact point */
+        float normal[2];
+        /** The tangent impulse of each contact point */
+        float tangent[2];
+    };
+
+    /** A snapshot of the world at a single tick */
+    class Snapshot {
+    public:
+        /** The tick of this snapshot */
+        Uint64 tick;
+        /** Whether this snapshot holds a saved tick */
+        bool valid;
+        /** The obstacle states, sorted by id */
+        std::vector<State> states;
+        /** The touching contacts, sorted by fixture */
+        std::vector<Contact> contacts;
+
+        /** Creates an empty snapshot */
+        Snapshot() : tick(0), valid(false) {}
+    };
+
+    /** The networked physics world */
+    std::shared_ptr<NetWorld> _world;
+    /** The ring of recent snapshots (indexed by tick) */
+    std::vector<Snapshot> _ring;
+
+    /**
+     * Returns the snapshot for the given tick
+     *
+     * @param tick  The simulation tick
+     *
+     * @return the snapshot for the given tick (nullptr if not saved)
+     */
+    const Snapshot* find(Uint64 tick) const;
+
+    /**
+     * Saves the warm-starting impulses of the touching contacts
+     *
+     * @param snap  The snapshot to save to
+     */
+    void saveContacts(Snapshot& snap);
+
+    /**
+     * Restores the warm-starting impulses of the contacts
+     *
+     * Contacts that were not touching in the snapshot have their impulses
+     * cleared.
+     *
+     * @param snap  The snapshot to restore from
+     */
+    void restoreContacts(const Snapshot& snap);
+
+#pragma mark -
+#pragma mark Constructors
+public:
+    /**
+     * Creates a new degenerate snapshot history on the stack.
+     *
+     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+     * the heap, use one of the static constructors instead.
+     */
+    NetRollback() {}
+
+    /**
+     * Deletes this snapshot history, disposing all resources
+     */
+    ~NetRollback() { dispose(); }
+
+    /**
+     * Disposes all of the resources used by this snapshot history.
+     *
+     * A disposed history can be safely reinitialized.
+     */
+    void dispose();
+
+    /**
+     * Initializes a snapshot history for the given world.
+     *
+     * The capacity is the number of ticks that can be rolled back. It
+     * should cover the worst round trip time expected, in ticks.
+     *
+     * @param world     The networked physics world
+     * @param capacity  The number of snapshots to keep
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(const std::shared_ptr<NetWorld>& world, Uint32 capacity);
+
+    /**
+     * Returns a newly allocated snapshot history for the given world.
+     *
+     * The capacity is the number of ticks that can be rolled back. It
+     * should cover the worst round trip time expected, in ticks.
+     *
+     * @param world     The networked physics world
+     * @param capacity  The number of snapshots to keep
+     *
+     * @return a newly allocated snapshot history for the given world.
+     */
+    static std::shared_ptr<NetRollback> alloc(const std::shared_ptr<NetWorld>& world,
+                                              Uint32 capacity) {
+        std::shared_ptr<NetRollback> result = std::make_shared<NetRollback>();
+        return (result->init(world,capacity) ? result : nullptr);
+    }
+
+#pragma mark -
+#pragma mark Snapshots
+    /**
+     * Returns the number of snapshots kept
+     *
+     * @return the number of snapshots kept
+     */
+    Uint32 getCapacity() const { return (Uint32)_ring.size(); }
+
+    /**
+     * Returns true if there is a snapshot for the given tick.
+     *
+     * A snapshot is lost once the ring wraps around to its slot.
+     *
+     * @param tick  The simulation tick
+     *
+     * @return true if there is a snapshot for the given tick.
+     */
+    bool hasSnapshot(Uint64 tick) const { return find(tick) != nullptr; }
+
+    /**
+     * Saves the state of the shared obstacles for the given tick.
+     *
+     * This replaces any snapshot in the same slot of the ring. The tick is
+     * typically saved just before the world is stepped.
+     *
+     * @param tick  The simulation tick
+     */
+    void save(Uint64 tick);
+
+    /**
+     * Restores the state of the shared obstacles from the given tick.
+     *
+     * This also restores the warm-starting impulses of the contacts. To do
+     * that, it brings the contacts up to date with the restored positions,
+     * which clears any forces applied since the last step. This method
+     * returns false (and does nothing) if there is no snapshot for this tick.
+     *
+     * @param tick  The simulation tick
+     *
+     * @return true if the state was restored.
+     */
+    bool restore(Uint64 tick);
+
+    /**
+     * Returns the obstacle states saved for the given tick.
+     *
+     * The states are sorted by obstacle id. This method returns nullptr if
+     * there is no snapshot for this tick.
+     *
+     * @param tick  The simulation tick
+     *
+     * @return the obstacle states saved for the given tick.
+     */
+    const std::vector<State>* getSnapshot(Uint64 tick) const;
+
+    /**
+     * Replaces the snapshot for the given tick.
+     *
+     * This is used to apply a correction, such as an authoritative snapshot
+     * received from another peer. The states must be sorted by obstacle id.
+     * If this tick was saved locally, the contact impulses of that save are
+     * kept. Otherwise, a restore of this tick clears them.
+     *
+     * @param tick      The simulation tick
+     * @param states    The obstacle states
+     * @param count     The number of obstacle states
+     */
+    void setSnapshot(Uint64 tick, const State* states, size_t count);
+
+    /**
+     * Corrects the state of a single obstacle in the given snapshot.
+     *
+     * This is used to apply a correction for one obstacle, such as a
+     * synchronization received from another peer. The correction takes
+     * effect at the next call to {@link #resimulate} from this tick (or an
+     * earlier one). This method returns false (and does nothing) if there
+     * is no snapshot for this tick, or if the obstacle is not in it.
+     *
+     * @param tick  The simulation tick
+     * @param state The corrected obstacle state
+     *
+     * @return true if the snapshot was corrected.
+     */
+    bool correct(Uint64 tick, const State& state);
+
+    /**
+     * Returns a checksum of the snapshot for the given tick.
+     *
+     * Two peers with the same checksum for a tick have (almost surely) the
+     * same state for their shared obstacles. This method returns 0 if there
+     * is no snapshot for this tick.
+     *
+     * @param tick  The simulation tick
+     *
+     * @return a checksum of the snapshot for the given tick.
+     */
+    Uint64 getChecksum(Uint64 tick) const;
+
+    /**
+     * Restores the given tick and steps forward to the current tick.
+     *
+     * The step function is called for each tick from the restored tick up
+     * to (but not including) the current tick. It should apply the inputs
+     * of that tick and step the world once. The snapshot of each following
+     * tick is then saved, replacing the one from the original simulation.
+     * This method returns false (and does nothing) if there is no snapshot
+     * for the restored tick.
+     *
+     * @param tick      The tick to restore
+     * @param current   The current simulation tick
+     * @param step      The function to simulate a single tick
+     *
+     * @return true if the world was restored and resimulated.
+     */
+    bool resimulate(Uint64 tick, Uint64 current, const std::function<void(Uint64 tick)>& step);
+};
+
+        }
+    }
+}
+
+#endif /* __CU_NET_ROLLBACK_H__ */
@@ -3,7 +3,10 @@
 //  Cornell University Game Library (CUGL)
 //
 //  This module provides events for physics synchronization, which are handled
-//  by the NetEventController internally.
+//  by the NetEventController internally. These events are sent every frame,
+//  so they use a compact encoding: every value is quantized to fixed point,
+//  obstacles are encoded relative to the last state sent for them, and the
+//  result is packed at the bit level.
 // 
 //  CUGL MIT License:
 //      This software is provided 'as-is', without any express or implied
@@ -30,11 +33,27 @@
 #ifndef __CU_PHYS_SYNC_EVENT_H__
 #define __CU_PHYS_SYNC_EVENT_H__
 
-#include <cugl/netcode/CUNetcodeSerializer.h>
 #include <cugl/physics2/CUObstacle.h>
 #include <cugl/physics2/distrib/CUNetEvent.h>
+#include <cugl/physics2/distrib/CUBitSerializer.h>
+#include <cugl/physics2/distrib/CUBitDeserializer.h>
 #include <SDL_stdinc.h>
 #include <unordered_set>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <array>
+
+/** The default number of fractional bits for obstacle positions */
+#define SYNC_POSITION_BITS  8
+/** The default number of fractional bits for obstacle velocities */
+#define SYNC_VELOCITY_BITS  6
+/** The default number of fractional bits for obstacle angles */
+#define SYNC_ANGLE_BITS     10
+/** The default number of fractional bits for angular velocities */
+#define SYNC_ANGULAR_BITS   8
+/** The default number of events between keyframes */
+#define SYNC_KEYFRAME_RATE  60
 
 namespace cugl {
 
@@ -64,6 +83,19 @@ namespace cugl {
  * This class should only be used internally by the networked physics library.
  * It is not designed to synchronize customs state. For that, you should use
  * {@link GameStateEvent} instead.
+ *
+ * Each value of an obstacle snapshot is quantized to a fixed point number,
+ * with the number of fractional bits given by a {@link Quantization}. The
+ * quantized values are then bit-packed, so that a value only uses as many
+ * bits as it needs. Obstacle ids are sorted and sent as differences, which
+ * are also small.
+ *
+ * If the event has a {@link Baseline}, an obstacle that was sent in a
+ * previous event is encoded as the difference from that previous state.
+ * As obstacles move very little between frames, these differences are much
+ * smaller than the values themselves. The receiver must share the same
+ * history, which is the purpose of the baseline. Without a baseline, every
+ * snapshot is sent in full.
  */
 class PhysSyncEvent : public NetEvent {
 public:
@@ -93,6 +125,166 @@ public:
         Parameters();
     };
 
+    /**
+     * The fixed point precision of an object snapshot.
+     *
+     * Each attribute is the number of fractional bits (0 to 31) for the
+     * corresponding values of a snapshot. So a position precision of 8 means
+     * that positions are rounded to the nearest 1/256 of a physics unit.
+     * Quantized values are clamped to 30 bits (including sign), so more
+     * fractional bits means a smaller range of values.
+     *
+     * The precision is included in every event, so the receiver does not need
+     * to know the precision of the sender.
+     */
+    class Quantization {
+    public:
+        /** The fractional bits of the position */
+        Uint8 position;
+        /** The fractional bits of the linear velocity */
+        Uint8 velocity;
+        /** The fractional bits of the angle */
+        Uint8 angle;
+        /** The fractional bits of the angular velocity */
+        Uint8 angular;
+
+        /** Creates a new quantization with default values */
+        Quantization();
+    };
+
+    /**
+     * The shared history for delta encoding.
+     *
+     * A baseline records the last (quantized) snapshot of each obstacle, both
+     * for the outbound events to each destination and for the inbound events
+     * of each peer. Outbound events are encoded relative to the history of
+     * their destination (broadcast events have their own history), and
+     * inbound events are decoded relative to the history of their source.
+     *
+     * The message channels are reliable and ordered, so the last state sent
+     * to a peer is also the last state that it acknowledged. Each event has a
+     * sequence number, so a receiver that misses an event (e.g. because it
+     * reconnected) discards its history for that source, and ignores delta
+     * snapshots until the obstacles are sent in full. The sender sends every
+     * obstacle in full at a regular keyframe interval for this reason.
+     */
+    class Baseline {
+    private:
+        /** The history of a single stream of events */
+        class Stream {
+        public:
+            /** The sequence number of the last event */
+            Uint32 sequence;
+            /** Whether the next outbound event must be a keyframe */
+            bool keyframe;
+            /** The quantized snapshot of each obstacle */
+            std::unordered_map<Uint64,std::array<Sint32,6>> states;
+
+            /** Creates an empty stream */
+            Stream() : sequence(0), keyframe(true) {}
+        };
+
+        /** The fixed point precision for outbound events */
+        Quantization _quantization;
+        /** The number of outbound events between keyframes */
+        Uint32 _keyframeRate;
+        /** The history of outbound events for each destination */
+        std::unordered_map<std::string,Stream> _outbound;
+        /** The history of inbound events for each source */
+        std::unordered_map<std::string,Stream> _inbound;
+
+        // The event accesses the streams directly
+        friend class PhysSyncEvent;
+
+    public:
+        /**
+         * Creates an empty baseline.
+         *
+         * The first outbound event will be a keyframe.
+         */
+        Baseline();
+
+        /**
+         * Returns a newly allocated empty baseline.
+         *
+         * @return a newly allocated empty baseline.
+         */
+        static std::shared_ptr<Baseline> alloc() {
+            return std::make_shared<Baseline>();
+        }
+
+        /**
+         * Clears all history in this baseline.
+         *
+         * The next outbound event will be a keyframe. This should be called
+         * whenever a new session starts.
+         */
+        void reset();
+
+        /**
+         * Removes all history for the given peer.
+         *
+         * Both the outbound history to the peer and the inbound history
+         * from the peer are erased. This should be called when a peer
+         * disconnects. If the peer reconnects, the next outbound event to
+         * it will be a keyframe.
+         *
+         * @param peer  The peer UUID
+         */
+        void removePeer(const std::string peer);
+
+        /**
+         * Removes the outbound history of obstacles no longer sent to a peer.
+         *
+         * Any obstacle in the outbound history to the given destination that
+         * is not in ids is erased. If such an obstacle is sent to this peer
+         * again, it will be sent in full. The ids must be sorted.
+         *
+         * @param peer  The peer UUID
+         * @param ids   The (sorted) obstacles to keep
+         */
+        void retain(const std::string peer, const std::vector<Uint64>& ids);
+
+        /**
+         * Returns the fixed point precision for outbound events
+         *
+         * @return the fixed point precision for outbound events
+         */
+        const Quantization& getQuantization() const { return _quantization; }
+
+        /**
+         * Sets the fixed point precision for outbound events
+         *
+         * Changing the precision forces the next outbound event to be a
+         * keyframe.
+         *
+         * @param value The fixed point precision for outbound events
+         */
+        void setQuantization(const Quantization& value);
+
+        /**
+         * Returns the number of outbound events between keyframes
+         *
+         * A keyframe sends every obstacle in full, so that peers that have
+         * lost their history can recover. If this value is 0, only the first
+         * event is a keyframe.
+         *
+         * @return the number of outbound events between keyframes
+         */
+        Uint32 getKeyframeRate() const { return _keyframeRate; }
+
+        /**
+         * Sets the number of outbound events between keyframes
+         *
+         * A keyframe sends every obstacle in full, so that peers that have
+         * lost their history can recover. If this value is 0, only the first
+         * event is a keyframe.
+         *
+         * @param value The number of outbound events between keyframes
+         */
+        void setKeyframeRate(Uint32 value) { _keyframeRate = value; }
+    };
+
 protected:
     /** The vector of added object snapshots. */
     std::vector<Parameters> _syncList;
@@ -100,14 +292,24 @@ protected:
 private:
     /** The set of ids of all obstacles added to be serialized. */
     std::unordered_set<Uint64> _obsSet;
-    // TODO: Is there a reason we are not using lightweights?
+    /** The history for delta encoding (may be nullptr) */
+    std::shared_ptr<Baseline> _baseline;
+    /** Whether the serializer holds the encoding of the current snapshots */
+    bool _encoded;
     /** The serializer for converting basic types to byte vectors. */
-    cugl::netcode::NetcodeSerializer _serializer;
+    BitSerializer _serializer;
     /** The deserializer for converting byte vectors to basic types. */
-    cugl::netcode::NetcodeDeserializer _deserializer;
+    BitDeserializer _deserializer;
     
 #pragma mark Constructors
 public:
+    /**
+     * Creates a new event with no snapshots.
+     *
+     * The event has no baseline, so every snapshot is sent in full.
+     */
+    PhysSyncEvent() : _encoded(false) {}
+
     /**
      * Returns a newly allocated event of this type.
      *
@@ -129,12 +331,43 @@ public:
      * in most of CUGL. That is because we need this factory method to be
      * polymorphic. All custom subclasses must implement this method.
      *
+     * The new event shares the baseline of this event. That way, inbound
+     * events created by the NetEventController can decode delta snapshots.
+     *
      * @return a newly allocated event of this type.
      */
     std::shared_ptr<NetEvent> newEvent() override {
-        return std::make_shared<PhysSyncEvent>();
+        std::shared_ptr<PhysSyncEvent> result = std::make_shared<PhysSyncEvent>();
+        result->_baseline = _baseline;
+        return result;
     }
     
+    /**
+     * Returns the history for delta encoding.
+     *
+     * If this value is nullptr, every snapshot is sent in full.
+     *
+     * @return the history for delta encoding.
+     */
+    const std::shared_ptr<Baseline>& getBaseline() const {
+        return _baseline;
+    }
+
+    /**
+     * Sets the history for delta encoding.
+     *
+     * If this value is nullptr, every snapshot is sent in full. Otherwise,
+     * serializing this event will update the history of its destination,
+     * while deserializing it will update the history of its source. Hence
+     * the destination must be set before the event is serialized, and an
+     * event must be deserialized after {@link #setMetaData}.
+     *
+     * @param baseline  The history for delta encoding.
+     */
+    void setBaseline(const std::shared_ptr<Baseline>& baseline) {
+        _baseline = baseline;
+    }
+
 
 #pragma mark Serialization/Deserialization
     /**
@@ -159,6 +392,11 @@ public:
     /**
      * Returns a byte vector serializing the current list of snapshots.
      *
+     * The snapshots are sorted by obstacle id as part of the encoding. If
+     * the event has a baseline, this method updates the outbound history.
+     * Therefore, the encoding is cached, and calling this method again
+     * returns the same bytes (unless more obstacles were added).
+     *
      * @return a byte vector serializing the current list of snapshots.
      */
     std::vector<std::byte> serialize() override;
@@ -166,7 +404,10 @@ public:
     /**
      * Unpacks a byte vector into a list of snapshots.
      *
-     * These snapshots can then be used in physics synchronizations.
+     * These snapshots can then be used in physics synchronizations. If the
+     * event has a baseline, the history of the source is used to decode
+     * delta snapshots (and is then updated). Delta snapshots that cannot be
+     * decoded are omitted from the list.
      *
      * @param data the byte vector to deserialize
      */
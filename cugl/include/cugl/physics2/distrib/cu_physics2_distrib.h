@@ -30,8 +30,12 @@
 #define __CU_PHYSICS2_DISTRIB_PKGS_H__
 
 #include "CUNetWorld.h"
+#include "CUNetInterest.h"
+#include "CUNetRollback.h"
 #include "CULWDeserializer.h"
 #include "CULWSerializer.h"
+#include "CUBitDeserializer.h"
+#include "CUBitSerializer.h"
 #include "CUObstacleFactory.h"
 #include "CUNetPhysicsController.h"
 #include "CUNetEventController.h"
@@ -1108,6 +1108,19 @@ public:
     virtual void draw(const std::shared_ptr<graphics::SpriteBatch>& batch,
                       const Affine2& transform, Color4 tint) override;
     
+    /**
+     * Returns false, as the drawing of a canvas node is not bounded.
+     *
+     * The paths on a canvas may be drawn anywhere, and are not confined to
+     * the content bounds. Therefore a canvas node (and its ancestors) are
+     * never culled.
+     *
+     * @param bounds    The rectangle to store the drawing bounds
+     *
+     * @return false, as the drawing of a canvas node is not bounded.
+     */
+    virtual bool getDrawBounds(Rect& bounds) override { return false; }
+    
 #pragma mark -
 #pragma mark Render State
     /**
@@ -632,7 +632,9 @@ public:
      * font, then the text will not display at all.
      *
      * Changing this value will regenerate the render data, and is potentially
-     * expensive, particularly if the font is using a fallback atlas.
+     * expensive, particularly if the font is using a fallback atlas. Setting
+     * the text to its current value does nothing (unless resize is true), so
+     * it is safe to call this method every frame.
      *
      * @param text      The text for this label.
      * @param resize    Whether to resize the label to fit the new text.
@@ -1361,6 +1363,19 @@ public:
     virtual void draw(const std::shared_ptr<graphics::SpriteBatch>& batch,
                       const Affine2& transform, Color4 tint) override;
     
+    /**
+     * Returns true if this node has finite drawing bounds, storing them in bounds.
+     *
+     * The text of a label is confined to its content bounds. However, the
+     * drop shadow (if any) is offset from the text and may be blurred, so
+     * the drawing bounds include the shadow as well.
+     *
+     * @param bounds    The rectangle to store the drawing bounds
+     *
+     * @return true if this node has finite drawing bounds
+     */
+    virtual bool getDrawBounds(Rect& bounds) override;
+    
 protected:
     /**
      * Allocates the render data necessary to render this node.
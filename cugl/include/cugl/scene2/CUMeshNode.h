@@ -622,6 +622,9 @@ public:
      * color, texture coordinates, or gradient coordinates. If there is
      * not vertex as that index, this method returns nullptr.
      *
+     * As the vertex may be moved, this method marks the cached culling
+     * bounds of this node as dirty.
+     *
      * @param index The sprite index
      *
      * @return a pointer to the sprite vertex as the given index
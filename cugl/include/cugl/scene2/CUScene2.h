@@ -93,6 +93,19 @@ protected:
     /** The destination factor for the blend function */
     GLenum _dstFactor;
     
+    /** Whether to cull nodes outside of the camera view */
+    bool _culling;
+    /** Whether the scene is currently rendering (so the view is valid) */
+    bool _viewing;
+    /** The world space bounds of the camera view for the current render */
+    Rect _viewbounds;
+    /** The number of nodes tested during the last render */
+    size_t _visited;
+    /** The number of subtrees culled during the last render */
+    size_t _culled;
+    /** The number of nodes drawn during the last render */
+    size_t _drawn;
+    
 #pragma mark -
 #pragma mark Constructors
 public:
@@ -565,6 +578,75 @@ public:
      */
     virtual void render() override;
     
+#pragma mark -
+#pragma mark Culling
+    /**
+     * Returns true if this scene culls nodes outside of the camera view.
+     *
+     * When culling is active, any node whose subtree bounds (as defined by
+     * {@link SceneNode#getSubtreeBounds}) do not intersect the camera view
+     * is skipped during rendering, together with all of its descendants.
+     * Culling is active by default.
+     *
+     * @return true if this scene culls nodes outside of the camera view.
+     */
+    bool isCulling() const { return _culling; }
+    
+    /**
+     * Sets whether this scene culls nodes outside of the camera view.
+     *
+     * When culling is active, any node whose subtree bounds (as defined by
+     * {@link SceneNode#getSubtreeBounds}) do not intersect the camera view
+     * is skipped during rendering, together with all of its descendants.
+     * Culling is active by default.
+     *
+     * @param value Whether this scene culls nodes outside of the camera view.
+     */
+    void setCulling(bool value) { _culling = value; }
+
+    /**
+     * Returns the number of nodes tested during the last render.
+     *
+     * This includes every visible node reached by the traversal, whether
+     * or not it was culled.
+     *
+     * @return the number of nodes tested during the last render.
+     */
+    size_t getVisitedCount() const { return _visited; }
+
+    /**
+     * Returns the number of subtrees culled during the last render.
+     *
+     * Each culled node counts once, even though none of its descendants
+     * are visited.
+     *
+     * @return the number of subtrees culled during the last render.
+     */
+    size_t getCulledCount() const { return _culled; }
+
+    /**
+     * Returns the number of nodes drawn during the last render.
+     *
+     * @return the number of nodes drawn during the last render.
+     */
+    size_t getDrawnCount() const { return _drawn; }
+    
+protected:
+    /**
+     * Prepares the camera view and statistics for culling.
+     *
+     * This method must be called at the start of any override of
+     * {@link #render}. It should be paired with a call to {@link #endCulling}.
+     */
+    void beginCulling();
+    
+    /**
+     * Completes the culling for the current render pass.
+     *
+     * Nodes rendered outside of a render pass are never culled.
+     */
+    void endCulling() { _viewing = false; }
+    
 private:
 #pragma mark -
 #pragma mark Internal Helpers
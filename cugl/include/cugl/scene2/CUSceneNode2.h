@@ -175,6 +175,27 @@ protected:
      */
     Affine2  _combined;
     
+    /**
+     * The cached node to world transform.
+     *
+     * This is the local transform multiplied by the transform of the parent
+     * at the last render. It is only recomputed if the local transform is
+     * dirty, or if the parent transform has changed. A change to the parent
+     * is detected by its version when the parent passes its own cached
+     * transform, and by an exact comparison otherwise.
+     */
+    Affine2  _worldmat;
+    /** The custom parent transform used to compute the cached world transform */
+    Affine2  _worldbase;
+    /** Whether the local transform changed since the world transform was cached */
+    bool _worlddirty;
+    /** Whether the cached world transform was computed from the parent cache */
+    bool _worldlinked;
+    /** The parent transform version used to compute the cached world transform */
+    Uint32 _worldsource;
+    /** A counter that changes whenever the cached world transform changes */
+    Uint32 _worldversion;
+    
     /** The array of children nodes */
     std::vector<std::shared_ptr<SceneNode>> _children;
 
@@ -221,6 +242,25 @@ protected:
     /** The defining JSON data for this node (if any) */
     std::shared_ptr<JsonValue> _json;
     
+    /**
+     * The cached bounds of this node and all of its descendants.
+     *
+     * These bounds are in node space, so they remain valid when an ancestor
+     * moves. They are only recomputed when this node changes its contents or
+     * a descendant changes its contents or transform.
+     */
+    Rect _cullbounds;
+    /** Whether the cached bounds are finite (false if anything is unbounded) */
+    bool _cullbounded;
+    /** Whether the cached bounds must be recomputed */
+    bool _culldirty;
+    /** The cached world space bounds of this node and all of its descendants */
+    Rect _cullworld;
+    /** The world transform version used to compute the world space bounds */
+    Uint32 _cullversion;
+    /** Whether the node space bounds changed since the world bounds were cached */
+    bool _cullstale;
+
 
 #pragma mark -
 #pragma mark Constructors
@@ -1240,6 +1280,7 @@ public:
      * @param scale the uniform scaling factor.
      */
     void setScale(float scale) {
+        if (_scale.x == scale && _scale.y == scale) return;
         _scale.set(scale,scale);
         if (!_useTransform) updateTransform();
     }
@@ -1255,6 +1296,7 @@ public:
      * @param vec   the non-uniform scaling factor.
      */
     void setScale(const Vec2 vec) {
+        if (_scale == vec) return;
         _scale = vec;
         if (!_useTransform) updateTransform();
     }
@@ -1271,6 +1313,7 @@ public:
      * @param sy    the y-axis scaling factor.
      */
     void setScale(float sx, float sy) {
+        if (_scale.x == sx && _scale.y == sy) return;
         _scale.set(sx,sy);
         if (!_useTransform) updateTransform();
     }
@@ -1296,6 +1339,7 @@ public:
      * @param angle the rotation angle of this node.
      */
     void setAngle(float angle) {
+        if (_angle == angle) return;
         _angle = angle;
         if (!_useTransform) updateTransform();
     }
@@ -1428,6 +1472,33 @@ public:
         return getNodeToWorldTransform().getInverse();
     }
     
+    /**
+     * Returns the node to world transform used at the last render.
+     *
+     * This value is cached during rendering, and is only recomputed when
+     * the local transform of this node or the transform passed down by its
+     * parent changes. Unlike {@link #getNodeToWorldTransform}, it includes
+     * any transform applied by the parent to its children (such as the
+     * pane transform of a {@link ScrollPane}). It is undefined if this node
+     * has never been rendered.
+     *
+     * @return the node to world transform used at the last render.
+     */
+    const Affine2& getRenderTransform() const { return _worldmat; }
+    
+    /**
+     * Returns the version of the cached render transform.
+     *
+     * This counter changes whenever {@link #getRenderTransform} changes,
+     * which happens when the local transform of this node or of any of its
+     * ancestors changes. Caches derived from the world position of this
+     * node (such as world space vertex data) can compare this value to a
+     * saved copy to determine if they need to be recomputed.
+     *
+     * @return the version of the cached render transform.
+     */
+    Uint32 getTransformVersion() const { return _worldversion; }
+    
     /**
      * Converts a screen position to node (local) space coordinates.
      *
@@ -1938,6 +2009,31 @@ public:
     virtual void draw(const std::shared_ptr<graphics::SpriteBatch>& batch, 
                       const Affine2& transform, Color4 tint) {}
     
+    /**
+     * Returns the node to world transform for the given parent transform.
+     *
+     * The result is the local transform of this node multiplied by the
+     * parent transform. It is cached, and is only recomputed when it is
+     * out of date. Changes to the local transform mark the cache as dirty.
+     * Changes above this node are propagated by version. If the transform
+     * is the cached render transform of the parent, the cache is valid as
+     * long as the parent version is the same as at the last call. So a
+     * clean node below a clean parent costs two comparisons, and a change
+     * to an ancestor reaches every descendant without walking the subtree.
+     * Any other transform (such as the root transform or the pane transform
+     * of a {@link ScrollPane}) is compared exactly to the one from the last
+     * call. The method {@link #getTransformVersion} is updated whenever the
+     * result changes.
+     *
+     * This method is called by {@link #render}. A subclass that renders its
+     * descendants in a custom order, like {@link OrderedNode}, should call it
+     * for each node that it visits.
+     *
+     * @param transform The parent transform
+     *
+     * @return the node to world transform for the given parent transform.
+     */
+    const Affine2& updateWorldTransform(const Affine2& transform);
     
 #pragma mark -
 #pragma mark Layout Automation
@@ -1979,6 +2075,90 @@ public:
      */
     virtual void doLayout();
 
+#pragma mark -
+#pragma mark Culling
+    /**
+     * Returns true if this node has finite drawing bounds, storing them in bounds.
+     *
+     * The bounds are in node space, and should contain everything drawn by
+     * {@link #draw}, but not the children of this node. They are used to
+     * skip any subtree that falls outside of the {@link Scene2} camera view.
+     * By default, they are the content bounds of this node. Any subclass that
+     * draws outside of its content bounds must override this method. If the
+     * drawing is not bounded, this method should return false, in which case
+     * neither this node nor any of its ancestors will be culled.
+     *
+     * A subclass that changes what it draws should call {@link #invalidateBounds}
+     * so that the cached bounds are recomputed.
+     *
+     * @param bounds    The rectangle to store the drawing bounds
+     *
+     * @return true if this node has finite drawing bounds
+     */
+    virtual bool getDrawBounds(Rect& bounds) {
+        bounds.set(Vec2::ZERO,_contentSize);
+        return true;
+    }
+    
+    /**
+     * Returns true if this subtree has finite bounds, storing them in bounds.
+     *
+     * The bounds are in node space, and contain the drawing bounds of this
+     * node and all of its descendants. This value is cached, and is only
+     * recomputed when the contents of this subtree change. It is unaffected
+     * by changes to the transforms of this node or its ancestors.
+     *
+     * @param bounds    The rectangle to store the subtree bounds
+     *
+     * @return true if this subtree has finite bounds
+     */
+    bool getSubtreeBounds(Rect& bounds);
+    
+    /**
+     * Returns true if this subtree is outside of the scene camera view.
+     *
+     * This method uses the transform computed by the last call to
+     * {@link #updateWorldTransform}, and so must be called after it. The
+     * world bounds of this subtree are cached against the transform version,
+     * so they are not recomputed for a static subtree. If this method returns
+     * false, the caller is expected to draw this node, and the rendering
+     * statistics of the {@link Scene2} are updated accordingly. No node is
+     * culled if it is not being rendered by a scene, or if that scene has
+     * culling disabled.
+     *
+     * This method is called by {@link #render}. A subclass that renders its
+     * descendants in a custom order should call it for each node that it
+     * visits, after {@link #updateWorldTransform}.
+     *
+     * @return true if this subtree is outside of the scene camera view.
+     */
+    bool cull();
+    
+protected:
+    /**
+     * Marks the cached bounds of this node and its ancestors as dirty.
+     *
+     * This method should be called whenever the drawing bounds of this node
+     * change. Changes to the content size and children of this node, as
+     * well as to the transforms of its children, are handled automatically.
+     */
+    void invalidateBounds();
+    
+    /**
+     * Returns true if this subtree has finite bounds, storing them in bounds.
+     *
+     * This method recomputes the value cached by {@link #getSubtreeBounds}.
+     * By default, it merges the drawing bounds of this node with the subtree
+     * bounds of each child, transformed into the coordinate space of this
+     * node. A subclass that transforms its children in a custom way must
+     * override this method.
+     *
+     * @param bounds    The rectangle to store the subtree bounds
+     *
+     * @return true if this subtree has finite bounds
+     */
+    virtual bool computeBounds(Rect& bounds);
+
 private:
 #pragma mark -
 #pragma mark Internal Helpers
@@ -1986,11 +2166,12 @@ private:
      * Sets the parent node.
      *
      * The purpose of this pointer is to climb back up the scene graph tree.
-     * No child asserts ownership of its parent.
+     * No child asserts ownership of its parent. Changing the parent marks
+     * the cached world transform as dirty.
      *
      * @param parent    A pointer to the parent node.
      */
-    void setParent(SceneNode* parent) { _parent = parent; }
+    void setParent(SceneNode* parent) { _parent = parent; _worlddirty = true; }
 
     /**
      * Sets the scene graph.
@@ -2023,7 +2204,7 @@ private:
     // Copying is only allowed via shared pointer.
     CU_DISALLOW_COPY_AND_ASSIGN(SceneNode);
     
-    // Tightly couple these two classes
+    // Tightly couple these classes
     friend class Scene2;
 };
     }
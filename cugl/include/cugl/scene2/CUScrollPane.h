@@ -924,6 +924,22 @@ public:
     virtual void render(const std::shared_ptr<graphics::SpriteBatch>& batch) override {
         render(batch,Affine2::IDENTITY,Color4::WHITE);
     }
+
+#pragma mark -
+#pragma mark Culling
+protected:
+    /**
+     * Returns true if this subtree has finite bounds, storing them in bounds.
+     *
+     * The children of a scroll pane are transformed by the pane transform.
+     * If the pane is masked, then the children are clipped to the mask, and
+     * so the mask bounds the entire subtree.
+     *
+     * @param bounds    The rectangle to store the subtree bounds
+     *
+     * @return true if this subtree has finite bounds
+     */
+    virtual bool computeBounds(Rect& bounds) override;
 };
     }
 }
@@ -608,6 +608,19 @@ public:
      */
     void refresh() { clearRenderData(); generateRenderData(); }
 
+    /**
+     * Returns true if this node has finite drawing bounds, storing them in bounds.
+     *
+     * The drawing bounds of a textured node are the bounds of its mesh,
+     * merged with the content bounds. As the mesh may extend past the
+     * content bounds (such as with a path stroke or a fringe), this method
+     * will generate the render data if it is not already present.
+     *
+     * @param bounds    The rectangle to store the drawing bounds
+     *
+     * @return true if this node has finite drawing bounds
+     */
+    virtual bool getDrawBounds(Rect& bounds) override;
     
 protected:
     /**
@@ -305,6 +305,7 @@ public:
      */
     void setSpriteMesh(const std::shared_ptr<graphics::SpriteMesh>& mesh) {
         _mesh = mesh;
+        invalidateBounds();
     }
 
     /**
@@ -405,6 +406,22 @@ public:
      */
     Vec2 getTextureOffset() const { return _texoffset; }
     
+#pragma mark Culling
+    /**
+     * Returns true if this node has a bounding box, storing it in lower and upper.
+     *
+     * Billboards always face the camera, so the sprite mesh may be drawn in
+     * any orientation about the node origin. Therefore the bounding box is
+     * the cube containing the sphere swept out by the sprite mesh. A node
+     * with no sprite mesh has no bounding box.
+     *
+     * @param lower The minimum corner of the bounding box
+     * @param upper The maximum corner of the bounding box
+     *
+     * @return true if this node has a bounding box
+     */
+    virtual bool getBoundingBox(Vec3& lower, Vec3& upper) const override;
+    
 };
     }
 }
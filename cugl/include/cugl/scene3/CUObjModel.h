@@ -189,8 +189,6 @@ public:
     std::vector<VertexInfo> vertices;
     /** The render group shape represented as indexed vertices */
     std::vector<GLuint> indices;
-    /** A vertex cache to eliminate redundancy */
-    std::unordered_map<VertexInfo,GLuint,VertexHasher> vertCache;
     
     /**
      * Creates an unintialized GroupInfo with default values
@@ -327,6 +325,10 @@ private:
     
     /** The mesh for storing the drawing data */
     graphics::Mesh<OBJVertex> _mesh;
+    /** The minimum corner of the mesh bounding box */
+    cugl::Vec3 _lower;
+    /** The maximum corner of the mesh bounding box */
+    cugl::Vec3 _upper;
     /** A vertex buffer to receive our triangle */
     std::shared_ptr<graphics::VertexBuffer> _vertbuff;
     /** The material for this shape */
@@ -501,6 +503,28 @@ public:
      */
     const graphics::Mesh<OBJVertex>& getMesh() const { return _mesh; }
     
+    /**
+     * Returns the minimum corner of the mesh bounding box.
+     *
+     * The bounding box is axis-aligned in model coordinates, and is computed
+     * once when the mesh is initialized. A mesh with no vertices has a
+     * degenerate box at the origin.
+     *
+     * @return the minimum corner of the mesh bounding box.
+     */
+    const cugl::Vec3& getMinCorner() const { return _lower; }
+
+    /**
+     * Returns the maximum corner of the mesh bounding box.
+     *
+     * The bounding box is axis-aligned in model coordinates, and is computed
+     * once when the mesh is initialized. A mesh with no vertices has a
+     * degenerate box at the origin.
+     *
+     * @return the maximum corner of the mesh bounding box.
+     */
+    const cugl::Vec3& getMaxCorner() const { return _upper; }
+    
     /**
      * Returns the name of the material associated with this mesh.
      *
@@ -585,6 +609,17 @@ private:
     std::string _name;
     /** The meshes associated with this object */
     std::vector<std::shared_ptr<ObjMesh>> _meshes;
+    /** The minimum corner of the model bounding box */
+    cugl::Vec3 _lower;
+    /** The maximum corner of the model bounding box */
+    cugl::Vec3 _upper;
+    
+    /**
+     * Recomputes the model bounding box from the meshes.
+     *
+     * This method should be called any time the set of meshes changes.
+     */
+    void computeBounds();
     
 public:
 #pragma mark Constructors
@@ -683,6 +718,26 @@ public:
         return _meshes;
     }
     
+    /**
+     * Returns the minimum corner of the model bounding box.
+     *
+     * The bounding box is axis-aligned in model coordinates. It is the union
+     * of the bounding boxes of all of the meshes.
+     *
+     * @return the minimum corner of the model bounding box.
+     */
+    const cugl::Vec3& getMinCorner() const { return _lower; }
+    
+    /**
+     * Returns the maximum corner of the model bounding box.
+     *
+     * The bounding box is axis-aligned in model coordinates. It is the union
+     * of the bounding boxes of all of the meshes.
+     *
+     * @return the maximum corner of the model bounding box.
+     */
+    const cugl::Vec3& getMaxCorner() const { return _upper; }
+    
     /**
      * Returns a submodel consisting of meshes that match the given tag.
      *
@@ -240,6 +240,7 @@ public:
      */
     void setModel(const std::shared_ptr<ObjModel>& model) {
         _model = model;
+        invalidateBounds();
     }
     
     /**
@@ -265,6 +266,20 @@ public:
     void setMaterial(const std::shared_ptr<Material>& material) {
         _material = material;
     }
+    
+#pragma mark Culling
+    /**
+     * Returns true if this node has a bounding box, storing it in lower and upper.
+     *
+     * The bounding box is the bounding box of the model, in node space. A
+     * node with no model has no bounding box.
+     *
+     * @param lower The minimum corner of the bounding box
+     * @param upper The maximum corner of the bounding box
+     *
+     * @return true if this node has a bounding box
+     */
+    virtual bool getBoundingBox(Vec3& lower, Vec3& upper) const override;
         
 };
     }
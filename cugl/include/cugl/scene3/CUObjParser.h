@@ -9,6 +9,11 @@
 //  clear that the files had a lot of back-and-forth in them that make inline
 //  parsing not so straight forward.
 //
+//  Files are read into memory with a single read and tokenized in place. The
+//  faces of each render group are indexed in parallel (when the parser has
+//  more than one thread). A parsed model can also be saved as a binary cache,
+//  which is recognized by its signature and loads without any text parsing.
+//
 //  Most users will never use these classes directly. Instead they are used
 //  internally by other classes in the cugl::obj package.
 //
@@ -42,8 +47,8 @@
 //
 //      3. This notice may not be removed or altered from any source distribution.
 //
-//  Author: Walker White
-//  Version: 7/3/24 (CUGL 3.0 reorganization)
+//  Author: agent
+//  Version: 10/17/26
 //
 #ifndef __OBJ_PARSER_H__
 #define __OBJ_PARSER_H__
@@ -58,9 +63,16 @@
 #include <cugl/scene3/CUMaterial.h>
 #include <cugl/scene3/CUObjModel.h>
 
+/** The file signature of a cached OBJ model */
+#define CU_OBJ_CACHE_MAGIC      "CUOB"
+/** The current version of the cached OBJ model format */
+#define CU_OBJ_CACHE_VERSION    1
 
 namespace cugl {
 
+// Forward references
+class ThreadPool;
+
     /**
      * The classes to construct a 3-d scene graph.
      *
@@ -92,6 +104,16 @@ namespace cugl {
  * Because OBJ data is spread over mutliple files, this parser is stateful.
  * That means it can expand the current {@link ModelInfo} data by reading
  * other files.
+ *
+ * Faces are not indexed as they are read. Instead, the parser records the
+ * face lines of each render group, and then indexes the groups at the end
+ * of the file. If the parser has more than one thread, the groups are split
+ * among the threads. The calling thread counts as one of the threads.
+ *
+ * Parsing large OBJ files is still slow compared to reading binary data.
+ * Therefore a parsed model can be saved with {@link #writeCache}. Any
+ * method that parses an OBJ file recognizes a cache file by its signature,
+ * so a cache can be used in place of the original OBJ file.
  */
 class ObjParser {
 public:
@@ -103,19 +125,42 @@ public:
     std::unordered_map<std::string,std::shared_ptr<MaterialLib>> materials;
     /** The information for previously parsed OBJ files */
     std::unordered_map<std::string,std::shared_ptr<ModelInfo>> models;
-    
+
+private:
+    /** A face, line, or point command recorded for a render group */
+    class ShapeLine {
+    public:
+        /** The index of the render group for this command */
+        size_t group;
+        /** The start of the command (in the file data) */
+        const char* begin;
+        /** The end of the command (in the file data) */
+        const char* end;
+    };
+    /** Internal class for removing duplicate vertices in a group */
+    class VertexTable;
+
+    /** The number of threads used to index the render groups */
+    Uint32 _threads;
+    /** The worker threads (one less than the thread count) */
+    std::shared_ptr<ThreadPool> _workers;
+    /** The shape commands of the current OBJ file (ordered by group) */
+    std::vector<ShapeLine> _shapes;
+
+public:
     /**
      * Creates a new OBJ parser.
      *
      * This is a fairly lightweight object. Therefore it is safe to use this
-     * constructor with new (though std::make_shared is prefered).
+     * constructor with new (though std::make_shared is prefered). The parser
+     * starts with a single thread.
      */
-    ObjParser() : debug(false) {}
+    ObjParser();
     
     /**
      * Deletes this OBJ parser, disposing all resource.
      */
-    ~ObjParser() { clear(); }
+    ~ObjParser();
     
     /**
      * Releases the data from all previously parsed files.
@@ -123,6 +168,26 @@ public:
      * This method has the same affect as {@link #clear}.
      */
     void dispose() { clear(); }
+
+    /**
+     * Returns the number of threads used to index the render groups
+     *
+     * The calling thread counts as one of the threads.
+     *
+     * @return the number of threads used to index the render groups
+     */
+    Uint32 getThreadCount() const { return _threads; }
+
+    /**
+     * Sets the number of threads used to index the render groups
+     *
+     * The calling thread counts as one of the threads, so a value of 1
+     * indexes all of the groups serially. Changing this value replaces
+     * the worker threads.
+     *
+     * @param threads   The number of threads used to index the render groups
+     */
+    void setThreadCount(Uint32 threads);
     
     /**
      * Returns the information for the given OBJ file.
@@ -286,8 +351,81 @@ public:
      * those methods return nullptr until a new file is parsed.
      */
     void clear();
-    
+
+    /**
+     * Writes the given model to a binary cache file.
+     *
+     * The cache stores the positions, texture coordinates, normals, and
+     * render groups of the model, together with the names of the imported
+     * MTL libraries. It does not store the libraries themselves. The cache
+     * can be read by any of the methods that parse an OBJ file, which
+     * recognize it by its signature.
+     *
+     * @param model The model to save
+     * @param file  The path to the cache file
+     *
+     * @return true if the cache was successfully written
+     */
+    static bool writeCache(const std::shared_ptr<ModelInfo>& model, const std::string file);
+
+    /**
+     * Returns true if the data begins with a cached OBJ model signature
+     *
+     * This is a quick test that does not validate the rest of the data.
+     *
+     * @param data  The data to test
+     * @param size  The number of bytes of data
+     *
+     * @return true if the data begins with a cached OBJ model signature
+     */
+    static bool isCache(const char* data, size_t size);
+
 private:
+    /**
+     * Reads the contents of the OBJ file into the given model.
+     *
+     * The render groups are indexed once the entire file is read.
+     *
+     * @param begin The start of the file data
+     * @param end   The end of the file data
+     * @param obj   The current ModelInfo results
+     */
+    void parseText(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj);
+
+    /**
+     * Reads a binary cache into the given model.
+     *
+     * This method returns false if the data is not a valid cache.
+     *
+     * @param begin The start of the file data
+     * @param end   The end of the file data
+     * @param obj   The current ModelInfo results
+     *
+     * @return true if the cache was successfully read
+     */
+    bool parseCache(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj);
+
+    /**
+     * Indexes the vertices of all render groups in the given model.
+     *
+     * This method processes the shape commands recorded while reading the
+     * OBJ file. The groups are split among the threads of this parser.
+     *
+     * @param obj   The current ModelInfo results
+     */
+    void buildGroups(const std::shared_ptr<ModelInfo>& obj);
+
+    /**
+     * Indexes the vertices of the given render group.
+     *
+     * @param group The render group to index
+     * @param begin The first shape command for this group
+     * @param end   The end of the shape commands for this group
+     * @param table The table for removing duplicate vertices
+     */
+    void buildGroup(GroupInfo* group, const ShapeLine* begin, const ShapeLine* end,
+                    VertexTable& table);
+
     /**
      * Processes a line representing an "o" command in an OBJ file.
      *
@@ -361,31 +499,18 @@ private:
     void processSmooth(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj);
     
     /**
-     * Processes a line representing an "f" command in an OBJ file.
-     *
-     * @param begin The start of the line
-     * @param end   The end of the line
-     * @param obj   The current ModelInfo results
-     */
-    void processFace(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj);
-    
-    /**
-     * Processes a line representing an "l" command in an OBJ file.
+     * Processes a line representing an "f", "l", or "p" command in an OBJ file.
      *
-     * @param begin The start of the line
-     * @param end   The end of the line
-     * @param obj   The current ModelInfo results
-     */
-    void processLine(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj);
-    
-    /**
-     * Processes a line representing a "p" command in an OBJ file.
+     * The line is recorded for the current render group, and is not indexed
+     * until {@link #buildGroups}.
      *
-     * @param begin The start of the line
-     * @param end   The end of the line
-     * @param obj   The current ModelInfo results
+     * @param begin     The start of the line
+     * @param end       The end of the line
+     * @param command   The drawing command for the line
+     * @param obj       The current ModelInfo results
      */
-    void processPoints(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj);
+    void processShape(const char* begin, const char* end, GLenum command,
+                      const std::shared_ptr<ModelInfo>& obj);
     
     /**
      * Processes a line representing a "material" command in a MTL file.
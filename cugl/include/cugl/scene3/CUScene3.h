@@ -78,6 +78,66 @@ class Scene3Pipeline;
  * order to preserve transparency and similar such affects.
  */
 class Scene3 {
+private:
+    /**
+     * A flattened scene graph node.
+     *
+     * The scene keeps a pre-order copy of the scene graph so that it can
+     * update world transforms and bounding boxes incrementally. Each entry
+     * knows the range of its subtree, so that a transform change can update
+     * the subtree without recursion.
+     */
+    class CullEntry {
+    public:
+        /** The scene graph node */
+        std::shared_ptr<SceneNode> node;
+        /** The global transform */
+        Mat4 world;
+        /** The minimum corner of the local bounding box */
+        Vec3 local0;
+        /** The maximum corner of the local bounding box */
+        Vec3 local1;
+        /** The minimum corner of the world bounding box */
+        Vec3 lower;
+        /** The maximum corner of the world bounding box */
+        Vec3 upper;
+        /** The entry of the parent node (-1 if a child of the scene) */
+        int parent;
+        /** The entry after the last descendant of this node */
+        Uint32 last;
+        /** The leaf volume containing this node (-1 if not bounded) */
+        int volume;
+        /** Whether this node has a bounding box */
+        bool bounded;
+        /** Whether this node survived culling in the last pass */
+        bool visible;
+    };
+    
+    /**
+     * A node in the bounding volume hierarchy.
+     *
+     * The hierarchy is stored in pre-order. The left child of an internal
+     * volume is the next volume, so only the right child is recorded. Every
+     * volume covers a contiguous range of the bounded entry order.
+     */
+    class CullVolume {
+    public:
+        /** The minimum corner of the bounding box */
+        Vec3 lower;
+        /** The maximum corner of the bounding box */
+        Vec3 upper;
+        /** The parent volume (-1 if root) */
+        int parent;
+        /** The right child volume (-1 if a leaf) */
+        int right;
+        /** The start of this volume in the bounded entry order */
+        Uint32 start;
+        /** The number of bounded entries in this volume */
+        Uint32 count;
+        /** Whether this volume must be refit to its contents */
+        bool dirty;
+    };
+
 #pragma mark Values
 protected:
     /** The name of this scene */
@@ -93,6 +153,36 @@ protected:
 
     /** Whether or note this scene is still active */
     bool _active;
+    /** Whether to cull nodes against the camera frustum */
+    bool _culling;
+
+private:
+    /** The flattened scene graph, in pre-order */
+    std::vector<CullEntry> _entries;
+    /** The bounding volume hierarchy over the bounded entries */
+    std::vector<CullVolume> _volumes;
+    /** The bounded entries, in the order of the volume hierarchy */
+    std::vector<Uint32> _order;
+    /** The entries whose transforms have changed since the last render */
+    std::vector<Uint32> _dirty;
+    /** A traversal stack for the volume hierarchy */
+    std::vector<Uint32> _stack;
+    /** The camera frustum for culling */
+    Frustum _frustum;
+    /** Whether the flattened scene graph must be rebuilt */
+    bool _restructure;
+    /** The (doubled) bounding box centers, used to build the hierarchy */
+    std::vector<Vec3> _centers;
+    /** The total surface area of the volume hierarchy */
+    float _area;
+    /** The total surface area of the volume hierarchy when it was built */
+    float _basearea;
+    /** The number of frustum tests in the last render pass */
+    size_t _tested;
+    /** The number of nodes culled in the last render pass */
+    size_t _culled;
+    /** The number of nodes submitted to the pipeline in the last render pass */
+    size_t _submitted;
 
 #pragma mark -
 #pragma mark Constructors
@@ -771,23 +861,153 @@ public:
      * Rendering happens by traversing the the scene graph using an "Pre-Order"
      * tree traversal algorithm ( https://en.wikipedia.org/wiki/Tree_traversal#Pre-order ).
      * That means that parents are always draw before children.
+     *
+     * The traversal is cached, so only the nodes whose transforms have changed
+     * since the last call have their world transforms recomputed. If culling is
+     * enabled, nodes outside of the camera frustum are not submitted.
      */
     virtual void render();
     
+#pragma mark -
+#pragma mark Culling
+    /**
+     * Returns true if this scene culls nodes against the camera frustum.
+     *
+     * When culling is enabled, any node with a bounding box (see
+     * {@link SceneNode#getBoundingBox}) that is completely outside of the
+     * camera frustum is not submitted to the pipeline. Nodes without a
+     * bounding box are always submitted. Culling is enabled by default.
+     *
+     * @return true if this scene culls nodes against the camera frustum.
+     */
+    bool isCulling() const { return _culling; }
+    
+    /**
+     * Sets whether this scene culls nodes against the camera frustum.
+     *
+     * When culling is enabled, any node with a bounding box (see
+     * {@link SceneNode#getBoundingBox}) that is completely outside of the
+     * camera frustum is not submitted to the pipeline. Nodes without a
+     * bounding box are always submitted. Culling is enabled by default.
+     *
+     * @param value Whether to cull nodes against the camera frustum.
+     */
+    void setCulling(bool value) { _culling = value; }
+    
+    /**
+     * Returns the number of frustum tests in the last call to {@link #render}.
+     *
+     * This includes the tests against the volume hierarchy as well as the
+     * tests against individual nodes. It is 0 if culling is disabled.
+     *
+     * @return the number of frustum tests in the last call to {@link #render}.
+     */
+    size_t getCullTests() const { return _tested; }
+    
+    /**
+     * Returns the number of nodes culled in the last call to {@link #render}.
+     *
+     * @return the number of nodes culled in the last call to {@link #render}.
+     */
+    size_t getCulledCount() const { return _culled; }
+    
+    /**
+     * Returns the number of nodes submitted in the last call to {@link #render}.
+     *
+     * This is the number of nodes passed to the {@link Scene3Pipeline}.
+     *
+     * @return the number of nodes submitted in the last call to {@link #render}.
+     */
+    size_t getSubmittedCount() const { return _submitted; }
+    
 private:
 #pragma mark -
 #pragma mark Internal Helpers
     /**
-     * Recursively adds the given scene graph node to the pipeline.
+     * Marks the flattened scene graph as out of date.
      *
-     * This method is uses to add nodes to the {@link Scene3Pipeline} by
-     * recursively traversing the tree.
+     * This method is called by a {@link SceneNode} whenever a node enters or
+     * leaves this scene, or when its bounding box changes. The flattened scene
+     * graph and volume hierarchy are rebuilt at the next call to {@link #render}.
+     */
+    void invalidateStructure() { _restructure = true; }
+    
+    /**
+     * Marks the transform of the given node as out of date.
+     *
+     * This method is called by a {@link SceneNode} whenever its model matrix
+     * changes. The world transforms of the node and its descendants are
+     * updated at the next call to {@link #render}.
+     *
+     * @param node  The node whose transform changed
+     */
+    void invalidateTransform(SceneNode* node) {
+        if (_restructure || node->_cullslot < 0) {
+            return;
+        } else if (_dirty.size() >= _entries.size()) {
+            // Do not let the queue grow without bound if we are not rendering
+            _restructure = true;
+            _dirty.clear();
+        } else {
+            _dirty.push_back(node->_cullslot);
+        }
+    }
+    
+    /**
+     * Rebuilds the flattened scene graph and the volume hierarchy.
+     */
+    void flatten();
+    
+    /**
+     * Recursively adds the given scene graph node to the flattened scene graph.
      *
      * @param node      The current node in the traversal.
-     * @param transform The global transformation matrix.
+     * @param parent    The entry of the parent node (-1 if a child of the scene)
+     */
+    void flatten(const std::shared_ptr<SceneNode>& node, int parent);
+    
+    /**
+     * Updates the world transform and bounding box for the given entry.
+     *
+     * This method assumes that the parent of this entry is up to date.
+     *
+     * @param slot  The entry to update
+     */
+    void refresh(Uint32 slot);
+    
+    /**
+     * Updates all entries whose transforms have changed since the last render.
+     *
+     * This method refits the volume hierarchy to the moved bounding boxes. If
+     * refitting has made the hierarchy too expensive to traverse, the hierarchy
+     * is rebuilt instead.
+     */
+    void refresh();
+    
+    /**
+     * Rebuilds the volume hierarchy from the current bounding boxes.
+     *
+     * This method does not change the flattened scene graph.
+     */
+    void rebuild();
+    
+    /**
+     * Recursively builds the volume hierarchy for a range of the entry order.
+     *
+     * @param start     The start of the range in the bounded entry order
+     * @param count     The number of bounded entries in the range
+     * @param parent    The parent volume (-1 if root)
+     *
+     * @return the index of the new volume
+     */
+    int build(Uint32 start, Uint32 count, int parent);
+    
+    /**
+     * Marks all entries outside of the camera frustum as not visible.
+     *
+     * This method updates the culling statistics.
      */
-    void traverse(const std::shared_ptr<SceneNode>& node,
-                  const Mat4& transform);
+    void cull();
     
     // Tightly couple with Node
     friend class SceneNode;
@@ -76,11 +76,16 @@ class Scene3Pipeline;
  * scene graph tree before drawing.
  *
  * Unlike the 2d scene graph nodes, we do not associate a bounding box (or
- * volume with the node). While that is important for UI layout code, it is
- * less important for 3d scene graphs. However, we do still have the concept
- * of the anchor. All transforms (scaling and rotation) are applied relative
- * to the anchor, not the node origin. But because there is no bounding box,
- * this anchor is specified as a point in node space, and not a percentage.
+ * volume with the node) for layout. While that is important for UI layout
+ * code, it is less important for 3d scene graphs. However, we do still have
+ * the concept of the anchor. All transforms (scaling and rotation) are applied
+ * relative to the anchor, not the node origin. But because there is no
+ * bounding box, this anchor is specified as a point in node space, and not a
+ * percentage.
+ *
+ * Subclasses that draw geometry may report a bounding box for culling via
+ * {@link #getBoundingBox}. The {@link Scene3} uses these boxes to skip nodes
+ * that are outside of the camera frustum.
  */
 class SceneNode {
 protected:
@@ -154,6 +159,8 @@ protected:
 
     /** The (current) child offset of this node (-1 if root) */
     int _childOffset;
+    /** The position of this node in the scene culling table (-1 if none) */
+    int _cullslot;
     
     /** The batch key */
     CUEnum _batchkey;
@@ -892,6 +899,39 @@ public:
         return getNodeToParentTransform().transform(nodePoint);
     }
     
+#pragma mark -
+#pragma mark Culling
+    /**
+     * Returns true if this node has a bounding box, storing it in lower and upper.
+     *
+     * The bounding box is axis-aligned in node (local) space, before the
+     * model matrix is applied. It only needs to contain what this node draws,
+     * and not the contents of its children. The {@link Scene3} uses this box
+     * to cull nodes outside of the camera frustum.
+     *
+     * A node without a bounding box is never culled. That is the default for
+     * the base class, which does not draw anything.
+     *
+     * @param lower The minimum corner of the bounding box
+     * @param upper The maximum corner of the bounding box
+     *
+     * @return true if this node has a bounding box
+     */
+    virtual bool getBoundingBox(Vec3& lower, Vec3& upper) const {
+        return false;
+    }
+    
+protected:
+    /**
+     * Notifies the scene that the bounding box of this node has changed.
+     *
+     * Subclasses should call this method whenever they change the geometry
+     * reported by {@link #getBoundingBox}. Transform changes are tracked
+     * automatically and do not need this call.
+     */
+    void invalidateBounds();
+
+public:
 #pragma mark -
 #pragma mark Scene Graph
     /**
@@ -1219,11 +1259,13 @@ private:
      * Sets the scene graph.
      *
      * The purpose of this pointer is to climb back up to the root of the
-     * scene graph tree. No node asserts ownership of its scene.
+     * scene graph tree. No node asserts ownership of its scene. Both the old
+     * and the new scene are notified so that they can rebuild their culling
+     * structures.
      *
      * @param scene    A pointer to the scene graph.
      */
-    void setScene(Scene3* scene) { _graph = scene; }
+    void setScene(Scene3* scene);
 
     /**
      * Recursively sets the scene graph for this node and all its children.
@@ -1239,7 +1281,8 @@ private:
      * Updates the model and normal matrices
      *
      * This transform is defined by scaling, rotation, and positional
-     * translation, in that order.
+     * translation, in that order. If this node is in a scene, the scene is
+     * notified so that it can update the world transform and culling bounds.
      */
     virtual void updateMatrices();
     
@@ -0,0 +1,188 @@
+"""
+Script to compile CUGL asset directories
+
+Parsing a large JSON asset directory at every startup is wasteful, since the
+directory rarely changes between runs. This script compiles a JSON asset
+directory into the binary format read by AssetDirectory. The AssetManager
+accepts the compiled file anywhere it accepts the JSON file, so a project can
+simply compile json/assets.json to json/assets.cuad and load that instead.
+
+The format must match CUAssetDirectory.cpp exactly. All integers are stored in
+network (big-endian) order. The file is the following sections, each aligned
+to 8 bytes:
+
+    header      'CUAD', version, #categories, #strings, #nodes, #string bytes
+    categories  (name id, node index) for each child of the root
+    strings     (offset, length) for each interned string
+    nodes       (type, pad[3], key id, payload) for each node in preorder
+    data        each interned string followed by a null terminator
+
+Usage: python assetdir.py assets.json assets.cuad
+
+Author: Walker White
+Date: July 3, 2024
+"""
+import json
+import struct
+import argparse
+
+
+# The file signature
+MAGIC = b'CUAD'
+# The format version (must match CU_ASSET_DIRECTORY_VERSION)
+VERSION = 1
+# The key id for a node without a key
+NO_KEY = 0xFFFFFFFF
+# The maximum container nesting (must match CU_ASSET_DIRECTORY_MAX_DEPTH)
+MAX_DEPTH = 256
+
+# The node types (must match JsonValue::Type)
+NULL_TYPE   = 0
+BOOL_TYPE   = 1
+NUMBER_TYPE = 2
+STRING_TYPE = 3
+ARRAY_TYPE  = 4
+OBJECT_TYPE = 5
+
+
+class Compiler(object):
+    """
+    This class flattens a JSON tree into records for a compiled directory.
+
+    Nodes are visited in preorder, and every key and string value is interned
+    the first time it is seen.
+    """
+
+    def __init__(self):
+        """
+        Creates an empty compiler
+        """
+        self.strings = []
+        self.ids = {}
+        self.nodes = []
+
+    def intern(self,value):
+        """
+        Returns the id of the given string, interning it if necessary
+
+        :param value: The string to intern
+        :type value:  ``str``
+
+        :return: the id of the given string
+        :rtype:  ``int``
+        """
+        if not value in self.ids:
+            self.ids[value] = len(self.strings)
+            self.strings.append(value.encode('utf-8'))
+        return self.ids[value]
+
+    def visit(self,value,key=None,depth=0):
+        """
+        Appends the records for the given subtree
+
+        Objects must be given as a list of key-value pairs, so that duplicate
+        keys are preserved (as they are in JsonValue).
+
+        :param value: The root of the subtree
+        :type value:  JSON value
+
+        :param key: The key of the subtree (None if not in an object)
+        :type key:  ``str``
+
+        :param depth: The number of non-empty containers above the subtree
+        :type depth:  ``int``
+        """
+        pos = len(self.nodes)
+        keyid = NO_KEY if key is None else self.intern(key)
+        self.nodes.append(None)
+        if value is None:
+            self.nodes[pos] = (NULL_TYPE,keyid,0)
+        elif type(value) == bool:
+            self.nodes[pos] = (BOOL_TYPE,keyid,1 if value else 0)
+        elif type(value) in (int,float):
+            bits = struct.unpack('>Q',struct.pack('>d',float(value)))[0]
+            self.nodes[pos] = (NUMBER_TYPE,keyid,bits)
+        elif type(value) == str:
+            self.nodes[pos] = (STRING_TYPE,keyid,self.intern(value))
+        elif len(value) > 0 and depth >= MAX_DEPTH:
+            raise ValueError('An asset directory may only nest %d containers' % MAX_DEPTH)
+        elif type(value) == ObjectPairs:
+            for (k,v) in value:
+                self.visit(v,k,depth+1)
+            total = len(self.nodes)-pos-1
+            self.nodes[pos] = (OBJECT_TYPE,keyid,(len(value) << 32) | total)
+        else:
+            for item in value:
+                self.visit(item,None,depth+1)
+            total = len(self.nodes)-pos-1
+            self.nodes[pos] = (ARRAY_TYPE,keyid,(len(value) << 32) | total)
+
+
+class ObjectPairs(list):
+    """
+    A JSON object as a list of key-value pairs
+    """
+    pass
+
+
+def compile_directory(text):
+    """
+    Returns the compiled form of the given JSON asset directory
+
+    :param text: The JSON asset directory
+    :type text:  ``str``
+
+    :return: the compiled form of the given JSON asset directory
+    :rtype:  ``bytes``
+    """
+    root = json.loads(text,object_pairs_hook=ObjectPairs)
+    if type(root) != ObjectPairs:
+        raise ValueError('An asset directory must be a JSON object')
+
+    compiler = Compiler()
+    compiler.visit(root)
+
+    categories = []
+    pos = 1
+    for ii in range(len(root)):
+        node = compiler.nodes[pos]
+        categories.append((node[1],pos))
+        pos += 1
+        if node[0] >= ARRAY_TYPE:
+            pos += node[2] & 0xFFFFFFFF
+
+    blob = b''.join(s+b'\0' for s in compiler.strings)
+    result = bytearray()
+    result += MAGIC
+    result += struct.pack('>5I',VERSION,len(categories),len(compiler.strings),
+                          len(compiler.nodes),len(blob))
+    for item in categories:
+        result += struct.pack('>2I',*item)
+    offset = 0
+    for s in compiler.strings:
+        result += struct.pack('>2I',offset,len(s))
+        offset += len(s)+1
+    for node in compiler.nodes:
+        result += struct.pack('>B3xIQ',*node)
+    result += blob
+    result += b'\0'*(-len(blob) % 8)
+    return bytes(result)
+
+
+def main():
+    """
+    Compiles the JSON asset directory given on the command line
+    """
+    parser = argparse.ArgumentParser(description='Compile a CUGL asset directory.')
+    parser.add_argument('input', type=str, help='the JSON asset directory')
+    parser.add_argument('output', type=str, help='the compiled asset directory')
+    args = parser.parse_args()
+
+    with open(args.input, encoding='utf-8') as file:
+        data = compile_directory(file.read())
+    with open(args.output, 'wb') as file:
+        file.write(data)
+
+
+if __name__ == '__main__':
+    main()
@@ -7,6 +7,11 @@
 //  the timeline. Actions can be added or removed at any time. We also support
 //  callback functions for monitoring the status of various actions.
 //
+//  The timeline stores the state of its actions in flat arrays, and recycles
+//  the storage of completed actions. Actions can be identified by a string
+//  key or by an integer handle. The handles are faster, as the string keys
+//  are just a lookup layer on top of them.
+//
 //  This class uses our standard shared-pointer architecture.
 //
 //  1. The constructor does not perform any initialization; it just sets all
@@ -43,169 +48,297 @@
 #include <cugl/core/actions/CUActionTimeline.h>
 #include <vector>
 
+using namespace cugl;
+
+/** The state of an action that is no longer active */
+#define STATE_INACTIVE  0xFF
+/** The easing id for an action with a custom easing function */
+#define EASING_CUSTOM   0xFF
+/** The number of easing types that can be evaluated in batches */
+#define EASING_BATCHES  ((Uint32)EasingFactory::Type::BOUNCE_IN_OUT+1)
+
+/** The bits of a handle that store the slot */
+#define HANDLE_SLOT(h)          ((Uint32)((h) & 0xFFFFFFFF))
+/** The bits of a handle that store the generation */
+#define HANDLE_GENERATION(h)    ((Uint32)((h) >> 32))
+/** Returns a handle for the given slot and generation */
+#define MAKE_HANDLE(s,g)        ((((Uint64)(g)) << 32) | (Uint64)(s))
+
+/** The easing functions (indexed by type) that can be evaluated in batches */
+static float (*const EASING_FUNCS[EASING_BATCHES])(float) = {
+    EasingFactory::linear,
+    EasingFactory::sineIn,      EasingFactory::sineOut,     EasingFactory::sineInOut,
+    EasingFactory::quadIn,      EasingFactory::quadOut,     EasingFactory::quadInOut,
+    EasingFactory::cubicIn,     EasingFactory::cubicOut,    EasingFactory::cubicInOut,
+    EasingFactory::quartIn,     EasingFactory::quartOut,    EasingFactory::quartInOut,
+    EasingFactory::quintIn,     EasingFactory::quintOut,    EasingFactory::quintInOut,
+    EasingFactory::expoIn,      EasingFactory::expoOut,     EasingFactory::expoInOut,
+    EasingFactory::circIn,      EasingFactory::circOut,     EasingFactory::circInOut,
+    EasingFactory::backIn,      EasingFactory::backOut,     EasingFactory::backInOut,
+    EasingFactory::bounceIn,    EasingFactory::bounceOut,   EasingFactory::bounceInOut
+};
 
-#pragma mark ActionInstance
-namespace cugl {
-    
 /**
- * This class is a wrapper for managing listener functions
+ * Returns the easing id for the given easing function
+ *
+ * If the function was allocated by {@link EasingFactory} (and is not elastic)
+ * this is its {@link EasingFactory::Type}. Otherwise it is EASING_CUSTOM.
+ *
+ * @param easing    The easing function
+ *
+ * @return the easing id for the given easing function
  */
-class ActionListenerWrapper {
-public:
-    ActionListener listener;
-    double time;
-    Uint32 key;
+static Uint8 easing_id(const EasingFunction& easing) {
+    if (easing == nullptr) {
+        return (Uint8)EasingFactory::Type::LINEAR;
+    }
+    auto ptr = easing.target<float(*)(float)>();
+    if (ptr != nullptr) {
+        for(Uint32 ii = 0; ii < EASING_BATCHES; ii++) {
+            if (*ptr == EASING_FUNCS[ii]) {
+                return (Uint8)ii;
+            }
+        }
+    }
+    return EASING_CUSTOM;
+}
 
-    ActionListenerWrapper(const ActionListener func, double t) {
-        listener = func;
-        time = t;
-        key = 0;
+/**
+ * Disposes all of the resources used by this timeline.
+ *
+ * A disposed action manager can be safely reinitialized. Any animations
+ * owned by this action manager will immediately stop and be released.
+ */
+void ActionTimeline::dispose() {
+    _listeners.clear();
+    _actions.clear();
+    _elapsed.clear();
+    _duration.clear();
+    _easing.clear();
+    _state.clear();
+    _paused.clear();
+    _handles.clear();
+    _keys.clear();
+    _functions.clear();
+    _easings.clear();
+    _waiting.clear();
+    _slots.clear();
+    _generations.clear();
+    _freeslots.clear();
+    _normtime.clear();
+    _easeorder.clear();
+    _easetime.clear();
+    _easecount.clear();
+    _updating = false;
+    _removed = false;
+    _active = 0;
+}
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Returns the position of the action for the given handle
+ *
+ * If the handle does not refer to an active action, this method returns
+ * -1.
+ *
+ * @param handle    The action handle
+ *
+ * @return the position of the action for the given handle
+ */
+Sint64 ActionTimeline::locate(Uint64 handle) const {
+    Uint32 slot = HANDLE_SLOT(handle);
+    if (slot >= _generations.size() || _generations[slot] != HANDLE_GENERATION(handle)) {
+        return -1;
     }
+    Uint32 pos = _slots[slot];
+    return _state[pos] == STATE_INACTIVE ? -1 : (Sint64)pos;
+}
 
-    ActionListenerWrapper(const ActionListener func, double t, Uint32 k) {
-        listener = func;
-        time = t;
-        key = k;
+/**
+ * Returns the position of the action for the given key
+ *
+ * If the key does not refer to an active action, this method returns -1.
+ *
+ * @param key       The identifying key
+ *
+ * @return the position of the action for the given key
+ */
+Sint64 ActionTimeline::locate(const std::string& key) const {
+    auto it = _actions.find(key);
+    if (it == _actions.end()) {
+        return -1;
     }
-    
-    bool operator<(const ActionListenerWrapper& rhs) {
-        return time > rhs.time;
+    return locate(it->second);
+}
+
+/**
+ * Returns a handle for a newly attached action
+ *
+ * The action is appended to the flat arrays. It will be started at the
+ * next call to {@link #update}.
+ *
+ * @param key       The identifying key (or the empty string)
+ * @param action    The action to animate
+ * @param duration  The action duration
+ * @param easing    The easing (interpolation) function
+ *
+ * @return a handle for a newly attached action
+ */
+Uint64 ActionTimeline::attach(const std::string& key, ActionFunction action,
+                              float duration, EasingFunction easing) {
+    Uint32 slot;
+    if (_freeslots.empty()) {
+        slot = (Uint32)_slots.size();
+        _slots.push_back(0);
+        _generations.push_back(1);
+    } else {
+        slot = _freeslots.back();
+        _freeslots.pop_back();
     }
     
-};
+    Uint64 handle = MAKE_HANDLE(slot,_generations[slot]);
+    Uint8 ease = easing_id(easing);
+    _slots[slot] = (Uint32)_elapsed.size();
+    _elapsed.push_back(0.0);
+    _duration.push_back(duration);
+    _easing.push_back(ease);
+    _state.push_back((Uint8)ActionState::BEGIN);
+    _paused.push_back(0);
+    _handles.push_back(handle);
+    _keys.push_back(key);
+    _functions.push_back(action);
+    _easings.push_back(ease == EASING_CUSTOM ? easing : nullptr);
+    _waiting.emplace_back();
+    _active++;
+    if (!key.empty()) {
+        _actions.emplace(key,handle);
+    }
+    return handle;
+}
 
 /**
- * This is an opaque class representing an action being actively animated.
+ * Stops the action at the given position
+ *
+ * The action is marked inactive and its key is immediately available.
+ * Any listeners waiting on completion are invoked. The storage for this
+ * action is not recycled until {@link #compact} or {@link #erase}.
  *
- * The instance contains the state of an action including duration, elapsed
- * time, the interpolation function, and any other necessary state. This class
- * is only meant to be used by {@link ActionTimeline}, and not directly by the
- * user.
+ * @param pos   The action position
  */
-class ActionInstance {
-public:
-    /** The key for this instance  */
-    std::string key;
-    
-    /** The interpolation function for this action */
-    ActionFunction action;
-    
-    /** The easing function to allow non-linear behavior */
-    EasingFunction easing;
-    
-    ActionState state;
-    
-    /* The desired completion time of the action */
-    double duration;
-    
-    /** The execution time since initialization */
-    double elapsed;
-    
-    /** Whether or not this instance is currently paused */
-    bool  paused;
-    
-    /** The listeners ordered in reverse call order*/
-    std::vector<std::shared_ptr<ActionListenerWrapper>> listeners;
-    
-    /** A weak pointer to our parent */
-    ActionTimeline* parent;
-    
-public:
-    /**
-     * Creates a new degenerate ActionInstance on the stack.
-     *
-     * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
-     * the heap, use one of the static constructors instead.
-     */
-    ActionInstance() : duration(0.0f), elapsed(0.0f), paused(false) {
-        state = ActionState::BEGIN;
+void ActionTimeline::retire(size_t pos) {
+    _state[pos] = STATE_INACTIVE;
+    _active--;
+    if (!_keys[pos].empty()) {
+        _actions.erase(_keys[pos]);
     }
-    
-    /**
-     * Deletes this action instance, disposing all resources
-     */
-    ~ActionInstance() { }
-    
-    void start() {
-        action(elapsed,ActionState::BEGIN);
-        state = ActionState::UPDATE;
+    if (_waiting[pos].empty()) {
+        return;
     }
-    
-    void update(float dt) {
-        if (paused || state == ActionState::FINISH) {
-            return;
-        }
-        
-        float normtime = 1.0;
-        if (duration > 0) {
-            normtime = (elapsed+dt) / duration;
-            // Clamp to end
-            if (normtime > 1.0f) {
-                normtime = 1.0f;
-            }
-        } else {
-            normtime = 0.0f;
-        }
-        
-        if (easing) {
-            normtime = easing(normtime);
-        }
-        
-        if (state == ActionState::BEGIN) {
-            start();
-        }
-        
-        action(normtime,ActionState::UPDATE);
 
-        if (elapsed+dt >= duration) {
-            state = ActionState::FINISH;
-            action(elapsed+dt,ActionState::FINISH);
-        }
-        
-        // Update the time and invoke the listeners
-        elapsed += dt;
-        while (!listeners.empty() && listeners.back()->time <= elapsed) {
-            auto wrapper = listeners.back();
-            wrapper->listener(key,wrapper->time,elapsed);
-            parent->_listeners.erase(wrapper->key);
-            listeners.pop_back();
-        }
+    // Listeners may modify the timeline, so we cannot refer to the arrays
+    std::vector<Listener> listeners;
+    listeners.swap(_waiting[pos]);
+    std::string key = _keys[pos];
+    double duration = _duration[pos];
+    double elapsed  = _elapsed[pos];
+    for(auto it = listeners.begin(); it != listeners.end(); ++it) {
+        _listeners.erase(it->key);
     }
     
-    void stop() {
-        // Only call listeners registered for completion
-        while (!listeners.empty()) {
-            auto wrapper = listeners.back();
-            if (wrapper->time >= duration) {
-                wrapper->listener(key,wrapper->time,elapsed);
-            }
-            parent->_listeners.erase(wrapper->key);
-            listeners.pop_back();
+    // Only call listeners registered for completion
+    while (!listeners.empty()) {
+        Listener& item = listeners.back();
+        if (item.time >= duration) {
+            item.listener(key,item.time,elapsed);
         }
+        listeners.pop_back();
     }
-};
+}
 
-// Keep this from being a mouthful
-typedef std::unordered_map<std::string,std::shared_ptr<ActionInstance>> InstanceMap;
+/**
+ * Recycles the storage of the action at the given position
+ *
+ * The action is replaced by the last action in the flat arrays. This
+ * invalidates its handle.
+ *
+ * @param pos   The action position
+ */
+void ActionTimeline::erase(size_t pos) {
+    Uint32 slot = HANDLE_SLOT(_handles[pos]);
+    _generations[slot]++;
+    if (_generations[slot] == 0) {
+        _generations[slot] = 1;
+    }
+    _freeslots.push_back(slot);
 
+    size_t last = _elapsed.size()-1;
+    if (pos != last) {
+        _elapsed[pos]  = _elapsed[last];
+        _duration[pos] = _duration[last];
+        _easing[pos]   = _easing[last];
+        _state[pos]    = _state[last];
+        _paused[pos]   = _paused[last];
+        _handles[pos]  = _handles[last];
+        _keys[pos].swap(_keys[last]);
+        _functions[pos].swap(_functions[last]);
+        _easings[pos].swap(_easings[last]);
+        _waiting[pos].swap(_waiting[last]);
+        _slots[HANDLE_SLOT(_handles[pos])] = (Uint32)pos;
+    }
+    
+    _elapsed.pop_back();
+    _duration.pop_back();
+    _easing.pop_back();
+    _state.pop_back();
+    _paused.pop_back();
+    _handles.pop_back();
+    _keys.pop_back();
+    _functions.pop_back();
+    _easings.pop_back();
+    _waiting.pop_back();
 }
 
-
-using namespace cugl;
+/**
+ * Recycles the storage of all inactive actions
+ */
+void ActionTimeline::compact() {
+    for(size_t ii = _state.size(); ii > 0; ii--) {
+        if (_state[ii-1] == STATE_INACTIVE) {
+            erase(ii-1);
+        }
+    }
+    _removed = false;
+}
 
 /**
- * Disposes all of the resources used by this timeline.
+ * Adds a listener for the action at the given position
  *
- * A disposed action manager can be safely reinitialized. Any animations
- * owned by this action manager will immediately stop and be released.
+ * @param pos       The action position
+ * @param time      The invocation time
+ * @param listener  The listener to add
+ *
+ * @return a key identifying this listener
  */
-void ActionTimeline::dispose() {
-    _listeners.clear();
-    _actions.clear();
+Uint32 ActionTimeline::attachListener(size_t pos, double time, ActionListener listener) {
+    Uint32 lkey = nextKey++;
+    Listener item;
+    item.listener = listener;
+    item.time = time;
+    item.key = lkey;
+    
+    // Listeners are ordered in reverse call order
+    std::vector<Listener>& listeners = _waiting[pos];
+    auto it = listeners.begin();
+    while (it != listeners.end() && it->time > time) {
+        ++it;
+    }
+    listeners.insert(it,std::move(item));
+    
+    _listeners[lkey] = _handles[pos];
+    return lkey;
 }
 
-
-
 #pragma mark -
 #pragma mark Action Management
 /**
@@ -234,13 +367,7 @@ bool ActionTimeline::add(const std::string key, ActionFunction action,
         return false;
     }
     
-    auto instance = std::make_shared<ActionInstance>();
-    instance->key = key;
-    instance->action = action;
-    instance->easing = easing;
-    instance->duration = duration;
-    instance->parent = this;
-    _actions.emplace(key,instance);
+    attach(key, action, duration, easing);
     return true;
 }
 
@@ -280,16 +407,86 @@ bool ActionTimeline::add(const std::string key, const std::shared_ptr<Action>& a
         }
     };
     
-    auto instance = std::make_shared<ActionInstance>();
-    instance->key = key;
-    instance->action = func;
-    instance->easing = easing;
-    instance->duration = duration;
-    instance->parent = this;
-    _actions.emplace(key,instance);
+    attach(key, func, duration, easing);
     return true;
 }
 
+/**
+ * Adds an action with the given duration and easing function
+ *
+ * The action will be invoked at the next call to {@link #update}. The
+ * easing function allows for effects like bouncing or elasticity in the
+ * linear interpolation. If null, the animation will use the standard
+ * linear easing.
+ *
+ * The action is not assigned a key. Instead, this method returns a
+ * handle that identifies the action. The handle is never 0, and so this
+ * method returns 0 if the action could not be added.
+ *
+ * @param action    The action to animate
+ * @param duration  The action duration
+ * @param easing    The easing (interpolation) function
+ *
+ * @return a handle identifying the action (or 0 for failure)
+ */
+Uint64 ActionTimeline::add(ActionFunction action, float duration, EasingFunction easing) {
+    if (action == nullptr) {
+        return 0;
+    }
+    return attach(std::string(), action, duration, easing);
+}
+
+/**
+ * Adds an action with the given duration and easing function
+ *
+ * The action will be invoked at the next call to {@link #update}. The
+ * easing function allows for effects like bouncing or elasticity in the
+ * linear interpolation. If null, the animation will use the standard
+ * linear easing.
+ *
+ * The action is not assigned a key. Instead, this method returns a
+ * handle that identifies the action. The handle is never 0, and so this
+ * method returns 0 if the action could not be added.
+ *
+ * @param action    The action to animate
+ * @param duration  The action duration
+ * @param easing    The easing (interpolation) function
+ *
+ * @return a handle identifying the action (or 0 for failure)
+ */
+Uint64 ActionTimeline::add(const std::shared_ptr<Action>& action, float duration,
+                           EasingFunction easing) {
+    if (action == nullptr) {
+        return 0;
+    }
+    
+    auto func = [=](float t, ActionState state) {
+        if (state == ActionState::BEGIN) {
+            action->start(t);
+        } else if (state == ActionState::FINISH) {
+            action->stop(t);
+        } else {
+            action->set(t);
+        }
+    };
+    return attach(std::string(), func, duration, easing);
+}
+
+/**
+ * Returns the handle for the action with the given key.
+ *
+ * If there is no action for the given key (e.g. the animation is
+ * complete) this method will return 0.
+ *
+ * @param key       The identifying key
+ *
+ * @return the handle for the action with the given key.
+ */
+Uint64 ActionTimeline::getHandle(const std::string key) const {
+    auto it = _actions.find(key);
+    return it == _actions.end() ? 0 : it->second;
+}
+
 /**
  * Removes the animation for the given key.
  *
@@ -304,15 +501,41 @@ bool ActionTimeline::add(const std::string key, const std::shared_ptr<Action>& a
  * @return true if the animation was successfully removed
  */
 bool ActionTimeline::remove(std::string key) {
-    auto action = _actions.find(key);
-    if (action == _actions.end()) {
+    auto it = _actions.find(key);
+    if (it == _actions.end()) {
+        return false;
+    }
+    return remove(it->second);
+}
+
+/**
+ * Removes the action for the given handle.
+ *
+ * This method will immediately stop the animation. In particular, it will
+ * invoke any listeners waiting on completion.
+ *
+ * If there is no animation for the give handle (e.g. the animation is
+ * complete) this method will return false.
+ *
+ * @param handle    The action handle
+ *
+ * @return true if the animation was successfully removed
+ */
+bool ActionTimeline::remove(Uint64 handle) {
+    Sint64 pos = locate(handle);
+    if (pos < 0) {
         return false;
     }
-    auto instance = action->second;
-    instance->stop();
     
-    action->second = nullptr;
-    _actions.erase(action);
+    retire((size_t)pos);
+    
+    // An update may still refer to this position
+    if (_updating) {
+        _removed = true;
+    } else {
+        // The listeners may have moved the action
+        erase(_slots[HANDLE_SLOT(handle)]);
+    }
     return true;
 }
 
@@ -326,20 +549,122 @@ bool ActionTimeline::remove(std::string key) {
  * @param dt    The number of seconds to animate
  */
 void ActionTimeline::update(float dt) {
-    auto completed = std::vector<InstanceMap::iterator>();
-    for(auto it = _actions.begin(); it != _actions.end(); ++it) {
-        auto instance = it->second;
-        instance->update(dt);
-        if (instance->state == ActionState::FINISH) {
-            completed.push_back(it);
+    // Actions added during this update start at the next one
+    size_t count = _elapsed.size();
+    if (count == 0) {
+        return;
+    }
+    _updating = true;
+    
+    // Compute the normalized time of each action
+    _normtime.resize(count);
+    _easecount.assign(EASING_BATCHES+1,0);
+    for(size_t ii = 0; ii < count; ii++) {
+        float normtime = 0.0f;
+        if (_duration[ii] > 0) {
+            normtime = (float)((_elapsed[ii]+dt) / _duration[ii]);
+            // Clamp to end
+            if (normtime > 1.0f) {
+                normtime = 1.0f;
+            }
+        }
+        _normtime[ii] = normtime;
+        
+        Uint8 ease = _easing[ii];
+        if (_paused[ii] || _state[ii] == STATE_INACTIVE) {
+            continue;
+        } else if (ease == EASING_CUSTOM) {
+            _normtime[ii] = _easings[ii](normtime);
+        } else if (ease != (Uint8)EasingFactory::Type::LINEAR) {
+            _easecount[ease+1]++;
         }
     }
     
-    for (auto it = completed.begin(); it != completed.end(); ++it) {
-        auto instance = (*it)->second;
-        instance->stop();
-        (*it)->second = nullptr;
-        _actions.erase(*it);
+    // Apply the easing functions in batches (counting sort by type)
+    for(Uint32 ii = 1; ii <= EASING_BATCHES; ii++) {
+        _easecount[ii] += _easecount[ii-1];
+    }
+    size_t batched = _easecount[EASING_BATCHES];
+    if (batched > 0) {
+        _easeorder.resize(batched);
+        _easetime.resize(batched);
+        for(size_t ii = 0; ii < count; ii++) {
+            Uint8 ease = _easing[ii];
+            if (_paused[ii] || _state[ii] == STATE_INACTIVE ||
+                ease == EASING_CUSTOM || ease == (Uint8)EasingFactory::Type::LINEAR) {
+                continue;
+            }
+            Uint32 pos = _easecount[ease]++;
+            _easeorder[pos] = (Uint32)ii;
+            _easetime[pos]  = _normtime[ii];
+        }
+        
+        // The counts are now the end of each type
+        Uint32 start = 0;
+        for(Uint32 ii = 0; ii < EASING_BATCHES; ii++) {
+            Uint32 end = _easecount[ii];
+            if (end > start) {
+                EasingFactory::evaluate((EasingFactory::Type)ii, _easetime.data()+start, end-start);
+            }
+            start = end;
+        }
+        for(size_t ii = 0; ii < batched; ii++) {
+            _normtime[_easeorder[ii]] = _easetime[ii];
+        }
+    }
+    
+    // Invoke the actions. Callbacks may modify the timeline, so we index
+    // the arrays each time instead of holding references.
+    for(size_t ii = 0; ii < count; ii++) {
+        if (_paused[ii] || _state[ii] == STATE_INACTIVE) {
+            continue;
+        }
+        
+        // Deque elements are stable even if callbacks add actions
+        ActionFunction& action = _functions[ii];
+        if (_state[ii] == (Uint8)ActionState::BEGIN) {
+            action((float)_elapsed[ii],ActionState::BEGIN);
+            if (_state[ii] == STATE_INACTIVE) {
+                continue;
+            }
+            _state[ii] = (Uint8)ActionState::UPDATE;
+        }
+        
+        action(_normtime[ii],ActionState::UPDATE);
+        if (_state[ii] == STATE_INACTIVE) {
+            continue;
+        }
+        
+        double elapsed = _elapsed[ii]+dt;
+        if (elapsed >= _duration[ii]) {
+            _state[ii] = (Uint8)ActionState::FINISH;
+            action((float)elapsed,ActionState::FINISH);
+            if (_state[ii] == STATE_INACTIVE) {
+                continue;
+            }
+        }
+        
+        // Update the time and invoke the listeners
+        _elapsed[ii] = elapsed;
+        while (_state[ii] != STATE_INACTIVE && !_waiting[ii].empty() &&
+               _waiting[ii].back().time <= elapsed) {
+            Listener item = std::move(_waiting[ii].back());
+            _waiting[ii].pop_back();
+            _listeners.erase(item.key);
+            item.listener(_keys[ii],item.time,elapsed);
+        }
+    }
+    
+    for(size_t ii = 0; ii < count; ii++) {
+        if (_state[ii] == (Uint8)ActionState::FINISH) {
+            retire(ii);
+            _removed = true;
+        }
+    }
+    
+    _updating = false;
+    if (_removed) {
+        compact();
     }
 }
 
@@ -351,8 +676,20 @@ void ActionTimeline::update(float dt) {
  * @return true if the given key represents an active animation
  */
 bool ActionTimeline::isActive(std::string key) const {
-    auto action = _actions.find(key);
-    return (action != _actions.end());
+    return locate(key) >= 0;
+}
+
+/**
+ * Returns true if the given handle represents an active action
+ *
+ * Note that paused actions are still active, even though they are paused.
+ *
+ * @param handle    The action handle
+ *
+ * @return true if the given handle represents an active action
+ */
+bool ActionTimeline::isActive(Uint64 handle) const {
+    return locate(handle) >= 0;
 }
 
 #pragma mark -
@@ -379,31 +716,43 @@ bool ActionTimeline::isActive(std::string key) const {
  * @return a key identifying this listener (or 0 for failure)
  */
 Uint32 ActionTimeline::addListener(const std::string key, float time, ActionListener listener) {
-    auto jt = _actions.find(key);
-    if (jt == _actions.end()) {
+    Sint64 pos = locate(key);
+    if (pos < 0) {
         return 0;
     }
-    auto instance = jt->second;
-    
-    Uint32 lkey = nextKey++;
-    auto wrapper = std::make_shared<ActionListenerWrapper>(listener, time, lkey);
+    return attachListener((size_t)pos, time, listener);
+}
 
-    bool placed = false;
-    for(auto it = instance->listeners.begin(); !placed && it != instance->listeners.end(); ++it ) {
-        if ((*it)->time <= wrapper->time) {
-            instance->listeners.insert(it,wrapper);
-            placed = true;
-        }
-    }
-    
-    if (!placed) {
-        instance->listeners.push_back(wrapper);
+/**
+ * Adds a listener for the specified action at the given time.
+ *
+ * This listener will be invoked when the timeline first passes the given
+ * time for the specified object. Due to framerate imprecision, the actual
+ * time the listener is invoked may be slightly greater than the time
+ * requested.
+ *
+ * If time is greater than or equal to the duration of action, this listener
+ * will be invoked once the action is completed. If it is less than or equal
+ * to 0, it will be invoked once the action is started. If the action does
+ * not have a key, the listener is passed the empty string.
+ *
+ * If there is no action for the given handle, this method will return 0,
+ * indicating failure.
+ *
+ * @param handle    The action handle
+ * @param time      The invocation time
+ * @param listener  The listener to add
+ *
+ * @return a key identifying this listener (or 0 for failure)
+ */
+Uint32 ActionTimeline::addListener(Uint64 handle, float time, ActionListener listener) {
+    Sint64 pos = locate(handle);
+    if (pos < 0) {
+        return 0;
     }
-
-    _listeners[lkey] = instance;
-    return lkey;
+    return attachListener((size_t)pos, time, listener);
 }
-        
+
 /**
  * Adds a listener for  action completion.
  *
@@ -420,29 +769,34 @@ Uint32 ActionTimeline::addListener(const std::string key, float time, ActionList
  * @return a key identifying this listener (or 0 for failure)
  */
 Uint32 ActionTimeline::addCompletionListener(const std::string key, ActionListener listener) {
-    auto jt = _actions.find(key);
-    if (jt == _actions.end()) {
+    Sint64 pos = locate(key);
+    if (pos < 0) {
         return 0;
     }
-    auto instance = jt->second;
-    
-    Uint32 lkey = nextKey++;
-    auto wrapper = std::make_shared<ActionListenerWrapper>(listener, instance->duration, lkey);
-    
-    bool placed = false;
-    for(auto it = instance->listeners.begin(); !placed && it != instance->listeners.end(); ++it ) {
-        if ((*it)->time <= wrapper->time) {
-            instance->listeners.insert(it,wrapper);
-            placed = true;
-        }
-    }
-    
-    if (!placed) {
-        instance->listeners.push_back(wrapper);
+    return attachListener((size_t)pos, _duration[pos], listener);
+}
+
+/**
+ * Adds a listener for  action completion.
+ *
+ * This listener will be invoked when action is completed, just before it
+ * is removed from this timeline. This method is the same as calling
+ * {@link #addListener} with a time greater than the duration.
+ *
+ * If there is no action for the given handle, this method will return 0,
+ * indicating failure.
+ *
+ * @param handle    The action handle
+ * @param listener  The listener to add
+ *
+ * @return a key identifying this listener (or 0 for failure)
+ */
+Uint32 ActionTimeline::addCompletionListener(Uint64 handle, ActionListener listener) {
+    Sint64 pos = locate(handle);
+    if (pos < 0) {
+        return 0;
     }
-    
-    _listeners[lkey] = instance;
-    return lkey;
+    return attachListener((size_t)pos, _duration[pos], listener);
 }
 
 /**
@@ -457,18 +811,20 @@ Uint32 ActionTimeline::addCompletionListener(const std::string key, ActionListen
 const ActionListener ActionTimeline::getListener(Uint32 key) const {
     auto jt = _listeners.find(key);
     if (jt == _listeners.end()) {
-        return 0;
+        return nullptr;
+    }
+    Sint64 pos = locate(jt->second);
+    if (pos < 0) {
+        return nullptr;
     }
-    auto instance = jt->second;
     
-    std::shared_ptr<ActionListenerWrapper> wrapper = nullptr;
-    for(auto it = instance->listeners.begin(); wrapper == nullptr && it != instance->listeners.end(); ++it) {
-        if ((*it)->key == key) {
-            wrapper = *it;
+    const std::vector<Listener>& listeners = _waiting[pos];
+    for(auto it = listeners.begin(); it != listeners.end(); ++it) {
+        if (it->key == key) {
+            return it->listener;
         }
     }
-    
-    return wrapper == nullptr ? nullptr : wrapper->listener;
+    return nullptr;
 }
 
 /**
@@ -486,17 +842,19 @@ bool ActionTimeline::removeListener(Uint32 key) {
     if (jt == _listeners.end()) {
         return false;
     }
-    auto instance = jt->second;
+    Sint64 pos = locate(jt->second);
+    _listeners.erase(jt);
+    if (pos < 0) {
+        return true;
+    }
     
-    std::shared_ptr<ActionListenerWrapper> wrapper = nullptr;
-    for(auto it = instance->listeners.begin(); wrapper == nullptr && it != instance->listeners.end(); ++it) {
-        if ((*it)->key == key) {
-            wrapper = *it;
-            instance->listeners.erase(it);
+    std::vector<Listener>& listeners = _waiting[pos];
+    for(auto it = listeners.begin(); it != listeners.end(); ++it) {
+        if (it->key == key) {
+            listeners.erase(it);
+            break;
         }
     }
-    
-    _listeners.erase(key);
     return true;
 }
 
@@ -513,11 +871,23 @@ bool ActionTimeline::removeListener(Uint32 key) {
  * @return the elapsed time of the given action.
  */
 float ActionTimeline::getElapsed(const std::string key) const {
-    auto action = _actions.find(key);
-    if (action == _actions.end()) {
-        return false;
-    }
-    return action->second->elapsed;
+    Sint64 pos = locate(key);
+    return pos < 0 ? 0.0f : (float)_elapsed[pos];
+}
+
+/**
+ * Returns the elapsed time of the given action.
+ *
+ * If there is no animation for the give handle (e.g. the animation is
+ * complete) this method will return 0.
+ *
+ * @param handle    The action handle
+ *
+ * @return the elapsed time of the given action.
+ */
+float ActionTimeline::getElapsed(Uint64 handle) const {
+    Sint64 pos = locate(handle);
+    return pos < 0 ? 0.0f : (float)_elapsed[pos];
 }
 
 /**
@@ -531,11 +901,23 @@ float ActionTimeline::getElapsed(const std::string key) const {
  * @return true if the animation for the given key is paused
  */
 bool ActionTimeline::isPaused(std::string key) {
-    auto action = _actions.find(key);
-    if (action == _actions.end()) {
-        return false;
-    }
-    return action->second->paused;
+    Sint64 pos = locate(key);
+    return pos < 0 ? false : _paused[pos] != 0;
+}
+
+/**
+ * Returns true if the animation for the given handle is paused
+ *
+ * This method will return false if there is no active animation with the
+ * given handle.
+ *
+ * @param handle    The action handle
+ *
+ * @return true if the animation for the given handle is paused
+ */
+bool ActionTimeline::isPaused(Uint64 handle) const {
+    Sint64 pos = locate(handle);
+    return pos < 0 ? false : _paused[pos] != 0;
 }
 
 /**
@@ -547,11 +929,25 @@ bool ActionTimeline::isPaused(std::string key) {
  * @param key       The identifying key
  */
 void ActionTimeline::pause(std::string key) {
-    auto action = _actions.find(key);
-    if (action == _actions.end()) {
-        return;
+    Sint64 pos = locate(key);
+    if (pos >= 0) {
+        _paused[pos] = 1;
+    }
+}
+
+/**
+ * Pauses the animation for the given handle.
+ *
+ * If there is no active animation for the given handle, or if it is
+ * already paused, this method does nothing.
+ *
+ * @param handle    The action handle
+ */
+void ActionTimeline::pause(Uint64 handle) {
+    Sint64 pos = locate(handle);
+    if (pos >= 0) {
+        _paused[pos] = 1;
     }
-    action->second->paused = true;
 }
 
 /**
@@ -563,11 +959,23 @@ void ActionTimeline::pause(std::string key) {
  * @param key       The identifying key
  */
 void ActionTimeline::unpause(std::string key) {
-    auto action = _actions.find(key);
-    if (action == _actions.end()) {
-        return;
+    Sint64 pos = locate(key);
+    if (pos >= 0) {
+        _paused[pos] = 0;
     }
-    action->second->paused = false;
 }
 
-
+/**
+ * Unpauses the animation for the given handle.
+ *
+ * If there is no active animation for the given handle, or if it is not
+ * currently paused, this method does nothing.
+ *
+ * @param handle    The action handle
+ */
+void ActionTimeline::unpause(Uint64 handle) {
+    Sint64 pos = locate(handle);
+    if (pos >= 0) {
+        _paused[pos] = 0;
+    }
+}
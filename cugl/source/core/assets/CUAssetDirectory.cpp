@@ -0,0 +1,787 @@
+//
+//  CUAssetDirectory.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a compiled (binary) form of a JSON asset directory.
+//  Parsing a large asset directory at every startup is wasteful, since the
+//  directory rarely changes between runs. A compiled directory stores the
+//  same tree as fixed-size records with an interned string table, so that it
+//  can be read (or memory mapped) and converted to JsonValue nodes without
+//  any text parsing. The AssetManager accepts a compiled directory anywhere
+//  that it accepts a JSON directory, and the loaders see exactly the same
+//  JsonValue objects in either case.
+//
+//  Compiled directories are typically produced at build time, either with the
+//  method AssetDirectory#write or with the script scripts/assetdir.py. All
+//  integers in the file are stored in network order, so compiled directories
+//  are portable across platforms.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#include <cstring>
+#include <climits>
+#include <unordered_map>
+#include <cugl/core/assets/CUAssetDirectory.h>
+#include <cugl/core/assets/CUJsonValue.h>
+#include <cugl/core/io/CUJsonParser.h>
+#include <cugl/core/io/CUBinaryWriter.h>
+#include <cugl/core/util/CUEndian.h>
+#include <cugl/core/util/CUDebug.h>
+#include <cugl/core/util/CUFiletools.h>
+#include <cugl/core/CUApplication.h>
+
+using namespace cugl;
+
+/** The size of the file header in bytes */
+#define HEADER_SIZE     24
+/** The size of a category record in bytes */
+#define CATEGORY_SIZE   8
+/** The size of a string record in bytes */
+#define STRING_SIZE     8
+/** The size of a node record in bytes */
+#define NODE_SIZE       16
+/** The key id for a node without a key (array items and the root) */
+#define NO_KEY          0xFFFFFFFF
+
+#pragma mark -
+#pragma mark Encoding Helpers
+/**
+ * Returns the 32 bit integer at the given position, decoded from network order
+ *
+ * @param data  The position to read
+ *
+ * @return the 32 bit integer at the given position
+ */
+static Uint32 get32(const Uint8* data) {
+    Uint32 value;
+    std::memcpy(&value, data, sizeof(Uint32));
+    return marshall(value);
+}
+
+/**
+ * Returns the 64 bit integer at the given position, decoded from network order
+ *
+ * @param data  The position to read
+ *
+ * @return the 64 bit integer at the given position
+ */
+static Uint64 get64(const Uint8* data) {
+    Uint64 value;
+    std::memcpy(&value, data, sizeof(Uint64));
+    return marshall(value);
+}
+
+/**
+ * Stores the 32 bit integer at the given position, encoded in network order
+ *
+ * @param data  The position to write
+ * @param value The value to write
+ */
+static void put32(Uint8* data, Uint32 value) {
+    value = marshall(value);
+    std::memcpy(data, &value, sizeof(Uint32));
+}
+
+/**
+ * Stores the 64 bit integer at the given position, encoded in network order
+ *
+ * @param data  The position to write
+ * @param value The value to write
+ */
+static void put64(Uint8* data, Uint64 value) {
+    value = marshall(value);
+    std::memcpy(data, &value, sizeof(Uint64));
+}
+
+/**
+ * Returns the given size rounded up to a multiple of 8
+ *
+ * @param size  The size to round
+ *
+ * @return the given size rounded up to a multiple of 8
+ */
+static size_t align8(size_t size) {
+    return (size+7) & ~((size_t)7);
+}
+
+/**
+ * This class flattens a JSON tree into records for a compiled directory.
+ *
+ * Nodes are visited in preorder, and every key and string value is interned
+ * the first time it is seen.
+ */
+class DirectoryCompiler {
+public:
+    /** A node record before it is encoded */
+    struct Record {
+        /** The node type */
+        Uint8  type;
+        /** The string id of the node key (or NO_KEY) */
+        Uint32 key;
+        /** The node payload (value or child count and subtree size) */
+        Uint64 payload;
+    };
+
+    /** The interned strings in order of first use */
+    std::vector<const std::string*> strings;
+    /** The string id for each interned string */
+    std::unordered_map<std::string,Uint32> ids;
+    /** The node records in preorder */
+    std::vector<Record> nodes;
+    /** The total number of bytes of string data */
+    size_t blobsize = 0;
+
+    /**
+     * Returns the id of the given string, interning it if necessary
+     *
+     * @param value The string to intern
+     *
+     * @return the id of the given string
+     */
+    Uint32 intern(const std::string& value) {
+        auto result = ids.emplace(value,(Uint32)strings.size());
+        if (result.second) {
+            strings.push_back(&(result.first->first));
+            blobsize += value.size()+1;
+        }
+        return result.first->second;
+    }
+
+    /**
+     * Appends the records for the given subtree
+     *
+     * @param node  The root of the subtree
+     * @param keyed Whether the node is the child of an object
+     */
+    void visit(const JsonValue* node, bool keyed) {
+        size_t pos = nodes.size();
+        nodes.push_back(Record());
+        nodes[pos].type = (Uint8)node->type();
+        nodes[pos].key  = keyed ? intern(node->key()) : NO_KEY;
+        nodes[pos].payload = 0;
+
+        switch (node->type()) {
+            case JsonValue::Type::NullType:
+                break;
+            case JsonValue::Type::BoolType:
+                nodes[pos].payload = node->asBool() ? 1 : 0;
+                break;
+            case JsonValue::Type::NumberType:
+            {
+                double value = node->asDouble();
+                std::memcpy(&(nodes[pos].payload), &value, sizeof(double));
+            }
+                break;
+            case JsonValue::Type::StringType:
+                nodes[pos].payload = intern(node->_stringValue);
+                break;
+            case JsonValue::Type::ArrayType:
+            case JsonValue::Type::ObjectType:
+            {
+                bool object = node->isObject();
+                for(size_t ii = 0; ii < node->size(); ii++) {
+                    visit(node->_children[ii].get(), object);
+                }
+                Uint64 count = node->size();
+                Uint64 total = nodes.size()-pos-1;
+                nodes[pos].payload = (count << 32) | total;
+            }
+                break;
+        }
+    }
+};
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates an uninitialized asset directory.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+AssetDirectory::AssetDirectory() :
+_data(nullptr),
+_size(0),
+_categories(0),
+_strings(0),
+_nodes(0),
+_catOffset(0),
+_strOffset(0),
+_nodeOffset(0),
+_blobOffset(0) {
+}
+
+/**
+ * Disposes all of the resources used by this asset directory.
+ *
+ * A disposed directory can be safely reinitialized.
+ */
+void AssetDirectory::dispose() {
+    _buffer.clear();
+    _buffer.shrink_to_fit();
+    _data = nullptr;
+    _size = 0;
+    _categories = 0;
+    _strings = 0;
+    _nodes = 0;
+    _catOffset  = 0;
+    _strOffset  = 0;
+    _nodeOffset = 0;
+    _blobOffset = 0;
+}
+
+/**
+ * Initializes an asset directory by compiling the given JSON directory.
+ *
+ * The JSON value must be an object, whose children are the asset
+ * categories.
+ *
+ * @param json  The JSON asset directory
+ *
+ * @return true if initialization was successful.
+ */
+bool AssetDirectory::init(const std::shared_ptr<JsonValue>& json) {
+    CUAssertLog(_data == nullptr, "Asset directory is already initialized");
+    if (json == nullptr || !json->isObject()) {
+        CULogError("An asset directory must be a JSON object");
+        return false;
+    }
+
+    DirectoryCompiler compiler;
+    compiler.visit(json.get(), false);
+
+    // Each category is a child of the root
+    std::vector<std::pair<Uint32,Uint32>> categories;
+    categories.reserve(json->size());
+    Uint32 pos = 1;
+    for(size_t ii = 0; ii < json->size(); ii++) {
+        categories.push_back(std::make_pair(compiler.nodes[pos].key,pos));
+        pos++;
+        if (compiler.nodes[pos-1].type >= (Uint8)JsonValue::Type::ArrayType) {
+            pos += (Uint32)(compiler.nodes[pos-1].payload & 0xFFFFFFFF);
+        }
+    }
+
+    size_t total = HEADER_SIZE;
+    total += CATEGORY_SIZE*categories.size();
+    total += STRING_SIZE*compiler.strings.size();
+    total += NODE_SIZE*compiler.nodes.size();
+    total += align8(compiler.blobsize);
+    _buffer.assign(total,0);
+
+    Uint8* data = _buffer.data();
+    std::memcpy(data, CU_ASSET_DIRECTORY_MAGIC, 4);
+    put32(data+4,  CU_ASSET_DIRECTORY_VERSION);
+    put32(data+8,  (Uint32)categories.size());
+    put32(data+12, (Uint32)compiler.strings.size());
+    put32(data+16, (Uint32)compiler.nodes.size());
+    put32(data+20, (Uint32)compiler.blobsize);
+    data += HEADER_SIZE;
+
+    for(auto it = categories.begin(); it != categories.end(); ++it) {
+        put32(data,   it->first);
+        put32(data+4, it->second);
+        data += CATEGORY_SIZE;
+    }
+
+    Uint32 offset = 0;
+    for(auto it = compiler.strings.begin(); it != compiler.strings.end(); ++it) {
+        put32(data,   offset);
+        put32(data+4, (Uint32)(*it)->size());
+        offset += (Uint32)(*it)->size()+1;
+        data += STRING_SIZE;
+    }
+
+    for(auto it = compiler.nodes.begin(); it != compiler.nodes.end(); ++it) {
+        data[0] = it->type;
+        put32(data+4, it->key);
+        put64(data+8, it->payload);
+        data += NODE_SIZE;
+    }
+
+    for(auto it = compiler.strings.begin(); it != compiler.strings.end(); ++it) {
+        std::memcpy(data, (*it)->data(), (*it)->size());
+        data += (*it)->size()+1;
+    }
+
+    _data = _buffer.data();
+    _size = _buffer.size();
+    if (!validate()) {
+        dispose();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Initializes an asset directory from compiled data.
+ *
+ * This directory does NOT copy the data. The data must remain valid (and
+ * unchanged) for the lifetime of this directory. This makes it possible
+ * to use a directory directly from a memory mapped file.
+ *
+ * This method fails if the data is not a valid compiled directory.
+ *
+ * @param data  The compiled data
+ * @param size  The number of bytes of data
+ *
+ * @return true if initialization was successful.
+ */
+bool AssetDirectory::init(const Uint8* data, size_t size) {
+    CUAssertLog(_data == nullptr, "Asset directory is already initialized");
+    _data = data;
+    _size = size;
+    if (!validate()) {
+        dispose();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Initializes an asset directory from the given compiled file.
+ *
+ * This initializer assumes that the file name is an absolute path. This
+ * method fails if the file is not a compiled directory.
+ *
+ * @param file  The path to the file
+ *
+ * @return true if initialization was successful.
+ */
+bool AssetDirectory::initWithFile(const std::string file) {
+    CUAssertLog(_data == nullptr, "Asset directory is already initialized");
+    return load(filetool::normalize_path(file));
+}
+
+/**
+ * Initializes an asset directory from the given compiled file.
+ *
+ * This initializer assumes that the file name is a relative path. It will
+ * search the application asset directory {@see Application#getAssetDirectory()}
+ * for the file. This method fails if the file cannot be found or is not
+ * a compiled directory.
+ *
+ * @param file  The relative path to the file
+ *
+ * @return true if initialization was successful.
+ */
+bool AssetDirectory::initWithAsset(const std::string file) {
+    CUAssertLog(_data == nullptr, "Asset directory is already initialized");
+    CUAssertLog(!filetool::is_absolute(file), "This initializer does not accept absolute paths");
+    std::string path = Application::get()->getAssetDirectory();
+    path.append(file);
+    return load(filetool::normalize_path(path));
+}
+
+#pragma mark -
+#pragma mark Attributes
+/**
+ * Returns true if the data begins with a compiled directory signature
+ *
+ * This is a quick test that does not validate the rest of the data.
+ *
+ * @param data  The data to test
+ * @param size  The number of bytes of data
+ *
+ * @return true if the data begins with a compiled directory signature
+ */
+bool AssetDirectory::isCompiled(const Uint8* data, size_t size) {
+    return size >= HEADER_SIZE && !std::memcmp(data, CU_ASSET_DIRECTORY_MAGIC, 4);
+}
+
+/**
+ * Returns the name of the given asset category
+ *
+ * The name is a view into the compiled data, and is only valid for the
+ * lifetime of this directory.
+ *
+ * @param index The category index
+ *
+ * @return the name of the given asset category
+ */
+std::string_view AssetDirectory::getCategory(size_t index) const {
+    CUAssertLog(index < _categories, "Category index %zu out of range", index);
+    return getString(get32(_data+_catOffset+CATEGORY_SIZE*index));
+}
+
+#pragma mark -
+#pragma mark Conversion
+/**
+ * Returns a newly allocated JsonValue for the given asset category
+ *
+ * The result has the same key and contents as the corresponding child of
+ * the original JSON directory. However, it has no parent.
+ *
+ * If arena is true, every node in the tree is allocated from a single
+ * arena (see {@link JsonArena}). This is much faster for large categories,
+ * but the arena is only released when every node of the tree has been
+ * deleted.
+ *
+ * @param index The category index
+ * @param arena Whether to allocate the tree from an arena
+ *
+ * @return a newly allocated JsonValue for the given asset category
+ */
+std::shared_ptr<JsonValue> AssetDirectory::get(size_t index, bool arena) const {
+    CUAssertLog(index < _categories, "Category index %zu out of range", index);
+    std::shared_ptr<JsonArena> pool = arena ? JsonArena::alloc() : nullptr;
+    std::shared_ptr<JsonValue> result = std::make_shared<JsonValue>();
+    readNode(get32(_data+_catOffset+CATEGORY_SIZE*index+4), result.get(), pool);
+    return result;
+}
+
+/**
+ * Returns a newly allocated JsonValue for the entire directory
+ *
+ * The result is identical to the original JSON directory.
+ *
+ * If arena is true, every node in the tree is allocated from a single
+ * arena (see {@link JsonArena}). This is much faster for large directories,
+ * but the arena is only released when every node of the tree has been
+ * deleted.
+ *
+ * @param arena Whether to allocate the tree from an arena
+ *
+ * @return a newly allocated JsonValue for the entire directory
+ */
+std::shared_ptr<JsonValue> AssetDirectory::toJson(bool arena) const {
+    if (_nodes == 0) {
+        return nullptr;
+    }
+    std::shared_ptr<JsonArena> pool = arena ? JsonArena::alloc() : nullptr;
+    std::shared_ptr<JsonValue> result = std::make_shared<JsonValue>();
+    readNode(0, result.get(), pool);
+    return result;
+}
+
+/**
+ * Returns a newly allocated JsonValue for the given directory file
+ *
+ * The file may either be a compiled directory or a JSON file. The file
+ * is read exactly once, and its signature determines how the contents
+ * are decoded. Hence this is the preferred way to read a directory whose
+ * format is not known in advance.
+ *
+ * This method assumes that the file name is an absolute path. It returns
+ * nullptr if the file cannot be read or is not a valid directory.
+ *
+ * @param file  The path to the file
+ * @param arena Whether to allocate the tree from an arena
+ *
+ * @return a newly allocated JsonValue for the given directory file
+ */
+std::shared_ptr<JsonValue> AssetDirectory::readJson(const std::string file, bool arena) {
+    std::vector<Uint8> buffer;
+    if (!readFile(filetool::normalize_path(file), buffer)) {
+        return nullptr;
+    }
+
+    if (isCompiled(buffer.data(), buffer.size())) {
+        AssetDirectory compiled;
+        return compiled.init(buffer.data(), buffer.size()) ? compiled.toJson(arena) : nullptr;
+    }
+
+    JsonParser parser;
+    parser.init((const char*)buffer.data(), buffer.size());
+    std::shared_ptr<JsonValue> result = std::make_shared<JsonValue>();
+    if (!parser.readValue(result.get(), arena)) {
+        CULogError("Invalid asset directory '%s': %s", file.c_str(), parser.getError().c_str());
+        return nullptr;
+    }
+    return result;
+}
+
+/**
+ * Returns a newly allocated JsonValue for the given directory file
+ *
+ * The file may either be a compiled directory or a JSON file. The file
+ * is read exactly once, and its signature determines how the contents
+ * are decoded. Hence this is the preferred way to read a directory whose
+ * format is not known in advance.
+ *
+ * This method assumes that the file name is a relative path. It will
+ * search the application asset directory {@see Application#getAssetDirectory()}
+ * for the file. It returns nullptr if the file cannot be read or is not
+ * a valid directory.
+ *
+ * @param file  The relative path to the file
+ * @param arena Whether to allocate the tree from an arena
+ *
+ * @return a newly allocated JsonValue for the given directory file
+ */
+std::shared_ptr<JsonValue> AssetDirectory::readJsonWithAsset(const std::string file, bool arena) {
+    CUAssertLog(!filetool::is_absolute(file), "This method does not accept absolute paths");
+    std::string path = Application::get()->getAssetDirectory();
+    path.append(file);
+    return readJson(path, arena);
+}
+
+/**
+ * Writes the compiled directory to the given file.
+ *
+ * If the file is a relative path, it is written to the application save
+ * directory {@see Application#getSaveDirectory()}. If the file already
+ * exists, it will be replaced.
+ *
+ * @param file  The path to the file
+ *
+ * @return true if the file was written successfully
+ */
+bool AssetDirectory::write(const std::string file) const {
+    CUAssertLog(_data != nullptr, "Asset directory is not initialized");
+    std::shared_ptr<BinaryWriter> writer = BinaryWriter::alloc(file);
+    if (writer == nullptr) {
+        return false;
+    }
+    writer->write(_data, _size);
+    writer->close();
+    return true;
+}
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Returns true if the attached data is a valid compiled directory
+ *
+ * This method reads the header and verifies that every section fits in
+ * the data. It also checks every node record, including that each
+ * subtree lies within its parent and that no container is nested more
+ * than {@link CU_ASSET_DIRECTORY_MAX_DEPTH} deep. Hence reading a valid
+ * directory never leaves the data.
+ *
+ * @return true if the attached data is a valid compiled directory
+ */
+bool AssetDirectory::validate() {
+    if (_data == nullptr || !isCompiled(_data, _size)) {
+        return false;
+    }
+
+    Uint32 version = get32(_data+4);
+    if (version != CU_ASSET_DIRECTORY_VERSION) {
+        CULogError("Unsupported asset directory version %u", version);
+        return false;
+    }
+
+    _categories = get32(_data+8);
+    _strings = get32(_data+12);
+    _nodes   = get32(_data+16);
+    size_t blobsize = get32(_data+20);
+
+    _catOffset  = HEADER_SIZE;
+    _strOffset  = _catOffset+CATEGORY_SIZE*(size_t)_categories;
+    _nodeOffset = _strOffset+STRING_SIZE*(size_t)_strings;
+    _blobOffset = _nodeOffset+NODE_SIZE*(size_t)_nodes;
+    if (_blobOffset+blobsize > _size) {
+        CULogError("Asset directory is truncated");
+        return false;
+    }
+
+    // Check every reference so that reading never leaves the data
+    for(Uint32 ii = 0; ii < _strings; ii++) {
+        const Uint8* record = _data+_strOffset+STRING_SIZE*ii;
+        size_t start = get32(record);
+        size_t length = get32(record+4);
+        if (start+length >= blobsize || _data[_blobOffset+start+length] != 0) {
+            CULogError("Asset directory has a corrupt string table");
+            return false;
+        }
+    }
+    // The last node of each open container, innermost at the back
+    std::vector<Uint64> open;
+    for(Uint32 ii = 0; ii < _nodes; ii++) {
+        while (!open.empty() && ii > open.back()) {
+            open.pop_back();
+        }
+        const Uint8* record = _data+_nodeOffset+NODE_SIZE*ii;
+        Uint32 key = get32(record+4);
+        Uint64 payload = get64(record+8);
+        bool valid = record[0] <= (Uint8)JsonValue::Type::ObjectType;
+        valid = valid && (key == NO_KEY || key < _strings);
+        if (record[0] == (Uint8)JsonValue::Type::StringType) {
+            valid = valid && payload < _strings;
+        } else if (record[0] >= (Uint8)JsonValue::Type::ArrayType) {
+            Uint64 count = payload >> 32;
+            Uint64 total = payload & 0xFFFFFFFF;
+            valid = valid && count <= total && ii+total < _nodes;
+            valid = valid && (open.empty() || ii+total <= open.back());
+            if (valid && total > 0) {
+                if (open.size() >= CU_ASSET_DIRECTORY_MAX_DEPTH) {
+                    CULogError("Asset directory is nested too deeply");
+                    return false;
+                }
+                open.push_back(ii+total);
+            }
+        }
+        if (!valid) {
+            CULogError("Asset directory has a corrupt node %u", ii);
+            return false;
+        }
+    }
+    for(Uint32 ii = 0; ii < _categories; ii++) {
+        const Uint8* record = _data+_catOffset+CATEGORY_SIZE*ii;
+        if (get32(record) >= _strings || get32(record+4) >= _nodes) {
+            CULogError("Asset directory has a corrupt category table");
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns true if the file contains a valid compiled directory
+ *
+ * The file is read into {@link #_buffer} with a single read of the
+ * file size.
+ *
+ * @param path  The absolute path to the compiled file
+ *
+ * @return true if the file contains a valid compiled directory
+ */
+bool AssetDirectory::load(const std::string path) {
+    if (!readFile(path, _buffer) || !isCompiled(_buffer.data(), _buffer.size())) {
+        dispose();
+        return false;
+    }
+
+    _data = _buffer.data();
+    _size = _buffer.size();
+    if (!validate()) {
+        dispose();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Returns true if the contents of the file were read into the buffer
+ *
+ * The buffer is resized to the file size and filled with a single read.
+ *
+ * @param path      The absolute path to the file
+ * @param buffer    The buffer to store the contents
+ *
+ * @return true if the contents of the file were read into the buffer
+ */
+bool AssetDirectory::readFile(const std::string path, std::vector<Uint8>& buffer) {
+    SDL_RWops* stream = SDL_RWFromFile(path.c_str(), "rb");
+    if (stream == nullptr) {
+        return false;
+    }
+
+    Sint64 size = SDL_RWsize(stream);
+    bool success = size >= 0;
+    if (success) {
+        buffer.resize((size_t)size);
+        success = SDL_RWread(stream, buffer.data(), 1, buffer.size()) == buffer.size();
+    }
+    SDL_RWclose(stream);
+    return success;
+}
+
+/**
+ * Returns the interned string with the given id
+ *
+ * @param id    The string id
+ *
+ * @return the interned string with the given id
+ */
+std::string_view AssetDirectory::getString(Uint32 id) const {
+    const Uint8* record = _data+_strOffset+STRING_SIZE*id;
+    const char* start = (const char*)(_data+_blobOffset+get32(record));
+    return std::string_view(start,get32(record+4));
+}
+
+/**
+ * Stores the subtree with the given root in the given node.
+ *
+ * Descendant nodes are allocated from the arena, if it is not nullptr.
+ *
+ * @param index The index of the root node record
+ * @param node  The node to store the result
+ * @param arena The arena for descendant nodes (may be nullptr)
+ *
+ * @return the index of the next node record after the subtree
+ */
+Uint32 AssetDirectory::readNode(Uint32 index, JsonValue* node,
+                                const std::shared_ptr<JsonArena>& arena) const {
+    const Uint8* record = _data+_nodeOffset+NODE_SIZE*index;
+    Uint32 key = get32(record+4);
+    Uint64 payload = get64(record+8);
+    if (key != NO_KEY) {
+        node->_key.assign(getString(key));
+    }
+
+    node->_type = (JsonValue::Type)record[0];
+    switch (node->_type) {
+        case JsonValue::Type::NullType:
+            break;
+        case JsonValue::Type::BoolType:
+            node->_longValue = payload ? 1 : 0;
+            break;
+        case JsonValue::Type::NumberType:
+        {
+            double value;
+            std::memcpy(&value, &payload, sizeof(double));
+            node->_doubleValue = value;
+            if (value >= (double)LONG_MAX) {
+                node->_longValue = LONG_MAX;
+            } else if (value <= (double)LONG_MIN) {
+                node->_longValue = LONG_MIN;
+            } else {
+                node->_longValue = (long)value;
+            }
+        }
+            break;
+        case JsonValue::Type::StringType:
+            node->_stringValue.assign(getString((Uint32)payload));
+            break;
+        case JsonValue::Type::ArrayType:
+        case JsonValue::Type::ObjectType:
+        {
+            Uint32 count = (Uint32)(payload >> 32);
+            Uint32 last  = index+(Uint32)(payload & 0xFFFFFFFF);
+            node->_children.reserve(count);
+            index++;
+            for(Uint32 ii = 0; ii < count && index <= last; ii++) {
+                std::shared_ptr<JsonValue> child = (arena ? arena->allocValue() : std::make_shared<JsonValue>());
+                child->_parent = node;
+                index = readNode(index, child.get(), arena);
+                node->_children.push_back(child);
+            }
+            node->rebuildIndex();
+            return last+1;
+        }
+    }
+    return index+1;
+}
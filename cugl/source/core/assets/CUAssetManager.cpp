@@ -47,6 +47,7 @@
 //
 #include <cugl/core/assets/CUAssetManager.h>
 #include <cugl/core/io/CUJsonReader.h>
+#include <cugl/core/assets/CUAssetDirectory.h>
 #include <cugl/core/CUApplication.h>
 
 using namespace cugl;
@@ -356,18 +357,19 @@ bool AssetManager::loadDirectory(const std::shared_ptr<JsonValue>& json) {
  * can. If any asset fails to load, it will return false. However, some
  * assets may still be loaded and safe to access.
  *
+ * The directory may either be a JSON file or a compiled directory (see
+ * {@link AssetDirectory}). Compiled directories are detected automatically.
+ *
  * @param directory The path to the JSON asset directory
  *
  * @return true if all assets specified in the directory were successfully loaded.
  */
 bool AssetManager::loadDirectory(const std::string directory) {
-    std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(directory);
-    if (reader == nullptr) {
+    std::shared_ptr<JsonValue> json = AssetDirectory::readJsonWithAsset(directory,true);
+    if (json == nullptr) {
         CULogError("No asset directory located at '%s'",directory.c_str());
         return false;
     }
-    
-    std::shared_ptr<JsonValue> json = reader->readJson();
     return loadDirectory(json);
 }
 
@@ -501,21 +503,28 @@ void AssetManager::loadDirectoryAsync(const std::shared_ptr<JsonValue>& json, Lo
  * to load, the callback function will be given the asset category name
  * (e.g. "soundfx") as the asset key.
  *
+ * The directory may either be a JSON file or a compiled directory (see
+ * {@link AssetDirectory}). Compiled directories are detected automatically.
+ *
  * @param directory The path to the JSON asset directory
  * @param callback  An optional callback after each asset is loaded
  */
 void AssetManager::loadDirectoryAsync(const std::string directory, LoaderCallback callback) {
     _preload = true;
     
-    std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(directory);
-    if (reader == nullptr && callback != nullptr) {
-        callback("",false);
-        return;
-    }
-    
     _workers->addTask([=,this](void) {
-        std::shared_ptr<JsonValue> json = reader->readJson();
-        loadDirectoryAsync(json,callback);
+        std::shared_ptr<JsonValue> json = AssetDirectory::readJsonWithAsset(directory,true);
+        if (json != nullptr) {
+            loadDirectoryAsync(json,callback);
+        } else {
+            CULogError("No asset directory located at '%s'",directory.c_str());
+            if (callback) {
+                Application::get()->schedule([=] {
+                    callback("",false);
+                    return false;
+                });
+            }
+        }
         _preload = false;
     });
 }
@@ -554,16 +563,17 @@ bool AssetManager::unloadDirectory(const std::shared_ptr<JsonValue>& json) {
  * still may remain in memory. However, the rest of the program can no
  * longer access these assets.
  *
+ * The directory may either be a JSON file or a compiled directory (see
+ * {@link AssetDirectory}). Compiled directories are detected automatically.
+ *
  * @param directory The path to the JSON asset directory
  */
 bool AssetManager::unloadDirectory(const std::string directory) {
-    std::shared_ptr<JsonReader> reader = JsonReader::allocWithAsset(directory);
-    if (reader == nullptr) {
+    std::shared_ptr<JsonValue> json = AssetDirectory::readJsonWithAsset(directory,true);
+    if (json == nullptr) {
         CULogError("No asset directory located at '%s'",directory.c_str());
         return false;
     }
-    
-    std::shared_ptr<JsonValue> json = reader->readJson();
     return unloadDirectory(json);
 }
 
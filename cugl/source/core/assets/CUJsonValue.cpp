@@ -4,8 +4,11 @@
 //
 //  This module a modern C++ alternative to the CUJSON interface for reading
 //  JSON files.  In particular, this gives us better type-checking and memory
-//  management.  With that said, it still uses CUJSON as the underlying parsing
-//  engine.
+//  management.  JSON strings are parsed with JsonParser, which builds the tree
+//  directly (optionally from an arena). CUJSON is still used for encoding.
+//
+//  Objects with many children lazily build a hash index of their keys, so
+//  keyed lookups are constant time on large objects.
 //
 //  This class uses our standard shared-pointer architecture.
 //
@@ -42,47 +45,12 @@
 //  Version: 7/3/24 (CUGL 3.0 reorganization)
 //
 #include <cugl/core/assets/CUJsonValue.h>
+#include <cugl/core/io/CUJsonParser.h>
 #include <cugl/core/util/CUDebug.h>
 #include <cugl/core/util/CUStringTools.h>
 
 using namespace cugl;
 
-/**
- * Returns the line of JSON with the offending error.
- *
- * Error messages in this library correspond to the tail of the JSON after the error is encounterd.  These
- * can be hard to read if the error happens early.  This function truncates the error to only include the
- * first line of the error.  It also indicates (via the reference variable) the line on which the error occurred.
- *
- * @param data      The JSON value being parsed
- * @param error     The tail of the JSON after encountering an error
- * @param lineno    The variable to store the line number
- *
- * @return the line of JSON with the offending error.
- */
-static std::string isolate_error(const char* data, const char* error, int& lineno) {
-    lineno = 1;
-    const char* pos = data;
-    while (pos != error) {
-        if (*pos == '\n') {
-            lineno++;
-        }
-        pos++;
-    }
-    size_t len = 0;
-    bool goon = true;
-    pos = error;
-    while (*pos && goon) {
-        if (*pos == '\n') {
-            goon = false;
-        } else {
-            len++;
-        }
-        pos++;
-    }
-    return std::string(error,len);
-}
-
 #pragma mark -
 #pragma mark JSON Conversions
 /**
@@ -181,6 +149,7 @@ std::shared_ptr<JsonValue> JsonValue::toJsonValue(const CUJSON* node) {
         }
     }
     result->_children.assign(items.begin(),items.end());
+    result->rebuildIndex();
     
     return result;
 }
@@ -221,6 +190,7 @@ void JsonValue::toJsonValue(JsonValue* value, const CUJSON* node) {
         }
     }
     value->_children.assign(items.begin(),items.end());
+    value->rebuildIndex();
 }
 
 /**
@@ -292,7 +262,8 @@ _parent(nullptr),
 _key(""),
 _stringValue(""),
 _longValue(0L),
-_doubleValue(0.0) {
+_doubleValue(0.0),
+_indexed(false) {
 }
 
 /**
@@ -395,25 +366,23 @@ bool JsonValue::init(double value) {
  * information about the parsing error will be passed to an assert.  Hence
  * error messages are suppressed if asserts are turned off.
  *
+ * If arena is true, the descendants of this node are allocated from a
+ * single arena (see {@link JsonParser#readValue}). This is much faster
+ * for large files, but the arena is not released until every descendant
+ * (including detached subtrees) has been deleted.
+ *
  * @param json  The JSON string to parse.
+ * @param arena Whether to allocate the descendants from an arena
  *
  * @return  true if the JSON node is initialized properly, false otherwise.
  */
-bool JsonValue::initWithJson(const std::string json) {
-    const char *error = NULL;
-    CUJSON* node = CUJSON_ParseWithOpts(json.c_str(), &error, 0);
-    if (node) {
-        toJsonValue(this,node);
-        CUJSON_Delete(node);
+bool JsonValue::initWithJson(const std::string json, bool arena) {
+    JsonParser parser;
+    parser.init(json.data(),json.size());
+    if (parser.readValue(this,arena)) {
         return true;
     }
-    if (error) {
-        int line = 0;
-        std::string source = isolate_error(json.c_str(),error,line);
-        CUAssertLog(false, "Invalid token at line %d:\n  %s",line,source.c_str());
-    } else {
-        CUAssertLog(false, "Invalid JSON");
-    }
+    CUAssertLog(false, "%s", parser.getError().c_str());
     return false; // If asserts turned off
 }
 
@@ -809,6 +778,9 @@ void JsonValue::setKey(const std::string key) {
         CUAssertLog(!_parent->has(key), "The key %s is already in use", key.c_str());
     }
     _key = key;
+    if (_parent) {
+        _parent->rebuildIndex();
+    }
 }
 
 /**
@@ -841,12 +813,7 @@ const int JsonValue::index() const {
  */
 bool JsonValue::has(const std::string key) const {
     CUAssertLog(isObject(), "Node is not an object type");
-    for(auto it = _children.begin(); it != _children.end(); it++) {
-        if ((*it)->_key == key) {
-            return true;
-        }
-    }
-    return false;
+    return findChild(key) != -1;
 }
 
 /**
@@ -889,18 +856,16 @@ const std::shared_ptr<JsonValue> JsonValue::get(int index) const {
  * corrupted and there is more than one child of this name, it will return
  * the first one.
  *
+ * This method is constant time for objects with many children.
+ *
  * @param key   The key identifying the child.
  *
  * @return the child with the specified key.
  */
 std::shared_ptr<JsonValue> JsonValue::get(const std::string key) {
     CUAssertLog(isObject(), "Node is not an object type");
-    for(auto it = _children.begin(); it != _children.end(); it++) {
-        if ((*it)->_key == key) {
-            return *it;
-        }
-    }
-    return nullptr;
+    int pos = findChild(key);
+    return pos == -1 ? nullptr : _children[pos];
 }
 
 /**
@@ -911,18 +876,16 @@ std::shared_ptr<JsonValue> JsonValue::get(const std::string key) {
  * corrupted and there is more than one child of this name, it will return
  * the first one.
  *
+ * This method is constant time for objects with many children.
+ *
  * @param key   The key identifying the child.
  *
  * @return the child with the specified key.
  */
 const std::shared_ptr<JsonValue> JsonValue::get(const std::string key) const {
     CUAssertLog(isObject(), "Node is not an object type");
-    for(auto it = _children.begin(); it != _children.end(); it++) {
-        if ((*it)->_key == key) {
-            return *it;
-        }
-    }
-    return nullptr;
+    int pos = findChild(key);
+    return pos == -1 ? nullptr : _children[pos];
 }
 
 #pragma mark -
@@ -1059,6 +1022,7 @@ std::shared_ptr<JsonValue> JsonValue::removeChild(int index) {
     CUAssertLog(0 <= index && index < _children.size(), "Index %d out of range", index);
     std::shared_ptr<JsonValue> result = _children[index];
     _children.erase(_children.begin() + index);
+    rebuildIndex();
     result->_parent = nullptr;
     return result;
 }
@@ -1076,15 +1040,11 @@ std::shared_ptr<JsonValue> JsonValue::removeChild(int index) {
  * Returns the child with the specified key and removes it from this node.
  */
 std::shared_ptr<JsonValue> JsonValue::removeChild(const std::string key) {
-    auto jt = _children.end();
-    for(auto it = _children.begin(); jt == _children.end() && it != _children.end(); it++) {
-        if ((*it)->_key == key) {
-            jt = it;
-        }
-    }
-    if (jt != _children.end()) {
-        std::shared_ptr<JsonValue> result = *jt;
-        _children.erase(jt);
+    int pos = findChild(key);
+    if (pos != -1) {
+        std::shared_ptr<JsonValue> result = _children[pos];
+        _children.erase(_children.begin()+pos);
+        rebuildIndex();
         result->_parent = nullptr;
         return result;
     }
@@ -1106,6 +1066,7 @@ void JsonValue::merge(const std::shared_ptr<JsonValue>& node) {
     node->_key = _key;
     _parent->removeChild(_key);
     node->_parent->_children.push_back(node);
+    node->_parent->rebuildIndex();
 }
 
 
@@ -1130,6 +1091,11 @@ void JsonValue::appendChild(const std::shared_ptr<JsonValue>& child) {
     CUAssertLog(isArray() || !has(child->key()),
                 "The key %s is already in use", child->key().c_str());
     _children.push_back(child);
+    if (_indexed) {
+        _index.emplace(child->_key,_children.size()-1);
+    } else if (_type == Type::ObjectType && _children.size() >= CU_JSON_INDEX_MINIMUM) {
+        rebuildIndex();
+    }
     child->_parent = this;
 }
 
@@ -1155,6 +1121,11 @@ void JsonValue::appendChild(const std::string key, const std::shared_ptr<JsonVal
     CUAssertLog(!has(key), "The key %s is already in use", key.c_str());
     child->_key = key;
     _children.push_back(child);
+    if (_indexed) {
+        _index.emplace(child->_key,_children.size()-1);
+    } else if (_type == Type::ObjectType && _children.size() >= CU_JSON_INDEX_MINIMUM) {
+        rebuildIndex();
+    }
     child->_parent = this;
 }
 
@@ -1179,6 +1150,7 @@ void JsonValue::insertChild(unsigned int index, const std::shared_ptr<JsonValue>
     CUAssertLog(!child->_parent, "This child already has a parent");
     CUAssertLog(isArray() || isObject(), "This node is a value type");
     _children.insert(_children.begin()+index,child);
+    rebuildIndex();
     child->_parent = this;
 }
 
@@ -1208,10 +1180,57 @@ void JsonValue::insertChild(unsigned int index, const std::string key,
     CUAssertLog(!has(key), "The key %s is already in use", key.c_str());
     child->_key = key;
     _children.insert(_children.begin()+index,child);
+    rebuildIndex();
     child->_parent = this;
 }
 
 
+#pragma mark -
+#pragma mark Key Index
+/**
+ * Returns the position of the first child with the given key
+ *
+ * If this node has a key index, this method uses it. Otherwise, it
+ * searches the children in order. This method never modifies the node.
+ *
+ * @param key   The key identifying the child
+ *
+ * @return the position of the first child with the given key (-1 if none)
+ */
+int JsonValue::findChild(const std::string& key) const {
+    if (_indexed) {
+        auto it = _index.find(key);
+        return it == _index.end() ? -1 : (int)it->second;
+    }
+    size_t size = _children.size();
+    for(size_t ii = 0; ii < size; ii++) {
+        if (_children[ii]->_key == key) {
+            return (int)ii;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Rebuilds the key index from the current children
+ *
+ * Only objects with at least {@link CU_JSON_INDEX_MINIMUM} children
+ * have an index. For any other node, this method removes the index.
+ * This method should be called after any change to the children other
+ * than an append.
+ */
+void JsonValue::rebuildIndex() {
+    _index.clear();
+    size_t size = _children.size();
+    _indexed = _type == Type::ObjectType && size >= CU_JSON_INDEX_MINIMUM;
+    if (_indexed) {
+        _index.reserve(size);
+        for(size_t ii = 0; ii < size; ii++) {
+            _index.emplace(_children[ii]->_key,ii);
+        }
+    }
+}
+
 #pragma mark -
 #pragma mark Encoding
 /**
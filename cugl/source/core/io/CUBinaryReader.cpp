@@ -457,6 +457,9 @@ size_t BinaryReader::read(char* buffer, size_t maximum, size_t offset) {
     CUAssertLog(ready(), "Attempt to read a finished stream");
     unsigned int pos = (unsigned int)offset;
     while (ready(1) && pos-offset < maximum) {
+        if (_bufsize-_bufoff < 1) {
+            fill(1);
+        }
         size_t available = _bufsize-_bufoff;
         size_t wanted = maximum-(pos-offset);
         wanted = wanted < available ? wanted : available;
@@ -483,6 +486,9 @@ size_t BinaryReader::read(Uint8* buffer, size_t maximum, size_t offset)  {
     CUAssertLog(ready(), "Attempt to read a finished stream");
     unsigned int pos = (unsigned int)offset;
     while (ready(1) && pos-offset < maximum) {
+        if (_bufsize-_bufoff < 1) {
+            fill(1);
+        }
         size_t available = _bufsize-_bufoff;
         size_t wanted = maximum-(pos-offset);
         wanted = wanted < available ? wanted : available;
@@ -513,6 +519,9 @@ size_t BinaryReader::read(Sint16* buffer, size_t maximum, size_t offset) {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 2;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufsize-_bufoff < bytes) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
@@ -547,6 +556,9 @@ size_t BinaryReader::read(Uint16* buffer, size_t maximum, size_t offset)  {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 2;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufsize-_bufoff < bytes) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
@@ -582,6 +594,9 @@ size_t BinaryReader::read(Sint32* buffer, size_t maximum, size_t offset) {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 4;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufsize-_bufoff < bytes) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
@@ -616,6 +631,9 @@ size_t BinaryReader::read(Uint32* buffer, size_t maximum, size_t offset) {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 4;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufsize-_bufoff < bytes) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
@@ -650,6 +668,9 @@ size_t BinaryReader::read(Sint64* buffer, size_t maximum, size_t offset) {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 8;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufsize-_bufoff < bytes) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
@@ -684,6 +705,9 @@ size_t BinaryReader::read(Uint64* buffer, size_t maximum, size_t offset) {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 8;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufsize-_bufoff < bytes) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
@@ -718,6 +742,9 @@ size_t BinaryReader::read(float* buffer, size_t maximum, size_t offset) {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 4;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufsize-_bufoff < bytes) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
@@ -752,6 +779,9 @@ size_t BinaryReader::read(double* buffer, size_t maximum, size_t offset) {
     unsigned int pos = (unsigned int)offset;
     unsigned int bytes = 8;
     while (ready(bytes) && pos-offset < maximum) {
+        if (_bufsize-_bufoff < bytes) {
+            fill(bytes);
+        }
         size_t available = bytes*((_bufsize-_bufoff)/bytes);
         size_t wanted = (maximum-(pos-offset))*bytes;
         wanted = wanted < available ? wanted : available;
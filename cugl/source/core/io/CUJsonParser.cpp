@@ -0,0 +1,906 @@
+//
+//  CUJsonParser.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides a streaming (pull) parser for JSON text. Unlike
+//  JsonValue, which always builds a full tree, this parser reports the JSON
+//  as a sequence of events (begin object, key, value, end object, and so on).
+//  Strings are reported as views into the source text whenever they have no
+//  escape characters, so the parser allocates no memory per token. The events
+//  can be consumed directly, pushed to a SAX-style handler, or used to build a
+//  JsonValue tree. In the last case, the tree can optionally be allocated from
+//  a single arena, greatly reducing the number of allocations for large files.
+//  This arena is also available to other classes that build JsonValue trees.
+//
+//  The parser accepts the same JSON as the CUJSON engine behind JsonValue.
+//  In particular, it only parses the first JSON value in the source text, and
+//  ignores anything that follows it.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#include <cmath>
+#include <cstring>
+#include <climits>
+#include <cstddef>
+#include <cugl/core/io/CUJsonParser.h>
+#include <cugl/core/assets/CUJsonValue.h>
+#include <cugl/core/util/CUDebug.h>
+
+using namespace cugl;
+
+/** Expecting any value */
+#define STATE_VALUE         0
+/** Expecting the first key of an object (or its end) */
+#define STATE_FIRST_KEY     1
+/** Expecting a key of an object */
+#define STATE_KEY           2
+/** Expecting a comma or the end of an object */
+#define STATE_OBJECT_NEXT   3
+/** Expecting the first item of an array (or its end) */
+#define STATE_FIRST_ITEM    4
+/** Expecting a comma or the end of an array */
+#define STATE_ARRAY_NEXT    5
+/** The value is complete */
+#define STATE_DONE          6
+
+/** The size of a single arena block */
+#define ARENA_BLOCK 65536
+
+#pragma mark -
+#pragma mark Arena Allocation
+/**
+ * An allocator adapter for JsonArena.
+ *
+ * Each copy of this allocator shares ownership of the arena. As a shared
+ * pointer control block keeps a copy of its allocator, the arena lives
+ * until the last node allocated from it is deleted.
+ */
+template <class T>
+class JsonArenaAllocator {
+public:
+    /** The allocated type */
+    typedef T value_type;
+    /** The backing arena */
+    std::shared_ptr<JsonArena> arena;
+
+    /**
+     * Creates an allocator for the given arena
+     *
+     * @param source    The backing arena
+     */
+    JsonArenaAllocator(const std::shared_ptr<JsonArena>& source) : arena(source) {}
+
+    /**
+     * Creates a copy of an allocator for another type
+     *
+     * @param other The allocator to copy
+     */
+    template <class U>
+    JsonArenaAllocator(const JsonArenaAllocator<U>& other) : arena(other.arena) {}
+
+    /**
+     * Returns storage for n objects
+     *
+     * @param n The number of objects
+     *
+     * @return storage for n objects
+     */
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena->allocate(n*sizeof(T)));
+    }
+
+    /**
+     * Releases storage (which is a no-op for an arena)
+     */
+    void deallocate(T*, size_t) {}
+
+    /** Returns true if the two allocators share an arena */
+    template <class U>
+    bool operator==(const JsonArenaAllocator<U>& other) const {
+        return arena == other.arena;
+    }
+
+    /** Returns true if the two allocators do not share an arena */
+    template <class U>
+    bool operator!=(const JsonArenaAllocator<U>& other) const {
+        return arena != other.arena;
+    }
+};
+
+/**
+ * Returns a new (null) JsonValue, allocated from the arena if it exists
+ *
+ * @param arena The arena (may be nullptr)
+ *
+ * @return a new (null) JsonValue, allocated from the arena if it exists
+ */
+static std::shared_ptr<JsonValue> make_node(const std::shared_ptr<JsonArena>& arena) {
+    if (arena) {
+        return arena->allocValue();
+    }
+    return std::make_shared<JsonValue>();
+}
+
+/**
+ * Deletes this arena, releasing all memory
+ */
+JsonArena::~JsonArena() {
+    for(auto it = _blocks.begin(); it != _blocks.end(); ++it) {
+        delete[] *it;
+    }
+}
+
+/**
+ * Returns a pointer to the given number of bytes
+ *
+ * The memory is aligned for any type.
+ *
+ * @param bytes The number of bytes to allocate
+ *
+ * @return a pointer to the given number of bytes
+ */
+void* JsonArena::allocate(size_t bytes) {
+    const size_t align = alignof(std::max_align_t);
+    bytes = (bytes+align-1) & ~(align-1);
+    if (bytes > ARENA_BLOCK/4) {
+        // Large requests get their own block, leaving the current one open
+        char* block = new char[bytes];
+        _blocks.insert(_blocks.begin(),block);
+        return block;
+    } else if (_offset+bytes > _capacity) {
+        _blocks.push_back(new char[ARENA_BLOCK]);
+        _offset = 0;
+        _capacity = ARENA_BLOCK;
+    }
+    void* result = _blocks.back()+_offset;
+    _offset += bytes;
+    return result;
+}
+
+/**
+ * Returns a new (null) JsonValue allocated from this arena
+ *
+ * The node keeps this arena alive for as long as the node exists.
+ *
+ * @return a new (null) JsonValue allocated from this arena
+ */
+std::shared_ptr<JsonValue> JsonArena::allocValue() {
+    return std::allocate_shared<JsonValue>(JsonArenaAllocator<JsonValue>(shared_from_this()));
+}
+
+/**
+ * Returns the value of a 4 digit hexadecimal string (0 if invalid)
+ *
+ * @param str   The hexadecimal string
+ *
+ * @return the value of a 4 digit hexadecimal string (0 if invalid)
+ */
+static unsigned parse_hex4(const char* str) {
+    unsigned h = 0;
+    for(int ii = 0; ii < 4; ii++) {
+        char c = str[ii];
+        h = h << 4;
+        if (c >= '0' && c <= '9') {
+            h += c-'0';
+        } else if (c >= 'A' && c <= 'F') {
+            h += 10+c-'A';
+        } else if (c >= 'a' && c <= 'f') {
+            h += 10+c-'a';
+        } else {
+            return 0;
+        }
+    }
+    return h;
+}
+
+/**
+ * Appends the UTF8 encoding of the given code point to the string
+ *
+ * @param out   The string to append to
+ * @param uc    The unicode code point
+ */
+static void append_utf8(std::string& out, unsigned uc) {
+    if (uc < 0x80) {
+        out.push_back((char)uc);
+    } else if (uc < 0x800) {
+        out.push_back((char)(0xC0 | (uc >> 6)));
+        out.push_back((char)(0x80 | (uc & 0x3F)));
+    } else if (uc < 0x10000) {
+        out.push_back((char)(0xE0 | (uc >> 12)));
+        out.push_back((char)(0x80 | ((uc >> 6) & 0x3F)));
+        out.push_back((char)(0x80 | (uc & 0x3F)));
+    } else {
+        out.push_back((char)(0xF0 | (uc >> 18)));
+        out.push_back((char)(0x80 | ((uc >> 12) & 0x3F)));
+        out.push_back((char)(0x80 | ((uc >> 6) & 0x3F)));
+        out.push_back((char)(0x80 | (uc & 0x3F)));
+    }
+}
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates an uninitialized parser.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+JsonParser::JsonParser() :
+_begin(nullptr),
+_curr(nullptr),
+_end(nullptr),
+_state(STATE_DONE),
+_event(Event::None),
+_boolValue(false),
+_numberValue(0),
+_errorPos(nullptr),
+_errorMsg(nullptr) {
+}
+
+/**
+ * Disposes all of the resources used by this parser.
+ *
+ * A disposed parser can be safely reinitialized.
+ */
+void JsonParser::dispose() {
+    _source.clear();
+    _scratch.clear();
+    _stack.clear();
+    _begin = _curr = _end = nullptr;
+    _state = STATE_DONE;
+    _event = Event::None;
+    _stringValue = std::string_view();
+    _errorPos = nullptr;
+    _errorMsg = nullptr;
+}
+
+/**
+ * Initializes a parser for the given JSON string.
+ *
+ * The parser makes a copy of the string, so it is safe to discard the
+ * original afterwards.
+ *
+ * @param json  The JSON string
+ *
+ * @return true if initialization was successful.
+ */
+bool JsonParser::init(const std::string json) {
+    _source = json;
+    return init(_source.data(),_source.size());
+}
+
+/**
+ * Initializes a parser for the given JSON text.
+ *
+ * This parser does NOT copy the text. The text must remain valid (and
+ * unchanged) for the lifetime of this parser. The text does not need to
+ * be null terminated.
+ *
+ * @param data  The JSON text
+ * @param size  The number of characters in the text
+ *
+ * @return true if initialization was successful.
+ */
+bool JsonParser::init(const char* data, size_t size) {
+    CUAssertLog(data != nullptr || size == 0, "JSON text is null");
+    _begin = data;
+    _curr  = data;
+    _end   = data+size;
+    _stack.clear();
+    _state = STATE_VALUE;
+    _event = Event::None;
+    _errorPos = nullptr;
+    _errorMsg = nullptr;
+    return true;
+}
+
+#pragma mark -
+#pragma mark Pull Interface
+/**
+ * Returns the next event in the JSON text.
+ *
+ * Once the parser returns {@link Event#Finished} or {@link Event#Error},
+ * every subsequent call will return the same value.
+ *
+ * @return the next event in the JSON text.
+ */
+JsonParser::Event JsonParser::next() {
+    if (_event == Event::Finished || _event == Event::Error) {
+        return _event;
+    }
+
+    while (true) {
+        skipSpace();
+        switch (_state) {
+            case STATE_DONE:
+                _event = Event::Finished;
+                return _event;
+            case STATE_VALUE:
+                return readToken();
+            case STATE_FIRST_ITEM:
+                if (_curr < _end && *_curr == ']') {
+                    _curr++;
+                    _stack.pop_back();
+                    endValue();
+                    _event = Event::EndArray;
+                    return _event;
+                }
+                return readToken();
+            case STATE_ARRAY_NEXT:
+                if (_curr < _end && *_curr == ',') {
+                    _curr++;
+                    _state = STATE_VALUE;
+                    break;
+                } else if (_curr < _end && *_curr == ']') {
+                    _curr++;
+                    _stack.pop_back();
+                    endValue();
+                    _event = Event::EndArray;
+                    return _event;
+                }
+                return fail(_curr,"Expected ',' or ']'");
+            case STATE_OBJECT_NEXT:
+                if (_curr < _end && *_curr == ',') {
+                    _curr++;
+                    _state = STATE_KEY;
+                    break;
+                } else if (_curr < _end && *_curr == '}') {
+                    _curr++;
+                    _stack.pop_back();
+                    endValue();
+                    _event = Event::EndObject;
+                    return _event;
+                }
+                return fail(_curr,"Expected ',' or '}'");
+            case STATE_FIRST_KEY:
+                if (_curr < _end && *_curr == '}') {
+                    _curr++;
+                    _stack.pop_back();
+                    endValue();
+                    _event = Event::EndObject;
+                    return _event;
+                }
+                // Fall through
+            case STATE_KEY:
+            {
+                if (_curr >= _end || *_curr != '\"') {
+                    return fail(_curr,"Expected a key");
+                }
+                if (!readString()) {
+                    return _event;
+                }
+                skipSpace();
+                if (_curr >= _end || *_curr != ':') {
+                    return fail(_curr,"Expected ':'");
+                }
+                _curr++;
+                _state = STATE_VALUE;
+                _event = Event::Key;
+                return _event;
+            }
+        }
+    }
+}
+
+/**
+ * Skips over the current value.
+ *
+ * If the most recent event is {@link Event#BeginObject} or
+ * {@link Event#BeginArray}, this method advances the parser to the
+ * matching end event. If the most recent event is {@link Event#Key},
+ * it skips the value of that entry. Otherwise it does nothing.
+ *
+ * @return false if there was a syntax error
+ */
+bool JsonParser::skip() {
+    if (_event == Event::Key) {
+        next();
+    }
+    if (_event == Event::BeginObject || _event == Event::BeginArray) {
+        size_t target = _stack.size()-1;
+        while (_stack.size() > target) {
+            if (next() == Event::Error) {
+                return false;
+            }
+        }
+    }
+    return _event != Event::Error;
+}
+
+/**
+ * Returns the value of the most recent number event as a long
+ *
+ * The number is truncated (and clamped to the range of a long).
+ *
+ * @return the value of the most recent number event as a long
+ */
+long JsonParser::getLong() const {
+    if (_numberValue >= (double)LONG_MAX) {
+        return LONG_MAX;
+    } else if (_numberValue <= (double)LONG_MIN) {
+        return LONG_MIN;
+    }
+    return (long)_numberValue;
+}
+
+/**
+ * Returns a description of the most recent syntax error
+ *
+ * The description includes the line number and the offending text. If
+ * there is no error, this returns the empty string.
+ *
+ * @return a description of the most recent syntax error
+ */
+std::string JsonParser::getError() const {
+    if (_errorPos == nullptr) {
+        return "";
+    }
+    int lineno = 1;
+    for(const char* pos = _begin; pos < _errorPos; pos++) {
+        if (*pos == '\n') {
+            lineno++;
+        }
+    }
+    const char* stop = _errorPos;
+    while (stop < _end && *stop != '\n' && *stop != '\0') {
+        stop++;
+    }
+    std::string result = _errorMsg;
+    result += " at line "+std::to_string(lineno)+":\n  ";
+    result.append(_errorPos,stop-_errorPos);
+    return result;
+}
+
+#pragma mark -
+#pragma mark Push Interfaces
+/**
+ * Parses the remaining JSON value, sending all events to the handler.
+ *
+ * Parsing stops when the value is complete, when there is a syntax error,
+ * or when an event of the handler returns false.
+ *
+ * @param handler   The handler to receive the events
+ *
+ * @return true if the value was parsed completely
+ */
+bool JsonParser::parse(JsonHandler& handler) {
+    while (true) {
+        bool goon = true;
+        switch (next()) {
+            case Event::NullValue:
+                goon = handler.onNull();
+                break;
+            case Event::BoolValue:
+                goon = handler.onBool(_boolValue);
+                break;
+            case Event::NumberValue:
+                goon = handler.onNumber(_numberValue);
+                break;
+            case Event::StringValue:
+                goon = handler.onString(_stringValue);
+                break;
+            case Event::Key:
+                goon = handler.onKey(_stringValue);
+                break;
+            case Event::BeginObject:
+                goon = handler.onBeginObject();
+                break;
+            case Event::EndObject:
+                goon = handler.onEndObject();
+                break;
+            case Event::BeginArray:
+                goon = handler.onBeginArray();
+                break;
+            case Event::EndArray:
+                goon = handler.onEndArray();
+                break;
+            case Event::Finished:
+                return true;
+            case Event::Error:
+            case Event::None:
+                return false;
+        }
+        if (!goon) {
+            return false;
+        }
+    }
+}
+
+/**
+ * Returns a newly allocated JsonValue for the next JSON value.
+ *
+ * The tree is built directly from the parsing events, without any
+ * intermediate representation. If arena is true, every node in the tree
+ * is allocated from a single arena. This is much faster for large files,
+ * but the arena is only released when every node of the tree (including
+ * any detached subtrees) has been deleted.
+ *
+ * If there is a parsing error, this method will return nullptr. The
+ * details are available from {@link #getError}.
+ *
+ * @param arena Whether to allocate the tree from an arena
+ *
+ * @return a newly allocated JsonValue for the next JSON value.
+ */
+std::shared_ptr<JsonValue> JsonParser::readValue(bool arena) {
+    std::shared_ptr<JsonValue> result = std::make_shared<JsonValue>();
+    return (readValue(result.get(),arena) ? result : nullptr);
+}
+
+/**
+ * Stores the next JSON value in the given node.
+ *
+ * The node is reset to match the next value. Any descendants are built
+ * directly from the parsing events, without any intermediate
+ * representation. If arena is true, every descendant is allocated from
+ * a single arena. This is much faster for large files, but the arena
+ * is only released when every descendant has been deleted.
+ *
+ * If there is a parsing error, this method will return false. The
+ * details are available from {@link #getError}.
+ *
+ * @param value The node to store the result
+ * @param arena Whether to allocate the descendants from an arena
+ *
+ * @return true if the value was read successfully
+ */
+bool JsonParser::readValue(JsonValue* value, bool arena) {
+    CUAssertLog(value != nullptr, "Cannot read into a null JsonValue");
+    std::shared_ptr<JsonArena> pool = arena ? JsonArena::alloc() : nullptr;
+
+    value->_children.clear();
+    value->_stringValue.clear();
+    value->_longValue = 0;
+    value->_doubleValue = 0;
+    value->_indexed = false;
+    value->_index.clear();
+
+    // Children are gathered on a single stack until their container closes
+    std::vector<std::shared_ptr<JsonValue>> items;
+    std::vector<std::pair<JsonValue*,size_t>> frames;
+    std::string key;
+    while (true) {
+        Event event = next();
+        if (event == Event::Error) {
+            return false;
+        } else if (event == Event::Finished || event == Event::None) {
+            fail(_curr,"Missing JSON value");
+            return false;
+        } else if (event == Event::Key) {
+            key.assign(_stringValue);
+            continue;
+        } else if (event == Event::EndObject || event == Event::EndArray) {
+            JsonValue* node = frames.back().first;
+            size_t start = frames.back().second;
+            node->_children.assign(std::make_move_iterator(items.begin()+start),
+                                   std::make_move_iterator(items.end()));
+            node->rebuildIndex();
+            items.resize(start);
+            frames.pop_back();
+            if (frames.empty()) {
+                return true;
+            }
+            continue;
+        }
+
+        JsonValue* node = value;
+        if (!frames.empty()) {
+            JsonValue* parent = frames.back().first;
+            std::shared_ptr<JsonValue> child = make_node(pool);
+            child->_parent = parent;
+            if (parent->_type == JsonValue::Type::ObjectType) {
+                child->_key = key;
+            }
+            node = child.get();
+            items.push_back(std::move(child));
+        }
+
+        switch (event) {
+            case Event::NullValue:
+                node->_type = JsonValue::Type::NullType;
+                break;
+            case Event::BoolValue:
+                node->_type = JsonValue::Type::BoolType;
+                node->_longValue = _boolValue ? 1 : 0;
+                break;
+            case Event::NumberValue:
+                node->_type = JsonValue::Type::NumberType;
+                node->_doubleValue = _numberValue;
+                node->_longValue = getLong();
+                break;
+            case Event::StringValue:
+                node->_type = JsonValue::Type::StringType;
+                node->_stringValue.assign(_stringValue);
+                break;
+            case Event::BeginObject:
+                node->_type = JsonValue::Type::ObjectType;
+                frames.push_back(std::make_pair(node,items.size()));
+                break;
+            case Event::BeginArray:
+                node->_type = JsonValue::Type::ArrayType;
+                frames.push_back(std::make_pair(node,items.size()));
+                break;
+            default:
+                break;
+        }
+
+        if (frames.empty()) {
+            return true;
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Internal Helpers
+/**
+ * Returns the error event, recording the error position and message.
+ *
+ * @param pos   The position of the error
+ * @param msg   The error description
+ *
+ * @return the error event
+ */
+JsonParser::Event JsonParser::fail(const char* pos, const char* msg) {
+    _errorPos = pos;
+    _errorMsg = msg;
+    _event = Event::Error;
+    return _event;
+}
+
+/**
+ * Returns the event for the value at the read position.
+ *
+ * @return the event for the value at the read position.
+ */
+JsonParser::Event JsonParser::readToken() {
+    if (_curr >= _end) {
+        return fail(_curr,"Unexpected end of JSON");
+    }
+
+    size_t left = _end-_curr;
+    switch (*_curr) {
+        case '{':
+            _curr++;
+            _stack.push_back('{');
+            _state = STATE_FIRST_KEY;
+            _event = Event::BeginObject;
+            return _event;
+        case '[':
+            _curr++;
+            _stack.push_back('[');
+            _state = STATE_FIRST_ITEM;
+            _event = Event::BeginArray;
+            return _event;
+        case '\"':
+            if (!readString()) {
+                return _event;
+            }
+            endValue();
+            _event = Event::StringValue;
+            return _event;
+        case 'n':
+            if (left >= 4 && !strncmp(_curr,"null",4)) {
+                _curr += 4;
+                endValue();
+                _event = Event::NullValue;
+                return _event;
+            }
+            break;
+        case 't':
+            if (left >= 4 && !strncmp(_curr,"true",4)) {
+                _curr += 4;
+                _boolValue = true;
+                endValue();
+                _event = Event::BoolValue;
+                return _event;
+            }
+            break;
+        case 'f':
+            if (left >= 5 && !strncmp(_curr,"false",5)) {
+                _curr += 5;
+                _boolValue = false;
+                endValue();
+                _event = Event::BoolValue;
+                return _event;
+            }
+            break;
+        default:
+            if (*_curr == '-' || (*_curr >= '0' && *_curr <= '9')) {
+                readNumber();
+                endValue();
+                _event = Event::NumberValue;
+                return _event;
+            }
+            break;
+    }
+    return fail(_curr,"Invalid token");
+}
+
+/**
+ * Reads the string at the read position, storing it in {@link #_stringValue}.
+ *
+ * @return false if the string is malformed
+ */
+bool JsonParser::readString() {
+    const char* start = _curr;
+    const char* ptr = _curr+1;
+
+    // Fast path: no escape characters means no copy
+    while (ptr < _end && *ptr != '\"' && *ptr != '\\') {
+        ptr++;
+    }
+    if (ptr >= _end) {
+        fail(start,"Unterminated string");
+        return false;
+    } else if (*ptr == '\"') {
+        _stringValue = std::string_view(start+1,ptr-start-1);
+        _curr = ptr+1;
+        return true;
+    }
+
+    // Decode the escape characters into the scratch buffer
+    _scratch.assign(start+1,ptr);
+    while (ptr < _end && *ptr != '\"') {
+        if (*ptr != '\\') {
+            _scratch.push_back(*ptr++);
+            continue;
+        }
+        ptr++;
+        if (ptr >= _end) {
+            break;
+        }
+        switch (*ptr) {
+            case 'b':
+                _scratch.push_back('\b');
+                break;
+            case 'f':
+                _scratch.push_back('\f');
+                break;
+            case 'n':
+                _scratch.push_back('\n');
+                break;
+            case 'r':
+                _scratch.push_back('\r');
+                break;
+            case 't':
+                _scratch.push_back('\t');
+                break;
+            case '\"':
+            case '\\':
+            case '/':
+                _scratch.push_back(*ptr);
+                break;
+            case 'u':
+            {
+                // Transcode UTF16 to UTF8
+                if (_end-ptr < 5) {
+                    fail(start,"Invalid unicode escape");
+                    return false;
+                }
+                unsigned uc = parse_hex4(ptr+1);
+                ptr += 4;
+                if ((uc >= 0xDC00 && uc <= 0xDFFF) || uc == 0) {
+                    fail(start,"Invalid unicode escape");
+                    return false;
+                }
+                if (uc >= 0xD800 && uc <= 0xDBFF) {
+                    if (_end-ptr < 7 || ptr[1] != '\\' || ptr[2] != 'u') {
+                        fail(start,"Missing unicode surrogate");
+                        return false;
+                    }
+                    unsigned uc2 = parse_hex4(ptr+3);
+                    ptr += 6;
+                    if (uc2 < 0xDC00 || uc2 > 0xDFFF) {
+                        fail(start,"Invalid unicode surrogate");
+                        return false;
+                    }
+                    uc = 0x10000 + (((uc & 0x3FF) << 10) | (uc2 & 0x3FF));
+                }
+                append_utf8(_scratch,uc);
+                break;
+            }
+            default:
+                fail(start,"Invalid escape character");
+                return false;
+        }
+        ptr++;
+    }
+
+    if (ptr >= _end) {
+        fail(start,"Unterminated string");
+        return false;
+    }
+    _stringValue = std::string_view(_scratch);
+    _curr = ptr+1;
+    return true;
+}
+
+/**
+ * Reads the number at the read position, storing it in {@link #_numberValue}.
+ */
+void JsonParser::readNumber() {
+    // Match the CUJSON algorithm so results are identical
+    double n = 0;
+    double sign = 1;
+    double scale = 0;
+    int subscale = 0;
+    int signsubscale = 1;
+
+    if (_curr < _end && *_curr == '-') {
+        sign = -1;
+        _curr++;
+    }
+    if (_curr < _end && *_curr == '0') {
+        _curr++;
+    }
+    if (_curr < _end && *_curr >= '1' && *_curr <= '9') {
+        do {
+            n = (n*10.0)+(*_curr++ - '0');
+        } while (_curr < _end && *_curr >= '0' && *_curr <= '9');
+    }
+    if (_end-_curr > 1 && *_curr == '.' && _curr[1] >= '0' && _curr[1] <= '9') {
+        _curr++;
+        do {
+            n = (n*10.0)+(*_curr++ - '0');
+            scale--;
+        } while (_curr < _end && *_curr >= '0' && *_curr <= '9');
+    }
+    if (_curr < _end && (*_curr == 'e' || *_curr == 'E')) {
+        _curr++;
+        if (_curr < _end && *_curr == '+') {
+            _curr++;
+        } else if (_curr < _end && *_curr == '-') {
+            signsubscale = -1;
+            _curr++;
+        }
+        while (_curr < _end && *_curr >= '0' && *_curr <= '9') {
+            subscale = (subscale*10)+(*_curr++ - '0');
+        }
+    }
+
+    _numberValue = sign*n*pow(10.0,(scale+subscale*signsubscale));
+}
+
+/**
+ * Updates the parsing state after a complete value.
+ */
+void JsonParser::endValue() {
+    if (_stack.empty()) {
+        _state = STATE_DONE;
+    } else if (_stack.back() == '{') {
+        _state = STATE_OBJECT_NEXT;
+    } else {
+        _state = STATE_ARRAY_NEXT;
+    }
+}
@@ -487,6 +487,33 @@ float* Affine2::multiply(const float* mat, float scalar, float* dst, size_t stri
  * @return A reference to dst for chaining
  */
 Affine2* Affine2::multiply(const Affine2& m1, const Affine2& m2, Affine2* dst) {
+#if defined CU_MATH_VECTOR_SSE
+    // Need to be prepared for them to be the same
+    float tx = m2.m[0] * m1.m[4] + m2.m[2] * m1.m[5] + m2.m[4];
+    float ty = m2.m[1] * m1.m[4] + m2.m[3] * m1.m[5] + m2.m[5];
+    __m128 l1 = _mm_loadu_ps(m1.m);
+    __m128 l2 = _mm_loadu_ps(m2.m);
+    __m128 xs = _mm_shuffle_ps(l1,l1,_MM_SHUFFLE(2,2,0,0));
+    __m128 ys = _mm_shuffle_ps(l1,l1,_MM_SHUFFLE(3,3,1,1));
+    __m128 r  = _mm_add_ps(_mm_mul_ps(_mm_movelh_ps(l2,l2),xs),
+                           _mm_mul_ps(_mm_movehl_ps(l2,l2),ys));
+    _mm_storeu_ps(dst->m,r);
+    dst->m[4] = tx;
+    dst->m[5] = ty;
+#elif defined CU_MATH_VECTOR_NEON64
+    // Need to be prepared for them to be the same
+    float tx = m2.m[0] * m1.m[4] + m2.m[2] * m1.m[5] + m2.m[4];
+    float ty = m2.m[1] * m1.m[4] + m2.m[3] * m1.m[5] + m2.m[5];
+    float32x4_t l1 = vld1q_f32(m1.m);
+    float32x4_t l2 = vld1q_f32(m2.m);
+    float32x4_t cs = vcombine_f32(vget_low_f32(l2),vget_low_f32(l2));
+    float32x4_t ds = vcombine_f32(vget_high_f32(l2),vget_high_f32(l2));
+    float32x4_t r  = vmulq_f32(cs,vtrn1q_f32(l1,l1));
+    r = vmlaq_f32(r,ds,vtrn2q_f32(l1,l1));
+    vst1q_f32(dst->m,r);
+    dst->m[4] = tx;
+    dst->m[5] = ty;
+#else
     // Need to be prepared for them to be the same
     float a  = m2.m[0] * m1.m[0] + m2.m[2] * m1.m[1];
     float b  = m2.m[0] * m1.m[2] + m2.m[2] * m1.m[3];
@@ -500,6 +527,7 @@ Affine2* Affine2::multiply(const Affine2& m1, const Affine2& m2, Affine2* dst) {
     dst->m[3] = d;
     dst->m[4] = tx;
     dst->m[5] = ty;
+#endif
     return dst;
 }
 
@@ -955,7 +983,35 @@ Vec2* Affine2::transform(const Affine2& aff, const Vec2 point, Vec2* dst) {
  * @return A reference to dst for chaining
  */
 float* Affine2::transform(const Affine2& aff, float const* input, float* output, size_t size) {
-    for(size_t ii = 0; ii < size; ii++) {
+    size_t start = 0;
+#if defined CU_MATH_VECTOR_SSE
+    // Transform two points at a time
+    __m128 cs = _mm_setr_ps(aff.m[0],aff.m[1],aff.m[0],aff.m[1]);
+    __m128 ds = _mm_setr_ps(aff.m[2],aff.m[3],aff.m[2],aff.m[3]);
+    __m128 ts = _mm_setr_ps(aff.m[4],aff.m[5],aff.m[4],aff.m[5]);
+    for(; start+1 < size; start += 2) {
+        __m128 v  = _mm_loadu_ps(input+2*start);
+        __m128 xs = _mm_shuffle_ps(v,v,_MM_SHUFFLE(2,2,0,0));
+        __m128 ys = _mm_shuffle_ps(v,v,_MM_SHUFFLE(3,3,1,1));
+        __m128 r  = _mm_add_ps(_mm_mul_ps(cs,xs),_mm_mul_ps(ds,ys));
+        _mm_storeu_ps(output+2*start,_mm_add_ps(r,ts));
+    }
+#elif defined CU_MATH_VECTOR_NEON64
+    // Transform two points at a time
+    float32x2_t cl = vld1_f32(aff.m);
+    float32x2_t dl = vld1_f32(aff.m+2);
+    float32x2_t tl = vld1_f32(aff.m+4);
+    float32x4_t cs = vcombine_f32(cl,cl);
+    float32x4_t ds = vcombine_f32(dl,dl);
+    float32x4_t ts = vcombine_f32(tl,tl);
+    for(; start+1 < size; start += 2) {
+        float32x4_t v = vld1q_f32(input+2*start);
+        float32x4_t r = vmlaq_f32(ts,cs,vtrn1q_f32(v,v));
+        r = vmlaq_f32(r,ds,vtrn2q_f32(v,v));
+        vst1q_f32(output+2*start,r);
+    }
+#endif
+    for(size_t ii = start; ii < size; ii++) {
         float x = aff.m[0]*input[2*ii]+aff.m[2]*input[2*ii+1]+aff.m[4];
         float y = aff.m[1]*input[2*ii]+aff.m[3]*input[2*ii+1]+aff.m[5];
         output[2*ii  ] = x;
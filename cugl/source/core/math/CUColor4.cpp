@@ -1803,6 +1803,62 @@ Color4* Color4::blendPre(Color4 c1, Color4 c2, Color4* dst) {
     return dst;
 }
 
+/**
+ * Multiplies an array of packed colors by the given tint.
+ *
+ * The colors are in the format returned by {@link #getPacked}. Each
+ * component is multiplied by the corresponding component of tint
+ * (interpreted in the range 0..1), and the result is rounded to the
+ * nearest byte. This is the operation used to tint vertex colors, and
+ * it is vectorized when the math library has vector support.
+ *
+ * It is safe for input and output to be the same array.
+ *
+ * @param input     The array of packed colors
+ * @param tint      The color to multiply by
+ * @param output    The array to store the results
+ * @param size      The number of colors in the two arrays
+ *
+ * @return A reference to output for chaining
+ */
+Uint32* Color4::multiply(const Uint32* input, Color4 tint, Uint32* output, size_t size) {
+    size_t start = 0;
+    // Rounded division by 255 is (v + 128 + ((v + 128) >> 8)) >> 8
+#if defined CU_MATH_VECTOR_SSE
+    __m128i zero  = _mm_setzero_si128();
+    __m128i shade = _mm_unpacklo_epi8(_mm_set1_epi32((int)tint.rgba),zero);
+    __m128i half  = _mm_set1_epi16(128);
+    for(; start+3 < size; start += 4) {
+        __m128i v  = _mm_loadu_si128((const __m128i*)(input+start));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(v,zero),shade),half);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(v,zero),shade),half);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo,_mm_srli_epi16(lo,8)),8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi,_mm_srli_epi16(hi,8)),8);
+        _mm_storeu_si128((__m128i*)(output+start),_mm_packus_epi16(lo,hi));
+    }
+#elif defined CU_MATH_VECTOR_NEON64
+    uint8x8_t shade = vreinterpret_u8_u32(vdup_n_u32(tint.rgba));
+    for(; start+3 < size; start += 4) {
+        uint8x16_t v  = vld1q_u8((const uint8_t*)(input+start));
+        uint16x8_t lo = vmull_u8(vget_low_u8(v),shade);
+        uint16x8_t hi = vmull_u8(vget_high_u8(v),shade);
+        uint8x8_t  rl = vraddhn_u16(lo,vrshrq_n_u16(lo,8));
+        uint8x8_t  rh = vraddhn_u16(hi,vrshrq_n_u16(hi,8));
+        vst1q_u8((uint8_t*)(output+start),vcombine_u8(rl,rh));
+    }
+#endif
+    const Uint8 factor[4] = { tint.r, tint.g, tint.b, tint.a };
+    for(size_t ii = start; ii < size; ii++) {
+        const Uint8* src = (const Uint8*)(input+ii);
+        Uint8* dst = (Uint8*)(output+ii);
+        for(int jj = 0; jj < 4; jj++) {
+            Uint32 v = src[jj]*factor[jj]+128;
+            dst[jj] = (Uint8)((v+(v >> 8)) >> 8);
+        }
+    }
+    return output;
+}
+
 /**
  * Returns a blend of this color with the other one.
  *
@@ -33,6 +33,7 @@
 #include <cugl/core/math/CUFrustum.h>
 #include <cugl/core/util/CUDebug.h>
 #include <cstring>
+#include <cmath>
 
 using namespace cugl;
 
@@ -54,15 +55,20 @@ static float CLIP_SPACE_POINTS[8*3] = {
 Frustum& Frustum::set(const Mat4& inverseView) {
     std::memcpy(_points, CLIP_SPACE_POINTS, CORNER_COUNT*sizeof(Vec3));
     for (int ii = 0; ii <  CORNER_COUNT; ii++) {
-        Mat4::transform(inverseView,_points[ii],&_points[ii]);
+        // Perspective matrices require the homogeneous divide
+        Vec4 point(_points[ii],1.0f);
+        Mat4::transform(inverseView,point,&point);
+        _points[ii].set(point.x/point.w,point.y/point.w,point.z/point.w);
     }
     
-    _planes[0].set(_points[1], _points[2], _points[0]);
-    _planes[1].set(_points[4], _points[7], _points[5]);
-    _planes[2].set(_points[0], _points[3], _points[4]);
-    _planes[3].set(_points[5], _points[6], _points[1]);
-    _planes[4].set(_points[2], _points[6], _points[3]);
-    _planes[5].set(_points[4], _points[1], _points[0]);
+    
+    // Wind the planes so that the normals face into the frustum
+    _planes[0].set(_points[1], _points[0], _points[2]);
+    _planes[1].set(_points[4], _points[5], _points[7]);
+    _planes[2].set(_points[0], _points[4], _points[3]);
+    _planes[3].set(_points[5], _points[1], _points[6]);
+    _planes[4].set(_points[2], _points[3], _points[6]);
+    _planes[5].set(_points[4], _points[0], _points[1]);
     return *this;
 }
 
@@ -169,37 +175,27 @@ Frustum::Region Frustum::findSphereWithoutNearFar (const Vec3 center, float radi
  */
 Frustum::Region Frustum::findBox(float x, float y, float z,
                                  float halfWidth, float halfHeight, float halfDepth) {
-    Vec3 corner[8];
-    corner[0].set(x + halfWidth, y + halfHeight, z + halfDepth);
-    corner[1].set(x + halfWidth, y + halfHeight, z - halfDepth);
-    corner[2].set(x + halfWidth, y - halfHeight, z + halfDepth);
-    corner[3].set(x + halfWidth, y - halfHeight, z - halfDepth);
-    corner[4].set(x - halfWidth, y + halfHeight, z + halfDepth);
-    corner[5].set(x - halfWidth, y + halfHeight, z - halfDepth);
-    corner[6].set(x - halfWidth, y - halfHeight, z + halfDepth);
-    corner[7].set(x - halfWidth, y - halfHeight, z - halfDepth);
-
+    // Compare the center distance to the box extent along each plane normal
     int totalIN = 0;
     for (int ii = 0; ii < PLANE_COUNT; ii++) {
-        int countIN = 8;
-        int pointIN = 1;
-        for(int jj = 0; jj < 8; ++jj) {
-            if (_planes[ii].sideOf(corner[jj]) == Plane::Side::BACK) {
-                pointIN = 0;
-                --countIN;
-            }
-        }
-            
-        // Nothing was on the right side.
-        if (countIN == 0) {
+        const Vec3& normal = _planes[ii].normal;
+        float dist = normal.x*x + normal.y*y + normal.z*z + _planes[ii].offset;
+        float span = std::fabs(normal.x)*halfWidth + std::fabs(normal.y)*halfHeight +
+                     std::fabs(normal.z)*halfDepth;
+        
+        // Every corner is behind this plane
+        if (dist + span < 0) {
             return Region::OUTSIDE;
         }
-            
-        totalIN += pointIN;
+        
+        // Every corner is in front of (or on) this plane
+        if (dist - span >= 0) {
+            totalIN++;
+        }
     }
         
     // All points are inside
-    if (totalIN == 6) {
+    if (totalIN == PLANE_COUNT) {
         return Region::INSIDE;
     }
         
@@ -6,12 +6,10 @@
 //  matrix in OpenGL.  The class has support for basic camera creation, as well
 //  as the traditional transforms.  It can transform any of Vec2, Vec3, and Vec4.
 //
-//  Even though this class is a candidate for vectorization, we have avoided it.
-//  Vectorization only pays off when working with long arrays of vectors. In
-//  addition, the vectorization APIs are a continual moving target. Most of the
-//  time, it is best to enable auto-vectorization in your compiler. Indeed, in
-//  our experiments, naive code with -O3 outperforms the manual vectorization
-//  by almost a full order of magnitude.
+//  Matrix multiplication, inversion, and the array transforms have explicit
+//  vector implementations. These are enabled when the build system defines
+//  either CU_MATH_VECTOR_SSE or CU_MATH_VECTOR_NEON64. Otherwise, this class
+//  falls back to scalar code and relies on the compiler to auto-vectorize.
 //
 //  Because math objects are intended to be on the stack, we do not provide
 //  any shared pointer support in this class.
@@ -1204,28 +1202,7 @@ float* Mat4::multiply(const float* mat, float scalar, float* dst) {
  * @return A reference to dst for chaining
  */
 Mat4* Mat4::multiply(const Mat4& m1, const Mat4& m2, Mat4* dst) {
-    float product[16];
-    product[0]  = m2.m[0] * m1.m[0]  + m2.m[4] * m1.m[1] + m2.m[8]   * m1.m[2]  + m2.m[12] * m1.m[3];
-    product[1]  = m2.m[1] * m1.m[0]  + m2.m[5] * m1.m[1] + m2.m[9]   * m1.m[2]  + m2.m[13] * m1.m[3];
-    product[2]  = m2.m[2] * m1.m[0]  + m2.m[6] * m1.m[1] + m2.m[10]  * m1.m[2]  + m2.m[14] * m1.m[3];
-    product[3]  = m2.m[3] * m1.m[0]  + m2.m[7] * m1.m[1] + m2.m[11]  * m1.m[2]  + m2.m[15] * m1.m[3];
-    
-    product[4]  = m2.m[0] * m1.m[4]  + m2.m[4] * m1.m[5] + m2.m[8]   * m1.m[6]  + m2.m[12] * m1.m[7];
-    product[5]  = m2.m[1] * m1.m[4]  + m2.m[5] * m1.m[5] + m2.m[9]   * m1.m[6]  + m2.m[13] * m1.m[7];
-    product[6]  = m2.m[2] * m1.m[4]  + m2.m[6] * m1.m[5] + m2.m[10]  * m1.m[6]  + m2.m[14] * m1.m[7];
-    product[7]  = m2.m[3] * m1.m[4]  + m2.m[7] * m1.m[5] + m2.m[11]  * m1.m[6]  + m2.m[15] * m1.m[7];
-    
-    product[8]  = m2.m[0] * m1.m[8]  + m2.m[4] * m1.m[9] + m2.m[8]   * m1.m[10] + m2.m[12] * m1.m[11];
-    product[9]  = m2.m[1] * m1.m[8]  + m2.m[5] * m1.m[9] + m2.m[9]   * m1.m[10] + m2.m[13] * m1.m[11];
-    product[10] = m2.m[2] * m1.m[8]  + m2.m[6] * m1.m[9] + m2.m[10]  * m1.m[10] + m2.m[14] * m1.m[11];
-    product[11] = m2.m[3] * m1.m[8]  + m2.m[7] * m1.m[9] + m2.m[11]  * m1.m[10] + m2.m[15] * m1.m[11];
-    
-    product[12] = m2.m[0] * m1.m[12] + m2.m[4] * m1.m[13] + m2.m[8]  * m1.m[14] + m2.m[12] * m1.m[15];
-    product[13] = m2.m[1] * m1.m[12] + m2.m[5] * m1.m[13] + m2.m[9]  * m1.m[14] + m2.m[13] * m1.m[15];
-    product[14] = m2.m[2] * m1.m[12] + m2.m[6] * m1.m[13] + m2.m[10] * m1.m[14] + m2.m[14] * m1.m[15];
-    product[15] = m2.m[3] * m1.m[12] + m2.m[7] * m1.m[13] + m2.m[11] * m1.m[14] + m2.m[15] * m1.m[15];
-    
-    std::memcpy(&(dst->m[0]), &(product[0]), MATRIX_SIZE);
+    multiply(m1.m, m2.m, dst->m);
     return dst;
 }
 
@@ -1244,6 +1221,45 @@ Mat4* Mat4::multiply(const Mat4& m1, const Mat4& m2, Mat4* dst) {
  * @return A reference to dst for chaining
  */
 float* Mat4::multiply(const float* m1, const float* m2, float* dst) {
+#if defined CU_MATH_VECTOR_SSE
+    // Each column of the product is a linear combination of the m2 columns
+    __m128 c0 = _mm_loadu_ps(m2);
+    __m128 c1 = _mm_loadu_ps(m2+4);
+    __m128 c2 = _mm_loadu_ps(m2+8);
+    __m128 c3 = _mm_loadu_ps(m2+12);
+    __m128 product[4];
+    for(int ii = 0; ii < 4; ii++) {
+        const float* col = m1+4*ii;
+        __m128 r = _mm_mul_ps(c0,_mm_set1_ps(col[0]));
+        r = _mm_add_ps(r,_mm_mul_ps(c1,_mm_set1_ps(col[1])));
+        r = _mm_add_ps(r,_mm_mul_ps(c2,_mm_set1_ps(col[2])));
+        r = _mm_add_ps(r,_mm_mul_ps(c3,_mm_set1_ps(col[3])));
+        product[ii] = r;
+    }
+    // Support the case where m1 or m2 == dst.
+    for(int ii = 0; ii < 4; ii++) {
+        _mm_storeu_ps(dst+4*ii,product[ii]);
+    }
+#elif defined CU_MATH_VECTOR_NEON64
+    // Each column of the product is a linear combination of the m2 columns
+    float32x4_t c0 = vld1q_f32(m2);
+    float32x4_t c1 = vld1q_f32(m2+4);
+    float32x4_t c2 = vld1q_f32(m2+8);
+    float32x4_t c3 = vld1q_f32(m2+12);
+    float32x4_t product[4];
+    for(int ii = 0; ii < 4; ii++) {
+        const float* col = m1+4*ii;
+        float32x4_t r = vmulq_n_f32(c0,col[0]);
+        r = vmlaq_n_f32(r,c1,col[1]);
+        r = vmlaq_n_f32(r,c2,col[2]);
+        r = vmlaq_n_f32(r,c3,col[3]);
+        product[ii] = r;
+    }
+    // Support the case where m1 or m2 == dst.
+    for(int ii = 0; ii < 4; ii++) {
+        vst1q_f32(dst+4*ii,product[ii]);
+    }
+#else
     float product[16];
     product[0]  = m2[0] * m1[0]  + m2[4] * m1[1] + m2[8]   * m1[2]  + m2[12] * m1[3];
     product[1]  = m2[1] * m1[0]  + m2[5] * m1[1] + m2[9]   * m1[2]  + m2[13] * m1[3];
@@ -1266,6 +1282,7 @@ float* Mat4::multiply(const float* m1, const float* m2, float* dst) {
     product[15] = m2[3] * m1[12] + m2[7] * m1[13] + m2[11] * m1[14] + m2[15] * m1[15];
     
     std::memcpy(dst, &(product[0]), MATRIX_SIZE);
+#endif
     return dst;
 }
 
@@ -1366,52 +1383,7 @@ float* Mat4::transpose(const float* m1, float* dst) {
  * @return A reference to dst for chaining
  */
 Mat4* Mat4::invert(const Mat4& m1, Mat4* dst) {
-    float a0 = m1.m[0]  * m1.m[5] -  m1.m[1]  * m1.m[4];
-    float a1 = m1.m[0]  * m1.m[6] -  m1.m[2]  * m1.m[4];
-    float a2 = m1.m[0]  * m1.m[7] -  m1.m[3]  * m1.m[4];
-    float a3 = m1.m[1]  * m1.m[6] -  m1.m[2]  * m1.m[5];
-    float a4 = m1.m[1]  * m1.m[7] -  m1.m[3]  * m1.m[5];
-    float a5 = m1.m[2]  * m1.m[7] -  m1.m[3]  * m1.m[6];
-    float b0 = m1.m[8]  * m1.m[13] - m1.m[9]  * m1.m[12];
-    float b1 = m1.m[8]  * m1.m[14] - m1.m[10] * m1.m[12];
-    float b2 = m1.m[8]  * m1.m[15] - m1.m[11] * m1.m[12];
-    float b3 = m1.m[9]  * m1.m[14] - m1.m[10] * m1.m[13];
-    float b4 = m1.m[9]  * m1.m[15] - m1.m[11] * m1.m[13];
-    float b5 = m1.m[10] * m1.m[15] - m1.m[11] * m1.m[14];
-    
-    // Calculate the determinant.
-    float det = a0 * b5 - a1 * b4 + a2 * b3 + a3 * b2 - a4 * b1 + a5 * b0;
-    
-    // Close to zero, can't invert.
-    if (fabs(det) <= CU_MATH_FLOAT_SMALL) {
-        dst->setZero();
-        return dst;
-    }
-    
-    // Support the case where m1 == dst.
-    Mat4 inverse;
-    inverse.m[0]  =  m1.m[5]  * b5 - m1.m[6]  * b4 + m1.m[7]  * b3;
-    inverse.m[1]  = -m1.m[1]  * b5 + m1.m[2]  * b4 - m1.m[3]  * b3;
-    inverse.m[2]  =  m1.m[13] * a5 - m1.m[14] * a4 + m1.m[15] * a3;
-    inverse.m[3]  = -m1.m[9]  * a5 + m1.m[10] * a4 - m1.m[11] * a3;
-    
-    inverse.m[4]  = -m1.m[4]  * b5 + m1.m[6]  * b2 - m1.m[7]  * b1;
-    inverse.m[5]  =  m1.m[0]  * b5 - m1.m[2]  * b2 + m1.m[3]  * b1;
-    inverse.m[6]  = -m1.m[12] * a5 + m1.m[14] * a2 - m1.m[15] * a1;
-    inverse.m[7]  =  m1.m[8]  * a5 - m1.m[10] * a2 + m1.m[11] * a1;
-    
-    inverse.m[8]  =  m1.m[4]  * b4 - m1.m[5]  * b2 + m1.m[7]  * b0;
-    inverse.m[9]  = -m1.m[0]  * b4 + m1.m[1]  * b2 - m1.m[3]  * b0;
-    inverse.m[10] =  m1.m[12] * a4 - m1.m[13] * a2 + m1.m[15] * a0;
-    inverse.m[11] = -m1.m[8]  * a4 + m1.m[9]  * a2 - m1.m[11] * a0;
-    
-    inverse.m[12] = -m1.m[4]  * b3 + m1.m[5]  * b1 - m1.m[6]  * b0;
-    inverse.m[13] =  m1.m[0]  * b3 - m1.m[1]  * b1 + m1.m[2]  * b0;
-    inverse.m[14] = -m1.m[12] * a3 + m1.m[13] * a1 - m1.m[14] * a0;
-    inverse.m[15] =  m1.m[8]  * a3 - m1.m[9]  * a1 + m1.m[10] * a0;
-    
-    multiply(inverse, 1.0f / det, dst);
-
+    invert(m1.m, dst->m);
     return dst;
 }
 
@@ -1451,6 +1423,73 @@ float* Mat4::invert(const float* m1, float* dst) {
         return dst;
     }
     
+#if defined CU_MATH_VECTOR_SSE || defined CU_MATH_VECTOR_NEON64
+    // Each column of the adjugate is a signed sum of three products. The
+    // vectors p0-p3 are the matrix entries and k0-k5 are the 2x2 minors.
+    float inv = 1.0f / det;
+    const float pv[16] = {
+        m1[4], m1[0], m1[12], m1[8],
+        m1[5], m1[1], m1[13], m1[9],
+        m1[6], m1[2], m1[14], m1[10],
+        m1[7], m1[3], m1[15], m1[11]
+    };
+    const float kv[24] = {
+        b0, b0, a0, a0,  b1, b1, a1, a1,  b2, b2, a2, a2,
+        b3, b3, a3, a3,  b4, b4, a4, a4,  b5, b5, a5, a5
+    };
+    const float sv[8] = { inv, -inv, inv, -inv, -inv, inv, -inv, inv };
+#endif
+#if defined CU_MATH_VECTOR_SSE
+    __m128 p0 = _mm_loadu_ps(pv);
+    __m128 p1 = _mm_loadu_ps(pv+4);
+    __m128 p2 = _mm_loadu_ps(pv+8);
+    __m128 p3 = _mm_loadu_ps(pv+12);
+    __m128 k0 = _mm_loadu_ps(kv);
+    __m128 k1 = _mm_loadu_ps(kv+4);
+    __m128 k2 = _mm_loadu_ps(kv+8);
+    __m128 k3 = _mm_loadu_ps(kv+12);
+    __m128 k4 = _mm_loadu_ps(kv+16);
+    __m128 k5 = _mm_loadu_ps(kv+20);
+    __m128 sp = _mm_loadu_ps(sv);
+    __m128 sn = _mm_loadu_ps(sv+4);
+    
+    __m128 r0 = _mm_sub_ps(_mm_mul_ps(p1,k5),_mm_mul_ps(p2,k4));
+    r0 = _mm_mul_ps(_mm_add_ps(r0,_mm_mul_ps(p3,k3)),sp);
+    __m128 r1 = _mm_sub_ps(_mm_mul_ps(p0,k5),_mm_mul_ps(p2,k2));
+    r1 = _mm_mul_ps(_mm_add_ps(r1,_mm_mul_ps(p3,k1)),sn);
+    __m128 r2 = _mm_sub_ps(_mm_mul_ps(p0,k4),_mm_mul_ps(p1,k2));
+    r2 = _mm_mul_ps(_mm_add_ps(r2,_mm_mul_ps(p3,k0)),sp);
+    __m128 r3 = _mm_sub_ps(_mm_mul_ps(p0,k3),_mm_mul_ps(p1,k1));
+    r3 = _mm_mul_ps(_mm_add_ps(r3,_mm_mul_ps(p2,k0)),sn);
+    
+    _mm_storeu_ps(dst,   r0);
+    _mm_storeu_ps(dst+4, r1);
+    _mm_storeu_ps(dst+8, r2);
+    _mm_storeu_ps(dst+12,r3);
+#elif defined CU_MATH_VECTOR_NEON64
+    float32x4_t p0 = vld1q_f32(pv);
+    float32x4_t p1 = vld1q_f32(pv+4);
+    float32x4_t p2 = vld1q_f32(pv+8);
+    float32x4_t p3 = vld1q_f32(pv+12);
+    float32x4_t k0 = vld1q_f32(kv);
+    float32x4_t k1 = vld1q_f32(kv+4);
+    float32x4_t k2 = vld1q_f32(kv+8);
+    float32x4_t k3 = vld1q_f32(kv+12);
+    float32x4_t k4 = vld1q_f32(kv+16);
+    float32x4_t k5 = vld1q_f32(kv+20);
+    float32x4_t sp = vld1q_f32(sv);
+    float32x4_t sn = vld1q_f32(sv+4);
+    
+    float32x4_t r0 = vmlaq_f32(vmlsq_f32(vmulq_f32(p1,k5),p2,k4),p3,k3);
+    float32x4_t r1 = vmlaq_f32(vmlsq_f32(vmulq_f32(p0,k5),p2,k2),p3,k1);
+    float32x4_t r2 = vmlaq_f32(vmlsq_f32(vmulq_f32(p0,k4),p1,k2),p3,k0);
+    float32x4_t r3 = vmlaq_f32(vmlsq_f32(vmulq_f32(p0,k3),p1,k1),p2,k0);
+    
+    vst1q_f32(dst,   vmulq_f32(r0,sp));
+    vst1q_f32(dst+4, vmulq_f32(r1,sn));
+    vst1q_f32(dst+8, vmulq_f32(r2,sp));
+    vst1q_f32(dst+12,vmulq_f32(r3,sn));
+#else
     // Support the case where m1 == dst.
     float inverse[16];
     inverse[0]  =  m1[5]  * b5 - m1[6]  * b4 + m1[7]  * b3;
@@ -1474,6 +1513,7 @@ float* Mat4::invert(const float* m1, float* dst) {
     inverse[15] =  m1[8]  * a3 - m1[9]  * a1 + m1[10] * a0;
     
     multiply(inverse, 1.0f / det, dst);
+#endif
     return dst;
 }
 
@@ -1770,21 +1810,7 @@ Vec4* Mat4::transform(const Mat4& mat, const Vec4 vec, Vec4* dst) {
  * @return A reference to dst for chaining
  */
 float* Mat4::transform(const Mat4& mat, float const* input, float* output, size_t size) {
-    CUAssertLog(output, "Destination vector is null");
-    for(size_t ii = 0; ii < size; ii++) {
-        // Handle case where v == dst.
-        float x = input[ii*4] * mat.m[0] + input[ii*4+1] * mat.m[4] + input[ii*4+2] * mat.m[8]  + input[ii*4+3] * mat.m[12];
-        float y = input[ii*4] * mat.m[1] + input[ii*4+1] * mat.m[5] + input[ii*4+2] * mat.m[9]  + input[ii*4+3] * mat.m[13];
-        float z = input[ii*4] * mat.m[2] + input[ii*4+1] * mat.m[6] + input[ii*4+2] * mat.m[10] + input[ii*4+3] * mat.m[14];
-        float w = input[ii*4] * mat.m[3] + input[ii*4+1] * mat.m[7] + input[ii*4+2] * mat.m[11] + input[ii*4+3] * mat.m[15];
-        
-        output[ii*4  ] = x;
-        output[ii*4+1] = y;
-        output[ii*4+2] = z;
-        output[ii*4+3] = w;
-    }
-
-    return output;
+    return transform(mat.m, input, output, size);
 }
 
 /**
@@ -1802,6 +1828,35 @@ float* Mat4::transform(const Mat4& mat, float const* input, float* output, size_
  */
 float* Mat4::transform(const float* mat, float const* input, float* output, size_t size) {
     CUAssertLog(output, "Destination vector is null");
+#if defined CU_MATH_VECTOR_SSE
+    __m128 c0 = _mm_loadu_ps(mat);
+    __m128 c1 = _mm_loadu_ps(mat+4);
+    __m128 c2 = _mm_loadu_ps(mat+8);
+    __m128 c3 = _mm_loadu_ps(mat+12);
+    for(size_t ii = 0; ii < size; ii++) {
+        // Handle case where v == dst.
+        const float* v = input+4*ii;
+        __m128 r = _mm_mul_ps(c0,_mm_set1_ps(v[0]));
+        r = _mm_add_ps(r,_mm_mul_ps(c1,_mm_set1_ps(v[1])));
+        r = _mm_add_ps(r,_mm_mul_ps(c2,_mm_set1_ps(v[2])));
+        r = _mm_add_ps(r,_mm_mul_ps(c3,_mm_set1_ps(v[3])));
+        _mm_storeu_ps(output+4*ii,r);
+    }
+#elif defined CU_MATH_VECTOR_NEON64
+    float32x4_t c0 = vld1q_f32(mat);
+    float32x4_t c1 = vld1q_f32(mat+4);
+    float32x4_t c2 = vld1q_f32(mat+8);
+    float32x4_t c3 = vld1q_f32(mat+12);
+    for(size_t ii = 0; ii < size; ii++) {
+        // Handle case where v == dst.
+        float32x4_t v = vld1q_f32(input+4*ii);
+        float32x4_t r = vmulq_laneq_f32(c0,v,0);
+        r = vfmaq_laneq_f32(r,c1,v,1);
+        r = vfmaq_laneq_f32(r,c2,v,2);
+        r = vfmaq_laneq_f32(r,c3,v,3);
+        vst1q_f32(output+4*ii,r);
+    }
+#else
     for(size_t ii = 0; ii < size; ii++) {
         // Handle case where v == dst.
         float x = input[ii*4] * mat[0] + input[ii*4+1] * mat[4] + input[ii*4+2] * mat[8]  + input[ii*4+3] * mat[12];
@@ -1814,6 +1869,7 @@ float* Mat4::transform(const float* mat, float const* input, float* output, size
         output[ii*4+2] = z;
         output[ii*4+3] = w;
     }
+#endif
     return output;
 }
 
@@ -4,8 +4,9 @@
 //
 //  This module is a factory for a lightweight earclipping triangulator. While
 //  we do have access to the very powerful Pol2Tri, that API has a lot of overhead
-//  with it. While earclipping is an O(n^2) algorithm, the lower overhead of this
-//  class makes it more performant in smaller applications.
+//  with it. This class keeps the ears in a priority queue and the vertices in a
+//  spatial grid, so typical polygons triangulate in O(n log n) time with very
+//  little overhead.
 //
 //  Because math objects are intended to be on the stack, we do not provide
 //  any shared pointer support in this class.
@@ -39,9 +40,19 @@
 #include <cugl/core/math/CUPoly2.h>
 #include <cugl/core/math/CUPath2.h>
 #include <cugl/core/util/CUDebug.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 
 using namespace cugl;
 
+/** The queue position of a vertex that is not an ear */
+#define NO_EAR          ((size_t)-1)
+/** The average number of vertices in a grid cell */
+#define GRID_DENSITY    2
+/** The grid tolerance (relative to the coordinate size) for round-off error */
+#define GRID_SLOP       (16*FLT_EPSILON)
+
 #pragma mark Support Class
 /**
  * An internal class that manages vertex data
@@ -62,6 +73,12 @@ public:
     bool eartip;
     /** Whether or not this vertex is (currently) active */
     bool active;
+    /** The position of this vertex in the ear queue (NO_EAR if not an ear) */
+    size_t earpos;
+    /** The grid cell containing this vertex */
+    Uint32 cell;
+    /** The position of this vertex in the grid */
+    Uint32 cellpos;
     /** The next vertex along this path */
     Vertex* next;
     /** The previous vertex along this path */
@@ -75,6 +92,9 @@ public:
     angle(0),
     eartip(false),
     active(true),
+    earpos(NO_EAR),
+    cell(0),
+    cellpos(0),
     next(nullptr),
     prev(nullptr) {
     }
@@ -89,6 +109,9 @@ public:
     angle(0),
     eartip(false),
     active(true),
+    earpos(NO_EAR),
+    cell(0),
+    cellpos(0),
     next(nullptr),
     prev(nullptr) {
         index = pos;
@@ -108,6 +131,9 @@ public:
         angle = 0;
         eartip = false;
         active = true;
+        earpos = NO_EAR;
+        cell = 0;
+        cellpos = 0;
         next = nullptr;
         prev = nullptr;
     }
@@ -124,6 +150,9 @@ public:
         dst->angle  = angle;
         dst->eartip = eartip;
         dst->active = active;
+        dst->earpos = earpos;
+        dst->cell   = cell;
+        dst->cellpos = cellpos;
         dst->next = next;
         dst->prev = prev;
     }
@@ -189,10 +218,12 @@ public:
     }
 
     /**
-     * Updates this vertex to determine ear status
+     * Updates the angle of this vertex and its potential ear status
      *
-     * This method should be called whenever an ear is clipped from the
-     * vertex set.
+     * A vertex is a potential ear if it is convex. It is only an ear if
+     * no other vertex lies inside of its ear region, which must be checked
+     * separately. This method should be called whenever an ear is clipped
+     * from the vertex set.
      */
     void update() {
         Vec2 vec1 = prev->coord-coord;
@@ -201,19 +232,22 @@ public:
         vec3.normalize();
         
         angle = vec1.x * vec3.x + vec1.y * vec3.y;
-        if (convex()) {
-            eartip = true;
-            Vertex* curr = next->next;
-            while (curr != prev) {
-                bool test = curr->index != index && curr->index != prev->index && curr->index != next->index;
-                if (test && inside(curr->coord)) {
-                    eartip = false;
-                }
-                curr = curr->next;
-            }
-        } else {
-            eartip = false;
-        }
+        eartip = convex();
+    }
+    
+    /**
+     * Returns true if ear a should be clipped before ear b
+     *
+     * The most extruded ear (the one with the largest angle cosine) is
+     * clipped first. Ties are broken by position in the vertex buffer.
+     *
+     * @param a The first ear
+     * @param b The second ear
+     *
+     * @return true if ear a should be clipped before ear b
+     */
+    static bool before(const Vertex* a, const Vertex* b) {
+        return a->angle > b->angle || (a->angle == b->angle && a < b);
     }
 };
 
@@ -242,6 +276,38 @@ static bool intersects(const Vec2& p11, const Vec2& p12, const Vec2& p21, const
     return !(dot11 * dot12 > 0 || dot21 * dot22 > 0);
 }
 
+/**
+ * Expands the interval [xmin,xmax] to include a line segment clipped to a band
+ *
+ * The band is the horizontal strip with y-coordinates in [ymin,ymax]. If
+ * the line segment does not intersect the band, the interval is unchanged.
+ *
+ * @param p1    The start of the line segment
+ * @param p2    The end of the line segment
+ * @param ymin  The bottom of the band
+ * @param ymax  The top of the band
+ * @param xmin  The minimum of the interval to expand
+ * @param xmax  The maximum of the interval to expand
+ */
+static void span_segment(const Vec2& p1, const Vec2& p2, float ymin, float ymax, float& xmin, float& xmax) {
+    float lo = std::min(p1.y, p2.y);
+    float hi = std::max(p1.y, p2.y);
+    if (hi < ymin || lo > ymax) {
+        return;
+    } else if (lo == hi) {
+        xmin = std::min(xmin, std::min(p1.x, p2.x));
+        xmax = std::max(xmax, std::max(p1.x, p2.x));
+        return;
+    }
+    
+    float t1 = (std::max(lo, ymin)-p1.y)/(p2.y-p1.y);
+    float t2 = (std::min(hi, ymax)-p1.y)/(p2.y-p1.y);
+    float x1 = p1.x+t1*(p2.x-p1.x);
+    float x2 = p1.x+t2*(p2.x-p1.x);
+    xmin = std::min(xmin, std::min(x1, x2));
+    xmax = std::max(xmax, std::max(x1, x2));
+}
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -252,6 +318,10 @@ _vertices(nullptr),
 _exterior(0),
 _vertsize(0),
 _vertlimit(0),
+_gridscale(0),
+_gridcols(0),
+_gridrows(0),
+_gridslop(0),
 _calculated(false) {
 }
 
@@ -270,6 +340,10 @@ _vertices(nullptr),
 _exterior(0),
 _vertsize(0),
 _vertlimit(0),
+_gridscale(0),
+_gridcols(0),
+_gridrows(0),
+_gridslop(0),
 _calculated(false) {
     set(points);
 }
@@ -290,6 +364,10 @@ _vertices(nullptr),
 _exterior(0),
 _vertsize(0),
 _vertlimit(0),
+_gridscale(0),
+_gridcols(0),
+_gridrows(0),
+_gridslop(0),
 _calculated(false) {
     set(path);
 }
@@ -685,39 +763,52 @@ void EarclipTriangulator::removeHoles() {
         Vertex* holepoint = _vertices+holeindx;
         Vertex* bestpoint = nullptr;
 
-        // Find the point on the exterior to connect it to
+        // Rank the exterior points by the angle of the divider
+        std::vector<std::pair<float,Vertex*>> candidates;
         bool repeat = true;
         Vertex* curr = _vertices;
         while (repeat || curr != _vertices) {
             if (curr->coord.x > holepoint->coord.x && curr->incone(holepoint->coord)) {
-                bool checkit = true;
-                if (bestpoint) {
-                    Vec2 v1 = curr->coord-holepoint->coord;
-                    Vec2 v2 = bestpoint->coord-holepoint->coord;
-                    v1.normalize();
-                    v2.normalize();
-                    if (v2.x > v1.x) {
-                        checkit = false;
+                Vec2 v1 = curr->coord-holepoint->coord;
+                v1.normalize();
+                candidates.push_back(std::make_pair(v1.x,curr));
+            }
+            repeat = false;
+            curr = curr->next;
+        }
+        
+        // Ties go to the last point in the exterior
+        std::reverse(candidates.begin(), candidates.end());
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [](const std::pair<float,Vertex*>& a, const std::pair<float,Vertex*>& b) {
+            return a.first > b.first;
+        });
+        
+        // The divider may not cross a hole or the exterior (with merged holes)
+        for(auto it = candidates.begin(); bestpoint == nullptr && it != candidates.end(); ++it) {
+            curr = it->second;
+            bool pointvisible = true;
+            for(size_t ii = 0; pointvisible && ii < holessize; ii++) {
+                for(size_t jj = 0; pointvisible && jj < holesleft[2*ii+1]; jj++) {
+                    Vertex* checkpt = _vertices+holesleft[2*ii]+jj;
+                    Vertex* nextpt  = checkpt->next;
+                    if (intersects(holepoint->coord, curr->coord, checkpt->coord, nextpt->coord)) {
+                        pointvisible = false;
                     }
                 }
-                if (checkit) {
-                    bool pointvisible = true;
-                    for(size_t ii = 0; pointvisible && ii < holessize; ii++) {
-                        for(size_t jj = 0; pointvisible && jj < holesleft[2*ii+1]; jj++) {
-                            Vertex* checkpt = _vertices+holesleft[2*ii]+jj;
-                            Vertex* nextpt  = checkpt->next;
-                            if (intersects(holepoint->coord, curr->coord, checkpt->coord, nextpt->coord)) {
-                                pointvisible = false;
-                            }
-                        }
-                    }
-                    if (pointvisible) {
-                        bestpoint = curr;
-                    }
+            }
+            Vertex* checkpt = _vertices;
+            repeat = true;
+            while (pointvisible && (repeat || checkpt != _vertices)) {
+                if (intersects(holepoint->coord, curr->coord, checkpt->coord, checkpt->next->coord)) {
+                    pointvisible = false;
                 }
+                repeat = false;
+                checkpt = checkpt->next;
+            }
+            if (pointvisible) {
+                bestpoint = curr;
             }
-            repeat = false;
-            curr = curr->next;
         }
         
         if (bestpoint == nullptr) {
@@ -763,42 +854,36 @@ void EarclipTriangulator::computeTriangles() {
     }
     
     // Find some initial ears
+    allocateGrid();
+    _ears.clear();
     for(size_t ii = 0; ii < _vertsize; ii++) {
-        _vertices[ii].update();
+        updateEar(_vertices+ii);
     }
     
     _output.reserve(3*(_vertsize-3));
     for(size_t ii = 0; ii < _vertsize-3; ii++) {
-        Vertex* bestear = nullptr;
-        // Find the most extruded ear.
-        for(size_t jj = 0; jj < _vertsize; jj++) {
-            Vertex* v = _vertices+jj;
-            if (v->active && v->eartip) {
-                if (bestear == nullptr) {
-                    bestear = v;
-                } else if (v->angle > bestear->angle) {
-                    bestear = v;
-                }
-            }
-        }
-        
-        if (bestear == nullptr) {
-            CUAssertLog(bestear != nullptr, "Could not find a suitable ear");
+        if (_ears.empty()) {
+            CUAssertLog(false, "Could not find a suitable ear");
             return;
         }
         
+        // The most extruded ear is at the top of the queue
+        Vertex* bestear = _ears.front();
+        removeEar(bestear);
+        
         _output.push_back(bestear->prev->index);
         _output.push_back(bestear->index);
         _output.push_back(bestear->next->index);
         
         // Cut off the ear
         bestear->active = false;
+        removeGrid(bestear);
         bestear->prev->next = bestear->next;
         bestear->next->prev = bestear->prev;
         
         if (ii != _vertsize - 4) {
-            bestear->prev->update();
-            bestear->next->update();
+            updateEar(bestear->prev);
+            updateEar(bestear->next);
         }
     }
 
@@ -813,3 +898,221 @@ void EarclipTriangulator::computeTriangles() {
         }
     }
 }
+
+/**
+ * Places the active vertices in a uniform grid
+ *
+ * This grid is used to find the vertices inside of a potential ear.
+ */
+void EarclipTriangulator::allocateGrid() {
+    Vec2 minp = _vertices[0].coord;
+    Vec2 maxp = minp;
+    for(size_t ii = 1; ii < _vertsize; ii++) {
+        const Vec2& coord = _vertices[ii].coord;
+        minp.x = std::min(minp.x, coord.x);
+        minp.y = std::min(minp.y, coord.y);
+        maxp.x = std::max(maxp.x, coord.x);
+        maxp.y = std::max(maxp.y, coord.y);
+    }
+    
+    // Choose square cells so that each cell has a few vertices
+    Vec2 extent = maxp-minp;
+    float cells = std::max(1.0f, (float)_vertsize/GRID_DENSITY);
+    float side = std::sqrt(extent.x*extent.y/cells);
+    if (!(side > 0)) {
+        side = std::max(extent.x, extent.y)/cells;
+    }
+    if (!(side > 0)) {
+        side = 1;
+    }
+    _gridorigin = minp;
+    _gridscale = 1/side;
+    _gridcols = (Uint32)std::min(extent.x*_gridscale+1, cells+1);
+    _gridrows = (Uint32)std::min(extent.y*_gridscale+1, cells+1);
+    
+    float bound = std::max(std::max(std::abs(minp.x), std::abs(maxp.x)),
+                           std::max(std::abs(minp.y), std::abs(maxp.y)));
+    _gridslop = GRID_SLOP*(bound+std::max(extent.x, extent.y));
+    
+    // Counting sort by cell
+    size_t total = (size_t)_gridcols*_gridrows;
+    _gridstart.assign(total, 0);
+    _gridcount.assign(total, 0);
+    _gridverts.resize(_vertsize);
+    for(size_t ii = 0; ii < _vertsize; ii++) {
+        Vertex* vertex = _vertices+ii;
+        Uint32 col = std::min((Uint32)((vertex->coord.x-minp.x)*_gridscale), _gridcols-1);
+        Uint32 row = std::min((Uint32)((vertex->coord.y-minp.y)*_gridscale), _gridrows-1);
+        vertex->cell = row*_gridcols+col;
+        _gridcount[vertex->cell]++;
+    }
+    for(size_t ii = 1; ii < total; ii++) {
+        _gridstart[ii] = _gridstart[ii-1]+_gridcount[ii-1];
+    }
+    std::fill(_gridcount.begin(), _gridcount.end(), 0);
+    for(size_t ii = 0; ii < _vertsize; ii++) {
+        Vertex* vertex = _vertices+ii;
+        vertex->cellpos = _gridstart[vertex->cell]+_gridcount[vertex->cell]++;
+        _gridverts[vertex->cellpos] = vertex;
+    }
+}
+
+/**
+ * Removes the given (clipped) vertex from the grid
+ *
+ * @param vertex    The vertex to remove
+ */
+void EarclipTriangulator::removeGrid(Vertex* vertex) {
+    Uint32 last = _gridstart[vertex->cell]+(--_gridcount[vertex->cell]);
+    Vertex* other = _gridverts[last];
+    _gridverts[vertex->cellpos] = other;
+    other->cellpos = vertex->cellpos;
+    _gridverts[last] = vertex;
+    vertex->cellpos = last;
+}
+
+/**
+ * Updates the ear status of the given vertex
+ *
+ * This method should be called whenever a neighbor of the vertex is
+ * clipped. It adds the vertex to the ear queue, moves it in the queue,
+ * or removes it from the queue as appropriate.
+ *
+ * @param vertex    The vertex to update
+ */
+void EarclipTriangulator::updateEar(Vertex* vertex) {
+    vertex->update();
+    if (vertex->eartip && isBlocked(vertex)) {
+        vertex->eartip = false;
+    }
+    
+    if (vertex->eartip) {
+        if (vertex->earpos == NO_EAR) {
+            vertex->earpos = _ears.size();
+            _ears.push_back(vertex);
+        }
+        raiseEar(vertex->earpos);
+        lowerEar(vertex->earpos);
+    } else if (vertex->earpos != NO_EAR) {
+        removeEar(vertex);
+    }
+}
+
+/**
+ * Returns true if another vertex lies inside the ear region of vertex
+ *
+ * The ear region for a vertex is the triangle defined by it and its
+ * two neighbors. Copies of the vertex or its neighbors (created by
+ * slicing holes) are ignored.
+ *
+ * @param vertex    The vertex to check
+ *
+ * @return true if another vertex lies inside the ear region of vertex
+ */
+bool EarclipTriangulator::isBlocked(Vertex* vertex) const {
+    const Vec2& p1 = vertex->prev->coord;
+    const Vec2& p2 = vertex->coord;
+    const Vec2& p3 = vertex->next->coord;
+    
+    // Only check the grid cells overlapping the ear region
+    float miny = std::min(std::min(p1.y, p2.y), p3.y)-_gridslop;
+    float maxy = std::max(std::max(p1.y, p2.y), p3.y)+_gridslop;
+    Uint32 row0 = (Uint32)std::min(std::max((miny-_gridorigin.y)*_gridscale, 0.0f), (float)(_gridrows-1));
+    Uint32 row1 = (Uint32)std::min(std::max((maxy-_gridorigin.y)*_gridscale, 0.0f), (float)(_gridrows-1));
+    
+    for(Uint32 row = row0; row <= row1; row++) {
+        // The span of the ear region in this row (the edge rows are unbounded)
+        float ymin = row == row0 ? miny : _gridorigin.y+row/_gridscale-_gridslop;
+        float ymax = row == row1 ? maxy : _gridorigin.y+(row+1)/_gridscale+_gridslop;
+        float minx = FLT_MAX;
+        float maxx = -FLT_MAX;
+        span_segment(p1, p2, ymin, ymax, minx, maxx);
+        span_segment(p2, p3, ymin, ymax, minx, maxx);
+        span_segment(p3, p1, ymin, ymax, minx, maxx);
+        if (minx > maxx) {
+            continue;
+        }
+        
+        minx = (minx-_gridslop-_gridorigin.x)*_gridscale;
+        maxx = (maxx+_gridslop-_gridorigin.x)*_gridscale;
+        Uint32 col0 = (Uint32)std::min(std::max(minx, 0.0f), (float)(_gridcols-1));
+        Uint32 col1 = (Uint32)std::min(std::max(maxx, 0.0f), (float)(_gridcols-1));
+        for(Uint32 cell = row*_gridcols+col0; cell <= row*_gridcols+col1; cell++) {
+            Vertex* const* curr = _gridverts.data()+_gridstart[cell];
+            Vertex* const* last = curr+_gridcount[cell];
+            for(; curr != last; curr++) {
+                if ((*curr)->index == vertex->index || (*curr)->index == vertex->prev->index ||
+                    (*curr)->index == vertex->next->index) {
+                    continue;
+                }
+                if (vertex->inside((*curr)->coord)) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+
+/**
+ * Moves the ear at the given queue position up to restore the heap
+ *
+ * @param pos   The position in the ear queue
+ */
+void EarclipTriangulator::raiseEar(size_t pos) {
+    Vertex* vertex = _ears[pos];
+    while (pos > 0) {
+        size_t parent = (pos-1)/2;
+        if (!Vertex::before(vertex, _ears[parent])) {
+            break;
+        }
+        _ears[pos] = _ears[parent];
+        _ears[pos]->earpos = pos;
+        pos = parent;
+    }
+    _ears[pos] = vertex;
+    vertex->earpos = pos;
+}
+
+/**
+ * Moves the ear at the given queue position down to restore the heap
+ *
+ * @param pos   The position in the ear queue
+ */
+void EarclipTriangulator::lowerEar(size_t pos) {
+    Vertex* vertex = _ears[pos];
+    size_t size = _ears.size();
+    while (2*pos+1 < size) {
+        size_t child = 2*pos+1;
+        if (child+1 < size && Vertex::before(_ears[child+1], _ears[child])) {
+            child++;
+        }
+        if (!Vertex::before(_ears[child], vertex)) {
+            break;
+        }
+        _ears[pos] = _ears[child];
+        _ears[pos]->earpos = pos;
+        pos = child;
+    }
+    _ears[pos] = vertex;
+    vertex->earpos = pos;
+}
+
+/**
+ * Removes the given vertex from the ear queue
+ *
+ * @param vertex    The vertex to remove
+ */
+void EarclipTriangulator::removeEar(Vertex* vertex) {
+    size_t pos = vertex->earpos;
+    Vertex* last = _ears.back();
+    _ears.pop_back();
+    vertex->earpos = NO_EAR;
+    if (last != vertex) {
+        _ears[pos] = last;
+        last->earpos = pos;
+        raiseEar(pos);
+        lowerEar(last->earpos);
+    }
+}
@@ -0,0 +1,579 @@
+//
+//  CUPolyBatch.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module is a factory for triangulating or extruding many paths at
+//  once. The other polygon factories process a single path on the calling
+//  thread. That is fine for a single shape, but scenes (or level loads)
+//  with hundreds of shapes spend a lot of time processing them one at a
+//  time. This factory splits the paths across a pool of worker threads,
+//  each with its own factory instances, and gathers the results into a
+//  single flat vertex and index buffer.
+//
+//  This class uses our standard shared-pointer architecture, as it owns
+//  a thread pool.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty. In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#include <cugl/core/math/polygon/CUPolyBatch.h>
+#include <cugl/core/math/polygon/CUEarclipTriangulator.h>
+#include <cugl/core/math/polygon/CUDelaunayTriangulator.h>
+#include <cugl/core/math/polygon/CUSimpleExtruder.h>
+#include <cugl/core/math/polygon/CUComplexExtruder.h>
+#include <cugl/core/util/CUThreadPool.h>
+#include <cugl/core/util/CUDebug.h>
+#include <algorithm>
+
+using namespace cugl;
+
+/** Default rounding tolerance (as in SimpleExtruder) */
+#define TOLERANCE   0.25f
+/** Default mitre limit (as in SimpleExtruder) */
+#define MITER_LIMIT 10.0f
+/** Default resolution scale (as in ComplexExtruder) */
+#define RESOLUTION  8
+/** The minimum number of path vertices worth a separate task */
+#define TASK_MIN_VERTICES   512
+
+/**
+ * The factories for a single task.
+ *
+ * Each task has its own factories, so that they can run in parallel. The
+ * factories are reused between calculations to avoid reallocation.
+ */
+class PolyBatch::Worker {
+public:
+    /** The ear clipping triangulator */
+    EarclipTriangulator earclip;
+    /** The Delaunay triangulator */
+    DelaunayTriangulator delaunay;
+    /** The fast extruder */
+    SimpleExtruder simple;
+    /** The precise extruder */
+    ComplexExtruder complex;
+    /** The polygons produced by this task (unused by the first task) */
+    Poly2 output;
+};
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates a new degenerate batch factory on the stack.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+PolyBatch::PolyBatch() :
+_threads(1),
+_joint(poly2::Joint::SQUARE),
+_endcap(poly2::EndCap::BUTT),
+_tolerance(TOLERANCE),
+_mitrelimit(MITER_LIMIT),
+_resolution(RESOLUTION),
+_calculated(false) {
+}
+
+/**
+ * Deletes this batch factory, disposing all resources
+ */
+PolyBatch::~PolyBatch() {
+    dispose();
+}
+
+/**
+ * Disposes all of the resources used by this batch factory.
+ *
+ * A disposed factory can be safely reinitialized.
+ */
+void PolyBatch::dispose() {
+    if (_workers != nullptr) {
+        _workers->stop();
+        _workers = nullptr;
+    }
+    _threads = 1;
+    _tasks.clear();
+    clear();
+}
+
+/**
+ * Initializes a batch factory with the given number of threads.
+ *
+ * The calling thread counts as one of the threads, so a factory with
+ * one thread does not create any worker threads.
+ *
+ * @param threads   The number of threads used to process the paths
+ *
+ * @return true if initialization was successful.
+ */
+bool PolyBatch::init(Uint32 threads) {
+    CUAssertLog(threads > 0, "The thread count must be positive");
+    setThreadCount(threads);
+    return true;
+}
+
+#pragma mark -
+#pragma mark Attributes
+/**
+ * Sets the number of threads used to process the paths
+ *
+ * The calling thread counts as one of the threads, so a value of 1
+ * processes all of the paths serially. Changing this value replaces
+ * the worker threads.
+ *
+ * @param threads   The number of threads used to process the paths
+ */
+void PolyBatch::setThreadCount(Uint32 threads) {
+    threads = std::max(threads,(Uint32)1);
+    if (threads != _threads && _workers != nullptr) {
+        _workers->stop();
+        _workers = nullptr;
+    }
+    _threads = threads;
+    if (_threads > 1 && _workers == nullptr) {
+        _workers = ThreadPool::alloc(_threads-1);
+    }
+}
+
+#pragma mark -
+#pragma mark Initialization
+/**
+ * Adds the given path to this batch, returning its position.
+ *
+ * A path to be triangulated should be closed and define its hull in a
+ * counter-clockwise traversal. The path is copied. The factory does not
+ * retain any references to the original data.
+ *
+ * @param path      The path to add
+ *
+ * @return the position of the path in this batch
+ */
+size_t PolyBatch::addPath(const Path2& path) {
+    if (_holeoffs.empty()) {
+        _holeoffs.push_back(0);
+    }
+    _input.push_back(path);
+    _holeoffs.push_back((Uint32)_holes.size());
+    return _input.size()-1;
+}
+
+/**
+ * Adds the given vertices to this batch as a path, returning its position.
+ *
+ * A path to be triangulated should be closed and define its hull in a
+ * counter-clockwise traversal. The vertices are copied. The factory does
+ * not retain any references to the original data.
+ *
+ * @param points    The path vertices
+ * @param size      The number of vertices
+ * @param closed    Whether the path is closed
+ *
+ * @return the position of the path in this batch
+ */
+size_t PolyBatch::addPath(const Vec2* points, size_t size, bool closed) {
+    if (_holeoffs.empty()) {
+        _holeoffs.push_back(0);
+    }
+    _input.emplace_back();
+    _input.back().set(points,size);
+    _input.back().closed = closed;
+    _holeoffs.push_back((Uint32)_holes.size());
+    return _input.size()-1;
+}
+
+/**
+ * Adds the given paths to this batch.
+ *
+ * The paths are added in order, after any paths already in this batch.
+ * They are copied. The factory does not retain any references to the
+ * original data.
+ *
+ * @param paths     The paths to add
+ */
+void PolyBatch::addPaths(const std::vector<Path2>& paths) {
+    if (_holeoffs.empty()) {
+        _holeoffs.push_back(0);
+    }
+    _input.insert(_input.end(), paths.begin(), paths.end());
+    _holeoffs.resize(_input.size()+1,(Uint32)_holes.size());
+}
+
+/**
+ * Adds a hole to the most recently added path.
+ *
+ * Holes are only used by triangulation, and are ignored by extrusion.
+ * The hole should be a clockwise path inside of the most recent
+ * path, as required by {@link EarclipTriangulator#addHole}. The hole is
+ * copied. The factory does not retain any references to the original data.
+ *
+ * @param hole      The hole to add
+ */
+void PolyBatch::addHole(const Path2& hole) {
+    CUAssertLog(!_input.empty(), "There is no path for this hole");
+    _holes.push_back(hole);
+    _holeoffs.back()++;
+}
+
+/**
+ * Adds a hole to the most recently added path.
+ *
+ * Holes are only used by triangulation, and are ignored by extrusion.
+ * The hole should be a clockwise path inside of the most recent
+ * path, as required by {@link EarclipTriangulator#addHole}. The vertices
+ * are copied. The factory does not retain any references to the original
+ * data.
+ *
+ * @param points    The hole vertices
+ * @param size      The number of vertices
+ */
+void PolyBatch::addHole(const Vec2* points, size_t size) {
+    CUAssertLog(!_input.empty(), "There is no path for this hole");
+    _holes.emplace_back();
+    _holes.back().set(points,size);
+    _holes.back().closed = true;
+    _holeoffs.back()++;
+}
+
+#pragma mark -
+#pragma mark Calculation
+/**
+ * Clears all computed data, but still maintains the settings.
+ *
+ * This method preserves all initial paths, as well as the thread
+ * count and extrusion settings.
+ */
+void PolyBatch::reset() {
+    _output.vertices.clear();
+    _output.indices.clear();
+    _vertoffs.clear();
+    _indxoffs.clear();
+    _calculated = false;
+}
+
+/**
+ * Clears all internal data, including the initial paths.
+ *
+ * When this method is called, you will need to add new paths before
+ * the calculation is run again. The thread count and extrusion
+ * settings are preserved.
+ */
+void PolyBatch::clear() {
+    reset();
+    _input.clear();
+    _holes.clear();
+    _holeoffs.clear();
+}
+
+/**
+ * Triangulates all of the paths in this batch.
+ *
+ * The polygon for each path is exactly the one produced by a single
+ * {@link EarclipTriangulator} (or {@link DelaunayTriangulator} if the
+ * parameter is true). Paths with fewer than three vertices produce
+ * an empty polygon. This method blocks until all paths are processed.
+ *
+ * @param delaunay  Whether to use Delaunay triangulation
+ */
+void PolyBatch::triangulate(bool delaunay) {
+    compute([=,this](Worker* worker, size_t index, Poly2* buffer) {
+        const Path2& path = _input[index];
+        if (path.size() < 3) {
+            return;
+        }
+        if (delaunay) {
+            DelaunayTriangulator* triangulator = &(worker->delaunay);
+            triangulator->clear();
+            triangulator->set(path);
+            for(Uint32 ii = _holeoffs[index]; ii < _holeoffs[index+1]; ii++) {
+                triangulator->addHole(_holes[ii]);
+            }
+            triangulator->calculate();
+            triangulator->getPolygon(buffer);
+        } else {
+            EarclipTriangulator* triangulator = &(worker->earclip);
+            triangulator->clear();
+            triangulator->set(path);
+            for(Uint32 ii = _holeoffs[index]; ii < _holeoffs[index+1]; ii++) {
+                triangulator->addHole(_holes[ii]);
+            }
+            triangulator->calculate();
+            triangulator->getPolygon(buffer);
+        }
+    });
+}
+
+/**
+ * Extrudes all of the paths in this batch with the given width.
+ *
+ * The polygon for each path is exactly the one produced by a single
+ * {@link SimpleExtruder} (or {@link ComplexExtruder} if the parameter
+ * is true) with the current extrusion settings. Paths with fewer than
+ * two vertices produce an empty polygon. This method blocks until all
+ * paths are processed.
+ *
+ * @param width     The stroke width of the extrusion
+ * @param complex   Whether to use the (precise) complex extrusion
+ */
+void PolyBatch::extrude(float width, bool complex) {
+    compute([=,this](Worker* worker, size_t index, Poly2* buffer) {
+        const Path2& path = _input[index];
+        if (path.size() < 2) {
+            return;
+        }
+        if (complex) {
+            ComplexExtruder* extruder = &(worker->complex);
+            extruder->clear();
+            extruder->setJoint(_joint);
+            extruder->setEndCap(_endcap);
+            extruder->setMitreLimit(_mitrelimit);
+            extruder->setResolution(_resolution);
+            extruder->set(path);
+            extruder->calculate(width);
+            extruder->getPolygon(buffer);
+        } else {
+            SimpleExtruder* extruder = &(worker->simple);
+            extruder->clear();
+            extruder->setJoint(_joint);
+            extruder->setEndCap(_endcap);
+            extruder->setTolerance(_tolerance);
+            extruder->setMitreLimit(_mitrelimit);
+            extruder->set(path);
+            extruder->calculate(width);
+            extruder->getPolygon(buffer);
+        }
+    });
+}
+
+#pragma mark -
+#pragma mark Materialization
+/**
+ * Returns the first vertex of the given polygon.
+ *
+ * The value for {@link #size} is the total number of vertices.
+ *
+ * @param index The polygon position
+ *
+ * @return the first vertex of the given polygon.
+ */
+Uint32 PolyBatch::getVertexOffset(size_t index) const {
+    if (!_calculated) {
+        return 0;
+    }
+    CUAssertLog(index < _vertoffs.size(), "Polygon index %zu out of range", index);
+    return _vertoffs[index];
+}
+
+/**
+ * Returns the first triangle index of the given polygon.
+ *
+ * The value for {@link #size} is the total number of indices.
+ *
+ * @param index The polygon position
+ *
+ * @return the first triangle index of the given polygon.
+ */
+Uint32 PolyBatch::getIndexOffset(size_t index) const {
+    if (!_calculated) {
+        return 0;
+    }
+    CUAssertLog(index < _indxoffs.size(), "Polygon index %zu out of range", index);
+    return _indxoffs[index];
+}
+
+/**
+ * Returns all of the polygons in this batch as a single polygon.
+ *
+ * The batch does not maintain references to this polygon and it is
+ * safe to modify it. If the calculation is not yet performed, this
+ * method will return the empty polygon.
+ *
+ * @return all of the polygons in this batch as a single polygon.
+ */
+Poly2 PolyBatch::getPolygon() const {
+    return _output;
+}
+
+/**
+ * Returns the polygon for the given path.
+ *
+ * The batch does not maintain references to this polygon and it is
+ * safe to modify it. If the calculation is not yet performed, this
+ * method will return the empty polygon.
+ *
+ * @param index The path position
+ *
+ * @return the polygon for the given path.
+ */
+Poly2 PolyBatch::getPolygon(size_t index) const {
+    Poly2 poly;
+    getPolygon(index,&poly);
+    return poly;
+}
+
+/**
+ * Stores the polygon for the given path in the given buffer.
+ *
+ * This method will append the vertices to the given polygon. If the
+ * buffer is not empty, the indices will be adjusted accordingly. You
+ * should clear the buffer first if you do not want to preserve the
+ * original data.
+ *
+ * If the calculation is not yet performed, this method will do nothing.
+ *
+ * @param index     The path position
+ * @param buffer    The buffer to store the polygon
+ *
+ * @return a reference to the buffer for chaining.
+ */
+Poly2* PolyBatch::getPolygon(size_t index, Poly2* buffer) const {
+    CUAssertLog(buffer, "Destination buffer is null");
+    if (_calculated) {
+        CUAssertLog(index < _input.size(), "Polygon index %zu out of range", index);
+        Uint32 vfirst = _vertoffs[index];
+        Uint32 vlast  = _vertoffs[index+1];
+        Uint32 ifirst = _indxoffs[index];
+        Uint32 ilast  = _indxoffs[index+1];
+
+        // Shift the indices from the batch to the buffer
+        Uint32 offset = (Uint32)buffer->vertices.size();
+        buffer->vertices.insert(buffer->vertices.end(),
+                                _output.vertices.begin()+vfirst,
+                                _output.vertices.begin()+vlast);
+        buffer->indices.reserve(buffer->indices.size()+(ilast-ifirst));
+        for(Uint32 ii = ifirst; ii < ilast; ii++) {
+            buffer->indices.push_back(_output.indices[ii]-vfirst+offset);
+        }
+    }
+    return buffer;
+}
+
+/**
+ * Returns the polygons of all paths in this batch.
+ *
+ * The batch does not maintain references to these polygons and it is
+ * safe to modify them. If the calculation is not yet performed, this
+ * method will return the empty list.
+ *
+ * @return the polygons of all paths in this batch.
+ */
+std::vector<Poly2> PolyBatch::getPolygons() const {
+    std::vector<Poly2> result;
+    if (_calculated) {
+        result.resize(_input.size());
+        for(size_t ii = 0; ii < _input.size(); ii++) {
+            getPolygon(ii,&result[ii]);
+        }
+    }
+    return result;
+}
+
+#pragma mark -
+#pragma mark Internal Computation
+/**
+ * Processes all paths, using the given function for each path.
+ *
+ * The function should compute the polygon for the path and append it to
+ * the given buffer, adjusting the indices. The paths are divided into
+ * contiguous ranges, each processed by a separate task, and the results
+ * are merged in order.
+ *
+ * @param process   The function to process a single path
+ */
+void PolyBatch::compute(const std::function<void(Worker*,size_t,Poly2*)>& process) {
+    reset();
+    size_t count = _input.size();
+    _vertoffs.resize(count+1);
+    _indxoffs.resize(count+1);
+
+    // Balance the tasks by vertex count, not path count
+    std::vector<size_t> weights(count+1);
+    weights[0] = 0;
+    for(size_t ii = 0; ii < count; ii++) {
+        size_t weight = _input[ii].size();
+        for(Uint32 jj = _holeoffs[ii]; jj < _holeoffs[ii+1]; jj++) {
+            weight += _holes[jj].size();
+        }
+        weights[ii+1] = weights[ii]+weight;
+    }
+
+    size_t total = weights[count];
+    Uint32 tasks = (Uint32)std::min(std::min((size_t)_threads, count), total/TASK_MIN_VERTICES);
+    tasks = std::max(tasks,(Uint32)1);
+    std::vector<size_t> ranges(tasks+1);
+    ranges[0] = 0;
+    for(Uint32 jj = 1; jj < tasks; jj++) {
+        auto it = std::lower_bound(weights.begin(), weights.end(), total*jj/tasks);
+        ranges[jj] = std::max((size_t)(it-weights.begin()),ranges[jj-1]);
+    }
+    ranges[tasks] = count;
+
+    while (_tasks.size() < tasks) {
+        _tasks.push_back(std::make_unique<Worker>());
+    }
+
+    // Each task appends a contiguous range of polygons to its own buffer
+    auto run = [&](Uint32 index) {
+        Worker* worker = _tasks[index].get();
+        Poly2* buffer = index == 0 ? &_output : &(worker->output);
+        buffer->vertices.clear();
+        buffer->indices.clear();
+        for(size_t ii = ranges[index]; ii < ranges[index+1]; ii++) {
+            _vertoffs[ii] = (Uint32)buffer->vertices.size();
+            _indxoffs[ii] = (Uint32)buffer->indices.size();
+            process(worker,ii,buffer);
+        }
+    };
+    if (tasks > 1) {
+        _workers->parallelFor(tasks, run);
+    } else {
+        run(0);
+    }
+
+    // Merge the ranges in order, rebasing the offsets and indices
+    for(Uint32 jj = 1; jj < tasks; jj++) {
+        const Poly2* partial = &(_tasks[jj]->output);
+        Uint32 vbase = (Uint32)_output.vertices.size();
+        Uint32 ibase = (Uint32)_output.indices.size();
+        for(size_t ii = ranges[jj]; ii < ranges[jj+1]; ii++) {
+            _vertoffs[ii] += vbase;
+            _indxoffs[ii] += ibase;
+        }
+        _output.vertices.insert(_output.vertices.end(),
+                                partial->vertices.begin(), partial->vertices.end());
+        _output.indices.reserve(ibase+partial->indices.size());
+        for(auto it = partial->indices.begin(); it != partial->indices.end(); ++it) {
+            _output.indices.push_back(vbase+*it);
+        }
+    }
+    _vertoffs[count] = (Uint32)_output.vertices.size();
+    _indxoffs[count] = (Uint32)_output.indices.size();
+    _calculated = true;
+}
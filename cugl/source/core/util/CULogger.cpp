@@ -37,6 +37,10 @@
 #include <cugl/core/util/CUFiletools.h>
 #include <cugl/core/CUApplication.h>
 #include <cugl/core/io/CUTextWriter.h>
+#include <cugl/core/util/CUThreadPool.h>
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
 #include <chrono>
 #include <ctime>
 #include <cstring>
@@ -47,6 +51,26 @@ using namespace cugl;
 
 // The buffer size allocated for time stampes
 #define STAMP_SIZE 64
+/** The default capacity (in bytes) of a per-thread asynchronous buffer */
+#define RING_SIZE       65536
+/** The minimum capacity (in bytes) of a per-thread asynchronous buffer */
+#define RING_MIN        1024
+/** The maximum time (in milliseconds) a message waits to be written */
+#define DRAIN_INTERVAL  5
+/** The maximum length of a single conversion specification */
+#define SPEC_SIZE       32
+/** The initial space reserved to format a single argument */
+#define FORMAT_CHUNK    64
+
+/** A record that only fills the end of a buffer, and should be skipped */
+#define RECORD_PAD      0
+/** A record with a format string and its raw arguments */
+#define RECORD_ARGS     1
+/** A record with a message formatted by the calling thread */
+#define RECORD_TEXT     2
+
+/** The id of the most recent asynchronous session */
+static std::atomic<Uint64> _lastsession(0);
 
 /** The list of all active logs */
 std::unordered_map<std::string, std::shared_ptr<Logger>> Logger::_channels;
@@ -109,20 +133,28 @@ static SDL_LogPriority level2sdl(Logger::Level level) {
 }
 
 /**
- * Stores the time stamp in the given buffer.
+ * Returns the current time in microseconds since the epoch.
+ *
+ * @return the current time in microseconds since the epoch.
+ */
+static Uint64 stamp_now() {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return (Uint64)std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
+/**
+ * Stores the time stamp for the given time in the given buffer.
  *
  * The times stamp includes the date and time up to the nearest microsecond.
  *
  * @param buffer    The buffer to store the time stamp
  * @param size      The size of the buffer
+ * @param micros    The time in microseconds since the epoch
  *
  * @return the length of the string written to the buffer
  */
-static size_t stamp_time(char* buffer, size_t size) {
-    auto now = std::chrono::system_clock::now();
-    auto micro = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()) % 1000000;
-
-    auto timer = std::chrono::system_clock::to_time_t(now);
+static size_t stamp_time(char* buffer, size_t size, Uint64 micros) {
+    std::time_t timer = (std::time_t)(micros/1000000);
     std::tm parse = *std::localtime(&timer);
 #ifdef __WINDOWS__
     // Windows is apparently not C++11 conformant on strftime
@@ -131,11 +163,595 @@ static size_t stamp_time(char* buffer, size_t size) {
     size_t limit = std::strftime(buffer, size, "%y-%m-%d %0H:%M:%S", &parse);
 #endif
     if (limit+9 < size) {
-        limit += std::snprintf(buffer+limit, 9, ".%06d",(int)(micro.count()));
+        limit += std::snprintf(buffer+limit, 9, ".%06d",(int)(micros % 1000000));
     }
     return limit;
 }
 
+/**
+ * Stores the time stamp in the given buffer.
+ *
+ * The times stamp includes the date and time up to the nearest microsecond.
+ *
+ * @param buffer    The buffer to store the time stamp
+ * @param size      The size of the buffer
+ *
+ * @return the length of the string written to the buffer
+ */
+static size_t stamp_time(char* buffer, size_t size) {
+    return stamp_time(buffer, size, stamp_now());
+}
+
+#pragma mark -
+#pragma mark Asynchronous Records
+/**
+ * The header of a record in an asynchronous buffer.
+ *
+ * A record is the header followed by its payload, padded to a multiple of
+ * 8 bytes. A {@link RECORD_ARGS} payload is the format string followed by
+ * the raw arguments, in the order they appear in the format string. Each
+ * argument is padded to 8 bytes, and strings are stored inline (as their
+ * length followed by their characters). A {@link RECORD_TEXT} payload is
+ * just the formatted message. A {@link RECORD_PAD} record only uses the
+ * first 8 bytes of the header.
+ */
+class RecordHeader {
+public:
+    /** The size of the record (header and payload) in bytes */
+    Uint32 size;
+    /** The record kind */
+    Uint16 kind;
+    /** The message level (-1 for the default levels) */
+    Sint16 level;
+    /** The time of the message in microseconds since the epoch */
+    Uint64 stamp;
+};
+
+/** A record waiting to be formatted by the background thread */
+class PendingRecord {
+public:
+    /** The time of the message in microseconds since the epoch */
+    Uint64 stamp;
+    /** The record in its buffer */
+    const Uint8* record;
+};
+
+/** The length modifiers of a conversion specification */
+enum class ArgLength : int {
+    NONE, HH, H, L, LL, J, Z, T, BIGL
+};
+
+/**
+ * A single conversion specification in a format string.
+ *
+ * This class only parses the parts of the specification needed to know the
+ * type of the arguments. The specification is reformatted with snprintf.
+ */
+class FormatSpec {
+public:
+    /** The start of the specification (the % character) */
+    const char* start;
+    /** The position after the specification */
+    const char* end;
+    /** The conversion character */
+    char conv;
+    /** The length modifier */
+    ArgLength length;
+    /** The number of * arguments for the width and precision */
+    int stars;
+    /** The precision (-1 if absent or given by an argument) */
+    int precision;
+    /** Whether the precision is given by an argument */
+    bool precStar;
+    /** Whether the specification can be formatted from a record */
+    bool valid;
+};
+
+/**
+ * Parses the conversion specification starting at the given position.
+ *
+ * The specification is invalid if it cannot be deferred to the background
+ * thread. That includes positional arguments, %n, and wide characters.
+ *
+ * @param pos   The position of the % character
+ * @param spec  The specification to store the result
+ *
+ * @return the position after the specification
+ */
+static const char* parse_spec(const char* pos, FormatSpec& spec) {
+    spec.start = pos;
+    spec.conv  = '\0';
+    spec.length = ArgLength::NONE;
+    spec.stars = 0;
+    spec.precision = -1;
+    spec.precStar = false;
+    spec.valid = false;
+
+    pos++;
+    while (*pos != '\0' && std::strchr("-+ #0'", *pos) != nullptr) {
+        pos++;
+    }
+    if (*pos == '*') {
+        spec.stars++;
+        pos++;
+    } else {
+        while (*pos >= '0' && *pos <= '9') {
+            pos++;
+        }
+        if (*pos == '$') {
+            return pos;
+        }
+    }
+    if (*pos == '.') {
+        pos++;
+        if (*pos == '*') {
+            spec.stars++;
+            spec.precStar = true;
+            pos++;
+        } else {
+            spec.precision = 0;
+            while (*pos >= '0' && *pos <= '9') {
+                spec.precision = 10*spec.precision+(*pos-'0');
+                pos++;
+            }
+        }
+    }
+    switch (*pos) {
+        case 'h':
+            pos++;
+            spec.length = ArgLength::H;
+            if (*pos == 'h') {
+                pos++;
+                spec.length = ArgLength::HH;
+            }
+            break;
+        case 'l':
+            pos++;
+            spec.length = ArgLength::L;
+            if (*pos == 'l') {
+                pos++;
+                spec.length = ArgLength::LL;
+            }
+            break;
+        case 'j':
+            pos++;
+            spec.length = ArgLength::J;
+            break;
+        case 'z':
+            pos++;
+            spec.length = ArgLength::Z;
+            break;
+        case 't':
+            pos++;
+            spec.length = ArgLength::T;
+            break;
+        case 'L':
+            pos++;
+            spec.length = ArgLength::BIGL;
+            break;
+    }
+    if (*pos == '\0') {
+        return pos;
+    }
+
+    spec.conv = *pos++;
+    spec.end  = pos;
+    if (spec.end-spec.start >= SPEC_SIZE) {
+        return pos;
+    }
+    switch (spec.conv) {
+        case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+            spec.valid = spec.length != ArgLength::BIGL;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec.valid = (spec.length == ArgLength::NONE || spec.length == ArgLength::L ||
+                          spec.length == ArgLength::BIGL);
+            break;
+        case 'c': case 's': case 'p':
+            spec.valid = spec.length == ArgLength::NONE;
+            break;
+        case '%':
+            spec.valid = true;
+            break;
+    }
+    return pos;
+}
+
+/**
+ * Pads the record to a multiple of 8 bytes.
+ *
+ * @param out   The record
+ */
+static void pad_record(std::string& out) {
+    out.resize((out.size()+7) & ~(size_t)7, '\0');
+}
+
+/**
+ * Appends a raw argument to the record.
+ *
+ * @param out   The record
+ * @param value The argument value
+ */
+template <typename T>
+static void put_value(std::string& out, T value) {
+    size_t off = out.size();
+    out.resize(off+((sizeof(T)+7) & ~(size_t)7), '\0');
+    std::memcpy(&out[off], &value, sizeof(T));
+}
+
+/**
+ * Returns the next raw argument of a record, advancing the position.
+ *
+ * @param args  The position of the argument in the record
+ *
+ * @return the next raw argument of a record
+ */
+template <typename T>
+static T get_value(const Uint8*& args) {
+    T value;
+    std::memcpy(&value, args, sizeof(T));
+    args += (sizeof(T)+7) & ~(size_t)7;
+    return value;
+}
+
+/**
+ * Appends the format string and its raw arguments to the record.
+ *
+ * String arguments are copied into the record. This function returns false
+ * if the format string cannot be deferred. In that case the arguments are
+ * partially consumed, and the record should be discarded.
+ *
+ * @param format    The formatting string
+ * @param args      The printf-style subsitution arguments
+ * @param out       The record
+ *
+ * @return true if the arguments were successfully stored
+ */
+static bool encode_args(const char* format, va_list args, std::string& out) {
+    size_t len = std::strlen(format);
+    out.append(format, len+1);
+    pad_record(out);
+
+    FormatSpec spec;
+    const char* pos = format;
+    while (*pos != '\0') {
+        if (*pos != '%') {
+            pos++;
+            continue;
+        }
+        pos = parse_spec(pos, spec);
+        if (!spec.valid) {
+            return false;
+        } else if (spec.conv == '%') {
+            continue;
+        }
+
+        int precision = spec.precision;
+        for(int ii = 0; ii < spec.stars; ii++) {
+            int value = va_arg(args, int);
+            put_value(out, value);
+            if (spec.precStar) {
+                precision = value;
+            }
+        }
+
+        switch (spec.conv) {
+            case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c':
+                // A va_list passed by value cannot be read by a helper and
+                // then used again here, so every va_arg stays in this loop
+                switch (spec.length) {
+                    case ArgLength::L:
+                        put_value(out, va_arg(args, long));
+                        break;
+                    case ArgLength::LL:
+                        put_value(out, va_arg(args, long long));
+                        break;
+                    case ArgLength::J:
+                        put_value(out, va_arg(args, intmax_t));
+                        break;
+                    case ArgLength::Z:
+                        put_value(out, va_arg(args, size_t));
+                        break;
+                    case ArgLength::T:
+                        put_value(out, va_arg(args, ptrdiff_t));
+                        break;
+                    default:
+                        put_value(out, va_arg(args, int));
+                        break;
+                }
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                if (spec.length == ArgLength::BIGL) {
+                    put_value(out, va_arg(args, long double));
+                } else {
+                    put_value(out, va_arg(args, double));
+                }
+                break;
+            case 'p':
+                put_value(out, va_arg(args, void*));
+                break;
+            case 's':
+            {
+                const char* text = va_arg(args, const char*);
+                if (text == nullptr) {
+                    text = "(null)";
+                }
+                size_t size;
+                if (precision >= 0) {
+                    const void* term = std::memchr(text, '\0', precision);
+                    size = term == nullptr ? precision : (const char*)term-text;
+                } else {
+                    size = std::strlen(text);
+                }
+                put_value(out, (Uint32)size);
+                out.append(text, size);
+                out.push_back('\0');
+                pad_record(out);
+            }
+                break;
+        }
+    }
+    return true;
+}
+
+/**
+ * Appends a printf-style formatted string to the given string.
+ *
+ * @param out       The string to append to
+ * @param format    The formatting string
+ * @param args      The printf-style subsitution arguments
+ */
+static void append_vformat(std::string& out, const char* format, va_list args) {
+    va_list copy;
+    va_copy(copy, args);
+    size_t off = out.size();
+    out.resize(off+FORMAT_CHUNK);
+    int amt = std::vsnprintf(&out[off], FORMAT_CHUNK, format, args);
+    if (amt >= FORMAT_CHUNK) {
+        out.resize(off+amt+1);
+        std::vsnprintf(&out[off], amt+1, format, copy);
+    } else if (amt < 0) {
+        // Keep any output before the error, as the synchronous logger does
+        out[off+FORMAT_CHUNK-1] = '\0';
+        amt = (int)std::strlen(&out[off]);
+    }
+    va_end(copy);
+    out.resize(off+amt);
+}
+
+/**
+ * Appends a single formatted argument to the given string.
+ *
+ * @param out       The string to append to
+ * @param format    The conversion specification
+ * @param args      The width, precision, and argument values
+ */
+template <typename... Args>
+static void append_format(std::string& out, const char* format, Args... args) {
+    size_t off = out.size();
+    out.resize(off+FORMAT_CHUNK);
+    int amt = std::snprintf(&out[off], FORMAT_CHUNK, format, args...);
+    if (amt >= FORMAT_CHUNK) {
+        out.resize(off+amt+1);
+        std::snprintf(&out[off], amt+1, format, args...);
+    }
+    out.resize(off+std::max(amt,0));
+}
+
+/**
+ * Appends a single formatted argument to the given string.
+ *
+ * @param out       The string to append to
+ * @param spec      The conversion specification
+ * @param text      The conversion specification as a string
+ * @param stars     The width and precision arguments
+ * @param value     The argument value
+ */
+template <typename T>
+static void append_arg(std::string& out, const FormatSpec& spec, const char* text,
+                       const int* stars, T value) {
+    switch (spec.stars) {
+        case 0:
+            append_format(out, text, value);
+            break;
+        case 1:
+            append_format(out, text, stars[0], value);
+            break;
+        default:
+            append_format(out, text, stars[0], stars[1], value);
+            break;
+    }
+}
+
+/**
+ * Appends the next integer argument of a record to the given string.
+ *
+ * @param out       The string to append to
+ * @param spec      The conversion specification
+ * @param text      The conversion specification as a string
+ * @param stars     The width and precision arguments
+ * @param args      The position of the argument in the record
+ */
+template <typename T>
+static void append_integer(std::string& out, const FormatSpec& spec, const char* text,
+                           const int* stars, const Uint8*& args) {
+    T value = get_value<T>(args);
+    if (std::strchr("ouxX", spec.conv) != nullptr) {
+        append_arg(out, spec, text, stars, (std::make_unsigned_t<T>)value);
+    } else {
+        append_arg(out, spec, text, stars, (std::make_signed_t<T>)value);
+    }
+}
+
+/**
+ * Appends the message of a {@link RECORD_ARGS} payload to the given string.
+ *
+ * @param format    The formatting string
+ * @param args      The raw arguments
+ * @param out       The string to append to
+ */
+static void decode_args(const char* format, const Uint8* args, std::string& out) {
+    char text[SPEC_SIZE];
+    int  stars[2];
+    FormatSpec spec;
+    const char* pos = format;
+    const char* run = format;
+    while (*pos != '\0') {
+        if (*pos != '%') {
+            pos++;
+            continue;
+        }
+        out.append(run, pos-run);
+        pos = parse_spec(pos, spec);
+        run = pos;
+        if (spec.conv == '%') {
+            out.push_back('%');
+            continue;
+        }
+
+        std::memcpy(text, spec.start, spec.end-spec.start);
+        text[spec.end-spec.start] = '\0';
+        for(int ii = 0; ii < spec.stars; ii++) {
+            stars[ii] = get_value<int>(args);
+        }
+
+        switch (spec.conv) {
+            case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c':
+                switch (spec.length) {
+                    case ArgLength::L:
+                        append_integer<long>(out, spec, text, stars, args);
+                        break;
+                    case ArgLength::LL:
+                        append_integer<long long>(out, spec, text, stars, args);
+                        break;
+                    case ArgLength::J:
+                        append_integer<intmax_t>(out, spec, text, stars, args);
+                        break;
+                    case ArgLength::Z:
+                        append_integer<size_t>(out, spec, text, stars, args);
+                        break;
+                    case ArgLength::T:
+                        append_integer<ptrdiff_t>(out, spec, text, stars, args);
+                        break;
+                    default:
+                        append_integer<int>(out, spec, text, stars, args);
+                        break;
+                }
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                if (spec.length == ArgLength::BIGL) {
+                    append_arg(out, spec, text, stars, get_value<long double>(args));
+                } else {
+                    append_arg(out, spec, text, stars, get_value<double>(args));
+                }
+                break;
+            case 'p':
+                append_arg(out, spec, text, stars, get_value<void*>(args));
+                break;
+            case 's':
+            {
+                Uint32 size = get_value<Uint32>(args);
+                append_arg(out, spec, text, stars, (const char*)args);
+                args += (size+8) & ~(size_t)7;
+            }
+                break;
+        }
+    }
+    out.append(run, pos-run);
+}
+
+/**
+ * A buffer of pending messages for a single thread.
+ *
+ * This is a single-producer, single-consumer ring of variable sized records.
+ * Only the owning thread writes records, and only the background thread
+ * reads them, so neither side needs a lock. A record never wraps around the
+ * end of the ring; the space at the end is filled with a padding record
+ * instead.
+ */
+class Logger::Ring {
+public:
+    /** The ring storage (as words for alignment) */
+    Uint64* data;
+    /** The capacity of the ring in bytes (a power of two) */
+    size_t capacity;
+    /** The total number of bytes written (only advanced by the owner) */
+    alignas(64) std::atomic<Uint64> head;
+    /** The total number of bytes read (only advanced by the background thread) */
+    alignas(64) std::atomic<Uint64> tail;
+    /** Whether the owning thread has exited */
+    std::atomic<bool> orphaned;
+    /** Whether the logger has left the session of this buffer */
+    std::atomic<bool> detached;
+
+    /**
+     * Creates a ring with the given capacity.
+     *
+     * @param size  The capacity in bytes (a power of two)
+     */
+    Ring(size_t size) : capacity(size), head(0), tail(0), orphaned(false), detached(false) {
+        data = new Uint64[size/sizeof(Uint64)];
+    }
+
+    /**
+     * Deletes this ring, releasing all resources.
+     */
+    ~Ring() {
+        delete[] data;
+    }
+
+    /**
+     * Returns the record at the given position.
+     *
+     * @param pos   The position in bytes
+     *
+     * @return the record at the given position.
+     */
+    Uint8* get(Uint64 pos) {
+        return (Uint8*)data+(pos & (capacity-1));
+    }
+
+    /**
+     * Returns the number of bytes not yet read by the background thread.
+     *
+     * @return the number of bytes not yet read by the background thread.
+     */
+    size_t used() const {
+        return (size_t)(head.load(std::memory_order_relaxed)-tail.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * Returns true if the record was added to this ring.
+     *
+     * This method fails if there is not enough room for the record. It may
+     * only be called by the owning thread.
+     *
+     * @param record    The record
+     * @param size      The record size (a multiple of 8)
+     *
+     * @return true if the record was added to this ring.
+     */
+    bool push(const char* record, size_t size) {
+        Uint64 pos = head.load(std::memory_order_relaxed);
+        size_t off = pos & (capacity-1);
+        size_t pad = off+size > capacity ? capacity-off : 0;
+        size_t room = capacity-(size_t)(pos-tail.load(std::memory_order_acquire));
+        if (pad+size > room) {
+            return false;
+        }
+        if (pad) {
+            RecordHeader header;
+            header.size  = (Uint32)pad;
+            header.kind  = RECORD_PAD;
+            header.level = 0;
+            std::memcpy(get(pos), &header, sizeof(Uint64));
+        }
+        std::memcpy(get(pos+pad), record, size);
+        head.store(pos+pad+size, std::memory_order_release);
+        return true;
+    }
+};
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -150,7 +766,15 @@ _consLevel(Level::NO_MSG),
 _buffer(nullptr),
 _capacity(0),
 _autof(false),
-_open(false) {
+_open(false),
+_async(false),
+_overflow(Overflow::BLOCK),
+_ringSize(RING_SIZE),
+_session(0),
+_flushAsked(0),
+_flushDone(0),
+_stopping(false),
+_dropped(0) {
 }
 
 /**
@@ -159,8 +783,18 @@ _open(false) {
  * A disposed logger can be safely reinitialized.
  */
 void Logger::dispose() {
-    _writer->close();
-    _writer = nullptr;
+    if (_async) {
+        setAsync(false);
+    }
+    if (_writer != nullptr) {
+        _writer->close();
+        _writer = nullptr;
+    }
+    if (_buffer != nullptr) {
+        std::free(_buffer);
+        _buffer = nullptr;
+    }
+    _capacity = 0;
     _open  = false;
     _autof = false;
     _fileLevel = Level::NO_MSG;
@@ -351,7 +985,7 @@ bool Logger::close(const std::string channel) {
  */
 void Logger::setLogLevel(Level level) {
     if (_open) {
-        _writer->flush();
+        flush();
         _fileLevel = level;
     }
 }
@@ -393,8 +1027,308 @@ void Logger::setAutoFlush(bool value) {
     if (_open) {
         _autof = value;
         if (value) {
+            flush();
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Asynchronous Logging
+/**
+ * Sets whether this logger is asynchronous.
+ *
+ * An asynchronous logger copies the format string and the arguments of
+ * each message into a buffer owned by the calling thread, without any
+ * locking. A background thread formats the messages and writes them to
+ * the file (and the console) in batches. This keeps file I/O off of the
+ * calling thread, and makes it safe to log from several threads at once.
+ *
+ * String arguments are copied, so they may be freed as soon as the log
+ * call returns. With auto flush, the file is flushed after each batch
+ * rather than after each message. Call {@link #flush} to wait until all
+ * messages logged so far are in the file.
+ *
+ * Leaving asynchronous mode writes all pending messages before it
+ * returns. This method should not be called while other threads are
+ * logging to this channel.
+ *
+ * @param value whether this logger is asynchronous
+ */
+void Logger::setAsync(bool value) {
+    if (!_open || _async == value) {
+        return;
+    }
+    
+    if (value) {
+        _writer->flush();
+        _drainer = ThreadPool::alloc(1);
+        if (_drainer == nullptr) {
+            CUAssertLog(false, "Channel '%s' could not start a log thread.",_name.c_str());
+            return;
+        }
+        _session  = ++_lastsession;
+        _flushAsked = 0;
+        _flushDone  = 0;
+        _stopping = false;
+        _async = true;
+        _drainer->addTask([this](void) {
+            drain();
+        });
+    } else {
+        {
+            std::unique_lock<std::mutex> lock(_drainMutex);
+            _stopping = true;
+        }
+        _drainWake.notify_one();
+        _drainer->stop();
+        _drainer = nullptr;
+        
+        // Threads drop their cached buffers the next time they log
+        for (auto it = _rings.begin(); it != _rings.end(); ++it) {
+            (*it)->detached.store(true, std::memory_order_release);
+        }
+        _rings.clear();
+        _async = false;
+        _writer->flush();
+    }
+}
+
+/**
+ * Sets the capacity in bytes of each per-thread buffer.
+ *
+ * Each thread logging to an asynchronous logger gets its own buffer of
+ * this size. A message that is larger than the buffer is always dropped.
+ * The size is rounded up to a power of two, and only applies to buffers
+ * allocated after this call. The default is 64 KB.
+ *
+ * @param size  The capacity in bytes of each per-thread buffer
+ */
+void Logger::setBufferSize(size_t size) {
+    size_t capacity = RING_MIN;
+    while (capacity < size) {
+        capacity *= 2;
+    }
+    _ringSize = capacity;
+}
+
+/**
+ * Returns the buffer of the calling thread for asynchronous logging.
+ *
+ * The buffer is allocated the first time a thread logs to this channel
+ * in the current asynchronous session.
+ *
+ * @return the buffer of the calling thread for asynchronous logging.
+ */
+Logger::Ring* Logger::acquireRing() {
+    // The buffers of this thread, marked as orphaned when it exits
+    class RingCache {
+    public:
+        std::vector<std::pair<Uint64,std::shared_ptr<Ring>>> entries;
+        ~RingCache() {
+            for (auto it = entries.begin(); it != entries.end(); ++it) {
+                it->second->orphaned.store(true, std::memory_order_release);
+            }
+        }
+    };
+    static thread_local RingCache cache;
+    
+    for (auto it = cache.entries.begin(); it != cache.entries.end(); ) {
+        if (it->first == _session) {
+            return it->second.get();
+        } else if (it->second->detached.load(std::memory_order_acquire)) {
+            it = cache.entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    
+    std::shared_ptr<Ring> ring = std::make_shared<Ring>(_ringSize);
+    {
+        std::unique_lock<std::mutex> lock(_drainMutex);
+        _rings.push_back(ring);
+    }
+    cache.entries.emplace_back(_session, ring);
+    return ring.get();
+}
+
+/**
+ * Adds a message to the buffer of the calling thread.
+ *
+ * The message is stored as the format string and the raw arguments, and
+ * is formatted later by the background thread. If the format string uses
+ * features that cannot be deferred (such as positional arguments), the
+ * message is formatted immediately instead.
+ *
+ * @param level     The message level (-1 for the default levels)
+ * @param format    The formatting string
+ * @param args      The printf-style subsitution arguments
+ */
+void Logger::enqueue(int level, const char* format, va_list args) {
+    // Messages that go nowhere are rejected before any copying
+    bool tofile = (int)_fileLevel > (int)Level::NO_MSG;
+    bool tocons = (int)_consLevel > (int)Level::NO_MSG;
+    if (level >= 0) {
+        tofile = tofile && level > (int)Level::NO_MSG && level <= (int)_fileLevel;
+        tocons = tocons && level > (int)Level::NO_MSG;
+    }
+    if (!tofile && !tocons) {
+        return;
+    }
+    
+    static thread_local std::string record;
+    RecordHeader header;
+    header.kind  = RECORD_ARGS;
+    header.level = (Sint16)level;
+    header.stamp = stamp_now();
+    record.assign(sizeof(RecordHeader), '\0');
+    
+    va_list backup;
+    va_copy(backup, args);
+    if (!encode_args(format, args, record)) {
+        header.kind = RECORD_TEXT;
+        record.resize(sizeof(RecordHeader));
+        append_vformat(record, format, backup);
+        record.push_back('\0');
+        pad_record(record);
+    }
+    va_end(backup);
+    header.size = (Uint32)record.size();
+    std::memcpy(&record[0], &header, sizeof(RecordHeader));
+    
+    Ring* ring = acquireRing();
+    if (record.size() > ring->capacity) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    while (!ring->push(record.data(), record.size())) {
+        if (_overflow == Overflow::DROP) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        _drainWake.notify_one();
+        std::this_thread::yield();
+    }
+    
+    // Do not wait for the next interval if the buffer is filling up
+    if (ring->used() > ring->capacity/2) {
+        _drainWake.notify_one();
+    }
+}
+
+/**
+ * Runs the background thread for asynchronous logging.
+ *
+ * This method repeatedly drains the per-thread buffers, formats the
+ * messages in timestamp order, and writes them to the file as a single
+ * batch. It returns once the logger leaves asynchronous mode and all
+ * pending messages have been written.
+ */
+void Logger::drain() {
+    std::vector<std::shared_ptr<Ring>> active;
+    std::vector<Uint64> heads;
+    std::vector<PendingRecord> pending;
+    std::string prefix = "["+_name+"] ";
+    std::string message;
+    std::string batch;
+    
+    // The date and time are only reformatted when the second changes
+    char stamp[STAMP_SIZE];
+    size_t stampLen = 0;
+    Uint64 second = 0;
+    
+    std::unique_lock<std::mutex> lock(_drainMutex);
+    while (true) {
+        Uint64 asked  = _flushAsked;
+        bool stopping = _stopping;
+        active.assign(_rings.begin(), _rings.end());
+        lock.unlock();
+        
+        pending.clear();
+        heads.resize(active.size());
+        for(size_t ii = 0; ii < active.size(); ii++) {
+            Ring* ring = active[ii].get();
+            Uint64 pos = ring->tail.load(std::memory_order_relaxed);
+            heads[ii]  = ring->head.load(std::memory_order_acquire);
+            while (pos < heads[ii]) {
+                RecordHeader header;
+                const Uint8* record = ring->get(pos);
+                std::memcpy(&header, record, sizeof(Uint64));
+                if (header.kind != RECORD_PAD) {
+                    std::memcpy(&header, record, sizeof(RecordHeader));
+                    pending.push_back({header.stamp, record});
+                }
+                pos += header.size;
+            }
+        }
+        
+        // Each buffer is in order, but the threads must be interleaved
+        std::stable_sort(pending.begin(), pending.end(), [](const PendingRecord& a, const PendingRecord& b) {
+            return a.stamp < b.stamp;
+        });
+        
+        for (auto it = pending.begin(); it != pending.end(); ++it) {
+            RecordHeader header;
+            std::memcpy(&header, it->record, sizeof(RecordHeader));
+            const char* body = (const char*)(it->record+sizeof(RecordHeader));
+            message.assign(prefix);
+            if (header.kind == RECORD_TEXT) {
+                message.append(body);
+            } else {
+                size_t len = std::strlen(body);
+                decode_args(body, (const Uint8*)body+((len+8) & ~(size_t)7), message);
+            }
+            
+            Level flevel = header.level < 0 ? _fileLevel : (Level)header.level;
+            Level clevel = header.level < 0 ? _consLevel : (Level)header.level;
+            if ((int)_fileLevel > (int)Level::NO_MSG &&
+                (int)flevel > (int)Level::NO_MSG &&
+                (int)flevel <= (int)_fileLevel) {
+                if (stampLen == 0 || header.stamp/1000000 != second) {
+                    stampLen = stamp_time(stamp, STAMP_SIZE, header.stamp);
+                    second = header.stamp/1000000;
+                } else {
+                    std::snprintf(stamp+stampLen-6, 7, "%06d", (int)(header.stamp % 1000000));
+                }
+                batch.append(stamp, stampLen);
+                batch.push_back(' ');
+                batch.append(level2name(flevel));
+                batch.append(": ");
+                batch.append(message);
+                batch.push_back('\n');
+            }
+            if ((int)_consLevel > (int)Level::NO_MSG &&
+                (int)clevel > (int)Level::NO_MSG) {
+                SDL_LogMessage(SDL_LOG_CATEGORY_CUSTOM, level2sdl(clevel),
+                               "%s",message.c_str());
+            }
+        }
+        
+        // The records may be overwritten once the tail moves
+        for(size_t ii = 0; ii < active.size(); ii++) {
+            active[ii]->tail.store(heads[ii], std::memory_order_release);
+        }
+        if (!batch.empty()) {
+            _writer->write(batch.c_str());
+            batch.clear();
+        }
+        if (_autof || asked != _flushDone) {
             _writer->flush();
         }
+        
+        lock.lock();
+        _flushDone = asked;
+        _drainDone.notify_all();
+        
+        // Release the buffers of threads that have exited
+        _rings.erase(std::remove_if(_rings.begin(), _rings.end(), [](const std::shared_ptr<Ring>& ring) {
+            return ring->orphaned.load(std::memory_order_acquire) && ring->used() == 0;
+        }), _rings.end());
+        
+        if (stopping) {
+            break;
+        } else if (_flushAsked == asked && !_stopping) {
+            _drainWake.wait_for(lock, std::chrono::milliseconds(DRAIN_INTERVAL));
+        }
     }
 }
 
@@ -417,12 +1351,19 @@ void Logger::log(const std::string format, ...) {
         CUAssertLog(_open, "Channel '%s' is closed.",_name.c_str());
         return;
     }
+    if (_async) {
+        va_list args;
+        va_start (args, format);
+        enqueue(-1, format.c_str(), args);
+        va_end(args);
+        return;
+    }
     
     va_list args;
     va_start (args, format);
-    size_t size = vsnprintf(nullptr, 0, format.c_str(), args)+1;
+    size_t size = vsnprintf(nullptr, 0, format.c_str(), args)+_name.size()+4;
     va_end(args);
-    if (size < _capacity) {
+    if (size > _capacity) {
         expand(size);
     }
     
@@ -473,12 +1414,19 @@ void Logger::log(const char* format, ...) {
         CUAssertLog(_open, "Channel '%s' is closed.",_name.c_str());
         return;
     }
+    if (_async) {
+        va_list args;
+        va_start (args, format);
+        enqueue(-1, format, args);
+        va_end(args);
+        return;
+    }
 
     va_list args;
     va_start (args, format);
-    size_t size = vsnprintf(nullptr, 0, format, args)+1;
+    size_t size = vsnprintf(nullptr, 0, format, args)+_name.size()+4;
     va_end(args);
-    if (size < _capacity) {
+    if (size > _capacity) {
         expand(size);
     }
     
@@ -529,12 +1477,19 @@ void Logger::log(Level level, const std::string format, ...) {
         CUAssertLog(_open, "Channel '%s' is closed.",_name.c_str());
         return;
     }
+    if (_async) {
+        va_list args;
+        va_start (args, format);
+        enqueue((int)level, format.c_str(), args);
+        va_end(args);
+        return;
+    }
 
     va_list args;
     va_start (args, format);
     size_t size = vsnprintf(nullptr, 0, format.c_str(), args)+_name.size()+4;
     va_end(args);
-    if (size < _capacity) {
+    if (size > _capacity) {
         expand(size);
     }
     
@@ -588,12 +1543,19 @@ void Logger::log(Level level, const char* format, ...) {
         CUAssertLog(_open, "Channel '%s' is closed.",_name.c_str());
         return;
     }
+    if (_async) {
+        va_list args;
+        va_start (args, format);
+        enqueue((int)level, format, args);
+        va_end(args);
+        return;
+    }
 
     va_list args;
     va_start (args, format);
     size_t size = vsnprintf(nullptr, 0, format, args)+_name.size()+4;
     va_end(args);
-    if (size < _capacity) {
+    if (size > _capacity) {
         expand(size);
     }
     
@@ -635,9 +1597,19 @@ void Logger::log(Level level, const char* format, ...) {
  * Otherwise, the file is written after every message. To improve
  * performance, you may wish to disable auto flush if you are writting a
  * large number of messages per animation frame.
+ *
+ * For an asynchronous logger, this method blocks until the background
+ * thread has written every message logged before the call.
  */
 void Logger::flush() {
-    if (_open) {
+    if (!_open) {
+        return;
+    } else if (_async) {
+        std::unique_lock<std::mutex> lock(_drainMutex);
+        Uint64 ticket = ++_flushAsked;
+        _drainWake.notify_one();
+        _drainDone.wait(lock, [&] { return _flushDone >= ticket; });
+    } else {
         _writer->flush();
     }
 }
@@ -160,6 +160,47 @@ void ThreadPool::addTask(const std::function<void()> &task){
     _taskCondition.notify_one();
 }
 
+/**
+ * Runs the given indexed tasks, returning when they are all complete.
+ *
+ * The task is called once for each index from 0 to count-1. Index 0 is
+ * run on the calling thread, and the rest are added to this pool. This
+ * method blocks until every task has finished, so the tasks may safely
+ * reference the stack of the caller. The order in which the tasks run
+ * is unspecified, so a task should only write to data owned by its index.
+ *
+ * This method should never be called from a task of this pool, as the
+ * nested tasks may wait on a worker that is blocked.
+ *
+ * @param count The number of tasks
+ * @param task  The task to run (given the task index)
+ */
+void ThreadPool::parallelFor(Uint32 count, const std::function<void(Uint32)>& task) {
+    if (count == 0) {
+        return;
+    } else if (count == 1) {
+        task(0);
+        return;
+    }
+
+    // A countdown latch for the tasks on the workers
+    std::mutex mutex;
+    std::condition_variable condition;
+    Uint32 pending = count-1;
+    for(Uint32 ii = 1; ii < count; ii++) {
+        addTask([&,ii]() {
+            task(ii);
+            std::unique_lock<std::mutex> lk(mutex);
+            if (--pending == 0) {
+                condition.notify_one();
+            }
+        });
+    }
+    task(0);
+    std::unique_lock<std::mutex> lk(mutex);
+    condition.wait(lk, [&] { return pending == 0; });
+}
+
 /**
  * Stops the thread pool, marking it for shut down.
  *
@@ -174,12 +215,18 @@ void ThreadPool::stop() {
         _taskCondition.notify_all();
     }
     
+    // Stopping twice (such as stop followed by dispose) must not rejoin
     for (auto&& worker : _workers) {
 #ifdef CU_SDL_THREADS
-        int status;
-        SDL_WaitThread(worker,&status);
+        if (worker != nullptr) {
+            int status;
+            SDL_WaitThread(worker,&status);
+            worker = nullptr;
+        }
 #else
-        worker.join();
+        if (worker.joinable()) {
+            worker.join();
+        }
 #endif
     }
 }
@@ -44,6 +44,7 @@
 //
 #include <deque>
 #include <algorithm>
+#include <cfloat>
 #include <utf8/utf8.h>
 #include <cugl/core/util/CUDebug.h>
 #include <cugl/core/util/CUFiletools.h>
@@ -67,6 +68,15 @@ using namespace cugl::graphics;
 /** The number of spaces to a tab character */
 #define TAB_SPACE       4
 
+/** The number of bits for a character in a page of the glyph table */
+#define GLYPH_PAGE_BITS 8
+/** The number of characters in a page of the glyph table */
+#define GLYPH_PAGE_SIZE (1 << GLYPH_PAGE_BITS)
+/** The number of characters in the basic multilingual plane */
+#define GLYPH_BMP_SIZE  0x10000
+/** The number of characters (from 0) in the direct kerning table */
+#define KERN_ASCII_SIZE 128
+
 /**
  * Returns true if thechar is a Unicode control character
  *
@@ -105,6 +115,7 @@ static bool is_whitespace(Uint32 thechar) {
 Font::Atlas::Atlas() :
 _parent(nullptr),
 _surface(nullptr),
+_shelf(0),
 texture(nullptr) {
 }
 
@@ -121,6 +132,8 @@ void Font::Atlas::dispose() {
 	}
 	_parent = nullptr;
 	_size = Size::ZERO;
+    _cursor = Vec2::ZERO;
+    _shelf = 0;
     texture = nullptr;
 	glyphmap.clear();
 }
@@ -153,6 +166,104 @@ bool Font::Atlas::init(Font* parent, std::deque<Uint32>& glyphset)  {
     return glyphmap.size() > 0;
 }
 
+/**
+ * Initializes an empty dynamic atlas for the given font
+ *
+ * A dynamic atlas starts with no glyphs. Glyphs are added one at a
+ * time with {@link #insert}, which packs them into horizontal shelves
+ * and copies them straight to the texture. Hence this initializer
+ * creates the (blank) texture immediately, and it may only be called
+ * on the main thread.
+ *
+ * @param parent    The parent font of this atlas
+ * @param size      The width and height of the atlas texture
+ *
+ * @return true if the atlas was successfully initialized
+ */
+bool Font::Atlas::initDynamic(Font* parent, int size) {
+    this->_parent = parent;
+    _size.set(size,size);
+    
+    // Start blank, except for the 2 patch at the beginning
+    std::vector<Uint8> pixels(4*size*size,0);
+    for(int ii = 0; ii < 2; ii++) {
+        std::memset(pixels.data()+4*ii*size,255,8);
+    }
+    texture = Texture::allocWithData(pixels.data(), size, size);
+    _cursor.set(2,0);
+    _shelf = 0;
+    return texture != nullptr;
+}
+
+/**
+ * Adds a glyph to this dynamic atlas.
+ *
+ * The glyph is placed at the end of the current shelf, or at the
+ * start of a new shelf if the current one is full. The glyph is
+ * rendered and copied to that region of the texture, so this method
+ * may only be called on the main thread. The glyph metrics must
+ * already be known to the parent font.
+ *
+ * This method returns false if there is no room left in the atlas.
+ *
+ * @param thechar   The character to add
+ *
+ * @return true if the glyph was successfully added
+ */
+bool Font::Atlas::insert(Uint32 thechar) {
+    if (glyphmap.find(thechar) != glyphmap.end()) {
+        return true;
+    }
+    
+    float padding = _parent->_atlasPadding;
+    float w = _parent->getMetrics(thechar).advance+GLYPH_BORDER+2*padding;
+    float h = _parent->_fontHeight+GLYPH_BORDER+2*padding;
+    
+    // Start a new shelf if this one is full
+    if (_cursor.x+w > _size.width) {
+        _cursor.x = 0;
+        _cursor.y += _shelf;
+        _shelf = 0;
+    }
+    if (_cursor.x+w > _size.width || _cursor.y+h > _size.height) {
+        return false;
+    }
+    
+    SDL_Color color;
+    color.r = color.g = color.b = color.a = 255;
+    SDL_Surface* temp = TTF_RenderGlyph32_Blended(_parent->_data, thechar, color);
+    if (temp == nullptr) {
+        return false;
+    }
+    
+    // Same spacing as build, but the glyph gets its own surface
+    Rect bounds(_cursor.x+GLYPH_BORDER/2,_cursor.y+GLYPH_BORDER/2,w-GLYPH_BORDER,h-GLYPH_BORDER);
+    SDL_Surface* cell = allocSurface((int)bounds.size.width, (int)bounds.size.height);
+    if (cell == nullptr) {
+        SDL_FreeSurface(temp);
+        return false;
+    }
+    
+    SDL_Rect srcrect, dstrect;
+    dstrect.x = dstrect.y = (int)padding;
+    srcrect.x = srcrect.y = 0;
+    dstrect.w = srcrect.w = (int)(bounds.size.width-2*padding);
+    dstrect.h = srcrect.h = (int)(bounds.size.height-2*padding);
+    SDL_SetSurfaceBlendMode(temp, SDL_BLENDMODE_NONE);
+    SDL_BlitSurface(temp,&srcrect,cell,&dstrect);
+    SDL_FreeSurface(temp);
+    
+    texture->bind();
+    texture->set(cell->pixels, (int)bounds.origin.x, (int)bounds.origin.y, cell->w, cell->h);
+    texture->unbind();
+    SDL_FreeSurface(cell);
+    
+    glyphmap.emplace(thechar,bounds);
+    _cursor.x += w;
+    _shelf = std::max(_shelf,h);
+    return true;
+}
+
 /**
  * Returns true if this font has a glyph for the given (UNICODE) character.
  *
@@ -609,20 +720,24 @@ SDL_Surface* Font::Atlas::allocSurface(int width, int height) {
 Font::Font() :
 _name(""),
 _stylename(""),
-_fontSize(0),
 _data(nullptr),
+_fontSize(0),
 _fontHeight(0),
-_fontAscent(0),
 _fontDescent(0),
+_fontAscent(0),
 _fontLineSkip(0),
-_atlasPadding(0),
-_shrinkLimit(0),
-_stretchLimit(0),
-_fallback(false),
 _fixedWidth(false),
 _useKerning(true),
 _style(Style::NORMAL),
-_hints(Hinting::NORMAL){ }
+_hints(Hinting::NORMAL),
+_kerncount(0),
+_atlasPadding(0),
+_fallback(false),
+_shrinkLimit(0),
+_stretchLimit(0),
+_dynamic(false),
+_dynamicIndex(0),
+_cacheLimit(0) { }
 
 /**
  * Deletes the font resources and resets all attributes.
@@ -648,9 +763,17 @@ void Font::dispose() {
     _style  = Style::NORMAL;
     _hints  = Hinting::NORMAL;
     _glyphsize.clear();
-    _kernmap.clear();
+    _glyphcode.clear();
+    _glyphpages.clear();
+    _glyphextra.clear();
+    _kerncount = 0;
+    _kernascii.clear();
+    _kernpairs.clear();
     _atlases.clear();
     _atlasmap.clear();
+    _dynamicAtlas = nullptr;
+    _dynamicIndex = 0;
+    clearRunCache();
 }
 
 /**
@@ -712,7 +835,10 @@ bool Font::init(const std::string file, Uint32 size) {
  * @return true if this font has a glyph for the given (UNICODE) character.
  */
 bool Font::hasGlyph(Uint32 thechar) const {
-    return thechar == TAB_CHAR || TTF_GlyphIsProvided32(_data, thechar) != 0;
+    if (thechar == TAB_CHAR || findGlyph(thechar) >= 0) {
+        return true;
+    }
+    return TTF_GlyphIsProvided32(_data, thechar) != 0;
 }
 
 /**
@@ -830,6 +956,154 @@ void Font::setPadding(Uint32 padding) {
     }
 }
 
+/**
+ * Sets whether to generate a fallback atlas for glyph runs.
+ *
+ * When creating a set of glyphs run it is possible for some of the
+ * glyphs to be supported by the font, but missing from the all of
+ * the atlases. This is particularly true for unicode characters
+ * beyond the ascii range. By default, the glyph run set will simply
+ * omit this glyphs.
+ *
+ * However, if this value is set to true, the glyph run methods like
+ * {@link #getGlyphs} will generate a one-time atlas for the missing
+ * characters. This atlas will **not** be stored for future use. In
+ * addition, forcing this creation means that the glyph generation
+ * methods are no longer safe to be used outside of the main thread
+ * (this is not an issue if this attribute is false).
+ *
+ * Reseting this value will clear the glyph run cache.
+ *
+ * @param fallback  Whether to generate a fallback atlas for glyph runs.
+ */
+void Font::setAtlasFallback(bool fallback) {
+    if (_fallback != fallback) {
+        _fallback = fallback;
+        clearRunCache();
+    }
+}
+
+/**
+ * Sets whether to add missing glyphs to a dynamic atlas.
+ *
+ * By default, the atlas collection is fixed once it is built, and any
+ * glyph missing from it is either omitted or rendered with a one-time
+ * fallback atlas (see {@link #setAtlasFallback}). If this value is true,
+ * the glyph run methods like {@link #getGlyphs} will instead add any
+ * missing glyphs to a dynamic atlas the first time that they are used.
+ * These glyphs are then part of the atlas collection, so each glyph is
+ * only rendered once. This is ideal for text that changes often, like
+ * counters and timers, as it does not require the characters to be
+ * known ahead of time.
+ *
+ * A dynamic atlas is a fixed size texture, and glyphs are packed into
+ * it on horizontal shelves. When it is full, a new one is started. As
+ * new glyphs are copied directly to the texture, the glyph generation
+ * methods are no longer safe to be used outside of the main thread if
+ * this value is true. This value takes precedence over the fallback
+ * atlas when both are set.
+ *
+ * Reseting this value will clear the glyph run cache.
+ *
+ * @param dynamic   Whether to add missing glyphs to a dynamic atlas.
+ */
+void Font::setAtlasDynamic(bool dynamic) {
+    if (_dynamic != dynamic) {
+        _dynamic = dynamic;
+        clearRunCache();
+    }
+}
+
+/**
+ * Sets the maximum number of lines in the glyph run cache.
+ *
+ * The glyph run cache stores the glyph runs for recently rendered lines
+ * of text, keyed by the text and the tracking width. When the same line
+ * is rendered again, such as when a {@link TextLayout} is regenerated
+ * for a label whose text has not changed (or has changed back), the
+ * glyph runs are copied from the cache and moved to the new origin. Once
+ * the cache is full, the least recently used line is discarded.
+ *
+ * A cached line is only used when it fits in the bounding box. Lines
+ * that must be clipped are generated as normal. Because every glyph
+ * run method updates the cache, a font with a cache is not safe to use
+ * outside of the main thread. Hence the cache is disabled by default
+ * (this value is 0).
+ *
+ * @param limit The maximum number of lines in the glyph run cache
+ */
+void Font::setRunCacheLimit(Uint32 limit) {
+    _cacheLimit = limit;
+    while (_runcache.size() > _cacheLimit) {
+        _runindex.erase(_runcache.back().key);
+        _runcache.pop_back();
+    }
+}
+
+/**
+ * Returns true if the glyph runs for the given line are cached.
+ *
+ * The line is identified by its text and tracking width, as in
+ * {@link #getGlyphs}. This method does not count as a use of the line,
+ * so it does not change which line will be discarded next.
+ *
+ * @param text  The line of text
+ * @param track The tracking width (if positive)
+ *
+ * @return true if the glyph runs for the given line are cached.
+ */
+bool Font::hasCachedRun(const std::string text, float track) const {
+    std::string key(text);
+    key.append(reinterpret_cast<const char*>(&track),sizeof(float));
+    return _runindex.find(key) != _runindex.end();
+}
+
+/**
+ * Sets the limit for shrinking the advance during tracking
+ *
+ * A font can provided limited tracking support to shrink or grow the
+ * space between characters (in order to fit a glyph run to a given
+ * width). This value is the maximum number of units that tracking
+ * will ever reduce the advance between two characters. This limit
+ * is applied uniformly to all characters, including spaces.
+ *
+ * By default this value is 0, disabling all (negative) tracking.
+ *
+ * Reseting this value will clear the glyph run cache.
+ *
+ * @param limit     The limit for shrinking the advance during tracking
+ */
+void Font::setShrinkLimit(Uint32 limit) {
+    if (_shrinkLimit != (int)limit) {
+        _shrinkLimit = limit;
+        clearRunCache();
+    }
+}
+
+/**
+ * Sets the limit for stretching the advance during tracking
+ *
+ * A font can provided limited tracking support to shrink or grow the
+ * space between characters (in order to fit a glyph run to a given
+ * width). This value is the maximum number of units that tracking
+ * will ever grow the advance between two (non-space) characters.
+ *
+ * By default this value is 0. That means that any positive tracking
+ * will be applied to spaces only. In that case, the result would be
+ * equivalent to old-school justification, which stretches a line
+ * by only resizing whitespace.
+ *
+ * Reseting this value will clear the glyph run cache.
+ *
+ * @param limit     The limit for stretching the advance during tracking
+ */
+void Font::setStretchLimit(Uint32 limit) {
+    if (_stretchLimit != (int)limit) {
+        _stretchLimit = limit;
+        clearRunCache();
+    }
+}
+
 #pragma mark -
 #pragma mark Measurements
 /**
@@ -851,8 +1125,9 @@ void Font::setPadding(Uint32 padding) {
  * @return the glyph metrics for the given (Unicode) character.
  */
 const Font::Metrics Font::getMetrics(Uint32 thechar) const {
-    if (_glyphsize.find(thechar) != _glyphsize.end()) {
-        return _glyphsize.at(thechar);
+    Sint32 index = findGlyph(thechar);
+    if (index >= 0) {
+        return _glyphsize[index];
     }
     
     if (thechar == TAB_CHAR) {
@@ -873,7 +1148,8 @@ const Font::Metrics Font::getMetrics(Uint32 thechar) const {
  *
  * This value is the amount of overlap (in pixels) between any two adjacent
  * character glyphs rendered by this font.  If the value is 0, there is no
- * kerning for this pair.
+ * kerning for this pair.  A negative value means the glyphs are spaced
+ * further apart than their advance.
  *
  * The Unicode representation uses the endianness native to the platform.
  * Therefore, this value should not be serialized.  Use UTF8 to represent
@@ -886,9 +1162,11 @@ const Font::Metrics Font::getMetrics(Uint32 thechar) const {
  *
  * @return the kerning adjustment between the two (Unicode) characters.
  */
-unsigned int Font::getKerning(Uint32 a, Uint32 b) const {
-    if (_glyphsize.find(a) != _glyphsize.end() && _glyphsize.find(b) != _glyphsize.end()) {
-        return _kernmap.at(a).at(b);
+int Font::getKerning(Uint32 a, Uint32 b) const {
+    Sint32 aindex = findGlyph(a);
+    Sint32 bindex = findGlyph(b);
+    if (aindex >= 0 && bindex >= 0 && (size_t)std::max(aindex,bindex) < _kerncount) {
+        return findKerning(aindex,bindex);
     }
 
     if (is_control(a) || is_control(b)) {
@@ -962,16 +1240,19 @@ Size Font::getSize(const char* substr, const char* end) const {
     Uint32 prvchar = 0;
     while (begin != end) {
         Uint32 thechar = utf8::next(begin,end);
-        if (_glyphsize.find(thechar) != _glyphsize.end()) {
-            if (prvchar > 0 && _glyphsize.find(prvchar) != _glyphsize.end()) {
-                result.width -= _kernmap.at(prvchar).at(thechar);
+        Sint32 index = findGlyph(thechar);
+        if (index >= 0) {
+            if (prvchar > 0) {
+                result.width -= getKerning(prvchar,thechar);
             }
-            result.width += _glyphsize.at(thechar).advance;
-        } else {
+            result.width += _glyphsize[index].advance;
+        } else if (hasGlyph(thechar)) {
             if (prvchar > 0) {
                 result.width -= computeKerning(prvchar,thechar);
             }
-            result.width +=computeMetrics(thechar).advance;
+            result.width += computeMetrics(thechar).advance;
+        } else {
+            continue;
         }
         prvchar = thechar;
     }
@@ -1066,7 +1347,7 @@ Rect Font::getInternalBounds(const char* substr, const char* end) const {
     while(first == 0 && begin != end) {
         Uint32 ch = utf8::next(begin,end);
         if (hasGlyph(ch)) {
-            metrics = (_glyphsize.find(ch) != _glyphsize.end() ? _glyphsize.at(ch) : computeMetrics(ch));
+            metrics = getMetrics(ch);
             result.origin.x = (float)metrics.minx;
             result.size.width = (float)(metrics.advance-metrics.minx);
             maxy = (metrics.maxy > maxy ? metrics.maxy : maxy);
@@ -1084,9 +1365,8 @@ Rect Font::getInternalBounds(const char* substr, const char* end) const {
     while (begin != end) {
         Uint32 ch = utf8::next(begin,end);
         if (hasGlyph(ch)) {
-            bool present = _glyphsize.find(ch) != _glyphsize.end();
-            result.size.width -= (present ? _kernmap.at(last).at(ch) : computeKerning(last, ch));
-            metrics = (present ? _glyphsize.at(ch) : computeMetrics(ch));
+            result.size.width -= getKerning(last, ch);
+            metrics = getMetrics(ch);
             result.size.width += metrics.advance;
             maxy = (metrics.maxy > maxy ? metrics.maxy : maxy);
             miny = (metrics.miny < miny ? metrics.miny : miny);
@@ -1297,6 +1577,22 @@ std::vector<int> Font::getTracking(const char* substr, const char* end, float wi
  */
 void Font::clearAtlases() {
     _atlases.clear();
+    _atlasmap.clear();
+    _dynamicAtlas = nullptr;
+    _dynamicIndex = 0;
+    clearRunCache();
+}
+
+/**
+ * Deletes all of the lines in the glyph run cache.
+ *
+ * The cache is cleared automatically whenever the atlas collection
+ * or the tracking limits change. Hence this method is only necessary
+ * to reclaim memory.
+ */
+void Font::clearRunCache() {
+    _runcache.clear();
+    _runindex.clear();
 }
 
 /**
@@ -1410,7 +1706,8 @@ bool Font::buildAtlasesAsync() {
         return false;
     }
     
-    gatherKerning(glyphs);
+    gatherKerning();
+    clearRunCache();
     bool success = true;
     while (success && glyphs.size() > 0) {
         std::shared_ptr<Atlas> atlas = Atlas::alloc(this, glyphs);
@@ -1459,7 +1756,8 @@ bool Font::buildAtlasesAsync() {
  */
 bool Font::buildAtlasesAsync(const std::string charset) {
     std::deque<Uint32> glyphs = gatherGlyphs(charset);
-    gatherKerning(glyphs);
+    gatherKerning();
+    clearRunCache();
     bool success = true;
     while (success && glyphs.size() > 0) {
         std::shared_ptr<Atlas> atlas = Atlas::alloc(this, glyphs);
@@ -1509,7 +1807,8 @@ bool Font::buildAtlasesAsync(const std::string charset) {
  */
 bool Font::buildAtlasesAsync(const std::vector<Uint32>& charset) {
     std::deque<Uint32> glyphs = gatherGlyphs(charset);
-    gatherKerning(glyphs);
+    gatherKerning();
+    clearRunCache();
     bool success = true;
     while (success && glyphs.size() > 0) {
         std::shared_ptr<Atlas> atlas = Atlas::alloc(this, glyphs);
@@ -2059,6 +2358,116 @@ size_t Font::getGlyphs(std::unordered_map<GLuint, std::shared_ptr<GlyphRun>>& ru
     bounds.size.width  += 2*_atlasPadding;
     bounds.size.height += 2*_atlasPadding;
 
+    if (_cacheLimit == 0) {
+        if (_dynamic) {
+            buildDynamicGlyphs(substr, end);
+        }
+        return generateGlyphs(runs, substr, end, origin, bounds, track);
+    }
+    
+    std::string key(substr,end);
+    key.append(reinterpret_cast<const char*>(&track),sizeof(float));
+    auto find = _runindex.find(key);
+    if (find != _runindex.end()) {
+        _runcache.splice(_runcache.begin(), _runcache, find->second);
+    } else {
+        if (_dynamic) {
+            buildDynamicGlyphs(substr, end);
+        } else if (_fallback) {
+            // Local atlases do not outlive this call, so they cannot be cached
+            const char* begin = substr;
+            while (begin != end) {
+                if (_atlasmap.find(utf8::next(begin,end)) == _atlasmap.end()) {
+                    return generateGlyphs(runs, substr, end, origin, bounds, track);
+                }
+            }
+        }
+        
+        // Generate at the origin with no bounding box
+        CachedRun entry;
+        entry.key = key;
+        Rect everywhere(-FLT_MAX/4,-FLT_MAX/4,FLT_MAX/2,FLT_MAX/2);
+        entry.total = generateGlyphs(entry.runs, substr, end, Vec2::ZERO, everywhere, track);
+        
+        Vec2 minp(FLT_MAX,FLT_MAX);
+        Vec2 maxp(-FLT_MAX,-FLT_MAX);
+        for(auto it = entry.runs.begin(); it != entry.runs.end(); ++it) {
+            const std::vector<SpriteVertex>& vertices = it->second->mesh.vertices;
+            for(auto jt = vertices.begin(); jt != vertices.end(); ++jt) {
+                minp.x = std::min(minp.x,jt->position.x);
+                minp.y = std::min(minp.y,jt->position.y);
+                maxp.x = std::max(maxp.x,jt->position.x);
+                maxp.y = std::max(maxp.y,jt->position.y);
+            }
+        }
+        
+        // Quads are shifted by the padding after they are bounds checked
+        if (!entry.runs.empty()) {
+            entry.extent.set(minp.x+_atlasPadding, minp.y+_atlasPadding, maxp.x-minp.x, maxp.y-minp.y);
+        }
+        
+        _runcache.push_front(std::move(entry));
+        _runindex.emplace(key, _runcache.begin());
+        if (_runcache.size() > _cacheLimit) {
+            _runindex.erase(_runcache.back().key);
+            _runcache.pop_back();
+        }
+    }
+    
+    // Lines that need clipping are not cached
+    const CachedRun& entry = _runcache.front();
+    Rect extent = entry.extent;
+    extent.origin += origin;
+    if (!entry.runs.empty() && !bounds.contains(extent)) {
+        return generateGlyphs(runs, substr, end, origin, bounds, track);
+    }
+    
+    for(auto it = entry.runs.begin(); it != entry.runs.end(); ++it) {
+        std::shared_ptr<GlyphRun> grun;
+        auto jt = runs.find(it->first);
+        if (jt == runs.end()) {
+            grun = GlyphRun::alloc();
+            grun->texture = it->second->texture;
+            runs[it->first] = grun;
+        } else {
+            grun = jt->second;
+        }
+        
+        const Mesh<SpriteVertex>& source = it->second->mesh;
+        Mesh<SpriteVertex>& mesh = grun->mesh;
+        GLuint size = (GLuint)mesh.vertices.size();
+        mesh.vertices.reserve(size+source.vertices.size());
+        for(auto kt = source.vertices.begin(); kt != source.vertices.end(); ++kt) {
+            mesh.vertices.push_back(*kt);
+            mesh.vertices.back().position += origin;
+        }
+        mesh.indices.reserve(mesh.indices.size()+source.indices.size());
+        for(auto kt = source.indices.begin(); kt != source.indices.end(); ++kt) {
+            mesh.indices.push_back(size+*kt);
+        }
+        grun->contents.insert(it->second->contents.begin(), it->second->contents.end());
+    }
+    return entry.total;
+}
+
+/**
+ * Stores the glyph runs to render the given string in the given map
+ *
+ * This method is the uncached implementation of {@link #getGlyphs}. The
+ * bounds must already include the atlas padding.
+ *
+ * @param runs      The map to store the glyph runs
+ * @param substr    The start of the string for glyph generation
+ * @param end       The end of the string for glyph generation
+ * @param origin    The position of the first character
+ * @param bounds    The bounding box for the quads (with padding)
+ * @param track     The tracking width (if positive)
+ *
+ * @return the number of glyphs successfully processed
+ */
+size_t Font::generateGlyphs(std::unordered_map<GLuint, std::shared_ptr<GlyphRun>>& runs,
+                            const char* substr, const char* end, const Vec2 origin,
+                            const Rect bounds, float track) {
     Vec2 offset = origin;
     const char* begin = substr;
     const char* check = substr;
@@ -2069,7 +2478,7 @@ size_t Font::getGlyphs(std::unordered_map<GLuint, std::shared_ptr<GlyphRun>>& ru
         adjusts = getTracking(substr, end, track);
     }
     size_t total = 0;
-    if (_fallback) {
+    if (_fallback && !_dynamic) {
         // See which any characters are missing
         std::vector<Uint32> missing;
         while (begin != end) {
@@ -2090,7 +2499,7 @@ size_t Font::getGlyphs(std::unordered_map<GLuint, std::shared_ptr<GlyphRun>>& ru
         while (begin != end) {
             Uint32 thechar = utf8::next(begin,end);
             if (prvchar > 0) {
-                offset.x -= _kernmap[prvchar][thechar];
+                offset.x -= findKerning(findGlyph(prvchar),findGlyph(thechar));
                 if (track > 0 && pos < adjusts.size()) {
                     offset.x += adjusts[pos++];
                 }
@@ -2141,7 +2550,7 @@ size_t Font::getGlyphs(std::unordered_map<GLuint, std::shared_ptr<GlyphRun>>& ru
         while (begin != end) {
             Uint32 thechar = utf8::next(begin,end);
             if (prvchar > 0) {
-                offset.x -= _kernmap[prvchar][thechar];
+                offset.x -= findKerning(findGlyph(prvchar),findGlyph(thechar));
                 if (track > 0 && pos < adjusts.size()) {
                     offset.x += adjusts[pos++];
                 }
@@ -2211,6 +2620,12 @@ size_t Font::getGlyphs(std::unordered_map<GLuint, std::shared_ptr<GlyphRun>>& ru
  */
 std::shared_ptr<GlyphRun> Font::getGlyph(Uint32 thechar, Vec2& offset) {
     std::shared_ptr<GlyphRun> grun = nullptr;
+    if (_dynamic && _atlasmap.find(thechar) == _atlasmap.end()) {
+        char str[5];
+        std::memset(str,0,5);
+        char* end = utf8::append(thechar, str);
+        buildDynamicGlyphs(str, end);
+    }
     if (_atlasmap.find(thechar) != _atlasmap.end()) {
         std::shared_ptr<Atlas> atlas = _atlases[_atlasmap[thechar]];
         grun = GlyphRun::alloc();
@@ -2220,7 +2635,7 @@ std::shared_ptr<GlyphRun> Font::getGlyph(Uint32 thechar, Vec2& offset) {
         std::vector<Uint32> charset;
         charset.push_back(thechar);
         std::deque<Uint32> glyphs = gatherGlyphs(charset);
-        gatherKerning(glyphs);
+        gatherKerning();
         std::shared_ptr<Atlas> atlas = Atlas::alloc(this, glyphs);
         grun = GlyphRun::alloc();
         grun->texture = atlas->texture;
@@ -2268,6 +2683,12 @@ std::shared_ptr<GlyphRun> Font::getGlyph(Uint32 thechar, Vec2& offset) {
  */
 std::shared_ptr<GlyphRun> Font::getGlyph(Uint32 thechar, Vec2& offset, const Rect rect) {
     std::shared_ptr<GlyphRun> grun = nullptr;
+    if (_dynamic && _atlasmap.find(thechar) == _atlasmap.end()) {
+        char str[5];
+        std::memset(str,0,5);
+        char* end = utf8::append(thechar, str);
+        buildDynamicGlyphs(str, end);
+    }
     if (_atlasmap.find(thechar) != _atlasmap.end()) {
         std::shared_ptr<Atlas> atlas = _atlases[_atlasmap[thechar]];
         grun = GlyphRun::alloc();
@@ -2277,7 +2698,7 @@ std::shared_ptr<GlyphRun> Font::getGlyph(Uint32 thechar, Vec2& offset, const Rec
         std::vector<Uint32> charset;
         charset.push_back(thechar);
         std::deque<Uint32> glyphs = gatherGlyphs(charset);
-        gatherKerning(glyphs);
+        gatherKerning();
         std::shared_ptr<Atlas> atlas = Atlas::alloc(this, glyphs);
         grun = GlyphRun::alloc();
         grun->texture = atlas->texture;
@@ -2692,9 +3113,9 @@ size_t Font::getGlyphBoxes(Mesh<SpriteVertex>& mesh, const char* substr, const c
     Uint32 pos = 0;
     while (begin != end) {
         Uint32 thechar = utf8::next(begin,end);
-        if (_glyphsize.find(thechar) != _glyphsize.end()) {
+        if (findGlyph(thechar) >= 0) {
             if (prvchar > 0) {
-                offset.x -= _kernmap[prvchar][thechar];
+                offset.x -= getKerning(prvchar,thechar);
                 if (track > 0 && pos < adjusts.size()) {
                     offset.x += adjusts[pos++];
                 }
@@ -2736,7 +3157,7 @@ std::deque<Uint32> Font::gatherGlyphs() {
     for(Uint32 ii = 32; ii < 127; ii++) {
         if (_atlasmap.find(ii) == _atlasmap.end() && TTF_GlyphIsProvided32(_data, ii)) {
             Metrics metrics = computeMetrics(ii);
-            _glyphsize.emplace(ii,metrics);
+            addGlyph(ii,metrics);
             added.push_back(ii);
         }
     }
@@ -2744,14 +3165,14 @@ std::deque<Uint32> Font::gatherGlyphs() {
     // Tabs for good measure
     if ((_atlasmap.find(TAB_CHAR) == _atlasmap.end()) && (_atlasmap.find(SPACE_CHAR) != _atlasmap.end())) {
         Metrics metrics = computeMetrics(TAB_CHAR);
-        _glyphsize.emplace(TAB_CHAR,metrics);
+        addGlyph(TAB_CHAR,metrics);
         // NOT added to atlas, since space is a proxy
     }
     
     // Sort them by width
     std::sort(added.begin(),added.end(),[&](Uint32 a, Uint32 b) {
-        int aad = _glyphsize[a].advance;
-        int bad = _glyphsize[b].advance;
+        int aad = _glyphsize[findGlyph(a)].advance;
+        int bad = _glyphsize[findGlyph(b)].advance;
         return (aad > bad || (aad == bad && a > b));
     });
     
@@ -2783,23 +3204,23 @@ std::deque<Uint32> Font::gatherGlyphs(const std::string charset) {
         if (thechar == TAB_CHAR && _atlasmap.find(thechar) == _atlasmap.end()) {
             if (_atlasmap.find(SPACE_CHAR) == _atlasmap.end() && TTF_GlyphIsProvided32(_data, SPACE_CHAR)) {
                 Metrics metrics = computeMetrics(SPACE_CHAR);
-                _glyphsize.emplace(SPACE_CHAR,metrics);
+                addGlyph(SPACE_CHAR,metrics);
                 added.push_back(SPACE_CHAR);
             }
             Metrics metrics = computeMetrics(TAB_CHAR);
-            _glyphsize.emplace(TAB_CHAR,metrics);
+            addGlyph(TAB_CHAR,metrics);
             // NOT added to atlas, since space is a proxy
         } else if (_atlasmap.find(thechar) == _atlasmap.end() && TTF_GlyphIsProvided32(_data, thechar)) {
             Metrics metrics = computeMetrics(thechar);
-            _glyphsize.emplace(thechar,metrics);
+            addGlyph(thechar,metrics);
             added.push_back(thechar);
         }
     }
     
     // Sort them by width
     std::sort(added.begin(),added.end(),[&](Uint32 a, Uint32 b) {
-        int aad = _glyphsize[a].advance;
-        int bad = _glyphsize[b].advance;
+        int aad = _glyphsize[findGlyph(a)].advance;
+        int bad = _glyphsize[findGlyph(b)].advance;
         return (aad > bad || (aad == bad && a > b));
     });
     
@@ -2827,23 +3248,23 @@ std::deque<Uint32> Font::gatherGlyphs(const std::vector<Uint32>& charset) {
         if (*it == TAB_CHAR && _atlasmap.find(*it) == _atlasmap.end()) {
             if (_atlasmap.find(SPACE_CHAR) == _atlasmap.end() && TTF_GlyphIsProvided32(_data, SPACE_CHAR)) {
                 Metrics metrics = computeMetrics(SPACE_CHAR);
-                _glyphsize.emplace(SPACE_CHAR,metrics);
+                addGlyph(SPACE_CHAR,metrics);
                 added.push_back(SPACE_CHAR);
             }
             Metrics metrics = computeMetrics(TAB_CHAR);
-            _glyphsize.emplace(TAB_CHAR,metrics);
+            addGlyph(TAB_CHAR,metrics);
             // NOT added to atlas, since space is a proxy
         } else if (_atlasmap.find(*it) == _atlasmap.end() && TTF_GlyphIsProvided32(_data, *it)) {
             Metrics metrics = computeMetrics(*it);
-            _glyphsize.emplace(*it,metrics);
+            addGlyph(*it,metrics);
             added.push_back(*it);
         }
     }
     
     // Sort them by width
     std::sort(added.begin(),added.end(),[&](Uint32 a, Uint32 b) {
-        int aad = _glyphsize[a].advance;
-        int bad = _glyphsize[b].advance;
+        int aad = _glyphsize[findGlyph(a)].advance;
+        int bad = _glyphsize[findGlyph(b)].advance;
         return (aad > bad || (aad == bad && a > b));
     });
     
@@ -2851,22 +3272,133 @@ std::deque<Uint32> Font::gatherGlyphs(const std::vector<Uint32>& charset) {
 }
 
 /**
- * Gathers the kerning information for given characters.
+ * Gathers the kerning information for all new characters.
+ *
+ * The new characters are those gathered since the last call to this
+ * method. They will not only be kerned against each other, but they will
+ * also be kerned against any existing characters.
+ */
+void Font::gatherKerning() {
+    // Only pairs with a new glyph need to be computed
+    size_t start = _kerncount;
+    size_t total = _glyphsize.size();
+    if (start == total) {
+        return;
+    }
+    if (_kernascii.empty()) {
+        _kernascii.resize(KERN_ASCII_SIZE*KERN_ASCII_SIZE,0);
+    }
+    
+    size_t sorted = _kernpairs.size();
+    auto store = [&](size_t a, size_t b) {
+        Uint32 achar = _glyphcode[a];
+        Uint32 bchar = _glyphcode[b];
+        int kerning = computeKerning(achar, bchar);
+        if (achar < KERN_ASCII_SIZE && bchar < KERN_ASCII_SIZE) {
+            _kernascii[achar*KERN_ASCII_SIZE+bchar] = (Sint16)kerning;
+        } else if (kerning != 0) {
+            _kernpairs.push_back(std::make_pair(((Uint64)achar << 32) | bchar, kerning));
+        }
+    };
+    
+    for(size_t ii = start; ii < total; ii++) {
+        for(size_t jj = 0; jj < total; jj++) {
+            store(ii,jj);
+            if (jj < start) {
+                store(jj,ii);
+            }
+        }
+    }
+    
+    // Existing pairs are already sorted
+    std::sort(_kernpairs.begin()+sorted, _kernpairs.end());
+    std::inplace_merge(_kernpairs.begin(), _kernpairs.begin()+sorted, _kernpairs.end());
+    _kerncount = total;
+}
+
+/**
+ * Returns the position of the character in the glyph metrics
  *
- * These characters will not only be kerned against each other, but
- * they will also be kerned against any existing characters.
+ * This method returns -1 if the glyph metrics for this character have
+ * not been gathered.
  *
- * @param glyphs    The glyphs to acquire kerning data for
+ * @param thechar   The Unicode character to find
+ *
+ * @return the position of the character in the glyph metrics
  */
-void Font::gatherKerning(const std::deque<Uint32>& glyphs) {
-    for(auto it = _glyphsize.begin(); it != _glyphsize.end(); ++it) {
-        if (_kernmap.find(it->first) == _kernmap.end()) {
-            _kernmap.emplace(it->first, std::unordered_map<Uint32, Uint32>());
+Sint32 Font::findGlyph(Uint32 thechar) const {
+    if (thechar < GLYPH_BMP_SIZE) {
+        size_t page = thechar >> GLYPH_PAGE_BITS;
+        if (page >= _glyphpages.size() || _glyphpages[page].empty()) {
+            return -1;
         }
-        for(auto jt = _glyphsize.begin(); jt != _glyphsize.end(); ++jt) {
-            _kernmap[it->first].emplace(jt->first, computeKerning(it->first, jt->first));
+        return (Sint32)_glyphpages[page][thechar & (GLYPH_PAGE_SIZE-1)]-1;
+    }
+    
+    auto it = _glyphextra.find(thechar);
+    return it == _glyphextra.end() ? -1 : (Sint32)it->second;
+}
+
+/**
+ * Adds the glyph metrics for the given character
+ *
+ * This method does nothing if the metrics for this character have
+ * already been gathered.
+ *
+ * @param thechar   The Unicode character to add
+ * @param metrics   The glyph metrics of the character
+ */
+void Font::addGlyph(Uint32 thechar, const Metrics& metrics) {
+    if (findGlyph(thechar) >= 0) {
+        return;
+    }
+    
+    Uint32 index = (Uint32)_glyphsize.size();
+    if (thechar < GLYPH_BMP_SIZE) {
+        size_t page = thechar >> GLYPH_PAGE_BITS;
+        if (page >= _glyphpages.size()) {
+            _glyphpages.resize(page+1);
         }
+        if (_glyphpages[page].empty()) {
+            _glyphpages[page].resize(GLYPH_PAGE_SIZE,0);
+        }
+        _glyphpages[page][thechar & (GLYPH_PAGE_SIZE-1)] = index+1;
+    } else {
+        _glyphextra.emplace(thechar,index);
     }
+    _glyphsize.push_back(metrics);
+    _glyphcode.push_back(thechar);
+}
+
+/**
+ * Returns the kerning between two gathered characters.
+ *
+ * The characters are specified by their position in the glyph metrics.
+ * This method returns 0 if either character does not have kerning
+ * information yet.
+ *
+ * @param a     The position of the first character in the pair
+ * @param b     The position of the second character in the pair
+ *
+ * @return the kerning between two gathered characters.
+ */
+int Font::findKerning(Sint32 a, Sint32 b) const {
+    if (a < 0 || b < 0 || (size_t)std::max(a,b) >= _kerncount) {
+        return 0;
+    }
+    
+    Uint32 achar = _glyphcode[a];
+    Uint32 bchar = _glyphcode[b];
+    if (achar < KERN_ASCII_SIZE && bchar < KERN_ASCII_SIZE) {
+        return _kernascii[achar*KERN_ASCII_SIZE+bchar];
+    }
+    
+    Uint64 key = ((Uint64)achar << 32) | bchar;
+    auto it = std::lower_bound(_kernpairs.begin(), _kernpairs.end(), key,
+                               [](const std::pair<Uint64, int>& pair, Uint64 value) {
+        return pair.first < value;
+    });
+    return (it != _kernpairs.end() && it->first == key) ? it->second : 0;
 }
 
 /**
@@ -2886,7 +3418,7 @@ Font::Metrics Font::computeMetrics(Uint32 thechar) const {
         return metrics;
     }
     
-    Metrics metrics;
+    Metrics metrics = {0, 0, 0, 0, 0};
     int success = TTF_GlyphMetrics32(_data, thechar, &metrics.minx, &metrics.maxx,
                                    &metrics.miny,  &metrics.maxy, &metrics.advance);
     
@@ -2933,8 +3465,10 @@ int Font::computeKerning(Uint32 a, Uint32 b) const {
     
     int w1, w2;
     TTF_SizeUTF8(_data, str, &w1, &w2);
-    w2 =  (_glyphsize.find(a) != _glyphsize.end() ? _glyphsize.at(a).advance : computeMetrics(a).advance);
-    w2 += (_glyphsize.find(b) != _glyphsize.end() ? _glyphsize.at(b).advance : computeMetrics(b).advance);
+    Sint32 aindex = findGlyph(a);
+    Sint32 bindex = findGlyph(b);
+    w2 =  (aindex >= 0 ? _glyphsize[aindex].advance : computeMetrics(a).advance);
+    w2 += (bindex >= 0 ? _glyphsize[bindex].advance : computeMetrics(b).advance);
     
     return w2-w1;
 }
@@ -2967,7 +3501,7 @@ bool Font::buildLocalAtlases(const std::vector<Uint32>& charset,
                              std::unordered_map<Uint32, size_t>& map) {
     
     std::deque<Uint32> glyphs = gatherGlyphs(charset);
-    gatherKerning(glyphs);
+    gatherKerning();
     bool success = true;
     while (success && glyphs.size() > 0) {
         std::shared_ptr<Atlas> atlas = Atlas::alloc(this, glyphs);
@@ -2989,6 +3523,63 @@ bool Font::buildLocalAtlases(const std::vector<Uint32>& charset,
     return success;
 }
 
+/**
+ * Adds any glyphs in the given string missing from the atlases.
+ *
+ * The missing glyphs are added to the current dynamic atlas, and a new
+ * dynamic atlas is started when that one is full. Unlike local atlases,
+ * these glyphs become part of the atlas collection. Characters that are
+ * not supported by the font are ignored.
+ *
+ * WARNING: This method is not thread safe. It modifies an OpenGL texture,
+ * which means that it may only be called in the main thread.
+ *
+ * @param substr    The start of the string to check
+ * @param end       The end of the string to check
+ *
+ * @return true if all supported glyphs were successfully added.
+ */
+bool Font::buildDynamicGlyphs(const char* substr, const char* end) {
+    std::vector<Uint32> missing;
+    const char* begin = substr;
+    while (begin != end) {
+        Uint32 thechar = utf8::next(begin,end);
+        if (_atlasmap.find(thechar) == _atlasmap.end()) {
+            missing.push_back(thechar);
+        }
+    }
+    if (missing.empty()) {
+        return true;
+    }
+    
+    std::deque<Uint32> glyphs = gatherGlyphs(missing);
+    gatherKerning();
+    bool success = true;
+    for(auto it = glyphs.begin(); success && it != glyphs.end(); ++it) {
+        if (_atlasmap.find(*it) != _atlasmap.end()) {
+            continue;
+        }
+        if (_dynamicAtlas == nullptr || !_dynamicAtlas->insert(*it)) {
+            int cell = std::max(_glyphsize[findGlyph(*it)].advance,_fontHeight)+GLYPH_BORDER+2*_atlasPadding;
+            std::shared_ptr<Atlas> atlas = Atlas::allocDynamic(this, std::max(MAX_ATLAS_SIZE,(int)nextPOT(cell)));
+            success = atlas != nullptr && atlas->insert(*it);
+            if (success) {
+                _dynamicAtlas = atlas;
+                _dynamicIndex = _atlases.size();
+                _atlases.push_back(atlas);
+            }
+        }
+        if (success) {
+            _atlasmap.emplace(*it,_dynamicIndex);
+            if (*it == SPACE_CHAR) {
+                _atlasmap.emplace(TAB_CHAR,_dynamicIndex);
+            }
+        }
+    }
+    
+    return success;
+}
+
 /**
  * Creates a quad outline of this character and stores it in mesh
  *
@@ -3016,12 +3607,7 @@ bool Font::getOutline(Uint32 thechar, Vec2& offset, Mesh<SpriteVertex>& mesh, co
     // Technically, this answer is correct
     if (!hasGlyph(thechar)) { return true; }
     
-    Metrics metrics;
-    if (_glyphsize.find(thechar) != _glyphsize.end()) {
-        metrics = _glyphsize[thechar];
-    } else {
-        metrics = computeMetrics(thechar);
-    }
+    Metrics metrics = getMetrics(thechar);
     Rect quad(offset,Size(metrics.advance,metrics.maxy-metrics.miny));
     quad.origin.y += metrics.miny-_fontDescent;
     
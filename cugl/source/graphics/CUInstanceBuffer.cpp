@@ -145,8 +145,7 @@ void InstanceBuffer::attach(const std::shared_ptr<Shader>& shader) {
             }
         }
 
-        GLenum error = glGetError();
-        CUAssertLog(error == GL_NO_ERROR, "InstanceBuffer: %s", gl_error_name(error).c_str());
+        CU_GL_CHECK("InstanceBuffer");
     }
 }
 
@@ -186,8 +185,7 @@ void InstanceBuffer::loadInstanceData(const void * data, GLsizei size, GLenum us
     }
     glBindBuffer( GL_ARRAY_BUFFER, 0 );
 
-    GLenum error = glGetError();
-    CUAssertLog(error == GL_NO_ERROR, "InstanceBuffer: %s", gl_error_name(error).c_str());
+    CU_GL_CHECK("InstanceBuffer");
 
 }
 
@@ -222,7 +220,7 @@ void InstanceBuffer::loadInstanceData(const void * data, GLsizei size, GLenum us
 void InstanceBuffer::drawInstanced(GLenum mode, GLsizei count, GLsizei instances, GLint offset) {
     // Assert causes problems on android emulator for now
     //CUAssertLog(isBound(), "Vertex buffer is not bound");
-    glDrawElementsInstanced(mode, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(GLuint)), instances);
+    glDrawElementsInstanced(mode, count, GL_UNSIGNED_INT, (void*)((_indxBase+offset) * sizeof(GLuint)), instances);
 }
     
 /**
@@ -315,7 +313,6 @@ void InstanceBuffer::setupInstanceAttribute(const std::string name, GLint size,
             glVertexAttribDivisor(pos,1);
         }
         
-        GLenum error = glGetError();
-        CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
+        CU_GL_CHECK("VertexBuffer");
     }
 }
@@ -457,6 +457,7 @@ bool SpriteBatch::init(unsigned int capacity, const std::shared_ptr<Shader>& sha
 
     // TODO: Refactor this into ShaderData
     _vertbuff = VertexBuffer::alloc(_indxMax,sizeof(SpriteVertex));
+    _vertbuff->setStreaming(true);
     _vertbuff->setupAttribute("aPosition", 2, GL_FLOAT, GL_FALSE,
                               offsetof(SpriteVertex,position));
     _vertbuff->setupAttribute("aColor",    4, GL_UNSIGNED_BYTE, GL_TRUE,
@@ -2297,6 +2298,172 @@ void SpriteBatch::drawMesh(const SpriteVertex* vertices, size_t size,
     }
 }
 
+#pragma mark -
+#pragma mark Batched Sprites
+/**
+ * Draws many sprites from the same texture in a single call.
+ *
+ * This method is a bulk version of the convenience draw methods. Sprite
+ * ii is the texture region regions[ii], anchored at its center. It is
+ * scaled by scales[ii], rotated by angles[ii] (radians, counter clockwise)
+ * and then placed with its center at positions[ii]. The texture regions
+ * are specified in texture pixel coordinates (e.g from the bottom left
+ * corner), which makes this method ideal for sprite sheets.
+ *
+ * Only the positions array is required. If regions is nullptr, each
+ * sprite is the entire texture. If scales is nullptr, the sprites are not
+ * scaled. If angles is nullptr, the sprites are not rotated. If colors is
+ * nullptr, each sprite is tinted with the active color. Otherwise the
+ * colors replace the active color (which is not changed).
+ *
+ * This method sets the active texture, but it writes the vertices
+ * directly to the sprite batch mesh, bypassing the per-shape overhead
+ * of the fill methods. The vertex positions are computed four corners
+ * at a time when the math library has vector support.
+ *
+ * @param texture   The new active texture
+ * @param regions   The texture region for each sprite (may be nullptr)
+ * @param positions The center of each sprite in world coordinates
+ * @param scales    The scale of each sprite (may be nullptr)
+ * @param angles    The rotation of each sprite (may be nullptr)
+ * @param colors    The color of each sprite (may be nullptr)
+ * @param size      The number of sprites
+ */
+void SpriteBatch::drawSprites(const std::shared_ptr<Texture>& texture, const Rect* regions,
+                              const Vec2* positions, const Vec2* scales, const float* angles,
+                              const Color4* colors, size_t size) {
+    CUAssertLog(texture != nullptr, "Batched sprites require a texture");
+    CUAssertLog(positions != nullptr || size == 0, "Sprite positions are missing");
+    if (size == 0) {
+        return;
+    }
+    
+    setTexture(texture);
+    setCommand(GL_TRIANGLES);
+    
+    // Map pixel coordinates to the texture (which may be a subtexture)
+    float twidth  = (float)texture->getWidth();
+    float theight = (float)texture->getHeight();
+    float tsmin = texture->getMinS();
+    float ttmax = texture->getMaxT();
+    float sscale = (texture->getMaxS()-tsmin)/twidth;
+    float tscale = (ttmax-texture->getMinT())/theight;
+    GLuint active = _color.getPacked();
+
+#if defined CU_MATH_VECTOR_SSE
+    const __m128 kx = _mm_setr_ps(-1.0f, 1.0f, 1.0f,-1.0f);
+    const __m128 ky = _mm_setr_ps(-1.0f,-1.0f, 1.0f, 1.0f);
+#elif defined CU_MATH_VECTOR_NEON64
+    const float kxv[4] = {-1.0f, 1.0f, 1.0f,-1.0f};
+    const float kyv[4] = {-1.0f,-1.0f, 1.0f, 1.0f};
+    const float32x4_t kx = vld1q_f32(kxv);
+    const float32x4_t ky = vld1q_f32(kyv);
+#else
+    const float kx[4] = {-1.0f, 1.0f, 1.0f,-1.0f};
+    const float ky[4] = {-1.0f,-1.0f, 1.0f, 1.0f};
+#endif
+
+    size_t pos = 0;
+    while (pos < size) {
+        if (_vertSize+4 > _vertMax ||  _indxSize+6 > _indxMax) {
+            flush();
+        }
+        setUniformBlock(_context);
+        
+        size_t amt = std::min((size_t)(_vertMax-_vertSize)/4,(size_t)(_indxMax-_indxSize)/6);
+        amt = std::min(amt,size-pos);
+        
+        SpriteVertex* vert = _vertData+_vertSize;
+        GLuint* indx = _indxData+_indxSize;
+        for(size_t ii = pos; ii < pos+amt; ii++) {
+            float rx = 0, ry = 0;
+            float rw = twidth, rh = theight;
+            if (regions) {
+                rx = regions[ii].origin.x;
+                ry = regions[ii].origin.y;
+                rw = regions[ii].size.width;
+                rh = regions[ii].size.height;
+            }
+            
+            // The columns of the transform, pre-multiplied by the half extents
+            float sx = 0.5f*rw;
+            float sy = 0.5f*rh;
+            if (scales) {
+                sx *= scales[ii].x;
+                sy *= scales[ii].y;
+            }
+            float ax = sx, bx = 0, ay = 0, by = sy;
+            if (angles && angles[ii] != 0) {
+                float c = cosf(angles[ii]);
+                float s = sinf(angles[ii]);
+                ax =  c*sx; ay = s*sx;
+                bx = -s*sy; by = c*sy;
+            }
+            
+            float px = positions[ii].x;
+            float py = positions[ii].y;
+#if defined CU_MATH_VECTOR_SSE
+            __m128 xs = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ax),kx),_mm_mul_ps(_mm_set1_ps(bx),ky));
+            __m128 ys = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ay),kx),_mm_mul_ps(_mm_set1_ps(by),ky));
+            xs = _mm_add_ps(xs,_mm_set1_ps(px));
+            ys = _mm_add_ps(ys,_mm_set1_ps(py));
+            __m128 lo = _mm_unpacklo_ps(xs,ys);
+            __m128 hi = _mm_unpackhi_ps(xs,ys);
+            _mm_storel_pi((__m64*)&(vert[0].position),lo);
+            _mm_storeh_pi((__m64*)&(vert[1].position),lo);
+            _mm_storel_pi((__m64*)&(vert[2].position),hi);
+            _mm_storeh_pi((__m64*)&(vert[3].position),hi);
+#elif defined CU_MATH_VECTOR_NEON64
+            float32x4_t xs = vmlaq_n_f32(vmulq_n_f32(kx,ax),ky,bx);
+            float32x4_t ys = vmlaq_n_f32(vmulq_n_f32(kx,ay),ky,by);
+            xs = vaddq_f32(xs,vdupq_n_f32(px));
+            ys = vaddq_f32(ys,vdupq_n_f32(py));
+            float32x4_t lo = vzip1q_f32(xs,ys);
+            float32x4_t hi = vzip2q_f32(xs,ys);
+            vst1_f32((float*)&(vert[0].position),vget_low_f32(lo));
+            vst1_f32((float*)&(vert[1].position),vget_high_f32(lo));
+            vst1_f32((float*)&(vert[2].position),vget_low_f32(hi));
+            vst1_f32((float*)&(vert[3].position),vget_high_f32(hi));
+#else
+            for(int kk = 0; kk < 4; kk++) {
+                vert[kk].position.x = ax*kx[kk]+bx*ky[kk]+px;
+                vert[kk].position.y = ay*kx[kk]+by*ky[kk]+py;
+            }
+#endif
+            
+            // Texture coordinates are flipped vertically
+            float s0 = tsmin+rx*sscale;
+            float s1 = tsmin+(rx+rw)*sscale;
+            float t0 = ttmax-ry*tscale;
+            float t1 = ttmax-(ry+rh)*tscale;
+            GLuint clr = colors ? colors[ii].getPacked() : active;
+            vert[0].texcoord.set(s0,t0);
+            vert[1].texcoord.set(s1,t0);
+            vert[2].texcoord.set(s1,t1);
+            vert[3].texcoord.set(s0,t1);
+            for(int kk = 0; kk < 4; kk++) {
+                vert[kk].gradcoord.set(1,1);
+                vert[kk].color = clr;
+            }
+            
+            GLuint base = (GLuint)(vert-_vertData);
+            indx[0] = base;
+            indx[1] = base+1;
+            indx[2] = base+2;
+            indx[3] = base;
+            indx[4] = base+2;
+            indx[5] = base+3;
+            vert += 4;
+            indx += 6;
+        }
+        
+        _vertSize += (unsigned int)(4*amt);
+        _indxSize += (unsigned int)(6*amt);
+        _inflight = true;
+        pos += amt;
+    }
+}
+
 #pragma mark -
 #pragma mark Text Drawing
 /**
@@ -2956,16 +3123,11 @@ unsigned int SpriteBatch::prepare(const Mesh<SpriteVertex>& mesh, const Affine2&
     for(auto it = mesh.vertices.begin(); it != mesh.vertices.end(); ++it) {
         _vertData[_vertSize+ii] = *it;
         _vertData[_vertSize+ii].position = it->position*mat;
-        if (tint) {
-            Uint32 c = marshall(_vertData[_vertSize+ii].color);
-            Uint32 r = round(_color.r*((c >> 24)/255.0f));
-            Uint32 g = round(_color.g*(((c >> 16) & 0xff)/255.0f));
-            Uint32 b = round(_color.b*(((c >> 8) & 0xff)/255.0f));
-            Uint32 a = round(_color.a*((c & 0xff)/255.0f));
-            _vertData[_vertSize+ii].color = marshall(r << 24 | g << 16 | b << 8 | a);
-        }
         ii++;
     }
+    if (tint) {
+        tintVertices(_vertData+_vertSize, ii);
+    }
     
     int jj = 0;
     for(auto it = mesh.indices.begin(); it != mesh.indices.end(); ++it) {
@@ -3064,16 +3226,11 @@ unsigned int SpriteBatch::prepare(const SpriteVertex* vertices, size_t size, con
     for(size_t kk = 0; kk < size; kk++) {
         _vertData[_vertSize+ii] = vertices[kk];
         _vertData[_vertSize+ii].position = vertices[kk].position*mat;
-        if (tint) {
-            Uint32 c = marshall(_vertData[_vertSize+ii].color);
-            Uint32 r = round(_color.r*((c >> 24)/255.0f));
-            Uint32 g = round(_color.g*(((c >> 16) & 0xff)/255.0f));
-            Uint32 b = round(_color.b*(((c >> 8) & 0xff)/255.0f));
-            Uint32 a = round(_color.a*((c & 0xff)/255.0f));
-            _vertData[_vertSize+ii].color = marshall(r << 24 | g << 16 | b << 8 | a);
-        }
         ii++;
     }
+    if (tint) {
+        tintVertices(_vertData+_vertSize, ii);
+    }
     
     int jj = 0;
     for(Uint32 kk = 2; kk < size; kk++) {
@@ -3142,3 +3299,29 @@ unsigned int SpriteBatch::chunkify(const SpriteVertex* vertices, size_t size, co
     _inflight = true;
     return (unsigned int)(size+start);
 }
+
+/**
+ * Tints the given vertices by the active color.
+ *
+ * The vertex colors are multiplied by the active color and rounded to
+ * the nearest byte. The colors are gathered into blocks so that they
+ * can be tinted with {@link Color4#multiply}, which is vectorized when
+ * the math library has vector support.
+ *
+ * @param vertices  The vertices to tint
+ * @param size      The number of vertices to tint
+ */
+void SpriteBatch::tintVertices(SpriteVertex* vertices, size_t size) {
+    const size_t block = 64;
+    Uint32 colors[block];
+    for(size_t start = 0; start < size; start += block) {
+        size_t amt = std::min(block, size-start);
+        for(size_t ii = 0; ii < amt; ii++) {
+            colors[ii] = vertices[start+ii].color;
+        }
+        Color4::multiply(colors, _color, colors, amt);
+        for(size_t ii = 0; ii < amt; ii++) {
+            vertices[start+ii].color = colors[ii];
+        }
+    }
+}
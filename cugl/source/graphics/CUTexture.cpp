@@ -391,6 +391,46 @@ const Texture& Texture::set(const void *data) {
     return *this;
 }
 
+/**
+ * Sets a rectangular region of this texture to the contents of the buffer.
+ *
+ * The buffer must have the correct data format. In addition, the buffer
+ * must be size width*height*bytesize, where width and height are the
+ * size of the region. The rest of the texture is unchanged. The region
+ * is in pixel coordinates, with the origin at the first row of the
+ * texture data. This method does not regenerate any mipmaps.
+ *
+ * A region with a negative size, or that does not fit in the texture,
+ * is ignored.
+ *
+ * This method is only successful if the texture is currently bound to its
+ * slot.
+ *
+ * @param data      The buffer to read into the texture
+ * @param x         The left edge of the region
+ * @param y         The first row of the region
+ * @param width     The width of the region
+ * @param height    The height of the region
+ *
+ * @return a reference to this (modified) texture for chaining.
+ */
+const Texture& Texture::set(const void *data, int x, int y, int width, int height) {
+    if (!isActive()) {
+        CUAssertLog(false,"Texture %s is not currently active.",_name.c_str());
+        return *this;
+    }
+    if (x < 0 || y < 0 || width < 0 || height < 0 ||
+        (GLuint)(x+width) > _width || (GLuint)(y+height) > _height) {
+        CUAssertLog(false,"Region %dx%d at (%d,%d) is outside of texture %s",
+                    width,height,x,y,_name.c_str());
+        return *this;
+    }
+
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height,
+                    (GLenum)_pixelFormat, GL_UNSIGNED_BYTE, data);
+    return *this;
+}
+
 
 #pragma mark -
 #pragma mark Attributes
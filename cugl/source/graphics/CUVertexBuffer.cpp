@@ -13,6 +13,12 @@
 //  it does not support instancing. For that you will need to use the
 //  InstanceBuffer class, or design your own VertexBuffer abstraction.
 //
+//  A vertex buffer can optionally stream its data. In that mode the buffers
+//  are allocated once as a ring of blocks. Each load is written directly into
+//  mapped buffer memory, and blocks are guarded by fences so that the CPU never
+//  overwrites data the GPU is still reading. This avoids respecifying the
+//  buffer on every load, which is ideal for a SpriteBatch.
+//
 //  This class uses our standard shared-pointer architecture.
 //
 //  1. The constructor does not perform any initialization; it just sets all
@@ -47,6 +53,7 @@
 //  Author: Walker White
 //  Version: 7/3/24 (CUGL 3.0 reorganization)
 //
+#include <cstring>
 #include <cugl/core/util/CUDebug.h>
 #include <cugl/graphics/CUVertexBuffer.h>
 #include <cugl/graphics/CUShader.h>
@@ -65,7 +72,10 @@ VertexBuffer::VertexBuffer() :
 _vertArray(0),
 _vertBuffer(0),
 _indxBuffer(0),
-_stride(0) {
+_stride(0),
+_streaming(false),
+_vertBase(0),
+_indxBase(0) {
     _shader = nullptr;
 }
 
@@ -139,6 +149,12 @@ void VertexBuffer::dispose() {
     }
     _enabled.clear();
     _attributes.clear();
+    _locations.clear();
+    releaseRing(_vertRing);
+    releaseRing(_indxRing);
+    _streaming = false;
+    _vertBase = 0;
+    _indxBase = 0;
     glDeleteBuffers(1,&_indxBuffer);
     glDeleteBuffers(1,&_vertBuffer);
     glDeleteVertexArrays(1,&_vertArray);
@@ -208,24 +224,25 @@ void VertexBuffer::attach(const std::shared_ptr<Shader>& shader) {
         glBindBuffer( GL_ARRAY_BUFFER, _vertBuffer );
 
         // Link up attributes on the first time
+        _locations.clear();
         for(auto it = _attributes.begin(); it != _attributes.end(); ++it) {
             std::string name = it->first;
 			GLint pos = glGetAttribLocation(_shader->getProgram(), name.c_str());
+            _locations[name] = pos;
 			if (pos == -1) {
 				CUWarn("Active shader has no attribute %s", name.c_str());
 			} else if (_enabled[name]) {
 				glEnableVertexAttribArray(pos);
 				glVertexAttribPointer(pos,it->second.size,it->second.type,
 									  it->second.norm,_stride,
-									  reinterpret_cast<void*>(it->second.offset));
+									  reinterpret_cast<void*>(_vertBase+it->second.offset));
                 glVertexAttribDivisor(pos,0);
 			} else {
 				glDisableVertexAttribArray(pos);
 			}
         }
 
-        GLenum error = glGetError();
-        CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
+        CU_GL_CHECK("VertexBuffer");
     } else {
         bind();
     }
@@ -242,6 +259,7 @@ std::shared_ptr<Shader> VertexBuffer::detach() {
     std::shared_ptr<Shader> result = _shader;
     unbind();
     _shader = nullptr;
+    _locations.clear();
     return result;
 }
 
@@ -259,6 +277,33 @@ bool VertexBuffer::isBound() const {
 
 #pragma mark -
 #pragma mark Vertex Processing
+/**
+ * Sets whether this vertex buffer streams its data.
+ *
+ * A streaming buffer is allocated once, as a ring of blocks each with
+ * the full capacity of this buffer. Each call to {@link #loadVertexData}
+ * or {@link #loadIndexData} writes the data directly into mapped memory
+ * at the next free position of the ring, rather than respecifying the
+ * buffer. Fences ensure that no data is overwritten while the GPU is
+ * still reading it.
+ *
+ * Streaming is ideal for buffers that are reloaded several times a frame,
+ * like the one in {@link SpriteBatch}. It requires a nonzero stride. Any
+ * data previously loaded is invalidated by this method, and must be
+ * loaded again.
+ *
+ * @param value Whether this vertex buffer streams its data.
+ */
+void VertexBuffer::setStreaming(bool value) {
+    CUAssertLog(!value || _stride > 0, "Streaming requires a nonzero stride");
+    if (_streaming == value) {
+        return;
+    }
+    releaseRing(_vertRing);
+    releaseRing(_indxRing);
+    _streaming = value;
+}
+
 /**
  * Loads the given vertex buffer with data.
  *
@@ -278,6 +323,9 @@ bool VertexBuffer::isBound() const {
  * can amortize the uniform changes. For quads and other simple meshes,
  * you should always choose GL_STREAM_DRAW.
  *
+ * If this buffer is streaming, the usage is ignored. The data is written
+ * to the next free position of the ring instead.
+ *
  * This method will only succeed if this buffer is actively bound.
  *
  * @param data  The data to load
@@ -289,23 +337,29 @@ void VertexBuffer::loadVertexData(const void * data, GLsizei size, GLenum usage)
     //CUAssertLog(isBound(), "Vertex buffer is not bound");
     CUAssertLog(size <= _size, "Data exceeds maximum capacity: %d > %d",size,_size);
     glBindBuffer( GL_ARRAY_BUFFER, _vertBuffer );
-    GLenum error = glGetError();
-    CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
 
-    if (usage == GL_STATIC_DRAW) {
-        glBufferData( GL_ARRAY_BUFFER, _stride * size, data, usage );
+    if (_streaming) {
+        GLsizeiptr base = streamData(GL_ARRAY_BUFFER, _vertRing, data,
+                                     (GLsizeiptr)_stride*size, (GLsizeiptr)_stride*_size);
+        if (base != _vertBase) {
+            _vertBase = base;
+            rebaseAttributes();
+        }
     } else {
-        // Buffer orphaning
-        glBufferData(GL_ARRAY_BUFFER, _stride*_size, NULL, usage);
-        error = glGetError();
-        CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
-        glBufferSubData(GL_ARRAY_BUFFER, 0, _stride*size, data);
-        error = glGetError();
-        CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
+        if (_vertBase != 0) {
+            _vertBase = 0;
+            rebaseAttributes();
+        }
+        if (usage == GL_STATIC_DRAW) {
+            glBufferData( GL_ARRAY_BUFFER, _stride * size, data, usage );
+        } else {
+            // Buffer orphaning
+            glBufferData(GL_ARRAY_BUFFER, _stride*_size, NULL, usage);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, _stride*size, data);
+        }
     }
 
-    error = glGetError();
-    CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
+    CU_GL_CHECK("VertexBuffer");
 }
 
 /**
@@ -328,6 +382,9 @@ void VertexBuffer::loadVertexData(const void * data, GLsizei size, GLenum usage)
  * you should always choose GL_STREAM_DRAW and push as much computation to the
  * CPU as possible.
  *
+ * If this buffer is streaming, the usage is ignored. The indices are
+ * written to the next free position of the ring instead.
+ *
  * This method will only succeed if this buffer is actively bound.
  *
  * @param data  The indices to load
@@ -339,16 +396,22 @@ void VertexBuffer::loadIndexData(const void * data, GLsizei size, GLenum usage)
     //CUAssertLog(isBound(), "Vertex buffer is not bound");
     CUAssertLog(size <= _size, "Data exceeds maximum capacity: %d > %d",size,_size);
     glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _indxBuffer );
-    if (usage == GL_STATIC_DRAW) {
-        glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)*size, data, usage );
+    if (_streaming) {
+        GLsizeiptr base = streamData(GL_ELEMENT_ARRAY_BUFFER, _indxRing, data,
+                                     sizeof(GLuint)*size, sizeof(GLuint)*_size);
+        _indxBase = (GLsizei)(base/sizeof(GLuint));
     } else {
-        // Buffer orphaning
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)*_size, NULL, usage);
-        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(GLuint)*size, data);
+        _indxBase = 0;
+        if (usage == GL_STATIC_DRAW) {
+            glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)*size, data, usage );
+        } else {
+            // Buffer orphaning
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)*_size, NULL, usage);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(GLuint)*size, data);
+        }
     }
 
-    GLenum error = glGetError();
-    CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
+    CU_GL_CHECK("VertexBuffer");
 }
 
 /**
@@ -377,9 +440,8 @@ void VertexBuffer::draw(GLenum mode, GLsizei count, GLsizei offset) {
     // Assert causes problems on android emulator for now
     //CUAssertLog(isBound(), "Vertex buffer is not bound");
     if (count == 0) { return; }
-    glDrawElements(mode, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(GLuint)));
-    GLenum error = glGetError();
-    CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
+    glDrawElements(mode, count, GL_UNSIGNED_INT, (void*)((_indxBase+offset) * sizeof(GLuint)));
+    CU_GL_CHECK("VertexBuffer");
 }
 
 /**
@@ -410,8 +472,7 @@ void VertexBuffer::drawDirect(GLenum mode, GLint first, GLsizei count) {
     //CUAssertLog(isBound(), "Vertex buffer is not bound");
     if (count == 0) { return; }
     glDrawArrays(mode, first, count);
-    GLenum error = glGetError();
-    CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
+    CU_GL_CHECK("VertexBuffer");
 }
 
 #pragma mark -
@@ -460,17 +521,17 @@ void VertexBuffer::setupAttribute(const std::string name, GLint size, GLenum typ
     if (_shader != nullptr) {
         _shader->bind();
         GLint pos = glGetAttribLocation(_shader->getProgram(), name.c_str());
+        _locations[name] = pos;
         if (pos == -1) {
             CUWarn("Active shader has no attribute %s", name.c_str());
         } else {
             glEnableVertexAttribArray(pos);
             glVertexAttribPointer(pos,data.size,data.type,data.norm,_stride,
-                                  reinterpret_cast<GLvoid*>(data.offset));
+                                  reinterpret_cast<GLvoid*>(_vertBase+data.offset));
             glVertexAttribDivisor(pos,0);
         }
         
-        GLenum error = glGetError();
-        CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
+        CU_GL_CHECK("VertexBuffer");
     }
 }
 
@@ -517,3 +578,102 @@ void VertexBuffer::disableAttribute(const std::string name) {
 		}
 	}    
 }
+
+#pragma mark -
+#pragma mark Streaming Helpers
+/**
+ * Writes the given data to the next free position of the stream ring.
+ *
+ * The ring storage is allocated on first use. If the data does not fit
+ * in the current block, this method fences that block and moves on to
+ * the next one, waiting on its fence if the GPU is still using it. The
+ * data is then copied into mapped buffer memory (falling back to
+ * glBufferSubData if the buffer cannot be mapped).
+ *
+ * The buffer for the target must be bound.
+ *
+ * @param target    The buffer target (array or element array)
+ * @param ring      The ring for this buffer
+ * @param data      The data to write
+ * @param bytes     The number of bytes to write
+ * @param capacity  The size of a single ring block in bytes
+ *
+ * @return the byte offset of the data in the buffer
+ */
+GLsizeiptr VertexBuffer::streamData(GLenum target, StreamRing& ring, const void* data,
+                                    GLsizeiptr bytes, GLsizeiptr capacity) {
+    if (!ring.allocated) {
+        glBufferData(target, capacity*CU_VERTEX_STREAM_BLOCKS, NULL, GL_STREAM_DRAW);
+        ring.allocated = true;
+        ring.block = 0;
+        ring.head  = 0;
+    } else if (ring.head+bytes > capacity) {
+        // Fence the draws from this block and move on
+        ring.fences[ring.block] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ring.block = (ring.block+1) % CU_VERTEX_STREAM_BLOCKS;
+        ring.head  = 0;
+        
+        GLsync fence = ring.fences[ring.block];
+        if (fence) {
+            GLenum status = glClientWaitSync(fence, 0, 0);
+            while (status == GL_TIMEOUT_EXPIRED) {
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                          CU_VERTEX_STREAM_TIMEOUT);
+            }
+            glDeleteSync(fence);
+            ring.fences[ring.block] = 0;
+        }
+    }
+    
+    GLsizeiptr offset = ring.block*capacity+ring.head;
+    if (bytes > 0) {
+        GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        void* dst = glMapBufferRange(target, offset, bytes, access);
+        if (dst == NULL) {
+            glBufferSubData(target, offset, bytes, data);
+        } else {
+            std::memcpy(dst, data, bytes);
+            if (glUnmapBuffer(target) == GL_FALSE) {
+                // Mapped contents were lost (rare)
+                glBufferSubData(target, offset, bytes, data);
+            }
+        }
+    }
+    
+    // Keep every region 16 byte aligned
+    ring.head += (bytes+15) & ~((GLsizeiptr)15);
+    return offset;
+}
+
+/**
+ * Releases all fences in the given ring, marking it unallocated.
+ *
+ * @param ring  The ring to release
+ */
+void VertexBuffer::releaseRing(StreamRing& ring) {
+    for(int ii = 0; ii < CU_VERTEX_STREAM_BLOCKS; ii++) {
+        if (ring.fences[ii]) {
+            glDeleteSync(ring.fences[ii]);
+            ring.fences[ii] = 0;
+        }
+    }
+    ring.block = 0;
+    ring.head  = 0;
+    ring.allocated = false;
+}
+
+/**
+ * Repoints the enabled attributes at the active vertex data
+ *
+ * This method is necessary whenever the vertex data moves within the
+ * buffer (e.g. in a streaming buffer). The vertex buffer must be bound.
+ */
+void VertexBuffer::rebaseAttributes() {
+    for(auto it = _locations.begin(); it != _locations.end(); ++it) {
+        if (it->second != -1 && _enabled[it->first]) {
+            const AttribData& data = _attributes[it->first];
+            glVertexAttribPointer(it->second,data.size,data.type,data.norm,_stride,
+                                  reinterpret_cast<GLvoid*>(_vertBase+data.offset));
+        }
+    }
+}
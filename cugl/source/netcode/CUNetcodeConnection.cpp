@@ -72,6 +72,7 @@
 #include <algorithm>
 #include <random>
 #include <cstring>
+#include <thread>
 #include <SDL_app.h>
 
 using namespace cugl::netcode;
@@ -123,9 +124,13 @@ NetcodeConnection::NetcodeConnection() :
 	_ishost(false), 
 	_initialPlayers(0),
 	_migration(0),
-	_buffsize(0),
+	_bufflimit(0),
 	_buffhead(0),
 	_bufftail(0),
+	_buffusers(0),
+	_buffresize(false),
+	_sources(nullptr),
+	_immediate(false),
 	_debug(false),
 	_open(false),
 	_active(false),
@@ -137,6 +142,12 @@ NetcodeConnection::NetcodeConnection() :
  */
 NetcodeConnection::~NetcodeConnection() {
 	dispose();
+	Source* source = _sources.exchange(nullptr);
+	while (source != nullptr) {
+		Source* next = source->next;
+		delete source;
+		source = next;
+	}
 }
 
 /**
@@ -180,8 +191,17 @@ void NetcodeConnection::dispose() {
 			_host = "";
 			_room = "";
 			_ishost = false;
+
+			// Wait for any appending threads to leave the buffer
+			_buffresize = true;
+			while (_buffusers > 0) {
+				std::this_thread::yield();
+			}
+			_buffer = nullptr;
+			_buffhead = 0;
+			_bufftail = 0;
+			_buffresize = false;
 			
-			_buffer.clear();
 			_players.clear();
 			_rtcconfig.iceServers.clear();
 			
@@ -933,52 +953,165 @@ void NetcodeConnection::handleSignal(const std::shared_ptr<JsonValue>&  json) {
 	} 
 }
 
-/** 
+/**
+ * Returns the interned source for the given UUID.
+ *
+ * If the UUID has not been interned, this method interns it. This
+ * method does not require a lock.
+ *
+ * @param uuid  The source UUID
+ *
+ * @return the interned source for the given UUID.
+ */
+const NetcodeConnection::Source* NetcodeConnection::intern(const std::string& uuid) {
+	Source* head = _sources.load(std::memory_order_acquire);
+	for (Source* curr = head; curr != nullptr; curr = curr->next) {
+		if (curr->uuid == uuid) {
+			return curr;
+		}
+	}
+
+	// Only happens on the first message from a peer
+	Source* source = new Source(uuid);
+	source->next = head;
+	while (!_sources.compare_exchange_weak(source->next, source,
+										   std::memory_order_acq_rel)) {
+		// Another thread may have interned it in the meantime
+		for (Source* curr = source->next; curr != head; curr = curr->next) {
+			if (curr->uuid == uuid) {
+				delete source;
+				return curr;
+			}
+		}
+		head = source->next;
+	}
+	return source;
+}
+
+/**
+ * Acquires access to the data ring buffer.
+ *
+ * Access prevents the buffer from being resized by {@link #setCapacity}.
+ * It must be released with {@link #releaseBuffer}. This method only
+ * blocks if the buffer is being resized.
+ */
+void NetcodeConnection::acquireBuffer() {
+	while (true) {
+		_buffusers.fetch_add(1, std::memory_order_seq_cst);
+		if (!_buffresize.load(std::memory_order_seq_cst)) {
+			return;
+		}
+		_buffusers.fetch_sub(1, std::memory_order_release);
+		while (_buffresize.load(std::memory_order_acquire)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+/**
+ * Removes the oldest message from the ring buffer.
+ *
+ * If successful, the message is swapped into the given envelope. This
+ * method does not require a lock, but the caller must have acquired
+ * access with {@link #acquireBuffer}.
+ *
+ * @param envelope  The envelope to store the message
+ *
+ * @return true if a message was removed.
+ */
+bool NetcodeConnection::pop(Envelope& envelope) {
+	if (_buffer == nullptr || _bufflimit == 0) {
+		return false;
+	}
+	size_t pos = _buffhead.load(std::memory_order_relaxed);
+	while (true) {
+		Slot* slot = &(_buffer[pos % _bufflimit]);
+		size_t seq = slot->sequence.load(std::memory_order_acquire);
+		intptr_t diff = (intptr_t)seq-(intptr_t)(pos+1);
+		if (diff == 0) {
+			if (_buffhead.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) {
+				envelope.source = slot->envelope.source;
+				envelope.message.swap(slot->envelope.message);
+				slot->sequence.store(pos+_bufflimit, std::memory_order_release);
+				return true;
+			}
+		} else if (diff < 0) {
+			return false;
+		} else {
+			pos = _buffhead.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+/**
  * Appends the given data to the ring buffer.
  *
  * This method is used to store an incoming message for later consumption.
+ * It does not require a lock, and may be called by several threads at
+ * once. If the buffer is full, the oldest message is dropped.
  *
  * @param source    The message source
  * @param data      The message data
  *
  * @return if the message was successfully added to the buffer.
  */
-bool NetcodeConnection::append(const std::string source, const std::vector<std::byte>& data) {
- 	std::function<bool()> callback;
-	bool success = false;
-	
-	{
-		std::lock_guard<std::recursive_mutex> lock(_mutex);
-		if (_active) {
+bool NetcodeConnection::append(const std::string& source, const std::vector<std::byte>& data) {
+	if (!_active) {
+		return false;
+	}
+
+	if (_immediate) {
+		std::function<bool()> callback;
+		{
+			std::lock_guard<std::recursive_mutex> lock(_mutex);
 			if (_onReceipt) {
-				callback = [=,this]() {
-					_onReceipt(source,data);
+				Dispatcher dispatch = _onReceipt;
+				callback = [=]() {
+					dispatch(source,data);
 					return false;
 				};
-			} else {
-				// Buffer it
-				if (_buffsize == _buffer.size()) {
-					// Drops the oldest message
-					_buffhead = ((_buffhead + 1) % _buffer.size());
-					_buffsize--;
-				}
-		
-				Envelope* env = &(_buffer[_bufftail]);
-				env->source  = source;
-				env->message = data;
-
-				_bufftail = ((_bufftail + 1) % _buffer.size());
-				_buffsize++;
-			}		
-			success = true;
+			}
+		}
+		if (callback) {
+			Application::get()->schedule(callback);
+			return true;
 		}
 	}
-	
-	if (callback) {
-        Application::get()->schedule(callback);
+
+	const Source* interned = intern(source);
+	acquireBuffer();
+	if (_buffer == nullptr || _bufflimit == 0) {
+		releaseBuffer();
+		return false;
 	}
-	
-	return success;
+
+	Envelope dropped;
+	size_t pos = _bufftail.load(std::memory_order_relaxed);
+	while (true) {
+		Slot* slot = &(_buffer[pos % _bufflimit]);
+		size_t seq = slot->sequence.load(std::memory_order_acquire);
+		intptr_t diff = (intptr_t)seq-(intptr_t)pos;
+		if (diff == 0) {
+			if (_bufftail.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) {
+				// Reuses the capacity of the pooled byte vector
+				slot->envelope.source = interned;
+				slot->envelope.message.assign(data.begin(), data.end());
+				slot->sequence.store(pos+1, std::memory_order_release);
+				break;
+			}
+		} else if (diff < 0) {
+			// Full. Drops the oldest message
+			if (!pop(dropped)) {
+				// The oldest message is still being read
+				std::this_thread::yield();
+			}
+			pos = _bufftail.load(std::memory_order_relaxed);
+		} else {
+			pos = _bufftail.load(std::memory_order_relaxed);
+		}
+	}
+	releaseBuffer();
+	return true;
 }
 
 #pragma mark -
@@ -1040,7 +1173,7 @@ const std::string NetcodeConnection::getHost() {
  */
 size_t NetcodeConnection::getCapacity() {
 	std::lock_guard<std::recursive_mutex> lock(_mutex);
-	return _buffer.size();
+	return _bufflimit;
 }
 
 /**
@@ -1054,24 +1187,46 @@ size_t NetcodeConnection::getCapacity() {
  * Note that this is NOT the same as the capacity of a single message. That
  * value was set as part of the initial {@link NetcodeConfig}.
  *
+ * Resizing an open connection briefly blocks any threads appending to
+ * the buffer. If the new capacity is smaller than the number of messages
+ * in the buffer, the oldest messages are dropped.
+ *
  * @param capacity  The new message buffer capacity.
  */
 void NetcodeConnection::setCapacity(size_t capacity) {
 	std::lock_guard<std::recursive_mutex> lock(_mutex);
-	
+	if (_buffer == nullptr) {
+		_bufflimit = capacity;
+		return;
+	}
+
+	// Wait for all other users to leave the buffer
+	_buffresize.store(true, std::memory_order_seq_cst);
+	while (_buffusers.load(std::memory_order_seq_cst) > 0) {
+		std::this_thread::yield();
+	}
+
 	// Rotate to correct position
-	size_t pos = _buffhead;
-	if (capacity < _buffsize) {
-		pos = ((_buffhead + (_buffsize-capacity)) % _buffer.size());
-		_buffsize = capacity;
+	std::vector<Envelope> messages;
+	Envelope envelope;
+	while (pop(envelope)) {
+		messages.push_back(std::move(envelope));
+	}
+	size_t first = messages.size() > capacity ? messages.size()-capacity : 0;
+
+	_buffer = std::make_unique<Slot[]>(capacity);
+	for (size_t ii = 0; ii < capacity; ii++) {
+		_buffer[ii].sequence.store(ii, std::memory_order_relaxed);
 	}
-	if (pos != 0) {
-		std::rotate(_buffer.begin(), _buffer.begin() + pos, _buffer.end());
+	for (size_t ii = first; ii < messages.size(); ii++) {
+		Slot* slot = &(_buffer[ii-first]);
+		slot->envelope = std::move(messages[ii]);
+		slot->sequence.store(ii-first+1, std::memory_order_relaxed);
 	}
-	_buffhead = 0;
-	_bufftail = ((_bufftail + (_buffer.size()-pos)) % _buffer.size());
-	_buffer.resize(capacity);
-    _bufflimit = capacity;
+	_bufflimit = capacity;
+	_buffhead.store(0, std::memory_order_relaxed);
+	_bufftail.store(messages.size()-first, std::memory_order_relaxed);
+	_buffresize.store(false, std::memory_order_seq_cst);
 }
     
 /**
@@ -1194,7 +1349,12 @@ void NetcodeConnection::open() {
 	_socket->onClosed([this]() { onClosed(); });
 	_socket->onMessage([this](auto data) { onMessage(data); });
 	
-	_buffer.resize(_bufflimit);
+	if (_buffer == nullptr) {
+		_buffer = std::make_unique<Slot[]>(_bufflimit);
+		for (size_t ii = 0; ii < _bufflimit; ii++) {
+			_buffer[ii].sequence.store(ii, std::memory_order_relaxed);
+		}
+	}
 	
 	// Start the connection
 	_active = true;
@@ -1446,36 +1606,35 @@ bool NetcodeConnection::broadcast(const std::vector<std::byte>& data) {
  * @param dispatcher    The function to process received data
  */
 void NetcodeConnection::receive(const Dispatcher& dispatcher) {
-    if (dispatcher == nullptr || !_open || _buffsize == 0) {
+    if (dispatcher == nullptr || !_open ||
+        _buffhead.load(std::memory_order_relaxed) == _bufftail.load(std::memory_order_relaxed)) {
         return;
     }
     
-    // Sigh. Dispatch is also a callback. Cannot hold a lock when we use.
+    // Dispatch is also a callback (which may reenter), so drain first
     std::vector<Envelope> messages;
-    messages.reserve(_buffsize);
-    {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
-        size_t limit = _buffsize;
-        if (_buffer.empty()) {
-            return;
-        }
-        
-        size_t off = 0;
-        for (auto it = _buffer.begin()+_buffhead; it != _buffer.end() && off < limit; off++, ++it) {
-            messages.emplace_back(std::move(*it));
-        }
-        // Wrap around ring buffer
-        for (auto it = _buffer.begin(); it != _buffer.end() && off < limit; off++, ++it) {
-            messages.emplace_back(std::move(*it));
-        }
-        
-        _buffhead = ((_buffhead + off) % _buffer.size());
-        _buffsize -= off;
+    messages.swap(_drain);
+    size_t count = 0;
+    acquireBuffer();
+    // Only drain what is here now, so a burst cannot stall this thread
+    size_t head  = _buffhead.load(std::memory_order_acquire);
+    size_t limit = std::min(_bufftail.load(std::memory_order_acquire)-head, _bufflimit);
+    if (messages.size() < limit) {
+        messages.resize(limit);
+    }
+    while (count < limit && pop(messages[count])) {
+        count++;
+    }
+    releaseBuffer();
+
+    // Now we can consume messages
+    for(size_t ii = 0; ii < count; ii++) {
+        dispatcher(messages[ii].source->uuid,messages[ii].message);
     }
     
-    // Now with lock released we can consume messages
-    for(auto it = messages.begin(); it != messages.end(); ++it) {
-        dispatcher(it->source,it->message);
+    // Keep the byte vectors for the next drain
+    if (_drain.empty()) {
+        _drain.swap(messages);
     }
 }
 
@@ -1542,6 +1701,7 @@ void NetcodeConnection::endSession() {
 void NetcodeConnection::onReceipt(Dispatcher callback) {
     std::lock_guard<std::recursive_mutex> lock(_mutex);
     _onReceipt = callback;
+    _immediate = (callback != nullptr);
 }
 
 /**
@@ -49,11 +49,140 @@
 #include <cugl/core/util/CUHashtools.h>
 
 #include <stdexcept>
-#include <sstream>
+#include <cstring>
 
 using namespace cugl;
 using namespace cugl::netcode;
 
+/** The number of bytes in a vector header (type, length type, length) */
+#define VECTOR_HEADER   (2+sizeof(Uint64))
+
+#pragma mark -
+#pragma mark Encoding Helpers
+/**
+ * Stores the value at the given position, encoded in network order
+ *
+ * @param dst   The position to write
+ * @param value The value to write
+ */
+template <typename T>
+static inline void put_value(std::byte* dst, T value) {
+    value = marshall(value);
+    std::memcpy(dst, &value, sizeof(T));
+}
+
+/**
+ * Returns the value at the given position, decoded from network order
+ *
+ * @param src   The position to read
+ *
+ * @return the value at the given position
+ */
+template <typename T>
+static inline T get_value(const std::byte* src) {
+    // Memcopy necessary for possible alignment issues
+    T value;
+    std::memcpy(&value, src, sizeof(T));
+    return marshall(value);
+}
+
+/**
+ * Returns a pointer to the given number of new bytes at the end of data
+ *
+ * The vector grows geometrically, so repeated calls are amortized constant
+ * time. The new bytes must all be written by the caller.
+ *
+ * @param data  The byte vector to extend
+ * @param bytes The number of bytes to add
+ *
+ * @return a pointer to the given number of new bytes at the end of data
+ */
+static inline std::byte* extend(std::vector<std::byte>& data, size_t bytes) {
+    size_t size = data.size();
+    data.resize(size+bytes);
+    return data.data()+size;
+}
+
+/**
+ * Writes a single typed value to the end of data
+ *
+ * @param data  The byte vector to extend
+ * @param type  The value type
+ * @param value The value to write
+ */
+template <typename T>
+static inline void write_value(std::vector<std::byte>& data, NetcodeType type, T value) {
+    std::byte* dst = extend(data, 1+sizeof(T));
+    dst[0] = static_cast<std::byte>(type);
+    put_value(dst+1, value);
+}
+
+/**
+ * Writes the header of a vector to the given position
+ *
+ * @param dst   The position to write
+ * @param type  The element type
+ * @param size  The number of elements
+ */
+static inline void put_header(std::byte* dst, NetcodeType type, size_t size) {
+    dst[0] = static_cast<std::byte>(ArrayType + type);
+    dst[1] = static_cast<std::byte>(UInt64Type);
+    put_value(dst+2, (Uint64)size);
+}
+
+/**
+ * Writes a vector of typed values to the end of data
+ *
+ * The space for the entire vector is allocated at once, so that there is
+ * at most one allocation for the vector.
+ *
+ * @param data      The byte vector to extend
+ * @param type      The element type
+ * @param values    The values to write
+ */
+template <typename T>
+static void write_array(std::vector<std::byte>& data, NetcodeType type, std::span<const T> values) {
+    const size_t stride = 1+sizeof(T);
+    std::byte* dst = extend(data, VECTOR_HEADER+stride*values.size());
+    put_header(dst, type, values.size());
+    dst += VECTOR_HEADER;
+    for(auto it = values.begin(); it != values.end(); ++it) {
+        dst[0] = static_cast<std::byte>(type);
+        put_value(dst+1, *it);
+        dst += stride;
+    }
+}
+
+/**
+ * Reads a vector of typed values from data
+ *
+ * The vector header must already have been read, and the data must have
+ * enough bytes for every element. At most capacity values are stored in
+ * the buffer. The remaining values are skipped.
+ *
+ * @param data      The serialized data
+ * @param pos       The read position (updated by this function)
+ * @param type      The element type
+ * @param buffer    The buffer to store the values
+ * @param capacity  The capacity of the buffer
+ * @param size      The number of elements in the vector
+ */
+template <typename T>
+static void read_array(const std::byte* data, size_t& pos, NetcodeType type,
+                       T* buffer, size_t capacity, size_t size) {
+    const size_t stride = 1+sizeof(T);
+    const std::byte* src = data+pos;
+    size_t amt = size < capacity ? size : capacity;
+    for(size_t ii = 0; ii < amt; ii++) {
+        if (static_cast<uint8_t>(src[0]) != type) {
+            throw std::domain_error("Illegal state of array; did you pass in a valid message?");
+        }
+        buffer[ii] = get_value<T>(src+1);
+        src += stride;
+    }
+    pos += stride*size;
+}
+
 #pragma mark -
 #pragma mark NetcodeSerializer
 /**
@@ -79,12 +208,7 @@ void NetcodeSerializer::writeBool(bool b) {
  * @param f The value to write
  */
 void NetcodeSerializer::writeFloat(float f) {
-    float ii = marshall(f);
-    const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-    _data.push_back(static_cast<std::byte>(FloatType));
-    for (size_t j = 0; j < sizeof(float); j++) {
-        _data.push_back(bytes[j]);
-    }
+    write_value(_data, FloatType, f);
 }
 
 /**
@@ -97,12 +221,7 @@ void NetcodeSerializer::writeFloat(float f) {
  * @param d The value to write
  */
 void NetcodeSerializer::writeDouble(double d) {
-    double ii = marshall(d);
-    const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-    _data.push_back(static_cast<std::byte>(DoubleType));
-    for (size_t j = 0; j < sizeof(double); j++) {
-        _data.push_back(bytes[j]);
-    }
+    write_value(_data, DoubleType, d);
 }
 
 /**
@@ -115,12 +234,7 @@ void NetcodeSerializer::writeDouble(double d) {
  * @param i The value to write
  */
 void NetcodeSerializer::writeUint32(Uint32 i) {
-    Uint32 ii = marshall(i);
-    const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-    _data.push_back(static_cast<std::byte>(UInt32Type));
-    for (size_t j = 0; j < sizeof(Uint32); j++) {
-        _data.push_back(bytes[j]);
-    }
+    write_value(_data, UInt32Type, i);
 }
 
 /**
@@ -133,12 +247,7 @@ void NetcodeSerializer::writeUint32(Uint32 i) {
  * @param i The value to write
  */
 void NetcodeSerializer::writeUint64(Uint64 i) {
-    Uint64 ii = marshall(i);
-    const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-    _data.push_back(static_cast<std::byte>(UInt64Type));
-    for (size_t j = 0; j < sizeof(Uint64); j++) {
-        _data.push_back(bytes[j]);
-    }
+    write_value(_data, UInt64Type, i);
 }
 
 /**
@@ -151,12 +260,7 @@ void NetcodeSerializer::writeUint64(Uint64 i) {
  * @param i The value to write
  */
 void NetcodeSerializer::writeSint32(Sint32 i) {
-    Sint32 ii = marshall(i);
-    const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-    _data.push_back(static_cast<std::byte>(SInt32Type));
-    for (size_t j = 0; j < sizeof(Sint32); j++) {
-        _data.push_back(bytes[j]);
-    }
+    write_value(_data, SInt32Type, i);
 }
 
 /**
@@ -169,12 +273,7 @@ void NetcodeSerializer::writeSint32(Sint32 i) {
  * @param i The value to write
  */
 void NetcodeSerializer::writeSint64(Sint64 i) {
-    Sint64 ii = marshall(i);
-    const std::byte* bytes = reinterpret_cast<const std::byte*>(&ii);
-    _data.push_back(static_cast<std::byte>(SInt64Type));
-    for (size_t j = 0; j < sizeof(Sint64); j++) {
-        _data.push_back(bytes[j]);
-    }
+    write_value(_data, SInt64Type, i);
 }
 
 /**
@@ -186,11 +285,13 @@ void NetcodeSerializer::writeSint64(Sint64 i) {
  *
  * @param s The value to write
  */
-void NetcodeSerializer::writeString(std::string s) {
-    _data.push_back(static_cast<std::byte>(StringType));
-    writeUint64((Uint64)(s.size()));
-    for (char& c : s) {
-        _data.push_back(static_cast<std::byte>(c));
+void NetcodeSerializer::writeString(std::string_view s) {
+    std::byte* dst = extend(_data, VECTOR_HEADER+s.size());
+    dst[0] = static_cast<std::byte>(StringType);
+    dst[1] = static_cast<std::byte>(UInt64Type);
+    put_value(dst+2, (Uint64)s.size());
+    if (!s.empty()) {
+        std::memcpy(dst+VECTOR_HEADER, s.data(), s.size());
     }
 }
 /**
@@ -205,8 +306,8 @@ void NetcodeSerializer::writeString(std::string s) {
  *
  * @param s The value to write
  */
-void NetcodeSerializer::writeChars(char* s) {
-    writeString(std::string(s));
+void NetcodeSerializer::writeChars(const char* s) {
+    writeString(std::string_view(s));
 }
 
 /**
@@ -261,11 +362,12 @@ void NetcodeSerializer::writeJson(const std::shared_ptr<JsonValue>& j) {
  *
  * @param v The vector to write
  */
-void NetcodeSerializer::writeBoolVector(std::vector<bool> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + BooleanTrue));
-    writeUint64((Uint64)(v.size()));
+void NetcodeSerializer::writeBoolVector(const std::vector<bool>& v) {
+    std::byte* dst = extend(_data, VECTOR_HEADER+v.size());
+    put_header(dst, BooleanTrue, v.size());
+    dst += VECTOR_HEADER;
     for (size_t i = 0; i < v.size(); i++) {
-        writeBool(v[i]);
+        dst[i] = static_cast<std::byte>(v[i] ? BooleanTrue : BooleanFalse);
     }
 }
 
@@ -276,14 +378,13 @@ void NetcodeSerializer::writeBoolVector(std::vector<bool> v) {
  * written in. You should pass the result of {@link #serialize} to the
  * {@link NetcodeConnection} to send all values buffered up to this point.
  *
- * @param v The vector to write
+ * The values may come from any contiguous storage, such as an array. They
+ * will be deserialized as a vector.
+ *
+ * @param v The values to write
  */
-void NetcodeSerializer::writeFloatVector(std::vector<float> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + FloatType));
-    writeUint64((Uint64)(v.size()));
-    for (size_t i = 0; i < v.size(); i++) {
-        writeFloat(v[i]);
-    }
+void NetcodeSerializer::writeFloatVector(std::span<const float> v) {
+    write_array(_data, FloatType, v);
 }
 
 /**
@@ -293,14 +394,13 @@ void NetcodeSerializer::writeFloatVector(std::vector<float> v) {
  * written in. You should pass the result of {@link #serialize} to the
  * {@link NetcodeConnection} to send all values buffered up to this point.
  *
- * @param v The vector to write
+ * The values may come from any contiguous storage, such as an array. They
+ * will be deserialized as a vector.
+ *
+ * @param v The values to write
  */
-void NetcodeSerializer::writeDoubleVector(std::vector<double> v) {
-    _data.push_back((std::byte)(ArrayType + DoubleType));
-    writeUint64((Uint64)(v.size()));
-    for (size_t i = 0; i < v.size(); i++) {
-        writeDouble(v[i]);
-    }
+void NetcodeSerializer::writeDoubleVector(std::span<const double> v) {
+    write_array(_data, DoubleType, v);
 }
 
 /**
@@ -310,14 +410,13 @@ void NetcodeSerializer::writeDoubleVector(std::vector<double> v) {
  * written in. You should pass the result of {@link #serialize} to the
  * {@link NetcodeConnection} to send all values buffered up to this point.
  *
- * @param v The vector to write
+ * The values may come from any contiguous storage, such as an array. They
+ * will be deserialized as a vector.
+ *
+ * @param v The values to write
  */
-void NetcodeSerializer::writeUint32Vector(std::vector<Uint32> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + UInt32Type));
-    writeUint64((Uint64)(v.size()));
-    for (size_t i = 0; i < v.size(); i++) {
-            writeUint32(v[i]);
-    }
+void NetcodeSerializer::writeUint32Vector(std::span<const Uint32> v) {
+    write_array(_data, UInt32Type, v);
 }
 
 /**
@@ -327,14 +426,13 @@ void NetcodeSerializer::writeUint32Vector(std::vector<Uint32> v) {
  * written in. You should pass the result of {@link #serialize} to the
  * {@link NetcodeConnection} to send all values buffered up to this point.
  *
- * @param v The vector to write
+ * The values may come from any contiguous storage, such as an array. They
+ * will be deserialized as a vector.
+ *
+ * @param v The values to write
  */
-void NetcodeSerializer::writeUint64Vector(std::vector<Uint64> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + UInt64Type));
-    writeUint64((Uint64)(v.size()));
-    for (size_t i = 0; i < v.size(); i++) {
-            writeUint64(v[i]);
-    }
+void NetcodeSerializer::writeUint64Vector(std::span<const Uint64> v) {
+    write_array(_data, UInt64Type, v);
 }
 
 /**
@@ -344,13 +442,12 @@ void NetcodeSerializer::writeUint64Vector(std::vector<Uint64> v) {
  * written in. You should pass the result of {@link #serialize} to the
  * {@link NetcodeConnection} to send all values buffered up to this point.
  *
- * @param v The vector to write
- */void NetcodeSerializer::writeSint32Vector(std::vector<Sint32> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + SInt32Type));
-    writeUint64((Uint64)(v.size()));
-    for (size_t i = 0; i < v.size(); i++) {
-        writeSint32(v[i]);
-    }
+ * The values may come from any contiguous storage, such as an array. They
+ * will be deserialized as a vector.
+ *
+ * @param v The values to write
+ */void NetcodeSerializer::writeSint32Vector(std::span<const Sint32> v) {
+    write_array(_data, SInt32Type, v);
 }
 
 /**
@@ -360,14 +457,13 @@ void NetcodeSerializer::writeUint64Vector(std::vector<Uint64> v) {
  * written in. You should pass the result of {@link #serialize} to the
  * {@link NetcodeConnection} to send all values buffered up to this point.
  *
- * @param v The vector to write
+ * The values may come from any contiguous storage, such as an array. They
+ * will be deserialized as a vector.
+ *
+ * @param v The values to write
  */
-void NetcodeSerializer::writeSint64Vector(std::vector<Sint64> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + SInt64Type));
-    writeUint64((Uint64)(v.size()));
-    for (size_t i = 0; i < v.size(); i++) {
-        writeSint64(v[i]);
-    }
+void NetcodeSerializer::writeSint64Vector(std::span<const Sint64> v) {
+    write_array(_data, SInt64Type, v);
 }
 
 /**
@@ -377,13 +473,15 @@ void NetcodeSerializer::writeSint64Vector(std::vector<Sint64> v) {
  * written in. You should pass the result of {@link #serialize} to the
  * {@link NetcodeConnection} to send all values buffered up to this point.
  *
- * @param v The vector to write
+ * The values may come from any contiguous storage, such as an array. They
+ * will be deserialized as a vector.
+ *
+ * @param v The values to write
  */
-void NetcodeSerializer::writeStringVector(std::vector<std::string> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + StringType));
-    writeUint64((Uint64)(v.size()));
-    for (size_t i = 0; i < v.size(); i++) {
-        writeString(v[i]);
+void NetcodeSerializer::writeStringVector(std::span<const std::string> v) {
+    put_header(extend(_data, VECTOR_HEADER), StringType, v.size());
+    for (auto it = v.begin(); it != v.end(); ++it) {
+        writeString(*it);
     }
 }
 
@@ -399,9 +497,8 @@ void NetcodeSerializer::writeStringVector(std::vector<std::string> v) {
  *
  * @param v The vector to write
  */
-void NetcodeSerializer::writeCharsVector(std::vector<char*> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + StringType));
-    writeUint64((Uint64)(v.size()));
+void NetcodeSerializer::writeCharsVector(const std::vector<char*>& v) {
+    put_header(extend(_data, VECTOR_HEADER), StringType, v.size());
     for (size_t i = 0; i < v.size(); i++) {
         writeChars(v[i]);
     }
@@ -416,9 +513,8 @@ void NetcodeSerializer::writeCharsVector(std::vector<char*> v) {
  *
  * @param v The vector to write
  */
-void NetcodeSerializer::writeJsonVector(std::vector<std::shared_ptr<JsonValue>> v) {
-    _data.push_back(static_cast<std::byte>(ArrayType + JsonType));
-    writeUint64((Uint64)(v.size()));
+void NetcodeSerializer::writeJsonVector(const std::vector<std::shared_ptr<JsonValue>>& v) {
+    put_header(extend(_data, VECTOR_HEADER), JsonType, v.size());
     for (size_t i = 0; i < v.size(); i++) {
         writeJson(v[i]);
     }
@@ -470,6 +566,9 @@ const std::string NetcodeSerializer::serialize64() {
 
 /**
  * Clears the input buffer.
+ *
+ * The buffer memory is retained, so that the serializer can be reused
+ * without allocating memory for each message.
  */
 void NetcodeSerializer::reset() {
 	_data.clear();
@@ -497,8 +596,47 @@ void NetcodeSerializer::reset() {
  * @param msg The byte vector serialized by {@link NetcodeSerializer}
  */
 void NetcodeDeserializer::receive(const std::vector<std::byte>& msg) {
-	_data = msg;
-	_pos = 0;
+    _buffer = msg;
+    _data = _buffer.data();
+    _size = _buffer.size();
+    _pos = 0;
+}
+
+/**
+ * Loads a new message to be read, taking ownership of it.
+ *
+ * This method is identical to {@link #receive(const std::vector<std::byte>&)}
+ * except that the message is moved into this deserializer instead of
+ * copied.
+ *
+ * @param msg The byte vector serialized by {@link NetcodeSerializer}
+ */
+void NetcodeDeserializer::receive(std::vector<std::byte>&& msg) {
+    _buffer = std::move(msg);
+    _data = _buffer.data();
+    _size = _buffer.size();
+    _pos = 0;
+}
+
+/**
+ * Loads a new message to be read in place.
+ *
+ * This deserializer does NOT copy the message. The data must remain valid
+ * (and unchanged) until the message is read completely, or until another
+ * message is loaded. In return, loading a message requires no allocation.
+ *
+ * Calling this method will discard any previously loaded messages. The
+ * message must be serialized by {@link NetcodeSerializer}. Otherwise,
+ * the results are unspecified.
+ *
+ * @param data  The message serialized by {@link NetcodeSerializer}
+ * @param size  The number of bytes in the message
+ */
+void NetcodeDeserializer::receive(const std::byte* data, size_t size) {
+    _buffer.clear();
+    _data = data;
+    _size = size;
+    _pos = 0;
 }
 
 /**
@@ -522,7 +660,9 @@ void NetcodeDeserializer::receive(const std::vector<std::byte>& msg) {
  * @param msg The byte vector serialized by {@link NetcodeSerializer}
  */
 void NetcodeDeserializer::receive64(const std::string msg) {
-    _data = hashtool::b64_decode(msg);
+    _buffer = hashtool::b64_decode(msg);
+    _data = _buffer.data();
+    _size = _buffer.size();
     _pos = 0;
 }
 
@@ -543,7 +683,7 @@ void NetcodeDeserializer::receive64(const std::string msg) {
  * the other read methods).
  */
 NetcodeDeserializer::Message NetcodeDeserializer::read() {
-	if (_pos >= _data.size()) {
+	if (_pos >= _size) {
 		return {};
 	}
 
@@ -606,7 +746,7 @@ NetcodeDeserializer::Message NetcodeDeserializer::read() {
  * @return the type of the next data value to be read.
  */
 NetcodeType NetcodeDeserializer::nextType() const {
-    if (_pos >= _data.size()) {
+    if (_pos >= _size) {
         return InvalidType;
     }
     
@@ -651,7 +791,7 @@ NetcodeType NetcodeDeserializer::nextType() const {
  * @return a single boolean value.
  */
 bool NetcodeDeserializer::readBool() {
-    if (_pos >= _data.size()) {
+    if (_pos >= _size) {
         return false;
     }
     uint8_t value = static_cast<uint8_t>(_data[_pos++]);
@@ -670,16 +810,13 @@ bool NetcodeDeserializer::readBool() {
  * @return a single float value.
  */
 float NetcodeDeserializer::readFloat() {
-    if (_pos >= _data.size()) {
+    if (_pos+1+sizeof(float) > _size) {
+        _pos = _size;
         return 0.0f;
     }
-    _pos++;
-    
-    // Memcopy necessary for possible alignment issues
-    float value;
-    std::memcpy(&value, _data.data() + _pos, sizeof(float));
-    _pos += sizeof(float);
-    return marshall(value);
+    float value = get_value<float>(_data+_pos+1);
+    _pos += 1+sizeof(float);
+    return value;
 }
 
 /**
@@ -694,16 +831,13 @@ float NetcodeDeserializer::readFloat() {
  * @return a single double value.
  */
 double NetcodeDeserializer::readDouble() {
-    if (_pos >= _data.size()) {
+    if (_pos+1+sizeof(double) > _size) {
+        _pos = _size;
         return 0.0;
     }
-    _pos++;
-    
-    // Memcopy necessary for possible alignment issues
-    double value;
-    std::memcpy(&value, _data.data() + _pos, sizeof(double));
-    _pos += sizeof(double);
-    return marshall(value);
+    double value = get_value<double>(_data+_pos+1);
+    _pos += 1+sizeof(double);
+    return value;
 }
 
 /**
@@ -718,16 +852,13 @@ double NetcodeDeserializer::readDouble() {
  * @return a single unsigned (32 bit) int value.
  */
 Uint32 NetcodeDeserializer::readUint32() {
-    if (_pos >= _data.size()) {
+    if (_pos+1+sizeof(Uint32) > _size) {
+        _pos = _size;
         return 0;
     }
-    _pos++;
-    
-    // Memcopy necessary for possible alignment issues
-    Uint32 value;
-    std::memcpy(&value, _data.data() + _pos, sizeof(Uint32));
-    _pos += sizeof(Uint32);
-    return marshall(value);
+    Uint32 value = get_value<Uint32>(_data+_pos+1);
+    _pos += 1+sizeof(Uint32);
+    return value;
 }
 
 /**
@@ -742,16 +873,13 @@ Uint32 NetcodeDeserializer::readUint32() {
  * @return a single signed (32 bit) int value.
  */
 Sint32 NetcodeDeserializer::readSint32() {
-    if (_pos >= _data.size()) {
+    if (_pos+1+sizeof(Sint32) > _size) {
+        _pos = _size;
         return 0;
     }
-    _pos++;
-    
-    // Memcopy necessary for possible alignment issues
-    Sint32 value;
-    std::memcpy(&value, _data.data() + _pos, sizeof(Sint32));
-    _pos += sizeof(Sint32);
-    return marshall(value);
+    Sint32 value = get_value<Sint32>(_data+_pos+1);
+    _pos += 1+sizeof(Sint32);
+    return value;
 }
 
 /**
@@ -765,16 +893,13 @@ Sint32 NetcodeDeserializer::readSint32() {
  *
  * @return a single unsigned (64 bit) int value.
  */Uint64 NetcodeDeserializer::readUint64() {
-    if (_pos >= _data.size()) {
+    if (_pos+1+sizeof(Uint64) > _size) {
+        _pos = _size;
         return 0;
     }
-    _pos++;
-    
-    // Memcopy necessary for possible alignment issues
-    Uint64 value;
-    std::memcpy(&value, _data.data() + _pos, sizeof(Uint64));
-    _pos += sizeof(Uint64);
-    return marshall(value);
+    Uint64 value = get_value<Uint64>(_data+_pos+1);
+    _pos += 1+sizeof(Uint64);
+    return value;
 }
 
 /**
@@ -789,16 +914,13 @@ Sint32 NetcodeDeserializer::readSint32() {
  * @return a single signed (64 bit) int value.
  */
 Sint64 NetcodeDeserializer::readSint64() {
-    if (_pos >= _data.size()) {
+    if (_pos+1+sizeof(Sint64) > _size) {
+        _pos = _size;
         return 0;
     }
-    _pos++;
-    
-    // Memcopy necessary for possible alignment issues
-    Sint64 value;
-    std::memcpy(&value, _data.data() + _pos, sizeof(Sint64));
-    _pos += sizeof(Sint64);
-    return marshall(value);
+    Sint64 value = get_value<Sint64>(_data+_pos+1);
+    _pos += 1+sizeof(Sint64);
+    return value;
 }
 
 /**
@@ -813,16 +935,38 @@ Sint64 NetcodeDeserializer::readSint64() {
  * @return a single string.
  */
 std::string NetcodeDeserializer::readString() {
-    if (_pos >= _data.size()) {
-        return std::string();
+    std::string_view view = readStringView();
+    return std::string(view.data(),view.size());
+}
+
+/**
+ * Returns a single string as a view into the loaded message.
+ *
+ * This method is only defined if {@link #nextType} has returned StringType.
+ * Otherwise, calling this method will potentially corrupt the stream.
+ *
+ * Unlike {@link #readString}, this method does not copy the string. The
+ * view is only valid as long as the loaded message. If the message was
+ * read in place (see {@link #receive(const std::byte*,size_t)}), that is
+ * the lifetime of the original buffer.
+ *
+ * The method advances the read position. If called when no more data is
+ * available, this method will return the empty string.
+ *
+ * @return a single string as a view into the loaded message.
+ */
+std::string_view NetcodeDeserializer::readStringView() {
+    if (_pos >= _size) {
+        return std::string_view();
     }
     _pos++;
-    Uint64 size = std::get<Uint64>(read());
-    std::ostringstream disp;
-    for (size_t i = 0; i < size; i++, _pos++) {
-        disp << static_cast<char>(_data[_pos]);
+    Uint64 size = readUint64();
+    if (size > _size-_pos) {
+        throw std::domain_error("Illegal string; did you pass in a valid message?");
     }
-    return disp.str();
+    const char* start = reinterpret_cast<const char*>(_data+_pos);
+    _pos += size;
+    return std::string_view(start,size);
 }
 
 /**
@@ -837,7 +981,7 @@ std::string NetcodeDeserializer::readString() {
  * @return a single {@link JsonValue} object.
  */
 std::shared_ptr<JsonValue> NetcodeDeserializer::readJson() {
-    if (_pos >= _data.size()) {
+    if (_pos >= _size) {
         return nullptr;
     }
     _pos++;
@@ -892,12 +1036,19 @@ std::shared_ptr<JsonValue> NetcodeDeserializer::readJson() {
  *
  * @return a vector of boolean values.
  */
-std::vector<bool> NetcodeDeserializer::readBoolVector()  {
-    _pos++;
-    Uint64 size = std::get<Uint64>(read());
+std::vector<bool> NetcodeDeserializer::readBoolVector() {
     std::vector<bool> vv;
+    if (_pos >= _size) {
+        return vv;
+    }
+    size_t size = readVectorSize(1);
+    vv.resize(size);
     for (size_t i = 0; i < size; i++) {
-        vv.push_back(std::get<bool>(read()));
+        uint8_t value = static_cast<uint8_t>(_data[_pos++]);
+        if (value != BooleanTrue && value != BooleanFalse) {
+            throw std::domain_error("Illegal state of array; did you pass in a valid message?");
+        }
+        vv[i] = (value == BooleanTrue);
     }
     return vv;
 }
@@ -916,17 +1067,40 @@ std::vector<bool> NetcodeDeserializer::readBoolVector()  {
  */
 std::vector<float> NetcodeDeserializer::readFloatVector() {
     std::vector<float> vv;
-    if (_pos >= _data.size()) {
+    if (_pos >= _size) {
         return vv;
     }
-    _pos++;
-    Uint64 size = std::get<Uint64>(read());
-    for (size_t i = 0; i < size; i++) {
-        vv.push_back(std::get<float>(read()));
-    }
+    vv.resize(readVectorSize(1+sizeof(float)));
+    read_array(_data, _pos, FloatType, vv.data(), vv.size(), vv.size());
     return vv;
 }
 
+/**
+ * Reads a vector of float values into the given buffer.
+ *
+ * This method is only defined if {@link #nextType} has returned
+ * (ArrayType+FloatType). Otherwise, calling this method will potentially
+ * corrupt the stream.
+ *
+ * This method stores as many values as fit in the buffer, skipping the
+ * rest. It returns the length of the serialized vector, so a result
+ * larger than the buffer indicates that values were skipped. Either way,
+ * the read position is advanced past the entire vector. This method does
+ * not allocate any memory.
+ *
+ * @param buffer    The buffer to store the values
+ *
+ * @return the number of values in the serialized vector
+ */
+size_t NetcodeDeserializer::readFloatVector(std::span<float> buffer) {
+    if (_pos >= _size) {
+        return 0;
+    }
+    size_t size = readVectorSize(1+sizeof(float));
+    read_array(_data, _pos, FloatType, buffer.data(), buffer.size(), size);
+    return size;
+}
+
 /**
  * Returns a vector of double values.
  *
@@ -939,19 +1113,42 @@ std::vector<float> NetcodeDeserializer::readFloatVector() {
  *
  * @return a vector of double values.
  */
-std::vector<double> NetcodeDeserializer::readDoubleVector()     {
+std::vector<double> NetcodeDeserializer::readDoubleVector() {
     std::vector<double> vv;
-    if (_pos >= _data.size()) {
+    if (_pos >= _size) {
         return vv;
     }
-    _pos++;
-    Uint64 size = std::get<Uint64>(read());
-    for (size_t i = 0; i < size; i++) {
-        vv.push_back(std::get<double>(read()));
-    }
+    vv.resize(readVectorSize(1+sizeof(double)));
+    read_array(_data, _pos, DoubleType, vv.data(), vv.size(), vv.size());
     return vv;
 }
 
+/**
+ * Reads a vector of double values into the given buffer.
+ *
+ * This method is only defined if {@link #nextType} has returned
+ * (ArrayType+DoubleType). Otherwise, calling this method will potentially
+ * corrupt the stream.
+ *
+ * This method stores as many values as fit in the buffer, skipping the
+ * rest. It returns the length of the serialized vector, so a result
+ * larger than the buffer indicates that values were skipped. Either way,
+ * the read position is advanced past the entire vector. This method does
+ * not allocate any memory.
+ *
+ * @param buffer    The buffer to store the values
+ *
+ * @return the number of values in the serialized vector
+ */
+size_t NetcodeDeserializer::readDoubleVector(std::span<double> buffer) {
+    if (_pos >= _size) {
+        return 0;
+    }
+    size_t size = readVectorSize(1+sizeof(double));
+    read_array(_data, _pos, DoubleType, buffer.data(), buffer.size(), size);
+    return size;
+}
+
 /**
  * Returns a vector of unsigned (32 bit) int values.
  *
@@ -966,17 +1163,40 @@ std::vector<double> NetcodeDeserializer::readDoubleVector()     {
  */
 std::vector<Uint32> NetcodeDeserializer::readUint32Vector() {
     std::vector<Uint32> vv;
-    if (_pos >= _data.size()) {
+    if (_pos >= _size) {
         return vv;
     }
-    _pos++;
-    Uint64 size = std::get<Uint64>(read());
-    for (size_t i = 0; i < size; i++) {
-        vv.push_back(std::get<Uint32>(read()));
-    }
+    vv.resize(readVectorSize(1+sizeof(Uint32)));
+    read_array(_data, _pos, UInt32Type, vv.data(), vv.size(), vv.size());
     return vv;
 }
 
+/**
+ * Reads a vector of unsigned (32 bit) int values into the given buffer.
+ *
+ * This method is only defined if {@link #nextType} has returned
+ * (ArrayType+UInt32Type). Otherwise, calling this method will potentially
+ * corrupt the stream.
+ *
+ * This method stores as many values as fit in the buffer, skipping the
+ * rest. It returns the length of the serialized vector, so a result
+ * larger than the buffer indicates that values were skipped. Either way,
+ * the read position is advanced past the entire vector. This method does
+ * not allocate any memory.
+ *
+ * @param buffer    The buffer to store the values
+ *
+ * @return the number of values in the serialized vector
+ */
+size_t NetcodeDeserializer::readUint32Vector(std::span<Uint32> buffer) {
+    if (_pos >= _size) {
+        return 0;
+    }
+    size_t size = readVectorSize(1+sizeof(Uint32));
+    read_array(_data, _pos, UInt32Type, buffer.data(), buffer.size(), size);
+    return size;
+}
+
 /**
  * Returns a vector of signed (32 bit) int values.
  *
@@ -989,19 +1209,42 @@ std::vector<Uint32> NetcodeDeserializer::readUint32Vector() {
  *
  * @return a vector of signed (32 bit) int values.
  */
-std::vector<Sint32> NetcodeDeserializer::readSint32Vector()  {
+std::vector<Sint32> NetcodeDeserializer::readSint32Vector() {
     std::vector<Sint32> vv;
-    if (_pos >= _data.size()) {
+    if (_pos >= _size) {
         return vv;
     }
-    _pos++;
-    Uint64 size = std::get<Uint64>(read());
-    for (size_t i = 0; i < size; i++) {
-        vv.push_back(std::get<Sint32>(read()));
-    }
+    vv.resize(readVectorSize(1+sizeof(Sint32)));
+    read_array(_data, _pos, SInt32Type, vv.data(), vv.size(), vv.size());
     return vv;
 }
 
+/**
+ * Reads a vector of signed (32 bit) int values into the given buffer.
+ *
+ * This method is only defined if {@link #nextType} has returned
+ * (ArrayType+SInt32Type). Otherwise, calling this method will potentially
+ * corrupt the stream.
+ *
+ * This method stores as many values as fit in the buffer, skipping the
+ * rest. It returns the length of the serialized vector, so a result
+ * larger than the buffer indicates that values were skipped. Either way,
+ * the read position is advanced past the entire vector. This method does
+ * not allocate any memory.
+ *
+ * @param buffer    The buffer to store the values
+ *
+ * @return the number of values in the serialized vector
+ */
+size_t NetcodeDeserializer::readSint32Vector(std::span<Sint32> buffer) {
+    if (_pos >= _size) {
+        return 0;
+    }
+    size_t size = readVectorSize(1+sizeof(Sint32));
+    read_array(_data, _pos, SInt32Type, buffer.data(), buffer.size(), size);
+    return size;
+}
+
 /**
  * Returns a vector of unsigned (64 bit) int values.
  *
@@ -1016,17 +1259,40 @@ std::vector<Sint32> NetcodeDeserializer::readSint32Vector()  {
  */
 std::vector<Uint64> NetcodeDeserializer::readUint64Vector() {
     std::vector<Uint64> vv;
-    if (_pos >= _data.size()) {
+    if (_pos >= _size) {
         return vv;
     }
-    _pos++;
-    Uint64 size = std::get<Uint64>(read());
-    for (size_t i = 0; i < size; i++) {
-        vv.push_back(std::get<Uint64>(read()));
-    }
+    vv.resize(readVectorSize(1+sizeof(Uint64)));
+    read_array(_data, _pos, UInt64Type, vv.data(), vv.size(), vv.size());
     return vv;
 }
 
+/**
+ * Reads a vector of unsigned (64 bit) int values into the given buffer.
+ *
+ * This method is only defined if {@link #nextType} has returned
+ * (ArrayType+UInt64Type). Otherwise, calling this method will potentially
+ * corrupt the stream.
+ *
+ * This method stores as many values as fit in the buffer, skipping the
+ * rest. It returns the length of the serialized vector, so a result
+ * larger than the buffer indicates that values were skipped. Either way,
+ * the read position is advanced past the entire vector. This method does
+ * not allocate any memory.
+ *
+ * @param buffer    The buffer to store the values
+ *
+ * @return the number of values in the serialized vector
+ */
+size_t NetcodeDeserializer::readUint64Vector(std::span<Uint64> buffer) {
+    if (_pos >= _size) {
+        return 0;
+    }
+    size_t size = readVectorSize(1+sizeof(Uint64));
+    read_array(_data, _pos, UInt64Type, buffer.data(), buffer.size(), size);
+    return size;
+}
+
 /**
  * Returns a vector of signed (64 bit) int values.
  *
@@ -1041,17 +1307,40 @@ std::vector<Uint64> NetcodeDeserializer::readUint64Vector() {
  */
 std::vector<Sint64> NetcodeDeserializer::readSint64Vector() {
     std::vector<Sint64> vv;
-    if (_pos >= _data.size()) {
+    if (_pos >= _size) {
         return vv;
     }
-    _pos++;
-    Uint64 size = std::get<Uint64>(read());
-    for (size_t i = 0; i < size; i++) {
-        vv.push_back(std::get<Sint64>(read()));
-    }
+    vv.resize(readVectorSize(1+sizeof(Sint64)));
+    read_array(_data, _pos, SInt64Type, vv.data(), vv.size(), vv.size());
     return vv;
 }
 
+/**
+ * Reads a vector of signed (64 bit) int values into the given buffer.
+ *
+ * This method is only defined if {@link #nextType} has returned
+ * (ArrayType+SInt64Type). Otherwise, calling this method will potentially
+ * corrupt the stream.
+ *
+ * This method stores as many values as fit in the buffer, skipping the
+ * rest. It returns the length of the serialized vector, so a result
+ * larger than the buffer indicates that values were skipped. Either way,
+ * the read position is advanced past the entire vector. This method does
+ * not allocate any memory.
+ *
+ * @param buffer    The buffer to store the values
+ *
+ * @return the number of values in the serialized vector
+ */
+size_t NetcodeDeserializer::readSint64Vector(std::span<Sint64> buffer) {
+    if (_pos >= _size) {
+        return 0;
+    }
+    size_t size = readVectorSize(1+sizeof(Sint64));
+    read_array(_data, _pos, SInt64Type, buffer.data(), buffer.size(), size);
+    return size;
+}
+
 /**
  * Returns a vector of strings.
  *
@@ -1066,11 +1355,11 @@ std::vector<Sint64> NetcodeDeserializer::readSint64Vector() {
  */
 std::vector<std::string> NetcodeDeserializer::readStringVector() {
     std::vector<std::string> vv;
-    if (_pos >= _data.size()) {
+    if (_pos >= _size) {
         return vv;
     }
-    _pos++;
-    Uint64 size = std::get<Uint64>(read());
+    size_t size = readVectorSize(VECTOR_HEADER);
+    vv.reserve(size);
     for (size_t i = 0; i < size; i++) {
         vv.push_back(std::get<std::string>(read()));
     }
@@ -1091,11 +1380,11 @@ std::vector<std::string> NetcodeDeserializer::readStringVector() {
  */
 std::vector<std::shared_ptr<JsonValue>> NetcodeDeserializer::readJsonVector() {
     std::vector<std::shared_ptr<JsonValue>> vv;
-    if (_pos >= _data.size()) {
+    if (_pos >= _size) {
         return vv;
     }
-    _pos++;
-    Uint64 size = std::get<Uint64>(read());
+    size_t size = readVectorSize(VECTOR_HEADER);
+    vv.reserve(size);
     for (size_t i = 0; i < size; i++) {
         vv.push_back(std::get<std::shared_ptr<JsonValue>>(read()));
     }
@@ -1106,6 +1395,28 @@ std::vector<std::shared_ptr<JsonValue>> NetcodeDeserializer::readJsonVector() {
  * Clears the buffer and ignore any remaining data in it.
  */
 void NetcodeDeserializer::reset() {
-	_pos = 0;
-	_data.clear();
+    _pos = 0;
+    _size = 0;
+    _data = nullptr;
+    _buffer.clear();
+}
+
+/**
+ * Returns the length of the vector at the read position
+ *
+ * This method advances the read position past the vector header. It
+ * throws an exception if the vector is longer than the remaining data,
+ * as each element has a type and at least one byte of data.
+ *
+ * @param stride    The number of bytes for each element
+ *
+ * @return the length of the vector at the read position
+ */
+size_t NetcodeDeserializer::readVectorSize(size_t stride) {
+    _pos++;
+    Uint64 size = readUint64();
+    if (size > (_size-_pos)/stride) {
+        throw std::domain_error("Illegal state of array; did you pass in a valid message?");
+    }
+    return (size_t)size;
 }
@@ -435,11 +435,15 @@ void WebSocket::open(bool secure) {
  */
 void WebSocket::close() {
     if (_active) {
+        std::shared_ptr<rtc::WebSocket> socket;
         {
             std::lock_guard<std::mutex> lock(_mutex);
-            _socket->close();
+            socket = _socket;
             _state = WebSocket::State::CLOSING;
         }
+        
+        // Closing may invoke callbacks that need the lock
+        socket->close();
 
         // Never hold locks on a user callback
         if (_onStateChange) {
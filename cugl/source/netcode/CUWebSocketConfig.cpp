@@ -55,7 +55,8 @@ pemKey(""),
 pemPass(""),
 timeout(0),
 bufferSize(0),
-maxMessage(0) {
+maxMessage(0),
+sharded(false) {
 }
 
 /**
@@ -92,6 +93,7 @@ WebSocketConfig::WebSocketConfig(const InetAddress& address) : WebSocketConfig()
  *      "timeout":      An int representing the connection timeout
  *      "buffer size":  An int respresenting the size of the message buffer
  *      "max message":  An int respresenting the maximum transmission size
+ *      "sharded":      A boolean indicating if messages are buffered per client
  *
  * @param prefs     The configuration settings
  */
@@ -105,6 +107,7 @@ WebSocketConfig::WebSocketConfig(const std::shared_ptr<JsonValue>& prefs) {
     timeout = prefs->getInt("timeout",0);
     bufferSize = prefs->getInt("buffer size",0);
     maxMessage = prefs->getInt("max message",0);
+    sharded = prefs->getBool("sharded",false);
 }
 
 /**
@@ -132,6 +135,7 @@ WebSocketConfig& WebSocketConfig::set(const WebSocketConfig& src) {
     timeout = src.timeout;
     bufferSize = src.bufferSize;
     maxMessage = src.maxMessage;
+    sharded = src.sharded;
     return *this;
 }
 
@@ -152,6 +156,7 @@ WebSocketConfig& WebSocketConfig::set(const std::shared_ptr<WebSocketConfig>& sr
     timeout = src->timeout;
     bufferSize = src->bufferSize;
     maxMessage = src->maxMessage;
+    sharded = src->sharded;
     return *this;
 }
 
@@ -169,6 +174,7 @@ WebSocketConfig& WebSocketConfig::set(const std::shared_ptr<WebSocketConfig>& sr
  *      "pempass":      The PEM pass phrase
  *      "timeout":      An int representing the connection timeout
  *      "max message":  An int respresenting the maximum transmission size
+ *      "sharded":      A boolean indicating if messages are buffered per client
  *
  * @param prefs     The address settings
  *
@@ -184,6 +190,7 @@ WebSocketConfig& WebSocketConfig::set(const std::shared_ptr<JsonValue>& prefs) {
     timeout = prefs->getInt("timeout",0);
     bufferSize = prefs->getInt("buffer size",0);
     maxMessage = prefs->getInt("max message",0);
+    sharded = prefs->getBool("sharded",false);
 
     return *this;
 }
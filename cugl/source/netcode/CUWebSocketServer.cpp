@@ -59,6 +59,8 @@ using namespace std;
 
 /** The buffer size for message envelopes */
 #define DEFAULT_BUFFER 64
+/** The smoothing factor (as a shift) for the per-client latency */
+#define LATENCY_SHIFT  3
 
 /**
  * Copies information from a CUGL configuration to an RTC configuration
@@ -95,14 +97,45 @@ static void config2rtc(const WebSocketConfig& src, rtc::WebSocketServerConfigura
  *
  * This is an internal class used by {@link WebSocketServer}. We add it to
  * reduce the number of redirects associating keys with sockets.
+ *
+ * In sharded mode, the wrapper also stores the message buffer for this
+ * connection. This buffer has its own lock, so that connections do not
+ * contend with each other (or with the server lock) on receipt.
  */
 class cugl::netcode::WebSocketWrapper {
 public:
+    /** A buffered message */
+    class Message {
+    public:
+        /** The message (relative) timestamp */
+        Uint64 timestamp;
+        /** The message (as a byte vector) */
+        std::vector<std::byte> data;
+
+        /** Creates an empty message */
+        Message() : timestamp(0) {}
+    };
+
     size_t key;
     std::string address;
     std::string path;
     std::shared_ptr<rtc::WebSocket> socket;
     std::unordered_set<WebSocketWrapper*>* neighbors;
+
+    /** The lock for the message buffer */
+    std::mutex mutex;
+    /** The message ring buffer (sharded mode only) */
+    std::vector<Message> inbox;
+    /** The ring buffer being dispatched (swapped with the inbox) */
+    std::vector<Message> outbox;
+    /** The head of the message ring buffer */
+    size_t head;
+    /** The number of messages in the ring buffer */
+    size_t count;
+    /** The capacity of the message ring buffer */
+    size_t limit;
+    /** The smoothed time from receipt to dispatch in microseconds */
+    std::atomic<Uint64> latency;
     
     /**
      * Creates a new wrapper with the given key and socket
@@ -113,7 +146,11 @@ public:
     WebSocketWrapper(size_t key, const std::shared_ptr<rtc::WebSocket>& socket) :
         neighbors(nullptr),
         address(""),
-        path("") {
+        path(""),
+        head(0),
+        count(0),
+        limit(0),
+        latency(0) {
         this->key = key;
         this->socket = socket;
     }
@@ -127,6 +164,66 @@ public:
         socket = nullptr;
         neighbors = nullptr; // This was handled externally
     }
+
+    /**
+     * Sets the capacity of the message buffer, keeping the newest messages
+     *
+     * This method must be called while holding the wrapper lock.
+     *
+     * @param capacity  The new capacity
+     *
+     * @return the number of messages dropped
+     */
+    size_t resize(size_t capacity) {
+        size_t dropped = 0;
+        if (inbox.size() != capacity) {
+            std::vector<Message> ring(capacity);
+            if (count > capacity) {
+                dropped = count-capacity;
+                head = (head+dropped) % inbox.size();
+                count = capacity;
+            }
+            for(size_t ii = 0; ii < count; ii++) {
+                ring[ii] = std::move(inbox[(head+ii) % inbox.size()]);
+            }
+            inbox.swap(ring);
+            head = 0;
+        }
+        limit = capacity;
+        return dropped;
+    }
+
+    /**
+     * Appends a message to the buffer, dropping the oldest if it is full
+     *
+     * The byte vectors of the buffer are reused, so this method does not
+     * allocate once the buffer has warmed up. This method must be called
+     * while holding the wrapper lock.
+     *
+     * @param data      The message data
+     * @param timestamp The message timestamp
+     *
+     * @return true if a message was dropped
+     */
+    bool push(const std::vector<std::byte>& data, Uint64 timestamp) {
+        if (limit == 0) {
+            return true;
+        }
+        bool dropped = false;
+        if (inbox.size() != limit) {
+            dropped = resize(limit) > 0;
+        }
+        if (count == limit) {
+            head = (head+1) % limit;
+            count--;
+            dropped = true;
+        }
+        Message* msg = &(inbox[(head+count) % limit]);
+        msg->timestamp = timestamp;
+        msg->data.assign(data.begin(), data.end());
+        count++;
+        return dropped;
+    }
 };
 
 #pragma mark -
@@ -145,6 +242,9 @@ WebSocketServer::WebSocketServer() :
     _buffsize(0),
     _buffhead(0),
     _bufftail(0),
+    _dropped(0),
+    _immediate(false),
+    _draining(false),
     _debug(false),
     _active(false) {}
 
@@ -165,18 +265,26 @@ WebSocketServer::~WebSocketServer() {
  */
 void WebSocketServer::dispose() {
     if (_active) {
-        std::lock_guard<std::mutex> lock(_mutex);
-        _active = false;    // Prevents cycles
-        
-        // This kills all connections
-        _connections.clear();
-        _paths.clear();
-        
-        _server->stop();
-        _server = nullptr;
+        std::unordered_map<size_t, std::shared_ptr<WebSocketWrapper>> connections;
+        std::shared_ptr<rtc::WebSocketServer> server;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _active = false;    // Prevents cycles
+            
+            connections.swap(_connections);
+            _paths.clear();
+            _keymap.clear();
+            _snapshot = nullptr;
+            _pathshots.clear();
+            server = _server;
+            _server = nullptr;
 
-        _buffer.clear();
-        return;
+            _buffer.clear();
+        }
+        
+        // This kills all connections. Their callbacks need the lock.
+        connections.clear();
+        server->stop();
     }
 }
 
@@ -270,31 +378,32 @@ void WebSocketServer::onClient(std::shared_ptr<rtc::WebSocket> socket) {
     {
         std::lock_guard<std::mutex> lock(_mutex);
         _connections.try_emplace(key,std::make_shared<WebSocketWrapper>(key,socket));
-        
-        // In case we die before a connection
-        std::weak_ptr<WebSocketServer> wserver = shared_from_this();
-        
-        // Time to register some callbacks
-        socket->onOpen([key,wserver]() {
-            auto server = wserver.lock();
-            if (server) {
-                server->onOpen(key);
-            }
-        });
-        socket->onError([key,wserver](std::string s) {
-            auto server = wserver.lock();
-            if (server) {
-                server->onError(key,s);
-            }
-        });
-        socket->onClosed([key,wserver]() {
-            auto server = wserver.lock();
-            if (server) {
-                server->onClosed(key);
-            }
-        });
     }
     
+    // In case we die before a connection
+    std::weak_ptr<WebSocketServer> wserver = shared_from_this();
+    
+    // Time to register some callbacks. A callback for an event that already
+    // happened is invoked on registration, so we cannot hold the lock.
+    socket->onOpen([key,wserver]() {
+        auto server = wserver.lock();
+        if (server) {
+            server->onOpen(key);
+        }
+    });
+    socket->onError([key,wserver](std::string s) {
+        auto server = wserver.lock();
+        if (server) {
+            server->onError(key,s);
+        }
+    });
+    socket->onClosed([key,wserver]() {
+        auto server = wserver.lock();
+        if (server) {
+            server->onClosed(key);
+        }
+    });
+    
     // JUST in case
     if (socket->isOpen()) {
         onOpen(key);
@@ -311,6 +420,7 @@ void WebSocketServer::onClient(std::shared_ptr<rtc::WebSocket> socket) {
 void WebSocketServer::onOpen(size_t key) {
     std::string addr = "UNKNOWN";
     std::string path = "/";
+    std::shared_ptr<WebSocketWrapper> wrapper;
 
     {
         std::lock_guard<std::mutex> lock(_mutex);
@@ -318,7 +428,10 @@ void WebSocketServer::onOpen(size_t key) {
         if (it == _connections.end()) {
             return;
         }
-        auto wrapper = it->second;
+        wrapper = it->second;
+        if (!wrapper->address.empty()) {
+            return;     // Already opened
+        }
         
         Uint64 time = NetworkLayer::get()->getTime();
         std::string hash = strtool::to_hexstring(time);
@@ -351,18 +464,50 @@ void WebSocketServer::onOpen(size_t key) {
         }
         wrapper->neighbors->emplace(wrapper.get());
         
-        // Add the new callback
-        std::weak_ptr<WebSocketServer> wserver = shared_from_this();
+        if (_config.sharded) {
+            wrapper->limit = _bufflimit;
+        }
+        refresh(path);
+        
+        if (_debug) {
+            CULog("SERVER: Client %s connected",addr.c_str());
+        }
+    }
+    
+    // Add the new callback. Pending messages are dispatched on registration,
+    // so we cannot hold the lock.
+    std::weak_ptr<WebSocketServer> wserver = shared_from_this();
+    if (_config.sharded) {
+        std::weak_ptr<WebSocketWrapper> wwrapper = wrapper;
+        wrapper->socket->onMessage([addr,wserver,wwrapper](auto data) {
+            auto server = wserver.lock();
+            auto wrapper = wwrapper.lock();
+            if (server == nullptr || wrapper == nullptr ||
+                !std::holds_alternative<rtc::binary>(data)) {
+                return;
+            } else if (server->_immediate) {
+                server->onMessage(addr,data);
+                return;
+            }
+            
+            // Only lock this connection
+            Uint64 time = NetworkLayer::get()->getTime();
+            bool dropped = false;
+            {
+                std::lock_guard<std::mutex> lock(wrapper->mutex);
+                dropped = wrapper->push(std::get<rtc::binary>(data),time);
+            }
+            if (dropped) {
+                server->_dropped++;
+            }
+        });
+    } else {
         wrapper->socket->onMessage([addr,wserver](auto data) {
             auto server = wserver.lock();
             if (server) {
                 server->onMessage(addr,data);
             }
         });
-        
-        if (_debug) {
-            CULog("SERVER: Client %s connected",addr.c_str());
-        }
     }
     
     // Never hold locks during a user callback
@@ -433,6 +578,7 @@ void WebSocketServer::onClosed(size_t key) {
         }
         
         _connections.erase(it);
+        refresh(path);
         
         if (_debug) {
             CULog("SERVER: Client %s disconnected",addr.c_str());
@@ -490,6 +636,7 @@ bool WebSocketServer::append(const std::string client, const std::vector<std::by
                     // Drops the oldest message
                     _buffhead = ((_buffhead + 1) % _buffer.size());
                     _buffsize--;
+                    _dropped++;
                 }
         
                 Envelope* env = &(_buffer[_bufftail]);
@@ -511,6 +658,40 @@ bool WebSocketServer::append(const std::string client, const std::vector<std::by
     return success;
 }
 
+/**
+ * Rebuilds the connection snapshots after a connection change.
+ *
+ * This rebuilds the snapshot of all connections, and the snapshot of the
+ * given path. This method must be called while holding the lock.
+ *
+ * @param path  The path of the connection that changed
+ */
+void WebSocketServer::refresh(const std::string& path) {
+    auto all = std::make_shared<std::vector<std::shared_ptr<WebSocketWrapper>>>();
+    all->reserve(_connections.size());
+    for (auto it = _connections.begin(); it != _connections.end(); ++it) {
+        if (!it->second->address.empty()) {
+            all->push_back(it->second);
+        }
+    }
+    _snapshot = all;
+    
+    auto jt = _paths.find(path);
+    if (jt == _paths.end()) {
+        _pathshots.erase(path);
+        return;
+    }
+    auto local = std::make_shared<std::vector<std::shared_ptr<WebSocketWrapper>>>();
+    local->reserve(jt->second.size());
+    for (auto kt = jt->second.begin(); kt != jt->second.end(); ++kt) {
+        auto wt = _connections.find((*kt)->key);
+        if (wt != _connections.end()) {
+            local->push_back(wt->second);
+        }
+    }
+    _pathshots[path] = local;
+}
+
 #pragma mark -
 #pragma mark Accessors
 /**
@@ -542,7 +723,7 @@ uint16_t WebSocketServer::getPort() const {
  */
 size_t WebSocketServer::getCapacity() {
     std::lock_guard<std::mutex> lock(_mutex);
-    return _buffer.size();
+    return _config.sharded ? _bufflimit : _buffer.size();
 }
 
 /**
@@ -560,6 +741,14 @@ size_t WebSocketServer::getCapacity() {
  */
 void WebSocketServer::setCapacity(size_t capacity) {
     std::lock_guard<std::mutex> lock(_mutex);
+    if (_config.sharded) {
+        for (auto it = _connections.begin(); it != _connections.end(); ++it) {
+            std::lock_guard<std::mutex> sublock(it->second->mutex);
+            _dropped += it->second->resize(capacity);
+        }
+        _bufflimit = capacity;
+        return;
+    }
     
     // Rotate to correct position
     size_t pos = _buffhead;
@@ -660,6 +849,81 @@ size_t WebSocketServer::getNumConnections() {
     return _keymap.size();
 }
 
+/**
+ * Returns the number of messages waiting to be received.
+ *
+ * This is the total number of messages across all connections that will
+ * be dispatched by the next call to {@link #receive}.
+ *
+ * This method is not const because it requires a lock.
+ *
+ * @return the number of messages waiting to be received.
+ */
+size_t WebSocketServer::getQueueDepth() {
+    size_t result = _buffsize;
+    std::shared_ptr<const std::vector<std::shared_ptr<WebSocketWrapper>>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        snapshot = _snapshot;
+    }
+    if (_config.sharded && snapshot) {
+        for (auto it = snapshot->begin(); it != snapshot->end(); ++it) {
+            std::lock_guard<std::mutex> lock((*it)->mutex);
+            result += (*it)->count;
+        }
+    }
+    return result;
+}
+
+/**
+ * Returns the number of messages waiting to be received from a client.
+ *
+ * This value is only tracked in sharded mode. Otherwise, this method
+ * returns 0.
+ *
+ * This method is not const because it requires a lock.
+ *
+ * @param client    The client identifier
+ *
+ * @return the number of messages waiting to be received from a client.
+ */
+size_t WebSocketServer::getQueueDepth(const std::string client) {
+    std::shared_ptr<WebSocketWrapper> wrapper;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _keymap.find(client);
+        if (!_config.sharded || it == _keymap.end()) {
+            return 0;
+        }
+        wrapper = _connections.find(it->second)->second;
+    }
+    std::lock_guard<std::mutex> lock(wrapper->mutex);
+    return wrapper->count;
+}
+
+/**
+ * Returns the average time messages from a client wait to be received.
+ *
+ * This is the time in microseconds between the arrival of a message and
+ * its dispatch by {@link #receive}, smoothed over recent messages. This
+ * value is only tracked in sharded mode. Otherwise, this method returns
+ * 0.
+ *
+ * This method is not const because it requires a lock.
+ *
+ * @param client    The client identifier
+ *
+ * @return the average time messages from a client wait to be received.
+ */
+Uint64 WebSocketServer::getLatency(const std::string client) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _keymap.find(client);
+    if (!_config.sharded || it == _keymap.end()) {
+        return 0;
+    }
+    return _connections.find(it->second)->second->latency;
+}
+
 /**
  * Toggles the debugging status of this connection.
  *
@@ -717,13 +981,23 @@ void WebSocketServer::stop() {
         return;
     }
     
-    std::lock_guard<std::mutex> lock(_mutex);
-    _active = false;
-    _connections.clear();
-    _paths.clear();
-    _keymap.clear();
-    _server->stop();
-    _server = nullptr;
+    std::unordered_map<size_t, std::shared_ptr<WebSocketWrapper>> connections;
+    std::shared_ptr<rtc::WebSocketServer> server;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _active = false;
+        connections.swap(_connections);
+        _paths.clear();
+        _keymap.clear();
+        _snapshot = nullptr;
+        _pathshots.clear();
+        server = _server;
+        _server = nullptr;
+    }
+    
+    // Closing a connection invokes callbacks that need the lock
+    connections.clear();
+    server->stop();
 }
 
 /**
@@ -843,26 +1117,25 @@ bool WebSocketServer::sendTo(const std::string dst, std::vector<std::byte>&& dat
  */
 bool WebSocketServer::broadcast(const std::string path,
                                 const std::vector<std::byte>& data) {
-    std::vector<std::shared_ptr<rtc::WebSocket>> sockets;
+    std::shared_ptr<const std::vector<std::shared_ptr<WebSocketWrapper>>> snapshot;
     bool success = true;
 
-    // Critical section
+    // Critical section (the snapshot is immutable)
     if (_active) {
         std::lock_guard<std::mutex> lock(_mutex);
-        auto it = _paths.find(path);
-        if (it == _paths.end()) {
+        auto it = _pathshots.find(path);
+        if (it == _pathshots.end()) {
             return false;
         }
-        
-        sockets.reserve(it->second.size());
-        for (auto jt = it->second.begin(); jt != it->second.end(); ++jt) {
-            sockets.push_back((*jt)->socket);
-        }
+        snapshot = it->second;
+    }
+    if (snapshot == nullptr) {
+        return false;
     }
         
     // Do not hold locks on send
-    for(auto it = sockets.begin(); it != sockets.end(); ++it) {
-        success = (*it)->send(data) && success;
+    for(auto it = snapshot->begin(); it != snapshot->end(); ++it) {
+        success = (*it)->socket->send(data) && success;
     }
         
     return success;
@@ -891,23 +1164,23 @@ bool WebSocketServer::broadcast(const std::string path,
  * @return true if the message was (apparently) sent
  */
 bool WebSocketServer::broadcast(const std::vector<std::byte>& data) {
-    std::vector<std::shared_ptr<rtc::WebSocket>> sockets;
+    std::shared_ptr<const std::vector<std::shared_ptr<WebSocketWrapper>>> snapshot;
     bool success = true;
 
-    // Critical section
+    // Critical section (the snapshot is immutable)
     if (_active) {
         std::lock_guard<std::mutex> lock(_mutex);
-        sockets.reserve(_connections.size());
-        for (auto jt = _connections.begin(); jt != _connections.end(); ++jt) {
-            if (jt->second->socket->isOpen()) {
-                sockets.push_back(jt->second->socket);
-            }
-        }
+        snapshot = _snapshot;
+    }
+    if (snapshot == nullptr) {
+        return true;
     }
         
     // Do not hold locks on send
-    for(auto it = sockets.begin(); it != sockets.end(); ++it) {
-        success = (*it)->send(data) && success;
+    for(auto it = snapshot->begin(); it != snapshot->end(); ++it) {
+        if ((*it)->socket->isOpen()) {
+            success = (*it)->socket->send(data) && success;
+        }
     }
         
     return success;
@@ -929,10 +1202,20 @@ bool WebSocketServer::broadcast(const std::vector<std::byte>& data) {
  * buffered and are processed as soon as they are received. However, this
  * method has the advantage that it can be read on a separate thread.
  *
+ * In sharded mode, messages are dispatched one connection at a time (in
+ * the order received from that connection). Messages from different
+ * connections can be ordered by their timestamp. This method should not
+ * be called by more than one thread at a time.
+ *
  * @param dispatcher    The function to process received data
  */
 void WebSocketServer::receive(const Dispatcher& dispatcher) {
-    if (dispatcher == nullptr || !_active || _buffsize == 0) {
+    if (dispatcher == nullptr || !_active) {
+        return;
+    } else if (_config.sharded) {
+        drain(dispatcher);
+        return;
+    } else if (_buffsize == 0) {
         return;
     }
     
@@ -965,6 +1248,62 @@ void WebSocketServer::receive(const Dispatcher& dispatcher) {
     }
 }
     
+/**
+ * Dispatches all messages in the connection buffers.
+ *
+ * This is the implementation of {@link #receive} in sharded mode. Each
+ * connection buffer is swapped out in constant time and dispatched with
+ * no locks held.
+ *
+ * @param dispatcher    The function to process received data
+ */
+void WebSocketServer::drain(const Dispatcher& dispatcher) {
+    if (_draining.exchange(true)) {
+        return;
+    }
+    
+    std::shared_ptr<const std::vector<std::shared_ptr<WebSocketWrapper>>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        snapshot = _snapshot;
+    }
+    
+    if (snapshot) {
+        Uint64 time = NetworkLayer::get()->getTime();
+        for (auto it = snapshot->begin(); it != snapshot->end(); ++it) {
+            WebSocketWrapper* wrapper = it->get();
+            size_t head  = 0;
+            size_t count = 0;
+            {
+                std::lock_guard<std::mutex> lock(wrapper->mutex);
+                if (wrapper->count == 0) {
+                    continue;
+                }
+                // Swap buffers so that appends can continue during dispatch
+                wrapper->inbox.swap(wrapper->outbox);
+                head  = wrapper->head;
+                count = wrapper->count;
+                wrapper->head  = 0;
+                wrapper->count = 0;
+                if (wrapper->inbox.size() != wrapper->limit) {
+                    wrapper->inbox.resize(wrapper->limit);
+                }
+            }
+            
+            Uint64 latency = wrapper->latency;
+            size_t size = wrapper->outbox.size();
+            for (size_t ii = 0; ii < count; ii++) {
+                auto& msg = wrapper->outbox[(head+ii) % size];
+                Uint64 wait = time > msg.timestamp ? time-msg.timestamp : 0;
+                latency = latency+(wait >> LATENCY_SHIFT)-(latency >> LATENCY_SHIFT);
+                dispatcher(wrapper->address,msg.data,msg.timestamp);
+            }
+            wrapper->latency = latency;
+        }
+    }
+    _draining = false;
+}
+    
 #pragma mark -
 #pragma mark Callbacks
 /**
@@ -983,6 +1322,7 @@ void WebSocketServer::receive(const Dispatcher& dispatcher) {
 void WebSocketServer::onReceipt(Dispatcher callback) {
     std::lock_guard<std::mutex> lock(_mutex);
     _onReceipt = callback;
+    _immediate = (callback != nullptr);
 }
 
 /**
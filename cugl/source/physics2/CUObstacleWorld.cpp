@@ -57,6 +57,8 @@ using namespace cugl::physics2;
 
 /** The default value of gravity (going down) */
 #define DEFAULT_GRAVITY -9.8f
+/** The minimum number of queries per thread in a batched query */
+#define QUERY_BATCH_MIN 64
 
 #pragma mark -
 #pragma mark Proxy Classes
@@ -154,6 +156,76 @@ public:
 };
 
 
+/**
+ * A b2QueryCallback to collect fixtures in a batched query.
+ *
+ * Unlike {@link QueryProxy}, this class does not use a closure, so it has
+ * no per-query overhead.
+ */
+class BatchQueryProxy : public b2QueryCallback {
+public:
+    /** The vector to store the fixtures found */
+    std::vector<b2Fixture*>* fixtures;
+    /** The category bits of the fixtures to report */
+    Uint16 mask;
+
+    /**
+     * Returns true to continue the AABB query
+     *
+     * This function is called for each fixture found in the query AABB.
+     *
+     * @param  fixture  the fixture selected
+     *
+     * @return true to continue the query.
+     */
+    bool ReportFixture(b2Fixture* fixture) override {
+        if (fixture->GetFilterData().categoryBits & mask) {
+            fixtures->push_back(fixture);
+        }
+        return true;
+    }
+};
+
+/**
+ * A b2RayCastCallback to find the closest hit in a batched ray cast.
+ *
+ * Unlike {@link RaycastProxy}, this class does not use a closure, so it has
+ * no per-ray overhead.
+ */
+class BatchRaycastProxy : public b2RayCastCallback {
+public:
+    /** The closest hit so far */
+    RayHit* hit;
+    /** The category bits of the fixtures to report */
+    Uint16 mask;
+
+    /**
+     * Called for each fixture found in the query.
+     *
+     * This callback clips the ray at each hit, so that the last hit reported
+     * is the closest one.
+     *
+     * @param  fixture  the fixture hit by the ray
+     * @param  point    the point of initial intersection
+     * @param  normal   the normal vector at the point of intersection
+     * @param  faction  the fraction to return
+     *
+     * @return -1 to filter, or the fraction to clip the ray
+     */
+    float ReportFixture(b2Fixture* fixture, const b2Vec2& point,
+                        const b2Vec2& normal, float fraction) override {
+        if (!(fixture->GetFilterData().categoryBits & mask)) {
+            return -1;
+        }
+        hit->fixture = fixture;
+        hit->point.set(point.x,point.y);
+        hit->normal.set(normal.x,normal.y);
+        hit->fraction = fraction;
+        return fraction;
+    }
+};
+
+
 #pragma mark -
 #pragma mark Constructors
 
@@ -166,7 +238,8 @@ ObstacleWorld::ObstacleWorld() :
 _world(nullptr),
 _collide(false),
 _filters(false),
-_destroy(false)
+_destroy(false),
+_threads(1)
 {
     _lockstep   = false;
     _stepssize  = DEFAULT_WORLD_STEP;
@@ -192,6 +265,12 @@ void ObstacleWorld::dispose() {
         delete _world;
         _world  = nullptr;
     }
+    if (_workers != nullptr) {
+        _workers->stop();
+        _workers = nullptr;
+    }
+    _partials.clear();
+    _threads = 1;
     onBeginContact = nullptr;
     onEndContact   = nullptr;
     beforeSolve    = nullptr;
@@ -236,6 +315,7 @@ bool ObstacleWorld::init(const Rect bounds, const Vec2 gravity) {
     _gravity = gravity;
     _world = new b2World(b2Vec2(gravity.x, gravity.y));
     if (_world) {
+        setThreadCount(_threads);
         return true;
     }
     return false;
@@ -421,6 +501,7 @@ void ObstacleWorld::clear(bool reboot) {
         if (_destroy) {
             _world->SetDestructionListener(this);
         }
+        setThreadCount(_threads);
     }
 }
 
@@ -443,6 +524,61 @@ void ObstacleWorld::setGravity(const Vec2 gravity) {
     }
 }
 
+/**
+ * Sets the number of threads used to solve the physics islands.
+ *
+ * An island is a set of bodies connected by contacts or joints. Islands
+ * are independent of each other, so they can be solved in parallel. If
+ * this value is greater than 1, each step partitions the awake islands
+ * into (at most) this many tasks, and solves them on a pool of worker
+ * threads together with the calling thread.
+ *
+ * The simulation is identical to a serial one, and the islands are
+ * merged in a deterministic order. The only difference is that the
+ * {@link #afterSolve} callbacks are deferred until all islands are
+ * solved (they are still called in the serial order, on the calling
+ * thread). Collision detection and continuous collision remain serial,
+ * so this only pays off for large worlds with many separate islands.
+ *
+ * @param threads   The number of threads used to solve the physics islands
+ */
+void ObstacleWorld::setThreadCount(Uint32 threads) {
+    threads = std::max(threads,(Uint32)1);
+    if (threads != _threads && _workers != nullptr) {
+        _workers->stop();
+        _workers = nullptr;
+    }
+    _threads = threads;
+    if (_threads > 1 && _workers == nullptr) {
+        _workers = ThreadPool::alloc(_threads-1);
+    }
+    if (_world != nullptr) {
+        if (_threads > 1) {
+            _world->SetTaskExecutor(runTasks, (int32)_threads, this);
+        } else {
+            _world->SetTaskExecutor(nullptr, 0, nullptr);
+        }
+    }
+}
+
+/**
+ * Runs the given island solver tasks, returning when they are complete.
+ *
+ * This is the task executor for the Box2d world. The first task is run
+ * on the calling thread, and the rest are run by the worker threads.
+ *
+ * @param task          The task to run
+ * @param taskCount     The number of tasks
+ * @param taskContext   The solver data shared by all tasks
+ * @param userContext   The ObstacleWorld running the tasks
+ */
+void ObstacleWorld::runTasks(b2TaskCallback* task, int32 taskCount, void* taskContext, void* userContext) {
+    ObstacleWorld* world = (ObstacleWorld*)userContext;
+    world->_workers->parallelFor((Uint32)taskCount, [=](Uint32 index) {
+        task((int32)index,taskContext);
+    });
+}
+
 /**
  * Executes a single step of the physics engine.
  *
@@ -604,3 +740,121 @@ void ObstacleWorld::rayCast(std::function<float(b2Fixture* fixture, const Vec2 p
     proxy.onQuery = callback;
     _world->RayCast(&proxy, b2Vec2(point1.x,point1.y), b2Vec2(point2.x,point2.y));
 }
+
+/**
+ * Query the world for the fixtures that potentially overlap each AABB.
+ *
+ * This is a batched version of {@link #queryAABB} for issuing many
+ * queries at once. The fixtures for box i are stored in fixtures at
+ * positions offsets[i] to offsets[i+1] (exclusive), in the order that
+ * Box2d reports them. Both vectors are cleared first, but they keep their
+ * capacity, so reusing them avoids allocation.
+ *
+ * Only fixtures whose category bits intersect the mask are reported. If
+ * {@link #getThreadCount} is greater than 1, large batches are split
+ * across the worker threads. The results are the same either way. The
+ * world must not be modified (or stepped) during the query. As the
+ * worker results are kept between calls, this method should only be
+ * called from one thread at a time.
+ *
+ * @param boxes     The axis-aligned bounding boxes
+ * @param count     The number of boxes
+ * @param fixtures  The vector to store the fixtures found
+ * @param offsets   The vector to store the start of each box (count+1 values)
+ * @param mask      The category bits of the fixtures to report
+ */
+void ObstacleWorld::queryAABB(const Rect* boxes, size_t count,
+                              std::vector<b2Fixture*>& fixtures, std::vector<size_t>& offsets,
+                              Uint16 mask) const {
+    fixtures.clear();
+    offsets.resize(count+1);
+    Uint32 tasks = (Uint32)std::min((size_t)_threads, count/QUERY_BATCH_MIN);
+    tasks = std::max(tasks,(Uint32)1);
+
+    // Each task collects a contiguous range of boxes
+    if (_partials.size() < tasks-1) {
+        _partials.resize(tasks-1);
+    }
+    for(Uint32 jj = 1; jj < tasks; jj++) {
+        _partials[jj-1].clear();
+    }
+    auto query = [&](Uint32 index) {
+        size_t first = index*count/tasks;
+        size_t last  = (index+1)*count/tasks;
+        BatchQueryProxy proxy;
+        proxy.fixtures = index == 0 ? &fixtures : &_partials[index-1];
+        proxy.mask = mask;
+        for(size_t ii = first; ii < last; ii++) {
+            offsets[ii] = proxy.fixtures->size();
+            b2AABB b2box;
+            b2box.lowerBound.Set(boxes[ii].origin.x, boxes[ii].origin.y);
+            b2box.upperBound.Set(boxes[ii].origin.x+boxes[ii].size.width,
+                                 boxes[ii].origin.y+boxes[ii].size.height);
+            _world->QueryAABB(&proxy, b2box);
+        }
+    };
+    if (tasks > 1) {
+        _workers->parallelFor(tasks, query);
+    } else {
+        query(0);
+    }
+
+    // Merge the ranges in order, rebasing the offsets
+    for(Uint32 jj = 1; jj < tasks; jj++) {
+        size_t base  = fixtures.size();
+        size_t first = jj*count/tasks;
+        size_t last  = (jj+1)*count/tasks;
+        for(size_t ii = first; ii < last; ii++) {
+            offsets[ii] += base;
+        }
+        fixtures.insert(fixtures.end(), _partials[jj-1].begin(), _partials[jj-1].end());
+    }
+    offsets[count] = fixtures.size();
+}
+
+/**
+ * Ray-casts the world for the closest fixture hit by each ray.
+ *
+ * This is a batched version of {@link #rayCast} for issuing many ray casts
+ * (such as line-of-sight tests) at once. The closest hit for the ray from
+ * starts[i] to ends[i] is stored in hits[i]. If the ray hits nothing, the
+ * fixture of the hit is nullptr, and the fraction is 1. As with a single
+ * ray-cast, fixtures that contain the starting point are ignored.
+ *
+ * Only fixtures whose category bits intersect the mask are reported. If
+ * {@link #getThreadCount} is greater than 1, large batches are split
+ * across the worker threads. The results are the same either way. The
+ * world must not be modified (or stepped) during the ray casts.
+ *
+ * @param starts    The ray starting points
+ * @param ends      The ray ending points
+ * @param count     The number of rays
+ * @param hits      The array to store the closest hits (at least count)
+ * @param mask      The category bits of the fixtures to report
+ */
+void ObstacleWorld::rayCast(const Vec2* starts, const Vec2* ends, size_t count,
+                            RayHit* hits, Uint16 mask) const {
+    Uint32 tasks = (Uint32)std::min((size_t)_threads, count/QUERY_BATCH_MIN);
+    tasks = std::max(tasks,(Uint32)1);
+    auto cast = [&](Uint32 index) {
+        size_t first = index*count/tasks;
+        size_t last  = (index+1)*count/tasks;
+        BatchRaycastProxy proxy;
+        proxy.mask = mask;
+        for(size_t ii = first; ii < last; ii++) {
+            RayHit* hit = hits+ii;
+            hit->fixture = nullptr;
+            hit->point = ends[ii];
+            hit->normal.setZero();
+            hit->fraction = 1.0f;
+            proxy.hit = hit;
+            _world->RayCast(&proxy, b2Vec2(starts[ii].x,starts[ii].y),
+                            b2Vec2(ends[ii].x,ends[ii].y));
+        }
+    };
+    if (tasks > 1) {
+        _workers->parallelFor(tasks, cast);
+    } else {
+        cast(0);
+    }
+}
@@ -47,8 +47,12 @@
 #include <cugl/physics2/distrib/CULWSerializer.h>
 #include <cugl/netcode/CUNetworkLayer.h>
 
-/** The minimum message length */
-#define MIN_MSG_LENGTH sizeof(std::byte)+sizeof(Uint64)
+/** The length of a frame header (flags and timestamp) */
+#define FRAME_HEADER_LENGTH sizeof(std::byte)+sizeof(Uint64)
+/** The default maximum frame size (to fit a typical network MTU) */
+#define FRAME_DEFAULT_SIZE  1200
+/** The frame flag indicating that the frame body is compressed */
+#define FRAME_COMPRESSED    0x01
 
 using namespace cugl;
 using namespace cugl::physics2;
@@ -72,7 +76,9 @@ _numReady(0),
 _roomid(""),
 _physEnabled(false),
 _status(Status::IDLE),
-_startGameTimeStamp(0) {
+_startGameTimeStamp(0),
+_frameSize(FRAME_DEFAULT_SIZE),
+_compressSize(0) {
 }
 
 /**
@@ -181,6 +187,11 @@ void NetEventController::disconnect() {
     _startGameTimeStamp = 0;
     _numReady = 0;
     _outEventQueue.clear();
+    for (auto it = _frames.begin(); it != _frames.end(); ++it) {
+        it->second.data.clear();
+        it->second.count = 0;
+    }
+    _pending.clear();
     
     while (!_inEventQueue.empty()) {
         _inEventQueue.pop();
@@ -250,6 +261,10 @@ void NetEventController::enablePhysics(std::shared_ptr<NetWorld>& world, Obstacl
     //CULog("ENABLED PHYSICS");
     attachEventType<PhysSyncEvent>();
     attachEventType<PhysObstEvent>();
+    // Inbound sync events must decode against the same history
+    Uint8 type = _eventTypeMap.at(std::type_index(typeid(PhysSyncEvent)));
+    auto sync = std::dynamic_pointer_cast<PhysSyncEvent>(_newEventVector[type]);
+    sync->setBaseline(_physController->getSyncBaseline());
     if(_isHost) {
         _physController->ownAll();
     }
@@ -321,6 +336,16 @@ void NetEventController::updateNet() {
         checkConnection();
 
         if (_status == Status::INGAME && _physEnabled) {
+            // Drop the per-peer state of anyone who has left
+            auto interest = _physController->getInterest();
+            if (interest) {
+                std::vector<std::string> peers = interest->getPeers();
+                for (auto it = peers.begin(); it != peers.end(); it++) {
+                    if (!_network->isPlayerActive(*it)) {
+                        _physController->removePeer(*it);
+                    }
+                }
+            }
             _physController->packPhysSync(NetPhysicsController::SyncType::FULL_SYNC);
             _physController->packPhysObj();
             _physController->updateSimulation();
@@ -332,6 +357,9 @@ void NetEventController::updateNet() {
         }
         
         processReceivedData();
+        if (_status == Status::INGAME && _physEnabled) {
+            _physController->applyRollback(getGameTick());
+        }
         sendQueuedOutData();
     }
 }
@@ -339,50 +367,242 @@ void NetEventController::updateNet() {
 
 #pragma mark Networking Internals
 /**
- * Unwraps the a byte vector data into a NetEvent.
+ * Writes a varint to the end of the given buffer
+ *
+ * @param buffer    The buffer to write to
+ * @param value     The value to write
+ */
+static void write_varint(std::vector<std::byte>& buffer, size_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(std::byte((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(std::byte(value));
+}
+
+/**
+ * Returns a varint read from the given data, advancing the position
+ *
+ * If the data ends before the varint, the position is set past the end.
+ *
+ * @param data  The data to read
+ * @param size  The data size
+ * @param pos   The position to read from
+ *
+ * @return a varint read from the given data
+ */
+static size_t read_varint(const std::byte* data, size_t size, size_t& pos) {
+    size_t result = 0;
+    for (Uint32 shift = 0; shift < 64; shift += 7) {
+        if (pos >= size) {
+            pos = size+1;
+            return 0;
+        }
+        Uint8 group = (Uint8)data[pos++];
+        result |= (size_t)(group & 0x7f) << shift;
+        if (!(group & 0x80)) {
+            break;
+        }
+    }
+    return result;
+}
+
+/**
+ * Appends the zero run-length encoding of the given data to a buffer
+ *
+ * Nonzero bytes are copied. A run of zeroes is a zero byte followed by
+ * the length of the run (at most 255).
+ *
+ * @param data      The data to compress
+ * @param size      The data size
+ * @param buffer    The buffer to write to
+ */
+static void compress_zeroes(const std::byte* data, size_t size, std::vector<std::byte>& buffer) {
+    size_t pos = 0;
+    while (pos < size) {
+        if (data[pos] != std::byte(0)) {
+            buffer.push_back(data[pos++]);
+        } else {
+            size_t run = 0;
+            while (pos < size && run < 255 && data[pos] == std::byte(0)) {
+                pos++;
+                run++;
+            }
+            buffer.push_back(std::byte(0));
+            buffer.push_back(std::byte(run));
+        }
+    }
+}
+
+/**
+ * Appends the zero run-length decoding of the given data to a buffer
+ *
+ * @param data      The data to decompress
+ * @param size      The data size
+ * @param buffer    The buffer to write to
+ *
+ * @return true if the data was well-formed
+ */
+static bool expand_zeroes(const std::byte* data, size_t size, std::vector<std::byte>& buffer) {
+    size_t pos = 0;
+    while (pos < size) {
+        if (data[pos] != std::byte(0)) {
+            buffer.push_back(data[pos++]);
+        } else if (pos+1 < size) {
+            buffer.insert(buffer.end(), (size_t)data[pos+1], std::byte(0));
+            pos += 2;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Unwraps a framed message into NetEvents.
  *
- * The controller automatically detects the type of event, spawns a new
+ * A frame is a flag byte, the sender timestamp, and a sequence of events.
+ * Each event is prefixed by its length (as a varint) and its type. The
+ * controller automatically detects the type of each event, spawns a new
  * empty instance of that event, and calls the event's
- * {@link NetEvent#deserialize} method. This method is only called on
- * outbound events.
+ * {@link NetEvent#deserialize} method. The events are passed to
+ * {@link #processReceivedEvent} in the order they were sent.
+ *
+ * The frame is read in place. Only compressed frames are copied, into a
+ * buffer that is reused across frames. This method is only called on
+ * inbound events.
  *
- * @param byte      The message received
+ * @param data      The message received
  * @param source    The UUID of the sender
  */
-std::shared_ptr<NetEvent> NetEventController::unwrap(const std::vector<std::byte>& data, std::string source) {
-    CUAssertLog(data.size() >= MIN_MSG_LENGTH && (Uint8)data[0] < _newEventVector.size(),
-                "Unwrapping invalid event");
-    LWDeserializer deserializer;
-    deserializer.receive(data);
-    Uint8 eventType = (Uint8)deserializer.readByte();
-    std::shared_ptr<NetEvent> e = _newEventVector[eventType]->newEvent();
-    Uint64 eventTimeStamp = deserializer.readUint64();
+void NetEventController::unwrap(const std::vector<std::byte>& data, const std::string& source) {
+    CUAssertLog(data.size() >= FRAME_HEADER_LENGTH, "Unwrapping invalid frame");
+    if (data.size() < FRAME_HEADER_LENGTH) {
+        return;
+    }
+
+    const std::byte* body = data.data()+1;
+    size_t size = data.size()-1;
+    if ((Uint8)data[0] & FRAME_COMPRESSED) {
+        _packed.clear();
+        bool valid = expand_zeroes(body, size, _packed);
+        CUAssertLog(valid && _packed.size() >= sizeof(Uint64), "Unwrapping invalid frame");
+        if (!valid || _packed.size() < sizeof(Uint64)) {
+            return;
+        }
+        body = _packed.data();
+        size = _packed.size();
+    }
 
+    Uint64 eventTimeStamp = 0;
+    for (size_t ii = 0; ii < sizeof(Uint64); ii++) {
+        eventTimeStamp = (eventTimeStamp << 8) | (Uint8)body[ii];
+    }
     Uint64 time = Application::get()->getFixedCount();
-    Uint64 receiveTimeStamp = time-_startGameTimeStamp;
-    e->setMetaData(eventTimeStamp, receiveTimeStamp, source);
-    e->deserialize(std::vector(data.begin()+MIN_MSG_LENGTH,data.end()));
-    return e;
+
+    size_t pos = sizeof(Uint64);
+    while (pos < size) {
+        size_t length = read_varint(body, size, pos);
+        CUAssertLog(length > 0 && pos+length <= size, "Unwrapping invalid event");
+        if (length == 0 || pos+length > size) {
+            return;
+        }
+        Uint8 eventType = (Uint8)body[pos];
+        CUAssertLog(eventType < _newEventVector.size(), "Unwrapping invalid event");
+        if (eventType < _newEventVector.size()) {
+            std::shared_ptr<NetEvent> e = _newEventVector[eventType]->newEvent();
+            // An earlier event in the frame may have started the game
+            e->setMetaData(eventTimeStamp, time-_startGameTimeStamp, source);
+            _payload.assign(body+pos+1, body+pos+length);
+            e->deserialize(_payload);
+            processReceivedEvent(e);
+        }
+        pos += length;
+    }
 }
 
 /**
- * Wraps a NetEvent into a byte vector.
+ * Wraps a NetEvent into the frame for its destination.
  *
  * The controller calls the event's {@link NetEvent#serialize()} method
- * and packs the event into byte data. This method is only on inbound
- * events.
+ * and appends the event to the frame for its destination. If the event
+ * would make the frame larger than {@link #getMaxFrameSize}, the frame is
+ * sent first. Frames that could be received by the same peer are sent
+ * in order, so each peer receives events in the order they were queued.
+ * This method is only called on outbound events.
  *
  * @param e The event to wrap
  */
-const std::vector<std::byte> NetEventController::wrap(const std::shared_ptr<NetEvent>& e) {
-    LWSerializer serializer;
-    serializer.writeByte((std::byte)getType(*e));
-    //CULog("flag: %x",(std::byte)getType(*e));
+void NetEventController::wrap(const std::shared_ptr<NetEvent>& e) {
+    const std::string& dst = e->getDestination();
+    
+    // A broadcast reaches every peer, so must follow any unicast frames
+    if (dst.empty()) {
+        for (auto it = _pending.begin(); it != _pending.end(); ++it) {
+            flush(*it);
+        }
+        _pending.clear();
+    } else {
+        flush("");
+    }
 
-    Uint64 time = Application::get()->getFixedCount();
-    serializer.writeUint64(time-_startGameTimeStamp);
-    serializer.writeByteVector(e->serialize());
-    return serializer.serialize();
+    std::vector<std::byte> payload = e->serialize();
+    Frame& frame = _frames[dst];
+    size_t length = payload.size()+1;
+    size_t needed = length+(length < 0x80 ? 1 : 5);
+    if (frame.count == 0 && !dst.empty()) {
+        _pending.push_back(dst);
+    } else if (frame.count > 0 && frame.data.size()+needed > _frameSize) {
+        flush(dst);
+    }
+    
+    if (frame.count == 0) {
+        frame.data.clear();
+        frame.data.push_back(std::byte(0));
+        Uint64 time = Application::get()->getFixedCount()-_startGameTimeStamp;
+        for (int ii = sizeof(Uint64)-1; ii >= 0; ii--) {
+            frame.data.push_back(std::byte((time >> (8*ii)) & 0xff));
+        }
+    }
+    
+    write_varint(frame.data, length);
+    frame.data.push_back((std::byte)getType(*e));
+    frame.data.insert(frame.data.end(), payload.begin(), payload.end());
+    frame.count++;
+}
+
+/**
+ * Sends the frame for the given destination, if it has any events.
+ *
+ * The frame is compressed if it is at least {@link #getCompressionThreshold}
+ * bytes and compression makes it smaller. The frame buffer is retained.
+ *
+ * @param dst   The destination UUID (empty for broadcast)
+ */
+void NetEventController::flush(const std::string& dst) {
+    auto it = _frames.find(dst);
+    if (it == _frames.end() || it->second.count == 0) {
+        return;
+    }
+    
+    Frame& frame = it->second;
+    const std::vector<std::byte>* message = &(frame.data);
+    if (_compressSize > 0 && frame.data.size() >= _compressSize) {
+        _packed.clear();
+        _packed.push_back(std::byte(FRAME_COMPRESSED));
+        compress_zeroes(frame.data.data()+1, frame.data.size()-1, _packed);
+        if (_packed.size() < frame.data.size()) {
+            message = &_packed;
+        }
+    }
+    
+    if (dst.empty()) {
+        _network->broadcast(*message);
+    } else {
+        _network->sendTo(dst, *message);
+    }
+    frame.data.clear();
+    frame.count = 0;
 }
 
 /**
@@ -394,10 +614,7 @@ const std::vector<std::byte> NetEventController::wrap(const std::shared_ptr<NetE
 void NetEventController::processReceivedData(){
     _network->receive([this](const std::string source,
         const std::vector<std::byte>& data) {
-        //if (cugl::net::NetworkLayer::get()->isDebug()) {
-        //    CULog("DATA %d, CUR STATE %d, SOURCE %s", data[0], _status, source.c_str());
-        //}
-        processReceivedEvent(unwrap(data, source));
+        unwrap(data, source);
     });
 }
 
@@ -495,7 +712,9 @@ bool NetEventController::checkConnection() {
                 if (debug) {
                     CULog("NET PHYSICS: Player '%s'", (*it).c_str());
                 }
-                _network->sendTo((*it), wrap(GameStateEvent::allocUIDAssign(shortUID++)));
+                auto e = GameStateEvent::allocUIDAssign(shortUID++);
+                e->setDestination(*it);
+                pushOutEvent(e);
             }
         }
         return true;
@@ -519,19 +738,22 @@ bool NetEventController::checkConnection() {
 }
 
 /**
- * Broadcasts all queued outbound events.
+ * Sends all queued outbound events.
+ *
+ * Events are coalesced into one frame per destination, so that a single
+ * message is sent to each peer per update (unless the frame would exceed
+ * {@link #getMaxFrameSize}).
  */
 void NetEventController::sendQueuedOutData(){
-    int msgCount = 0;
-    int byteCount = 0;
     for(auto it = _outEventQueue.begin(); it != _outEventQueue.end(); it++){
-        auto e = *(it);
-        auto wrapped = wrap(e);
-        msgCount++;
-        byteCount += wrapped.size();
-        //CULog("flag: %x", (std::byte)getType(*e))
-        _network->broadcast(wrap(e));
+        wrap(*it);
     }
     _outEventQueue.clear();
+    
+    flush("");
+    for (auto it = _pending.begin(); it != _pending.end(); ++it) {
+        flush(*it);
+    }
+    _pending.clear();
 }
 
@@ -0,0 +1,379 @@
+//
+//  CUNetInterest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides interest management (area-of-interest filtering) for
+//  networked physics. By default, every shared obstacle is synchronized with
+//  every peer. In a large world, most of those obstacles are far away from
+//  the player on that peer. This module places the shared obstacles in a
+//  spatial grid, and computes the obstacles relevant to each peer from an
+//  area of interest. Physics synchronization is then sent to each peer
+//  individually, so that the traffic to a peer scales with the number of
+//  obstacles near it, and not the size of the world.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#include <cugl/physics2/distrib/CUNetInterest.h>
+#include <cugl/physics2/distrib/CUNetWorld.h>
+#include <cugl/core/util/CUDebug.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace cugl;
+using namespace cugl::physics2;
+using namespace cugl::physics2::distrib;
+
+/** The bias to make signed grid coordinates sort as unsigned */
+#define GRID_BIAS   0x80000000u
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates a new degenerate interest manager on the stack.
+ *
+ * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
+ * the heap, use one of the static constructors instead.
+ */
+NetInterest::NetInterest() :
+_cellSize(0) {
+}
+
+/**
+ * Disposes all of the resources used by this interest manager.
+ *
+ * A disposed manager can be safely reinitialized.
+ */
+void NetInterest::dispose() {
+    _cellSize = 0;
+    _entries.clear();
+    _regions.clear();
+    _peers.clear();
+    _anchors.clear();
+}
+
+/**
+ * Initializes an interest manager with the given grid cell size.
+ *
+ * The cell size should be comparable to the size of a typical area of
+ * interest. Smaller cells make queries more precise, but require more
+ * binary searches per query.
+ *
+ * @param cellSize  The size of a (square) grid cell in physics units
+ *
+ * @return true if initialization was successful.
+ */
+bool NetInterest::init(float cellSize) {
+    CUAssertLog(cellSize > 0, "Cell size must be positive");
+    _cellSize = cellSize;
+    return true;
+}
+
+#pragma mark -
+#pragma mark Areas of Interest
+/**
+ * Sets the area of interest of a peer to a fixed rectangle.
+ *
+ * The relevancy set of the peer is not updated until the next call to
+ * {@link #update} or {@link #build}.
+ *
+ * @param peer      The peer UUID
+ * @param region    The area of interest
+ */
+void NetInterest::setInterest(const std::string peer, const Rect region) {
+    if (!hasInterest(peer)) {
+        _peers.push_back(peer);
+    }
+    Region& data = _regions[peer];
+    detach(data);
+    data.bounds = region;
+}
+
+/**
+ * Sets the area of interest of a peer to follow an obstacle.
+ *
+ * The area of interest is a rectangle of the given size centered on the
+ * position of the obstacle. It is typically the obstacle representing the
+ * player on that peer. If the obstacle is not in the grid, the area of
+ * interest does not move.
+ *
+ * The relevancy set of the peer is not updated until the next call to
+ * {@link #update} or {@link #build}.
+ *
+ * @param peer      The peer UUID
+ * @param anchor    The id of the obstacle to follow
+ * @param size      The size of the area of interest
+ */
+void NetInterest::setInterest(const std::string peer, Uint64 anchor, const Size size) {
+    if (!hasInterest(peer)) {
+        _peers.push_back(peer);
+    }
+    Region& data = _regions[peer];
+    detach(data);
+    data.bounds.size = size;
+    data.anchor = anchor;
+    data.anchored = true;
+    _anchors[anchor].users++;
+}
+
+/**
+ * Removes the area of interest of a peer.
+ *
+ * The peer will no longer receive physics synchronization. This should be
+ * called when a peer disconnects.
+ *
+ * @param peer  The peer UUID
+ */
+void NetInterest::removeInterest(const std::string peer) {
+    auto it = _regions.find(peer);
+    if (it != _regions.end()) {
+        detach(it->second);
+        _regions.erase(it);
+        _peers.erase(std::find(_peers.begin(), _peers.end(), peer));
+    }
+}
+
+/**
+ * Detaches the area of interest of a peer from its anchor (if any)
+ *
+ * The anchor is forgotten once no area of interest follows it.
+ *
+ * @param region    The area of interest
+ */
+void NetInterest::detach(Region& region) {
+    if (!region.anchored) {
+        return;
+    }
+    auto it = _anchors.find(region.anchor);
+    if (it != _anchors.end() && --(it->second.users) == 0) {
+        _anchors.erase(it);
+    }
+    region.anchored = false;
+}
+
+/**
+ * Returns the current area of interest of a peer.
+ *
+ * If the area follows an obstacle, this is the area as of the last
+ * update. If the peer has no area of interest, this returns the empty
+ * rectangle.
+ *
+ * @param peer  The peer UUID
+ *
+ * @return the current area of interest of a peer.
+ */
+Rect NetInterest::getInterest(const std::string peer) const {
+    auto it = _regions.find(peer);
+    return it == _regions.end() ? Rect::ZERO : it->second.bounds;
+}
+
+/**
+ * Returns the relevancy set of a peer.
+ *
+ * This is the ids of the obstacles in the area of interest of the peer,
+ * as of the last update. The ids are sorted. If the peer has no area
+ * of interest, this set is empty.
+ *
+ * @param peer  The peer UUID
+ *
+ * @return the relevancy set of a peer.
+ */
+const std::vector<Uint64>& NetInterest::getRelevant(const std::string peer) const {
+    static const std::vector<Uint64> empty;
+    auto it = _regions.find(peer);
+    return it == _regions.end() ? empty : it->second.relevant;
+}
+
+/**
+ * Returns true if the obstacle is in the relevancy set of a peer.
+ *
+ * @param peer  The peer UUID
+ * @param id    The obstacle id
+ *
+ * @return true if the obstacle is in the relevancy set of a peer.
+ */
+bool NetInterest::isRelevant(const std::string peer, Uint64 id) const {
+    const std::vector<Uint64>& relevant = getRelevant(peer);
+    return std::binary_search(relevant.begin(), relevant.end(), id);
+}
+
+#pragma mark -
+#pragma mark Spatial Grid
+/**
+ * Returns the grid coordinate for the given world coordinate
+ *
+ * @param value The world coordinate
+ *
+ * @return the grid coordinate for the given world coordinate
+ */
+Sint32 NetInterest::getCoord(float value) const {
+    double coord = std::floor((double)value/_cellSize);
+    if (std::isnan(coord)) {
+        return 0;
+    }
+    coord = std::max(coord, (double)SDL_MIN_SINT32);
+    coord = std::min(coord, (double)SDL_MAX_SINT32);
+    return (Sint32)coord;
+}
+
+/**
+ * Returns the (order preserving) key for the given grid cell
+ *
+ * @param x The grid column
+ * @param y The grid row
+ *
+ * @return the (order preserving) key for the given grid cell
+ */
+Uint64 NetInterest::getCell(Sint32 x, Sint32 y) {
+    return ((Uint64)((Uint32)y ^ GRID_BIAS) << 32) | ((Uint32)x ^ GRID_BIAS);
+}
+
+/**
+ * Rebuilds the grid and relevancy sets from the given world.
+ *
+ * Only shared obstacles are placed in the grid. This method is called
+ * by {@link NetPhysicsController} before each synchronization.
+ *
+ * @param world The networked physics world
+ */
+void NetInterest::update(const std::shared_ptr<NetWorld>& world) {
+    clear();
+    const auto& objmap = world->getObstacleMap();
+    _entries.reserve(objmap.size());
+    for (auto it = objmap.begin(); it != objmap.end(); it++) {
+        if ((*it).second->isShared()) {
+            insert((*it).first, (*it).second->getPosition());
+        }
+    }
+    build();
+}
+
+/**
+ * Removes all obstacles from the grid.
+ *
+ * This method (together with {@link #insert} and {@link #build}) allows
+ * the grid to be built from positions other than those of a
+ * {@link NetWorld}, such as predicted positions.
+ */
+void NetInterest::clear() {
+    _entries.clear();
+    for (auto it = _anchors.begin(); it != _anchors.end(); it++) {
+        it->second.found = false;
+    }
+}
+
+/**
+ * Adds an obstacle position to the grid.
+ *
+ * The grid is not valid until the next call to {@link #build}.
+ *
+ * @param id        The obstacle id
+ * @param position  The obstacle position
+ */
+void NetInterest::insert(Uint64 id, const Vec2 position) {
+    Entry entry;
+    entry.cell = getCell(getCoord(position.x), getCoord(position.y));
+    entry.id = id;
+    entry.position = position;
+    _entries.push_back(entry);
+    if (!_anchors.empty()) {
+        auto it = _anchors.find(id);
+        if (it != _anchors.end()) {
+            it->second.position = position;
+            it->second.found = true;
+        }
+    }
+}
+
+/**
+ * Sorts the grid and recomputes the relevancy set of every peer.
+ */
+void NetInterest::build() {
+    std::sort(_entries.begin(), _entries.end(), [](const Entry& a, const Entry& b) {
+        return a.cell < b.cell;
+    });
+    for (auto it = _regions.begin(); it != _regions.end(); it++) {
+        Region& region = (*it).second;
+        if (region.anchored) {
+            const Anchor& anchor = _anchors.at(region.anchor);
+            if (anchor.found) {
+                region.bounds.origin = anchor.position-region.bounds.size/2;
+            }
+        }
+        region.relevant.clear();
+        query(region.bounds, region.relevant);
+        std::sort(region.relevant.begin(), region.relevant.end());
+    }
+}
+
+/**
+ * Appends the ids of the obstacles in the given region to result.
+ *
+ * An obstacle is in the region if its position is. The ids are appended
+ * in grid order, not id order. This method requires that the grid has
+ * been built.
+ *
+ * @param region    The region to query
+ * @param result    The vector to store the result
+ */
+void NetInterest::query(const Rect region, std::vector<Uint64>& result) const {
+    if (_entries.empty()) {
+        return;
+    }
+    Sint32 x0 = getCoord(region.getMinX());
+    Sint32 x1 = getCoord(region.getMaxX());
+    Sint32 y0 = getCoord(region.getMinY());
+    Sint32 y1 = getCoord(region.getMaxY());
+
+    // A very tall region is cheaper to scan than to search
+    if ((Uint64)((Sint64)y1-y0+1) >= _entries.size()) {
+        for (auto it = _entries.begin(); it != _entries.end(); it++) {
+            if (region.contains((*it).position)) {
+                result.push_back((*it).id);
+            }
+        }
+        return;
+    }
+
+    auto compare = [](const Entry& a, Uint64 cell) { return a.cell < cell; };
+    for (Sint64 row = y0; row <= y1; row++) {
+        Uint64 first = getCell(x0, (Sint32)row);
+        Uint64 last  = getCell(x1, (Sint32)row);
+        auto it = std::lower_bound(_entries.begin(), _entries.end(), first, compare);
+        for (; it != _entries.end() && (*it).cell <= last; it++) {
+            if (region.contains((*it).position)) {
+                result.push_back((*it).id);
+            }
+        }
+    }
+}
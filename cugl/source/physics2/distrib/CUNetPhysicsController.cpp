@@ -42,7 +42,16 @@
 #include <cugl/physics2/distrib/CUNetWorld.h>
 #include <cugl/physics2/distrib/CUNetPhysicsController.h>
 #include <cugl/physics2/distrib/CULWSerializer.h>
+#include <algorithm>
 
+/** The default number of objects in a prioritized synchronization */
+#define PRIO_SYNC_LIMIT         80
+/** The priority gained per unit of linear speed */
+#define PRIO_VELOCITY_WEIGHT    1.0f
+/** The priority gained per unit of angular speed */
+#define PRIO_ANGULAR_WEIGHT     1.0f
+/** The priority multiplier for objects owned by this world */
+#define PRIO_OWNER_WEIGHT       2.0f
 
 using namespace cugl;
 using namespace cugl::physics2;
@@ -74,7 +83,10 @@ _itprCount(0),
 _ovrdCount(0),
 _stepSum(0),
 _objRotation(0),
-_isHost(false) {
+_isHost(false),
+_syncLimit(PRIO_SYNC_LIMIT),
+_rollbackTick(0),
+_rollbackPending(false) {
 }
 
 
@@ -104,6 +116,7 @@ bool NetPhysicsController::init(std::shared_ptr<NetWorld>& world, Uint32 shortUI
     //_world->setshortUID(shortUID);
     _linkSceneToObsFunc = linkFunc;
     _isHost = isHost;
+    _syncBaseline = PhysSyncEvent::Baseline::alloc();
     return true;
 }
 
@@ -119,6 +132,10 @@ void NetPhysicsController::dispose() {
     _world = nullptr;
     _isHost = false;
     _linkSceneToObsFunc = nullptr;
+    _syncBaseline = nullptr;
+    _interest = nullptr;
+    _rollback = nullptr;
+    _rollbackStep = nullptr;
 }
 
 #pragma mark Object Management
@@ -505,6 +522,7 @@ void NetPhysicsController::processPhysSyncEvent(const std::shared_ptr<PhysSyncEv
         return; // Ignore physic syncs from self.
     }
     const std::vector<PhysSyncEvent::Parameters>& params = event->getSyncList();
+    Uint64 tick = event->getEventTimeStamp();
     for (auto it = params.begin(); it != params.end(); it++) {
         PhysSyncEvent::Parameters param = (*it);
         
@@ -514,6 +532,11 @@ void NetPhysicsController::processPhysSyncEvent(const std::shared_ptr<PhysSyncEv
             // Ugh
             continue;
         }
+        
+        // Replay the correction if we still have that tick
+        if (correctSnapshot(tick, param)) {
+            continue;
+        }
             
         float x = param.x;
         float y = param.y;
@@ -541,6 +564,42 @@ void NetPhysicsController::processPhysSyncEvent(const std::shared_ptr<PhysSyncEv
     }
 }
 
+/**
+ * Accumulates the synchronization priority of every shared obstacle.
+ *
+ * This method stores the (weighted) priority of each shared obstacle in
+ * {@link #_syncQueue}. It does not reset any priorities.
+ */
+void NetPhysicsController::accumulateSyncPriority() {
+    // Accumulate priority for every shared obstacle
+    const auto& objmap = _world->getObstacleMap();
+    const auto& ownership = _world->getOwnedObstacles();
+    _syncQueue.clear();
+    for (auto it = objmap.begin(); it != objmap.end(); it++) {
+        const std::shared_ptr<Obstacle>& obj = (*it).second;
+        if (!obj->isShared()) {
+            continue;
+        }
+        float& priority = _syncPriority[(*it).first];
+        priority += 1.0f+PRIO_VELOCITY_WEIGHT*obj->getLinearVelocity().length();
+        priority += PRIO_ANGULAR_WEIGHT*std::abs(obj->getAngularVelocity());
+        float weight = ownership.count(obj) ? PRIO_OWNER_WEIGHT : 1.0f;
+        _syncQueue.push_back(std::make_pair(priority*weight,(*it).first));
+    }
+
+    // Drop the priorities of removed (or unshared) obstacles
+    if (_syncPriority.size() > _syncQueue.size()) {
+        for (auto it = _syncPriority.begin(); it != _syncPriority.end(); ) {
+            auto jt = objmap.find((*it).first);
+            if (jt == objmap.end() || !(*jt).second->isShared()) {
+                it = _syncPriority.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+}
+
 /**
  * Packs object data for synchronization.
  *
@@ -551,10 +610,19 @@ void NetPhysicsController::processPhysSyncEvent(const std::shared_ptr<PhysSyncEv
  * objects. It is called automatically by {@link NetEventController}, but
  * additional calls to it can help fix potential desyncing.
  *
+ * If there is an area-of-interest manager, this method creates an event
+ * for each peer instead. See {@link #setInterest}.
+ *
  * @param type  the type of synchronization
  */
 void NetPhysicsController::packPhysSync(SyncType type) {
+    if (_interest) {
+        packInterestSync(type);
+        return;
+    }
+    
     auto event = PhysSyncEvent::alloc();
+    event->setBaseline(_syncBaseline);
     
     switch (type) {
         case SyncType::OVERRIDE_FULL_SYNC:
@@ -568,48 +636,34 @@ void NetPhysicsController::packPhysSync(SyncType type) {
             break;
         case SyncType::FULL_SYNC:
         {
-            auto ownership = _world->getOwnedObstacles();
-            for (auto it = _world->getObstacleMap().begin(); it != _world->getObstacleMap().end(); it++) {
-                Uint64 id = (*it).first;
-                auto obj = (*it).second;
-                if (obj->isShared() && ownership.count(obj))
-                    event->addObstacle(id,obj);
+            const auto& ids = _world->getObstacleIds();
+            const auto& ownership = _world->getOwnedObstacles();
+            for (auto it = ownership.begin(); it != ownership.end(); it++) {
+                const std::shared_ptr<Obstacle>& obj = (*it).first;
+                auto jt = ids.find(obj);
+                if (obj->isShared() && jt != ids.end()) {
+                    event->addObstacle((*jt).second,obj);
+                }
             }
         }
             break;
         case SyncType::PRIO_SYNC:
         {
-            std::vector<Uint64> velQueue;
-            auto objmap = _world->getObstacleMap();
-            for (auto it = objmap.begin(); it != objmap.end(); it++) {
-                Uint64 id = (*it).first;
-                auto obj = (*it).second;
-                if(obj->isShared()) {
-                    velQueue.push_back(id);
-                }
-            }
-            
-            std::sort(velQueue.begin(), velQueue.end(), [this](Uint64 const& l, Uint64 const& r) {
-                auto omap = _world->getObstacleMap();
-                return omap.at(l)->getLinearVelocity().length() > omap.at(r)->getLinearVelocity().length();
-            });
-            
-            size_t defaultPri = 60;
-            size_t numPrioObj = std::min(defaultPri,velQueue.size());
+            accumulateSyncPriority();
             
-            
-            for (size_t ii = 0; ii < numPrioObj; ii++) {
-                auto obj = objmap.at(velQueue[ii]);
-                if(obj->isShared()) {
-                    event->addObstacle(velQueue[ii],obj);
-                }
+            // Select the highest priorities (in no particular order)
+            const auto& objmap = _world->getObstacleMap();
+            size_t limit = std::min(_syncLimit,_syncQueue.size());
+            if (limit < _syncQueue.size()) {
+                std::nth_element(_syncQueue.begin(), _syncQueue.begin()+limit, _syncQueue.end(),
+                                 [](const std::pair<float,Uint64>& a, const std::pair<float,Uint64>& b) {
+                    return a.first > b.first;
+                });
             }
-            
-            defaultPri = 20;
-            for (size_t ii = 0; ii < std::min(defaultPri,velQueue.size()); ii++) {
-                // Refactored as obstacles are no longer a vector
-                auto obj = _world->getNextObstacle();
-                event->addObstacle(_world->getObstacleId(obj),obj);
+            for (size_t ii = 0; ii < limit; ii++) {
+                Uint64 id = _syncQueue[ii].second;
+                event->addObstacle(id,objmap.at(id));
+                _syncPriority[id] = 0;
             }
         }
             break;
@@ -618,6 +672,100 @@ void NetPhysicsController::packPhysSync(SyncType type) {
     _outEvents.push_back(event);
 }
 
+/**
+ * Forgets all synchronization state for a disconnected peer.
+ *
+ * This removes the area of interest of the peer (if any), and erases
+ * the delta encoding history to and from that peer. It is called by
+ * {@link NetEventController} when a peer leaves the game.
+ *
+ * @param peer  The peer UUID
+ */
+void NetPhysicsController::removePeer(const std::string peer) {
+    if (_interest) {
+        _interest->removeInterest(peer);
+    }
+    if (_syncBaseline) {
+        _syncBaseline->removePeer(peer);
+    }
+}
+
+/**
+ * Packs object data for synchronization with each peer.
+ *
+ * This method is used instead of {@link #packPhysSync} when there is an
+ * area-of-interest manager. It creates a separate event for each peer
+ * with an area of interest, containing only relevant obstacles.
+ *
+ * @param type  the type of synchronization
+ */
+void NetPhysicsController::packInterestSync(SyncType type) {
+    _interest->update(_world);
+    if (type == SyncType::PRIO_SYNC) {
+        accumulateSyncPriority();
+    }
+    
+    const auto& objmap = _world->getObstacleMap();
+    const auto& ownership = _world->getOwnedObstacles();
+    const std::vector<std::string>& peers = _interest->getPeers();
+    _syncSent.clear();
+    for (auto it = peers.begin(); it != peers.end(); it++) {
+        auto event = PhysSyncEvent::alloc();
+        event->setBaseline(_syncBaseline);
+        event->setDestination(*it);
+        
+        // The grid only contains shared obstacles
+        const std::vector<Uint64>& relevant = _interest->getRelevant(*it);
+        _syncBaseline->retain(*it, relevant);
+        switch (type) {
+            case SyncType::OVERRIDE_FULL_SYNC:
+                for (auto jt = relevant.begin(); jt != relevant.end(); jt++) {
+                    event->addObstacle(*jt,objmap.at(*jt));
+                }
+                break;
+            case SyncType::FULL_SYNC:
+                for (auto jt = relevant.begin(); jt != relevant.end(); jt++) {
+                    const std::shared_ptr<Obstacle>& obj = objmap.at(*jt);
+                    if (ownership.count(obj)) {
+                        event->addObstacle(*jt,obj);
+                    }
+                }
+                break;
+            case SyncType::PRIO_SYNC:
+            {
+                _syncQueue.clear();
+                for (auto jt = relevant.begin(); jt != relevant.end(); jt++) {
+                    const std::shared_ptr<Obstacle>& obj = objmap.at(*jt);
+                    float weight = ownership.count(obj) ? PRIO_OWNER_WEIGHT : 1.0f;
+                    _syncQueue.push_back(std::make_pair(_syncPriority[*jt]*weight,*jt));
+                }
+                size_t limit = std::min(_syncLimit,_syncQueue.size());
+                if (limit < _syncQueue.size()) {
+                    std::nth_element(_syncQueue.begin(), _syncQueue.begin()+limit, _syncQueue.end(),
+                                     [](const std::pair<float,Uint64>& a, const std::pair<float,Uint64>& b) {
+                        return a.first > b.first;
+                    });
+                }
+                for (size_t ii = 0; ii < limit; ii++) {
+                    Uint64 id = _syncQueue[ii].second;
+                    event->addObstacle(id,objmap.at(id));
+                    _syncSent.push_back(id);
+                }
+            }
+                break;
+        }
+        
+        if (!event->getSyncList().empty()) {
+            _outEvents.push_back(event);
+        }
+    }
+    
+    // Reset priorities only after every peer has chosen
+    for (auto it = _syncSent.begin(); it != _syncSent.end(); it++) {
+        _syncPriority[*it] = 0;
+    }
+}
+
 /**
  * Packs any changed object information
  *
@@ -688,4 +836,102 @@ void NetPhysicsController::reset() {
     _deleteCache.clear();
     _outEvents.clear();
     _sharedObsToNodeMap.clear();
+    _syncPriority.clear();
+    _syncQueue.clear();
+    _syncSent.clear();
+    if (_syncBaseline) {
+        _syncBaseline->reset();
+    }
+    _rollbackPending = false;
+}
+
+#pragma mark Rollback
+/**
+ * Sets the snapshot history for rollback corrections.
+ *
+ * When a history is attached, a physics synchronization from another
+ * peer is written into the snapshot for the tick at which it was sent
+ * (see {@link #correctSnapshot}). The next call to {@link #applyRollback}
+ * restores the earliest corrected tick and replays the world to the
+ * current tick with the given step function. Synchronizations too old
+ * for the history are interpolated as before.
+ *
+ * The application must save a snapshot of every tick (with
+ * {@link NetRollback#save}) just before stepping the world. The step
+ * function should apply the inputs of the given tick and step the world
+ * once, just as the application does.
+ *
+ * @param rollback  The snapshot history for rollback corrections
+ * @param step      The function to resimulate a single tick
+ */
+void NetPhysicsController::setRollback(const std::shared_ptr<NetRollback>& rollback,
+                                       const std::function<void(Uint64 tick)>& step) {
+    CUAssertLog(rollback == nullptr || step != nullptr, "A rollback requires a step function");
+    _rollback = rollback;
+    _rollbackStep = step;
+    _rollbackPending = false;
+}
+
+/**
+ * Corrects the state of an obstacle at an earlier tick.
+ *
+ * The correction is written into the rollback snapshot for that tick,
+ * and any interpolation of the obstacle is cancelled. The world is not
+ * changed until the next call to {@link #applyRollback}. This method
+ * returns false if there is no rollback history, or if the history does
+ * not have this obstacle at this tick. In that case the caller should
+ * fall back to interpolation.
+ *
+ * @param tick  The tick of the corrected state
+ * @param param The corrected obstacle state
+ *
+ * @return true if the correction was recorded.
+ */
+bool NetPhysicsController::correctSnapshot(Uint64 tick, const PhysSyncEvent::Parameters& param) {
+    if (_rollback == nullptr) {
+        return false;
+    }
+    NetRollback::State state;
+    state.id = param.obsId;
+    state.x = param.x;
+    state.y = param.y;
+    state.angle = param.angle;
+    state.vx = param.vx;
+    state.vy = param.vy;
+    state.omega = param.vAngular;
+    state.flags = NetRollback::AWAKE;
+    state.reserved = 0;
+    if (!_rollback->correct(tick, state)) {
+        return false;
+    }
+
+    auto obj = _world->getObstacle(param.obsId);
+    if (obj != nullptr) {
+        _cache.erase(obj);
+    }
+    if (!_rollbackPending || tick < _rollbackTick) {
+        _rollbackTick = tick;
+    }
+    _rollbackPending = true;
+    return true;
+}
+
+/**
+ * Replays the world from the earliest corrected tick to the current one.
+ *
+ * This method does nothing if no snapshot has been corrected since the
+ * last rollback. It is called by {@link NetEventController} after the
+ * incoming events are processed. The current tick is the next tick to
+ * be simulated, whose snapshot has not been saved yet.
+ *
+ * @param current   The current simulation tick
+ *
+ * @return true if the world was rolled back and replayed.
+ */
+bool NetPhysicsController::applyRollback(Uint64 current) {
+    if (!_rollbackPending || _rollback == nullptr) {
+        return false;
+    }
+    _rollbackPending = false;
+    return _rollback->resimulate(_rollbackTick, current, _rollbackStep);
 }
@@ -0,0 +1,419 @@
+//
+//  CUNetRollback.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This module provides state snapshots for networked physics. By default,
+//  networked physics only moves forward: peers send their state, and the
+//  receivers interpolate towards it. Rollback netcode and client-side
+//  prediction instead need to save the state of the world every tick, and
+//  restore an earlier state when a correction arrives. This module keeps a
+//  ring of recent snapshots of the shared obstacles, each stored as a flat
+//  array of plain data, and supports restoring and resimulating from them.
+//
+//  This class uses our standard shared-pointer architecture.
+//
+//  1. The constructor does not perform any initialization; it just sets all
+//     attributes to their defaults.
+//
+//  2. All initialization takes place via init methods, which can fail if an
+//     object is initialized more than once.
+//
+//  3. All allocation takes place via static constructors which return a shared
+//     pointer.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#include <cugl/physics2/distrib/CUNetRollback.h>
+#include <cugl/physics2/distrib/CUNetWorld.h>
+#include <cugl/core/util/CUDebug.h>
+#include <box2d/b2_body.h>
+#include <box2d/b2_contact.h>
+#include <box2d/b2_world.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace cugl;
+using namespace cugl::physics2;
+using namespace cugl::physics2::distrib;
+
+/** The FNV-1a offset basis for checksums */
+#define CHECKSUM_BASIS  0xcbf29ce484222325ull
+/** The FNV-1a prime for checksums */
+#define CHECKSUM_PRIME  0x100000001b3ull
+
+/**
+ * Returns true if the first contact comes before the second
+ *
+ * Contacts are ordered by their fixtures and child shapes, so that a
+ * restore can find them with a binary search.
+ *
+ * @param fa    The first fixture of the first contact
+ * @param ca    The first child shape of the first contact
+ * @param fb    The second fixture of the first contact
+ * @param cb    The second child shape of the first contact
+ * @param ga    The first fixture of the second contact
+ * @param da    The first child shape of the second contact
+ * @param gb    The second fixture of the second contact
+ * @param db    The second child shape of the second contact
+ *
+ * @return true if the first contact comes before the second
+ */
+static bool contact_less(const b2Fixture* fa, Sint32 ca, const b2Fixture* fb, Sint32 cb,
+                         const b2Fixture* ga, Sint32 da, const b2Fixture* gb, Sint32 db) {
+    std::less<const b2Fixture*> less;
+    if (fa != ga) {
+        return less(fa,ga);
+    } else if (fb != gb) {
+        return less(fb,gb);
+    } else if (ca != da) {
+        return ca < da;
+    }
+    return cb < db;
+}
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Disposes all of the resources used by this snapshot history.
+ *
+ * A disposed history can be safely reinitialized.
+ */
+void NetRollback::dispose() {
+    _world = nullptr;
+    _ring.clear();
+}
+
+/**
+ * Initializes a snapshot history for the given world.
+ *
+ * The capacity is the number of ticks that can be rolled back. It
+ * should cover the worst round trip time expected, in ticks.
+ *
+ * @param world     The networked physics world
+ * @param capacity  The number of snapshots to keep
+ *
+ * @return true if initialization was successful.
+ */
+bool NetRollback::init(const std::shared_ptr<NetWorld>& world, Uint32 capacity) {
+    CUAssertLog(world != nullptr, "The world cannot be null");
+    CUAssertLog(capacity > 0, "Capacity must be positive");
+    _world = world;
+    _ring.resize(capacity);
+    return true;
+}
+
+#pragma mark -
+#pragma mark Snapshots
+/**
+ * Returns the snapshot for the given tick
+ *
+ * @param tick  The simulation tick
+ *
+ * @return the snapshot for the given tick (nullptr if not saved)
+ */
+const NetRollback::Snapshot* NetRollback::find(Uint64 tick) const {
+    if (_ring.empty()) {
+        return nullptr;
+    }
+    const Snapshot* snap = &_ring[tick % _ring.size()];
+    return (snap->valid && snap->tick == tick) ? snap : nullptr;
+}
+
+/**
+ * Saves the warm-starting impulses of the touching contacts
+ *
+ * @param snap  The snapshot to save to
+ */
+void NetRollback::saveContacts(Snapshot& snap) {
+    snap.contacts.clear();
+    for (b2Contact* c = _world->getWorld()->GetContactList(); c; c = c->GetNext()) {
+        const b2Manifold* manifold = c->GetManifold();
+        if (!c->IsTouching() || manifold->pointCount == 0) {
+            continue;
+        }
+        
+        Contact contact;
+        contact.fixtureA = c->GetFixtureA();
+        contact.fixtureB = c->GetFixtureB();
+        contact.childA = c->GetChildIndexA();
+        contact.childB = c->GetChildIndexB();
+        contact.count  = manifold->pointCount;
+        for (int ii = 0; ii < 2; ii++) {
+            bool used = ii < manifold->pointCount;
+            contact.keys[ii] = used ? manifold->points[ii].id.key : 0;
+            contact.normal[ii]  = used ? manifold->points[ii].normalImpulse : 0;
+            contact.tangent[ii] = used ? manifold->points[ii].tangentImpulse : 0;
+        }
+        snap.contacts.push_back(contact);
+    }
+    
+    std::sort(snap.contacts.begin(), snap.contacts.end(), [](const Contact& a, const Contact& b) {
+        return contact_less(a.fixtureA, a.childA, a.fixtureB, a.childB,
+                            b.fixtureA, b.childA, b.fixtureB, b.childB);
+    });
+}
+
+/**
+ * Restores the warm-starting impulses of the contacts
+ *
+ * Contacts that were not touching in the snapshot have their impulses
+ * cleared.
+ *
+ * @param snap  The snapshot to restore from
+ */
+void NetRollback::restoreContacts(const Snapshot& snap) {
+    // A step of zero time creates the contacts of the restored positions and
+    // computes their manifolds, without moving anything.
+    b2World* world = _world->getWorld();
+    world->Step(0, 0, 0);
+    
+    for (b2Contact* c = world->GetContactList(); c; c = c->GetNext()) {
+        b2Manifold* manifold = c->GetManifold();
+        const b2Fixture* fa = c->GetFixtureA();
+        const b2Fixture* fb = c->GetFixtureB();
+        Sint32 ca = c->GetChildIndexA();
+        Sint32 cb = c->GetChildIndexB();
+        auto it = std::lower_bound(snap.contacts.begin(), snap.contacts.end(), c,
+                                   [&](const Contact& a, const b2Contact*) {
+            return contact_less(a.fixtureA, a.childA, a.fixtureB, a.childB, fa, ca, fb, cb);
+        });
+        bool found = (it != snap.contacts.end() && it->fixtureA == fa && it->fixtureB == fb &&
+                      it->childA == ca && it->childB == cb);
+
+        // Match the points by feature, as the next step would
+        for (int ii = 0; ii < manifold->pointCount; ii++) {
+            b2ManifoldPoint* point = &(manifold->points[ii]);
+            point->normalImpulse  = 0;
+            point->tangentImpulse = 0;
+            for (int jj = 0; found && jj < it->count; jj++) {
+                if (it->keys[jj] == point->id.key) {
+                    point->normalImpulse  = it->normal[jj];
+                    point->tangentImpulse = it->tangent[jj];
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Saves the state of the shared obstacles for the given tick.
+ *
+ * This replaces any snapshot in the same slot of the ring. The tick is
+ * typically saved just before the world is stepped.
+ *
+ * @param tick  The simulation tick
+ */
+void NetRollback::save(Uint64 tick) {
+    Snapshot& snap = _ring[tick % _ring.size()];
+    snap.tick  = tick;
+    snap.valid = true;
+    snap.states.clear();
+
+    const auto& objmap = _world->getObstacleMap();
+    for (auto it = objmap.begin(); it != objmap.end(); it++) {
+        Obstacle* obj = (*it).second.get();
+        b2Body* body  = obj->getBody();
+        if (!obj->isShared() || body == nullptr) {
+            continue;
+        }
+
+        State state;
+        const b2Vec2& pos = body->GetPosition();
+        const b2Vec2& vel = body->GetLinearVelocity();
+        state.id = (*it).first;
+        state.x  = pos.x;
+        state.y  = pos.y;
+        state.angle = body->GetAngle();
+        state.vx = vel.x;
+        state.vy = vel.y;
+        state.omega = body->GetAngularVelocity();
+        state.flags = body->IsAwake() ? AWAKE : 0;
+        state.reserved = 0;
+        snap.states.push_back(state);
+    }
+
+    // The obstacle map is unordered, so the order differs between peers
+    std::sort(snap.states.begin(), snap.states.end(), [](const State& a, const State& b) {
+        return a.id < b.id;
+    });
+    saveContacts(snap);
+}
+
+/**
+ * Restores the state of the shared obstacles from the given tick.
+ *
+ * This also restores the warm-starting impulses of the contacts. To do
+ * that, it brings the contacts up to date with the restored positions,
+ * which clears any forces applied since the last step. This method
+ * returns false (and does nothing) if there is no snapshot for this tick.
+ *
+ * @param tick  The simulation tick
+ *
+ * @return true if the state was restored.
+ */
+bool NetRollback::restore(Uint64 tick) {
+    const Snapshot* snap = find(tick);
+    if (snap == nullptr) {
+        return false;
+    }
+
+    // Write to the bodies directly, so that nothing is marked for sync
+    const auto& objmap = _world->getObstacleMap();
+    for (auto it = snap->states.begin(); it != snap->states.end(); it++) {
+        auto jt = objmap.find((*it).id);
+        if (jt == objmap.end()) {
+            continue;
+        }
+        b2Body* body = (*jt).second->getBody();
+        if (body == nullptr) {
+            continue;
+        }
+        body->SetTransform(b2Vec2((*it).x,(*it).y),(*it).angle);
+        body->SetLinearVelocity(b2Vec2((*it).vx,(*it).vy));
+        body->SetAngularVelocity((*it).omega);
+        body->SetAwake((*it).flags & AWAKE);
+    }
+    restoreContacts(*snap);
+    return true;
+}
+
+/**
+ * Returns the obstacle states saved for the given tick.
+ *
+ * The states are sorted by obstacle id. This method returns nullptr if
+ * there is no snapshot for this tick.
+ *
+ * @param tick  The simulation tick
+ *
+ * @return the obstacle states saved for the given tick.
+ */
+const std::vector<NetRollback::State>* NetRollback::getSnapshot(Uint64 tick) const {
+    const Snapshot* snap = find(tick);
+    return snap == nullptr ? nullptr : &(snap->states);
+}
+
+/**
+ * Replaces the snapshot for the given tick.
+ *
+ * This is used to apply a correction, such as an authoritative snapshot
+ * received from another peer. The states must be sorted by obstacle id.
+ * If this tick was saved locally, the contact impulses of that save are
+ * kept. Otherwise, a restore of this tick clears them.
+ *
+ * @param tick      The simulation tick
+ * @param states    The obstacle states
+ * @param count     The number of obstacle states
+ */
+void NetRollback::setSnapshot(Uint64 tick, const State* states, size_t count) {
+    Snapshot& snap = _ring[tick % _ring.size()];
+    if (!snap.valid || snap.tick != tick) {
+        snap.contacts.clear();
+    }
+    snap.tick  = tick;
+    snap.valid = true;
+    snap.states.assign(states, states+count);
+}
+
+/**
+ * Corrects the state of a single obstacle in the given snapshot.
+ *
+ * This is used to apply a correction for one obstacle, such as a
+ * synchronization received from another peer. The correction takes
+ * effect at the next call to {@link #resimulate} from this tick (or an
+ * earlier one). This method returns false (and does nothing) if there
+ * is no snapshot for this tick, or if the obstacle is not in it.
+ *
+ * @param tick  The simulation tick
+ * @param state The corrected obstacle state
+ *
+ * @return true if the snapshot was corrected.
+ */
+bool NetRollback::correct(Uint64 tick, const State& state) {
+    if (find(tick) == nullptr) {
+        return false;
+    }
+    Snapshot& snap = _ring[tick % _ring.size()];
+    auto it = std::lower_bound(snap.states.begin(), snap.states.end(), state.id,
+                               [](const State& a, Uint64 id) { return a.id < id; });
+    if (it == snap.states.end() || (*it).id != state.id) {
+        return false;
+    }
+    *it = state;
+    return true;
+}
+
+/**
+ * Returns a checksum of the snapshot for the given tick.
+ *
+ * Two peers with the same checksum for a tick have (almost surely) the
+ * same state for their shared obstacles. This method returns 0 if there
+ * is no snapshot for this tick.
+ *
+ * @param tick  The simulation tick
+ *
+ * @return a checksum of the snapshot for the given tick.
+ */
+Uint64 NetRollback::getChecksum(Uint64 tick) const {
+    const Snapshot* snap = find(tick);
+    if (snap == nullptr) {
+        return 0;
+    }
+
+    // State has no padding, so we can hash the bytes directly
+    Uint64 hash = CHECKSUM_BASIS;
+    const Uint8* bytes = reinterpret_cast<const Uint8*>(snap->states.data());
+    size_t size = snap->states.size()*sizeof(State);
+    for(size_t ii = 0; ii < size; ii++) {
+        hash = (hash ^ bytes[ii])*CHECKSUM_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Restores the given tick and steps forward to the current tick.
+ *
+ * The step function is called for each tick from the restored tick up
+ * to (but not including) the current tick. It should apply the inputs
+ * of that tick and step the world once. The snapshot of each following
+ * tick is then saved, replacing the one from the original simulation.
+ * This method returns false (and does nothing) if there is no snapshot
+ * for the restored tick.
+ *
+ * @param tick      The tick to restore
+ * @param current   The current simulation tick
+ * @param step      The function to simulate a single tick
+ *
+ * @return true if the world was restored and resimulated.
+ */
+bool NetRollback::resimulate(Uint64 tick, Uint64 current,
+                             const std::function<void(Uint64 tick)>& step) {
+    if (!restore(tick)) {
+        return false;
+    }
+    for(Uint64 ii = tick; ii < current; ii++) {
+        step(ii);
+        save(ii+1);
+    }
+    return true;
+}
@@ -3,7 +3,10 @@
 //  Cornell University Game Library (CUGL)
 //
 //  This module provides events for physics synchronization, which are handled
-//  by the NetEventController internally.
+//  by the NetEventController internally. These events are sent every frame,
+//  so they use a compact encoding: every value is quantized to fixed point,
+//  obstacles are encoded relative to the last state sent for them, and the
+//  result is packed at the bit level.
 //
 //  CUGL MIT License:
 //      This software is provided 'as-is', without any express or implied
@@ -28,11 +31,122 @@
 //  Version: 7/3/24 (CUGL 3.0 reorganization)
 //
 #include <cugl/physics2/distrib/CUPhysSyncEvent.h>
+#include <algorithm>
+#include <cmath>
+#include <bit>
 
 using namespace cugl;
 using namespace cugl::physics2;
 using namespace cugl::physics2::distrib;
 
+/** The largest magnitude of a quantized value */
+#define SYNC_VALUE_LIMIT    ((1 << 29)-1)
+/** The number of bits to encode a fractional bit count or a value width */
+#define SYNC_WIDTH_BITS     5
+/** The number of values in an obstacle snapshot */
+#define SYNC_VALUE_COUNT    6
+
+#pragma mark -
+#pragma mark Encoding Helpers
+/**
+ * Returns the value rounded to a fixed point number with the given precision
+ *
+ * The result is clamped to {@link SYNC_VALUE_LIMIT}, so that the difference
+ * of any two quantized values fits in 31 bits.
+ *
+ * @param value The value to quantize
+ * @param bits  The number of fractional bits
+ *
+ * @return the value rounded to a fixed point number with the given precision
+ */
+static Sint32 quantize(float value, Uint8 bits) {
+    double scaled = std::round(std::ldexp((double)value, bits));
+    if (std::isnan(scaled)) {
+        return 0;
+    } else if (scaled > SYNC_VALUE_LIMIT) {
+        return SYNC_VALUE_LIMIT;
+    } else if (scaled < -SYNC_VALUE_LIMIT) {
+        return -SYNC_VALUE_LIMIT;
+    }
+    return (Sint32)scaled;
+}
+
+/**
+ * Returns the float value of the given fixed point number
+ *
+ * @param value The quantized value
+ * @param bits  The number of fractional bits
+ *
+ * @return the float value of the given fixed point number
+ */
+static float dequantize(Sint32 value, Uint8 bits) {
+    return (float)std::ldexp((double)value, -bits);
+}
+
+/**
+ * Returns the fractional bits for each value of a snapshot
+ *
+ * @param quant The snapshot precision
+ *
+ * @return the fractional bits for each value of a snapshot
+ */
+static std::array<Uint8,SYNC_VALUE_COUNT> get_precision(const PhysSyncEvent::Quantization& quant) {
+    return { quant.position, quant.position, quant.velocity, quant.velocity,
+             quant.angle, quant.angular };
+}
+
+/**
+ * Writes the given snapshot values to the serializer
+ *
+ * The values are zig-zag encoded and written in groups: the position, the
+ * linear velocity, the angle, and the angular velocity. Each group is
+ * prefixed by the bit width of its largest value.
+ *
+ * @param serializer    The serializer to write to
+ * @param values        The snapshot values
+ */
+static void write_values(BitSerializer& serializer,
+                         const std::array<Sint32,SYNC_VALUE_COUNT>& values) {
+    static const size_t groups[] = { 0, 2, 4, 5, SYNC_VALUE_COUNT };
+    std::array<Uint32,SYNC_VALUE_COUNT> coded;
+    for(size_t ii = 0; ii < SYNC_VALUE_COUNT; ii++) {
+        coded[ii] = ((Uint32)values[ii] << 1) ^ (Uint32)(values[ii] >> 31);
+    }
+    for(size_t gg = 0; gg+1 < sizeof(groups)/sizeof(size_t); gg++) {
+        Uint32 bound = 0;
+        for(size_t ii = groups[gg]; ii < groups[gg+1]; ii++) {
+            bound |= coded[ii];
+        }
+        Uint32 width = (Uint32)std::bit_width(bound);
+        serializer.writeBits(width, SYNC_WIDTH_BITS);
+        for(size_t ii = groups[gg]; ii < groups[gg+1]; ii++) {
+            serializer.writeBits(coded[ii], width);
+        }
+    }
+}
+
+/**
+ * Reads snapshot values from the deserializer
+ *
+ * This is the inverse of {@link write_values}.
+ *
+ * @param deserializer  The deserializer to read from
+ * @param values        The array to store the snapshot values
+ */
+static void read_values(BitDeserializer& deserializer,
+                        std::array<Sint32,SYNC_VALUE_COUNT>& values) {
+    static const size_t groups[] = { 0, 2, 4, 5, SYNC_VALUE_COUNT };
+    for(size_t gg = 0; gg+1 < sizeof(groups)/sizeof(size_t); gg++) {
+        Uint32 width = (Uint32)deserializer.readBits(SYNC_WIDTH_BITS);
+        for(size_t ii = groups[gg]; ii < groups[gg+1]; ii++) {
+            Uint32 coded = (Uint32)deserializer.readBits(width);
+            values[ii] = (Sint32)(coded >> 1) ^ -(Sint32)(coded & 1);
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Parameters
 /** Creates a new parameter set with default values */
 PhysSyncEvent::Parameters::Parameters() {
     obsId = 0;
@@ -44,6 +158,93 @@ PhysSyncEvent::Parameters::Parameters() {
     vAngular = 0;
 }
 
+/** Creates a new quantization with default values */
+PhysSyncEvent::Quantization::Quantization() {
+    position = SYNC_POSITION_BITS;
+    velocity = SYNC_VELOCITY_BITS;
+    angle = SYNC_ANGLE_BITS;
+    angular = SYNC_ANGULAR_BITS;
+}
+
+#pragma mark -
+#pragma mark Baseline
+/**
+ * Creates an empty baseline.
+ *
+ * The first outbound event will be a keyframe.
+ */
+PhysSyncEvent::Baseline::Baseline() :
+_keyframeRate(SYNC_KEYFRAME_RATE) {
+}
+
+/**
+ * Clears all history in this baseline.
+ *
+ * The next outbound event will be a keyframe. This should be called
+ * whenever a new session starts.
+ */
+void PhysSyncEvent::Baseline::reset() {
+    _outbound.clear();
+    _inbound.clear();
+}
+
+/**
+ * Removes all history for the given peer.
+ *
+ * Both the outbound history to the peer and the inbound history
+ * from the peer are erased. This should be called when a peer
+ * disconnects. If the peer reconnects, the next outbound event to
+ * it will be a keyframe.
+ *
+ * @param peer  The peer UUID
+ */
+void PhysSyncEvent::Baseline::removePeer(const std::string peer) {
+    _outbound.erase(peer);
+    _inbound.erase(peer);
+}
+
+/**
+ * Removes the outbound history of obstacles no longer sent to a peer.
+ *
+ * Any obstacle in the outbound history to the given destination that
+ * is not in ids is erased. If such an obstacle is sent to this peer
+ * again, it will be sent in full. The ids must be sorted.
+ *
+ * @param peer  The peer UUID
+ * @param ids   The (sorted) obstacles to keep
+ */
+void PhysSyncEvent::Baseline::retain(const std::string peer, const std::vector<Uint64>& ids) {
+    auto it = _outbound.find(peer);
+    if (it == _outbound.end()) {
+        return;
+    }
+    auto& states = it->second.states;
+    for (auto jt = states.begin(); jt != states.end(); ) {
+        if (std::binary_search(ids.begin(), ids.end(), jt->first)) {
+            jt++;
+        } else {
+            jt = states.erase(jt);
+        }
+    }
+}
+
+/**
+ * Sets the fixed point precision for outbound events
+ *
+ * Changing the precision forces the next outbound event to be a
+ * keyframe.
+ *
+ * @param value The fixed point precision for outbound events
+ */
+void PhysSyncEvent::Baseline::setQuantization(const Quantization& value) {
+    _quantization = value;
+    for (auto it = _outbound.begin(); it != _outbound.end(); it++) {
+        it->second.keyframe = true;
+    }
+}
+
+#pragma mark -
+#pragma mark Serialization/Deserialization
 /**
  * Snapshots an obstacle's current position and velocity.
  *
@@ -66,52 +267,156 @@ void PhysSyncEvent::addObstacle(Uint64 id, const std::shared_ptr<physics2::Obsta
     param.angle = obs->getAngle();
     param.vAngular = obs->getAngularVelocity();
     _syncList.push_back(param);
+    _encoded = false;
 }
 
 /**
  * Returns a byte vector serializing the current list of snapshots.
  *
+ * The snapshots are sorted by obstacle id as part of the encoding. If
+ * the event has a baseline, this method updates the outbound history.
+ * Therefore, the encoding is cached, and calling this method again
+ * returns the same bytes (unless more obstacles were added).
+ *
  * @return a byte vector serializing the current list of snapshots.
  */
 std::vector<std::byte> PhysSyncEvent::serialize() {
+    if (_encoded) {
+        return _serializer.serialize();
+    }
+
+    Quantization quant;
+    Baseline::Stream* stream = nullptr;
+    bool keyframe = true;
+    if (_baseline) {
+        stream = &(_baseline->_outbound[getDestination()]);
+        stream->sequence++;
+        quant = _baseline->_quantization;
+        Uint32 rate = _baseline->_keyframeRate;
+        keyframe = stream->keyframe || (rate && stream->sequence % rate == 0);
+        stream->keyframe = false;
+        if (keyframe) {
+            stream->states.clear();
+        }
+    }
+
+    std::sort(_syncList.begin(), _syncList.end(), [](const Parameters& a, const Parameters& b) {
+        return a.obsId < b.obsId;
+    });
+
     _serializer.reset();
-    _serializer.writeUint64((Uint64)_syncList.size());
+    _serializer.writeBits(quant.position, SYNC_WIDTH_BITS);
+    _serializer.writeBits(quant.velocity, SYNC_WIDTH_BITS);
+    _serializer.writeBits(quant.angle, SYNC_WIDTH_BITS);
+    _serializer.writeBits(quant.angular, SYNC_WIDTH_BITS);
+    _serializer.writeBool(keyframe);
+    _serializer.writeVarint(stream ? stream->sequence : 0);
+    _serializer.writeVarint((Uint64)_syncList.size());
+
+    std::array<Uint8,SYNC_VALUE_COUNT> precision = get_precision(quant);
+    std::array<Sint32,SYNC_VALUE_COUNT> values;
+    std::array<Sint32,SYNC_VALUE_COUNT> coded;
+    Uint64 previous = 0;
     for (auto it = _syncList.begin(); it != _syncList.end(); it++) {
-        Parameters& obj = (*it);
-        _serializer.writeUint64(obj.obsId);
-        _serializer.writeFloat(obj.x);
-        _serializer.writeFloat(obj.y);
-        _serializer.writeFloat(obj.vx);
-        _serializer.writeFloat(obj.vy);
-        _serializer.writeFloat(obj.angle);
-        _serializer.writeFloat(obj.vAngular);
+        const Parameters& obj = (*it);
+        _serializer.writeVarint(obj.obsId-previous);
+        previous = obj.obsId;
+
+        const float raw[] = { obj.x, obj.y, obj.vx, obj.vy, obj.angle, obj.vAngular };
+        for(size_t ii = 0; ii < SYNC_VALUE_COUNT; ii++) {
+            values[ii] = quantize(raw[ii],precision[ii]);
+        }
+        coded = values;
+        if (!keyframe) {
+            auto jt = stream->states.find(obj.obsId);
+            bool delta = jt != stream->states.end();
+            if (delta) {
+                for(size_t ii = 0; ii < SYNC_VALUE_COUNT; ii++) {
+                    coded[ii] -= jt->second[ii];
+                }
+            }
+            _serializer.writeBool(delta);
+        }
+        write_values(_serializer, coded);
+        if (stream) {
+            stream->states[obj.obsId] = values;
+        }
     }
+    _encoded = true;
     return _serializer.serialize();
 }
 
 /**
  * Unpacks a byte vector into a list of snapshots.
  *
- * These snapshots can then be used in physics synchronizations.
+ * These snapshots can then be used in physics synchronizations. If the
+ * event has a baseline, the history of the source is used to decode
+ * delta snapshots (and is then updated). Delta snapshots that cannot be
+ * decoded are omitted from the list.
  *
  * @param data the byte vector to deserialize
  */
 void PhysSyncEvent::deserialize(const std::vector<std::byte>& data) {
-    if (data.size() < 4)
-        return;
-    
-    _deserializer.reset();
     _deserializer.receive(data);
-    Uint64 numObjs = _deserializer.readUint64();
-    for (size_t i = 0; i < numObjs; i++) {
+    Quantization quant;
+    quant.position = (Uint8)_deserializer.readBits(SYNC_WIDTH_BITS);
+    quant.velocity = (Uint8)_deserializer.readBits(SYNC_WIDTH_BITS);
+    quant.angle = (Uint8)_deserializer.readBits(SYNC_WIDTH_BITS);
+    quant.angular = (Uint8)_deserializer.readBits(SYNC_WIDTH_BITS);
+    bool keyframe = _deserializer.readBool();
+    Uint32 sequence = (Uint32)_deserializer.readVarint();
+    Uint64 numObjs = _deserializer.readVarint();
+    if (_deserializer.hasOverflow()) {
+        _deserializer.reset();
+        return;
+    }
+
+    // A gap in the sequence means our history no longer matches the sender
+    Baseline::Stream* stream = nullptr;
+    if (_baseline) {
+        stream = &(_baseline->_inbound[getSourceId()]);
+        if (keyframe || sequence != stream->sequence+1) {
+            stream->states.clear();
+        }
+        stream->sequence = sequence;
+    }
+
+    std::array<Uint8,SYNC_VALUE_COUNT> precision = get_precision(quant);
+    std::array<Sint32,SYNC_VALUE_COUNT> values;
+    Uint64 id = 0;
+    for (Uint64 ii = 0; ii < numObjs; ii++) {
+        id += _deserializer.readVarint();
+        bool delta = keyframe ? false : _deserializer.readBool();
+        read_values(_deserializer, values);
+        if (_deserializer.hasOverflow()) {
+            break;
+        }
+
+        if (delta) {
+            if (!stream) {
+                continue;
+            }
+            auto jt = stream->states.find(id);
+            if (jt == stream->states.end()) {
+                continue;
+            }
+            for(size_t kk = 0; kk < SYNC_VALUE_COUNT; kk++) {
+                values[kk] = (Sint32)((Uint32)values[kk]+(Uint32)jt->second[kk]);
+            }
+        }
+        if (stream) {
+            stream->states[id] = values;
+        }
+
         Parameters param;
-        param.obsId = _deserializer.readUint64();
-        param.x = _deserializer.readFloat();
-        param.y = _deserializer.readFloat();
-        param.vx = _deserializer.readFloat();
-        param.vy = _deserializer.readFloat();
-        param.angle = _deserializer.readFloat();
-        param.vAngular = _deserializer.readFloat();
+        param.obsId = id;
+        param.x = dequantize(values[0],precision[0]);
+        param.y = dequantize(values[1],precision[1]);
+        param.vx = dequantize(values[2],precision[2]);
+        param.vy = dequantize(values[3],precision[3]);
+        param.angle = dequantize(values[4],precision[4]);
+        param.vAngular = dequantize(values[5],precision[5]);
         _syncList.push_back(param);
     }
+    _deserializer.reset();
 }
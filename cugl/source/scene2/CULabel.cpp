@@ -484,14 +484,20 @@ const std::string Label::getText() const {
  * font, then the text will not display at all.
  *
  * Changing this value will regenerate the render data, and is potentially
- * expensive, particularly if the font is using a fallback atlas.
+ * expensive, particularly if the font is using a fallback atlas. Setting
+ * the text to its current value does nothing (unless resize is true), so
+ * it is safe to call this method every frame.
  *
  * @param text      The text for this label.
  * @param resize    Whether to resize the label to fit the new text.
  */
 void Label::setText(const std::string text, bool resize) {
-    _layout->setText(text);
-    _layout->layout();
+    if (text != _layout->getText()) {
+        _layout->setText(text);
+        _layout->layout();
+    } else if (!resize) {
+        return;
+    }
     if (resize) {
         this->resize();
     }
@@ -956,6 +962,7 @@ void Label::setDropShadow(float x, float y) {
     if (!_dropShadow && !_dropOffset.isZero()) {
         _dropShadow = true;
     }
+    invalidateBounds();
 }
 
 /**
@@ -981,6 +988,7 @@ void Label::setDropShadow(float x, float y) {
 void Label::setShadowBlur(float blur) {
     _dropBlur = blur;
     _dropShadow = blur > 0 || !_dropOffset.isZero();
+    invalidateBounds();
 }
 
 
@@ -1041,6 +1049,27 @@ void Label::draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2& trans
     }
 }
 
+/**
+ * Returns true if this node has finite drawing bounds, storing them in bounds.
+ *
+ * The text of a label is confined to its content bounds. However, the
+ * drop shadow (if any) is offset from the text and may be blurred, so
+ * the drawing bounds include the shadow as well.
+ *
+ * @param bounds    The rectangle to store the drawing bounds
+ *
+ * @return true if this node has finite drawing bounds
+ */
+bool Label::getDrawBounds(Rect& bounds) {
+    bounds.set(Vec2::ZERO,_contentSize);
+    if (_dropShadow) {
+        Rect shadow(_dropOffset.x-_dropBlur, _dropOffset.y-_dropBlur,
+                    _contentSize.width+2*_dropBlur, _contentSize.height+2*_dropBlur);
+        bounds.merge(shadow);
+    }
+    return true;
+}
+
 /**
  * Allocate the render data necessary to render this node.
  */
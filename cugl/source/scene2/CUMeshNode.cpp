@@ -393,6 +393,7 @@ std::shared_ptr<SceneNode> MeshNode::copy(const std::shared_ptr<SceneNode>& dst)
 void MeshNode::setMesh(const Mesh<SpriteVertex>& mesh) {
     _mesh = mesh;
     _flipFlags = 0;
+    invalidateBounds();
 }
 
 /**
@@ -403,6 +404,7 @@ void MeshNode::setMesh(const Mesh<SpriteVertex>& mesh) {
 void MeshNode::setMesh(graphics::Mesh<graphics::SpriteVertex>&& mesh) {
     _mesh = std::move(mesh);
     _flipFlags = 0;
+    invalidateBounds();
 }
 
 
@@ -431,11 +433,16 @@ const SpriteVertex* MeshNode::getVertex(size_t index) const {
  * color, texture coordinates, or gradient coordinates. If there is
  * not vertex as that index, this method returns nullptr.
  *
+ * As the vertex may be moved, this method marks the cached culling
+ * bounds of this node as dirty.
+ *
  * @param index The sprite index
  *
  * @return a pointer to the sprite vertex as the given index
  */
 SpriteVertex* MeshNode::getVertex(size_t index) {
+    // The caller may move this vertex
+    invalidateBounds();
     if (index < _mesh.vertices.size()) {
         return &(_mesh.vertices.at(index));
     }
@@ -557,6 +564,7 @@ void MeshNode::setPolygon(const Poly2& poly) {
     
     _mesh.set(poly);
     _mesh.command = GL_TRIANGLES;
+    invalidateBounds();
     
     // Adjust the mesh as necesary
     Size nsize = getContentSize();
@@ -293,8 +293,12 @@ bool OrderedNode::initWithData(const AssetManager* manager,
 void OrderedNode::visit(const std::shared_ptr<SceneNode>& node, const Affine2& transform, Color4 tint) {
     if (!node->isVisible()) { return; }
 
-    Affine2 matrix;
-    Affine2::multiply(node->getTransform(),transform,&matrix);
+    // Ordered nodes are barriers that cull themselves when rendered
+    bool barrier = node->getClassName() == getClassName();
+    const SceneNode& parent = *node;
+    const Affine2& matrix = node->updateWorldTransform(transform);
+    if (!barrier && node->cull()) { return; }
+    
     Color4 color = node->getColor();
     if (node->hasRelativeColor()) {
         color *= tint;
@@ -314,9 +318,8 @@ void OrderedNode::visit(const std::shared_ptr<SceneNode>& node, const Affine2& t
     
     // Identify pre or post. Block at child ordered nodes
     bool ispost = (_order == Order::POST_ORDER || _order == Order::POST_ASCEND || _order == Order::POST_DESCEND);
-    bool barrier = node->getClassName() == getClassName();
     if (ispost && !barrier) {
-        auto children = node->getChildren();
+        const auto& children = parent.getChildren();
         for(auto it = children.begin(); it != children.end(); ++it) {
             visit(*it, matrix, color);
         }
@@ -334,7 +337,7 @@ void OrderedNode::visit(const std::shared_ptr<SceneNode>& node, const Affine2& t
     context->canonical = canonical;
     
     if (!ispost && !barrier) {
-        auto children = node->getChildren();
+        const auto& children = parent.getChildren();
         for(auto it = children.begin(); it != children.end(); ++it) {
             visit(*it, matrix, color);
         }
@@ -364,8 +367,9 @@ void OrderedNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine
         // Drop to standard for efficiency
         SceneNode::render(batch,transform,tint);
     } else {
-        Affine2 matrix;
-        Affine2::multiply(_combined,transform,&matrix);
+        const Affine2& matrix = updateWorldTransform(transform);
+        if (cull()) { return; }
+        
         Color4 color = _tintColor;
         if (_hasParentColor) {
             color *= tint;
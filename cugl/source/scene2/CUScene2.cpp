@@ -59,7 +59,12 @@ Scene2::Scene2() : Scene(),
 _color(Color4::WHITE),
 _blendEquation(GL_FUNC_ADD),
 _srcFactor(GL_SRC_ALPHA),
-_dstFactor(GL_ONE_MINUS_SRC_ALPHA)
+_dstFactor(GL_ONE_MINUS_SRC_ALPHA),
+_culling(true),
+_viewing(false),
+_visited(0),
+_culled(0),
+_drawn(0)
 {}
 
 /**
@@ -72,6 +77,11 @@ void Scene2::dispose() {
     Scene::dispose();
     removeAllChildren();
     _color = Color4::WHITE;
+    _culling = true;
+    _viewing = false;
+    _visited = 0;
+    _culled  = 0;
+    _drawn   = 0;
 }
 
 
@@ -371,9 +381,47 @@ void Scene2::render() {
     _batch->setDstBlendFunc(_dstFactor);
     _batch->setBlendEquation(_blendEquation);
 
+    beginCulling();
     for(auto it = _children.begin(); it != _children.end(); ++it) {
         (*it)->render(_batch, Affine2::IDENTITY, _color);
     }
+    endCulling();
 
     _batch->end();
 }
+
+#pragma mark -
+#pragma mark Culling
+/**
+ * Prepares the camera view and statistics for culling.
+ *
+ * This method must be called at the start of any override of
+ * {@link #render}. It should be paired with a call to {@link #endCulling}.
+ */
+void Scene2::beginCulling() {
+    _visited = 0;
+    _culled  = 0;
+    _drawn   = 0;
+    _viewing = _camera != nullptr;
+    if (!_viewing) {
+        return;
+    }
+    
+    // Unproject the corners of normalized device space
+    const Mat4& inverse = _camera->getInverseProjectView();
+    float minx = 0, maxx = 0;
+    float miny = 0, maxy = 0;
+    for(int ii = 0; ii < 4; ii++) {
+        Vec4 corner((ii & 1) ? 1.0f : -1.0f, (ii & 2) ? 1.0f : -1.0f, 0.0f, 1.0f);
+        Mat4::transform(inverse, corner, &corner);
+        if (corner.w != 0) {
+            corner.x /= corner.w;
+            corner.y /= corner.w;
+        }
+        if (ii == 0 || corner.x < minx) { minx = corner.x; }
+        if (ii == 0 || corner.x > maxx) { maxx = corner.x; }
+        if (ii == 0 || corner.y < miny) { miny = corner.y; }
+        if (ii == 0 || corner.y > maxy) { maxy = corner.y; }
+    }
+    _viewbounds.set(minx, miny, maxx-minx, maxy-miny);
+}
@@ -160,9 +160,11 @@ void Scene2Texture::render() {
     _batch->setDstBlendFunc(_dstFactor);
     _batch->setBlendEquation(_blendEquation);
 
+    beginCulling();
     for(auto it = _children.begin(); it != _children.end(); ++it) {
         (*it)->render(_batch, Affine2::IDENTITY, _color);
     }
+    endCulling();
 
     _batch->end();
     _target->end();
@@ -67,10 +67,18 @@ _anchor(Vec2::ANCHOR_BOTTOM_LEFT),
 _scale(Vec2::ONE),
 _angle(0),
 _useTransform(false),
+_worlddirty(true),
+_worldlinked(false),
+_worldsource(0),
+_worldversion(0),
 _parent(nullptr),
 _graph(nullptr),
 _childOffset(-2),
-_priority(0) {
+_priority(0),
+_cullbounded(true),
+_culldirty(true),
+_cullversion(0),
+_cullstale(true) {
     _classname = "SceneNode";
 }
 
@@ -258,6 +266,11 @@ void SceneNode::dispose() {
     _transform = Affine2::IDENTITY;
     _useTransform = false;
     _combined = Affine2::IDENTITY;
+    _worldmat = Affine2::IDENTITY;
+    _worldbase = Affine2::IDENTITY;
+    _worlddirty = true;
+    _worldlinked = false;
+    _worldversion++;
     _parent = nullptr;
     _graph = nullptr;
     _childOffset = -2;
@@ -266,6 +279,11 @@ void SceneNode::dispose() {
     _hashOfName = 0;
     _priority = 0.0f;
     _json = nullptr;
+    _cullbounds = Rect::ZERO;
+    _cullbounded = true;
+    _culldirty = true;
+    _cullworld = Rect::ZERO;
+    _cullstale = true;
 }
 
 /**
@@ -291,6 +309,7 @@ std::shared_ptr<SceneNode> SceneNode::copy(const std::shared_ptr<SceneNode>& dst
     dst->_transform = _transform;
     dst->_useTransform = _useTransform;
     dst->_combined = _combined;
+    dst->_worlddirty = true;
     dst->_tag = _tag;
     dst->_name = _name;
     dst->_hashOfName = _hashOfName;
@@ -314,9 +333,14 @@ std::shared_ptr<SceneNode> SceneNode::copy(const std::shared_ptr<SceneNode>& dst
  * @param  y    The x-coordinate of the node in its parent's coordinate system.
  */
 void SceneNode::setPosition(float x, float y) {
+    if (x == _position.x && y == _position.y) {
+        return;
+    }
     _combined.m[4] += (x-_position.x);
     _combined.m[5] += (y-_position.y);
     _position.set(x,y);
+    _worlddirty = true;
+    if (_parent) _parent->invalidateBounds();
 }
 
 /**
@@ -336,6 +360,7 @@ void SceneNode::setContentSize(const Size size) {
     _position += _anchor*(size-_contentSize);
     _contentSize.set(size);
     if (!_useTransform) updateTransform();
+    invalidateBounds();
     if (_layout) {
         doLayout();
     }
@@ -497,6 +522,8 @@ void SceneNode::updateTransform() {
         _combined.m[4] += _position.x-offset.x;
         _combined.m[5] += _position.y-offset.y;
      }
+    _worlddirty = true;
+    if (_parent) _parent->invalidateBounds();
 }
 
 /**
@@ -622,7 +649,7 @@ void SceneNode::addChild(const std::shared_ptr<SceneNode>& child) {
     _children.push_back(child);
     child->setParent(this);
     child->pushScene(_graph);
-    
+    invalidateBounds();
 }
 
 /**
@@ -646,6 +673,7 @@ void SceneNode::swapChild(const std::shared_ptr<SceneNode>& child1,
     child1->setParent(nullptr);
     child2->pushScene(_graph);
     child1->pushScene(nullptr);
+    invalidateBounds();
     
     // Check if we are dirty and/or inherit children
     if (inherit) {
@@ -676,6 +704,7 @@ void SceneNode::removeChild(unsigned int pos) {
         _children[ii]->_childOffset = ii;
     }
     _children.resize(_children.size()-1);
+    invalidateBounds();
 }
 
 /**
@@ -739,6 +768,7 @@ void SceneNode::removeAllChildren() {
         (*it)->pushScene(nullptr);
     }
     _children.clear();
+    invalidateBounds();
 }
 
 /**
@@ -791,8 +821,9 @@ void SceneNode::doLayout() {
 void SceneNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) {
     if (!_isVisible) { return; }
     
-    Affine2 matrix;
-    Affine2::multiply(_combined,transform,&matrix);
+    const Affine2& matrix = updateWorldTransform(transform);
+    if (cull()) { return; }
+
     Color4 color = _tintColor;
     if (_hasParentColor) {
         color *= tint;
@@ -818,6 +849,54 @@ void SceneNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine2&
     }
 }
 
+/**
+ * Returns the node to world transform for the given parent transform.
+ *
+ * The result is the local transform of this node multiplied by the
+ * parent transform. It is cached, and is only recomputed when it is
+ * out of date. Changes to the local transform mark the cache as dirty.
+ * Changes above this node are propagated by version. If the transform
+ * is the cached render transform of the parent, the cache is valid as
+ * long as the parent version is the same as at the last call. So a
+ * clean node below a clean parent costs two comparisons, and a change
+ * to an ancestor reaches every descendant without walking the subtree.
+ * Any other transform (such as the root transform or the pane transform
+ * of a {@link ScrollPane}) is compared exactly to the one from the last
+ * call. The method {@link #getTransformVersion} is updated whenever the
+ * result changes.
+ *
+ * This method is called by {@link #render}. A subclass that renders its
+ * descendants in a custom order, like {@link OrderedNode}, should call it
+ * for each node that it visits.
+ *
+ * @param transform The parent transform
+ *
+ * @return the node to world transform for the given parent transform.
+ */
+const Affine2& SceneNode::updateWorldTransform(const Affine2& transform) {
+    bool linked = _parent != nullptr && &transform == &(_parent->_worldmat);
+    if (!_worlddirty) {
+        if (linked) {
+            if (_worldlinked && _worldsource == _parent->_worldversion) {
+                return _worldmat;
+            }
+        } else if (!_worldlinked && _worldbase.isExactly(transform)) {
+            return _worldmat;
+        }
+    }
+    
+    Affine2::multiply(_combined,transform,&_worldmat);
+    if (linked) {
+        _worldsource = _parent->_worldversion;
+    } else {
+        _worldbase = transform;
+    }
+    _worldlinked = linked;
+    _worlddirty = false;
+    _worldversion++;
+    return _worldmat;
+}
+
 /**
  * Returns the absolute color tinting this node.
  *
@@ -835,3 +914,111 @@ Color4 SceneNode::getAbsoluteColor() {
     return result;
 }
 
+
+#pragma mark -
+#pragma mark Culling
+/**
+ * Returns true if this subtree has finite bounds, storing them in bounds.
+ *
+ * The bounds are in node space, and contain the drawing bounds of this
+ * node and all of its descendants. This value is cached, and is only
+ * recomputed when the contents of this subtree change. It is unaffected
+ * by changes to the transforms of this node or its ancestors.
+ *
+ * @param bounds    The rectangle to store the subtree bounds
+ *
+ * @return true if this subtree has finite bounds
+ */
+bool SceneNode::getSubtreeBounds(Rect& bounds) {
+    if (_culldirty) {
+        _cullbounded = computeBounds(_cullbounds);
+        _culldirty = false;
+        _cullstale = true;
+    }
+    bounds = _cullbounds;
+    return _cullbounded;
+}
+
+/**
+ * Marks the cached bounds of this node and its ancestors as dirty.
+ *
+ * This method should be called whenever the drawing bounds of this node
+ * change. Changes to the content size and children of this node, as
+ * well as to the transforms of its children, are handled automatically.
+ */
+void SceneNode::invalidateBounds() {
+    // A dirty node always has dirty ancestors, so we can stop early
+    SceneNode* node = this;
+    while (node != nullptr && !node->_culldirty) {
+        node->_culldirty = true;
+        node = node->_parent;
+    }
+}
+
+/**
+ * Returns true if this subtree has finite bounds, storing them in bounds.
+ *
+ * This method recomputes the value cached by {@link #getSubtreeBounds}.
+ * By default, it merges the drawing bounds of this node with the subtree
+ * bounds of each child, transformed into the coordinate space of this
+ * node. A subclass that transforms its children in a custom way must
+ * override this method.
+ *
+ * @param bounds    The rectangle to store the subtree bounds
+ *
+ * @return true if this subtree has finite bounds
+ */
+bool SceneNode::computeBounds(Rect& bounds) {
+    bool result = getDrawBounds(bounds);
+    Rect local;
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        if ((*it)->getSubtreeBounds(local)) {
+            Affine2::transform((*it)->_combined, local, &local);
+            bounds.merge(local);
+        } else {
+            result = false;
+        }
+    }
+    return result;
+}
+
+/**
+ * Returns true if this subtree is outside of the scene camera view.
+ *
+ * This method uses the transform computed by the last call to
+ * {@link #updateWorldTransform}, and so must be called after it. The
+ * world bounds of this subtree are cached against the transform version,
+ * so they are not recomputed for a static subtree. If this method returns
+ * false, the caller is expected to draw this node, and the rendering
+ * statistics of the {@link Scene2} are updated accordingly. No node is
+ * culled if it is not being rendered by a scene, or if that scene has
+ * culling disabled.
+ *
+ * This method is called by {@link #render}. A subclass that renders its
+ * descendants in a custom order should call it for each node that it
+ * visits, after {@link #updateWorldTransform}.
+ *
+ * @return true if this subtree is outside of the scene camera view.
+ */
+bool SceneNode::cull() {
+    if (_graph == nullptr || !_graph->_viewing) {
+        return false;
+    }
+    
+    _graph->_visited++;
+    if (_graph->_culling) {
+        Rect bounds;
+        bool bounded = getSubtreeBounds(bounds);
+        if (bounded && (_cullstale || _cullversion != _worldversion)) {
+            Affine2::transform(_worldmat, bounds, &_cullworld);
+            _cullversion = _worldversion;
+            _cullstale = false;
+        }
+        if (bounded && !_cullworld.doesIntersect(_graph->_viewbounds)) {
+            _graph->_culled++;
+            return true;
+        }
+    }
+    _graph->_drawn++;
+    return false;
+}
@@ -860,6 +860,7 @@ void ScrollPane::setMasked(bool value) {
     } else {
         _panemask = nullptr;
     }
+    invalidateBounds();
 }
 
 /**
@@ -958,6 +959,7 @@ Vec2 ScrollPane::applyPan(const Vec2& delta) {
     } else {
         _panetrans.translate(delta);
     }
+    invalidateBounds();
     return result;
 }
 
@@ -1020,6 +1022,7 @@ float ScrollPane::applySpin(float angle) {
     _panetrans.translate(-center.x, -center.y);
     _panetrans.rotate(angle);
     _panetrans.translate(center.x, center.y);
+    invalidateBounds();
     return angle;
 }
 
@@ -1071,6 +1074,7 @@ float ScrollPane::applyZoom(float scale) {
     _panetrans.translate(-center.x, -center.y);
     _panetrans.scale(scale,scale);
     _panetrans.translate(center.x, center.y);
+    invalidateBounds();
     return scale;
 }
 
@@ -1108,6 +1112,7 @@ void ScrollPane::resetPane() {
         
         _panetrans.translate(offset);
     }
+    invalidateBounds();
 }
     
 #pragma mark -
@@ -1127,8 +1132,9 @@ void ScrollPane::resetPane() {
 void ScrollPane::render(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) {
     if (!_isVisible) { return; }
     
-    Affine2 matrix;
-    Affine2::multiply(_combined,transform,&matrix);
+    Affine2 matrix = updateWorldTransform(transform);
+    if (cull()) { return; }
+    
     Color4 color = _tintColor;
     if (_hasParentColor) {
         color *= tint;
@@ -1161,3 +1167,39 @@ void ScrollPane::render(const std::shared_ptr<SpriteBatch>& batch, const Affine2
         batch->setScissor(active);
     }
 }
+
+#pragma mark -
+#pragma mark Culling
+/**
+ * Returns true if this subtree has finite bounds, storing them in bounds.
+ *
+ * The children of a scroll pane are transformed by the pane transform.
+ * If the pane is masked, then the children are clipped to the mask, and
+ * so the mask bounds the entire subtree.
+ *
+ * @param bounds    The rectangle to store the subtree bounds
+ *
+ * @return true if this subtree has finite bounds
+ */
+bool ScrollPane::computeBounds(Rect& bounds) {
+    bool result = getDrawBounds(bounds);
+    if (_panemask) {
+        Rect mask;
+        Affine2::transform(_panemask->getTransform(), _panemask->getBounds(), &mask);
+        bounds.merge(mask);
+        return result;
+    }
+    
+    Rect local;
+    Affine2 matrix;
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        if ((*it)->getSubtreeBounds(local)) {
+            Affine2::multiply((*it)->getTransform(), _panetrans, &matrix);
+            Affine2::transform(matrix, local, &local);
+            bounds.merge(local);
+        } else {
+            result = false;
+        }
+    }
+    return result;
+}
@@ -350,6 +350,35 @@ void TexturedNode::setContentSize(const Size size) {
     clearRenderData();
 }
 
+/**
+ * Returns true if this node has finite drawing bounds, storing them in bounds.
+ *
+ * The drawing bounds of a textured node are the bounds of its mesh,
+ * merged with the content bounds. As the mesh may extend past the
+ * content bounds (such as with a path stroke or a fringe), this method
+ * will generate the render data if it is not already present.
+ *
+ * @param bounds    The rectangle to store the drawing bounds
+ *
+ * @return true if this node has finite drawing bounds
+ */
+bool TexturedNode::getDrawBounds(Rect& bounds) {
+    if (!_rendered) {
+        generateRenderData();
+    }
+    
+    float minx = 0, maxx = _contentSize.width;
+    float miny = 0, maxy = _contentSize.height;
+    for(auto it = _mesh.vertices.begin(); it != _mesh.vertices.end(); ++it) {
+        minx = std::min(minx, it->position.x);
+        maxx = std::max(maxx, it->position.x);
+        miny = std::min(miny, it->position.y);
+        maxy = std::max(maxy, it->position.y);
+    }
+    bounds.set(minx, miny, maxx-minx, maxy-miny);
+    return true;
+}
+
 #pragma mark -
 #pragma mark Internal Helpers
 
@@ -359,6 +388,7 @@ void TexturedNode::setContentSize(const Size size) {
 void TexturedNode::clearRenderData() {
     _mesh.clear();
     _rendered = false;
+    invalidateBounds();
 }
 
 
@@ -52,6 +52,7 @@
 #include <cugl/graphics/CUSpriteMesh.h>
 #include <cugl/graphics/CUTexture.h>
 #include <cugl/graphics/CUGradient.h>
+#include <algorithm>
 
 using namespace cugl::scene3;
 using namespace cugl::graphics;
@@ -300,3 +301,34 @@ void BillboardNode::setFrame(int frame) {
     float dy = y-_bounds.origin.y;
     _texoffset.set(dx,dy);
 }
+
+#pragma mark -
+#pragma mark Culling
+/**
+ * Returns true if this node has a bounding box, storing it in lower and upper.
+ *
+ * Billboards always face the camera, so the sprite mesh may be drawn in
+ * any orientation about the node origin. Therefore the bounding box is
+ * the cube containing the sphere swept out by the sprite mesh. A node
+ * with no sprite mesh has no bounding box.
+ *
+ * @param lower The minimum corner of the bounding box
+ * @param upper The maximum corner of the bounding box
+ *
+ * @return true if this node has a bounding box
+ */
+bool BillboardNode::getBoundingBox(Vec3& lower, Vec3& upper) const {
+    if (_mesh == nullptr) {
+        return false;
+    }
+    
+    float radius = 0;
+    const Mesh<SpriteVertex>& mesh = _mesh->getMesh();
+    for(auto it = mesh.vertices.begin(); it != mesh.vertices.end(); ++it) {
+        radius = std::max(radius, it->position.lengthSquared());
+    }
+    radius = std::sqrt(radius);
+    lower.set(-radius,-radius,-radius);
+    upper.set(radius,radius,radius);
+    return true;
+}
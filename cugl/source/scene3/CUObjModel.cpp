@@ -50,6 +50,7 @@
 #include <cugl/scene3/CUObjModel.h>
 #include <cugl/scene3/CUMaterial.h>
 #include <cugl/scene3/CUObjShader.h>
+#include <algorithm>
 
 using namespace cugl;
 using namespace cugl::graphics;
@@ -111,6 +112,19 @@ bool ObjMesh::initWithInfo(const std::shared_ptr<ModelInfo>& root,
         _mesh.vertices.push_back(vert);
     }
     
+    if (!_mesh.vertices.empty()) {
+        _lower = _mesh.vertices.front().position;
+        _upper = _lower;
+        for(auto it = _mesh.vertices.begin(); it != _mesh.vertices.end(); ++it) {
+            _lower.x = std::min(_lower.x, it->position.x);
+            _lower.y = std::min(_lower.y, it->position.y);
+            _lower.z = std::min(_lower.z, it->position.z);
+            _upper.x = std::max(_upper.x, it->position.x);
+            _upper.y = std::max(_upper.y, it->position.y);
+            _upper.z = std::max(_upper.z, it->position.z);
+        }
+    }
+    
     _mesh.indices.insert(_mesh.indices.end(),
                          info->indices.begin(),
                          info->indices.end());
@@ -140,6 +154,8 @@ void ObjMesh::dispose() {
     _shader = nullptr;
     _tags.clear();
     _mesh.clear();
+    _lower.setZero();
+    _upper.setZero();
     _index = 0;
 }
 
@@ -418,6 +434,7 @@ bool ObjModel::initWithInfo(const std::shared_ptr<ModelInfo>& info, Uint32 depth
         mesh->setMaterialName((*it)->material);
         _meshes.push_back(mesh);
     }
+    computeBounds();
     return true;
 }
 
@@ -433,6 +450,38 @@ bool ObjModel::initWithInfo(const std::shared_ptr<ModelInfo>& info, Uint32 depth
 void ObjModel::dispose() {
     _name = "";
     _meshes.clear();
+    _lower.setZero();
+    _upper.setZero();
+}
+
+/**
+ * Recomputes the model bounding box from the meshes.
+ *
+ * This method should be called any time the set of meshes changes.
+ */
+void ObjModel::computeBounds() {
+    bool first = true;
+    _lower.setZero();
+    _upper.setZero();
+    for(auto it = _meshes.begin(); it != _meshes.end(); ++it) {
+        if ((*it)->getMesh().vertices.empty()) {
+            continue;
+        }
+        const Vec3& lower = (*it)->getMinCorner();
+        const Vec3& upper = (*it)->getMaxCorner();
+        if (first) {
+            _lower = lower;
+            _upper = upper;
+            first = false;
+        } else {
+            _lower.x = std::min(_lower.x, lower.x);
+            _lower.y = std::min(_lower.y, lower.y);
+            _lower.z = std::min(_lower.z, lower.z);
+            _upper.x = std::max(_upper.x, upper.x);
+            _upper.y = std::max(_upper.y, upper.y);
+            _upper.z = std::max(_upper.z, upper.z);
+        }
+    }
 }
 
 /**
@@ -456,6 +505,7 @@ std::shared_ptr<ObjModel> ObjModel::getSubModel(const std::string tag) const {
             result->_meshes.push_back(mesh);
         }
     }
+    result->computeBounds();
     return result;
 }
 
@@ -170,3 +170,25 @@ std::shared_ptr<SceneNode> ObjNode::clone() const {
     SceneNode::copy(result);
     return result;
 }
+
+#pragma mark -
+#pragma mark Culling
+/**
+ * Returns true if this node has a bounding box, storing it in lower and upper.
+ *
+ * The bounding box is the bounding box of the model, in node space. A
+ * node with no model has no bounding box.
+ *
+ * @param lower The minimum corner of the bounding box
+ * @param upper The maximum corner of the bounding box
+ *
+ * @return true if this node has a bounding box
+ */
+bool ObjNode::getBoundingBox(Vec3& lower, Vec3& upper) const {
+    if (_model == nullptr) {
+        return false;
+    }
+    lower = _model->getMinCorner();
+    upper = _model->getMaxCorner();
+    return true;
+}
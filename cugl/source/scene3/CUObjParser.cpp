@@ -42,20 +42,42 @@
 //
 //      3. This notice may not be removed or altered from any source distribution.
 //
-//  Author: Walker White
-//  Version: 7/3/24 (CUGL 3.0 reorganization)
+//  Author: agent
+//  Version: 10/17/26
 //
 #include <cugl/scene3/CUObjParser.h>
-#include <cugl/core/io/CUTextReader.h>
+#include <cugl/core/io/CUBinaryWriter.h>
 #include <cugl/core/util/CUStringTools.h>
 #include <cugl/core/util/CUFiletools.h>
+#include <cugl/core/util/CUThreadPool.h>
+#include <cugl/core/util/CUEndian.h>
 #include <cugl/core/assets/CUJsonValue.h>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
 
 using namespace cugl;
 using namespace cugl::scene3;
 using namespace cugl::graphics;
 using namespace std;
 
+/** The minimum number of shape commands for each indexing task */
+#define TASK_MIN_SHAPES     4096
+/** The size of the cache header in bytes */
+#define CACHE_HEADER_SIZE   32
+/** An unused slot in a vertex table */
+#define EMPTY_SLOT          0xFFFFFFFF
+/** The largest exact power of 10 for a double */
+#define MAX_EXACT_POW10     22
+/** The maximum number of significant digits in a parsed number */
+#define MAX_DIGITS          19
+/** The largest integer mantissa that is exact in a double */
+#define MAX_EXACT_MANTISSA  (((Uint64)1) << 53)
+/** The double mantissa bits that are discarded when rounding to a float */
+#define FLOAT_DISCARD_MASK  0x1FFFFFFF
+/** The discarded bits of a double that is halfway between two floats */
+#define FLOAT_HALFWAY_BITS  0x10000000
+
 /**
  * Returns true if c is skippable whitespace
  *
@@ -66,6 +88,435 @@ static bool isSkippable(char c) {
     return c == ' ' || c == '\t' || c == '\r' || c <= 0;
 }
 
+/**
+ * Returns the end of the line starting at begin
+ *
+ * The end is either a newline or the end of the data.
+ *
+ * @param begin The start of the line
+ * @param end   The end of the data
+ *
+ * @return the end of the line starting at begin
+ */
+static const char* line_end(const char* begin, const char* end) {
+    const char* result = (const char*)std::memchr(begin, '\n', end-begin);
+    return result == nullptr ? end : result;
+}
+
+/**
+ * Returns the end of the unsigned integer at begin
+ *
+ * If there is no integer at begin, this function returns begin.
+ *
+ * @param begin The start of the string fragment to parse
+ * @param end   The end of the string fragment to parse
+ * @param value The value to store the result
+ *
+ * @return the end of the unsigned integer at begin
+ */
+static const char* parse_uint(const char* begin, const char* end, Uint32& value) {
+    Uint64 result = 0;
+    const char* curr = begin;
+    while (curr != end && *curr >= '0' && *curr <= '9') {
+        if (result <= 0xFFFFFFFF) {
+            result = result*10+(*curr-'0');
+        }
+        curr++;
+    }
+    value = result > 0xFFFFFFFF ? 0xFFFFFFFF : (Uint32)result;
+    return curr;
+}
+
+/**
+ * Returns the end of the floating point number at begin
+ *
+ * This function is a replacement for strtof that does not need a terminated
+ * string, and it gives exactly the same result. If the significant digits
+ * are an integer that is exact in a double (at most 2^53), and the exponent
+ * is within the exact powers of 10 for a double, the number is converted
+ * with a single division or multiplication. That double is correctly
+ * rounded, so rounding it to a float gives the same float as strtof unless
+ * the double is exactly halfway between two floats. Those numbers, and all
+ * other numbers (including special values like nan), are passed to strtof.
+ *
+ * If there is no number at begin, this function returns begin.
+ *
+ * @param begin The start of the string fragment to parse
+ * @param end   The end of the string fragment to parse
+ * @param value The value to store the result
+ *
+ * @return the end of the floating point number at begin
+ */
+static const char* parse_float(const char* begin, const char* end, float& value) {
+    static const double powers[MAX_EXACT_POW10+1] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* curr = begin;
+    bool negative = false;
+    if (curr != end && (*curr == '-' || *curr == '+')) {
+        negative = (*curr == '-');
+        curr++;
+    }
+
+    Uint64 mantissa = 0;
+    int digits = 0;
+    int scale  = 0;
+    bool exact = true;
+    const char* start = curr;
+    while (curr != end && *curr >= '0' && *curr <= '9') {
+        if (digits < MAX_DIGITS) {
+            mantissa = mantissa*10+(*curr-'0');
+            digits += (mantissa > 0);
+        } else {
+            exact = false;
+        }
+        curr++;
+    }
+    bool found = curr != start;
+    if (curr != end && *curr == '.') {
+        curr++;
+        const char* frac = curr;
+        while (curr != end && *curr >= '0' && *curr <= '9') {
+            if (digits < MAX_DIGITS) {
+                mantissa = mantissa*10+(*curr-'0');
+                digits += (mantissa > 0);
+                scale--;
+            } else {
+                exact = false;
+            }
+            curr++;
+        }
+        found = found || curr != frac;
+    }
+
+    if (!found) {
+        // Let strtof handle special values (the data is always terminated)
+        char* right;
+        value = std::strtof(begin,&right);
+        return right > end ? begin : right;
+    }
+
+    if (curr != end && (*curr == 'e' || *curr == 'E')) {
+        const char* mark = curr++;
+        bool expneg = false;
+        if (curr != end && (*curr == '-' || *curr == '+')) {
+            expneg = (*curr == '-');
+            curr++;
+        }
+        Uint32 exponent;
+        const char* right = parse_uint(curr, end, exponent);
+        if (right == curr) {
+            curr = mark;
+        } else {
+            exponent = std::min(exponent,(Uint32)1000);
+            scale += expneg ? -(int)exponent : (int)exponent;
+            curr = right;
+        }
+    }
+
+    if (exact && mantissa <= MAX_EXACT_MANTISSA &&
+        scale <= MAX_EXACT_POW10 && scale >= -MAX_EXACT_POW10) {
+        double result = (double)mantissa;
+        result = scale < 0 ? result/powers[-scale] : result*powers[scale];
+        
+        // The result is at least 1e-22, so it is never a subnormal float
+        Uint64 bits;
+        std::memcpy(&bits, &result, sizeof(double));
+        if ((bits & FLOAT_DISCARD_MASK) != FLOAT_HALFWAY_BITS) {
+            value = (float)(negative ? -result : result);
+            return curr;
+        }
+    }
+
+    char* right;
+    value = std::strtof(begin,&right);
+    return right;
+}
+
+/**
+ * Returns true if count numbers were read from the string fragment
+ *
+ * The numbers must be separated by whitespace. Parsing stops at a comment.
+ *
+ * @param begin The start of the string fragment to parse
+ * @param end   The end of the string fragment to parse
+ * @param data  The array to store the numbers
+ * @param count The number of values to parse
+ *
+ * @return true if count numbers were read from the string fragment
+ */
+static bool parse_floats(const char* begin, const char* end, float* data, int count) {
+    const char* curr = begin;
+    for(int ii = 0; ii < count; ii++) {
+        while (curr != end && isSkippable(*curr)) {
+            curr++;
+        }
+        if (curr == end || *curr == '#') {
+            return false;
+        }
+        const char* right = parse_float(curr, end, data[ii]);
+        if (right == curr) {
+            return false;
+        }
+        curr = right;
+    }
+    return true;
+}
+
+#pragma mark -
+#pragma mark Cache Encoding
+/**
+ * Appends the 32 bit value to the data, encoded in network order
+ *
+ * @param data  The data to modify
+ * @param value The value to write
+ */
+static void put32(std::vector<char>& data, Uint32 value) {
+    value = marshall(value);
+    size_t pos = data.size();
+    data.resize(pos+sizeof(Uint32));
+    std::memcpy(data.data()+pos, &value, sizeof(Uint32));
+}
+
+/**
+ * Appends the float array to the data, encoded in network order
+ *
+ * @param data  The data to modify
+ * @param array The values to write
+ * @param count The number of values to write
+ */
+static void put_floats(std::vector<char>& data, const float* array, size_t count) {
+    for(size_t ii = 0; ii < count; ii++) {
+        Uint32 value;
+        std::memcpy(&value, array+ii, sizeof(Uint32));
+        put32(data, value);
+    }
+}
+
+/**
+ * Appends the string to the data, prefixed by its length
+ *
+ * @param data  The data to modify
+ * @param value The string to write
+ */
+static void put_string(std::vector<char>& data, const std::string& value) {
+    put32(data, (Uint32)value.size());
+    data.insert(data.end(), value.begin(), value.end());
+}
+
+/**
+ * Returns true if a 32 bit value was read from the data
+ *
+ * The value is decoded from network order. On success, the read head is
+ * moved past the value.
+ *
+ * @param curr  The read head
+ * @param end   The end of the data
+ * @param value The value to store the result
+ *
+ * @return true if a 32 bit value was read from the data
+ */
+static bool get32(const char*& curr, const char* end, Uint32& value) {
+    if ((size_t)(end-curr) < sizeof(Uint32)) {
+        return false;
+    }
+    std::memcpy(&value, curr, sizeof(Uint32));
+    value = marshall(value);
+    curr += sizeof(Uint32);
+    return true;
+}
+
+/**
+ * Returns true if count floats were read from the data
+ *
+ * The values are decoded from network order. On success, the read head is
+ * moved past the values.
+ *
+ * @param curr  The read head
+ * @param end   The end of the data
+ * @param array The array to store the result
+ * @param count The number of values to read
+ *
+ * @return true if count floats were read from the data
+ */
+static bool get_floats(const char*& curr, const char* end, float* array, size_t count) {
+    if ((size_t)(end-curr)/sizeof(Uint32) < count) {
+        return false;
+    }
+    for(size_t ii = 0; ii < count; ii++) {
+        Uint32 value;
+        std::memcpy(&value, curr, sizeof(Uint32));
+        value = marshall(value);
+        std::memcpy(array+ii, &value, sizeof(Uint32));
+        curr += sizeof(Uint32);
+    }
+    return true;
+}
+
+/**
+ * Returns true if a length-prefixed string was read from the data
+ *
+ * On success, the read head is moved past the string.
+ *
+ * @param curr  The read head
+ * @param end   The end of the data
+ * @param value The string to store the result
+ *
+ * @return true if a length-prefixed string was read from the data
+ */
+static bool get_string(const char*& curr, const char* end, std::string& value) {
+    Uint32 size;
+    if (!get32(curr, end, size) || (size_t)(end-curr) < size) {
+        return false;
+    }
+    value.assign(curr, size);
+    curr += size;
+    return true;
+}
+
+#pragma mark -
+#pragma mark Vertex Table
+/**
+ * This class is a flat hash table for removing duplicate vertices.
+ *
+ * The table is an open-addressed array of positions in the vertex list of
+ * a render group, and so it does not store any keys of its own. It uses
+ * linear probing and is never more than half full.
+ */
+class ObjParser::VertexTable {
+public:
+    /** The positions of the vertices in the group (or EMPTY_SLOT) */
+    std::vector<Uint32> slots;
+    /** The mask for a position in the slots (the capacity is a power of 2) */
+    Uint32 mask;
+    /** The vertex indices of the current shape command */
+    std::vector<GLuint> shape;
+
+    /**
+     * Returns the hash code for the given vertex
+     *
+     * @param vert  The vertex to hash
+     *
+     * @return the hash code for the given vertex
+     */
+    static Uint32 hash(const VertexInfo& vert) {
+        Uint64 h = (Uint32)vert.pindex;
+        h = h*0x9E3779B97F4A7C15ULL+(Uint32)vert.tindex;
+        h = h*0x9E3779B97F4A7C15ULL+(Uint32)vert.nindex;
+        return (Uint32)(h ^ (h >> 32));
+    }
+
+    /**
+     * Resets this table to hold at least the given number of vertices
+     *
+     * @param expected  The expected number of vertices
+     */
+    void reset(size_t expected) {
+        size_t capacity = 64;
+        while (capacity < 2*expected) {
+            capacity <<= 1;
+        }
+        slots.assign(capacity,EMPTY_SLOT);
+        mask = (Uint32)(capacity-1);
+    }
+
+    /**
+     * Doubles the capacity of this table, rehashing the group vertices
+     *
+     * @param group The render group for this table
+     */
+    void grow(const GroupInfo* group) {
+        slots.assign(2*slots.size(),EMPTY_SLOT);
+        mask = (Uint32)(slots.size()-1);
+        Uint32 count = (Uint32)group->vertices.size();
+        for(Uint32 ii = 0; ii < count; ii++) {
+            Uint32 pos = hash(group->vertices[ii]) & mask;
+            while (slots[pos] != EMPTY_SLOT) {
+                pos = (pos+1) & mask;
+            }
+            slots[pos] = ii;
+        }
+    }
+
+    /**
+     * Returns the index of the given vertex in the render group
+     *
+     * If the vertex is not already in the group, it is appended to it.
+     *
+     * @param group The render group for this table
+     * @param vert  The vertex to find
+     *
+     * @return the index of the given vertex in the render group
+     */
+    GLuint acquire(GroupInfo* group, const VertexInfo& vert) {
+        if (2*(group->vertices.size()+1) > slots.size()) {
+            grow(group);
+        }
+        Uint32 pos = hash(vert) & mask;
+        while (true) {
+            Uint32 slot = slots[pos];
+            if (slot == EMPTY_SLOT) {
+                slot = (Uint32)group->vertices.size();
+                slots[pos] = slot;
+                group->vertices.push_back(vert);
+                return slot;
+            } else if (group->vertices[slot] == vert) {
+                return slot;
+            }
+            pos = (pos+1) & mask;
+        }
+    }
+};
+
+#pragma mark -
+#pragma mark Constructors
+/**
+ * Creates a new OBJ parser.
+ *
+ * This is a fairly lightweight object. Therefore it is safe to use this
+ * constructor with new (though std::make_shared is prefered). The parser
+ * starts with a single thread.
+ */
+ObjParser::ObjParser() :
+debug(false),
+_threads(1) {
+}
+
+/**
+ * Deletes this OBJ parser, disposing all resource.
+ */
+ObjParser::~ObjParser() {
+    clear();
+    if (_workers != nullptr) {
+        _workers->stop();
+        _workers = nullptr;
+    }
+}
+
+/**
+ * Sets the number of threads used to index the render groups
+ *
+ * The calling thread counts as one of the threads, so a value of 1
+ * indexes all of the groups serially. Changing this value replaces
+ * the worker threads.
+ *
+ * @param threads   The number of threads used to index the render groups
+ */
+void ObjParser::setThreadCount(Uint32 threads) {
+    threads = std::max(threads,(Uint32)1);
+    if (threads != _threads && _workers != nullptr) {
+        _workers->stop();
+        _workers = nullptr;
+    }
+    _threads = threads;
+    if (_threads > 1 && _workers == nullptr) {
+        _workers = ThreadPool::alloc(_threads-1);
+    }
+}
+
+#pragma mark -
 #pragma mark Parsing
 
 /**
@@ -190,8 +641,11 @@ std::shared_ptr<ModelInfo> ObjParser::parseJson(const std::shared_ptr<JsonValue>
 std::shared_ptr<ModelInfo> ObjParser::parseObj(const std::string key,
                                                const std::string source,
                                                bool recurse) {
-    auto reader = TextReader::alloc(source);
-    if (reader == nullptr) {
+    // Read the file in one pass and parse it in place
+    size_t size = 0;
+    std::string path = cugl::filetool::normalize_path(source);
+    char* data = (char*)SDL_LoadFile(path.c_str(), &size);
+    if (data == nullptr) {
         CUAssertLog(false, "Could not read file %s", source.c_str());
         return nullptr;
     }
@@ -200,60 +654,20 @@ std::shared_ptr<ModelInfo> ObjParser::parseObj(const std::string key,
     std::shared_ptr<ModelInfo> model = std::make_shared<ModelInfo>();
     model->name = key;
     model->path = source;
-     
-    while (reader->ready()) {
-        string line = reader->readLine();
-        const char* begin = line.c_str();
-        const char* end = begin+line.size();
-         
-        while(begin != end && isSkippable(*begin)) {
-            begin++;
+    
+    if (isCache(data, size)) {
+        if (!parseCache(data, data+size, model)) {
+            CULogError("Invalid OBJ cache %s", source.c_str());
+            model = nullptr;
         }
-         
-        if (begin != end) {
-            char c = *begin;
-             
-            switch (c) {
-            case 'o':
-                processObject(begin, end, model);
-                break;
-            case 'm':
-                processImport(begin, end, model);
-                break;
-            case 'g':
-                processGroup(begin, end, model);
-                break;
-            case 's':
-                processSmooth(begin, end, model);
-                break;
-            case 'v':
-                processVertex(begin, end, model);
-                break;
-            case 'f':
-                processFace(begin, end, model);
-                break;
-            case 'l':
-                processLine(begin, end, model);
-                break;
-            case 'p':
-                processPoints(begin, end, model);
-                break;
-            case 'u':
-                processUsage(begin, end, model);
-                break;
-            case '#':
-                // Comment.  Abort
-                break;
-            default:
-                if (debug) {
-                    CULogError("Unsupported OBJ command: %s",begin);
-                }
-                break;
-            }
-         }
-     }
-     
-    reader = nullptr;
+    } else {
+        parseText(data, data+size, model);
+    }
+    SDL_free(data);
+    
+    if (model == nullptr) {
+        return nullptr;
+    }
 
     if (recurse) {
         std::string root = cugl::filetool::split_path(source).first;
@@ -308,8 +722,11 @@ std::shared_ptr<ModelInfo> ObjParser::getObj(const std::string key) const {
  * @return the information for the given MTL file.
  */
 std::shared_ptr<MaterialLib> ObjParser::parseMtl(const std::string key, const std::string source) {
-    auto reader = TextReader::alloc(source);
-    if (reader == nullptr) {
+    // Read the file in one pass and parse it in place
+    size_t size = 0;
+    std::string path = cugl::filetool::normalize_path(source);
+    char* data = (char*)SDL_LoadFile(path.c_str(), &size);
+    if (data == nullptr) {
         CUAssertLog(false, "Could not read file %s", source.c_str());
         return nullptr;
     }
@@ -321,10 +738,12 @@ std::shared_ptr<MaterialLib> ObjParser::parseMtl(const std::string key, const st
     
     std::string root = cugl::filetool::split_path(source).first;
      
-    while (reader->ready()) {
-        string line = reader->readLine();
-        const char* begin = line.c_str();
-        const char* end = begin+line.size();
+    const char* next = data;
+    const char* last = data+size;
+    while (next != last) {
+        const char* begin = next;
+        const char* end = line_end(begin, last);
+        next = end == last ? last : end+1;
          
         while(begin != end && isSkippable(*begin)) {
             begin++;
@@ -360,14 +779,14 @@ std::shared_ptr<MaterialLib> ObjParser::parseMtl(const std::string key, const st
                 break;
             default:
                 if (debug) {
-                    CULogError("Unsupported MTL command: %s",begin);
+                    CULogError("Unsupported MTL command: %.*s",(int)(end-begin),begin);
                 }
                 break;
             }
          }
      }
      
-    reader = nullptr;
+    SDL_free(data);
     return lib;
 }
 
@@ -405,6 +824,394 @@ void ObjParser::clear() {
     models.clear();
 }
 
+#pragma mark -
+#pragma mark OBJ Files
+/**
+ * Reads the contents of the OBJ file into the given model.
+ *
+ * The render groups are indexed once the entire file is read.
+ *
+ * @param begin The start of the file data
+ * @param end   The end of the file data
+ * @param obj   The current ModelInfo results
+ */
+void ObjParser::parseText(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj) {
+    _shapes.clear();
+    
+    const char* next = begin;
+    while (next != end) {
+        const char* left  = next;
+        const char* right = line_end(left, end);
+        next = right == end ? end : right+1;
+        
+        while(left != right && isSkippable(*left)) {
+            left++;
+        }
+         
+        if (left != right) {
+            char c = *left;
+             
+            switch (c) {
+            case 'o':
+                processObject(left, right, obj);
+                break;
+            case 'm':
+                processImport(left, right, obj);
+                break;
+            case 'g':
+                processGroup(left, right, obj);
+                break;
+            case 's':
+                processSmooth(left, right, obj);
+                break;
+            case 'v':
+                processVertex(left, right, obj);
+                break;
+            case 'f':
+                processShape(left, right, GL_TRIANGLES, obj);
+                break;
+            case 'l':
+                processShape(left, right, GL_LINES, obj);
+                break;
+            case 'p':
+                processShape(left, right, GL_POINTS, obj);
+                break;
+            case 'u':
+                processUsage(left, right, obj);
+                break;
+            case '#':
+                // Comment.  Abort
+                break;
+            default:
+                if (debug) {
+                    CULogError("Unsupported OBJ command: %.*s",(int)(right-left),left);
+                }
+                break;
+            }
+        }
+    }
+    
+    buildGroups(obj);
+}
+
+/**
+ * Indexes the vertices of all render groups in the given model.
+ *
+ * This method processes the shape commands recorded while reading the
+ * OBJ file. The groups are split among the threads of this parser.
+ *
+ * @param obj   The current ModelInfo results
+ */
+void ObjParser::buildGroups(const std::shared_ptr<ModelInfo>& obj) {
+    size_t count = obj->groups.size();
+    if (_shapes.empty() || count == 0) {
+        _shapes.clear();
+        return;
+    }
+    
+    // Groups are only ever appended, so the commands of a group are contiguous
+    std::vector<size_t> offsets(count+1,0);
+    for(auto it = _shapes.begin(); it != _shapes.end(); ++it) {
+        offsets[it->group+1]++;
+    }
+    for(size_t ii = 0; ii < count; ii++) {
+        offsets[ii+1] += offsets[ii];
+    }
+
+    // Balance the tasks by command count, not group count
+    size_t total = _shapes.size();
+    Uint32 tasks = (Uint32)std::min(std::min((size_t)_threads, count), total/TASK_MIN_SHAPES);
+    tasks = std::max(tasks,(Uint32)1);
+    std::vector<size_t> ranges(tasks+1);
+    ranges[0] = 0;
+    for(Uint32 jj = 1; jj < tasks; jj++) {
+        auto it = std::lower_bound(offsets.begin(), offsets.end(), total*jj/tasks);
+        ranges[jj] = std::max((size_t)(it-offsets.begin()),ranges[jj-1]);
+    }
+    ranges[tasks] = count;
+    
+    // Each task indexes a contiguous range of groups
+    const ShapeLine* shapes = _shapes.data();
+    auto run = [&](Uint32 index) {
+        VertexTable table;
+        for(size_t ii = ranges[index]; ii < ranges[index+1]; ii++) {
+            if (offsets[ii] < offsets[ii+1]) {
+                buildGroup(obj->groups[ii].get(), shapes+offsets[ii], shapes+offsets[ii+1], table);
+            }
+        }
+    };
+    if (tasks > 1 && _workers != nullptr) {
+        _workers->parallelFor(tasks, run);
+    } else {
+        for(Uint32 ii = 0; ii < tasks; ii++) {
+            run(ii);
+        }
+    }
+    _shapes.clear();
+}
+
+/**
+ * Indexes the vertices of the given render group.
+ *
+ * @param group The render group to index
+ * @param begin The first shape command for this group
+ * @param end   The end of the shape commands for this group
+ * @param table The table for removing duplicate vertices
+ */
+void ObjParser::buildGroup(GroupInfo* group, const ShapeLine* begin, const ShapeLine* end,
+                           VertexTable& table) {
+    table.reset(end-begin);
+    
+    std::vector<GLuint>& indices = table.shape;
+    for(const ShapeLine* line = begin; line != end; ++line) {
+        indices.clear();
+        const char* curr = line->begin;
+        while (curr < line->end) {
+            VertexInfo vert;
+            const char* next = parseVertex(curr, line->end, vert);
+            if (vert.pindex != -1) {
+                indices.push_back(table.acquire(group, vert));
+            }
+            if (next == curr) {
+                break;
+            }
+            curr = next;
+        }
+        
+        switch (group->command) {
+        case GL_TRIANGLES:
+            // Faces are added as triangle fans
+            if (indices.size() >= 3) {
+                GLuint base = indices[0];
+                GLuint left = indices[1];
+                for(auto it = indices.begin()+2; it != indices.end(); ++it) {
+                    GLuint right = *it;
+                    group->indices.push_back(base);
+                    group->indices.push_back(left);
+                    group->indices.push_back(right);
+                    left = right;
+                }
+            }
+            break;
+        case GL_LINES:
+            // Lines are added as pairs
+            if (indices.size() >= 2) {
+                GLuint left = indices[0];
+                for(auto it = indices.begin()+1; it != indices.end(); ++it) {
+                    GLuint right = *it;
+                    group->indices.push_back(left);
+                    group->indices.push_back(right);
+                    left = right;
+                }
+            }
+            break;
+        case GL_POINTS:
+            // Points are added individually
+            group->indices.insert(group->indices.end(),indices.begin(),indices.end());
+            break;
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark OBJ Cache
+/**
+ * Returns true if the data begins with a cached OBJ model signature
+ *
+ * This is a quick test that does not validate the rest of the data.
+ *
+ * @param data  The data to test
+ * @param size  The number of bytes of data
+ *
+ * @return true if the data begins with a cached OBJ model signature
+ */
+bool ObjParser::isCache(const char* data, size_t size) {
+    return size >= CACHE_HEADER_SIZE && !std::memcmp(data, CU_OBJ_CACHE_MAGIC, 4);
+}
+
+/**
+ * Writes the given model to a binary cache file.
+ *
+ * The cache stores the positions, texture coordinates, normals, and
+ * render groups of the model, together with the names of the imported
+ * MTL libraries. It does not store the libraries themselves. The cache
+ * can be read by any of the methods that parse an OBJ file, which
+ * recognize it by its signature.
+ *
+ * @param model The model to save
+ * @param file  The path to the cache file
+ *
+ * @return true if the cache was successfully written
+ */
+bool ObjParser::writeCache(const std::shared_ptr<ModelInfo>& model, const std::string file) {
+    if (model == nullptr) {
+        return false;
+    }
+    
+    // All values are 32 bits, so estimate the bulk data up front
+    size_t estimate = CACHE_HEADER_SIZE+4*(3*model->positions.size()+
+                                           2*model->texcoords.size()+
+                                           3*model->normals.size());
+    for(auto it = model->groups.begin(); it != model->groups.end(); ++it) {
+        estimate += 4*(3*(*it)->vertices.size()+(*it)->indices.size());
+    }
+    std::vector<char> data;
+    data.reserve(estimate);
+    
+    data.insert(data.end(), CU_OBJ_CACHE_MAGIC, CU_OBJ_CACHE_MAGIC+4);
+    put32(data, CU_OBJ_CACHE_VERSION);
+    put32(data, (Uint32)model->positions.size());
+    put32(data, (Uint32)model->texcoords.size());
+    put32(data, (Uint32)model->normals.size());
+    put32(data, (Uint32)model->groups.size());
+    put32(data, (Uint32)model->libraries.size());
+    put32(data, 0); // Reserved
+    
+    put_floats(data, reinterpret_cast<const float*>(model->positions.data()), 3*model->positions.size());
+    put_floats(data, reinterpret_cast<const float*>(model->texcoords.data()), 2*model->texcoords.size());
+    put_floats(data, reinterpret_cast<const float*>(model->normals.data()), 3*model->normals.size());
+    put_string(data, model->material);
+    for(auto it = model->libraries.begin(); it != model->libraries.end(); ++it) {
+        put_string(data, it->first);
+    }
+    
+    for(auto it = model->groups.begin(); it != model->groups.end(); ++it) {
+        const GroupInfo* group = it->get();
+        put32(data, group->index);
+        put32(data, group->command);
+        put_string(data, group->object);
+        put_string(data, group->material);
+        put32(data, (Uint32)group->tags.size());
+        for(auto jt = group->tags.begin(); jt != group->tags.end(); ++jt) {
+            put_string(data, *jt);
+        }
+        put32(data, (Uint32)group->vertices.size());
+        for(auto jt = group->vertices.begin(); jt != group->vertices.end(); ++jt) {
+            put32(data, (Uint32)jt->pindex);
+            put32(data, (Uint32)jt->tindex);
+            put32(data, (Uint32)jt->nindex);
+        }
+        put32(data, (Uint32)group->indices.size());
+        for(auto jt = group->indices.begin(); jt != group->indices.end(); ++jt) {
+            put32(data, *jt);
+        }
+    }
+    
+    std::shared_ptr<BinaryWriter> writer = BinaryWriter::alloc(file);
+    if (writer == nullptr) {
+        return false;
+    }
+    writer->write(data.data(), data.size());
+    writer->close();
+    return true;
+}
+
+/**
+ * Reads a binary cache into the given model.
+ *
+ * This method returns false if the data is not a valid cache.
+ *
+ * @param begin The start of the file data
+ * @param end   The end of the file data
+ * @param obj   The current ModelInfo results
+ *
+ * @return true if the cache was successfully read
+ */
+bool ObjParser::parseCache(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj) {
+    if (!isCache(begin, end-begin)) {
+        return false;
+    }
+    
+    const char* curr = begin+4;
+    Uint32 version, positions, texcoords, normals, groups, libraries, reserved;
+    get32(curr, end, version);
+    get32(curr, end, positions);
+    get32(curr, end, texcoords);
+    get32(curr, end, normals);
+    get32(curr, end, groups);
+    get32(curr, end, libraries);
+    get32(curr, end, reserved);
+    if (version != CU_OBJ_CACHE_VERSION) {
+        CULogError("Unsupported OBJ cache version %u", version);
+        return false;
+    }
+    
+    // Check the sizes before allocating anything
+    size_t remain = (end-curr)/sizeof(Uint32);
+    if (remain < 3*(size_t)positions+2*(size_t)texcoords+3*(size_t)normals) {
+        return false;
+    }
+    obj->positions.resize(positions);
+    obj->texcoords.resize(texcoords);
+    obj->normals.resize(normals);
+    get_floats(curr, end, reinterpret_cast<float*>(obj->positions.data()), 3*(size_t)positions);
+    get_floats(curr, end, reinterpret_cast<float*>(obj->texcoords.data()), 2*(size_t)texcoords);
+    get_floats(curr, end, reinterpret_cast<float*>(obj->normals.data()), 3*(size_t)normals);
+    if (!get_string(curr, end, obj->material)) {
+        return false;
+    }
+    
+    std::string name;
+    for(Uint32 ii = 0; ii < libraries; ii++) {
+        if (!get_string(curr, end, name)) {
+            return false;
+        }
+        obj->libraries[name] = nullptr;
+    }
+    
+    Uint32 value;
+    for(Uint32 ii = 0; ii < groups; ii++) {
+        std::shared_ptr<GroupInfo> group = std::make_shared<GroupInfo>();
+        if (!get32(curr, end, group->index) || !get32(curr, end, value)) {
+            return false;
+        }
+        group->command = value;
+        if (!get_string(curr, end, group->object) ||
+            !get_string(curr, end, group->material) ||
+            !get32(curr, end, value)) {
+            return false;
+        }
+        for(Uint32 jj = 0; jj < value; jj++) {
+            if (!get_string(curr, end, name)) {
+                return false;
+            }
+            group->tags.emplace(name);
+        }
+        
+        if (!get32(curr, end, value) || (size_t)(end-curr)/(3*sizeof(Uint32)) < value) {
+            return false;
+        }
+        group->vertices.resize(value);
+        for(auto jt = group->vertices.begin(); jt != group->vertices.end(); ++jt) {
+            Uint32 index;
+            get32(curr, end, index);
+            jt->pindex = (int)index;
+            get32(curr, end, index);
+            jt->tindex = (int)index;
+            get32(curr, end, index);
+            jt->nindex = (int)index;
+            if (jt->pindex < 0 || jt->pindex >= (int)positions ||
+                jt->tindex < -1 || jt->tindex >= (int)texcoords ||
+                jt->nindex < -1 || jt->nindex >= (int)normals) {
+                return false;
+            }
+        }
+        
+        if (!get32(curr, end, value) || (size_t)(end-curr)/sizeof(Uint32) < value) {
+            return false;
+        }
+        group->indices.resize(value);
+        for(auto jt = group->indices.begin(); jt != group->indices.end(); ++jt) {
+            get32(curr, end, *jt);
+            if (*jt >= group->vertices.size()) {
+                return false;
+            }
+        }
+        obj->groups.push_back(group);
+    }
+    return true;
+}
+
 #pragma mark -
 #pragma mark OBJ Data
 /**
@@ -416,7 +1223,7 @@ void ObjParser::clear() {
  */
 void ObjParser::processObject(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj) {
     if (begin+1 == end || !isSkippable(*(begin+1))) {
-        if (debug) CULogError("Unrecognized OBJ command: %s",begin);
+        if (debug) CULogError("Unrecognized OBJ command: %.*s",(int)(end-begin),begin);
         return;
     }
      
@@ -429,7 +1236,7 @@ void ObjParser::processObject(const char* begin, const char* end, const std::sha
         right++;
     }
     if (left == right) {
-        if (debug) CULogError("Invalid object name: %s",begin);
+        if (debug) CULogError("Invalid object name: %.*s",(int)(end-begin),begin);
         return;
     }
 
@@ -450,7 +1257,7 @@ void ObjParser::processImport(const char* begin, const char* end, const std::sha
     size_t len = strlen(key);
     
     if (begin+len+1 >= end) {
-        if (debug) CULogError("Unrecognized OBJ command: %s",begin);
+        if (debug) CULogError("Unrecognized OBJ command: %.*s",(int)(end-begin),begin);
         return;
     }
     
@@ -458,7 +1265,7 @@ void ObjParser::processImport(const char* begin, const char* end, const std::sha
     memcpy(command, begin, len);
     command[len] = 0;
     if (strcmp(command, key) != 0) {
-        if (debug) CULogError("Unrecognized OBJ command: %s",begin);
+        if (debug) CULogError("Unrecognized OBJ command: %.*s",(int)(end-begin),begin);
     }
     
     const char* left = begin+len;
@@ -470,7 +1277,7 @@ void ObjParser::processImport(const char* begin, const char* end, const std::sha
         right++;
     }
     if (left == right) {
-        if (debug) CULogError("Invalid library name: %s",begin);
+        if (debug) CULogError("Invalid library name: %.*s",(int)(end-begin),begin);
         return;
     }
 
@@ -489,7 +1296,7 @@ void ObjParser::processImport(const char* begin, const char* end, const std::sha
  */
 void ObjParser::processVertex(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj) {
     if (begin+1 == end) {
-        if (debug) CULogError("Unrecognized vertex command: %s",begin);
+        if (debug) CULogError("Unrecognized vertex command: %.*s",(int)(end-begin),begin);
         return;
     }
     
@@ -503,30 +1310,15 @@ void ObjParser::processVertex(const char* begin, const char* end, const std::sha
                 processTexCoord(begin, end, obj);
                 break;
             default:
-                if (debug) CULogError("Unsupported vertex command: %s",begin);
+                if (debug) CULogError("Unsupported vertex command: %.*s",(int)(end-begin),begin);
                 break;
         }
         return;
     }
     
     float data[3];
-    int index = 0;
-    
-    const char* curr = begin+1;
-    while(index < 3) {
-        while (curr != end && isSkippable(*curr) && *curr != '#') {
-            curr++;
-        }
-        if (curr == end || *curr == '#') {
-            index = 4;
-        }
-        char* right;
-        data[index++] = std::strtof(curr,&right);
-        curr = right;
-    }
-    
-    if (index == 4) {
-        if (debug) CULogError("Could not parse command: %s",begin);
+    if (!parse_floats(begin+1, end, data, 3)) {
+        if (debug) CULogError("Could not parse command: %.*s",(int)(end-begin),begin);
         return;
     }
 
@@ -546,28 +1338,13 @@ void ObjParser::processVertex(const char* begin, const char* end, const std::sha
  */
 void ObjParser::processTexCoord(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj) {
     if (begin+2 >= end || !isSkippable(*(begin+2))) {
-        if (debug) CULogError("Unrecognized tex coord command: %s",begin);
+        if (debug) CULogError("Unrecognized tex coord command: %.*s",(int)(end-begin),begin);
         return;
     }
     
     float data[2];
-    int index = 0;
-    
-    const char* curr = begin+2;
-    while(index < 2) {
-        while (curr != end && isSkippable(*curr) && *curr != '#') {
-            curr++;
-        }
-        if (curr == end || *curr == '#') {
-            index = 3;
-        }
-        char* right;
-        data[index++] = std::strtof(curr,&right);
-        curr = right;
-    }
-    
-    if (index == 3) {
-        if (debug) CULogError("Could not parse command: %s",begin);
+    if (!parse_floats(begin+2, end, data, 2)) {
+        if (debug) CULogError("Could not parse command: %.*s",(int)(end-begin),begin);
         return;
     }
 
@@ -586,28 +1363,13 @@ void ObjParser::processTexCoord(const char* begin, const char* end, const std::s
  */
 void ObjParser::processNormal(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj) {
     if (begin+2 >= end || !isSkippable(*(begin+2))) {
-        if (debug) CULogError("Unrecognized normal command: %s",begin);
+        if (debug) CULogError("Unrecognized normal command: %.*s",(int)(end-begin),begin);
         return;
     }
     
     float data[3];
-    int index = 0;
-    
-    const char* curr = begin+2;
-    while(index < 3) {
-        while (curr != end && isSkippable(*curr) && *curr != '#') {
-            curr++;
-        }
-        if (curr == end || *curr == '#') {
-            index = 4;
-        }
-        char* right;
-        data[index++] = std::strtof(curr,&right);
-        curr = right;
-    }
-    
-    if (index == 4) {
-        if (debug) CULogError("Could not parse command: %s",begin);
+    if (!parse_floats(begin+2, end, data, 3)) {
+        if (debug) CULogError("Could not parse command: %.*s",(int)(end-begin),begin);
         return;
     }
     
@@ -630,7 +1392,7 @@ void ObjParser::processUsage(const char* begin, const char* end, const std::shar
     size_t len = strlen(key);
     
     if (begin+len+1 >= end) {
-        if (debug) CULogError("Unrecognized OBJ command: %s",begin);
+        if (debug) CULogError("Unrecognized OBJ command: %.*s",(int)(end-begin),begin);
         return;
     }
     
@@ -638,7 +1400,7 @@ void ObjParser::processUsage(const char* begin, const char* end, const std::shar
     memcpy(command, begin, len);
     command[len] = 0;
     if (strcmp(command, key) != 0) {
-        if (debug) CULogError("Unrecognized OBJ command: %s",begin);
+        if (debug) CULogError("Unrecognized OBJ command: %.*s",(int)(end-begin),begin);
     }
     
     // Get the name
@@ -651,7 +1413,7 @@ void ObjParser::processUsage(const char* begin, const char* end, const std::shar
         right++;
     }
     if (left == right) {
-        if (debug) CULogError("Invalid material name: %s",begin);
+        if (debug) CULogError("Invalid material name: %.*s",(int)(end-begin),begin);
         return;
     }
 
@@ -673,7 +1435,7 @@ void ObjParser::processUsage(const char* begin, const char* end, const std::shar
  */
 void ObjParser::processGroup(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj) {
     if (begin+1 == end || !isSkippable(*(begin+1))) {
-        if (debug) CULogError("Unrecognized OBJ command: %s",begin);
+        if (debug) CULogError("Unrecognized OBJ command: %.*s",(int)(end-begin),begin);
         return;
     }
     
@@ -710,15 +1472,17 @@ void ObjParser::processGroup(const char* begin, const char* end, const std::shar
  */
 void ObjParser::processSmooth(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj)  {
     if (begin+1 == end || !isSkippable(*(begin+1))) {
-        if (debug) CULogError("Unrecognized OBJ command: %s",begin);
+        if (debug) CULogError("Unrecognized OBJ command: %.*s",(int)(end-begin),begin);
         return;
     }
     
-    const char* curr = begin+2;
-    char* right;
-    unsigned index = (unsigned)std::strtoul(curr,&right,10);
-    if (curr == right) {
-        if (debug) CULogError("Unrecognized index: %s",begin);
+    const char* curr = begin+1;
+    while (curr != end && isSkippable(*curr)) {
+        curr++;
+    }
+    unsigned index;
+    if (parse_uint(curr, end, index) == curr) {
+        if (debug) CULogError("Unrecognized index: %.*s",(int)(end-begin),begin);
         return;
     }
     
@@ -727,149 +1491,36 @@ void ObjParser::processSmooth(const char* begin, const char* end, const std::sha
 }
 
 /**
- * Processes a line representing an "f" command in an OBJ file.
+ * Processes a line representing an "f", "l", or "p" command in an OBJ file.
  *
- * @param begin The start of the line
- * @param end   The end of the line
- * @param obj   The current ModelInfo results
- */
-void ObjParser::processFace(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj) {
-    if (begin+1 == end || !isSkippable(*(begin+1))) {
-        if (debug) CULogError("Unrecognized OBJ command: %s",begin);
-        return;
-    }
-    
-    // Get the current group
-    std::shared_ptr<GroupInfo> group = obj->currentGroup();
-    if (group == nullptr || (group->command != GL_FALSE && group->command != GL_TRIANGLES)) {
-        group = obj->acquireGroup();
-    }
-    
-    const char* curr = begin+2;
-    GLuint count = (GLuint)group->vertCache.size();
-    std::vector<GLuint> indices;
-    while (curr < end) {
-        VertexInfo vert;
-        curr = parseVertex(curr, end, vert);
-        if (vert.pindex != -1) {
-            // Search for it in the index
-            auto find = group->vertCache.find(vert);
-            if (find == group->vertCache.end()) {
-                indices.push_back(count);
-                group->vertices.push_back(vert);
-                group->vertCache[vert] = count++;
-            } else {
-                indices.push_back(find->second);
-            }
-        }
-    }
-    
-    // Faces are added as triangle fans
-    group->command = GL_TRIANGLES;
-    group->touched = false;
-    GLuint base = indices[0];
-    GLuint left = indices[1];
-    for(auto it = indices.begin()+2; it != indices.end(); ++it) {
-        GLuint right = *it;
-        group->indices.push_back(base);
-        group->indices.push_back(left);
-        group->indices.push_back(right);
-        left = right;
-    }
-}
-
-/**
- * Processes a line representing an "l" command in an OBJ file.
+ * The line is recorded for the current render group, and is not indexed
+ * until {@link #buildGroups}.
  *
- * @param begin The start of the line
- * @param end   The end of the line
- * @param obj   The current ModelInfo results
+ * @param begin     The start of the line
+ * @param end       The end of the line
+ * @param command   The drawing command for the line
+ * @param obj       The current ModelInfo results
  */
-void ObjParser::processLine(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj) {
+void ObjParser::processShape(const char* begin, const char* end, GLenum command,
+                             const std::shared_ptr<ModelInfo>& obj) {
     if (begin+1 == end || !isSkippable(*(begin+1))) {
-        if (debug) CULogError("Unrecognized OBJ command: %s",begin);
+        if (debug) CULogError("Unrecognized OBJ command: %.*s",(int)(end-begin),begin);
         return;
     }
     
     // Get the current group
     std::shared_ptr<GroupInfo> group = obj->currentGroup();
-    if (group == nullptr || (group->command != GL_FALSE && group->command != GL_LINES)) {
+    if (group == nullptr || (group->command != GL_FALSE && group->command != command)) {
         group = obj->acquireGroup();
     }
-    
-    const char* curr = begin+2;
-    GLuint count = (GLuint)group->vertCache.size();
-    std::vector<GLuint> indices;
-    while (curr < end) {
-        VertexInfo vert;
-        curr = parseVertex(curr, end, vert);
-        if (vert.pindex != -1) {
-            // Search for it in the index
-            auto find = group->vertCache.find(vert);
-            if (find == group->vertCache.end()) {
-                indices.push_back(count);
-                group->vertices.push_back(vert);
-                group->vertCache[vert] = count++;
-            } else {
-                indices.push_back(find->second);
-            }
-        }
-    }
-    
-    // Lines are added as pairs
-    group->command = GL_LINES;
+    group->command = command;
     group->touched = false;
-    GLuint left = indices[0];
-    for(auto it = indices.begin()+1; it != indices.end(); ++it) {
-        GLuint right = *it;
-        group->indices.push_back(left);
-        group->indices.push_back(right);
-        left = right;
-    }
-}
-
-/**
- * Processes a line representing a "p" command in an OBJ file.
- *
- * @param begin The start of the line
- * @param end   The end of the line
- * @param obj   The current ModelInfo results
- */
-void ObjParser::processPoints(const char* begin, const char* end, const std::shared_ptr<ModelInfo>& obj) {
-    if (begin+1 == end || !isSkippable(*(begin+1))) {
-        if (debug) CULogError("Unrecognized OBJ command: %s",begin);
-        return;
-    }
-    
-    // Get the current group
-    std::shared_ptr<GroupInfo> group = obj->currentGroup();
-    if (group == nullptr || (group->command != GL_FALSE && group->command != GL_POINTS)) {
-        group = obj->acquireGroup();
-    }
-    
-    const char* curr = begin+2;
-    GLuint count = (GLuint)group->vertCache.size();
-    std::vector<GLuint> indices;
-    while (curr < end) {
-        VertexInfo vert;
-        curr = parseVertex(curr, end, vert);
-        if (vert.pindex != -1) {
-            // Search for it in the index
-            auto find = group->vertCache.find(vert);
-            if (find == group->vertCache.end()) {
-                indices.push_back(count);
-                group->vertices.push_back(vert);
-                group->vertCache[vert] = count++;
-            } else {
-                indices.push_back(find->second);
-            }
-        }
-    }
     
-    // Points are added individually
-    group->command = GL_POINTS;
-    group->touched = false;
-    group->indices.insert(group->indices.end(),indices.begin(),indices.end());
+    ShapeLine line;
+    line.group = obj->groups.size()-1;
+    line.begin = begin+2;
+    line.end = end;
+    _shapes.push_back(line);
 }
 
 #pragma mark -
@@ -887,7 +1538,7 @@ void ObjParser::processMaterial(const char* begin, const char* end, const std::s
     size_t len = strlen(key);
     
     if (begin+len+1 >= end) {
-        if (debug) CULogError("Unrecognized MTL command: %s",begin);
+        if (debug) CULogError("Unrecognized MTL command: %.*s",(int)(end-begin),begin);
         return;
     }
     
@@ -895,7 +1546,7 @@ void ObjParser::processMaterial(const char* begin, const char* end, const std::s
     memcpy(command, begin, len);
     command[len] = 0;
     if (strcmp(command, key) != 0) {
-        if (debug) CULogError("Unrecognized MTL command: %s",begin);
+        if (debug) CULogError("Unrecognized MTL command: %.*s",(int)(end-begin),begin);
     }
     
     // Get the name
@@ -908,7 +1559,7 @@ void ObjParser::processMaterial(const char* begin, const char* end, const std::s
         right++;
     }
     if (left == right) {
-        if (debug) CULogError("Invalid material name: %s",begin);
+        if (debug) CULogError("Invalid material name: %.*s",(int)(end-begin),begin);
         return;
     }
 
@@ -929,7 +1580,7 @@ void ObjParser::processIllum(const char* begin, const char* end, const std::shar
     size_t len = strlen(key);
     
     if (begin+len+1 >= end) {
-        if (debug) CULogError("Unrecognized MTL command: %s",begin);
+        if (debug) CULogError("Unrecognized MTL command: %.*s",(int)(end-begin),begin);
         return;
     }
     
@@ -937,14 +1588,16 @@ void ObjParser::processIllum(const char* begin, const char* end, const std::shar
     memcpy(command, begin, len);
     command[len] = 0;
     if (strcmp(command, key) != 0) {
-        if (debug) CULogError("Unrecognized MTL command: %s",begin);
+        if (debug) CULogError("Unrecognized MTL command: %.*s",(int)(end-begin),begin);
     }
     
     const char* curr = begin+len;
-    char* right;
-    unsigned illum = (GLuint)std::strtoul(curr,&right,10);
-    if (curr == right) {
-        if (debug) CULogError("Unrecognized illum: %s",begin);
+    while (curr != end && isSkippable(*curr)) {
+        curr++;
+    }
+    unsigned illum;
+    if (parse_uint(curr, end, illum) == curr) {
+        if (debug) CULogError("Unrecognized illum: %.*s",(int)(end-begin),begin);
         return;
     }
     
@@ -969,7 +1622,7 @@ void ObjParser::processShininess(const char* begin, const char* end, const std::
     size_t len = strlen(key);
     
     if (begin+len+1 >= end) {
-        if (debug) CULogError("Unrecognized MTL command: %s",begin);
+        if (debug) CULogError("Unrecognized MTL command: %.*s",(int)(end-begin),begin);
         return;
     }
     
@@ -977,14 +1630,16 @@ void ObjParser::processShininess(const char* begin, const char* end, const std::
     memcpy(command, begin, len);
     command[len] = 0;
     if (strcmp(command, key) != 0) {
-        if (debug) CULogError("Unrecognized MTL command: %s",begin);
+        if (debug) CULogError("Unrecognized MTL command: %.*s",(int)(end-begin),begin);
     }
     
     const char* curr = begin+len;
-    char* right;
-    float ns = std::strtof(curr,&right);
-    if (curr == right) {
-        if (debug) CULogError("Unrecognized shininess: %s",begin);
+    while (curr != end && isSkippable(*curr)) {
+        curr++;
+    }
+    float ns;
+    if (parse_float(curr, end, ns) == curr) {
+        if (debug) CULogError("Unrecognized shininess: %.*s",(int)(end-begin),begin);
         return;
     }
     
@@ -1025,34 +1680,19 @@ void ObjParser::processColor(const char* begin, const char* end, const std::shar
             color = &(material->Ks);
             break;
         default:
-            if (debug) CULogError("Unrecognized MTL command: %s",begin);
+            if (debug) CULogError("Unrecognized MTL command: %.*s",(int)(end-begin),begin);
             return;
     }
     
     suff = *(begin+2);
     if (!isSkippable(suff)) {
-        if (debug) CULogError("Unrecognized MTL command: %s",begin);
+        if (debug) CULogError("Unrecognized MTL command: %.*s",(int)(end-begin),begin);
         return;
     }
     
     float data[3];
-    int index = 0;
-    
-    const char* curr = begin+2;
-    while(index < 3) {
-        while (curr != end && isSkippable(*curr) && *curr != '#') {
-            curr++;
-        }
-        if (curr == end || *curr == '#') {
-            index = 4;
-        }
-        char* right;
-        data[index++] = std::strtof(curr,&right);
-        curr = right;
-    }
-    
-    if (index == 4) {
-        if (debug) CULogError("Could not parse command: %s",begin);
+    if (!parse_floats(begin+2, end, data, 3)) {
+        if (debug) CULogError("Could not parse command: %.*s",(int)(end-begin),begin);
         return;
     }
 
@@ -1180,31 +1820,32 @@ const char* ObjParser::parseVertex(const char* begin, const char* end, VertexInf
     while (left != end && isSkippable(*left)) {
         left++;
     }
-    char* right;
+    if (left == end || *left == '#') {
+        return end;
+    }
     
-    info.pindex = (int)std::strtoul(left,&right,10)-1;
+    Uint32 index;
+    const char* right = parse_uint(left, end, index);
     if (left == right) {
-        info.pindex = -1;
+        // Skip the unsupported token (e.g. a relative index)
+        while (right != end && !isSkippable(*right)) {
+            right++;
+        }
+        return right;
     }
+    info.pindex = (int)index-1;
 
-    left = right;
-    if (left != end && *left == '/') {
-        left++;
-        info.tindex = (int)std::strtoul(left,&right,10)-1;
-        if (left == right) {
-            info.tindex = -1;
-        }
+    if (right != end && *right == '/') {
+        left = right+1;
+        right = parse_uint(left, end, index);
+        info.tindex = left == right ? -1 : (int)index-1;
     }
 
-    left = right;
-    if (left != end && *left == '/') {
-        left++;
-        info.nindex = (int)std::strtoul(left,&right,10)-1;
-        if (left == right) {
-            info.nindex = -1;
-        }
+    if (right != end && *right == '/') {
+        left = right+1;
+        right = parse_uint(left, end, index);
+        info.nindex = left == right ? -1 : (int)index-1;
     }
     
-    //CULog("%d/%d/%d",pindex,tindex,nindex);
     return right;
 }
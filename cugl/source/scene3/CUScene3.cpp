@@ -50,6 +50,10 @@
 #define DEFAULT_NEAR 0.1f
 /** Default distance of initial camera on Z-axis */
 #define DEFAULT_POS  2.0f
+/** The maximum number of nodes in a leaf of the volume hierarchy */
+#define CULL_LEAF_SIZE  4
+/** The growth in hierarchy surface area that triggers a rebuild */
+#define CULL_REBUILD_FACTOR 1.5f
 
 using namespace cugl;
 using namespace cugl::scene3;
@@ -65,7 +69,14 @@ using namespace cugl::scene3;
 Scene3::Scene3() :
 _camera(nullptr),
 _name(""),
-_active(false)
+_active(false),
+_culling(true),
+_restructure(true),
+_area(0),
+_basearea(0),
+_tested(0),
+_culled(0),
+_submitted(0)
 {}
 
 /**
@@ -79,6 +90,18 @@ void Scene3::dispose() {
     _camera = nullptr;
     _name = "";
     _active = false;
+    _culling = true;
+    _entries.clear();
+    _volumes.clear();
+    _order.clear();
+    _dirty.clear();
+    _restructure = true;
+    _centers.clear();
+    _area = 0;
+    _basearea = 0;
+    _tested = 0;
+    _culled = 0;
+    _submitted = 0;
 }
 
 /**
@@ -373,35 +396,342 @@ void Scene3::removeAllChildren() {
  * tree traversal algorithm ( https://en.wikipedia.org/wiki/Tree_traversal#Pre-order ).
  * That means that parents are always draw before children.
  *
- * @param pipeline  The pipeline to draw with.
+ * The traversal is cached, so only the nodes whose transforms have changed
+ * since the last call have their world transforms recomputed. If culling is
+ * enabled, nodes outside of the camera frustum are not submitted.
  */
 void Scene3::render() {
     if (_pipeline == nullptr) {
         return;
     }
-    for(auto it = _children.begin(); it != _children.end(); ++it) {
-        traverse(*it, Mat4::IDENTITY);
+    
+    if (_restructure) {
+        flatten();
+    } else {
+        refresh();
+    }
+    
+    _tested = 0;
+    _culled = 0;
+    _submitted = 0;
+    if (_culling) {
+        cull();
+    }
+    
+    for(auto it = _entries.begin(); it != _entries.end(); ++it) {
+        if (!_culling || it->visible) {
+            _pipeline->append(it->node, it->world);
+            _submitted++;
+        }
     }
 
     _pipeline->flush(_camera);
 }
 
+#pragma mark -
+#pragma mark Culling
 /**
- * Recursively adds the given scene graph node to the pipeline.
+ * Expands the box (lower,upper) to contain the box (lo,hi).
  *
- * This method is uses to add nodes to the {@link Scene3Pipeline} by
- * recursively traversing the tree.
+ * @param lower The minimum corner of the box to expand
+ * @param upper The maximum corner of the box to expand
+ * @param lo    The minimum corner of the box to contain
+ * @param hi    The maximum corner of the box to contain
+ */
+static void expand(Vec3& lower, Vec3& upper, const Vec3& lo, const Vec3& hi) {
+    lower.x = std::min(lower.x, lo.x);
+    lower.y = std::min(lower.y, lo.y);
+    lower.z = std::min(lower.z, lo.z);
+    upper.x = std::max(upper.x, hi.x);
+    upper.y = std::max(upper.y, hi.y);
+    upper.z = std::max(upper.z, hi.z);
+}
+
+/**
+ * Returns the surface area of the box (lower,upper).
+ *
+ * The total surface area of a volume hierarchy is proportional to the
+ * expected cost of traversing it.
+ *
+ * @param lower The minimum corner of the box
+ * @param upper The maximum corner of the box
+ *
+ * @return the surface area of the box (lower,upper).
+ */
+static float area(const Vec3& lower, const Vec3& upper) {
+    Vec3 size = upper-lower;
+    return 2*(size.x*size.y+size.y*size.z+size.z*size.x);
+}
+
+/**
+ * Rebuilds the flattened scene graph and the volume hierarchy.
+ */
+void Scene3::flatten() {
+    _entries.clear();
+    for(auto it = _children.begin(); it != _children.end(); ++it) {
+        flatten(*it, -1);
+    }
+    
+    _order.clear();
+    for(Uint32 ii = 0; ii < _entries.size(); ii++) {
+        if (_entries[ii].bounded) {
+            _order.push_back(ii);
+        }
+    }
+    
+    rebuild();
+    _dirty.clear();
+    _restructure = false;
+}
+
+/**
+ * Recursively adds the given scene graph node to the flattened scene graph.
  *
  * @param node      The current node in the traversal.
- * @param transform The global transformation matrix.
+ * @param parent    The entry of the parent node (-1 if a child of the scene)
  */
-void Scene3::traverse(const std::shared_ptr<SceneNode>& node,
-                      const Mat4& transform) {
-    Mat4 matrix;
-    Mat4::multiply(transform, node->getModelMatrix(), &matrix);
-    _pipeline->append(node,matrix);
-    auto kids = node->getChildren();
-    for(auto it = kids.begin(); it != kids.end(); ++it) {
-        traverse(*it, matrix);
+void Scene3::flatten(const std::shared_ptr<SceneNode>& node, int parent) {
+    Uint32 slot = (Uint32)_entries.size();
+    _entries.emplace_back();
+    
+    CullEntry* entry = &_entries.back();
+    entry->node = node;
+    entry->parent = parent;
+    entry->volume = -1;
+    entry->visible = true;
+    entry->bounded = node->getBoundingBox(entry->local0, entry->local1);
+    node->_cullslot = slot;
+    refresh(slot);
+    
+    // The recursion may reallocate the entries
+    for(auto it = node->_children.begin(); it != node->_children.end(); ++it) {
+        flatten(*it, (int)slot);
+    }
+    _entries[slot].last = (Uint32)_entries.size();
+}
+
+/**
+ * Updates the world transform and bounding box for the given entry.
+ *
+ * This method assumes that the parent of this entry is up to date.
+ *
+ * @param slot  The entry to update
+ */
+void Scene3::refresh(Uint32 slot) {
+    CullEntry* entry = &_entries[slot];
+    if (entry->parent < 0) {
+        entry->world = entry->node->getModelMatrix();
+    } else {
+        // The parent transform is applied after the model matrix
+        Mat4::multiply(entry->node->getModelMatrix(), _entries[entry->parent].world, &entry->world);
+    }
+    
+    if (!entry->bounded) {
+        return;
+    }
+    
+    // Transform the box center, and project the extents onto each axis
+    const float* m = entry->world.m;
+    Vec3 center = (entry->local0+entry->local1)*0.5f;
+    Vec3 extent = (entry->local1-entry->local0)*0.5f;
+    Vec3 middle;
+    Mat4::transform(entry->world, center, &middle);
+    Vec3 radius(std::fabs(m[0])*extent.x+std::fabs(m[4])*extent.y+std::fabs(m[8])*extent.z,
+                std::fabs(m[1])*extent.x+std::fabs(m[5])*extent.y+std::fabs(m[9])*extent.z,
+                std::fabs(m[2])*extent.x+std::fabs(m[6])*extent.y+std::fabs(m[10])*extent.z);
+    entry->lower = middle-radius;
+    entry->upper = middle+radius;
+}
+
+/**
+ * Updates all entries whose transforms have changed since the last render.
+ *
+ * This method refits the volume hierarchy to the moved bounding boxes. If
+ * refitting has made the hierarchy too expensive to traverse, the hierarchy
+ * is rebuilt instead.
+ */
+void Scene3::refresh() {
+    if (_dirty.empty()) {
+        return;
+    }
+    
+    // Each subtree is a contiguous range, so sorting lets us skip nested ranges
+    std::sort(_dirty.begin(), _dirty.end());
+    Uint32 covered = 0;
+    for(auto it = _dirty.begin(); it != _dirty.end(); ++it) {
+        if (*it < covered) {
+            continue;
+        }
+        covered = _entries[*it].last;
+        for(Uint32 ii = *it; ii < covered; ii++) {
+            refresh(ii);
+            int volume = _entries[ii].volume;
+            while (volume >= 0 && !_volumes[volume].dirty) {
+                _volumes[volume].dirty = true;
+                volume = _volumes[volume].parent;
+            }
+        }
+    }
+    _dirty.clear();
+    
+    // Children always follow their parents, so refit in reverse order
+    for(int ii = (int)_volumes.size()-1; ii >= 0; ii--) {
+        CullVolume* volume = &_volumes[ii];
+        if (!volume->dirty) {
+            continue;
+        }
+        
+        _area -= area(volume->lower, volume->upper);
+        volume->dirty = false;
+        if (volume->right < 0) {
+            CullEntry* entry = &_entries[_order[volume->start]];
+            volume->lower = entry->lower;
+            volume->upper = entry->upper;
+            for(Uint32 jj = 1; jj < volume->count; jj++) {
+                entry = &_entries[_order[volume->start+jj]];
+                expand(volume->lower, volume->upper, entry->lower, entry->upper);
+            }
+        } else {
+            CullVolume* left  = &_volumes[ii+1];
+            CullVolume* right = &_volumes[volume->right];
+            volume->lower = left->lower;
+            volume->upper = left->upper;
+            expand(volume->lower, volume->upper, right->lower, right->upper);
+        }
+        _area += area(volume->lower, volume->upper);
+    }
+    
+    if (_area > CULL_REBUILD_FACTOR*_basearea) {
+        rebuild();
+    }
+}
+
+/**
+ * Rebuilds the volume hierarchy from the current bounding boxes.
+ *
+ * This method does not change the flattened scene graph.
+ */
+void Scene3::rebuild() {
+    // Cache the centers (doubled) to keep the partitioning in cache
+    _centers.resize(_entries.size());
+    for(auto it = _order.begin(); it != _order.end(); ++it) {
+        _centers[*it] = _entries[*it].lower+_entries[*it].upper;
+    }
+    
+    _volumes.clear();
+    _area = 0;
+    if (!_order.empty()) {
+        build(0, (Uint32)_order.size(), -1);
+    }
+    _basearea = _area;
+}
+
+/**
+ * Recursively builds the volume hierarchy for a range of the entry order.
+ *
+ * @param start     The start of the range in the bounded entry order
+ * @param count     The number of bounded entries in the range
+ * @param parent    The parent volume (-1 if root)
+ *
+ * @return the index of the new volume
+ */
+int Scene3::build(Uint32 start, Uint32 count, int parent) {
+    int index = (int)_volumes.size();
+    _volumes.emplace_back();
+    
+    // Compute the bounds of the boxes and of their centers
+    Vec3 lower = _entries[_order[start]].lower;
+    Vec3 upper = _entries[_order[start]].upper;
+    Vec3 clower = _centers[_order[start]];
+    Vec3 cupper = clower;
+    for(Uint32 ii = 1; ii < count; ii++) {
+        const CullEntry& entry = _entries[_order[start+ii]];
+        const Vec3& center = _centers[_order[start+ii]];
+        expand(lower, upper, entry.lower, entry.upper);
+        expand(clower, cupper, center, center);
+    }
+    
+    CullVolume* volume = &_volumes[index];
+    volume->lower = lower;
+    volume->upper = upper;
+    volume->parent = parent;
+    volume->right = -1;
+    volume->start = start;
+    volume->count = count;
+    volume->dirty = false;
+    _area += area(lower, upper);
+    if (count <= CULL_LEAF_SIZE) {
+        for(Uint32 ii = 0; ii < count; ii++) {
+            _entries[_order[start+ii]].volume = index;
+        }
+        return index;
+    }
+    
+    // Split at the median center along the longest axis
+    Vec3 span = cupper-clower;
+    int axis = (span.x >= span.y && span.x >= span.z) ? 0 : (span.y >= span.z ? 1 : 2);
+    Uint32 half = count/2;
+    auto first = _order.begin()+start;
+    const Vec3* centers = _centers.data();
+    std::nth_element(first, first+half, first+count,
+                     [centers,axis](Uint32 a, Uint32 b) {
+                         const float* ca = &centers[a].x;
+                         const float* cb = &centers[b].x;
+                         return ca[axis] < cb[axis];
+                     });
+    
+    // The vector may reallocate, so do not hold the pointer
+    build(start, half, index);
+    int right = build(start+half, count-half, index);
+    _volumes[index].right = right;
+    return index;
+}
+
+/**
+ * Marks all entries outside of the camera frustum as not visible.
+ *
+ * This method updates the culling statistics.
+ */
+void Scene3::cull() {
+    for(auto it = _entries.begin(); it != _entries.end(); ++it) {
+        it->visible = !it->bounded;
+    }
+    if (_volumes.empty()) {
+        return;
+    }
+    
+    _frustum.set(_camera->getInverseProjectView());
+    _stack.clear();
+    _stack.push_back(0);
+    while (!_stack.empty()) {
+        Uint32 index = _stack.back();
+        _stack.pop_back();
+        
+        const CullVolume& volume = _volumes[index];
+        Frustum::Region region = _frustum.findBox((volume.lower+volume.upper)*0.5f,
+                                                  volume.upper-volume.lower);
+        _tested++;
+        if (region == Frustum::Region::OUTSIDE) {
+            _culled += volume.count;
+        } else if (region == Frustum::Region::INSIDE || volume.count == 1) {
+            for(Uint32 ii = 0; ii < volume.count; ii++) {
+                _entries[_order[volume.start+ii]].visible = true;
+            }
+        } else if (volume.right < 0) {
+            for(Uint32 ii = 0; ii < volume.count; ii++) {
+                CullEntry& entry = _entries[_order[volume.start+ii]];
+                region = _frustum.findBox((entry.lower+entry.upper)*0.5f,
+                                          entry.upper-entry.lower);
+                _tested++;
+                if (region == Frustum::Region::OUTSIDE) {
+                    _culled++;
+                } else {
+                    entry.visible = true;
+                }
+            }
+        } else {
+            _stack.push_back(volume.right);
+            _stack.push_back(index+1);
+        }
     }
 }
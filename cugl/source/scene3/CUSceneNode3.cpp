@@ -71,6 +71,7 @@ _scale(Vec3::ONE),
 _parent(nullptr),
 _graph(nullptr),
 _childOffset(-2),
+_cullslot(-1),
 _batchkey(UNUSED_KEY) {
     _modelmat = Mat4::IDENTITY;
     _classname = "SceneNode";
@@ -244,6 +245,7 @@ void SceneNode::dispose() {
     _parent = nullptr;
     _graph = nullptr;
     _childOffset = -2;
+    _cullslot = -1;
     _tag = 0;
     _name = "";
     _hashOfName = 0;
@@ -484,6 +486,24 @@ void SceneNode::updateMatrices() {
     Mat4::scale(_modelmat, _scale, &_modelmat);
     Mat4::rotate(_modelmat, _rotate, &_modelmat);
     Mat4::translate(_modelmat, _position, &_modelmat);
+    if (_graph != nullptr) {
+        _graph->invalidateTransform(this);
+    }
+}
+
+#pragma mark -
+#pragma mark Culling
+/**
+ * Notifies the scene that the bounding box of this node has changed.
+ *
+ * Subclasses should call this method whenever they change the geometry
+ * reported by {@link #getBoundingBox}. Transform changes are tracked
+ * automatically and do not need this call.
+ */
+void SceneNode::invalidateBounds() {
+    if (_graph != nullptr) {
+        _graph->invalidateStructure();
+    }
 }
 
 #pragma mark -
@@ -704,6 +724,30 @@ void SceneNode::removeAllChildren() {
     _children.clear();
 }
 
+/**
+ * Sets the scene graph.
+ *
+ * The purpose of this pointer is to climb back up to the root of the
+ * scene graph tree. No node asserts ownership of its scene. Both the old
+ * and the new scene are notified so that they can rebuild their culling
+ * structures.
+ *
+ * @param scene    A pointer to the scene graph.
+ */
+void SceneNode::setScene(Scene3* scene) {
+    if (_graph == scene) {
+        return;
+    }
+    if (_graph != nullptr) {
+        _graph->invalidateStructure();
+    }
+    if (scene != nullptr) {
+        scene->invalidateStructure();
+    }
+    _graph = scene;
+    _cullslot = -1;
+}
+
 /**
  * Recursively sets the scene graph for this node and all its children.
  *
@@ -0,0 +1,504 @@
+//
+//  ActionTimelineTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the action timeline. It checks that a stale handle is
+//  rejected once its slot has been reused, that callbacks may add and remove
+//  actions in the middle of an update, and that listeners fire at their
+//  times (with only the completion listeners firing when an action is
+//  removed early). It checks that the batched easing functions match the
+//  easing functions of the factory, both directly and through the timeline.
+//  It then compares the time to update thousands of actions against the
+//  original timeline, which stored each action in a shared object.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/17/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/core/actions/CUActionTimeline.h>
+#include <CUTestHarness.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace cugl;
+
+/** The number of times checked for each easing function */
+#define EASE_SAMPLES    1001
+/** The number of actions for each timing */
+#define ACTION_COUNT    5000
+/** The number of frames for each timing */
+#define FRAME_COUNT     60
+/** The duration of a frame in seconds */
+#define FRAME_TIME      (1.0f/60.0f)
+/** The number of easing types (including the elastic ones) */
+#define EASING_TYPES    ((int)EasingFactory::Type::ELASTIC_IN_OUT+1)
+
+#pragma mark Reference Timeline
+/**
+ * The original timeline, which stores each action in a shared object
+ *
+ * This is the timeline before the actions were moved to flat arrays. The
+ * listeners are omitted, as none are attached in the timings.
+ */
+class ReferenceTimeline {
+private:
+    /** A single action and its state */
+    class Instance {
+    public:
+        /** The action to animate */
+        ActionFunction action;
+        /** The easing function (or nullptr for linear) */
+        EasingFunction easing;
+        /** The state of this action */
+        ActionState state;
+        /** The duration of this action */
+        double duration;
+        /** The time elapsed for this action */
+        double elapsed;
+        /** Whether this action is paused */
+        bool paused;
+
+        /** Creates an action at the beginning of its timeline */
+        Instance() : state(ActionState::BEGIN), duration(0), elapsed(0), paused(false) {}
+
+        /** Moves this action forward by dt seconds */
+        void update(float dt) {
+            if (paused || state == ActionState::FINISH) {
+                return;
+            }
+
+            float normtime = 0.0f;
+            if (duration > 0) {
+                normtime = (elapsed+dt) / duration;
+                if (normtime > 1.0f) {
+                    normtime = 1.0f;
+                }
+            }
+            if (easing) {
+                normtime = easing(normtime);
+            }
+            if (state == ActionState::BEGIN) {
+                action(elapsed,ActionState::BEGIN);
+                state = ActionState::UPDATE;
+            }
+
+            action(normtime,ActionState::UPDATE);
+            if (elapsed+dt >= duration) {
+                state = ActionState::FINISH;
+                action(elapsed+dt,ActionState::FINISH);
+            }
+            elapsed += dt;
+        }
+    };
+
+    /** The actions of this timeline */
+    std::unordered_map<std::string,std::shared_ptr<Instance>> _actions;
+
+public:
+    /**
+     * Adds an action with the given duration and easing function
+     *
+     * @param key       The identifying key
+     * @param action    The action to animate
+     * @param duration  The action duration
+     * @param easing    The easing (interpolation) function
+     *
+     * @return true if the animation was successfully started
+     */
+    bool add(const std::string key, ActionFunction action, float duration,
+             EasingFunction easing=nullptr) {
+        if (_actions.find(key) != _actions.end() || action == nullptr) {
+            return false;
+        }
+        auto instance = std::make_shared<Instance>();
+        instance->action = action;
+        instance->easing = easing;
+        instance->duration = duration;
+        _actions.emplace(key,instance);
+        return true;
+    }
+
+    /**
+     * Updates all non-paused animations by dt seconds
+     *
+     * @param dt    The number of seconds to animate
+     */
+    void update(float dt) {
+        auto completed = std::vector<std::unordered_map<std::string,std::shared_ptr<Instance>>::iterator>();
+        for(auto it = _actions.begin(); it != _actions.end(); ++it) {
+            auto instance = it->second;
+            instance->update(dt);
+            if (instance->state == ActionState::FINISH) {
+                completed.push_back(it);
+            }
+        }
+        for(auto it = completed.begin(); it != completed.end(); ++it) {
+            _actions.erase(*it);
+        }
+    }
+
+    /**
+     * Returns the number of active actions
+     *
+     * @return the number of active actions
+     */
+    size_t size() const { return _actions.size(); }
+};
+
+#pragma mark -
+#pragma mark Checks
+/**
+ * Checks that handles are rejected once their action is gone.
+ *
+ * The storage of a removed (or completed) action is recycled by the next
+ * action added. The old handle must not refer to the new action.
+ */
+static void testHandles() {
+    auto timeline = ActionTimeline::alloc();
+    int calls = 0;
+    ActionFunction count = [&](float t, ActionState state) { calls++; };
+    ActionListener never = [](const std::string key, float time, float actual) {};
+
+    Uint64 first = timeline->add(count, 1.0f);
+    CU_CHECK(first != 0 && timeline->isActive(first));
+    CU_CHECK(timeline->size() == 1);
+    CU_CHECK(timeline->remove(first));
+    CU_CHECK(!timeline->isActive(first));
+    CU_CHECK(timeline->size() == 0);
+
+    // The slot is reused, but with a new generation
+    Uint64 second = timeline->add(count, 1.0f);
+    CU_CHECK(second != first && (Uint32)second == (Uint32)first);
+    CU_CHECK(!timeline->isActive(first) && timeline->isActive(second));
+    CU_CHECK(!timeline->remove(first));
+    CU_CHECK(timeline->addListener(first, 0.5f, never) == 0);
+    CU_CHECK(timeline->addCompletionListener(first, never) == 0);
+    timeline->pause(first);
+    CU_CHECK(!timeline->isPaused(second));
+    timeline->update(0.25f);
+    CU_CHECK(timeline->getElapsed(first) == 0.0f);
+    CU_CHECK(timeline->getElapsed(second) == 0.25f);
+    CU_CHECK(calls == 2);
+
+    // Keys are a layer over handles
+    CU_CHECK(timeline->add("key", count, 0.5f));
+    Uint64 keyed = timeline->getHandle("key");
+    CU_CHECK(keyed != 0 && timeline->isActive(keyed));
+    CU_CHECK(!timeline->add("key", count, 0.5f));
+    CU_CHECK(timeline->size() == 2);
+    timeline->update(0.5f);
+    CU_CHECK(!timeline->isActive("key") && !timeline->isActive(keyed));
+    CU_CHECK(timeline->getHandle("key") == 0);
+    CU_CHECK(timeline->size() == 1);
+
+    // A completed action is recycled the same way
+    CU_CHECK(timeline->add("key", count, 0.5f));
+    Uint64 rekeyed = timeline->getHandle("key");
+    CU_CHECK(rekeyed != keyed && (Uint32)rekeyed == (Uint32)keyed);
+    CU_CHECK(!timeline->isActive(keyed) && !timeline->remove(keyed));
+    CU_CHECK(timeline->isActive("key"));
+    CU_CHECK(timeline->size() == 2);
+
+    timeline->dispose();
+    CU_CHECK(timeline->size() == 0);
+    CU_CHECK(!timeline->isActive(second) && !timeline->isActive(rekeyed));
+}
+
+/**
+ * Checks that callbacks may add and remove actions during an update.
+ *
+ * Actions removed during an update are not called again, even later in
+ * the same update. Actions added during an update start at the next one.
+ */
+static void testCallbacks() {
+    auto timeline = ActionTimeline::alloc();
+    std::unordered_map<std::string,int> calls;
+    auto counter = [&](const std::string key) {
+        return [&,key](float t, ActionState state) {
+            if (state == ActionState::UPDATE) {
+                calls[key]++;
+            }
+        };
+    };
+
+    // The first action removes itself and an action after it
+    CU_CHECK(timeline->add("a", [&](float t, ActionState state) {
+        if (state == ActionState::UPDATE) {
+            calls["a"]++;
+            timeline->remove("c");
+            timeline->remove("a");
+        }
+    }, 1.0f));
+
+    // The second action adds an action (and removes nothing)
+    CU_CHECK(timeline->add("b", [&](float t, ActionState state) {
+        if (state == ActionState::UPDATE && !timeline->isActive("d")) {
+            calls["b"]++;
+            timeline->add("d", counter("d"), 10.0f);
+        }
+    }, 1.0f));
+    CU_CHECK(timeline->add("c", counter("c"), 1.0f));
+
+    // The last action removes an action before it
+    CU_CHECK(timeline->add("e", [&](float t, ActionState state) {
+        if (state == ActionState::UPDATE) {
+            calls["e"]++;
+            timeline->remove("b");
+        }
+    }, 10.0f));
+    CU_CHECK(timeline->size() == 4);
+
+    timeline->update(0.25f);
+    CU_CHECK(calls["a"] == 1 && calls["b"] == 1 && calls["e"] == 1);
+    CU_CHECK(calls["c"] == 0 && calls["d"] == 0);
+    CU_CHECK(!timeline->isActive("a") && !timeline->isActive("b") && !timeline->isActive("c"));
+    CU_CHECK(timeline->isActive("d") && timeline->isActive("e"));
+    CU_CHECK(timeline->size() == 2);
+    CU_CHECK(timeline->getElapsed("d") == 0.0f);
+
+    timeline->update(0.25f);
+    CU_CHECK(calls["d"] == 1 && calls["e"] == 2);
+    CU_CHECK(timeline->getElapsed("d") == 0.25f);
+
+    // A completion listener runs just before removal, and may add actions
+    int finished = 0;
+    CU_CHECK(timeline->add("f", counter("f"), 0.25f));
+    timeline->addCompletionListener("f", [&](const std::string key, float time, float actual) {
+        finished++;
+        CU_CHECK(timeline->isActive(key));
+        CU_CHECK(timeline->add("h", counter("h"), 10.0f));
+    });
+    timeline->update(0.25f);
+    CU_CHECK(finished == 1 && calls["f"] == 1 && calls["h"] == 0);
+    CU_CHECK(!timeline->isActive("f") && timeline->isActive("h"));
+    CU_CHECK(timeline->getElapsed("h") == 0.0f);
+
+    // A listener may remove its own action
+    CU_CHECK(timeline->add("g", counter("g"), 1.0f));
+    timeline->addListener("g", 0.25f, [&](const std::string key, float time, float actual) {
+        CU_CHECK(timeline->remove(key));
+    });
+    timeline->update(0.25f);
+    timeline->update(0.25f);
+    CU_CHECK(calls["g"] == 1 && !timeline->isActive("g"));
+    CU_CHECK(timeline->size() == 3);
+}
+
+/**
+ * Checks that listeners fire once, at their requested times.
+ *
+ * When an action is removed before it is complete, only the listeners
+ * registered for completion are invoked.
+ */
+static void testListeners() {
+    auto timeline = ActionTimeline::alloc();
+    std::vector<std::string> fired;
+    std::vector<float> actuals;
+    auto record = [&](const std::string name) {
+        return [&,name](const std::string key, float time, float actual) {
+            fired.push_back(name+":"+key);
+            actuals.push_back(actual);
+        };
+    };
+    auto noop = [](float t, ActionState state) {};
+
+    CU_CHECK(timeline->add("run", noop, 1.0f));
+    Uint32 start  = timeline->addListener("run", 0.0f, record("start"));
+    Uint32 middle = timeline->addListener("run", 0.5f, record("middle"));
+    Uint32 late   = timeline->addListener("run", 0.9f, record("late"));
+    Uint32 done   = timeline->addCompletionListener("run", record("done"));
+    CU_CHECK(start != 0 && middle != 0 && late != 0 && done != 0);
+    CU_CHECK(timeline->getListener(middle) != nullptr);
+    CU_CHECK(timeline->removeListener(late));
+    CU_CHECK(!timeline->removeListener(late));
+    CU_CHECK(timeline->getListener(late) == nullptr);
+
+    timeline->update(0.25f);
+    CU_CHECK(fired == std::vector<std::string>({"start:run"}));
+    timeline->update(0.25f);
+    CU_CHECK(fired.size() == 2 && fired.back() == "middle:run" && actuals.back() == 0.5f);
+    CU_CHECK(timeline->getListener(middle) == nullptr);
+    timeline->update(0.25f);
+    timeline->update(0.25f);
+    CU_CHECK(fired.size() == 3 && fired.back() == "done:run" && actuals.back() == 1.0f);
+    CU_CHECK(timeline->getListener(done) == nullptr);
+    CU_CHECK(!timeline->isActive("run"));
+
+    // Removing an action only calls the completion listeners
+    fired.clear();
+    actuals.clear();
+    Uint64 handle = timeline->add(noop, 1.0f);
+    timeline->addListener(handle, 0.75f, record("middle"));
+    timeline->addListener(handle, 2.0f, record("after"));
+    Uint32 early = timeline->addCompletionListener(handle, record("done"));
+    timeline->update(0.25f);
+    CU_CHECK(fired.empty());
+    CU_CHECK(timeline->remove(handle));
+    CU_CHECK(fired == std::vector<std::string>({"done:", "after:"}));
+    CU_CHECK(actuals.size() == 2 && actuals[0] == 0.25f && actuals[1] == 0.25f);
+    CU_CHECK(timeline->getListener(early) == nullptr && !timeline->removeListener(early));
+
+    // Paused actions do not advance their listeners
+    fired.clear();
+    CU_CHECK(timeline->add("paused", noop, 1.0f));
+    timeline->addListener("paused", 0.25f, record("middle"));
+    timeline->pause("paused");
+    timeline->update(0.5f);
+    CU_CHECK(fired.empty() && timeline->isPaused("paused"));
+    timeline->unpause("paused");
+    timeline->update(0.5f);
+    CU_CHECK(fired == std::vector<std::string>({"middle:paused"}));
+    CU_CHECK(timeline->size() == 1);
+}
+
+/**
+ * Checks that the batched easing functions match the factory functions.
+ *
+ * It also checks the easing applied by the timeline, which sorts the
+ * actions by easing type before evaluating them in batches.
+ */
+static void testEasing() {
+    std::vector<float> times(EASE_SAMPLES);
+    for(int ii = 0; ii < EASE_SAMPLES; ii++) {
+        times[ii] = ii/(float)(EASE_SAMPLES-1);
+    }
+
+    bool batched = true;
+    for(int type = 0; type < EASING_TYPES; type++) {
+        EasingFactory::Type kind = (EasingFactory::Type)type;
+        EasingFunction func = EasingFactory::alloc(kind, 0.4f);
+        std::vector<float> result = times;
+        EasingFactory::evaluate(kind, result.data(), result.size(), 0.4f);
+        for(int ii = 0; ii < EASE_SAMPLES; ii++) {
+            if (result[ii] != func(times[ii])) {
+                std::printf("  easing %d differs at %g\n", type, times[ii]);
+                batched = false;
+                break;
+            }
+        }
+    }
+    CU_CHECK(batched);
+
+    // Interleave the types (and a custom function) in the timeline
+    auto timeline = ActionTimeline::alloc();
+    EasingFunction custom = [](float t) { return t*t*0.5f; };
+    std::vector<float> eased(3*(EASING_TYPES+1), -1.0f);
+    std::vector<EasingFunction> funcs;
+    for(int ii = 0; ii < (int)eased.size(); ii++) {
+        int type = ii % (EASING_TYPES+1);
+        EasingFunction func = type < EASING_TYPES ? EasingFactory::alloc((EasingFactory::Type)type) : custom;
+        funcs.push_back(func);
+        timeline->add([&,ii](float t, ActionState state) {
+            if (state == ActionState::UPDATE) {
+                eased[ii] = t;
+            }
+        }, 1.0f+ii, func);
+    }
+
+    bool timed = true;
+    for(int frame = 1; frame <= 3; frame++) {
+        timeline->update(0.3f);
+        for(int ii = 0; ii < (int)eased.size(); ii++) {
+            float expected = funcs[ii]((float)(((double)0.3f*frame)/(1.0+ii)));
+            timed = timed && eased[ii] == expected;
+        }
+    }
+    CU_CHECK(timed);
+}
+
+#pragma mark -
+#pragma mark Timings
+/**
+ * Reports the time to update many actions, against the original timeline.
+ *
+ * The actions cycle through the easing types. The first timing updates
+ * long actions, so that none complete. The second adds actions that only
+ * last a few frames, so storage is recycled every frame.
+ */
+static void timeUpdate() {
+    float sink = 0;
+    auto action = [&](float t, ActionState state) { sink += t; };
+    std::vector<EasingFunction> easings;
+    for(int ii = 0; ii < EASING_TYPES; ii++) {
+        easings.push_back(EasingFactory::alloc((EasingFactory::Type)ii));
+    }
+
+    auto timeline = ActionTimeline::alloc();
+    ReferenceTimeline reference;
+    for(int ii = 0; ii < ACTION_COUNT; ii++) {
+        std::string key = "action"+std::to_string(ii);
+        timeline->add(key, action, 1000.0f, easings[ii % EASING_TYPES]);
+        reference.add(key, action, 1000.0f, easings[ii % EASING_TYPES]);
+    }
+    double time1 = cu_test_time([&] {
+        for(int ii = 0; ii < FRAME_COUNT; ii++) {
+            timeline->update(FRAME_TIME);
+        }
+    });
+    double time2 = cu_test_time([&] {
+        for(int ii = 0; ii < FRAME_COUNT; ii++) {
+            reference.update(FRAME_TIME);
+        }
+    });
+    CU_CHECK(timeline->size() == ACTION_COUNT && reference.size() == ACTION_COUNT);
+    std::printf("%d actions for %d frames: %.3f ms (original %.3f ms)\n",
+                ACTION_COUNT, FRAME_COUNT, time1, time2);
+
+    // Short actions, so the timeline is always adding and retiring
+    timeline->dispose();
+    reference = ReferenceTimeline();
+    int counter = 0;
+    double time3 = cu_test_time([&] {
+        for(int ii = 0; ii < FRAME_COUNT; ii++) {
+            for(int jj = 0; jj < ACTION_COUNT/10; jj++) {
+                timeline->add(action, 4*FRAME_TIME, easings[jj % EASING_TYPES]);
+            }
+            timeline->update(FRAME_TIME);
+        }
+    });
+    double time4 = cu_test_time([&] {
+        for(int ii = 0; ii < FRAME_COUNT; ii++) {
+            for(int jj = 0; jj < ACTION_COUNT/10; jj++) {
+                reference.add(std::to_string(counter++), action, 4*FRAME_TIME, easings[jj % EASING_TYPES]);
+            }
+            reference.update(FRAME_TIME);
+        }
+    });
+    CU_CHECK(timeline->size() == reference.size());
+    std::printf("%d short actions per frame: %.3f ms (original %.3f ms)\n",
+                ACTION_COUNT/10, time3, time4);
+    std::printf("(checksum %g)\n", sink);
+}
+
+/**
+ * Runs the timeline checks and timings.
+ */
+int main(int argc, char** argv) {
+    testHandles();
+    testCallbacks();
+    testListeners();
+    testEasing();
+    timeUpdate();
+    return cu_test_result("ActionTimelineTest");
+}
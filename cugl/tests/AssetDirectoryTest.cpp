@@ -0,0 +1,352 @@
+//
+//  AssetDirectoryTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks compiled asset directories. It compiles a synthetic
+//  asset directory and checks that every category (and the whole tree)
+//  converts back to the original JSON, both with and without an arena. It
+//  checks that a single read of a directory file decodes either format,
+//  that truncated, corrupt and overly nested data is rejected without
+//  reading past the data, and then reports the startup cost of a JSON
+//  directory against a compiled one.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/17/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/core/assets/CUAssetDirectory.h>
+#include <cugl/core/assets/CUJsonValue.h>
+#include <CUTestHarness.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+using namespace cugl;
+
+/** The number of assets in each category of the small directory */
+#define SMALL_ASSETS    20
+/** The number of assets in each category of the startup directory */
+#define LARGE_ASSETS    2000
+/** The number of node records in a chain far deeper than the limit */
+#define CHAIN_LENGTH    100000
+
+#pragma mark Documents
+/**
+ * Returns a synthetic asset directory with the given number of assets
+ *
+ * The directory has the categories of a typical game: textures, fonts,
+ * sounds, and scene graphs with nested children.
+ *
+ * @param assets    The number of assets in each category
+ *
+ * @return a synthetic asset directory with the given number of assets
+ */
+static std::string makeDirectory(int assets) {
+    std::mt19937 rand(assets);
+    std::string text = "{\n";
+    const char* categories[] = { "textures", "fonts", "sounds" };
+    for(int cc = 0; cc < 3; cc++) {
+        text += std::string("  \"")+categories[cc]+"\": {\n";
+        for(int ii = 0; ii < assets; ii++) {
+            std::string name = categories[cc]+std::to_string(ii);
+            text += "    \""+name+"\": {\"file\": \"assets/"+name+".png\", ";
+            text += "\"size\": "+std::to_string(8+rand()%64)+", ";
+            text += "\"volume\": "+std::to_string((rand()%1000)/1000.0)+", ";
+            text += "\"mipmaps\": "+std::string(rand()%2 ? "true" : "false")+", ";
+            text += "\"atlas\": null, \"span\": [0, 0.5, -1e3, "+std::to_string(ii)+"]}";
+            text += (ii+1 < assets ? ",\n" : "\n");
+        }
+        text += "  },\n";
+    }
+    text += "  \"scene2s\": {\n";
+    for(int ii = 0; ii < assets; ii++) {
+        text += "    \"scene"+std::to_string(ii)+"\": {\"type\": \"Node\", \"children\": {";
+        for(int jj = 0; jj < 4; jj++) {
+            text += (jj ? ", " : "");
+            text += "\"child"+std::to_string(jj)+"\": {\"type\": \"Image\", ";
+            text += "\"data\": {\"texture\": \"textures"+std::to_string(jj)+"\", ";
+            text += "\"anchor\": [0.5, 0.5], \"label\": \"caf\\u00e9 \\\"quoted\\\"\"}}";
+        }
+        text += "}}";
+        text += (ii+1 < assets ? ",\n" : "\n");
+    }
+    text += "  }\n}\n";
+    return text;
+}
+
+/**
+ * Returns the JSON text of an object wrapping the given number of arrays
+ *
+ * The innermost array contains a single number, so every array is a
+ * non-empty container.
+ *
+ * @param arrays    The number of nested arrays
+ *
+ * @return the JSON text of an object wrapping the given number of arrays
+ */
+static std::string makeNested(int arrays) {
+    return "{\"deep\": "+std::string(arrays,'[')+"1"+std::string(arrays,']')+"}";
+}
+
+/**
+ * Appends the given 32-bit integer in network order
+ *
+ * @param data  The data to extend
+ * @param value The value to append
+ */
+static void append32(std::vector<Uint8>& data, Uint32 value) {
+    for(int ii = 3; ii >= 0; ii--) {
+        data.push_back((Uint8)(value >> (8*ii)));
+    }
+}
+
+/**
+ * Appends a node record to the given data
+ *
+ * @param data  The data to extend
+ * @param type  The node type
+ * @param count The number of children
+ * @param total The size of the subtree
+ */
+static void appendNode(std::vector<Uint8>& data, JsonValue::Type type, Uint32 count, Uint32 total) {
+    data.push_back((Uint8)type);
+    data.insert(data.end(), 3, 0);
+    append32(data, 0xFFFFFFFF);
+    append32(data, count);
+    append32(data, total);
+}
+
+/**
+ * Returns a hand-built compiled directory of nested arrays
+ *
+ * The root is an array with a single array child, and so on, with the
+ * given number of arrays above a final null. The directory has no
+ * categories or strings. If escape is true, the second array claims
+ * one more node than its parent contains.
+ *
+ * @param arrays    The number of nested arrays
+ * @param escape    Whether a subtree escapes its parent
+ *
+ * @return a hand-built compiled directory of nested arrays
+ */
+static std::vector<Uint8> makeChain(Uint32 arrays, bool escape=false) {
+    std::vector<Uint8> data(CU_ASSET_DIRECTORY_MAGIC, CU_ASSET_DIRECTORY_MAGIC+4);
+    append32(data, CU_ASSET_DIRECTORY_VERSION);
+    append32(data, 0);
+    append32(data, 0);
+    append32(data, arrays+(escape ? 2 : 1));
+    append32(data, 0);
+    for(Uint32 ii = 0; ii < arrays; ii++) {
+        Uint32 total = arrays-ii+(escape && ii == 1 ? 1 : 0);
+        appendNode(data, JsonValue::Type::ArrayType, 1, total);
+    }
+    appendNode(data, JsonValue::Type::NullType, 0, 0);
+    if (escape) {
+        appendNode(data, JsonValue::Type::NullType, 0, 0);
+    }
+    return data;
+}
+
+/**
+ * Writes the given bytes to a temporary file, returning its path
+ *
+ * @param name  The file name
+ * @param data  The file contents
+ * @param size  The number of bytes
+ *
+ * @return the path of the temporary file
+ */
+static std::string writeTemp(const std::string& name, const void* data, size_t size) {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+    std::ofstream file(path, std::ios::binary);
+    file.write((const char*)data, size);
+    return path.string();
+}
+
+#pragma mark Checks
+/**
+ * Checks that a compiled directory converts back to the original JSON.
+ */
+static void testRoundTrip() {
+    std::shared_ptr<JsonValue> json = JsonValue::allocWithJson(makeDirectory(SMALL_ASSETS));
+    std::shared_ptr<AssetDirectory> compiled = AssetDirectory::alloc(json);
+    CU_CHECK(compiled != nullptr);
+    if (compiled == nullptr) {
+        return;
+    }
+
+    std::string expected = json->toString();
+    CU_CHECK(compiled->toJson()->toString() == expected);
+    CU_CHECK(compiled->toJson(true)->toString() == expected);
+    CU_CHECK(compiled->size() == json->size());
+    for(size_t ii = 0; ii < compiled->size(); ii++) {
+        std::shared_ptr<JsonValue> category = compiled->get(ii, ii % 2);
+        CU_CHECK(compiled->getCategory(ii) == json->get(ii)->key());
+        CU_CHECK(category->key() == json->get(ii)->key());
+        CU_CHECK(category->toString() == json->get(ii)->toString());
+        std::string last = json->get(ii)->get(SMALL_ASSETS-1)->key();
+        CU_CHECK(category->get(last) != nullptr && category->get(last)->key() == last);
+    }
+
+    // Data owned by the caller is used in place
+    std::vector<Uint8> copy(compiled->data(), compiled->data()+compiled->byteSize());
+    std::shared_ptr<AssetDirectory> view = AssetDirectory::alloc(copy.data(), copy.size());
+    CU_CHECK(view != nullptr && view->data() == copy.data());
+    CU_CHECK(view != nullptr && view->toJson()->toString() == expected);
+}
+
+/**
+ * Checks that a single read of a directory file decodes either format.
+ */
+static void testFiles() {
+    std::string text = makeDirectory(SMALL_ASSETS);
+    std::shared_ptr<JsonValue> json = JsonValue::allocWithJson(text);
+    std::shared_ptr<AssetDirectory> compiled = AssetDirectory::alloc(json);
+    std::string expected = json->toString();
+
+    std::string jsonPath = writeTemp("cugl_assetdir_test.json", text.data(), text.size());
+    std::string binPath  = writeTemp("cugl_assetdir_test.cuad", compiled->data(), compiled->byteSize());
+
+    std::shared_ptr<JsonValue> fromText = AssetDirectory::readJson(jsonPath);
+    std::shared_ptr<JsonValue> fromBin  = AssetDirectory::readJson(binPath, true);
+    CU_CHECK(fromText != nullptr && fromText->toString() == expected);
+    CU_CHECK(fromBin  != nullptr && fromBin->toString() == expected);
+    CU_CHECK(AssetDirectory::allocWithFile(binPath) != nullptr);
+    CU_CHECK(AssetDirectory::allocWithFile(jsonPath) == nullptr);
+    CU_CHECK(AssetDirectory::readJson(jsonPath+".missing") == nullptr);
+
+    // A compiled file with the signature but a bad body is not reparsed as JSON
+    std::vector<Uint8> bad(compiled->data(), compiled->data()+compiled->byteSize()/2);
+    std::string badPath = writeTemp("cugl_assetdir_test.bad", bad.data(), bad.size());
+    CU_CHECK(AssetDirectory::readJson(badPath) == nullptr);
+    CU_CHECK(AssetDirectory::allocWithFile(badPath) == nullptr);
+
+    std::remove(jsonPath.c_str());
+    std::remove(binPath.c_str());
+    std::remove(badPath.c_str());
+}
+
+/**
+ * Checks that truncated, corrupt and overly nested data is rejected.
+ */
+static void testErrors() {
+    std::shared_ptr<JsonValue> json = JsonValue::allocWithJson(makeDirectory(2));
+    std::shared_ptr<AssetDirectory> compiled = AssetDirectory::alloc(json);
+    std::vector<Uint8> data(compiled->data(), compiled->data()+compiled->byteSize());
+
+    // Every truncation is rejected (the string data is padded to 8 bytes)
+    size_t minimum = data.size()-7;
+    bool rejected = true;
+    for(size_t ii = 0; ii < minimum; ii++) {
+        std::vector<Uint8> prefix(data.begin(), data.begin()+ii);
+        rejected = rejected && AssetDirectory::alloc(prefix.data(), prefix.size()) == nullptr;
+    }
+    CU_CHECK(rejected);
+
+    // The wrong signature or version
+    std::vector<Uint8> bad = data;
+    bad[0] = 'X';
+    CU_CHECK(AssetDirectory::alloc(bad.data(), bad.size()) == nullptr);
+    bad = data;
+    bad[7]++;
+    CU_CHECK(AssetDirectory::alloc(bad.data(), bad.size()) == nullptr);
+
+    // Flipping any one byte never reads past the data
+    size_t accepted = 0;
+    for(size_t ii = 8; ii < data.size(); ii++) {
+        bad = data;
+        bad[ii] ^= 0x80;
+        std::shared_ptr<AssetDirectory> result = AssetDirectory::alloc(bad.data(), bad.size());
+        if (result != nullptr) {
+            accepted++;
+            result->toJson();
+        }
+    }
+    CU_CHECK(accepted < data.size());
+
+    // A subtree that escapes its parent
+    std::vector<Uint8> chain = makeChain(4);
+    CU_CHECK(AssetDirectory::alloc(chain.data(), chain.size()) != nullptr);
+    chain = makeChain(4, true);
+    CU_CHECK(AssetDirectory::alloc(chain.data(), chain.size()) == nullptr);
+
+    // Nesting is limited, both when compiling and when reading
+    chain = makeChain(CU_ASSET_DIRECTORY_MAX_DEPTH);
+    std::shared_ptr<AssetDirectory> deep = AssetDirectory::alloc(chain.data(), chain.size());
+    CU_CHECK(deep != nullptr && deep->toJson() != nullptr);
+    chain = makeChain(CU_ASSET_DIRECTORY_MAX_DEPTH+1);
+    CU_CHECK(AssetDirectory::alloc(chain.data(), chain.size()) == nullptr);
+    chain = makeChain(CHAIN_LENGTH);
+    CU_CHECK(AssetDirectory::alloc(chain.data(), chain.size()) == nullptr);
+
+    // The root object is the first container
+    json = JsonValue::allocWithJson(makeNested(CU_ASSET_DIRECTORY_MAX_DEPTH-1));
+    CU_CHECK(AssetDirectory::alloc(json) != nullptr);
+    json = JsonValue::allocWithJson(makeNested(CU_ASSET_DIRECTORY_MAX_DEPTH));
+    CU_CHECK(AssetDirectory::alloc(json) == nullptr);
+}
+
+#pragma mark Timings
+/**
+ * Reports the startup cost of a JSON directory against a compiled one.
+ *
+ * Each time includes reading the file, as that is what the asset manager
+ * does at startup.
+ */
+static void timeStartup() {
+    std::string text = makeDirectory(LARGE_ASSETS);
+    std::shared_ptr<JsonValue> json = JsonValue::allocWithJson(text);
+    std::shared_ptr<AssetDirectory> compiled = AssetDirectory::alloc(json);
+    std::string jsonPath = writeTemp("cugl_assetdir_time.json", text.data(), text.size());
+    std::string binPath  = writeTemp("cugl_assetdir_time.cuad", compiled->data(), compiled->byteSize());
+
+    std::shared_ptr<JsonValue> fromText, fromBin;
+    double parse = cu_test_time([&] {
+        fromText = AssetDirectory::readJson(jsonPath, true);
+    });
+    double load = cu_test_time([&] {
+        fromBin = AssetDirectory::readJson(binPath, true);
+    });
+    double category = cu_test_time([&] {
+        std::shared_ptr<AssetDirectory> directory = AssetDirectory::allocWithFile(binPath);
+        directory->get(0, true);
+    });
+    CU_CHECK(fromText != nullptr && fromBin != nullptr);
+    CU_CHECK(fromText->toString(false) == fromBin->toString(false));
+
+    std::printf("%.1f KB JSON, %.1f KB compiled: %.2f ms JSON, %.2f ms compiled, %.2f ms one category\n",
+                text.size()/1024.0, compiled->byteSize()/1024.0, parse, load, category);
+    std::remove(jsonPath.c_str());
+    std::remove(binPath.c_str());
+}
+
+/**
+ * Runs the asset directory checks and timings.
+ */
+int main(int argc, char** argv) {
+    testRoundTrip();
+    testFiles();
+    testErrors();
+    timeStartup();
+    return cu_test_result("AssetDirectoryTest");
+}
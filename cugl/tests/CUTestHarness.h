@@ -0,0 +1,95 @@
+//
+//  CUTestHarness.h
+//  Cornell University Game Library (CUGL)
+//
+//  This header provides the minimal support shared by the CUGL test drivers.
+//  Each driver is a standalone executable that checks the behavior of one
+//  module and prints the timings of its fast paths. A driver returns a
+//  nonzero exit code if any check fails, so that the drivers can be run
+//  with ctest. They do not require a window or a graphics context.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#ifndef __CU_TEST_HARNESS_H__
+#define __CU_TEST_HARNESS_H__
+#include <chrono>
+#include <cstdio>
+
+/** The number of failed checks in this driver */
+inline int cu_test_failures = 0;
+
+/**
+ * Checks that the given condition holds, reporting it if it does not.
+ *
+ * Unlike CUAssertLog, a failed check does not abort the driver.
+ */
+#define CU_CHECK(cond) do { \
+    if (!(cond)) { \
+        std::printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        cu_test_failures++; \
+    } \
+} while (0)
+
+/**
+ * Returns the exit code for this driver, after printing a summary.
+ *
+ * @param name  The driver name
+ *
+ * @return the exit code for this driver
+ */
+inline int cu_test_result(const char* name) {
+    if (cu_test_failures) {
+        std::printf("%s: %d check(s) failed\n", name, cu_test_failures);
+        return 1;
+    }
+    std::printf("%s: all checks passed\n", name);
+    return 0;
+}
+
+/**
+ * Returns the time in milliseconds to execute the given function.
+ *
+ * The function is executed the given number of times, and the best time
+ * is returned to reduce the noise of a shared machine.
+ *
+ * @param func      The function to time
+ * @param repeat    The number of times to execute the function
+ *
+ * @return the time in milliseconds to execute the given function.
+ */
+template <typename F>
+double cu_test_time(F func, int repeat = 3) {
+    double best = -1;
+    for (int ii = 0; ii < repeat; ii++) {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        auto end = std::chrono::steady_clock::now();
+        double time = std::chrono::duration<double,std::milli>(end-start).count();
+        if (best < 0 || time < best) {
+            best = time;
+        }
+    }
+    return best;
+}
+
+#endif /* __CU_TEST_HARNESS_H__ */
@@ -0,0 +1,233 @@
+//
+//  EarclipTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the ear clipping triangulator on large polygons. It
+//  triangulates stars, spirals, combs, and polygons with holes, and checks
+//  that each triangulation is valid: it has the expected number of
+//  triangles, every triangle is counter-clockwise, and the triangles cover
+//  exactly the area of the polygon. It then reports the time to
+//  triangulate polygons of 10k to 100k vertices.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/core/math/polygon/CUEarclipTriangulator.h>
+#include <CUTestHarness.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace cugl;
+
+/**
+ * Returns a star with the given number of vertices.
+ *
+ * The points alternate between an outer and a (random) inner radius, so
+ * half of the vertices are reflex.
+ *
+ * @param size  The number of vertices
+ * @param seed  The random seed
+ *
+ * @return a star with the given number of vertices.
+ */
+static std::vector<Vec2> star(size_t size, unsigned seed) {
+    std::mt19937 rand(seed);
+    std::uniform_real_distribution<float> inner(20.0f, 90.0f);
+    std::vector<Vec2> result;
+    for (size_t ii = 0; ii < size; ii++) {
+        double angle = 2*M_PI*ii/size;
+        float radius = ii % 2 ? inner(rand) : 100.0f;
+        result.push_back(Vec2(radius*std::cos(angle), radius*std::sin(angle)));
+    }
+    return result;
+}
+
+/**
+ * Returns a thick spiral with the given number of vertices.
+ *
+ * The spiral winds several times around its center, so most ears are
+ * long and thin, and many vertices are close to each candidate ear.
+ *
+ * @param size  The number of vertices
+ *
+ * @return a thick spiral with the given number of vertices.
+ */
+static std::vector<Vec2> spiral(size_t size) {
+    size_t half = size/2;
+    double turns = 6*2*M_PI;
+    std::vector<Vec2> result;
+    for (size_t ii = 0; ii < half; ii++) {
+        double angle = turns*ii/half;
+        double radius = 10+angle*4;
+        result.push_back(Vec2(radius*std::cos(angle), radius*std::sin(angle)));
+    }
+    for (size_t ii = half; ii > 0; ii--) {
+        double angle = turns*(ii-1)/half;
+        double radius = 12+angle*4;
+        result.push_back(Vec2(radius*std::cos(angle), radius*std::sin(angle)));
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+/**
+ * Returns a comb with the given number of teeth.
+ *
+ * The teeth share collinear integer points along the spine of the comb.
+ *
+ * @param teeth The number of teeth
+ *
+ * @return a comb with the given number of teeth.
+ */
+static std::vector<Vec2> comb(size_t teeth) {
+    std::vector<Vec2> result;
+    result.push_back(Vec2(0,0));
+    result.push_back(Vec2(teeth*2.0f,0));
+    for (size_t ii = teeth; ii > 0; ii--) {
+        float x = ii*2.0f;
+        result.push_back(Vec2(x,10));
+        result.push_back(Vec2(x-1,10));
+        result.push_back(Vec2(x-1,2));
+        result.push_back(Vec2(x-2,2));
+    }
+    result.pop_back();
+    result.push_back(Vec2(0,10));
+    return result;
+}
+
+/**
+ * Returns the signed area of the given polygon
+ *
+ * @param points    The polygon vertices
+ *
+ * @return the signed area of the given polygon
+ */
+static double area(const std::vector<Vec2>& points) {
+    double result = 0;
+    for (size_t ii = 0; ii < points.size(); ii++) {
+        const Vec2& a = points[ii];
+        const Vec2& b = points[(ii+1) % points.size()];
+        result += (double)a.x*b.y-(double)b.x*a.y;
+    }
+    return result/2;
+}
+
+/**
+ * Triangulates the polygon and checks that the triangulation is valid.
+ *
+ * @param name  The polygon name, for reporting errors
+ * @param hull  The polygon hull
+ * @param holes The polygon holes
+ *
+ * @return the time in milliseconds to triangulate the polygon
+ */
+static double check(const char* name, const std::vector<Vec2>& hull,
+                    const std::vector<std::vector<Vec2>>& holes = {}) {
+    EarclipTriangulator triangulator;
+    std::vector<Vec2> points = hull;
+    double expected = area(hull);
+    double time = cu_test_time([&] {
+        triangulator.set(hull);
+        for (auto it = holes.begin(); it != holes.end(); ++it) {
+            triangulator.addHole(*it);
+        }
+        triangulator.calculate();
+    }, 1);
+    for (auto it = holes.begin(); it != holes.end(); ++it) {
+        points.insert(points.end(), it->begin(), it->end());
+        expected += area(*it);
+    }
+
+    std::vector<Uint32> indices = triangulator.getTriangulation();
+    size_t triangles = points.size()+2*holes.size()-2;
+    bool valid = indices.size() == 3*triangles;
+    double total = 0;
+    for (size_t ii = 0; valid && ii+2 < indices.size(); ii += 3) {
+        valid = indices[ii] < points.size() && indices[ii+1] < points.size() &&
+                indices[ii+2] < points.size();
+        if (valid) {
+            double part = area({points[indices[ii]], points[indices[ii+1]], points[indices[ii+2]]});
+            valid = part >= -1e-9*std::abs(expected);
+            total += part;
+        }
+    }
+    valid = valid && std::abs(total-expected) <= 1e-6*std::abs(expected);
+    if (!valid) {
+        std::printf("  invalid triangulation of %s (%zu vertices)\n", name, points.size());
+    }
+    CU_CHECK(valid);
+    return time;
+}
+
+/**
+ * Checks the triangulation of many polygons with and without holes.
+ */
+static void testShapes() {
+    // A square has a known triangulation
+    EarclipTriangulator square({Vec2(0,0),Vec2(1,0),Vec2(1,1),Vec2(0,1)});
+    square.calculate();
+    CU_CHECK(square.getTriangulation().size() == 6);
+
+    for (unsigned seed = 0; seed < 50; seed++) {
+        check("star", star(20+seed*37, seed));
+        check("spiral", spiral(40+seed*20));
+        check("comb", comb(5+seed*3));
+    }
+
+    // Holes are sliced into the hull, which creates duplicate vertices
+    for (unsigned seed = 0; seed < 20; seed++) {
+        std::vector<std::vector<Vec2>> holes;
+        std::vector<Vec2> hull = star(200+seed*10, seed);
+        for (int ii = 0; ii < 3; ii++) {
+            std::vector<Vec2> hole = star(12, seed*3+ii);
+            for (auto it = hole.begin(); it != hole.end(); ++it) {
+                *it = *it*0.03f+Vec2(ii*8.0f-8.0f, 0);
+            }
+            std::reverse(hole.begin(), hole.end());
+            holes.push_back(hole);
+        }
+        check("star with holes", hull, holes);
+    }
+}
+
+/**
+ * Reports the time to triangulate large polygons.
+ */
+static void timeShapes() {
+    size_t sizes[] = { 10000, 20000, 100000 };
+    for (size_t ii = 0; ii < 3; ii++) {
+        double time1 = check("star", star(sizes[ii], 1));
+        double time2 = check("spiral", spiral(sizes[ii]));
+        std::printf("%zu vertices: %.1f ms star, %.1f ms spiral\n", sizes[ii], time1, time2);
+    }
+}
+
+/**
+ * Runs the triangulation checks and timings.
+ */
+int main(int argc, char** argv) {
+    testShapes();
+    timeShapes();
+    return cu_test_result("EarclipTest");
+}
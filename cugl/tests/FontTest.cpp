@@ -0,0 +1,520 @@
+//
+//  FontTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the glyph metric and kerning tables of a font. It
+//  compares the metrics and the kerning of every pair of gathered glyphs,
+//  for both ASCII and non-ASCII characters, against SDL_ttf. It then
+//  reports the time to lay out and measure a large paragraph.
+//
+//  If an OpenGL context is available, the driver also checks that glyphs
+//  added to a dynamic atlas render and measure the same as glyphs in an
+//  atlas built up front, and that the glyph run cache is invalidated and
+//  bounded as documented. These checks are skipped on a headless machine.
+//
+//  The driver needs a TrueType font. CMake passes the path of the font in
+//  the assets directory, but any font may be given on the command line.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/17/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/graphics/CUFont.h>
+#include <cugl/graphics/CUTextLayout.h>
+#include <cugl/graphics/CUTexture.h>
+#include <utf8/utf8.h>
+#include <SDL_ttf.h>
+#include <CUTestHarness.h>
+#include <algorithm>
+#include <cfloat>
+#include <functional>
+#include <random>
+
+using namespace cugl;
+using namespace cugl::graphics;
+
+/** The point size of the font */
+#define FONT_SIZE       24
+/** The width at which to break lines */
+#define LINE_WIDTH      400.0f
+/** The approximate size in bytes of the paragraph */
+#define TEXT_SIZE       150000
+/** The number of words in each line checked against the atlases */
+#define LINE_WORDS      6
+/** The number of lines checked against the atlases */
+#define LINE_COUNT      40
+/** The maximum number of lines in the glyph run cache */
+#define CACHE_LIMIT     8
+
+/** The words of the paragraph, with ASCII and non-ASCII characters */
+static const char* WORDS[] = {
+    "The", "quick", "brown", "fox", "jumps", "over", "the", "lazy", "dog.",
+    "AVAST", "Wavy", "To", "Ty", "r\xC3\xA9sum\xC3\xA9", "na\xC3\xAFve",
+    "\xC3\x85ngstr\xC3\xB6m", "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82,",
+    "\xD0\xBC\xD0\xB8\xD1\x80!", "(42)", "\"quoted\""
+};
+
+/**
+ * Returns the code points of the given UTF8 string, without duplicates.
+ *
+ * @param text  The UTF8 string
+ *
+ * @return the code points of the given UTF8 string, without duplicates.
+ */
+static std::vector<Uint32> charset(const std::string& text) {
+    std::vector<Uint32> result;
+    const char* pos = text.c_str();
+    const char* end = pos+text.size();
+    while (pos != end) {
+        Uint32 code = utf8::next(pos, end);
+        if (std::find(result.begin(), result.end(), code) == result.end()) {
+            result.push_back(code);
+        }
+    }
+    return result;
+}
+
+/**
+ * Returns the given code point as a UTF8 string.
+ *
+ * @param code  The code point
+ *
+ * @return the given code point as a UTF8 string.
+ */
+static std::string encode(Uint32 code) {
+    std::string result;
+    utf8::append(code, std::back_inserter(result));
+    return result;
+}
+
+/**
+ * A single glyph quad, with the texels it samples
+ */
+class Quad {
+public:
+    /** The corners of the quad */
+    Vec2 corners[4];
+    /** The RGBA texels under the quad */
+    std::vector<Uint8> texels;
+    
+    /** Returns true if this quad is drawn before the given one */
+    bool operator<(const Quad& other) const {
+        if (corners[0].x != other.corners[0].x) {
+            return corners[0].x < other.corners[0].x;
+        }
+        return corners[0].y < other.corners[0].y;
+    }
+    
+    /** Returns true if this quad draws the same as the given one */
+    bool operator==(const Quad& other) const {
+        for(int ii = 0; ii < 4; ii++) {
+            if (corners[ii] != other.corners[ii]) {
+                return false;
+            }
+        }
+        return texels == other.texels;
+    }
+};
+
+/**
+ * Returns the RGBA texels in the given region of a texture.
+ *
+ * The texels are read through a framebuffer, as OpenGLES cannot read
+ * a texture directly.
+ *
+ * @param texture   The texture to read
+ * @param region    The region in texels
+ *
+ * @return the RGBA texels in the given region of a texture.
+ */
+static std::vector<Uint8> readTexels(const std::shared_ptr<Texture>& texture, const Rect region) {
+    GLint x = (GLint)std::round(region.origin.x);
+    GLint y = (GLint)std::round(region.origin.y);
+    GLint w = (GLint)std::round(region.getMaxX())-x;
+    GLint h = (GLint)std::round(region.getMaxY())-y;
+    std::vector<Uint8> result(4*std::max(w,0)*std::max(h,0));
+    if (result.empty()) {
+        return result;
+    }
+    
+    GLuint framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->getBuffer(), 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, result.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    return result;
+}
+
+/**
+ * Returns the quads of the given glyph runs, in drawing order.
+ *
+ * The quads from every atlas are merged, so that two fonts with different
+ * atlas layouts may be compared.
+ *
+ * @param runs  The glyph runs
+ *
+ * @return the quads of the given glyph runs, in drawing order.
+ */
+static std::vector<Quad> quads(const std::unordered_map<GLuint, std::shared_ptr<GlyphRun>>& runs) {
+    std::vector<Quad> result;
+    for(auto it = runs.begin(); it != runs.end(); ++it) {
+        const std::shared_ptr<Texture>& texture = it->second->texture;
+        const std::vector<SpriteVertex>& vertices = it->second->mesh.vertices;
+        for(size_t ii = 0; ii+3 < vertices.size(); ii += 4) {
+            Quad quad;
+            Vec2 minp(FLT_MAX,FLT_MAX);
+            Vec2 maxp(-FLT_MAX,-FLT_MAX);
+            for(int jj = 0; jj < 4; jj++) {
+                quad.corners[jj] = vertices[ii+jj].position;
+                minp.x = std::min(minp.x,vertices[ii+jj].texcoord.x);
+                minp.y = std::min(minp.y,vertices[ii+jj].texcoord.y);
+                maxp.x = std::max(maxp.x,vertices[ii+jj].texcoord.x);
+                maxp.y = std::max(maxp.y,vertices[ii+jj].texcoord.y);
+            }
+            Size size(texture->getWidth(),texture->getHeight());
+            Rect region(minp.x*size.width,minp.y*size.height,
+                        (maxp.x-minp.x)*size.width,(maxp.y-minp.y)*size.height);
+            quad.texels = readTexels(texture, region);
+            result.push_back(quad);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/**
+ * Checks the metrics and kerning tables against SDL_ttf.
+ *
+ * @param font  The font to check
+ * @param data  The same font opened directly by SDL_ttf
+ * @param chars The characters to check
+ */
+static void testTables(const std::shared_ptr<Font>& font, TTF_Font* data,
+                       const std::vector<Uint32>& chars) {
+    bool metrics = true;
+    for (auto it = chars.begin(); it != chars.end(); ++it) {
+        Font::Metrics expected;
+        TTF_GlyphMetrics32(data, *it, &expected.minx, &expected.maxx,
+                           &expected.miny, &expected.maxy, &expected.advance);
+        
+        // Fonts center each glyph in its rendered width
+        int width, height;
+        TTF_SizeUTF8(data, encode(*it).c_str(), &width, &height);
+        int diff = width-expected.advance;
+        expected.minx += diff/2;
+        expected.maxx += diff/2;
+        expected.advance += diff;
+        
+        Font::Metrics actual = font->getMetrics(*it);
+        metrics = metrics && font->hasGlyph(*it);
+        metrics = metrics && actual.minx == expected.minx && actual.maxx == expected.maxx;
+        metrics = metrics && actual.miny == expected.miny && actual.maxy == expected.maxy;
+        metrics = metrics && actual.advance == expected.advance;
+    }
+    CU_CHECK(metrics);
+
+    // Kerning is the advance lost when two glyphs are rendered together
+    size_t pairs = 0;
+    size_t kerned = 0;
+    for (auto at = chars.begin(); at != chars.end(); ++at) {
+        int aadvance = font->getMetrics(*at).advance;
+        for (auto bt = chars.begin(); bt != chars.end(); ++bt) {
+            int width, height;
+            std::string pair = encode(*at)+encode(*bt);
+            TTF_SizeUTF8(data, pair.c_str(), &width, &height);
+            int expected = aadvance+font->getMetrics(*bt).advance-width;
+            int actual = font->getKerning(*at, *bt);
+            if (actual != expected) {
+                std::printf("  kerning of '%s' is %d, expected %d\n", pair.c_str(), actual, expected);
+                CU_CHECK(actual == expected);
+            }
+            kerned += actual != 0;
+            pairs++;
+        }
+    }
+    std::printf("%zu glyphs, %zu pairs checked, %zu with kerning\n", chars.size(), pairs, kerned);
+}
+
+/**
+ * Reports the time to lay out and measure a large paragraph.
+ *
+ * @param font  The font to use
+ * @param text  The paragraph
+ */
+static void timeLayout(const std::shared_ptr<Font>& font, const std::string& text) {
+    auto layout = TextLayout::allocWithTextWidth(text, font, LINE_WIDTH);
+    double time1 = cu_test_time([&] {
+        layout->invalidate();
+        layout->layout();
+    }, 7);
+    CU_CHECK(layout->getLineCount() > 1);
+
+    Size size;
+    double time2 = cu_test_time([&] {
+        size = font->getSize(text);
+    }, 7);
+    CU_CHECK(size.width > LINE_WIDTH);
+    std::printf("%zu bytes in %zu lines: %.3f ms layout, %.3f ms getSize\n",
+                text.size(), layout->getLineCount(), time1, time2);
+}
+
+/**
+ * Checks that a dynamic atlas matches an atlas built up front.
+ *
+ * One font builds its atlases for the whole character set before use.
+ * The other has no atlases, and adds each glyph to a dynamic atlas the
+ * first time a line needs it. Every line must measure the same and draw
+ * the same quads over the same texels in both fonts.
+ *
+ * @param path  The path to the font file
+ * @param lines The lines to draw
+ * @param chars The characters of the lines
+ */
+static void testDynamic(const std::string& path, const std::vector<std::string>& lines,
+                        const std::vector<Uint32>& chars) {
+    auto eager = Font::alloc(path, FONT_SIZE);
+    auto lazy  = Font::alloc(path, FONT_SIZE);
+    CU_CHECK(eager->buildAtlases(chars));
+    lazy->setAtlasDynamic(true);
+    CU_CHECK(lazy->getAtlases().empty());
+    
+    bool sizes = true;
+    bool render = true;
+    for(auto it = lines.begin(); it != lines.end(); ++it) {
+        std::vector<Quad> expected = quads(eager->getGlyphs(*it, Vec2(10,20)));
+        std::vector<Quad> actual = quads(lazy->getGlyphs(*it, Vec2(10,20)));
+        render = render && !expected.empty() && expected == actual;
+        sizes = sizes && eager->getSize(*it) == lazy->getSize(*it);
+    }
+    CU_CHECK(render);
+    CU_CHECK(sizes);
+    
+    bool metrics = true;
+    for(auto it = chars.begin(); it != chars.end(); ++it) {
+        Font::Metrics expected = eager->getMetrics(*it);
+        Font::Metrics actual = lazy->getMetrics(*it);
+        metrics = metrics && lazy->hasGlyph(*it) && lazy->hasAtlases(encode(*it));
+        metrics = metrics && actual.minx == expected.minx && actual.maxx == expected.maxx;
+        metrics = metrics && actual.miny == expected.miny && actual.maxy == expected.maxy;
+        metrics = metrics && actual.advance == expected.advance;
+        metrics = metrics && eager->getSize(encode(*it)) == lazy->getSize(encode(*it));
+    }
+    CU_CHECK(metrics);
+    std::printf("%zu lines drawn with %zu eager and %zu dynamic atlases\n",
+                lines.size(), eager->getAtlases().size(), lazy->getAtlases().size());
+}
+
+/**
+ * Checks that the glyph run cache is transparent, invalidated and bounded.
+ *
+ * @param path  The path to the font file
+ * @param lines The lines to draw
+ * @param chars The characters of the lines
+ */
+static void testCache(const std::string& path, const std::vector<std::string>& lines,
+                      const std::vector<Uint32>& chars) {
+    auto plain = Font::alloc(path, FONT_SIZE);
+    auto font  = Font::alloc(path, FONT_SIZE);
+    CU_CHECK(plain->buildAtlases(chars));
+    CU_CHECK(font->buildAtlases(chars));
+    font->setRunCacheLimit(CACHE_LIMIT);
+    
+    // A cached line draws the same, wherever it is drawn
+    bool render = true;
+    for(int ii = 0; ii < 3; ii++) {
+        Vec2 origin(5.0f*ii,-7.0f*ii);
+        std::vector<Quad> expected = quads(plain->getGlyphs(lines[0], origin));
+        std::vector<Quad> actual = quads(font->getGlyphs(lines[0], origin));
+        render = render && expected == actual;
+        render = render && font->hasCachedRun(lines[0]);
+    }
+    CU_CHECK(render);
+    CU_CHECK(font->getRunCacheSize() == 1);
+    
+    // Every path that changes the glyphs must empty the cache
+    const std::string spare = "0123456789";
+    std::vector<Uint32> spares = charset(spare);
+    Rect bounds(-LINE_WIDTH,-LINE_WIDTH,4*LINE_WIDTH,2*LINE_WIDTH);
+    std::function<void()> build = [&] { font->buildAtlases(chars); };
+    std::function<void()> clear = [&] { font->clearAtlases(); };
+    struct Path {
+        const char* name;
+        std::function<void()> prepare;
+        std::function<void()> change;
+    };
+    std::vector<Path> paths = {
+        { "setKerning", build, [&] { font->setKerning(!font->usesKerning()); } },
+        { "setStyle", build, [&] { font->setStyle(Font::Style::BOLD); } },
+        { "setHinting", build, [&] { font->setHinting(Font::Hinting::MONO); } },
+        { "setPadding", build, [&] { font->setPadding(font->getPadding()+1); } },
+        { "setAtlasFallback", build, [&] { font->setAtlasFallback(!font->hasAtlasFallback()); } },
+        { "setAtlasDynamic", build, [&] { font->setAtlasDynamic(!font->hasAtlasDynamic()); } },
+        { "setShrinkLimit", build, [&] { font->setShrinkLimit(font->getShrinkLimit()+1); } },
+        { "setStretchLimit", build, [&] { font->setStretchLimit(font->getStretchLimit()+1); } },
+        { "clearRunCache", build, [&] { font->clearRunCache(); } },
+        { "clearAtlases", build, [&] { font->clearAtlases(); } },
+        { "buildAtlases()", clear, [&] { font->buildAtlases(); } },
+        { "buildAtlases(string)", clear, [&] { font->buildAtlases(spare); } },
+        { "buildAtlases(vector)", clear, [&] { font->buildAtlases(spares); } },
+        { "buildAtlasesAsync()", clear, [&] { font->buildAtlasesAsync(); } },
+        { "buildAtlasesAsync(string)", clear, [&] { font->buildAtlasesAsync(spare); } },
+        { "buildAtlasesAsync(vector)", clear, [&] { font->buildAtlasesAsync(spares); } },
+        { "dispose", build, [&] { font->dispose(); } },
+    };
+    for(auto it = paths.begin(); it != paths.end(); ++it) {
+        it->prepare();
+        font->getGlyphs(lines[1], Vec2::ZERO);
+        font->getGlyphs(lines[0], Vec2::ZERO, bounds, LINE_WIDTH);
+        bool filled = font->getRunCacheSize() == 2 && font->hasCachedRun(lines[0], LINE_WIDTH);
+        it->change();
+        bool emptied = font->getRunCacheSize() == 0 && !font->hasCachedRun(lines[0], LINE_WIDTH);
+        if (!filled || !emptied) {
+            std::printf("  %s did not clear the glyph run cache\n", it->name);
+        }
+        CU_CHECK(filled && emptied);
+    }
+    
+    // Eviction is least recently used and never exceeds the limit
+    font = Font::alloc(path, FONT_SIZE);
+    CU_CHECK(font->buildAtlases(chars));
+    font->setRunCacheLimit(CACHE_LIMIT);
+    bool bounded = true;
+    bool recent  = true;
+    for(size_t ii = 1; ii < lines.size(); ii++) {
+        font->getGlyphs(lines[ii], Vec2::ZERO);
+        font->getGlyphs(lines[0], Vec2::ZERO);
+        bounded = bounded && font->getRunCacheSize() <= CACHE_LIMIT;
+        for(size_t jj = 1; jj <= ii; jj++) {
+            recent = recent && font->hasCachedRun(lines[jj]) == (jj+CACHE_LIMIT > ii+1);
+        }
+        recent = recent && font->hasCachedRun(lines[0]);
+    }
+    CU_CHECK(bounded);
+    CU_CHECK(recent);
+    CU_CHECK(font->getRunCacheSize() == CACHE_LIMIT);
+    
+    font->setRunCacheLimit(CACHE_LIMIT/2);
+    CU_CHECK(font->getRunCacheSize() == CACHE_LIMIT/2);
+    CU_CHECK(font->hasCachedRun(lines[0]));
+    CU_CHECK(font->hasCachedRun(lines.back()));
+    CU_CHECK(!font->hasCachedRun(lines[lines.size()-CACHE_LIMIT/2]));
+    std::printf("%zu invalidation paths checked\n", paths.size());
+}
+
+/**
+ * Returns an OpenGL context for a hidden window, or nullptr if not supported.
+ *
+ * @param window    The window to store the result
+ *
+ * @return an OpenGL context for a hidden window, or nullptr if not supported.
+ */
+static SDL_GLContext openGL(SDL_Window*& window) {
+    window = nullptr;
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        return nullptr;
+    }
+#if CU_GL_PLATFORM == CU_GL_OPENGLES
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+#else
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+#endif
+    window = SDL_CreateWindow("FontTest", 0, 0, 64, 64, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    SDL_GLContext context = window == nullptr ? nullptr : SDL_GL_CreateContext(window);
+    if (context == nullptr) {
+        return nullptr;
+    }
+#if CU_PLATFORM == CU_PLATFORM_WINDOWS || CU_PLATFORM == CU_PLATFORM_LINUX
+    glewExperimental = GL_TRUE;
+    glewInit();
+#endif
+    return context;
+}
+
+/**
+ * Runs the font checks and timings.
+ */
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : CU_TEST_FONT;
+    if (TTF_Init() < 0) {
+        std::printf("Could not initialize TTF: %s\n", TTF_GetError());
+        return 1;
+    }
+    TTF_Font* data = TTF_OpenFont(path, FONT_SIZE);
+    auto font = Font::alloc(path, FONT_SIZE);
+    CU_CHECK(data != nullptr && font != nullptr);
+    if (data == nullptr || font == nullptr) {
+        TTF_Quit();
+        return cu_test_result("FontTest");
+    }
+
+    std::string text;
+    std::mt19937 rand(5);
+    std::uniform_int_distribution<size_t> word(0, sizeof(WORDS)/sizeof(char*)-1);
+    while (text.size() < TEXT_SIZE) {
+        text.append(WORDS[word(rand)]);
+        text.push_back(' ');
+    }
+    std::vector<Uint32> chars = charset(text);
+    CU_CHECK(font->buildAtlasesAsync(chars));
+    CU_CHECK(!font->hasGlyph(0x10FFFD));
+
+    testTables(font, data, chars);
+    timeLayout(font, text);
+    font = nullptr;
+
+    // Distinct lines for the atlas and cache checks
+    std::vector<std::string> lines;
+    while (lines.size() < LINE_COUNT) {
+        std::string line = WORDS[word(rand)];
+        for(int ii = 1; ii < LINE_WORDS; ii++) {
+            line.push_back(' ');
+            line.append(WORDS[word(rand)]);
+        }
+        if (std::find(lines.begin(), lines.end(), line) == lines.end()) {
+            lines.push_back(line);
+        }
+    }
+
+    SDL_Window* window;
+    SDL_GLContext context = openGL(window);
+    if (context != nullptr) {
+        testDynamic(path, lines, chars);
+        testCache(path, lines, chars);
+        SDL_GL_DeleteContext(context);
+    } else {
+        std::printf("No OpenGL context: %s; atlas checks skipped\n", SDL_GetError());
+    }
+    if (window != nullptr) {
+        SDL_DestroyWindow(window);
+    }
+    SDL_Quit();
+
+    TTF_CloseFont(data);
+    TTF_Quit();
+    return cu_test_result("FontTest");
+}
@@ -0,0 +1,453 @@
+//
+//  JsonTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the streaming JSON parser and the JsonValue trees that
+//  it builds. It compares the trees against the CUJSON reader (which was
+//  the original parsing engine) on nested, escaped and unicode documents,
+//  both with and without an arena. It checks that malformed documents are
+//  rejected, that the key index agrees with a linear search after every
+//  kind of change to the children, and that several threads may read the
+//  same tree at once. It then reports the time to parse a large document.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/17/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/core/assets/CUJSON.h>
+#include <cugl/core/assets/CUJsonValue.h>
+#include <cugl/core/io/CUJsonParser.h>
+#include <CUTestHarness.h>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <thread>
+
+using namespace cugl;
+
+/** The number of random documents to compare */
+#define DOCUMENT_COUNT  200
+/** The number of keys in the indexed object */
+#define KEY_COUNT       1000
+/** The number of reader threads */
+#define THREAD_COUNT    4
+
+#pragma mark Comparison
+/**
+ * Returns true if the JsonValue tree matches the CUJSON tree
+ *
+ * @param a The CUJSON node
+ * @param b The JsonValue node
+ *
+ * @return true if the JsonValue tree matches the CUJSON tree
+ */
+static bool same(const CUJSON* a, const JsonValue* b) {
+    std::string key = a->string ? a->string : "";
+    if (key != b->key()) {
+        return false;
+    }
+    switch (a->type & 0xFF) {
+        case CUJSON_False:
+            return b->isBool() && !b->asBool();
+        case CUJSON_True:
+            return b->isBool() && b->asBool();
+        case CUJSON_NULL:
+            return b->isNull();
+        case CUJSON_Number:
+            if (!b->isNumber() || a->valuedouble != b->asDouble()) {
+                return false;
+            }
+            // CUJSON only stores an int
+            return std::fabs(a->valuedouble) >= 2147483647.0 || a->valueint == b->asLong();
+        case CUJSON_String:
+            return b->isString() && b->asString() == a->valuestring;
+        case CUJSON_Array:
+        case CUJSON_Object:
+        {
+            if (b->type() != ((a->type & 0xFF) == CUJSON_Array ? JsonValue::Type::ArrayType
+                                                                : JsonValue::Type::ObjectType)) {
+                return false;
+            }
+            size_t pos = 0;
+            for(const CUJSON* child = a->child; child != nullptr; child = child->next) {
+                if (pos >= b->size() || !same(child, b->get((int)pos).get())) {
+                    return false;
+                }
+                pos++;
+            }
+            return pos == b->size();
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns true if both readers produce the same tree for the text
+ *
+ * The text is read with and without an arena.
+ *
+ * @param text  The JSON text
+ *
+ * @return true if both readers produce the same tree for the text
+ */
+static bool agree(const std::string& text) {
+    CUJSON* expected = CUJSON_Parse(text.c_str());
+    if (expected == nullptr) {
+        return false;
+    }
+    bool result = true;
+    for(int arena = 0; arena < 2; arena++) {
+        auto actual = JsonValue::allocWithJson(text, arena);
+        result = result && actual != nullptr && same(expected, actual.get());
+    }
+    CUJSON_Delete(expected);
+    return result;
+}
+
+#pragma mark Documents
+/**
+ * Returns a random JSON string literal
+ *
+ * The string mixes plain text, every escape sequence, unicode escapes
+ * (including surrogate pairs) and raw UTF-8.
+ *
+ * @param rand  The random generator
+ *
+ * @return a random JSON string literal
+ */
+static std::string randomString(std::mt19937& rand) {
+    static const char* pieces[] = {
+        "a", "key", " ", "\\\"", "\\\\", "\\/", "\\b", "\\f", "\\n", "\\r", "\\t",
+        "\\u0041", "\\u00e9", "\\u20AC", "\\u4e2d", "\\ud83d\\ude00", "\\u001f",
+        "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80"
+    };
+    size_t count = sizeof(pieces)/sizeof(pieces[0]);
+    std::string result = "\"";
+    int length = rand() % 8;
+    for(int ii = 0; ii < length; ii++) {
+        result += pieces[rand() % count];
+    }
+    return result+"\"";
+}
+
+/**
+ * Returns a random JSON number literal
+ *
+ * @param rand  The random generator
+ *
+ * @return a random JSON number literal
+ */
+static std::string randomNumber(std::mt19937& rand) {
+    static const char* fixed[] = {
+        "0", "-0", "1", "-1", "2147483647", "-2147483648", "12345678901",
+        "0.5", "-3.25", "1e3", "1E-3", "6.02e+23", "-1.5e-7", "123.456e2"
+    };
+    size_t count = sizeof(fixed)/sizeof(fixed[0]);
+    if (rand() % 2) {
+        return fixed[rand() % count];
+    }
+    return std::to_string((int)(rand() % 20001)-10000);
+}
+
+/**
+ * Returns a random JSON value with nested containers
+ *
+ * Objects sometimes have enough keys to be indexed.
+ *
+ * @param rand  The random generator
+ * @param depth The maximum remaining depth
+ *
+ * @return a random JSON value with nested containers
+ */
+static std::string randomValue(std::mt19937& rand, int depth) {
+    int kind = rand() % (depth > 0 ? 8 : 6);
+    switch (kind) {
+        case 0:
+            return "null";
+        case 1:
+            return rand() % 2 ? "true" : "false";
+        case 2:
+        case 3:
+            return randomNumber(rand);
+        case 4:
+        case 5:
+            return randomString(rand);
+        case 6:
+        {
+            std::string result = "[ ";
+            int size = rand() % 6;
+            for(int ii = 0; ii < size; ii++) {
+                result += (ii ? ", " : "")+randomValue(rand, depth-1);
+            }
+            return result+" ]";
+        }
+        default:
+        {
+            std::string result = "{\n";
+            int size = rand() % 3 ? rand() % 4 : 8+rand() % 8;
+            for(int ii = 0; ii < size; ii++) {
+                std::string key = randomString(rand);
+                key.insert(1, "k"+std::to_string(ii));
+                result += (ii ? ",\n" : "")+key+" :\t"+randomValue(rand, depth-1);
+            }
+            return result+"\n}";
+        }
+    }
+}
+
+#pragma mark Checks
+/**
+ * Checks the parser against the CUJSON reader on fixed documents.
+ */
+static void testFixed() {
+    CU_CHECK(agree("{}"));
+    CU_CHECK(agree("[]"));
+    CU_CHECK(agree("  {\"a\" : [1, 2.5, -3e2, true, false, null, \"\"] }  "));
+    CU_CHECK(agree("{\"nested\":{\"deeper\":{\"deepest\":[[[]],[{}],{\"x\":[1]}]}}}"));
+    CU_CHECK(agree("[\"\\\"quoted\\\"\", \"back\\\\slash\", \"\\/\\b\\f\\n\\r\\t\"]"));
+    CU_CHECK(agree("{\"\\u00e9t\\u00e9\" : \"\\u20ac\\u4e2d\\ud83d\\ude00\", \"raw\" : \"\xc3\xa9\xf0\x9f\x98\x80\"}"));
+    CU_CHECK(agree("{\"k\\n\\u0041y\" : 1}"));
+
+    // Lenient numbers and trailing text are read as CUJSON reads them
+    CU_CHECK(agree("[01, -, 1e, 2E+]"));
+    CU_CHECK(agree("{\"a\":1}}"));
+    CU_CHECK(agree("[1] [2]"));
+
+    // Deep nesting
+    std::string deep;
+    for(int ii = 0; ii < 200; ii++) {
+        deep += "{\"d\":[";
+    }
+    deep += "1";
+    for(int ii = 0; ii < 200; ii++) {
+        deep += "]}";
+    }
+    CU_CHECK(agree(deep));
+
+    // Unicode escapes decode to UTF-8
+    auto json = JsonValue::allocWithJson("[\"\\u00e9\", \"\\u20AC\", \"\\ud83d\\ude00\"]");
+    CU_CHECK(json != nullptr && json->get(0)->asString() == "\xc3\xa9");
+    CU_CHECK(json != nullptr && json->get(1)->asString() == "\xe2\x82\xac");
+    CU_CHECK(json != nullptr && json->get(2)->asString() == "\xf0\x9f\x98\x80");
+}
+
+/**
+ * Checks the parser against the CUJSON reader on random documents.
+ *
+ * Each document is also encoded and read back.
+ */
+static void testRandom() {
+    std::mt19937 rand(5);
+    bool valid = true;
+    bool encoded = true;
+    for(int ii = 0; ii < DOCUMENT_COUNT; ii++) {
+        std::string text = rand() % 2 ? randomValue(rand, 5) : "{\"root\":"+randomValue(rand, 5)+"}";
+        if (!agree(text)) {
+            std::printf("  disagree: %s\n", text.c_str());
+            valid = false;
+            continue;
+        }
+        auto json = JsonValue::allocWithJson(text);
+        encoded = encoded && agree(json->toString(ii % 2 == 0));
+    }
+    CU_CHECK(valid);
+    CU_CHECK(encoded);
+}
+
+/**
+ * Checks that malformed documents are rejected.
+ */
+static void testErrors() {
+    const char* bad[] = {
+        "", "{", "[1,2", "{\"a\" 1}", "{\"a\":}", "[1,]", "{\"a\":1,}", "[tru]",
+        "[nul]", "\"open", "[\"bad \\x escape\"]", "[\"\\u12\"]", "{1:2}", "[1 2]",
+        "[1.]"
+    };
+    for(size_t ii = 0; ii < sizeof(bad)/sizeof(bad[0]); ii++) {
+        for(int arena = 0; arena < 2; arena++) {
+            bool rejected = JsonValue::allocWithJson(bad[ii], arena) == nullptr;
+            if (!rejected) {
+                std::printf("  accepted: %s\n", bad[ii]);
+            }
+            CU_CHECK(rejected);
+        }
+        auto parser = JsonParser::alloc(bad[ii]);
+        JsonParser::Event event = JsonParser::Event::None;
+        for(int step = 0; step < 16 && event != JsonParser::Event::Error; step++) {
+            event = parser->next();
+        }
+        CU_CHECK(event == JsonParser::Event::Error && !parser->getError().empty());
+    }
+}
+
+/**
+ * Returns true if keyed lookups agree with a linear search
+ *
+ * @param node  The node to search
+ * @param keys  The keys to look up (present or not)
+ *
+ * @return true if keyed lookups agree with a linear search
+ */
+static bool lookups(const std::shared_ptr<JsonValue>& node, const std::vector<std::string>& keys) {
+    for(auto it = keys.begin(); it != keys.end(); ++it) {
+        std::shared_ptr<JsonValue> expected = nullptr;
+        for(size_t ii = 0; expected == nullptr && ii < node->size(); ii++) {
+            if (node->get((int)ii)->key() == *it) {
+                expected = node->get((int)ii);
+            }
+        }
+        if (node->get(*it) != expected || node->has(*it) != (expected != nullptr)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks the key index after every kind of change to the children.
+ */
+static void testIndex() {
+    std::string text = "{";
+    std::vector<std::string> keys;
+    for(int ii = 0; ii < KEY_COUNT; ii++) {
+        keys.push_back("key"+std::to_string(ii));
+        text += (ii ? ",\"" : "\"")+keys.back()+"\":"+std::to_string(ii);
+    }
+    text += "}";
+    keys.push_back("missing");
+    keys.push_back("");
+
+    for(int arena = 0; arena < 2; arena++) {
+        auto json = JsonValue::allocWithJson(text, arena);
+        CU_CHECK(json != nullptr && lookups(json, keys));
+        if (json == nullptr) {
+            continue;
+        }
+
+        json->appendValue("added", 1.0);
+        keys.push_back("added");
+        CU_CHECK(lookups(json, keys));
+
+        json->removeChild("key10");
+        json->removeChild(0);
+        CU_CHECK(lookups(json, keys));
+
+        json->insertChild(5, "inserted", JsonValue::alloc(2.0));
+        keys.push_back("inserted");
+        CU_CHECK(lookups(json, keys));
+
+        json->get("key20")->setKey("renamed");
+        keys.push_back("renamed");
+        CU_CHECK(lookups(json, keys));
+
+        json->get("key30")->merge(JsonValue::alloc(std::string("merged")));
+        CU_CHECK(lookups(json, keys) && json->getString("key30") == "merged");
+        keys.resize(KEY_COUNT+2);
+    }
+
+    // Small objects become indexed as they grow
+    auto small = JsonValue::allocObject();
+    std::vector<std::string> few;
+    for(int ii = 0; ii < 2*CU_JSON_INDEX_MINIMUM; ii++) {
+        few.push_back("k"+std::to_string(ii));
+        small->appendValue(few.back(), (long)ii);
+        CU_CHECK(lookups(small, few));
+    }
+}
+
+/**
+ * Checks that several threads may look up keys in the same tree.
+ */
+static void testThreads() {
+    std::string text = "{\"dir\":{";
+    for(int ii = 0; ii < KEY_COUNT; ii++) {
+        text += (ii ? ",\"" : "\"")+std::to_string(ii)+"\":{\"v\":"+std::to_string(ii)+"}";
+    }
+    text += "}}";
+    std::shared_ptr<const JsonValue> json = JsonValue::allocWithJson(text);
+    CU_CHECK(json != nullptr);
+    if (json == nullptr) {
+        return;
+    }
+
+    std::vector<int> found(THREAD_COUNT, 0);
+    std::vector<std::thread> threads;
+    for(int tt = 0; tt < THREAD_COUNT; tt++) {
+        threads.emplace_back([&, tt] {
+            const std::shared_ptr<JsonValue> dir = json->get("dir");
+            for(int ii = 0; ii < KEY_COUNT; ii++) {
+                int key = (ii*7+tt*131) % KEY_COUNT;
+                if (dir->get(std::to_string(key))->getLong("v") == key) {
+                    found[tt]++;
+                }
+            }
+        });
+    }
+    for(auto it = threads.begin(); it != threads.end(); ++it) {
+        it->join();
+    }
+    for(int tt = 0; tt < THREAD_COUNT; tt++) {
+        CU_CHECK(found[tt] == KEY_COUNT);
+    }
+}
+
+#pragma mark Timings
+/**
+ * Reports the time to parse a large document with each reader.
+ */
+static void timeParser() {
+    std::mt19937 rand(11);
+    std::string text = "[";
+    for(int ii = 0; ii < 2000; ii++) {
+        text += (ii ? ",\n" : "")+randomValue(rand, 6);
+    }
+    text += "]";
+
+    double cujson = cu_test_time([&] {
+        CUJSON_Delete(CUJSON_Parse(text.c_str()));
+    });
+    double parser = cu_test_time([&] {
+        JsonValue::allocWithJson(text);
+    });
+    double arena = cu_test_time([&] {
+        JsonValue::allocWithJson(text, true);
+    });
+    double events = cu_test_time([&] {
+        auto pull = JsonParser::alloc(text);
+        while (pull->next() != JsonParser::Event::Finished) {}
+    });
+    std::printf("%.1f KB: %.2f ms CUJSON, %.2f ms JsonValue, %.2f ms with arena, %.2f ms events only\n",
+                text.size()/1024.0, cujson, parser, arena, events);
+}
+
+/**
+ * Runs the JSON checks and timings.
+ */
+int main(int argc, char** argv) {
+    testFixed();
+    testRandom();
+    testErrors();
+    testIndex();
+    testThreads();
+    timeParser();
+    return cu_test_result("JsonTest");
+}
@@ -0,0 +1,176 @@
+//
+//  LoggerTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the asynchronous logger. It logs messages with mixed
+//  argument types, length modifiers, and star widths, and checks that the
+//  file written by the background thread matches printf exactly. It then
+//  reports the time spent in the calling thread by synchronous and by
+//  asynchronous logging.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/core/CUApplication.h>
+#include <cugl/core/util/CULogger.h>
+#include <CUTestHarness.h>
+#include <fstream>
+
+using namespace cugl;
+
+/** The number of messages in the timing test */
+#define MESSAGE_COUNT   20000
+
+/**
+ * An application that only provides a save directory.
+ *
+ * Loggers write to the save directory, but this driver does not need a
+ * window, so the application is never initialized.
+ */
+class LoggerApp : public Application {
+public:
+    /**
+     * Creates the application and makes it the active one.
+     */
+    LoggerApp() {
+        setOrganization("GDIAC");
+        setName("LoggerTest");
+        _theapp = this;
+    }
+};
+
+/**
+ * Returns the messages in the given log file, without their prefixes.
+ *
+ * @param path  The log file
+ *
+ * @return the messages in the given log file, without their prefixes.
+ */
+static std::vector<std::string> read_log(const std::string path) {
+    std::vector<std::string> result;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t pos = line.find("] ");
+        result.push_back(pos == std::string::npos ? line : line.substr(pos+2));
+    }
+    return result;
+}
+
+/**
+ * Returns the given arguments formatted by snprintf.
+ *
+ * @param format    The formatting string
+ * @param ...       The printf-style subsitution arguments
+ *
+ * @return the given arguments formatted by snprintf.
+ */
+static std::string expect(const char* format, ...) {
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return buffer;
+}
+
+/**
+ * Checks that asynchronous messages with mixed arguments match printf.
+ */
+static void testArguments() {
+    auto logger = Logger::open("async", Logger::Level::INFO_MSG);
+    CU_CHECK(logger != nullptr);
+    if (logger == nullptr) {
+        return;
+    }
+    logger->setAsync(true);
+
+    std::vector<std::string> expected;
+    long long big = -1234567890123LL;
+    size_t size = 4000000000u;
+    std::string* temp = new std::string("freed");
+
+    logger->log("%d %s %f", 42, "mixed", 3.25);
+    expected.push_back(expect("%d %s %f", 42, "mixed", 3.25));
+    logger->log("%lld %zu %c %x", big, size, 'q', 255u);
+    expected.push_back(expect("%lld %zu %c %x", big, size, 'q', 255u));
+    logger->log("%*d|%-8s|%.3e|%5.1f%%", 6, -17, "left", 6.02e23, 99.44);
+    expected.push_back(expect("%*d|%-8s|%.3e|%5.1f%%", 6, -17, "left", 6.02e23, 99.44));
+    logger->log("%s %hd %ld %s", "a", (short)-3, 70000L, "z");
+    expected.push_back(expect("%s %hd %ld %s", "a", (short)-3, 70000L, "z"));
+    logger->log("%s then %d", temp->c_str(), 7);
+    expected.push_back(expect("%s then %d", temp->c_str(), 7));
+    delete temp;
+    logger->log("no arguments");
+    expected.push_back("no arguments");
+
+    logger->flush();
+    std::vector<std::string> lines = read_log(logger->getPath());
+    CU_CHECK(lines.size() == expected.size());
+    for (size_t ii = 0; ii < lines.size() && ii < expected.size(); ii++) {
+        CU_CHECK(lines[ii] == expected[ii]);
+        if (lines[ii] != expected[ii]) {
+            std::printf("  logged '%s', expected '%s'\n", lines[ii].c_str(), expected[ii].c_str());
+        }
+    }
+    Logger::close("async");
+}
+
+/**
+ * Returns the time in milliseconds for the calling thread to log messages.
+ *
+ * @param channel   The log channel
+ * @param async     Whether to log asynchronously
+ *
+ * @return the time in milliseconds for the calling thread to log messages.
+ */
+static double timeLogger(const std::string channel, bool async) {
+    auto logger = Logger::open(channel, Logger::Level::INFO_MSG);
+    if (logger == nullptr) {
+        return 0;
+    }
+    logger->setAutoFlush(true);
+    logger->setAsync(async);
+    double time = cu_test_time([&] {
+        for (int ii = 0; ii < MESSAGE_COUNT; ii++) {
+            logger->log("frame %d: position (%f,%f) in %s", ii, ii*0.5f, ii*-0.25f, "world");
+        }
+    }, 1);
+    logger->flush();
+    CU_CHECK(read_log(logger->getPath()).size() == MESSAGE_COUNT);
+    Logger::close(channel);
+    return time;
+}
+
+/**
+ * Runs the logger checks and timings.
+ */
+int main(int argc, char** argv) {
+    LoggerApp app;
+    testArguments();
+    double sync  = timeLogger("sync", false);
+    double async = timeLogger("timed", true);
+    std::printf("%d messages with auto flush: %.3f us per call sync, %.3f us per call async\n",
+                MESSAGE_COUNT, sync*1000/MESSAGE_COUNT, async*1000/MESSAGE_COUNT);
+    return cu_test_result("LoggerTest");
+}
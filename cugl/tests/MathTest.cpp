@@ -0,0 +1,461 @@
+//
+//  MathTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the vector backend of the math classes. It compares
+//  Vec4 addition, Mat4 multiplication, inversion and array transforms,
+//  Affine2 multiplication and array transforms, and the packed Color4 tint
+//  against the scalar code that they replace. The scalar reference is the
+//  original implementation, copied here so that both paths can be run in
+//  the same build. It then reports the time of each operation for the
+//  library and for the scalar reference.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/17/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/core/math/CUVec4.h>
+#include <cugl/core/math/CUMat4.h>
+#include <cugl/core/math/CUAffine2.h>
+#include <cugl/core/math/CUColor4.h>
+#include <CUTestHarness.h>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace cugl;
+
+/** The number of random matrices to check */
+#define MATRIX_COUNT    10000
+/** The number of vectors (or points, or colors) in each array */
+#define ARRAY_SIZE      100003
+/** The relative error allowed for float results */
+#define TOLERANCE       1e-5f
+
+#pragma mark Scalar Reference
+/**
+ * Multiplies m1 by m2 with the scalar code, storing the result in dst.
+ *
+ * @param m1    The first matrix to multiply.
+ * @param m2    The second matrix to multiply.
+ * @param dst   A matrix to store the result in.
+ */
+static void scalarMultiply(const Mat4& m1, const Mat4& m2, Mat4* dst) {
+    float product[16];
+    for(int col = 0; col < 4; col++) {
+        for(int row = 0; row < 4; row++) {
+            product[4*col+row] = m2.m[row] * m1.m[4*col] + m2.m[row+4] * m1.m[4*col+1]
+                               + m2.m[row+8] * m1.m[4*col+2] + m2.m[row+12] * m1.m[4*col+3];
+        }
+    }
+    std::memcpy(dst->m, product, sizeof(product));
+}
+
+/**
+ * Inverts m1 with the scalar code, storing the result in dst.
+ *
+ * @param m1    The matrix to invert.
+ * @param dst   A matrix to store the result in.
+ */
+static void scalarInvert(const Mat4& m1, Mat4* dst) {
+    float a0 = m1.m[0]  * m1.m[5] -  m1.m[1]  * m1.m[4];
+    float a1 = m1.m[0]  * m1.m[6] -  m1.m[2]  * m1.m[4];
+    float a2 = m1.m[0]  * m1.m[7] -  m1.m[3]  * m1.m[4];
+    float a3 = m1.m[1]  * m1.m[6] -  m1.m[2]  * m1.m[5];
+    float a4 = m1.m[1]  * m1.m[7] -  m1.m[3]  * m1.m[5];
+    float a5 = m1.m[2]  * m1.m[7] -  m1.m[3]  * m1.m[6];
+    float b0 = m1.m[8]  * m1.m[13] - m1.m[9]  * m1.m[12];
+    float b1 = m1.m[8]  * m1.m[14] - m1.m[10] * m1.m[12];
+    float b2 = m1.m[8]  * m1.m[15] - m1.m[11] * m1.m[12];
+    float b3 = m1.m[9]  * m1.m[14] - m1.m[10] * m1.m[13];
+    float b4 = m1.m[9]  * m1.m[15] - m1.m[11] * m1.m[13];
+    float b5 = m1.m[10] * m1.m[15] - m1.m[11] * m1.m[14];
+    float det = a0 * b5 - a1 * b4 + a2 * b3 + a3 * b2 - a4 * b1 + a5 * b0;
+    if (fabs(det) <= CU_MATH_FLOAT_SMALL) {
+        dst->setZero();
+        return;
+    }
+
+    float inverse[16];
+    inverse[0]  =  m1.m[5]  * b5 - m1.m[6]  * b4 + m1.m[7]  * b3;
+    inverse[1]  = -m1.m[1]  * b5 + m1.m[2]  * b4 - m1.m[3]  * b3;
+    inverse[2]  =  m1.m[13] * a5 - m1.m[14] * a4 + m1.m[15] * a3;
+    inverse[3]  = -m1.m[9]  * a5 + m1.m[10] * a4 - m1.m[11] * a3;
+    inverse[4]  = -m1.m[4]  * b5 + m1.m[6]  * b2 - m1.m[7]  * b1;
+    inverse[5]  =  m1.m[0]  * b5 - m1.m[2]  * b2 + m1.m[3]  * b1;
+    inverse[6]  = -m1.m[12] * a5 + m1.m[14] * a2 - m1.m[15] * a1;
+    inverse[7]  =  m1.m[8]  * a5 - m1.m[10] * a2 + m1.m[11] * a1;
+    inverse[8]  =  m1.m[4]  * b4 - m1.m[5]  * b2 + m1.m[7]  * b0;
+    inverse[9]  = -m1.m[0]  * b4 + m1.m[1]  * b2 - m1.m[3]  * b0;
+    inverse[10] =  m1.m[12] * a4 - m1.m[13] * a2 + m1.m[15] * a0;
+    inverse[11] = -m1.m[8]  * a4 + m1.m[9]  * a2 - m1.m[11] * a0;
+    inverse[12] = -m1.m[4]  * b3 + m1.m[5]  * b1 - m1.m[6]  * b0;
+    inverse[13] =  m1.m[0]  * b3 - m1.m[1]  * b1 + m1.m[2]  * b0;
+    inverse[14] = -m1.m[12] * a3 + m1.m[13] * a1 - m1.m[14] * a0;
+    inverse[15] =  m1.m[8]  * a3 - m1.m[9]  * a1 + m1.m[10] * a0;
+    for(int ii = 0; ii < 16; ii++) {
+        dst->m[ii] = inverse[ii] * (1.0f / det);
+    }
+}
+
+/**
+ * Transforms the array of Vec4 values with the scalar code.
+ *
+ * @param mat       The transform matrix.
+ * @param input     The array of vectors to transform.
+ * @param output    The array to store the transformed vectors.
+ * @param size      The number of vectors in the two arrays.
+ */
+static void scalarTransform(const Mat4& mat, const float* input, float* output, size_t size) {
+    for(size_t ii = 0; ii < size; ii++) {
+        const float* v = input+4*ii;
+        float x = v[0] * mat.m[0] + v[1] * mat.m[4] + v[2] * mat.m[8]  + v[3] * mat.m[12];
+        float y = v[0] * mat.m[1] + v[1] * mat.m[5] + v[2] * mat.m[9]  + v[3] * mat.m[13];
+        float z = v[0] * mat.m[2] + v[1] * mat.m[6] + v[2] * mat.m[10] + v[3] * mat.m[14];
+        float w = v[0] * mat.m[3] + v[1] * mat.m[7] + v[2] * mat.m[11] + v[3] * mat.m[15];
+        output[4*ii] = x; output[4*ii+1] = y; output[4*ii+2] = z; output[4*ii+3] = w;
+    }
+}
+
+/**
+ * Multiplies m1 by m2 with the scalar code, storing the result in dst.
+ *
+ * @param m1    The first transform to multiply.
+ * @param m2    The second transform to multiply.
+ * @param dst   A transform to store the result in.
+ */
+static void scalarMultiply(const Affine2& m1, const Affine2& m2, Affine2* dst) {
+    float a  = m2.m[0] * m1.m[0] + m2.m[2] * m1.m[1];
+    float b  = m2.m[0] * m1.m[2] + m2.m[2] * m1.m[3];
+    float c  = m2.m[1] * m1.m[0] + m2.m[3] * m1.m[1];
+    float d  = m2.m[1] * m1.m[2] + m2.m[3] * m1.m[3];
+    float tx = m2.m[0] * m1.m[4] + m2.m[2] * m1.m[5] + m2.m[4];
+    float ty = m2.m[1] * m1.m[4] + m2.m[3] * m1.m[5] + m2.m[5];
+    dst->m[0] = a; dst->m[1] = c; dst->m[2] = b; dst->m[3] = d;
+    dst->m[4] = tx; dst->m[5] = ty;
+}
+
+/**
+ * Transforms the array of points with the scalar code.
+ *
+ * @param aff       The affine transform.
+ * @param input     The array of points to transform.
+ * @param output    The array to store the transformed points.
+ * @param size      The number of points in the two arrays.
+ */
+static void scalarTransform(const Affine2& aff, const float* input, float* output, size_t size) {
+    for(size_t ii = 0; ii < size; ii++) {
+        float x = aff.m[0]*input[2*ii]+aff.m[2]*input[2*ii+1]+aff.m[4];
+        float y = aff.m[1]*input[2*ii]+aff.m[3]*input[2*ii+1]+aff.m[5];
+        output[2*ii] = x; output[2*ii+1] = y;
+    }
+}
+
+/**
+ * Tints the packed colors with the float rounding of the sprite batch.
+ *
+ * @param input     The array of packed colors
+ * @param tint      The color to multiply by
+ * @param output    The array to store the results
+ * @param size      The number of colors in the two arrays
+ */
+static void scalarTint(const Uint32* input, Color4 tint, Uint32* output, size_t size) {
+    for(size_t ii = 0; ii < size; ii++) {
+        Uint32 c = marshall(input[ii]);
+        Uint32 r = std::round(tint.r*((c >> 24)/255.0f));
+        Uint32 g = std::round(tint.g*(((c >> 16) & 0xff)/255.0f));
+        Uint32 b = std::round(tint.b*(((c >> 8) & 0xff)/255.0f));
+        Uint32 a = std::round(tint.a*((c & 0xff)/255.0f));
+        output[ii] = marshall(r << 24 | g << 16 | b << 8 | a);
+    }
+}
+
+#pragma mark Checks
+/**
+ * Returns true if the two float arrays agree to within tolerance
+ *
+ * @param a     The first array
+ * @param b     The second array
+ * @param size  The number of floats in each array
+ *
+ * @return true if the two float arrays agree to within tolerance
+ */
+static bool close(const float* a, const float* b, size_t size) {
+    for(size_t ii = 0; ii < size; ii++) {
+        float scale = std::max(1.0f, std::max(std::fabs(a[ii]), std::fabs(b[ii])));
+        if (std::fabs(a[ii]-b[ii]) > TOLERANCE*scale) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns a random transform made of rotations, scales and translations.
+ *
+ * @param rand  The random generator
+ *
+ * @return a random transform made of rotations, scales and translations.
+ */
+static Mat4 randomMatrix(std::mt19937& rand) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    Mat4 result = Mat4::createRotation(Vec3(unit(rand),unit(rand),unit(rand)+2),unit(rand)*M_PI);
+    result.scale(1.5f+unit(rand),1.5f+unit(rand),1.5f+unit(rand));
+    result.translate(100*unit(rand),100*unit(rand),100*unit(rand));
+    return result;
+}
+
+/**
+ * Returns an array of random floats in the range [-100,100]
+ *
+ * @param rand  The random generator
+ * @param size  The number of floats
+ *
+ * @return an array of random floats in the range [-100,100]
+ */
+static std::vector<float> randomFloats(std::mt19937& rand, size_t size) {
+    std::uniform_real_distribution<float> range(-100.0f, 100.0f);
+    std::vector<float> result(size);
+    for(auto it = result.begin(); it != result.end(); ++it) {
+        *it = range(rand);
+    }
+    return result;
+}
+
+/**
+ * Checks Vec4 addition against the scalar sums.
+ */
+static void testVec4() {
+    std::mt19937 rand(1);
+    std::vector<float> data = randomFloats(rand, 8*MATRIX_COUNT);
+    bool valid = true;
+    for(size_t ii = 0; valid && ii < MATRIX_COUNT; ii++) {
+        const float* p = data.data()+8*ii;
+        Vec4 v(p[0],p[1],p[2],p[3]);
+        v.add(Vec4(p[4],p[5],p[6],p[7]));
+        valid = v.x == p[0]+p[4] && v.y == p[1]+p[5] && v.z == p[2]+p[6] && v.w == p[3]+p[7];
+    }
+    CU_CHECK(valid);
+}
+
+/**
+ * Checks Mat4 multiplication, inversion and array transforms.
+ */
+static void testMat4() {
+    std::mt19937 rand(2);
+    bool multiply = true;
+    bool invert = true;
+    bool alias  = true;
+    for(int ii = 0; ii < MATRIX_COUNT; ii++) {
+        Mat4 m1 = randomMatrix(rand);
+        Mat4 m2 = randomMatrix(rand);
+        Mat4 actual, expected;
+        Mat4::multiply(m1, m2, &actual);
+        scalarMultiply(m1, m2, &expected);
+        multiply = multiply && close(actual.m, expected.m, 16);
+
+        Mat4::invert(m1, &actual);
+        scalarInvert(m1, &expected);
+        invert = invert && close(actual.m, expected.m, 16);
+
+        // Input and output may be the same matrix
+        Mat4 copy = m1;
+        Mat4::multiply(copy, m2, &copy);
+        Mat4::multiply(m1, m2, &actual);
+        alias = alias && close(copy.m, actual.m, 16);
+        copy = m1;
+        Mat4::invert(copy, &copy);
+        Mat4::invert(m1, &actual);
+        alias = alias && close(copy.m, actual.m, 16);
+    }
+    CU_CHECK(multiply);
+    CU_CHECK(invert);
+    CU_CHECK(alias);
+
+    // Singular matrices invert to zero
+    Mat4 singular = Mat4::createScale(1.0f, 0.0f, 1.0f);
+    Mat4 result = Mat4::IDENTITY;
+    Mat4::invert(singular, &result);
+    CU_CHECK(result == Mat4::ZERO);
+
+    // The array transform handles arrays of any length, in place
+    Mat4 mat = randomMatrix(rand);
+    std::vector<float> input = randomFloats(rand, 4*ARRAY_SIZE);
+    std::vector<float> actual(input.size());
+    std::vector<float> expected(input.size());
+    Mat4::transform(mat, input.data(), actual.data(), ARRAY_SIZE);
+    scalarTransform(mat, input.data(), expected.data(), ARRAY_SIZE);
+    CU_CHECK(close(actual.data(), expected.data(), expected.size()));
+    Mat4::transform(mat, input.data(), input.data(), ARRAY_SIZE);
+    CU_CHECK(close(input.data(), expected.data(), expected.size()));
+}
+
+/**
+ * Checks Affine2 multiplication and array transforms.
+ */
+static void testAffine2() {
+    std::mt19937 rand(3);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    bool multiply = true;
+    for(int ii = 0; ii < MATRIX_COUNT; ii++) {
+        Affine2 m1 = Affine2::createRotation(unit(rand)*M_PI);
+        m1.scale(Vec2(1.5f+unit(rand),1.5f+unit(rand)));
+        m1.translate(Vec2(100*unit(rand),100*unit(rand)));
+        Affine2 m2(unit(rand),unit(rand),unit(rand),unit(rand),unit(rand),unit(rand));
+        Affine2 actual, expected;
+        Affine2::multiply(m1, m2, &actual);
+        scalarMultiply(m1, m2, &expected);
+        multiply = multiply && close(actual.m, expected.m, 6);
+        Affine2::multiply(m1, m2, &m1);
+        multiply = multiply && close(m1.m, expected.m, 6);
+    }
+    CU_CHECK(multiply);
+
+    Affine2 aff(unit(rand),unit(rand),unit(rand),unit(rand),unit(rand),unit(rand));
+    std::vector<float> input = randomFloats(rand, 2*ARRAY_SIZE);
+    std::vector<float> actual(input.size());
+    std::vector<float> expected(input.size());
+    Affine2::transform(aff, input.data(), actual.data(), ARRAY_SIZE);
+    scalarTransform(aff, input.data(), expected.data(), ARRAY_SIZE);
+    CU_CHECK(close(actual.data(), expected.data(), expected.size()));
+    Affine2::transform(aff, input.data(), input.data(), ARRAY_SIZE);
+    CU_CHECK(close(input.data(), expected.data(), expected.size()));
+}
+
+/**
+ * Checks the packed color tint for every pair of bytes.
+ *
+ * The result must be exactly the float rounding of the sprite batch.
+ */
+static void testColor4() {
+    // Every byte value, in every channel, with an odd length tail
+    std::vector<Uint32> input(256+3);
+    for(Uint32 ii = 0; ii < input.size(); ii++) {
+        Uint8 v = ii & 0xff;
+        input[ii] = Color4(v, (Uint8)(255-v), (Uint8)(v*7), (Uint8)(v*13)).getPacked();
+    }
+    std::vector<Uint32> actual(input.size());
+    std::vector<Uint32> expected(input.size());
+    bool valid = true;
+    for(Uint32 tt = 0; valid && tt < 256; tt++) {
+        Color4 tint((Uint8)tt, (Uint8)(tt*3), (Uint8)(255-tt), (Uint8)(tt*5));
+        Color4::multiply(input.data(), tint, actual.data(), input.size());
+        scalarTint(input.data(), tint, expected.data(), input.size());
+        valid = actual == expected;
+    }
+    CU_CHECK(valid);
+
+    // Tinting in place
+    Color4 tint(200, 100, 50, 25);
+    scalarTint(input.data(), tint, expected.data(), input.size());
+    Color4::multiply(input.data(), tint, input.data(), input.size());
+    CU_CHECK(input == expected);
+
+    // White is the identity
+    Color4::multiply(expected.data(), Color4::WHITE, actual.data(), expected.size());
+    CU_CHECK(actual == expected);
+}
+
+#pragma mark Timings
+/**
+ * Reports the time of each operation for the library and the scalar code.
+ */
+static void timeMath() {
+#if defined CU_MATH_VECTOR_SSE
+    const char* backend = "SSE";
+#elif defined CU_MATH_VECTOR_NEON64
+    const char* backend = "NEON";
+#else
+    const char* backend = "scalar";
+#endif
+    std::mt19937 rand(4);
+    std::vector<Mat4> mats;
+    for(int ii = 0; ii < MATRIX_COUNT; ii++) {
+        mats.push_back(randomMatrix(rand));
+    }
+    Mat4 result;
+    double times[2];
+    times[0] = cu_test_time([&] {
+        for(size_t ii = 1; ii < mats.size(); ii++) {
+            Mat4::multiply(mats[ii-1], mats[ii], &result);
+            Mat4::invert(result, &result);
+        }
+    });
+    times[1] = cu_test_time([&] {
+        for(size_t ii = 1; ii < mats.size(); ii++) {
+            scalarMultiply(mats[ii-1], mats[ii], &result);
+            scalarInvert(result, &result);
+        }
+    });
+    std::printf("%d Mat4 multiply+invert: %.3f ms %s, %.3f ms scalar\n",
+                MATRIX_COUNT, times[0], backend, times[1]);
+
+    std::vector<float> input = randomFloats(rand, 4*ARRAY_SIZE);
+    std::vector<float> output(input.size());
+    times[0] = cu_test_time([&] {
+        Mat4::transform(mats[0], input.data(), output.data(), ARRAY_SIZE);
+    });
+    times[1] = cu_test_time([&] {
+        scalarTransform(mats[0], input.data(), output.data(), ARRAY_SIZE);
+    });
+    std::printf("%d Mat4 Vec4 transforms: %.3f ms %s, %.3f ms scalar\n",
+                ARRAY_SIZE, times[0], backend, times[1]);
+
+    Affine2 aff = Affine2::createRotation(0.5f);
+    aff.translate(Vec2(10,20));
+    times[0] = cu_test_time([&] {
+        Affine2::transform(aff, input.data(), output.data(), 2*ARRAY_SIZE);
+    });
+    times[1] = cu_test_time([&] {
+        scalarTransform(aff, input.data(), output.data(), 2*ARRAY_SIZE);
+    });
+    std::printf("%d Affine2 point transforms: %.3f ms %s, %.3f ms scalar\n",
+                2*ARRAY_SIZE, times[0], backend, times[1]);
+
+    std::vector<Uint32> colors(ARRAY_SIZE);
+    std::vector<Uint32> tinted(ARRAY_SIZE);
+    for(size_t ii = 0; ii < colors.size(); ii++) {
+        colors[ii] = (Uint32)rand();
+    }
+    Color4 tint(200, 100, 50, 25);
+    times[0] = cu_test_time([&] {
+        Color4::multiply(colors.data(), tint, tinted.data(), colors.size());
+    });
+    times[1] = cu_test_time([&] {
+        scalarTint(colors.data(), tint, tinted.data(), colors.size());
+    });
+    std::printf("%d Color4 tints: %.3f ms %s, %.3f ms scalar\n",
+                ARRAY_SIZE, times[0], backend, times[1]);
+}
+
+/**
+ * Runs the math checks and timings.
+ */
+int main(int argc, char** argv) {
+    testVec4();
+    testMat4();
+    testAffine2();
+    testColor4();
+    timeMath();
+    return cu_test_result("MathTest");
+}
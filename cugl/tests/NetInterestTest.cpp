@@ -0,0 +1,220 @@
+//
+//  NetInterestTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the area-of-interest manager for networked physics.
+//  It compares the grid queries against a brute force scan, checks that
+//  anchored areas follow their obstacle, and checks that the delta encoding
+//  history of a peer is pruned when obstacles leave its area of interest or
+//  the peer disconnects. It then reports the time to rebuild the grid and
+//  the number of obstacles each peer receives relative to the world size.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/physics2/distrib/CUNetInterest.h>
+#include <cugl/physics2/distrib/CUPhysSyncEvent.h>
+#include <cugl/physics2/CUBoxObstacle.h>
+#include <CUTestHarness.h>
+#include <algorithm>
+#include <random>
+
+using namespace cugl;
+using namespace cugl::physics2;
+using namespace cugl::physics2::distrib;
+
+/** The number of obstacles in the timing world */
+#define WORLD_SIZE  20000
+/** The width and height of the timing world */
+#define WORLD_SPAN  2000.0f
+/** The number of peers in the timing world */
+#define PEER_COUNT  8
+
+/**
+ * Checks the grid queries against a brute force scan.
+ */
+static void testQuery() {
+    std::mt19937 rand(7);
+    std::uniform_real_distribution<float> coord(-500.0f, 500.0f);
+    std::vector<Vec2> positions;
+    auto interest = NetInterest::alloc(25.0f);
+    for (Uint64 id = 0; id < 5000; id++) {
+        positions.push_back(Vec2(coord(rand), coord(rand)));
+        interest->insert(id, positions.back());
+    }
+    interest->build();
+    CU_CHECK(interest->size() == positions.size());
+
+    std::vector<Uint64> result;
+    std::vector<Uint64> expect;
+    for (int ii = 0; ii < 100; ii++) {
+        Rect region(coord(rand), coord(rand), coord(rand)+500.0f, (ii % 10)*50.0f);
+        result.clear();
+        expect.clear();
+        interest->query(region, result);
+        for (Uint64 id = 0; id < positions.size(); id++) {
+            if (region.contains(positions[id])) {
+                expect.push_back(id);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        CU_CHECK(result == expect);
+    }
+}
+
+/**
+ * Checks that anchored areas of interest follow their obstacle.
+ */
+static void testAnchors() {
+    auto interest = NetInterest::alloc(10.0f);
+    interest->setInterest("a", 1, Size(20,20));
+    interest->setInterest("b", 1, Size(4,4));
+    interest->setInterest("c", Rect(100,100,10,10));
+
+    interest->insert(1, Vec2(0,0));
+    interest->insert(2, Vec2(5,5));
+    interest->insert(3, Vec2(105,105));
+    interest->build();
+    CU_CHECK(interest->getInterest("a").origin == Vec2(-10,-10));
+    CU_CHECK(interest->getInterest("b").origin == Vec2(-2,-2));
+    CU_CHECK(interest->isRelevant("a", 2));
+    CU_CHECK(!interest->isRelevant("b", 2));
+    CU_CHECK(interest->getRelevant("c") == std::vector<Uint64>({3}));
+
+    // Removing one follower must not forget the anchor of the other
+    interest->removeInterest("b");
+    interest->clear();
+    interest->insert(1, Vec2(100,100));
+    interest->insert(3, Vec2(105,105));
+    interest->build();
+    CU_CHECK(interest->getInterest("a").origin == Vec2(90,90));
+    CU_CHECK(interest->isRelevant("a", 3));
+    CU_CHECK(!interest->hasInterest("b"));
+    CU_CHECK(interest->getPeers().size() == 2);
+
+    // A missing anchor does not move the area
+    interest->clear();
+    interest->insert(3, Vec2(0,0));
+    interest->build();
+    CU_CHECK(interest->getInterest("a").origin == Vec2(90,90));
+    CU_CHECK(interest->getRelevant("a").empty());
+
+    // Switching to a fixed area detaches the anchor
+    interest->setInterest("a", Rect(-1,-1,2,2));
+    interest->clear();
+    interest->insert(1, Vec2(0,0));
+    interest->build();
+    CU_CHECK(interest->getInterest("a").origin == Vec2(-1,-1));
+    CU_CHECK(interest->isRelevant("a", 1));
+}
+
+/**
+ * Returns the size of a baseline encoded event for the given obstacles.
+ *
+ * @param baseline  The delta encoding history
+ * @param obstacles The obstacles to send
+ *
+ * @return the size of a baseline encoded event for the given obstacles.
+ */
+static size_t encode(const std::shared_ptr<PhysSyncEvent::Baseline>& baseline,
+                     const std::vector<std::shared_ptr<Obstacle>>& obstacles) {
+    auto event = PhysSyncEvent::alloc();
+    event->setBaseline(baseline);
+    event->setDestination("a");
+    for (size_t ii = 0; ii < obstacles.size(); ii++) {
+        event->addObstacle(ii, obstacles[ii]);
+    }
+    return event->serialize().size();
+}
+
+/**
+ * Checks that the outbound history is pruned with the area of interest.
+ */
+static void testBaseline() {
+    std::vector<std::shared_ptr<Obstacle>> obstacles;
+    for (int ii = 0; ii < 16; ii++) {
+        obstacles.push_back(BoxObstacle::alloc(Vec2(ii*3.7f, ii*-1.3f), Size(1,1)));
+    }
+    auto baseline = PhysSyncEvent::Baseline::alloc();
+    baseline->setKeyframeRate(0);
+    size_t full  = encode(baseline, obstacles);
+    size_t delta = encode(baseline, obstacles);
+    CU_CHECK(delta < full);
+
+    // Obstacles outside the area are resent in full
+    baseline->retain("a", std::vector<Uint64>({0,1,2,3}));
+    size_t partial = encode(baseline, obstacles);
+    CU_CHECK(partial > delta);
+    CU_CHECK(encode(baseline, obstacles) == delta);
+
+    // A reconnected peer gets a keyframe
+    baseline->removePeer("a");
+    CU_CHECK(encode(baseline, obstacles) == full);
+}
+
+/**
+ * Reports the time to rebuild the grid and the relevancy sets.
+ */
+static void timeBuild() {
+    std::mt19937 rand(11);
+    std::uniform_real_distribution<float> coord(0, WORLD_SPAN);
+    std::vector<Vec2> positions;
+    for (int ii = 0; ii < WORLD_SIZE; ii++) {
+        positions.push_back(Vec2(coord(rand), coord(rand)));
+    }
+
+    auto interest = NetInterest::alloc(100.0f);
+    for (int ii = 0; ii < PEER_COUNT; ii++) {
+        interest->setInterest(std::to_string(ii), (Uint64)ii, Size(200,200));
+    }
+    double time = cu_test_time([&] {
+        for (int frame = 0; frame < 100; frame++) {
+            interest->clear();
+            for (Uint64 id = 0; id < positions.size(); id++) {
+                interest->insert(id, positions[id]);
+            }
+            interest->build();
+        }
+    });
+
+    size_t relevant = 0;
+    for (int ii = 0; ii < PEER_COUNT; ii++) {
+        relevant += interest->getRelevant(std::to_string(ii)).size();
+    }
+    CU_CHECK(relevant > 0);
+    std::printf("%d obstacles, %d peers: %.3f ms per rebuild\n",
+                WORLD_SIZE, PEER_COUNT, time/100);
+    std::printf("obstacles sent per peer: %.1f (broadcast would send %d)\n",
+                (double)relevant/PEER_COUNT, WORLD_SIZE);
+}
+
+/**
+ * Runs the area-of-interest checks and timings.
+ */
+int main(int argc, char** argv) {
+    testQuery();
+    testAnchors();
+    testBaseline();
+    timeBuild();
+    return cu_test_result("NetInterestTest");
+}
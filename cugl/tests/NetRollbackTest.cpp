@@ -0,0 +1,358 @@
+//
+//  NetRollbackTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks rollback corrections for networked physics with two
+//  in-process peers. The authority applies an input that the other peer
+//  does not know about. The other peer then receives the state of the
+//  authority at an earlier tick, and the physics controller rewinds and
+//  replays its world to the current tick. With separate boxes, the two
+//  worlds must then agree exactly. With stacks of boxes knocked into each
+//  other, a peer that replays its own history must reproduce it exactly,
+//  and a corrected peer must agree with the authority up to a documented
+//  tolerance. It then reports the time to roll back several ticks.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/physics2/distrib/CUNetPhysicsController.h>
+#include <cugl/physics2/distrib/CUNetRollback.h>
+#include <cugl/physics2/distrib/CUNetWorld.h>
+#include <cugl/physics2/CUBoxObstacle.h>
+#include <CUTestHarness.h>
+#include <algorithm>
+
+using namespace cugl;
+using namespace cugl::physics2;
+using namespace cugl::physics2::distrib;
+
+/** The number of obstacles in each world */
+#define BODY_COUNT      2000
+/** The number of snapshots kept by each peer */
+#define HISTORY_SIZE    16
+/** The tick of the input the second peer does not know about */
+#define INPUT_TICK      5
+/** The tick of the correction sent by the authority */
+#define CORRECT_TICK    6
+/** The current tick when the correction arrives */
+#define CURRENT_TICK    20
+/** The number of ticks replayed in the timing test */
+#define REPLAY_TICKS    8
+/** The physics time step */
+#define STEP_SIZE       (1.0f/60.0f)
+/** The number of stacks in the stacked world */
+#define STACK_COUNT     20
+/** The number of boxes in each stack */
+#define STACK_HEIGHT    8
+/** The number of ticks for the stacks to settle before the first save */
+#define SETTLE_TICKS    60
+/**
+ * The largest difference in position or angle after a stacked correction
+ *
+ * A correction only carries the state of the bodies. The warm-starting
+ * impulses of the corrected tick are those of the receiving peer, and its
+ * contacts were created in a different order, so the solver converges to
+ * a slightly different answer. The measured difference is about 5e-4.
+ */
+#define STACK_TOLERANCE 2e-3
+
+#pragma mark Peers
+/** A single peer of the simulation */
+class Peer {
+public:
+    /** The networked physics world */
+    std::shared_ptr<NetWorld> world;
+    /** The shared obstacles, in creation order */
+    std::vector<std::shared_ptr<Obstacle>> bodies;
+    /** The snapshot history */
+    std::shared_ptr<NetRollback> rollback;
+    /** Whether this peer knows about the input at INPUT_TICK */
+    bool informed;
+
+    /** Whether this peer is a world of stacked boxes */
+    bool stacked;
+
+    /**
+     * Creates a peer with a world of separate falling boxes.
+     *
+     * The boxes are too far apart to collide, so there are no contacts
+     * to warm-start, and a correction matches the authority exactly.
+     *
+     * @param informed  Whether this peer knows about the input
+     */
+    Peer(bool informed) : informed(informed), stacked(false) {
+        world = NetWorld::alloc(Rect(0,0,1000,1000), Vec2(0,-9.8f));
+        for (int ii = 0; ii < BODY_COUNT; ii++) {
+            Vec2 pos((ii % 50)*20.0f+10.0f, (ii / 50)*20.0f+500.0f);
+            auto box = BoxObstacle::alloc(pos, Size(1,1));
+            box->setAngularVelocity((ii % 7)*0.1f);
+            world->initObstacle(box);
+            bodies.push_back(box);
+        }
+        rollback = NetRollback::alloc(world, HISTORY_SIZE);
+    }
+
+    /**
+     * Creates a peer with a world of stacked boxes on the ground.
+     *
+     * The stacks are settled before the first tick, so every box rests on
+     * warm-started contacts. The input knocks the top of every other stack
+     * into its neighbor, creating and destroying contacts.
+     *
+     * @param informed  Whether this peer knows about the input
+     * @param height    The number of boxes in each stack
+     */
+    Peer(bool informed, int height) : informed(informed), stacked(true) {
+        world = NetWorld::alloc(Rect(0,0,200,200), Vec2(0,-9.8f));
+        auto ground = BoxObstacle::alloc(Vec2(100,0.5f), Size(200,1));
+        ground->setBodyType(b2_staticBody);
+        world->initObstacle(ground);
+        for (int ii = 0; ii < STACK_COUNT; ii++) {
+            for (int jj = 0; jj < height; jj++) {
+                auto box = BoxObstacle::alloc(Vec2(ii*3.0f+10.0f, jj+1.5f), Size(1,1));
+                box->setDensity(1);
+                box->setFriction(0.6f);
+                world->initObstacle(box);
+                bodies.push_back(box);
+            }
+        }
+        for (int ii = 0; ii < SETTLE_TICKS; ii++) {
+            world->update(STEP_SIZE);
+        }
+        rollback = NetRollback::alloc(world, HISTORY_SIZE);
+    }
+
+    /**
+     * Simulates a single tick, applying the inputs known to this peer.
+     *
+     * @param tick  The simulation tick
+     */
+    void step(Uint64 tick) {
+        if (tick == INPUT_TICK && informed && stacked) {
+            size_t height = bodies.size()/STACK_COUNT;
+            for (size_t ii = 0; ii < STACK_COUNT; ii += 2) {
+                bodies[(ii+1)*height-1]->setLinearVelocity(Vec2(6,2));
+            }
+        } else if (tick == INPUT_TICK && informed) {
+            for (int ii = 0; ii < BODY_COUNT; ii += 10) {
+                bodies[ii]->setLinearVelocity(Vec2(3,12));
+            }
+        }
+        world->update(STEP_SIZE);
+    }
+
+    /**
+     * Simulates the given ticks, saving a snapshot before each one.
+     *
+     * @param first The first tick to simulate
+     * @param last  The tick after the last one to simulate
+     */
+    void run(Uint64 first, Uint64 last) {
+        for (Uint64 tick = first; tick < last; tick++) {
+            rollback->save(tick);
+            step(tick);
+        }
+    }
+};
+
+/**
+ * Returns the largest difference in position or angle between two peers
+ *
+ * @param a The first peer
+ * @param b The second peer
+ *
+ * @return the largest difference in position or angle between two peers
+ */
+static float divergence(const Peer& a, const Peer& b) {
+    float result = 0;
+    for (size_t ii = 0; ii < a.bodies.size(); ii++) {
+        float diff = a.bodies[ii]->getPosition().distance(b.bodies[ii]->getPosition());
+        result = std::max(result, diff);
+        diff = std::abs(a.bodies[ii]->getAngle()-b.bodies[ii]->getAngle());
+        result = std::max(result, diff);
+    }
+    return result;
+}
+
+/**
+ * Sends the snapshot of the authority at the given tick to a controller
+ *
+ * @param authority The authoritative peer
+ * @param control   The controller of the receiving peer
+ * @param tick      The tick of the correction
+ *
+ * @return true if every obstacle state was recorded
+ */
+static bool sendCorrection(Peer& authority, NetPhysicsController& control, Uint64 tick) {
+    const auto* states = authority.rollback->getSnapshot(tick);
+    if (states == nullptr) {
+        return false;
+    }
+    bool recorded = true;
+    for (auto it = states->begin(); it != states->end(); it++) {
+        PhysSyncEvent::Parameters param;
+        param.obsId = it->id;
+        param.x = it->x;
+        param.y = it->y;
+        param.angle = it->angle;
+        param.vx = it->vx;
+        param.vy = it->vy;
+        param.vAngular = it->omega;
+        recorded = control.correctSnapshot(tick, param) && recorded;
+    }
+    return recorded;
+}
+
+#pragma mark Tests
+/**
+ * Checks that a correction is replayed to the current tick.
+ */
+static void testCorrection() {
+    Peer authority(true);
+    Peer client(false);
+    auto control = NetPhysicsController::alloc(client.world, 2, false);
+    control->setRollback(client.rollback, [&](Uint64 tick) { client.step(tick); });
+
+    authority.run(0, CURRENT_TICK);
+    client.run(0, CURRENT_TICK);
+    authority.rollback->save(CURRENT_TICK);
+    client.rollback->save(CURRENT_TICK);
+    CU_CHECK(authority.rollback->getChecksum(INPUT_TICK) == client.rollback->getChecksum(INPUT_TICK));
+    CU_CHECK(authority.rollback->getChecksum(CURRENT_TICK) != client.rollback->getChecksum(CURRENT_TICK));
+
+    // The synchronization of the authority at the correction tick
+    const auto* states = authority.rollback->getSnapshot(CORRECT_TICK);
+    CU_CHECK(states != nullptr && states->size() == BODY_COUNT);
+    CU_CHECK(sendCorrection(authority, *control, CORRECT_TICK));
+
+    // Ticks that have left the history fall back to interpolation
+    PhysSyncEvent::Parameters stale;
+    stale.obsId = states->front().id;
+    CU_CHECK(!control->correctSnapshot(CURRENT_TICK-HISTORY_SIZE, stale));
+
+    CU_CHECK(control->applyRollback(CURRENT_TICK));
+    CU_CHECK(!control->applyRollback(CURRENT_TICK));
+    client.rollback->save(CURRENT_TICK);
+    CU_CHECK(authority.rollback->getChecksum(CURRENT_TICK) == client.rollback->getChecksum(CURRENT_TICK));
+    bool same = true;
+    for (size_t ii = 0; ii < BODY_COUNT; ii++) {
+        same = same && authority.bodies[ii]->getPosition() == client.bodies[ii]->getPosition();
+    }
+    CU_CHECK(same);
+}
+
+/**
+ * Checks that a stacked world replays its own history exactly.
+ *
+ * The replay crosses the input, so contacts are created and destroyed
+ * between the restored tick and the current one. The replay only matches
+ * because the contact impulses are restored with the bodies.
+ */
+static void testReplay() {
+    Peer peer(true, STACK_HEIGHT);
+    Peer twin(true, STACK_HEIGHT);
+    peer.run(0, CURRENT_TICK);
+    twin.run(0, CURRENT_TICK);
+    peer.rollback->save(CURRENT_TICK);
+    Uint64 checksum = peer.rollback->getChecksum(CURRENT_TICK);
+    CU_CHECK(divergence(peer, twin) == 0);
+
+    Uint64 starts[] = { CURRENT_TICK-1, CORRECT_TICK, INPUT_TICK };
+    for (Uint64 start : starts) {
+        CU_CHECK(peer.rollback->resimulate(start, CURRENT_TICK,
+                                           [&](Uint64 tick) { peer.step(tick); }));
+        peer.rollback->save(CURRENT_TICK);
+        CU_CHECK(peer.rollback->getChecksum(CURRENT_TICK) == checksum);
+        CU_CHECK(divergence(peer, twin) == 0);
+    }
+}
+
+/**
+ * Checks that a stacked correction agrees with the authority.
+ *
+ * The uninformed peer is far from the authority before the correction.
+ * Afterwards, it must agree up to {@link STACK_TOLERANCE}.
+ */
+static void testStackedCorrection() {
+    Peer authority(true, STACK_HEIGHT);
+    Peer client(false, STACK_HEIGHT);
+    auto control = NetPhysicsController::alloc(client.world, 2, false);
+    control->setRollback(client.rollback, [&](Uint64 tick) { client.step(tick); });
+
+    authority.run(0, CURRENT_TICK);
+    client.run(0, CURRENT_TICK);
+    CU_CHECK(divergence(authority, client) > 1);
+
+    CU_CHECK(sendCorrection(authority, *control, CORRECT_TICK));
+    CU_CHECK(control->applyRollback(CURRENT_TICK));
+    float diff = divergence(authority, client);
+    CU_CHECK(diff <= STACK_TOLERANCE);
+    std::printf("Stacked correction differs by %.2g (tolerance %.2g)\n", diff, STACK_TOLERANCE);
+}
+
+#pragma mark Timing
+/**
+ * Reports the time to save, restore, and replay a large world.
+ */
+static void timeRollback() {
+    Peer peer(true);
+    peer.run(0, CURRENT_TICK);
+    double save = cu_test_time([&] {
+        for (int ii = 0; ii < 100; ii++) {
+            peer.rollback->save(CURRENT_TICK);
+        }
+    });
+    double restore = cu_test_time([&] {
+        for (int ii = 0; ii < 100; ii++) {
+            peer.rollback->restore(CURRENT_TICK);
+        }
+    });
+    double replay = cu_test_time([&] {
+        peer.rollback->resimulate(CURRENT_TICK-REPLAY_TICKS, CURRENT_TICK,
+                                  [&](Uint64 tick) { peer.step(tick); });
+    });
+    std::printf("%d obstacles: %.3f ms per save, %.3f ms per restore\n",
+                BODY_COUNT, save/100, restore/100);
+    std::printf("%d obstacles: %.3f ms to roll back and replay %d ticks\n",
+                BODY_COUNT, replay, REPLAY_TICKS);
+
+    Peer stack(true, STACK_HEIGHT);
+    stack.run(0, CURRENT_TICK);
+    replay = cu_test_time([&] {
+        stack.rollback->resimulate(CURRENT_TICK-REPLAY_TICKS, CURRENT_TICK,
+                                   [&](Uint64 tick) { stack.step(tick); });
+    });
+    std::printf("%d stacked obstacles: %.3f ms to roll back and replay %d ticks\n",
+                (int)stack.bodies.size(), replay, REPLAY_TICKS);
+}
+
+/**
+ * Runs the rollback checks and timings.
+ */
+int main(int argc, char** argv) {
+    testCorrection();
+    testReplay();
+    testStackedCorrection();
+    timeRollback();
+    return cu_test_result("NetRollbackTest");
+}
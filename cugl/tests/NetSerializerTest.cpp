@@ -0,0 +1,527 @@
+//
+//  NetSerializerTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the netcode serializer and deserializer. It checks
+//  that the serializer produces exactly the bytes of a byte-at-a-time
+//  reference encoder (the original implementation), that every kind of
+//  value round-trips through both the variant and the typed readers, and
+//  that the span and view readers agree with the allocating ones. It checks
+//  that truncated messages are detected. It then reports the throughput of
+//  messages the size of a physics synchronization, both with vectors and
+//  with spans.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/17/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/netcode/CUNetcodeSerializer.h>
+#include <cugl/core/util/CUEndian.h>
+#include <CUTestHarness.h>
+#include <random>
+#include <stdexcept>
+
+using namespace cugl;
+using namespace cugl::netcode;
+
+/** The number of random values to compare against the reference */
+#define VALUE_COUNT     2000
+/** The number of obstacles in a synchronization message */
+#define SYNC_OBJECTS    64
+/** The number of floats of state for each obstacle */
+#define SYNC_STATE      6
+/** The number of messages for each timing */
+#define MESSAGE_COUNT   20000
+/** The number of bytes in a string or vector header */
+#define HEADER_BYTES    (2+sizeof(Uint64))
+
+#pragma mark Reference Encoder
+/**
+ * Appends the given value one byte at a time, in network order
+ *
+ * This is the encoding of the original serializer.
+ *
+ * @param data  The byte vector to extend
+ * @param type  The value type
+ * @param value The value to write
+ */
+template <typename T>
+static void refValue(std::vector<std::byte>& data, NetcodeType type, T value) {
+    auto bits = marshall(value);
+    const std::byte* bytes = reinterpret_cast<const std::byte*>(&bits);
+    data.push_back(static_cast<std::byte>(type));
+    for(size_t ii = 0; ii < sizeof(bits); ii++) {
+        data.push_back(bytes[ii]);
+    }
+}
+
+/**
+ * Appends the given vector one value at a time
+ *
+ * This is the encoding of the original serializer.
+ *
+ * @param data      The byte vector to extend
+ * @param type      The element type
+ * @param values    The values to write
+ */
+template <typename T>
+static void refVector(std::vector<std::byte>& data, NetcodeType type, const std::vector<T>& values) {
+    data.push_back(static_cast<std::byte>(ArrayType+type));
+    refValue(data, UInt64Type, (Uint64)values.size());
+    for(auto it = values.begin(); it != values.end(); ++it) {
+        refValue(data, type, *it);
+    }
+}
+
+/**
+ * Appends the given string one byte at a time
+ *
+ * This is the encoding of the original serializer.
+ *
+ * @param data  The byte vector to extend
+ * @param value The string to write
+ */
+static void refString(std::vector<std::byte>& data, const std::string& value) {
+    data.push_back(static_cast<std::byte>(StringType));
+    refValue(data, UInt64Type, (Uint64)value.size());
+    for(auto it = value.begin(); it != value.end(); ++it) {
+        data.push_back(static_cast<std::byte>(*it));
+    }
+}
+
+#pragma mark Values
+/**
+ * Returns a random vector of the given type
+ *
+ * @param rand  The random generator
+ *
+ * @return a random vector of the given type
+ */
+template <typename T>
+static std::vector<T> randomVector(std::mt19937_64& rand) {
+    std::vector<T> result(rand()%20);
+    for(auto it = result.begin(); it != result.end(); ++it) {
+        if constexpr (std::is_floating_point_v<T>) {
+            *it = (T)((Sint64)rand()%2000000)/(T)1000;
+        } else {
+            *it = (T)rand();
+        }
+    }
+    return result;
+}
+
+/**
+ * Returns a random string, possibly with embedded nulls
+ *
+ * @param rand  The random generator
+ *
+ * @return a random string, possibly with embedded nulls
+ */
+static std::string randomString(std::mt19937_64& rand) {
+    std::string result(rand()%40, ' ');
+    for(auto it = result.begin(); it != result.end(); ++it) {
+        *it = (char)(rand()%256);
+    }
+    return result;
+}
+
+/**
+ * Writes a random sequence to the serializer and the reference encoder
+ *
+ * The values are also appended to the list of expected messages.
+ *
+ * @param rand      The random generator
+ * @param writer    The serializer
+ * @param reference The reference encoding
+ * @param expected  The expected messages
+ */
+static void writeRandom(std::mt19937_64& rand, NetcodeSerializer& writer,
+                        std::vector<std::byte>& reference,
+                        std::vector<NetcodeDeserializer::Message>& expected) {
+    switch (rand()%14) {
+        case 0:
+        {
+            bool value = rand()%2;
+            writer.writeBool(value);
+            reference.push_back(static_cast<std::byte>(value ? BooleanTrue : BooleanFalse));
+            expected.push_back(value);
+        }
+            break;
+        case 1:
+        {
+            float value = (float)((Sint64)rand()%100000)/7.0f;
+            writer.writeFloat(value);
+            refValue(reference, FloatType, value);
+            expected.push_back(value);
+        }
+            break;
+        case 2:
+        {
+            double value = (double)((Sint64)rand())/3.0;
+            writer.writeDouble(value);
+            refValue(reference, DoubleType, value);
+            expected.push_back(value);
+        }
+            break;
+        case 3:
+        {
+            Uint32 value = (Uint32)rand();
+            writer.writeUint32(value);
+            refValue(reference, UInt32Type, value);
+            expected.push_back(value);
+        }
+            break;
+        case 4:
+        {
+            Sint32 value = (Sint32)rand();
+            writer.writeSint32(value);
+            refValue(reference, SInt32Type, value);
+            expected.push_back(value);
+        }
+            break;
+        case 5:
+        {
+            Uint64 value = rand();
+            writer.writeUint64(value);
+            refValue(reference, UInt64Type, value);
+            expected.push_back(value);
+        }
+            break;
+        case 6:
+        {
+            Sint64 value = (Sint64)rand();
+            writer.writeSint64(value);
+            refValue(reference, SInt64Type, value);
+            expected.push_back(value);
+        }
+            break;
+        case 7:
+        {
+            std::string value = randomString(rand);
+            writer.writeString(value);
+            refString(reference, value);
+            expected.push_back(value);
+        }
+            break;
+        case 8:
+        {
+            std::vector<float> value = randomVector<float>(rand);
+            writer.writeFloatVector(std::span<const float>(value));
+            refVector(reference, FloatType, value);
+            expected.push_back(value);
+        }
+            break;
+        case 9:
+        {
+            std::vector<double> value = randomVector<double>(rand);
+            writer.writeDoubleVector(value);
+            refVector(reference, DoubleType, value);
+            expected.push_back(value);
+        }
+            break;
+        case 10:
+        {
+            std::vector<Uint32> value = randomVector<Uint32>(rand);
+            writer.writeUint32Vector(std::span<const Uint32>(value));
+            refVector(reference, UInt32Type, value);
+            expected.push_back(value);
+        }
+            break;
+        case 11:
+        {
+            std::vector<Sint64> value = randomVector<Sint64>(rand);
+            writer.writeSint64Vector(value);
+            refVector(reference, SInt64Type, value);
+            expected.push_back(value);
+        }
+            break;
+        case 12:
+        {
+            std::vector<Uint64> value = randomVector<Uint64>(rand);
+            writer.writeUint64Vector(std::span<const Uint64>(value));
+            refVector(reference, UInt64Type, value);
+            expected.push_back(value);
+        }
+            break;
+        case 13:
+        {
+            std::vector<std::string> value(rand()%5);
+            for(auto it = value.begin(); it != value.end(); ++it) {
+                *it = randomString(rand);
+            }
+            writer.writeStringVector(value);
+            reference.push_back(static_cast<std::byte>(ArrayType+StringType));
+            refValue(reference, UInt64Type, (Uint64)value.size());
+            for(auto it = value.begin(); it != value.end(); ++it) {
+                refString(reference, *it);
+            }
+            expected.push_back(value);
+        }
+            break;
+    }
+}
+
+#pragma mark Checks
+/**
+ * Checks that random sequences match the reference and round-trip.
+ */
+static void testRoundTrip() {
+    std::mt19937_64 rand(31);
+    NetcodeSerializer writer;
+    std::vector<std::byte> reference;
+    std::vector<NetcodeDeserializer::Message> expected;
+    for(int ii = 0; ii < VALUE_COUNT; ii++) {
+        writeRandom(rand, writer, reference, expected);
+    }
+    std::vector<std::byte> message = writer.serialize();
+    CU_CHECK(message == reference);
+
+    // Copied, moved, in place and Base 64
+    NetcodeDeserializer reader;
+    for(int mode = 0; mode < 4; mode++) {
+        switch (mode) {
+            case 0:
+                reader.receive(message);
+                break;
+            case 1:
+                reader.receive(std::vector<std::byte>(message));
+                break;
+            case 2:
+                reader.receive(message.data(), message.size());
+                break;
+            case 3:
+                reader.receive64(writer.serialize64());
+                break;
+        }
+        bool same = true;
+        for(auto it = expected.begin(); it != expected.end(); ++it) {
+            same = same && reader.read() == *it;
+        }
+        CU_CHECK(same);
+        CU_CHECK(std::holds_alternative<std::monostate>(reader.read()));
+    }
+
+    // A reset serializer keeps its memory and starts over
+    size_t capacity = writer.serialize().capacity();
+    writer.reset();
+    CU_CHECK(writer.size() == 0);
+    CU_CHECK(writer.serialize().capacity() == capacity);
+    writer.writeUint32(7);
+    std::vector<std::byte> seven;
+    refValue(seven, UInt32Type, (Uint32)7);
+    CU_CHECK(writer.serialize() == seven);
+}
+
+/**
+ * Checks that the span and view readers agree with the allocating ones.
+ */
+static void testSpans() {
+    std::mt19937_64 rand(5);
+    std::vector<float>  floats  = randomVector<float>(rand);
+    std::vector<double> doubles = randomVector<double>(rand);
+    std::vector<Uint32> uints   = randomVector<Uint32>(rand);
+    std::vector<Sint32> sints   = randomVector<Sint32>(rand);
+    std::vector<Uint64> ulongs  = randomVector<Uint64>(rand);
+    std::vector<Sint64> slongs  = randomVector<Sint64>(rand);
+    floats.resize(12, 1.5f);
+    std::string text = std::string("embedded\0null", 13);
+
+    NetcodeSerializer writer;
+    writer.writeFloatVector(floats);
+    writer.writeDoubleVector(std::span<const double>(doubles));
+    writer.writeUint32Vector(uints);
+    writer.writeSint32Vector(std::span<const Sint32>(sints));
+    writer.writeUint64Vector(ulongs);
+    writer.writeSint64Vector(std::span<const Sint64>(slongs));
+    writer.writeString(std::string_view(text));
+    writer.writeFloatVector(floats);
+    writer.writeUint32(99);
+    std::vector<std::byte> message = writer.serialize();
+
+    NetcodeDeserializer reader;
+    reader.receive(message.data(), message.size());
+    std::vector<float>  f(floats.size());
+    std::vector<double> d(doubles.size());
+    std::vector<Uint32> u(uints.size());
+    std::vector<Sint32> s(sints.size());
+    std::vector<Uint64> ul(ulongs.size());
+    std::vector<Sint64> sl(slongs.size());
+    CU_CHECK(reader.readFloatVector(std::span<float>(f)) == floats.size() && f == floats);
+    CU_CHECK(reader.readDoubleVector(std::span<double>(d)) == doubles.size() && d == doubles);
+    CU_CHECK(reader.readUint32Vector(std::span<Uint32>(u)) == uints.size() && u == uints);
+    CU_CHECK(reader.readSint32Vector(std::span<Sint32>(s)) == sints.size() && s == sints);
+    CU_CHECK(reader.readUint64Vector(std::span<Uint64>(ul)) == ulongs.size() && ul == ulongs);
+    CU_CHECK(reader.readSint64Vector(std::span<Sint64>(sl)) == slongs.size() && sl == slongs);
+
+    // The view points into the original buffer
+    std::string_view view = reader.readStringView();
+    CU_CHECK(view == text);
+    CU_CHECK((const std::byte*)view.data() >= message.data() &&
+             (const std::byte*)view.data()+view.size() <= message.data()+message.size());
+
+    // A short buffer skips the remaining values
+    float part[4];
+    CU_CHECK(reader.readFloatVector(std::span<float>(part,4)) == floats.size());
+    CU_CHECK(std::equal(part, part+4, floats.begin()));
+    CU_CHECK(reader.nextType() == UInt32Type && reader.readUint32() == 99);
+    CU_CHECK(!reader.available());
+}
+
+/**
+ * Checks that truncated messages are detected.
+ */
+static void testTruncation() {
+    NetcodeSerializer writer;
+    writer.writeUint64(0x0123456789ABCDEFULL);
+    std::vector<std::byte> message = writer.serialize();
+
+    // A truncated scalar reads as 0
+    NetcodeDeserializer reader;
+    reader.receive(message.data(), message.size()-1);
+    CU_CHECK(reader.readUint64() == 0);
+
+    // A length larger than the rest of the message is an error
+    const std::string text = "a longer string value";
+    writer.reset();
+    writer.writeFloatVector(std::vector<float>(16, 2.0f));
+    writer.writeString(text);
+    message = writer.serialize();
+    size_t first = message.size()-HEADER_BYTES-text.size();
+    for(size_t cut : { first-1, message.size()-1 }) {
+        reader.receive(message.data(), cut);
+        bool thrown = false;
+        try {
+            reader.readFloatVector();
+            reader.readString();
+        } catch (std::domain_error&) {
+            thrown = true;
+        }
+        CU_CHECK(thrown);
+    }
+}
+
+#pragma mark Timings
+/**
+ * The state of the obstacles in a synchronization message
+ */
+struct SyncState {
+    /** The obstacle ids */
+    std::vector<Uint64> ids;
+    /** The obstacle states (position, velocity, angle and angular velocity) */
+    std::vector<float> states;
+};
+
+/**
+ * Reports the throughput of synchronization sized messages.
+ *
+ * Each message has the ids and states of {@link SYNC_OBJECTS} obstacles,
+ * together with a frame number and a tag. The reference path encodes one
+ * byte at a time, as the original serializer did. The vector path uses the
+ * allocating readers, while the span path reads in place into existing
+ * storage.
+ */
+static void timeThroughput() {
+    std::mt19937_64 rand(17);
+    SyncState input;
+    input.ids = randomVector<Uint64>(rand);
+    input.ids.resize(SYNC_OBJECTS);
+    input.states.resize(SYNC_OBJECTS*SYNC_STATE);
+    for(size_t ii = 0; ii < input.states.size(); ii++) {
+        input.states[ii] = (float)((Sint64)rand()%100000)/64.0f;
+    }
+    const std::string tag = "sync";
+
+    NetcodeSerializer writer;
+    NetcodeDeserializer reader;
+    SyncState output;
+    size_t bytes = 0;
+
+    double refTime = cu_test_time([&] {
+        for(int ii = 0; ii < MESSAGE_COUNT; ii++) {
+            std::vector<std::byte> message;
+            refValue(message, UInt32Type, (Uint32)ii);
+            refString(message, tag);
+            refVector(message, UInt64Type, input.ids);
+            refVector(message, FloatType, input.states);
+            reader.receive(message);
+            reader.readUint32();
+            reader.readString();
+            output.ids = reader.readUint64Vector();
+            output.states = reader.readFloatVector();
+        }
+    });
+    CU_CHECK(output.ids == input.ids && output.states == input.states);
+
+    double vecTime = cu_test_time([&] {
+        for(int ii = 0; ii < MESSAGE_COUNT; ii++) {
+            writer.reset();
+            writer.writeUint32((Uint32)ii);
+            writer.writeString(tag);
+            writer.writeUint64Vector(input.ids);
+            writer.writeFloatVector(input.states);
+            reader.receive(writer.serialize());
+            reader.readUint32();
+            reader.readString();
+            output.ids = reader.readUint64Vector();
+            output.states = reader.readFloatVector();
+        }
+    });
+    CU_CHECK(output.ids == input.ids && output.states == input.states);
+
+    output.ids.assign(SYNC_OBJECTS, 0);
+    output.states.assign(SYNC_OBJECTS*SYNC_STATE, 0.0f);
+    bool valid = true;
+    double spanTime = cu_test_time([&] {
+        for(int ii = 0; ii < MESSAGE_COUNT; ii++) {
+            writer.reset();
+            writer.writeUint32((Uint32)ii);
+            writer.writeString(std::string_view(tag));
+            writer.writeUint64Vector(std::span<const Uint64>(input.ids));
+            writer.writeFloatVector(std::span<const float>(input.states));
+            const std::vector<std::byte>& message = writer.serialize();
+            bytes = message.size();
+            reader.receive(message.data(), message.size());
+            valid = reader.readUint32() == (Uint32)ii && valid;
+            valid = reader.readStringView() == tag && valid;
+            reader.readUint64Vector(std::span<Uint64>(output.ids));
+            reader.readFloatVector(std::span<float>(output.states));
+        }
+    });
+    CU_CHECK(valid);
+    CU_CHECK(output.ids == input.ids && output.states == input.states);
+
+    double mb = (double)bytes*MESSAGE_COUNT/(1024.0*1024.0);
+    std::printf("%zu byte messages: %.2f us reference, %.2f us vectors, %.2f us spans (%.0f MB/s)\n",
+                bytes, 1000*refTime/MESSAGE_COUNT, 1000*vecTime/MESSAGE_COUNT,
+                1000*spanTime/MESSAGE_COUNT, 1000*mb/spanTime);
+}
+
+/**
+ * Runs the serializer checks and timings.
+ */
+int main(int argc, char** argv) {
+    testRoundTrip();
+    testSpans();
+    testTruncation();
+    timeThroughput();
+    return cu_test_result("NetSerializerTest");
+}
@@ -0,0 +1,126 @@
+//
+//  NetSyncTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the prioritized physics synchronization of the
+//  networked physics controller. It checks that the fastest obstacles are
+//  sent first, that every obstacle is eventually sent, and that an event
+//  never exceeds the priority sync limit. It then reports the time to pack
+//  a prioritized synchronization for a large world.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/physics2/distrib/CUNetPhysicsController.h>
+#include <cugl/physics2/distrib/CUNetWorld.h>
+#include <cugl/physics2/distrib/CUPhysSyncEvent.h>
+#include <cugl/physics2/CUBoxObstacle.h>
+#include <CUTestHarness.h>
+#include <unordered_set>
+
+using namespace cugl;
+using namespace cugl::physics2;
+using namespace cugl::physics2::distrib;
+
+/** The number of obstacles in the world */
+#define WORLD_SIZE  10000
+/** The number of fast moving obstacles */
+#define FAST_SIZE   100
+/** The maximum number of obstacles per synchronization */
+#define SYNC_LIMIT  80
+
+/**
+ * Returns the ids sent by the events queued in the controller.
+ *
+ * The queue of outbound events is cleared afterwards.
+ *
+ * @param control   The physics controller
+ *
+ * @return the ids sent by the events queued in the controller.
+ */
+static std::vector<Uint64> drain(const std::shared_ptr<NetPhysicsController>& control) {
+    std::vector<Uint64> result;
+    auto& events = control->getOutEvents();
+    for (auto it = events.begin(); it != events.end(); it++) {
+        auto sync = std::dynamic_pointer_cast<PhysSyncEvent>(*it);
+        if (sync) {
+            const auto& list = sync->getSyncList();
+            for (auto jt = list.begin(); jt != list.end(); jt++) {
+                result.push_back(jt->obsId);
+            }
+        }
+    }
+    events.clear();
+    return result;
+}
+
+/**
+ * Runs the prioritized synchronization checks and timings.
+ */
+int main(int argc, char** argv) {
+    auto world = NetWorld::alloc(Rect(0,0,1000,1000), Vec2::ZERO);
+    std::unordered_set<Uint64> fast;
+    for (int ii = 0; ii < WORLD_SIZE; ii++) {
+        Vec2 pos((ii % 100)*10.0f+5.0f, (ii / 100)*10.0f+5.0f);
+        auto box = BoxObstacle::alloc(pos, Size(1,1));
+        Uint64 id = world->initObstacle(box);
+        if (ii % (WORLD_SIZE/FAST_SIZE) == 0) {
+            box->setLinearVelocity(Vec2(10,0));
+            fast.insert(id);
+        }
+    }
+
+    auto control = NetPhysicsController::alloc(world, 1, true);
+    control->setPrioritySyncLimit(SYNC_LIMIT);
+
+    // The first synchronization only has fast obstacles
+    control->packPhysSync(NetPhysicsController::SyncType::PRIO_SYNC);
+    std::vector<Uint64> sent = drain(control);
+    CU_CHECK(sent.size() == SYNC_LIMIT);
+    for (auto it = sent.begin(); it != sent.end(); it++) {
+        CU_CHECK(fast.count(*it));
+    }
+
+    // Staleness guarantees that every obstacle is eventually sent
+    std::unordered_set<Uint64> seen(sent.begin(), sent.end());
+    int frames = 1;
+    while (seen.size() < WORLD_SIZE && frames < 1000) {
+        control->packPhysSync(NetPhysicsController::SyncType::PRIO_SYNC);
+        sent = drain(control);
+        CU_CHECK(sent.size() <= SYNC_LIMIT);
+        seen.insert(sent.begin(), sent.end());
+        frames++;
+    }
+    CU_CHECK(seen.size() == WORLD_SIZE);
+    std::printf("every obstacle sent after %d frames (minimum %d)\n",
+                frames, (WORLD_SIZE+SYNC_LIMIT-1)/SYNC_LIMIT);
+
+    double time = cu_test_time([&] {
+        for (int frame = 0; frame < 100; frame++) {
+            control->packPhysSync(NetPhysicsController::SyncType::PRIO_SYNC);
+            control->getOutEvents().clear();
+        }
+    });
+    std::printf("%d obstacles: %.3f ms per prioritized sync\n", WORLD_SIZE, time/100);
+    return cu_test_result("NetSyncTest");
+}
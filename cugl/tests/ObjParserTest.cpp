@@ -0,0 +1,414 @@
+//
+//  ObjParserTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the OBJ parser on a large generated model. The model
+//  has many render groups of textured quads, as well as line and point
+//  groups. The driver checks that every group is indexed correctly, that
+//  parsing with a worker pool gives exactly the same model as parsing with
+//  one thread, and that the binary cache reads back the same model. It checks
+//  that every number is parsed to exactly the float given by strtof, and
+//  that a truncated cache is rejected. It then reports the time to parse the
+//  text file and to read the cache.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/17/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/scene3/CUObjParser.h>
+#include <CUTestHarness.h>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+using namespace cugl;
+using namespace cugl::scene3;
+
+/** The number of quad groups in the model */
+#define GROUP_COUNT     16
+/** The number of quads along each side of a group */
+#define GRID_SIZE       128
+/** The number of worker threads for the parallel parser */
+#define THREAD_COUNT    4
+/** The generated OBJ file */
+#define OBJ_FILE        "ObjParserTest.obj"
+/** The generated cache file */
+#define CACHE_FILE      "ObjParserTest.cobj"
+/** The number of random numbers to compare against strtof */
+#define NUMBER_COUNT    150000
+/** The generated file of numbers */
+#define NUMBER_FILE     "ObjParserNumbers.obj"
+/** The generated file for the truncated caches */
+#define SMALL_FILE      "ObjParserSmall.cobj"
+/** The size of the cache header in bytes */
+#define CACHE_HEADER    32
+
+/** Numbers near the limits of the fast conversion */
+static const char* NUMBERS[] = {
+    "0", "-0", "+0.0", "1", "-1", "+1.5", ".5", "5.", "-.25", "0.1", "-0.3",
+    "1e10", "1E-10", "1.5e+3", "-2.5e-3", "1e22", "1e-22", "1e23", "1e-23",
+    "16777216", "16777217", "16777219", "-16777217", "9007199254740992",
+    "9007199254740993", "18014398509481985", "1234567890123456789",
+    "12345678901234567890123", "0.1234567890123456789012",
+    "1.00000005960464477539062500", "1.00000005960464477539062501",
+    "1.00000005960464477539062499", "1.000000059604644775390625e0",
+    "3.4028235e38", "3.4028236e38", "1e39", "-1e39", "1.17549435e-38",
+    "1e-45", "1e-46", "7.038531e-26", "1.7014118346046923e38",
+    "0.000000000000000000000000001", "123456.7890e-4", "-0e-50", "00000.00001e5",
+    "1.24010276979773898e+30", "1.29594222926243674e-05", "9.667535323205724711e+26",
+    "2.99073588848114", "8.319793269038200e-02", "1.153600809278766e+21",
+    "3.310703307779980e+24", "inf", "-inf", "nan"
+};
+
+/**
+ * Writes a model with many groups of quads to the given file.
+ *
+ * Each group is a grid of quads in its own object, with its own material,
+ * and with a counter-clockwise winding. The last two groups are a line
+ * strip and a set of points over the first grid.
+ *
+ * @param file  The file to write
+ */
+static void writeModel(const char* file) {
+    std::ofstream out(file);
+    out << "# Generated by ObjParserTest\n";
+    out << "vn 0 0 1\n";
+    Uint32 side = GRID_SIZE+1;
+    for(int gg = 0; gg < GROUP_COUNT; gg++) {
+        for(Uint32 yy = 0; yy < side; yy++) {
+            for(Uint32 xx = 0; xx < side; xx++) {
+                out << "v " << gg*200+xx << " " << yy << " " << gg*0.5f << "\n";
+                out << "vt " << xx/(float)GRID_SIZE << " " << yy/(float)GRID_SIZE << "\n";
+            }
+        }
+    }
+
+    for(int gg = 0; gg < GROUP_COUNT; gg++) {
+        out << "o grid" << gg << "\n";
+        out << "usemtl material" << gg << "\n";
+        Uint32 base = gg*side*side+1;
+        for(Uint32 yy = 0; yy < GRID_SIZE; yy++) {
+            for(Uint32 xx = 0; xx < GRID_SIZE; xx++) {
+                Uint32 corner = base+yy*side+xx;
+                Uint32 quad[] = { corner, corner+1, corner+side+1, corner+side };
+                out << "f";
+                for(int ii = 0; ii < 4; ii++) {
+                    out << " " << quad[ii] << "/" << quad[ii] << "/1";
+                }
+                out << "\n";
+            }
+        }
+    }
+
+    out << "o outline\n";
+    out << "l";
+    for(Uint32 xx = 1; xx <= side; xx++) {
+        out << " " << xx;
+    }
+    out << "\n";
+    out << "o corners\n";
+    out << "p 1 " << side << " " << side*side << "\n";
+}
+
+/**
+ * Returns a random number string for comparison against strtof
+ *
+ * The numbers have a sign, mantissas from 1 to 24 digits with a random
+ * decimal point, and an optional exponent. The mantissas are chosen so
+ * that many of them are exact in a double but not in a float.
+ *
+ * @param rand  The random number generator
+ *
+ * @return a random number string for comparison against strtof
+ */
+static std::string randomNumber(std::mt19937& rand) {
+    std::string result;
+    int sign = rand() % 3;
+    if (sign) {
+        result.push_back(sign == 1 ? '-' : '+');
+    }
+    int digits = 1+rand() % 24;
+    int point = rand() % (digits+2);
+    for(int ii = 0; ii < digits; ii++) {
+        if (ii == point) {
+            result.push_back('.');
+        }
+        result.push_back('0'+rand() % 10);
+    }
+    if (rand() % 2) {
+        result.push_back(rand() % 2 ? 'e' : 'E');
+        int exponent = (int)(rand() % 61)-30;
+        if (exponent >= 0 && rand() % 2) {
+            result.push_back('+');
+        }
+        result.append(std::to_string(exponent));
+    }
+    return result;
+}
+
+/**
+ * Returns a number string close to halfway between two floats
+ *
+ * The string has 14 to 19 significant digits. Rounding such a number to a
+ * double first may round it to exactly halfway, which then rounds to the
+ * wrong float.
+ *
+ * @param rand  The random number generator
+ *
+ * @return a number string close to halfway between two floats
+ */
+static std::string halfwayNumber(std::mt19937& rand) {
+    Uint32 bits = 0x00800000+rand() % 0x7E800000;
+    float lower;
+    std::memcpy(&lower, &bits, sizeof(float));
+    double halfway = ((double)lower+(double)std::nextafter(lower, FLT_MAX))/2;
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.*e", 13+(int)(rand() % 6), halfway);
+    return buffer;
+}
+
+/**
+ * Returns true if the two models have the same data
+ *
+ * @param a The first model
+ * @param b The second model
+ *
+ * @return true if the two models have the same data
+ */
+static bool same(const std::shared_ptr<ModelInfo>& a, const std::shared_ptr<ModelInfo>& b) {
+    if (a == nullptr || b == nullptr) {
+        return false;
+    }
+    bool result = a->positions == b->positions && a->texcoords == b->texcoords;
+    result = result && a->normals == b->normals && a->groups.size() == b->groups.size();
+    for(size_t ii = 0; result && ii < a->groups.size(); ii++) {
+        const GroupInfo* left  = a->groups[ii].get();
+        const GroupInfo* right = b->groups[ii].get();
+        result = left->command == right->command && left->object == right->object;
+        result = result && left->material == right->material && left->tags == right->tags;
+        result = result && left->vertices == right->vertices && left->indices == right->indices;
+    }
+    return result;
+}
+
+/**
+ * Checks that the groups of the model are indexed correctly.
+ *
+ * @param model The parsed model
+ */
+static void testGroups(const std::shared_ptr<ModelInfo>& model) {
+    Uint32 side = GRID_SIZE+1;
+    CU_CHECK(model->positions.size() == GROUP_COUNT*side*side);
+    CU_CHECK(model->texcoords.size() == GROUP_COUNT*side*side);
+    CU_CHECK(model->normals.size() == 1);
+
+    // Shared corners are only added once to each group
+    size_t quads = 0;
+    bool valid = true;
+    for(auto it = model->groups.begin(); it != model->groups.end(); ++it) {
+        const GroupInfo* group = it->get();
+        if (group->command != GL_TRIANGLES) {
+            continue;
+        }
+        quads++;
+        valid = valid && group->vertices.size() == side*side;
+        valid = valid && group->indices.size() == 6*GRID_SIZE*GRID_SIZE;
+        for(size_t ii = 0; valid && ii+2 < group->indices.size(); ii += 3) {
+            const VertexInfo& a = group->vertices[group->indices[ii  ]];
+            const VertexInfo& b = group->vertices[group->indices[ii+1]];
+            const VertexInfo& c = group->vertices[group->indices[ii+2]];
+            valid = a.pindex == a.tindex && b.pindex == b.tindex && c.pindex == c.tindex;
+            valid = valid && a.nindex == 0 && b.nindex == 0 && c.nindex == 0;
+            if (valid) {
+                Vec3 u = model->positions[b.pindex]-model->positions[a.pindex];
+                Vec3 v = model->positions[c.pindex]-model->positions[a.pindex];
+                valid = u.x*v.y-u.y*v.x > 0;
+            }
+        }
+    }
+    CU_CHECK(quads == GROUP_COUNT);
+    CU_CHECK(valid);
+
+    size_t lines = 0;
+    size_t points = 0;
+    for(auto it = model->groups.begin(); it != model->groups.end(); ++it) {
+        if ((*it)->command == GL_LINES) {
+            lines += (*it)->indices.size();
+        } else if ((*it)->command == GL_POINTS) {
+            points += (*it)->indices.size();
+        }
+    }
+    CU_CHECK(lines == 2*GRID_SIZE);
+    CU_CHECK(points == 3);
+}
+
+/**
+ * Checks that the parser reads every number as strtof does.
+ *
+ * The numbers are written as vertices, so each is followed by whitespace
+ * or a newline. The floats are compared bit for bit, so that the signs of
+ * zeroes (and the payloads of nans) are checked.
+ */
+static void testNumbers() {
+    std::vector<std::string> numbers(NUMBERS, NUMBERS+sizeof(NUMBERS)/sizeof(char*));
+    std::mt19937 rand(7);
+    while (numbers.size() < NUMBER_COUNT) {
+        numbers.push_back(numbers.size() % 2 ? randomNumber(rand) : halfwayNumber(rand));
+    }
+    
+    std::ofstream out(NUMBER_FILE);
+    for(size_t ii = 0; ii < numbers.size(); ii++) {
+        out << "v " << numbers[ii] << " " << numbers[(ii+1) % numbers.size()];
+        out << " " << numbers[(ii+2) % numbers.size()] << "\n";
+    }
+    out.close();
+    
+    ObjParser parser;
+    auto model = parser.parseObj(NUMBER_FILE, false);
+    CU_CHECK(model != nullptr && model->positions.size() == numbers.size());
+    if (model == nullptr || model->positions.size() != numbers.size()) {
+        std::remove(NUMBER_FILE);
+        return;
+    }
+    
+    size_t failed = 0;
+    for(size_t ii = 0; ii < numbers.size(); ii++) {
+        float expected = std::strtof(numbers[ii].c_str(), nullptr);
+        float actual = model->positions[ii].x;
+        if (std::memcmp(&expected, &actual, sizeof(float))) {
+            if (failed++ < 5) {
+                std::printf("  parsed %s as %.9g, expected %.9g\n", numbers[ii].c_str(), actual, expected);
+            }
+        }
+    }
+    CU_CHECK(failed == 0);
+    std::printf("%zu numbers checked against strtof\n", numbers.size());
+    std::remove(NUMBER_FILE);
+}
+
+/**
+ * Checks that every truncation of a cache is rejected.
+ *
+ * The cache is for a small model that uses every section of the cache.
+ * A cache shorter than the header is not recognized as a cache at all,
+ * so the truncations start with a complete header.
+ */
+static void testTruncated() {
+    std::ofstream text(SMALL_FILE);
+    text << "mtllib small.mtl\n";
+    text << "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n";
+    text << "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n";
+    text << "vn 0 0 1\n";
+    text << "o square\nusemtl red\ng front face\n";
+    text << "f 1/1/1 2/2/1 3/3/1 4/4/1\n";
+    text << "o edge\nl 1 2 3\n";
+    text.close();
+    
+    ObjParser parser;
+    auto model = parser.parseObj(SMALL_FILE, false);
+    CU_CHECK(model != nullptr && model->groups.size() == 2 && model->libraries.size() == 1);
+    if (model == nullptr) {
+        return;
+    }
+    CU_CHECK(ObjParser::writeCache(model, SMALL_FILE));
+    std::ifstream in(SMALL_FILE, std::ios::binary);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    in.close();
+    std::string data = buffer.str();
+    CU_CHECK(data.size() > CACHE_HEADER);
+    
+    // Each rejection logs an error
+    SDL_LogSetPriority(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_CRITICAL);
+    size_t accepted = 0;
+    for(size_t size = CACHE_HEADER; size < data.size(); size++) {
+        std::ofstream out(SMALL_FILE, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), size);
+        out.close();
+        accepted += parser.parseObj(SMALL_FILE, false) != nullptr;
+    }
+    SDL_LogResetPriorities();
+    CU_CHECK(accepted == 0);
+    
+    std::ofstream out(SMALL_FILE, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), data.size());
+    out.close();
+    CU_CHECK(same(model, parser.parseObj(SMALL_FILE, false)));
+    std::printf("%zu truncations of a %zu byte cache rejected\n", data.size()-CACHE_HEADER, data.size());
+    std::remove(SMALL_FILE);
+}
+
+/**
+ * Reports the time to parse the text file and to read the cache.
+ */
+static void timeParser() {
+    ObjParser parser;
+    std::shared_ptr<ModelInfo> model;
+    for(Uint32 threads = 1; threads <= THREAD_COUNT; threads += THREAD_COUNT-1) {
+        parser.setThreadCount(threads);
+        double time = cu_test_time([&] {
+            model = parser.parseObj(OBJ_FILE, false);
+        });
+        std::printf("%zu vertices in %zu groups: %.1f ms to parse with %u threads (%u cores)\n",
+                    model->positions.size(), model->groups.size(), time,
+                    threads, std::thread::hardware_concurrency());
+    }
+    double time = cu_test_time([&] {
+        model = parser.parseObj(CACHE_FILE, false);
+    });
+    std::printf("%zu vertices in %zu groups: %.1f ms to read the cache\n",
+                model->positions.size(), model->groups.size(), time);
+}
+
+/**
+ * Runs the OBJ parser checks and timings.
+ */
+int main(int argc, char** argv) {
+    writeModel(OBJ_FILE);
+
+    ObjParser parser;
+    auto single = parser.parseObj(OBJ_FILE, false);
+    CU_CHECK(single != nullptr);
+    if (single == nullptr) {
+        return cu_test_result("ObjParserTest");
+    }
+    testGroups(single);
+
+    parser.setThreadCount(THREAD_COUNT);
+    CU_CHECK(same(single, parser.parseObj(OBJ_FILE, false)));
+
+    CU_CHECK(ObjParser::writeCache(single, CACHE_FILE));
+    CU_CHECK(same(single, parser.parseObj(CACHE_FILE, false)));
+    testNumbers();
+    testTruncated();
+
+    timeParser();
+    std::remove(OBJ_FILE);
+    std::remove(CACHE_FILE);
+    return cu_test_result("ObjParserTest");
+}
@@ -0,0 +1,210 @@
+//
+//  ObstacleWorldTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the multithreaded features of the obstacle world. It
+//  simulates a scene of many independent stacks of boxes and wheels with a
+//  single thread and with a worker pool, checks that the two simulations
+//  are identical, and reports the speedup of the parallel island solver.
+//  It also checks the batched AABB queries and ray casts against the
+//  single query versions, and reports the time of each.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/physics2/CUObstacleWorld.h>
+#include <cugl/physics2/CUBoxObstacle.h>
+#include <cugl/physics2/CUWheelObstacle.h>
+#include <CUTestHarness.h>
+#include <random>
+#include <thread>
+
+using namespace cugl;
+using namespace cugl::physics2;
+
+/** The number of separate stacks (islands) */
+#define STACK_COUNT     100
+/** The number of bodies in each stack */
+#define STACK_HEIGHT    30
+/** The number of worker threads for the parallel simulation */
+#define THREAD_COUNT    4
+/** The number of steps to simulate */
+#define STEP_COUNT      200
+/** The physics time step */
+#define STEP_SIZE       (1.0f/60.0f)
+/** The number of queries in a batch */
+#define QUERY_COUNT     2000
+
+/**
+ * Returns a world of separate stacks of boxes and wheels.
+ *
+ * The stacks rest on a single static ground, which does not join them
+ * into one island. The obstacles are stored in bodies, in creation order.
+ *
+ * @param bodies    The vector to store the dynamic obstacles
+ *
+ * @return a world of separate stacks of boxes and wheels.
+ */
+static std::shared_ptr<ObstacleWorld> buildWorld(std::vector<std::shared_ptr<Obstacle>>& bodies) {
+    float width = STACK_COUNT*4.0f;
+    auto world = ObstacleWorld::alloc(Rect(0,0,width,STACK_HEIGHT*2.0f), Vec2(0,-9.8f));
+    auto ground = BoxObstacle::alloc(Vec2(width/2,0.5f), Size(width,1));
+    ground->setBodyType(b2_staticBody);
+    world->addObstacle(ground);
+    for (int ii = 0; ii < STACK_COUNT; ii++) {
+        for (int jj = 0; jj < STACK_HEIGHT; jj++) {
+            // Offsets make the stacks topple differently
+            Vec2 pos(ii*4.0f+2.0f+(jj % 3)*0.05f*(ii % 5), jj*1.05f+1.5f);
+            std::shared_ptr<Obstacle> body;
+            if (jj % 4 == 3) {
+                body = WheelObstacle::alloc(pos, 0.5f);
+            } else {
+                body = BoxObstacle::alloc(pos, Size(1,1));
+            }
+            world->addObstacle(body);
+            bodies.push_back(body);
+        }
+    }
+    return world;
+}
+
+/**
+ * Returns the time in milliseconds to simulate the stacks.
+ *
+ * @param threads   The number of threads to solve the islands
+ * @param bodies    The vector to store the dynamic obstacles
+ *
+ * @return the time in milliseconds to simulate the stacks.
+ */
+static double simulate(Uint32 threads, std::vector<std::shared_ptr<Obstacle>>& bodies) {
+    auto world = buildWorld(bodies);
+    world->setThreadCount(threads);
+    return cu_test_time([&] {
+        for (int step = 0; step < STEP_COUNT; step++) {
+            world->update(STEP_SIZE);
+        }
+    }, 1);
+}
+
+/**
+ * Checks that the parallel island solver matches the serial one.
+ */
+static void testIslands() {
+    std::vector<std::shared_ptr<Obstacle>> serial;
+    std::vector<std::shared_ptr<Obstacle>> parallel;
+    double time1 = simulate(1, serial);
+    double time2 = simulate(THREAD_COUNT, parallel);
+
+    CU_CHECK(serial.size() == parallel.size());
+    bool same = true;
+    for (size_t ii = 0; ii < serial.size() && ii < parallel.size(); ii++) {
+        same = same && serial[ii]->getPosition() == parallel[ii]->getPosition();
+        same = same && serial[ii]->getAngle() == parallel[ii]->getAngle();
+    }
+    CU_CHECK(same);
+    std::printf("%d bodies, %d steps: %.1f ms serial, %.1f ms with %d threads (%.2fx on %u cores)\n",
+                STACK_COUNT*STACK_HEIGHT, STEP_COUNT, time1, time2, THREAD_COUNT, time1/time2,
+                std::thread::hardware_concurrency());
+}
+
+/**
+ * Checks the batched queries against the single query versions.
+ */
+static void testQueries() {
+    std::vector<std::shared_ptr<Obstacle>> bodies;
+    auto world = buildWorld(bodies);
+    world->setThreadCount(THREAD_COUNT);
+    for (int step = 0; step < 60; step++) {
+        world->update(STEP_SIZE);
+    }
+
+    std::mt19937 rand(3);
+    std::uniform_real_distribution<float> xcoord(0, STACK_COUNT*4.0f);
+    std::uniform_real_distribution<float> ycoord(0, STACK_HEIGHT*1.5f);
+    std::vector<Rect> boxes;
+    std::vector<Vec2> starts;
+    std::vector<Vec2> ends;
+    for (int ii = 0; ii < QUERY_COUNT; ii++) {
+        boxes.push_back(Rect(xcoord(rand), ycoord(rand), 3, 3));
+        starts.push_back(Vec2(xcoord(rand), ycoord(rand)));
+        ends.push_back(starts.back()+Vec2(xcoord(rand)/10-20, ycoord(rand)-20));
+    }
+
+    // The single query versions
+    std::vector<b2Fixture*> expfixtures;
+    std::vector<size_t> expoffsets;
+    std::vector<RayHit> exphits(QUERY_COUNT);
+    double single = cu_test_time([&] {
+        expfixtures.clear();
+        expoffsets.clear();
+        for (int ii = 0; ii < QUERY_COUNT; ii++) {
+            expoffsets.push_back(expfixtures.size());
+            world->queryAABB([&](b2Fixture* fixture) {
+                expfixtures.push_back(fixture);
+                return true;
+            }, boxes[ii]);
+        }
+        expoffsets.push_back(expfixtures.size());
+        for (int ii = 0; ii < QUERY_COUNT; ii++) {
+            RayHit& hit = exphits[ii];
+            hit.fixture = nullptr;
+            hit.fraction = 1.0f;
+            world->rayCast([&](b2Fixture* fixture, const Vec2 point,
+                               const Vec2 normal, float fraction) {
+                hit.fixture = fixture;
+                hit.fraction = fraction;
+                return fraction;
+            }, starts[ii], ends[ii]);
+        }
+    });
+
+    std::vector<b2Fixture*> fixtures;
+    std::vector<size_t> offsets;
+    std::vector<RayHit> hits(QUERY_COUNT);
+    for (Uint32 threads = 1; threads <= THREAD_COUNT; threads += THREAD_COUNT-1) {
+        world->setThreadCount(threads);
+        double batch = cu_test_time([&] {
+            world->queryAABB(boxes.data(), QUERY_COUNT, fixtures, offsets);
+            world->rayCast(starts.data(), ends.data(), QUERY_COUNT, hits.data());
+        });
+        CU_CHECK(fixtures == expfixtures);
+        CU_CHECK(offsets == expoffsets);
+        bool same = true;
+        for (int ii = 0; ii < QUERY_COUNT; ii++) {
+            same = same && hits[ii].fixture == exphits[ii].fixture;
+            same = same && hits[ii].fraction == exphits[ii].fraction;
+        }
+        CU_CHECK(same);
+        std::printf("%d queries and ray casts: %.3f ms single, %.3f ms batched (%u threads)\n",
+                    QUERY_COUNT, single, batch, threads);
+    }
+}
+
+/**
+ * Runs the obstacle world checks and timings.
+ */
+int main(int argc, char** argv) {
+    testIslands();
+    testQueries();
+    return cu_test_result("ObstacleWorldTest");
+}
@@ -0,0 +1,369 @@
+//
+//  PhysSyncEventTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the bit-packed encoding of physics synchronization
+//  events. It sends a moving world from one peer to another over a local
+//  loopback, and checks that every received snapshot is within half a
+//  quantization step of the sender, both for keyframes and for deltas
+//  against the baseline. It checks that values out of range are clamped,
+//  and that a receiver that misses an event ignores deltas until the next
+//  keyframe. It then reports the bytes per obstacle and the reconstruction
+//  error against the original unquantized encoding.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/17/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/physics2/distrib/CUPhysSyncEvent.h>
+#include <cugl/physics2/CUBoxObstacle.h>
+#include <cugl/netcode/CUNetcodeSerializer.h>
+#include <CUTestHarness.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace cugl;
+using namespace cugl::physics2;
+using namespace cugl::physics2::distrib;
+
+/** The number of obstacles in the world */
+#define WORLD_SIZE      200
+/** The width and height of the world */
+#define WORLD_SPAN      1000.0f
+/** The number of frames to simulate */
+#define FRAME_COUNT     240
+/** The simulation time step */
+#define FRAME_STEP      (1.0f/60.0f)
+/** The number of events between keyframes */
+#define KEYFRAME_RATE   30
+
+#pragma mark Loopback
+/**
+ * A pair of peers connected by a local loopback.
+ *
+ * The sender encodes events to the receiver with its outbound baseline, and
+ * the receiver decodes them with its inbound baseline. Received events have
+ * no source metadata, so they share the inbound history of the empty id.
+ */
+class Loopback {
+public:
+    /** The outbound history of the sender */
+    std::shared_ptr<PhysSyncEvent::Baseline> sender;
+    /** The inbound history of the receiver */
+    std::shared_ptr<PhysSyncEvent::Baseline> receiver;
+
+    /**
+     * Creates a loopback with the given keyframe rate
+     *
+     * @param rate  The number of events between keyframes
+     */
+    Loopback(Uint32 rate) {
+        sender = PhysSyncEvent::Baseline::alloc();
+        sender->setKeyframeRate(rate);
+        receiver = PhysSyncEvent::Baseline::alloc();
+    }
+
+    /**
+     * Returns the encoding of the given obstacles
+     *
+     * @param world The obstacles to send
+     *
+     * @return the encoding of the given obstacles
+     */
+    std::vector<std::byte> send(const std::vector<std::shared_ptr<Obstacle>>& world) {
+        auto event = PhysSyncEvent::alloc();
+        event->setBaseline(sender);
+        event->setDestination("receiver");
+        for (size_t ii = 0; ii < world.size(); ii++) {
+            event->addObstacle(ii, world[ii]);
+        }
+        return event->serialize();
+    }
+
+    /**
+     * Returns the snapshots decoded from the given message
+     *
+     * @param data  The encoded message
+     *
+     * @return the snapshots decoded from the given message
+     */
+    std::vector<PhysSyncEvent::Parameters> receive(const std::vector<std::byte>& data) {
+        auto event = PhysSyncEvent::alloc();
+        event->setBaseline(receiver);
+        event->deserialize(data);
+        return event->getSyncList();
+    }
+};
+
+#pragma mark Helpers
+/**
+ * Returns the largest error allowed for a value with the given precision
+ *
+ * Values are rounded to the nearest fixed point number, so the error is at
+ * most half a step. The dequantized value is exact in a float as long as
+ * the quantized value has at most 24 significant bits.
+ *
+ * @param bits  The number of fractional bits
+ *
+ * @return the largest error allowed for a value with the given precision
+ */
+static double bound(Uint8 bits) {
+    return std::ldexp(0.5, -bits);
+}
+
+/**
+ * Returns a world of randomly placed and moving obstacles
+ *
+ * @param rand  The random generator
+ *
+ * @return a world of randomly placed and moving obstacles
+ */
+static std::vector<std::shared_ptr<Obstacle>> makeWorld(std::mt19937& rand) {
+    std::uniform_real_distribution<float> coord(-WORLD_SPAN/2, WORLD_SPAN/2);
+    std::uniform_real_distribution<float> speed(-20.0f, 20.0f);
+    std::vector<std::shared_ptr<Obstacle>> world;
+    for (int ii = 0; ii < WORLD_SIZE; ii++) {
+        auto box = BoxObstacle::alloc(Vec2(coord(rand), coord(rand)), Size(1,1));
+        box->setLinearVelocity(Vec2(speed(rand), speed(rand)));
+        box->setAngle(speed(rand)/10);
+        box->setAngularVelocity(speed(rand)/4);
+        world.push_back(box);
+    }
+    return world;
+}
+
+/**
+ * Advances the obstacles of the world by one time step
+ *
+ * There is no physics world, so the obstacles are moved by hand.
+ *
+ * @param world The obstacles to move
+ */
+static void stepWorld(const std::vector<std::shared_ptr<Obstacle>>& world) {
+    for (auto it = world.begin(); it != world.end(); ++it) {
+        Obstacle* obs = it->get();
+        obs->setPosition(obs->getPosition()+obs->getLinearVelocity()*FRAME_STEP);
+        obs->setAngle(obs->getAngle()+obs->getAngularVelocity()*FRAME_STEP);
+    }
+}
+
+/**
+ * Returns the largest error of each value group for the given snapshots
+ *
+ * The result is the error of the position, the linear velocity, the angle
+ * and the angular velocity, each relative to the precision bound. Hence
+ * every entry is at most 1 if the snapshots are within the bound. Every
+ * snapshot id must be a valid index into the world.
+ *
+ * @param world     The obstacles that were sent
+ * @param received  The snapshots that were received
+ * @param quant     The snapshot precision
+ *
+ * @return the largest error of each value group for the given snapshots
+ */
+static std::array<double,4> measure(const std::vector<std::shared_ptr<Obstacle>>& world,
+                                    const std::vector<PhysSyncEvent::Parameters>& received,
+                                    const PhysSyncEvent::Quantization& quant) {
+    std::array<double,4> error = { 0, 0, 0, 0 };
+    for (auto it = received.begin(); it != received.end(); ++it) {
+        const Obstacle* obs = world[it->obsId].get();
+        double pos = std::max(std::fabs((double)it->x-obs->getX()),
+                              std::fabs((double)it->y-obs->getY()));
+        double vel = std::max(std::fabs((double)it->vx-obs->getVX()),
+                              std::fabs((double)it->vy-obs->getVY()));
+        error[0] = std::max(error[0], pos/bound(quant.position));
+        error[1] = std::max(error[1], vel/bound(quant.velocity));
+        error[2] = std::max(error[2], std::fabs((double)it->angle-obs->getAngle())/bound(quant.angle));
+        error[3] = std::max(error[3], std::fabs((double)it->vAngular-obs->getAngularVelocity())/bound(quant.angular));
+    }
+    return error;
+}
+
+/**
+ * Returns the size of the original (unquantized) encoding of the world
+ *
+ * The original encoding wrote the count, and then the id and six floats of
+ * each obstacle, with the netcode serializer.
+ *
+ * @param world The obstacles to send
+ *
+ * @return the size of the original (unquantized) encoding of the world
+ */
+static size_t original(const std::vector<std::shared_ptr<Obstacle>>& world) {
+    netcode::NetcodeSerializer serializer;
+    serializer.writeUint64((Uint64)world.size());
+    for (size_t ii = 0; ii < world.size(); ii++) {
+        const Obstacle* obs = world[ii].get();
+        serializer.writeUint64(ii);
+        serializer.writeFloat(obs->getX());
+        serializer.writeFloat(obs->getY());
+        serializer.writeFloat(obs->getVX());
+        serializer.writeFloat(obs->getVY());
+        serializer.writeFloat(obs->getAngle());
+        serializer.writeFloat(obs->getAngularVelocity());
+    }
+    return serializer.size();
+}
+
+#pragma mark Checks
+/**
+ * Checks that a moving world is reconstructed within the quantization bound.
+ */
+static void testLoopback() {
+    std::mt19937 rand(3);
+    std::vector<std::shared_ptr<Obstacle>> world = makeWorld(rand);
+    Loopback loop(KEYFRAME_RATE);
+    PhysSyncEvent::Quantization quant;
+
+    std::array<double,4> worst = { 0, 0, 0, 0 };
+    size_t complete = 0;
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        stepWorld(world);
+        std::vector<PhysSyncEvent::Parameters> received = loop.receive(loop.send(world));
+        complete += (received.size() == world.size());
+        std::array<double,4> error = measure(world, received, quant);
+        for (int ii = 0; ii < 4; ii++) {
+            worst[ii] = std::max(worst[ii], error[ii]);
+        }
+    }
+    CU_CHECK(complete == FRAME_COUNT);
+    for (int ii = 0; ii < 4; ii++) {
+        CU_CHECK(worst[ii] <= 1.0);
+    }
+
+    // A finer precision is carried in the event itself
+    PhysSyncEvent::Quantization fine;
+    fine.position = 12;
+    fine.velocity = 10;
+    fine.angle = 16;
+    fine.angular = 12;
+    loop.sender->setQuantization(fine);
+    std::vector<PhysSyncEvent::Parameters> received = loop.receive(loop.send(world));
+    std::array<double,4> error = measure(world, received, fine);
+    CU_CHECK(received.size() == world.size());
+    for (int ii = 0; ii < 4; ii++) {
+        CU_CHECK(error[ii] <= 1.0);
+    }
+}
+
+/**
+ * Checks that values out of range are clamped instead of wrapping.
+ */
+static void testClamp() {
+    std::vector<std::shared_ptr<Obstacle>> world;
+    world.push_back(BoxObstacle::alloc(Vec2(3.0e7f, -3.0e7f), Size(1,1)));
+    world.push_back(BoxObstacle::alloc(Vec2(-1.5f, 2.25f), Size(1,1)));
+    Loopback loop(0);
+    std::vector<PhysSyncEvent::Parameters> received = loop.receive(loop.send(world));
+    CU_CHECK(received.size() == 2);
+    if (received.size() == 2) {
+        float limit = (float)std::ldexp((double)((1 << 29)-1), -SYNC_POSITION_BITS);
+        CU_CHECK(received[0].x == limit && received[0].y == -limit);
+        CU_CHECK(received[1].x == -1.5f && received[1].y == 2.25f);
+    }
+}
+
+/**
+ * Checks that a receiver that misses an event waits for a keyframe.
+ */
+static void testMissed() {
+    std::mt19937 rand(9);
+    std::vector<std::shared_ptr<Obstacle>> world = makeWorld(rand);
+    Loopback loop(8);
+    PhysSyncEvent::Quantization quant;
+
+    // Event 1 is a keyframe, and event 2 is a delta
+    CU_CHECK(loop.receive(loop.send(world)).size() == world.size());
+    stepWorld(world);
+    CU_CHECK(loop.receive(loop.send(world)).size() == world.size());
+
+    // Event 3 is lost, so no delta can be decoded until keyframe 8
+    stepWorld(world);
+    loop.send(world);
+    for (int ii = 4; ii < 8; ii++) {
+        stepWorld(world);
+        CU_CHECK(loop.receive(loop.send(world)).empty());
+    }
+    stepWorld(world);
+    std::vector<PhysSyncEvent::Parameters> received = loop.receive(loop.send(world));
+    CU_CHECK(received.size() == world.size());
+    std::array<double,4> error = measure(world, received, quant);
+    for (int ii = 0; ii < 4; ii++) {
+        CU_CHECK(error[ii] <= 1.0);
+    }
+}
+
+#pragma mark Measurements
+/**
+ * Reports the bytes per obstacle and the reconstruction error.
+ *
+ * The sizes are compared to the original encoding, which sent six floats
+ * for every obstacle. The error is relative to the quantization bound.
+ */
+static void measureBandwidth() {
+    std::mt19937 rand(5);
+    std::vector<std::shared_ptr<Obstacle>> world = makeWorld(rand);
+    Loopback loop(KEYFRAME_RATE);
+    PhysSyncEvent::Quantization quant;
+
+    size_t keybytes = 0, keyframes = 0;
+    size_t deltabytes = 0, deltas = 0;
+    size_t oldbytes = 0;
+    std::array<double,4> worst = { 0, 0, 0, 0 };
+    for (int frame = 1; frame <= FRAME_COUNT; frame++) {
+        stepWorld(world);
+        std::vector<std::byte> data = loop.send(world);
+        if (frame % KEYFRAME_RATE == 1) {
+            keybytes += data.size();
+            keyframes++;
+        } else {
+            deltabytes += data.size();
+            deltas++;
+        }
+        oldbytes += original(world);
+        std::array<double,4> error = measure(world, loop.receive(data), quant);
+        for (int ii = 0; ii < 4; ii++) {
+            worst[ii] = std::max(worst[ii], error[ii]);
+        }
+    }
+    CU_CHECK(keyframes > 0 && deltas > 0);
+    CU_CHECK(deltabytes/deltas < keybytes/keyframes);
+
+    double keysize = (double)keybytes/(keyframes*WORLD_SIZE);
+    double deltasize = (double)deltabytes/(deltas*WORLD_SIZE);
+    double oldsize = (double)oldbytes/(FRAME_COUNT*WORLD_SIZE);
+    std::printf("%.1f bytes/obstacle original, %.1f keyframe, %.1f delta; "
+                "error %.2f/%.2f/%.2f/%.2f of bound (pos/vel/angle/spin)\n",
+                oldsize, keysize, deltasize, worst[0], worst[1], worst[2], worst[3]);
+}
+
+/**
+ * Runs the synchronization event checks and measurements.
+ */
+int main(int argc, char** argv) {
+    testLoopback();
+    testClamp();
+    testMissed();
+    measureBandwidth();
+    return cu_test_result("PhysSyncEventTest");
+}
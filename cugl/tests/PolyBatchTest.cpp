@@ -0,0 +1,178 @@
+//
+//  PolyBatchTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the batch polygon factory. It triangulates and
+//  extrudes many paths with one thread and with a worker pool, and checks
+//  that every polygon is exactly the one made by a single triangulator or
+//  extruder. It then reports the time to process the batch with one thread
+//  and with the worker pool, against processing the paths one at a time.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/16/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/core/math/polygon/CUPolyBatch.h>
+#include <cugl/core/math/polygon/CUEarclipTriangulator.h>
+#include <cugl/core/math/polygon/CUSimpleExtruder.h>
+#include <CUTestHarness.h>
+#include <cmath>
+#include <random>
+#include <thread>
+
+using namespace cugl;
+
+/** The number of paths in the batch */
+#define PATH_COUNT      1000
+/** The number of worker threads for the parallel batch */
+#define THREAD_COUNT    4
+/** The width of the extrusion */
+#define STROKE_WIDTH    2.0f
+
+/**
+ * Returns a batch of random star-shaped paths.
+ *
+ * The paths have between 16 and 400 vertices, so the tasks must balance
+ * the work by vertex count rather than by path count.
+ *
+ * @return a batch of random star-shaped paths.
+ */
+static std::vector<Path2> buildPaths() {
+    std::mt19937 rand(9);
+    std::uniform_int_distribution<int> size(8, 200);
+    std::uniform_real_distribution<float> inner(10.0f, 45.0f);
+    std::vector<Path2> result;
+    for (int ii = 0; ii < PATH_COUNT; ii++) {
+        size_t count = 2*size(rand);
+        std::vector<Vec2> points;
+        for (size_t jj = 0; jj < count; jj++) {
+            double angle = 2*M_PI*jj/count;
+            float radius = jj % 2 ? inner(rand) : 50.0f;
+            points.push_back(Vec2((ii % 40)*100+radius*std::cos(angle),
+                                  (ii / 40)*100+radius*std::sin(angle)));
+        }
+        result.push_back(Path2(points));
+        result.back().closed = true;
+    }
+    return result;
+}
+
+/**
+ * Returns true if the two polygons have the same vertices and indices
+ *
+ * @param a The first polygon
+ * @param b The second polygon
+ *
+ * @return true if the two polygons have the same vertices and indices
+ */
+static bool same(const Poly2& a, const Poly2& b) {
+    return a.vertices == b.vertices && a.indices == b.indices;
+}
+
+/**
+ * Checks the batch against single triangulators and extruders.
+ *
+ * @param paths The paths to process
+ */
+static void testBatch(const std::vector<Path2>& paths) {
+    std::vector<Poly2> triangles;
+    std::vector<Poly2> strokes;
+    EarclipTriangulator triangulator;
+    SimpleExtruder extruder;
+    for (auto it = paths.begin(); it != paths.end(); ++it) {
+        triangulator.clear();
+        triangulator.set(*it);
+        triangulator.calculate();
+        triangles.push_back(triangulator.getPolygon());
+        extruder.clear();
+        extruder.set(*it);
+        extruder.calculate(STROKE_WIDTH);
+        strokes.push_back(extruder.getPolygon());
+    }
+
+    auto batch = PolyBatch::alloc(1);
+    batch->addPaths(paths);
+    for (Uint32 threads = 1; threads <= THREAD_COUNT; threads += THREAD_COUNT-1) {
+        batch->setThreadCount(threads);
+        batch->triangulate();
+        bool matches = batch->size() == paths.size();
+        for (size_t ii = 0; matches && ii < paths.size(); ii++) {
+            matches = same(batch->getPolygon(ii), triangles[ii]);
+        }
+        CU_CHECK(matches);
+
+        batch->reset();
+        batch->extrude(STROKE_WIDTH);
+        matches = batch->size() == paths.size();
+        for (size_t ii = 0; matches && ii < paths.size(); ii++) {
+            matches = same(batch->getPolygon(ii), strokes[ii]);
+        }
+        CU_CHECK(matches);
+        batch->reset();
+    }
+}
+
+/**
+ * Reports the time to triangulate and extrude the batch.
+ *
+ * @param paths The paths to process
+ */
+static void timeBatch(const std::vector<Path2>& paths) {
+    EarclipTriangulator triangulator;
+    SimpleExtruder extruder;
+    double single = cu_test_time([&] {
+        for (auto it = paths.begin(); it != paths.end(); ++it) {
+            triangulator.clear();
+            triangulator.set(*it);
+            triangulator.calculate();
+            triangulator.getPolygon();
+            extruder.clear();
+            extruder.set(*it);
+            extruder.calculate(STROKE_WIDTH);
+            extruder.getPolygon();
+        }
+    });
+
+    auto batch = PolyBatch::alloc(1);
+    batch->addPaths(paths);
+    for (Uint32 threads = 1; threads <= THREAD_COUNT; threads += THREAD_COUNT-1) {
+        batch->setThreadCount(threads);
+        double time = cu_test_time([&] {
+            batch->reset();
+            batch->triangulate();
+            batch->reset();
+            batch->extrude(STROKE_WIDTH);
+        });
+        std::printf("%d paths: %.1f ms one at a time, %.1f ms batched with %u threads (%u cores)\n",
+                    PATH_COUNT, single, time, threads, std::thread::hardware_concurrency());
+    }
+}
+
+/**
+ * Runs the batch polygon checks and timings.
+ */
+int main(int argc, char** argv) {
+    std::vector<Path2> paths = buildPaths();
+    testBatch(paths);
+    timeBatch(paths);
+    return cu_test_result("PolyBatchTest");
+}
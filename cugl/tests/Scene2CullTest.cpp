@@ -0,0 +1,311 @@
+//
+//  Scene2CullTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the view culling of a 2d scene graph. It renders many
+//  groups of nodes spread over a large world with a sprite batch that is
+//  never initialized (so it needs no OpenGL context). Each node records its
+//  draw call. The driver checks that exactly the nodes whose world bounds
+//  meet the camera view are drawn, with their correct world transforms. It
+//  checks this for a static scene, for moving and resized nodes, and for
+//  added and removed nodes. It then reports the time to render a frame with
+//  and without culling.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/17/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/scene2/CUScene2.h>
+#include <cugl/scene2/CUSceneNode2.h>
+#include <cugl/graphics/CUSpriteBatch.h>
+#include <cugl/core/math/CUOrthographicCamera.h>
+#include <CUTestHarness.h>
+#include <random>
+
+using namespace cugl;
+using namespace cugl::scene2;
+using namespace cugl::graphics;
+
+/** The number of groups in the scene */
+#define GROUP_COUNT     200
+/** The number of leaves in each group */
+#define LEAF_COUNT      50
+/** The half-width of the world */
+#define WORLD_SIZE      5000.0f
+/** The number of frames in each timing */
+#define FRAME_COUNT     50
+
+/**
+ * A node that records its draw calls.
+ */
+class RecordNode : public SceneNode {
+public:
+    /** The nodes drawn since the last clear */
+    static std::vector<SceneNode*> nodes;
+    /** The transforms drawn since the last clear */
+    static std::vector<Affine2> transforms;
+
+    /**
+     * Records this node and its transform.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     * @param transform The global transformation matrix.
+     * @param tint      The tint to blend with the Node color.
+     */
+    void draw(const std::shared_ptr<SpriteBatch>& batch,
+              const Affine2& transform, Color4 tint) override {
+        nodes.push_back(this);
+        transforms.push_back(transform);
+    }
+
+    /**
+     * Returns a newly allocated node with the given size and position.
+     *
+     * @param size  The node size
+     * @param pos   The node position
+     *
+     * @return a newly allocated node with the given size and position.
+     */
+    static std::shared_ptr<RecordNode> alloc(const Size size, const Vec2 pos) {
+        std::shared_ptr<RecordNode> result = std::make_shared<RecordNode>();
+        if (result->initWithBounds(size)) {
+            result->setPosition(pos);
+            return result;
+        }
+        return nullptr;
+    }
+};
+
+std::vector<SceneNode*> RecordNode::nodes;
+std::vector<Affine2> RecordNode::transforms;
+
+/**
+ * A scene that renders without starting the sprite batch.
+ */
+class CullScene : public Scene2 {
+public:
+    /**
+     * Initializes a scene with the given viewport size.
+     *
+     * @param width     The viewport width
+     * @param height    The viewport height
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(float width, float height) {
+        _size.set(width, height);
+        _camera = OrthographicCamera::allocOffset(0, 0, width, height);
+        _active = _camera != nullptr;
+        return _active;
+    }
+
+    /**
+     * Renders the scene graph with the given (uninitialized) batch.
+     *
+     * This is the same traversal as {@link Scene2#render}, but it does not
+     * start or end the batch.
+     *
+     * @param batch The sprite batch
+     */
+    void record(const std::shared_ptr<SpriteBatch>& batch) {
+        RecordNode::nodes.clear();
+        RecordNode::transforms.clear();
+        beginCulling();
+        for(auto it = _children.begin(); it != _children.end(); ++it) {
+            (*it)->render(batch, Affine2::IDENTITY, _color);
+        }
+        endCulling();
+    }
+};
+
+/**
+ * Collects the visible record nodes of the subtree in pre-order.
+ *
+ * @param node      The subtree root
+ * @param result    The collected nodes
+ */
+static void collect(const std::shared_ptr<SceneNode>& node, std::vector<SceneNode*>& result) {
+    if (!node->isVisible()) {
+        return;
+    }
+    if (dynamic_cast<RecordNode*>(node.get())) {
+        result.push_back(node.get());
+    }
+    std::vector<std::shared_ptr<SceneNode>> children = node->getChildren();
+    for(auto it = children.begin(); it != children.end(); ++it) {
+        collect(*it, result);
+    }
+}
+
+/**
+ * Renders the scene and checks the drawn nodes against brute force.
+ *
+ * @param name  The check name, for reporting errors
+ * @param scene The scene to render
+ * @param batch The sprite batch
+ */
+static void check(const char* name, const std::shared_ptr<CullScene>& scene,
+                  const std::shared_ptr<SpriteBatch>& batch) {
+    scene->record(batch);
+
+    std::vector<SceneNode*> all;
+    std::vector<std::shared_ptr<SceneNode>> children = scene->getChildren();
+    for(auto it = children.begin(); it != children.end(); ++it) {
+        collect(*it, all);
+    }
+    std::vector<SceneNode*> expected;
+    Rect view(Vec2::ZERO, scene->getSize());
+    for(auto it = all.begin(); it != all.end(); ++it) {
+        Rect bounds(Vec2::ZERO, (*it)->getContentSize());
+        bounds = (*it)->getNodeToWorldTransform().transform(bounds);
+        if (!scene->isCulling() || bounds.doesIntersect(view)) {
+            expected.push_back(*it);
+        }
+    }
+
+    // Drawing preserves the pre-order of the graph
+    bool valid = RecordNode::nodes == expected;
+    for(size_t ii = 0; valid && ii < RecordNode::nodes.size(); ii++) {
+        Affine2 world = RecordNode::nodes[ii]->getNodeToWorldTransform();
+        valid = world.equals(RecordNode::transforms[ii]);
+    }
+    if (!valid) {
+        std::printf("  %s: drew %zu nodes, expected %zu\n", name,
+                    RecordNode::nodes.size(), expected.size());
+    }
+    CU_CHECK(valid);
+    CU_CHECK(scene->getCulledCount()+scene->getDrawnCount() == scene->getVisitedCount());
+}
+
+/**
+ * Returns a scene with groups of leaves spread over a large world.
+ *
+ * The groups are rotated and scaled, so the world bounds of the leaves
+ * are not aligned with their content boxes.
+ *
+ * @param leaves    The leaf nodes
+ * @param groups    The group nodes
+ *
+ * @return a scene with groups of leaves spread over a large world.
+ */
+static std::shared_ptr<CullScene> buildScene(std::vector<std::shared_ptr<SceneNode>>& leaves,
+                                             std::vector<std::shared_ptr<SceneNode>>& groups) {
+    auto scene = std::make_shared<CullScene>();
+    scene->init(1024, 768);
+    std::mt19937 rand(7);
+    std::uniform_real_distribution<float> world(-WORLD_SIZE, WORLD_SIZE);
+    for(int ii = 0; ii < GROUP_COUNT; ii++) {
+        auto group = SceneNode::alloc();
+        group->setPosition(ii < 4 ? Vec2(100+ii*200.0f,300) : Vec2(world(rand),world(rand)));
+        group->setAngle(ii*0.3f);
+        group->setScale(0.5f+(ii % 4)*0.25f);
+        for(int jj = 0; jj < LEAF_COUNT; jj++) {
+            auto leaf = RecordNode::alloc(Size(32,32), Vec2((jj % 10)*40.0f,(jj / 10)*40.0f));
+            group->addChild(leaf);
+            leaves.push_back(leaf);
+        }
+        scene->addChild(group);
+        groups.push_back(group);
+    }
+    return scene;
+}
+
+/**
+ * Checks the drawn nodes as the scene changes.
+ */
+static void testCulling() {
+    auto batch = std::make_shared<SpriteBatch>();
+    std::vector<std::shared_ptr<SceneNode>> leaves;
+    std::vector<std::shared_ptr<SceneNode>> groups;
+    auto scene = buildScene(leaves, groups);
+    CU_CHECK(scene->isCulling());
+    check("static", scene, batch);
+    CU_CHECK(scene->getCulledCount() > 0 && !RecordNode::nodes.empty());
+    check("static again", scene, batch);
+
+    // Leaves and groups move in and out of view
+    std::mt19937 rand(3);
+    for(int frame = 0; frame < 10; frame++) {
+        for(int ii = 0; ii < 50; ii++) {
+            auto& leaf = leaves[rand() % leaves.size()];
+            leaf->setPosition(leaf->getPosition()+Vec2((frame % 2) ? -300.0f : 300.0f, 0));
+        }
+        groups[frame]->setPosition(groups[frame]->getPosition()+Vec2(0,(frame % 2) ? -500.0f : 500.0f));
+        check("moving", scene, batch);
+    }
+
+    // Content size changes the bounds
+    leaves[0]->setContentSize(Size(5000,5000));
+    check("resized", scene, batch);
+
+    // Hidden nodes are skipped
+    groups[1]->setVisible(false);
+    check("hidden", scene, batch);
+
+    // Structure changes update the subtree bounds
+    auto extra = RecordNode::alloc(Size(64,64), Vec2(-groups[5]->getPosition()));
+    groups[5]->addChild(extra);
+    groups[2]->removeChild(0);
+    scene->removeChild(groups[3]);
+    check("restructured", scene, batch);
+
+    scene->setCulling(false);
+    check("not culled", scene, batch);
+}
+
+/**
+ * Reports the time to render a frame with and without culling.
+ */
+static void timeCulling() {
+    auto batch = std::make_shared<SpriteBatch>();
+    std::vector<std::shared_ptr<SceneNode>> leaves;
+    std::vector<std::shared_ptr<SceneNode>> groups;
+    auto scene = buildScene(leaves, groups);
+    int moving[] = { 0, 100, 1000 };
+    for(int ii = 0; ii < 3; ii++) {
+        double times[2];
+        for(int culling = 0; culling < 2; culling++) {
+            scene->setCulling(culling);
+            times[culling] = cu_test_time([&] {
+                for(int frame = 0; frame < FRAME_COUNT; frame++) {
+                    for(int jj = 0; jj < moving[ii]; jj++) {
+                        auto& leaf = leaves[(frame*moving[ii]+jj*97) % leaves.size()];
+                        leaf->setPosition(leaf->getPosition()+Vec2((frame % 2) ? -0.5f : 0.5f, 0));
+                    }
+                    scene->record(batch);
+                }
+            })/FRAME_COUNT;
+        }
+        std::printf("%zu nodes, %d moving: %.3f ms per frame, %.3f ms culled (%zu drawn)\n",
+                    leaves.size()+groups.size(), moving[ii], times[0], times[1],
+                    RecordNode::nodes.size());
+    }
+}
+
+/**
+ * Runs the scene culling checks and timings.
+ */
+int main(int argc, char** argv) {
+    testCulling();
+    timeCulling();
+    return cu_test_result("Scene2CullTest");
+}
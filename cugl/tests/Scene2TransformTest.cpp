@@ -0,0 +1,395 @@
+//
+//  Scene2TransformTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the cached world transforms of a 2d scene graph. It
+//  renders scenes with a sprite batch that is never initialized (so it needs
+//  no OpenGL context), and each node records its draw call. The driver checks
+//  that every node is drawn with its correct world transform, and that the
+//  transform version only changes when the node or one of its ancestors
+//  moves. A change to an ancestor reaches a node through the version of its
+//  parent, so it also checks that this link is dropped when the node changes
+//  parents. It checks this for plain nodes, for an ordered node that sorts its
+//  descendants, and for the children of a scroll pane. It then reports the
+//  time to render a static frame, and a frame where every group moves.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/17/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/scene2/CUScene2.h>
+#include <cugl/scene2/CUSceneNode2.h>
+#include <cugl/scene2/CUOrderedNode.h>
+#include <cugl/scene2/CUScrollPane.h>
+#include <cugl/graphics/CUSpriteBatch.h>
+#include <cugl/core/math/CUOrthographicCamera.h>
+#include <CUTestHarness.h>
+#include <algorithm>
+
+using namespace cugl;
+using namespace cugl::scene2;
+using namespace cugl::graphics;
+
+/** The number of groups in the timing scene */
+#define GROUP_COUNT     200
+/** The number of leaves in each group of the timing scene */
+#define LEAF_COUNT      50
+/** The number of frames in each timing */
+#define FRAME_COUNT     50
+
+/**
+ * A node that records its draw calls.
+ */
+class RecordNode : public SceneNode {
+public:
+    /** The nodes drawn since the last clear */
+    static std::vector<SceneNode*> nodes;
+    /** The transforms drawn since the last clear */
+    static std::vector<Affine2> transforms;
+
+    /**
+     * Records this node and its transform.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     * @param transform The global transformation matrix.
+     * @param tint      The tint to blend with the Node color.
+     */
+    void draw(const std::shared_ptr<SpriteBatch>& batch,
+              const Affine2& transform, Color4 tint) override {
+        nodes.push_back(this);
+        transforms.push_back(transform);
+    }
+
+    /**
+     * Returns the transform this node was last drawn with.
+     *
+     * @return the transform this node was last drawn with.
+     */
+    Affine2 drawn() const {
+        auto it = std::find(nodes.begin(), nodes.end(), this);
+        return it == nodes.end() ? Affine2::ZERO : transforms[it-nodes.begin()];
+    }
+
+    /**
+     * Returns a newly allocated node at the given position.
+     *
+     * @param pos   The node position
+     *
+     * @return a newly allocated node at the given position.
+     */
+    static std::shared_ptr<RecordNode> alloc(const Vec2 pos) {
+        std::shared_ptr<RecordNode> result = std::make_shared<RecordNode>();
+        if (result->initWithBounds(Size(32,32))) {
+            result->setPosition(pos);
+            return result;
+        }
+        return nullptr;
+    }
+};
+
+std::vector<SceneNode*> RecordNode::nodes;
+std::vector<Affine2> RecordNode::transforms;
+
+/**
+ * A scene that renders without starting the sprite batch.
+ */
+class RecordScene : public Scene2 {
+public:
+    /**
+     * Initializes a scene with the given viewport size.
+     *
+     * @param width     The viewport width
+     * @param height    The viewport height
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(float width, float height) {
+        _size.set(width, height);
+        _camera = OrthographicCamera::allocOffset(0, 0, width, height);
+        _active = _camera != nullptr;
+        return _active;
+    }
+
+    /**
+     * Renders the scene graph with the given (uninitialized) batch.
+     *
+     * This is the same traversal as {@link Scene2#render}, but it does not
+     * start or end the batch.
+     *
+     * @param batch The sprite batch
+     */
+    void record(const std::shared_ptr<SpriteBatch>& batch) {
+        RecordNode::nodes.clear();
+        RecordNode::transforms.clear();
+        beginCulling();
+        for(auto it = _children.begin(); it != _children.end(); ++it) {
+            (*it)->render(batch, Affine2::IDENTITY, _color);
+        }
+        endCulling();
+    }
+};
+
+/**
+ * Returns true if every drawn node used its world transform.
+ *
+ * @return true if every drawn node used its world transform.
+ */
+static bool drawnCorrectly() {
+    bool result = !RecordNode::nodes.empty();
+    for(size_t ii = 0; result && ii < RecordNode::nodes.size(); ii++) {
+        const SceneNode* node = RecordNode::nodes[ii];
+        result = node->getNodeToWorldTransform().equals(RecordNode::transforms[ii]);
+        result = result && node->getRenderTransform().isExactly(RecordNode::transforms[ii]);
+    }
+    return result;
+}
+
+/**
+ * Checks that transforms are only recomputed when a node moves.
+ */
+static void testVersions() {
+    auto batch = std::make_shared<SpriteBatch>();
+    auto scene = std::make_shared<RecordScene>();
+    scene->init(1024, 768);
+
+    auto group = SceneNode::allocWithPosition(Vec2(300,200));
+    group->setAngle(0.5f);
+    auto a = RecordNode::alloc(Vec2(10,20));
+    auto b = RecordNode::alloc(Vec2(40,0));
+    auto c = RecordNode::alloc(Vec2(-60,30));
+    b->setScale(1.5f);
+    a->addChild(b);
+    group->addChild(a);
+    group->addChild(c);
+    scene->addChild(group);
+
+    scene->record(batch);
+    CU_CHECK(RecordNode::nodes.size() == 3 && drawnCorrectly());
+    Uint32 va = a->getTransformVersion();
+    Uint32 vb = b->getTransformVersion();
+    Uint32 vc = c->getTransformVersion();
+
+    // Static nodes and unchanged positions keep their cached transforms
+    scene->record(batch);
+    a->setPosition(a->getPosition());
+    group->setAngle(0.5f);
+    scene->record(batch);
+    CU_CHECK(drawnCorrectly());
+    CU_CHECK(a->getTransformVersion() == va && b->getTransformVersion() == vb);
+    CU_CHECK(c->getTransformVersion() == vc);
+
+    // A moved node updates its subtree, but not its siblings
+    a->setPosition(Vec2(15,25));
+    scene->record(batch);
+    CU_CHECK(drawnCorrectly());
+    CU_CHECK(a->getTransformVersion() != va && b->getTransformVersion() != vb);
+    CU_CHECK(c->getTransformVersion() == vc);
+
+    // A moved ancestor reaches every descendant through its version
+    va = a->getTransformVersion();
+    vb = b->getTransformVersion();
+    group->setAngle(-0.25f);
+    scene->record(batch);
+    CU_CHECK(drawnCorrectly());
+    CU_CHECK(a->getTransformVersion() != va && b->getTransformVersion() != vb);
+    CU_CHECK(c->getTransformVersion() != vc);
+
+    // The cache is usable outside of a scene
+    auto d = RecordNode::alloc(Vec2(5,7));
+    d->setAngle(1.0f);
+    Affine2 parent(2, 0, 0, 2, 50, 60);
+    Affine2 expected;
+    Affine2::multiply(d->getNodeToParentTransform(), parent, &expected);
+    CU_CHECK(d->updateWorldTransform(parent).equals(expected));
+    Uint32 vd = d->getTransformVersion();
+    d->updateWorldTransform(parent);
+    CU_CHECK(d->getTransformVersion() == vd);
+    d->updateWorldTransform(Affine2::IDENTITY);
+    CU_CHECK(d->getTransformVersion() != vd);
+    CU_CHECK(d->getRenderTransform().equals(d->getNodeToParentTransform()));
+}
+
+/**
+ * Checks the version links between a node and its parent.
+ */
+static void testLinks() {
+    auto batch = std::make_shared<SpriteBatch>();
+    auto scene = std::make_shared<RecordScene>();
+    scene->init(1024, 768);
+
+    // Two fresh groups have the same version after one frame
+    auto group1 = SceneNode::allocWithPosition(Vec2(100,100));
+    auto group2 = SceneNode::allocWithPosition(Vec2(400,300));
+    group2->setAngle(0.75f);
+    auto node = RecordNode::alloc(Vec2(20,10));
+    group1->addChild(node);
+    scene->addChild(group1);
+    scene->addChild(group2);
+    scene->record(batch);
+    CU_CHECK(group1->getTransformVersion() == group2->getTransformVersion());
+    CU_CHECK(drawnCorrectly());
+
+    // So a new parent must not reuse the link to the old one
+    node->removeFromParent();
+    group2->addChild(node);
+    scene->record(batch);
+    CU_CHECK(drawnCorrectly());
+    CU_CHECK(node->drawn().equals(node->getNodeToWorldTransform()));
+
+    // A direct call with another transform breaks the link to the parent
+    const Affine2& parent = group2->getRenderTransform();
+    Affine2 expected;
+    node->updateWorldTransform(parent);
+    Uint32 version = node->getTransformVersion();
+    node->updateWorldTransform(parent);
+    CU_CHECK(node->getTransformVersion() == version);
+    Affine2 other(1, 0, 0, 1, -30, 45);
+    Affine2::multiply(node->getNodeToParentTransform(), other, &expected);
+    CU_CHECK(node->updateWorldTransform(other).equals(expected));
+    Affine2::multiply(node->getNodeToParentTransform(), parent, &expected);
+    CU_CHECK(node->updateWorldTransform(parent).equals(expected));
+    CU_CHECK(node->getTransformVersion() != version);
+
+    // A copy of the parent transform is compared, not linked
+    Affine2 copy = parent;
+    version = node->getTransformVersion();
+    CU_CHECK(node->updateWorldTransform(copy).equals(expected));
+    node->updateWorldTransform(copy);
+    CU_CHECK(node->getTransformVersion() == version+1);
+}
+
+/**
+ * Checks the transforms of the descendants of an ordered node.
+ */
+static void testOrdered() {
+    auto batch = std::make_shared<SpriteBatch>();
+    auto scene = std::make_shared<RecordScene>();
+    scene->init(1024, 768);
+
+    // Priorities reverse the pre-order of the descendants
+    auto ordered = OrderedNode::allocWithOrder(OrderedNode::Order::ASCEND, Vec2(100,100));
+    std::vector<std::shared_ptr<RecordNode>> nodes;
+    for(int ii = 0; ii < 4; ii++) {
+        auto node = RecordNode::alloc(Vec2(ii*50.0f,0));
+        auto child = RecordNode::alloc(Vec2(0,ii*20.0f));
+        node->setPriority(100-2*ii);
+        child->setPriority(99-2*ii);
+        node->addChild(child);
+        ordered->addChild(node);
+        nodes.push_back(node);
+        nodes.push_back(child);
+    }
+    scene->addChild(ordered);
+
+    scene->record(batch);
+    bool sorted = RecordNode::nodes.size() == nodes.size();
+    for(size_t ii = 0; sorted && ii < nodes.size(); ii++) {
+        sorted = RecordNode::nodes[ii] == nodes[nodes.size()-ii-1].get();
+    }
+    CU_CHECK(sorted);
+    CU_CHECK(drawnCorrectly());
+
+    Uint32 version = nodes[3]->getTransformVersion();
+    nodes[2]->setPosition(Vec2(70,-40));
+    ordered->setPosition(Vec2(120,90));
+    scene->record(batch);
+    CU_CHECK(drawnCorrectly());
+    CU_CHECK(nodes[3]->getTransformVersion() != version);
+}
+
+/**
+ * Checks the transforms of the children of a scroll pane.
+ */
+static void testPane() {
+    auto batch = std::make_shared<SpriteBatch>();
+    auto scene = std::make_shared<RecordScene>();
+    scene->init(1024, 768);
+
+    auto pane = ScrollPane::allocWithInterior(Size(400,400), Rect(-300,-300,1000,1000), false);
+    pane->setPosition(Vec2(200,100));
+    auto node = RecordNode::alloc(Vec2(50,50));
+    pane->addChild(node);
+    scene->addChild(pane);
+
+    scene->record(batch);
+    Affine2 before = node->drawn();
+    CU_CHECK(before.equals(node->getNodeToWorldTransform()));
+    Uint32 version = node->getTransformVersion();
+
+    // The pan is passed down by the pane, and is not part of the node transform
+    Vec2 delta = pane->applyPan(Vec2(-40,-30));
+    scene->record(batch);
+    Affine2 after = node->drawn();
+    CU_CHECK(delta != Vec2::ZERO);
+    CU_CHECK(node->getTransformVersion() != version);
+    CU_CHECK(after.isExactly(node->getRenderTransform()));
+    CU_CHECK(Vec2(after.m[4]-before.m[4],after.m[5]-before.m[5]).equals(delta));
+}
+
+/**
+ * Reports the time to render a static and a moving frame.
+ */
+static void timeTransforms() {
+    auto batch = std::make_shared<SpriteBatch>();
+    auto scene = std::make_shared<RecordScene>();
+    scene->init(1024, 768);
+    scene->setCulling(false);
+    std::vector<std::shared_ptr<SceneNode>> groups;
+    for(int ii = 0; ii < GROUP_COUNT; ii++) {
+        auto group = SceneNode::allocWithPosition(Vec2((ii % 20)*50.0f,(ii / 20)*70.0f));
+        group->setAngle(ii*0.1f);
+        for(int jj = 0; jj < LEAF_COUNT; jj++) {
+            group->addChild(RecordNode::alloc(Vec2((jj % 10)*4.0f,(jj / 10)*4.0f)));
+        }
+        scene->addChild(group);
+        groups.push_back(group);
+    }
+
+    double still = cu_test_time([&] {
+        for(int frame = 0; frame < FRAME_COUNT; frame++) {
+            scene->record(batch);
+        }
+    })/FRAME_COUNT;
+    double moving = cu_test_time([&] {
+        for(int frame = 0; frame < FRAME_COUNT; frame++) {
+            for(auto it = groups.begin(); it != groups.end(); ++it) {
+                (*it)->setAngle((*it)->getAngle()+0.01f);
+            }
+            scene->record(batch);
+        }
+    })/FRAME_COUNT;
+    CU_CHECK(drawnCorrectly());
+    std::printf("%d nodes: %.3f ms per static frame, %.3f ms with every group moving\n",
+                GROUP_COUNT*(LEAF_COUNT+1), still, moving);
+}
+
+/**
+ * Runs the transform cache checks and timings.
+ */
+int main(int argc, char** argv) {
+    testVersions();
+    testLinks();
+    testOrdered();
+    testPane();
+    timeTransforms();
+    return cu_test_result("Scene2TransformTest");
+}
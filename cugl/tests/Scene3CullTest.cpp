@@ -0,0 +1,401 @@
+//
+//  Scene3CullTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the frustum culling of a 3d scene graph. It first
+//  checks the frustum of a perspective camera directly, with points, boxes
+//  and spheres in front of, behind, and straddling its planes. It renders a
+//  large grid of nested nodes through a pipeline with a recording batch (so
+//  it needs no OpenGL context), and checks that exactly the nodes whose
+//  world bounding boxes meet the camera frustum are submitted, with their
+//  correct world transforms. It checks this for a static scene, for moving
+//  nodes, and for added and removed nodes. It then reports the time to
+//  render a frame with and without culling.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/17/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/scene3/CUScene3.h>
+#include <cugl/scene3/CUSceneNode3.h>
+#include <cugl/scene3/CUScene3Pipeline.h>
+#include <cugl/scene3/CUScene3Batch.h>
+#include <cugl/core/math/CUFrustum.h>
+#include <cugl/core/math/CUPerspectiveCamera.h>
+#include <CUTestHarness.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <random>
+
+using namespace cugl;
+using namespace cugl::scene3;
+
+/** The number of nodes along each side of the grid */
+#define GRID_SIZE       100
+/** The batch key of the test nodes */
+#define BOX_KEY         0x0B0C
+/** The number of frames in each timing */
+#define FRAME_COUNT     50
+
+/**
+ * A batch that records the nodes appended to it.
+ */
+class RecordBatch : public Scene3Batch {
+public:
+    /** The nodes appended since the last clear */
+    std::vector<SceneNode*> nodes;
+    /** The transforms appended since the last clear */
+    std::vector<Mat4> transforms;
+
+    /**
+     * Records the node and its transform.
+     *
+     * @param node      The node to record
+     * @param transform The node world transform
+     */
+    void append(const std::shared_ptr<SceneNode>& node, const Mat4& transform) override {
+        nodes.push_back(node.get());
+        transforms.push_back(transform);
+    }
+
+    /**
+     * Does nothing, as nothing is drawn.
+     *
+     * @param camera    The camera to draw with
+     */
+    void flush(const std::shared_ptr<Camera>& camera) override {}
+
+    /**
+     * Removes all recorded nodes.
+     */
+    void clear() override {
+        nodes.clear();
+        transforms.clear();
+    }
+};
+
+/**
+ * A node with a unit bounding box.
+ */
+class BoxNode : public SceneNode {
+public:
+    /**
+     * Stores the unit box around the node origin.
+     *
+     * @param lower The minimum corner of the bounding box
+     * @param upper The maximum corner of the bounding box
+     *
+     * @return true, as the node is always bounded
+     */
+    bool getBoundingBox(Vec3& lower, Vec3& upper) const override {
+        lower.set(-0.5f,-0.5f,-0.5f);
+        upper.set( 0.5f, 0.5f, 0.5f);
+        return true;
+    }
+
+    /**
+     * Returns a newly allocated box node at the given position.
+     *
+     * @param pos   The node position
+     *
+     * @return a newly allocated box node at the given position.
+     */
+    static std::shared_ptr<BoxNode> alloc(const Vec3 pos) {
+        std::shared_ptr<BoxNode> result = std::make_shared<BoxNode>();
+        if (result->initWithPosition(pos)) {
+            result->setBatchKey(BOX_KEY);
+            return result;
+        }
+        return nullptr;
+    }
+};
+
+/**
+ * A scene that renders to a recording batch instead of the standard pipeline.
+ */
+class CullScene : public Scene3 {
+public:
+    /**
+     * Initializes a scene with the given size and recording batch.
+     *
+     * @param width     The viewport width
+     * @param height    The viewport height
+     * @param batch     The recording batch
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(float width, float height, const std::shared_ptr<RecordBatch>& batch) {
+        _camera = PerspectiveCamera::alloc(width, height);
+        _camera->setFar(500);
+        _camera->setPosition(Vec3(0,10,20));
+        _camera->lookAt(Vec3::ZERO,Vec3::UNIT_Y);
+        _camera->update();
+        _pipeline = Scene3Pipeline::alloc();
+        batch->init(BOX_KEY, 0);
+        _active = _pipeline->attach(batch);
+        return _active;
+    }
+};
+
+/**
+ * Returns true if the world box of the node meets the frustum
+ *
+ * @param node      The node to test
+ * @param frustum   The camera frustum
+ *
+ * @return true if the world box of the node meets the frustum
+ */
+static bool inside(const SceneNode* node, Frustum& frustum) {
+    Mat4 world = node->getNodeToWorldTransform();
+    Vec3 lower(FLT_MAX,FLT_MAX,FLT_MAX);
+    Vec3 upper(-FLT_MAX,-FLT_MAX,-FLT_MAX);
+    for(int ii = 0; ii < 8; ii++) {
+        Vec3 corner((ii & 1) ? 0.5f : -0.5f, (ii & 2) ? 0.5f : -0.5f, (ii & 4) ? 0.5f : -0.5f);
+        Mat4::transform(world,corner,&corner);
+        lower.set(std::min(lower.x,corner.x),std::min(lower.y,corner.y),std::min(lower.z,corner.z));
+        upper.set(std::max(upper.x,corner.x),std::max(upper.y,corner.y),std::max(upper.z,corner.z));
+    }
+    return frustum.findBox((lower+upper)*0.5f, upper-lower) != Frustum::Region::OUTSIDE;
+}
+
+/**
+ * Collects the nodes of the subtree in pre-order.
+ *
+ * @param node      The subtree root
+ * @param result    The collected nodes
+ */
+static void collect(const std::shared_ptr<SceneNode>& node, std::vector<SceneNode*>& result) {
+    result.push_back(node.get());
+    std::vector<std::shared_ptr<SceneNode>> children = node->getChildren();
+    for(auto it = children.begin(); it != children.end(); ++it) {
+        collect(*it, result);
+    }
+}
+
+/**
+ * Renders the scene and checks the submitted nodes against brute force.
+ *
+ * @param name  The check name, for reporting errors
+ * @param scene The scene to render
+ * @param batch The recording batch
+ */
+static void check(const char* name, const std::shared_ptr<CullScene>& scene,
+                  const std::shared_ptr<RecordBatch>& batch) {
+    batch->clear();
+    scene->render();
+
+    std::vector<SceneNode*> expected;
+    std::vector<SceneNode*> all;
+    for(size_t ii = 0; ii < scene->getChildCount(); ii++) {
+        collect(scene->getChild((unsigned int)ii), all);
+    }
+    Frustum frustum(scene->getCamera()->getInverseProjectView());
+    for(auto it = all.begin(); it != all.end(); ++it) {
+        if (!scene->isCulling() || inside(*it, frustum)) {
+            expected.push_back(*it);
+        }
+    }
+
+    // Submission preserves the pre-order of the graph
+    bool valid = batch->nodes == expected;
+    for(size_t ii = 0; valid && ii < batch->nodes.size(); ii++) {
+        Mat4 world = batch->nodes[ii]->getNodeToWorldTransform();
+        valid = world.equals(batch->transforms[ii]);
+    }
+    if (!valid) {
+        std::printf("  %s: submitted %zu nodes, expected %zu\n", name,
+                    batch->nodes.size(), expected.size());
+    }
+    CU_CHECK(valid);
+    CU_CHECK(scene->getSubmittedCount() == expected.size());
+    CU_CHECK(scene->getCulledCount()+expected.size() == all.size());
+}
+
+/**
+ * Returns a scene with a grid of nodes, each with one rotated child.
+ *
+ * @param batch The recording batch
+ * @param nodes The grid nodes
+ *
+ * @return a scene with a grid of nodes, each with one rotated child.
+ */
+static std::shared_ptr<CullScene> buildScene(const std::shared_ptr<RecordBatch>& batch,
+                                             std::vector<std::shared_ptr<SceneNode>>& nodes) {
+    auto scene = std::make_shared<CullScene>();
+    scene->init(1024, 768, batch);
+    for(int ii = 0; ii < GRID_SIZE; ii++) {
+        for(int jj = 0; jj < GRID_SIZE; jj++) {
+            auto node = BoxNode::alloc(Vec3(ii*2.0f-GRID_SIZE, 0, jj*2.0f-GRID_SIZE));
+            auto child = BoxNode::alloc(Vec3(0,1,0));
+            child->setRotation(Quaternion(Vec3::UNIT_Y,(ii+jj)*0.1f));
+            child->setScale(1.5f);
+            node->addChild(child);
+            scene->addChild(node);
+            nodes.push_back(node);
+        }
+    }
+    return scene;
+}
+
+/**
+ * Checks the frustum of a perspective camera directly.
+ *
+ * The camera is checked looking down an axis and from an oblique angle,
+ * so that a plane wound the wrong way cannot pass by symmetry. Boxes and
+ * spheres are centered on the near, far and left planes to check that
+ * they straddle them.
+ */
+static void testFrustum() {
+    Vec3 eyes[] = { Vec3(0,0,10), Vec3(20,15,-30) };
+    for(int ii = 0; ii < 2; ii++) {
+        auto camera = PerspectiveCamera::alloc(1024, 768, 60);
+        camera->setNear(1);
+        camera->setFar(100);
+        camera->setPosition(eyes[ii]);
+        camera->lookAt(Vec3::ZERO);
+        camera->update();
+        Frustum frustum(camera->getInverseProjectView());
+        Vec3 eye = camera->getPosition();
+        Vec3 dir = camera->getDirection();
+        
+        // Points in front, behind, before near and beyond far
+        CU_CHECK(frustum.find(eye+dir*10) == Frustum::Region::INSIDE);
+        CU_CHECK(frustum.find(eye+dir*99) == Frustum::Region::INSIDE);
+        CU_CHECK(frustum.find(eye-dir*10) == Frustum::Region::OUTSIDE);
+        CU_CHECK(frustum.find(eye+dir*0.5f) == Frustum::Region::OUTSIDE);
+        CU_CHECK(frustum.find(eye+dir*150) == Frustum::Region::OUTSIDE);
+        
+        // The corners are at the near and far distances
+        float front = (frustum.getCorner(0)-eye).dot(dir);
+        float back  = (frustum.getCorner(6)-eye).dot(dir);
+        CU_CHECK(std::fabs(front-1) < 1e-3f && std::fabs(back-100) < 1e-1f);
+        
+        // The middle of the left face, and a point just either side of it
+        Vec3 left = (frustum.getCorner(0)+frustum.getCorner(3)+
+                     frustum.getCorner(4)+frustum.getCorner(7))*0.25f;
+        Vec3 across = (eye+dir*((left-eye).dot(dir)))-left;
+        across.normalize();
+        CU_CHECK(frustum.find(left+across*0.5f) == Frustum::Region::INSIDE);
+        CU_CHECK(frustum.find(left-across*0.5f) == Frustum::Region::OUTSIDE);
+        
+        // Boxes inside, outside, and straddling the near, far and left planes
+        Vec3 unit(1,1,1);
+        CU_CHECK(frustum.findBox(eye+dir*10, unit) == Frustum::Region::INSIDE);
+        CU_CHECK(frustum.findBox(eye-dir*10, unit) == Frustum::Region::OUTSIDE);
+        CU_CHECK(frustum.findBox(eye+dir*200, unit) == Frustum::Region::OUTSIDE);
+        CU_CHECK(frustum.findBox(eye+dir, unit*0.5f) == Frustum::Region::INTERSECT);
+        CU_CHECK(frustum.findBox(eye+dir*100, unit*2) == Frustum::Region::INTERSECT);
+        CU_CHECK(frustum.findBox(left, unit) == Frustum::Region::INTERSECT);
+        CU_CHECK(frustum.findBox(left-across*2, unit) == Frustum::Region::OUTSIDE);
+        
+        // Spheres agree with the boxes
+        CU_CHECK(frustum.findSphere(eye+dir*10, 1) == Frustum::Region::INSIDE);
+        CU_CHECK(frustum.findSphere(eye-dir*10, 1) == Frustum::Region::OUTSIDE);
+        CU_CHECK(frustum.findSphere(eye+dir*100, 1) == Frustum::Region::INTERSECT);
+        CU_CHECK(frustum.findSphere(left, 1) == Frustum::Region::INTERSECT);
+    }
+}
+
+/**
+ * Checks the culled nodes as the scene changes.
+ */
+static void testCulling() {
+    auto batch = std::make_shared<RecordBatch>();
+    std::vector<std::shared_ptr<SceneNode>> nodes;
+    auto scene = buildScene(batch, nodes);
+    CU_CHECK(scene->isCulling());
+    check("static", scene, batch);
+    CU_CHECK(scene->getCulledCount() > 0 && scene->getSubmittedCount() > 0);
+    check("static again", scene, batch);
+
+    // A few moving nodes refit the hierarchy
+    std::mt19937 rand(3);
+    for(int frame = 0; frame < 10; frame++) {
+        for(int ii = 0; ii < 20; ii++) {
+            auto& node = nodes[rand() % nodes.size()];
+            node->setPosition(node->getPosition()+Vec3(0,0,(frame % 2) ? -3.0f : 3.0f));
+        }
+        check("moving", scene, batch);
+    }
+
+    // Moving everything far away rebuilds the hierarchy
+    for(auto it = nodes.begin(); it != nodes.end(); ++it) {
+        (*it)->setPosition((*it)->getPosition()*3.0f);
+    }
+    check("spread", scene, batch);
+
+    // Children move with their parents
+    nodes[0]->getChild(0)->setPosition(Vec3(0,-2,0));
+    nodes[0]->setPosition(Vec3::ZERO);
+    check("nested", scene, batch);
+
+    // Structure changes re-flatten the graph
+    auto extra = BoxNode::alloc(Vec3(1,1,1));
+    nodes[0]->addChild(extra);
+    scene->removeChild(nodes[1]);
+    check("restructured", scene, batch);
+
+    scene->setCulling(false);
+    check("not culled", scene, batch);
+}
+
+/**
+ * Reports the time to render a frame with and without culling.
+ */
+static void timeCulling() {
+    auto batch = std::make_shared<RecordBatch>();
+    std::vector<std::shared_ptr<SceneNode>> nodes;
+    auto scene = buildScene(batch, nodes);
+    std::mt19937 rand(5);
+    int moving[] = { 0, 100, 1000 };
+    for(int ii = 0; ii < 3; ii++) {
+        double times[2];
+        for(int culling = 0; culling < 2; culling++) {
+            scene->setCulling(culling);
+            times[culling] = cu_test_time([&] {
+                for(int frame = 0; frame < FRAME_COUNT; frame++) {
+                    for(int jj = 0; jj < moving[ii]; jj++) {
+                        auto& node = nodes[rand() % nodes.size()];
+                        Vec3 pos = node->getPosition();
+                        pos.y = (frame % 2) ? 0.5f : 0.0f;
+                        node->setPosition(pos);
+                    }
+                    batch->clear();
+                    scene->render();
+                }
+            })/FRAME_COUNT;
+        }
+        std::printf("%zu nodes, %d moving: %.3f ms per frame, %.3f ms culled (%zu submitted)\n",
+                    2*nodes.size(), moving[ii], times[0], times[1], scene->getSubmittedCount());
+    }
+}
+
+/**
+ * Runs the scene culling checks and timings.
+ */
+int main(int argc, char** argv) {
+    testFrustum();
+    testCulling();
+    timeCulling();
+    return cu_test_result("Scene3CullTest");
+}
@@ -0,0 +1,460 @@
+//
+//  WebSocketServerTest.cpp
+//  Cornell University Game Library (CUGL)
+//
+//  This driver checks the sharded mode of the websocket server over the
+//  loopback interface. It connects several clients, each on its own path,
+//  and has them send numbered messages. It checks that the queue depth of
+//  every shard matches what was sent, that a single receive dispatches each
+//  shard contiguously and in order, and that the latency of every client
+//  is measured. It also checks that a full shard drops its oldest messages,
+//  and that shrinking the capacity keeps the newest ones. It then reports
+//  the time to receive a frame of messages from every client.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Author: agent
+//  Version: 10/17/26
+//
+#define SDL_MAIN_HANDLED
+#include <cugl/netcode/CUNetworkLayer.h>
+#include <cugl/netcode/CUWebSocket.h>
+#include <cugl/netcode/CUWebSocketServer.h>
+#include <cugl/netcode/CUInetAddress.h>
+#include <CUTestHarness.h>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+
+using namespace cugl;
+using namespace cugl::netcode;
+
+/** The loopback port for the server (0 picks a free one) */
+#define SERVER_PORT     0
+/** The number of connected clients */
+#define CLIENT_COUNT    6
+/** The number of messages each client sends per round */
+#define MESSAGE_COUNT   40
+/** The capacity of each shard */
+#define SHARD_CAPACITY  64
+/** The number of messages past capacity in the overflow check */
+#define OVERFLOW_COUNT  24
+/** The capacity after shrinking the shards */
+#define SHRUNK_CAPACITY 16
+/** The number of rounds to time */
+#define ROUND_COUNT     50
+/** The time in milliseconds to wait for the network */
+#define NETWORK_TIMEOUT 5000
+
+#pragma mark Loopback
+/**
+ * A server with a set of clients on the loopback interface
+ *
+ * Each client connects on its own path, so that the server identifier of
+ * every client can be recovered from the connection callback.
+ */
+class Loopback {
+public:
+    /** The server under test */
+    std::shared_ptr<WebSocketServer> server;
+    /** The clients, in order of their path */
+    std::vector<std::shared_ptr<WebSocket>> clients;
+    /** The server identifier of each client, in the same order */
+    std::vector<std::string> names;
+
+    /** The server identifier for each path (set by the server callback) */
+    std::unordered_map<std::string,std::string> paths;
+    /** The lock for the path map */
+    std::mutex mutex;
+
+    /**
+     * Returns true if the given condition holds before the timeout
+     *
+     * @param cond  The condition to wait for
+     *
+     * @return true if the given condition holds before the timeout
+     */
+    template <typename F>
+    static bool await(F cond) {
+        auto start = std::chrono::steady_clock::now();
+        while (!cond()) {
+            auto time = std::chrono::steady_clock::now()-start;
+            if (std::chrono::duration_cast<std::chrono::milliseconds>(time).count() > NETWORK_TIMEOUT) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    /**
+     * Returns the path for the given client
+     *
+     * @param index The client index
+     *
+     * @return the path for the given client
+     */
+    static std::string path(size_t index) {
+        return "/client"+std::to_string(index);
+    }
+
+    /**
+     * Returns true if the server started and every client connected
+     *
+     * @return true if the server started and every client connected
+     */
+    bool open() {
+        WebSocketConfig config(SERVER_PORT);
+        config.sharded = true;
+        config.bufferSize = SHARD_CAPACITY;
+        server = WebSocketServer::alloc(config);
+        if (server == nullptr) {
+            return false;
+        }
+        server->onConnect([this](const std::string client, const std::string path) {
+            std::lock_guard<std::mutex> lock(mutex);
+            paths[path] = client;
+        });
+        server->start();
+
+        InetAddress address("127.0.0.1",server->getPort());
+        for(size_t ii = 0; ii < CLIENT_COUNT; ii++) {
+            auto client = WebSocket::allocWithPath(address,path(ii));
+            if (client == nullptr) {
+                return false;
+            }
+            client->open();
+            clients.push_back(client);
+        }
+
+        bool success = await([this] {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (paths.size() < CLIENT_COUNT) {
+                return false;
+            }
+            for(auto it = clients.begin(); it != clients.end(); ++it) {
+                if (!(*it)->isOpen()) {
+                    return false;
+                }
+            }
+            return true;
+        });
+        if (!success) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for(size_t ii = 0; ii < CLIENT_COUNT; ii++) {
+            names.push_back(paths[path(ii)]);
+        }
+        return true;
+    }
+
+    /**
+     * Closes all clients and stops the server
+     */
+    void close() {
+        for(auto it = clients.begin(); it != clients.end(); ++it) {
+            (*it)->close();
+        }
+        clients.clear();
+        if (server) {
+            server->stop();
+            server = nullptr;
+        }
+    }
+
+    /**
+     * Returns the index of the client with the given server identifier
+     *
+     * @param name  The server identifier
+     *
+     * @return the index of the client with the given server identifier
+     */
+    int find(const std::string& name) const {
+        for(size_t ii = 0; ii < names.size(); ii++) {
+            if (names[ii] == name) {
+                return (int)ii;
+            }
+        }
+        return -1;
+    }
+};
+
+/**
+ * Returns a message tagged with a client index and sequence number
+ *
+ * @param client    The client index
+ * @param seq       The sequence number
+ *
+ * @return a message tagged with a client index and sequence number
+ */
+static std::vector<std::byte> encode(size_t client, size_t seq) {
+    std::vector<std::byte> result(4);
+    result[0] = (std::byte)client;
+    result[1] = (std::byte)(seq & 0xff);
+    result[2] = (std::byte)((seq >> 8) & 0xff);
+    result[3] = (std::byte)0xcc;
+    return result;
+}
+
+/**
+ * Returns the sequence number of a message, or -1 if it is malformed
+ *
+ * @param message   The message
+ * @param client    The expected client index
+ *
+ * @return the sequence number of a message, or -1 if it is malformed
+ */
+static int decode(const std::vector<std::byte>& message, size_t client) {
+    if (message.size() != 4 || message[0] != (std::byte)client || message[3] != (std::byte)0xcc) {
+        return -1;
+    }
+    return (int)message[1] | ((int)message[2] << 8);
+}
+
+/**
+ * A record of the messages dispatched by a single receive
+ */
+class Delivery {
+public:
+    /** The client index of each message, in dispatch order */
+    std::vector<int> order;
+    /** The sequence numbers received from each client */
+    std::vector<std::vector<int>> sequence;
+    /** The timestamps received from each client */
+    std::vector<std::vector<Uint64>> stamps;
+    /** The number of messages from an unknown client or malformed */
+    size_t invalid;
+
+    /** Creates an empty delivery record */
+    Delivery() : sequence(CLIENT_COUNT), stamps(CLIENT_COUNT), invalid(0) {}
+
+    /**
+     * Returns the number of contiguous runs of a client in dispatch order
+     *
+     * @return the number of contiguous runs of a client in dispatch order
+     */
+    size_t runs() const {
+        size_t result = 0;
+        for(size_t ii = 0; ii < order.size(); ii++) {
+            if (ii == 0 || order[ii] != order[ii-1]) {
+                result++;
+            }
+        }
+        return result;
+    }
+};
+
+/**
+ * Dispatches all pending messages of the server into a delivery record
+ *
+ * @param loop  The loopback connection
+ *
+ * @return the delivery record
+ */
+static Delivery receive(Loopback& loop) {
+    Delivery result;
+    loop.server->receive([&](const std::string source, const std::vector<std::byte>& message, Uint64 time) {
+        int index = loop.find(source);
+        int seq = index < 0 ? -1 : decode(message,index);
+        if (seq < 0) {
+            result.invalid++;
+            return;
+        }
+        result.order.push_back(index);
+        result.sequence[index].push_back(seq);
+        result.stamps[index].push_back(time);
+    });
+    return result;
+}
+
+/**
+ * Returns true if the given sequence numbers are consecutive
+ *
+ * @param seq   The sequence numbers
+ * @param first The expected first number
+ * @param count The expected length
+ *
+ * @return true if the given sequence numbers are consecutive
+ */
+static bool consecutive(const std::vector<int>& seq, int first, size_t count) {
+    if (seq.size() != count) {
+        return false;
+    }
+    for(size_t ii = 0; ii < count; ii++) {
+        if (seq[ii] != first+(int)ii) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#pragma mark Tests
+/**
+ * Checks per-shard depth, ordering, and latency for several clients
+ *
+ * @param loop  The loopback connection
+ */
+static void testDelivery(Loopback& loop) {
+    CU_CHECK(loop.server->isSharded());
+    CU_CHECK(loop.server->getNumConnections() == CLIENT_COUNT);
+    CU_CHECK(loop.server->getCapacity() == SHARD_CAPACITY);
+    CU_CHECK(loop.server->getQueueDepth() == 0);
+
+    // Interleave the clients so that the arrivals interleave too
+    for(size_t seq = 0; seq < MESSAGE_COUNT; seq++) {
+        for(size_t ii = 0; ii < CLIENT_COUNT; ii++) {
+            CU_CHECK(loop.clients[ii]->send(encode(ii,seq)));
+        }
+    }
+    CU_CHECK(Loopback::await([&] {
+        return loop.server->getQueueDepth() == CLIENT_COUNT*MESSAGE_COUNT;
+    }));
+    for(size_t ii = 0; ii < CLIENT_COUNT; ii++) {
+        CU_CHECK(loop.server->getQueueDepth(loop.names[ii]) == MESSAGE_COUNT);
+        CU_CHECK(loop.server->getLatency(loop.names[ii]) == 0);
+    }
+    CU_CHECK(loop.server->getQueueDepth("nobody") == 0);
+    CU_CHECK(loop.server->getLatency("nobody") == 0);
+
+    // Let the messages wait, so that the latency is measurable
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    Delivery delivery = receive(loop);
+    CU_CHECK(delivery.invalid == 0);
+    CU_CHECK(delivery.order.size() == CLIENT_COUNT*MESSAGE_COUNT);
+    CU_CHECK(delivery.runs() == CLIENT_COUNT);
+    for(size_t ii = 0; ii < CLIENT_COUNT; ii++) {
+        CU_CHECK(consecutive(delivery.sequence[ii],0,MESSAGE_COUNT));
+        const std::vector<Uint64>& stamps = delivery.stamps[ii];
+        for(size_t jj = 1; jj < stamps.size(); jj++) {
+            CU_CHECK(stamps[jj-1] <= stamps[jj]);
+        }
+        CU_CHECK(loop.server->getQueueDepth(loop.names[ii]) == 0);
+        CU_CHECK(loop.server->getLatency(loop.names[ii]) > 0);
+    }
+    CU_CHECK(loop.server->getQueueDepth() == 0);
+    CU_CHECK(loop.server->getDropped() == 0);
+
+    // A second receive has nothing to dispatch
+    Delivery empty = receive(loop);
+    CU_CHECK(empty.order.empty() && empty.invalid == 0);
+}
+
+/**
+ * Checks that full shards drop their oldest messages
+ *
+ * Only the first client overflows, so the other shards must be untouched.
+ *
+ * @param loop  The loopback connection
+ */
+static void testOverflow(Loopback& loop) {
+    Uint64 dropped = loop.server->getDropped();
+    for(size_t seq = 0; seq < SHARD_CAPACITY+OVERFLOW_COUNT; seq++) {
+        CU_CHECK(loop.clients[0]->send(encode(0,seq)));
+    }
+    for(size_t seq = 0; seq < MESSAGE_COUNT; seq++) {
+        CU_CHECK(loop.clients[1]->send(encode(1,seq)));
+    }
+    CU_CHECK(Loopback::await([&] {
+        return loop.server->getDropped() == dropped+OVERFLOW_COUNT &&
+               loop.server->getQueueDepth(loop.names[1]) == MESSAGE_COUNT;
+    }));
+    CU_CHECK(loop.server->getQueueDepth(loop.names[0]) == SHARD_CAPACITY);
+    CU_CHECK(loop.server->getQueueDepth() == SHARD_CAPACITY+MESSAGE_COUNT);
+
+    Delivery delivery = receive(loop);
+    CU_CHECK(delivery.invalid == 0);
+    CU_CHECK(consecutive(delivery.sequence[0],OVERFLOW_COUNT,SHARD_CAPACITY));
+    CU_CHECK(consecutive(delivery.sequence[1],0,MESSAGE_COUNT));
+    for(size_t ii = 2; ii < CLIENT_COUNT; ii++) {
+        CU_CHECK(delivery.sequence[ii].empty());
+    }
+    CU_CHECK(delivery.runs() == 2);
+
+    // Shrinking keeps the newest messages of every shard
+    dropped = loop.server->getDropped();
+    for(size_t ii = 0; ii < CLIENT_COUNT; ii++) {
+        for(size_t seq = 0; seq < MESSAGE_COUNT; seq++) {
+            CU_CHECK(loop.clients[ii]->send(encode(ii,seq)));
+        }
+    }
+    CU_CHECK(Loopback::await([&] {
+        return loop.server->getQueueDepth() == CLIENT_COUNT*MESSAGE_COUNT;
+    }));
+    loop.server->setCapacity(SHRUNK_CAPACITY);
+    CU_CHECK(loop.server->getCapacity() == SHRUNK_CAPACITY);
+    CU_CHECK(loop.server->getDropped() == dropped+CLIENT_COUNT*(MESSAGE_COUNT-SHRUNK_CAPACITY));
+    CU_CHECK(loop.server->getQueueDepth() == CLIENT_COUNT*SHRUNK_CAPACITY);
+
+    delivery = receive(loop);
+    CU_CHECK(delivery.invalid == 0);
+    for(size_t ii = 0; ii < CLIENT_COUNT; ii++) {
+        CU_CHECK(consecutive(delivery.sequence[ii],MESSAGE_COUNT-SHRUNK_CAPACITY,SHRUNK_CAPACITY));
+    }
+    loop.server->setCapacity(SHARD_CAPACITY);
+}
+
+#pragma mark Timing
+/**
+ * Reports the time to receive a frame of messages from every client
+ *
+ * @param loop  The loopback connection
+ */
+static void timeReceive(Loopback& loop) {
+    double total = 0;
+    size_t count = 0;
+    for(size_t round = 0; round < ROUND_COUNT; round++) {
+        for(size_t ii = 0; ii < CLIENT_COUNT; ii++) {
+            for(size_t seq = 0; seq < MESSAGE_COUNT; seq++) {
+                loop.clients[ii]->send(encode(ii,seq));
+            }
+        }
+        CU_CHECK(Loopback::await([&] {
+            return loop.server->getQueueDepth() == CLIENT_COUNT*MESSAGE_COUNT;
+        }));
+        total += cu_test_time([&] {
+            loop.server->receive([&](const std::string source, const std::vector<std::byte>& message, Uint64 time) {
+                count += message.size();
+            });
+        }, 1);
+    }
+    CU_CHECK(count == 4*ROUND_COUNT*CLIENT_COUNT*MESSAGE_COUNT);
+    std::printf("%d clients x %d messages: %.1f us per receive\n",
+                CLIENT_COUNT, MESSAGE_COUNT, 1000*total/ROUND_COUNT);
+}
+
+/**
+ * Runs the websocket server checks and timings.
+ */
+int main(int argc, char** argv) {
+    NetworkLayer::start();
+    Loopback loop;
+    bool success = loop.open();
+    CU_CHECK(success);
+    if (success) {
+        testDelivery(loop);
+        testOverflow(loop);
+        timeReceive(loop);
+    }
+    loop.close();
+    NetworkLayer::stop();
+    return cu_test_result("WebSocketServerTest");
+}